@@ -67,6 +67,8 @@ class AppConstants {
 
   // SharedPreferences keys
   static const savedAdapterAddressKey = 'last_obd_adapter_address';
+  static const connectionProfilesKey = 'obd_connection_profiles';
+  static const didScanStatesKey = 'did_scan_states';
   static const devLogsCloudEnabledKey = 'dev_logs_cloud_enabled';
 
   // Firestore paths
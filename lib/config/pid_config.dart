@@ -1,5 +1,7 @@
 // PID and SPN definitions for OBD2 and J1939 Cummins parameters.
 // Config-driven: add new PIDs here and the app automatically supports them.
+// The native decoder table is generated from this file: after changing a PID
+// or parser, run `node scripts/gen_pid_table.js`.
 
 enum PollTier { fast, medium, slow, background }
 
@@ -549,6 +549,18 @@ class _PidStatusRowState extends State<_PidStatusRow> {
                                   : AppColors.textSecondary,
                             ),
                           ),
+                          if (s.latencyP50 != null) ...[
+                            const SizedBox(width: 6),
+                            Text(
+                              'p50 ${s.latencyP50!.inMilliseconds}ms '
+                              'p99 ${s.latencyP99!.inMilliseconds}ms',
+                              style: TextStyle(
+                                fontFamily: 'JetBrains Mono',
+                                fontSize: 10,
+                                color: AppColors.textTertiary,
+                              ),
+                            ),
+                          ],
                           if (s.failReason != null) ...[
                             const SizedBox(width: 6),
                             Text(
@@ -450,8 +450,11 @@ class _ProgressCard extends StatelessWidget {
               const SizedBox(width: AppSpacing.sm),
               _CountChip(label: 'Timeout', count: progress.timeoutCount, color: AppColors.textTertiary),
               const Spacer(),
-              if (remainStr.isNotEmpty)
-                Text(remainStr, style: AppTypography.labelSmall),
+              Text(
+                '${progress.hitsPerSecond.toStringAsFixed(1)} hits/s'
+                '${remainStr.isNotEmpty ? ' · $remainStr' : ''}',
+                style: AppTypography.labelSmall,
+              ),
             ],
           ),
         ],
@@ -88,6 +88,11 @@ class DidScanProgress {
 
   double get fraction => total > 0 ? current / total : 0;
 
+  /// DIDs found per second of scanning.
+  double get hitsPerSecond => elapsed > Duration.zero
+      ? foundCount * Duration.microsecondsPerSecond / elapsed.inMicroseconds
+      : 0;
+
   Duration get estimatedRemaining {
     if (current == 0) return Duration.zero;
     final msPerDid = elapsed.inMilliseconds / current;
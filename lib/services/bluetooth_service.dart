@@ -4,6 +4,7 @@ import 'dart:typed_data';
 import 'package:flutter_bluetooth_classic_serial/flutter_bluetooth_classic.dart'
     as bt;
 import 'package:myapp/config/constants.dart';
+import 'package:myapp/services/connection_profile_cache.dart';
 import 'package:myapp/services/diagnostic_service.dart';
 import 'package:shared_preferences/shared_preferences.dart';
 
@@ -44,6 +45,326 @@ class BluetoothDeviceInfo {
   String toString() => 'BluetoothDeviceInfo($name, $address)';
 }
 
+/// One complete adapter response, framed natively at the '>' prompt.
+class AdapterResponse {
+  /// Response lines without prompt, echo and SEARCHING.../BUS INIT noise.
+  final List<String> lines;
+
+  /// When the prompt arrived.
+  final DateTime timestamp;
+
+  /// Time from writing the command to the prompt.
+  final Duration elapsed;
+
+  const AdapterResponse({
+    required this.lines,
+    required this.timestamp,
+    required this.elapsed,
+  });
+}
+
+/// Outcome of one command of a [BluetoothAdapter.sendCommands] batch.
+class AdapterCommandResult {
+  final String command;
+
+  /// Response lines, or null if the command timed out or was never sent.
+  final List<String>? lines;
+
+  /// Time from writing the command to the prompt.
+  final Duration elapsed;
+
+  const AdapterCommandResult({
+    required this.command,
+    required this.lines,
+    required this.elapsed,
+  });
+}
+
+/// One result of the native poll schedule.
+class AdapterPollSample {
+  final String command;
+
+  /// Response lines, or null if the command timed out or was never sent.
+  final List<String>? lines;
+
+  /// When the sample reached Dart's side of the platform channel.
+  final DateTime timestamp;
+
+  /// Time from writing the command to the prompt.
+  final Duration elapsed;
+
+  const AdapterPollSample({
+    required this.command,
+    required this.lines,
+    required this.timestamp,
+    required this.elapsed,
+  });
+}
+
+/// Achieved vs. target sample rate of one scheduled command.
+class PollRate {
+  final String command;
+  final double targetHz;
+  final double achievedHz;
+  final int samples;
+  final int timeouts;
+  final int deadlineMisses;
+
+  const PollRate({
+    required this.command,
+    required this.targetHz,
+    required this.achievedHz,
+    required this.samples,
+    required this.timeouts,
+    required this.deadlineMisses,
+  });
+
+  @override
+  String toString() => '$command ${achievedHz.toStringAsFixed(1)}/'
+      '${targetHz.toStringAsFixed(1)}Hz';
+}
+
+/// Native latency of one adapter command since the last stats reset.
+class CommandLatency {
+  final String command;
+  final int completed;
+  final int timeouts;
+
+  /// Write to prompt.
+  final Duration p50;
+  final Duration p99;
+
+  /// Write to the first response byte: adapter and ECU time.
+  final Duration firstByteP50;
+
+  /// Prompt to the platform thread.
+  final Duration deliveryP99;
+
+  const CommandLatency({
+    required this.command,
+    required this.completed,
+    required this.timeouts,
+    required this.p50,
+    required this.p99,
+    required this.firstByteP50,
+    required this.deliveryP99,
+  });
+
+  @override
+  String toString() =>
+      '$command p50=${p50.inMilliseconds}ms p99=${p99.inMilliseconds}ms';
+}
+
+/// A responder count the adapter link learned and appends to a request.
+class ResponseCount {
+  final String command;
+
+  /// 0 while the request is sent open-ended.
+  final int count;
+  final int countedReplies;
+
+  /// Round trip saved per counted request.
+  final Duration saved;
+
+  const ResponseCount({
+    required this.command,
+    required this.count,
+    required this.countedReplies,
+    required this.saved,
+  });
+
+  /// Link time saved by the counted requests so far.
+  Duration get totalSaved => saved * countedReplies;
+
+  @override
+  String toString() => '$command/$count -${saved.inMilliseconds}ms';
+}
+
+/// The response timeout the native link picked for one OBD request.
+class AdaptiveTimeout {
+  final String command;
+
+  /// ATST value in 4 ms counts.
+  final int counts;
+  final int noData;
+  final int backoffs;
+
+  const AdaptiveTimeout({
+    required this.command,
+    required this.counts,
+    required this.noData,
+    required this.backoffs,
+  });
+
+  Duration get timeout => Duration(milliseconds: counts * 4);
+
+  @override
+  String toString() => '$command@${timeout.inMilliseconds}ms';
+}
+
+/// Latest value of one J1939 SPN from the passive bus monitor.
+class J1939Reading {
+  final int spn;
+  final int pgn;
+
+  /// PID id where the app config has the same parameter (`coolantTemp`).
+  final String id;
+  final String unit;
+  final double value;
+
+  /// Source address of the sending ECU (0 = engine, 3 = transmission).
+  final int source;
+
+  /// Time since the frame arrived.
+  final Duration age;
+
+  const J1939Reading({
+    required this.spn,
+    required this.pgn,
+    required this.id,
+    required this.unit,
+    required this.value,
+    required this.source,
+    required this.age,
+  });
+
+  @override
+  String toString() => 'SPN $spn $id=$value$unit';
+}
+
+/// An active fault one ECU reports in its DM1.
+class J1939Fault {
+  /// Source address of the ECU.
+  final int source;
+  final int spn;
+
+  /// Failure mode identifier.
+  final int fmi;
+  final int occurrences;
+
+  /// Lamps the ECU has on with this DM1.
+  final bool malfunctionLamp;
+  final bool redStopLamp;
+  final bool amberWarningLamp;
+
+  const J1939Fault({
+    required this.source,
+    required this.spn,
+    required this.fmi,
+    required this.occurrences,
+    this.malfunctionLamp = false,
+    this.redStopLamp = false,
+    this.amberWarningLamp = false,
+  });
+
+  @override
+  String toString() => 'SPN $spn FMI $fmi (x$occurrences) from $source';
+}
+
+/// The value the native link picks for one OBD request from the answers
+/// of every ECU, by the request's policy.
+class EcuValue {
+  final String command;
+
+  /// Null if no ECU answered it recently.
+  final double? value;
+
+  /// CAN ID of the ECU [value] came from.
+  final String? ecu;
+
+  /// The ECU the request is routed to; empty while every ECU is asked.
+  final String owner;
+
+  /// ECUs heard answering it, with or without a value.
+  final int ecus;
+
+  const EcuValue({
+    required this.command,
+    this.value,
+    this.ecu,
+    this.owner = '',
+    this.ecus = 0,
+  });
+
+  @override
+  String toString() => '$command=$value from $ecu';
+}
+
+/// One ECU's answer to a DID found by the native scan: its data, or its
+/// refusal ([nrc] 0x22 or 0x33).
+class AdapterDidAnswer {
+  final int did;
+
+  /// CAN ID it answered from.
+  final String ecu;
+  final Uint8List bytes;
+
+  /// 0 for data.
+  final int nrc;
+
+  const AdapterDidAnswer({
+    required this.did,
+    required this.ecu,
+    required this.bytes,
+    required this.nrc,
+  });
+}
+
+/// Progress of the native DID scan after each chunk of requests.
+class AdapterDidScanEvent {
+  /// DIDs found in this chunk.
+  final List<AdapterDidAnswer> answers;
+  final bool running;
+
+  /// Stopped, or the link went away, before every DID was probed.
+  final bool stopped;
+  final int total;
+  final int probed;
+  final int supported;
+  final int refused;
+  final int absent;
+  final int lastDid;
+  final Duration elapsed;
+
+  /// The scan's DID states, on the last event only.
+  final Uint8List? bitmap;
+
+  const AdapterDidScanEvent({
+    required this.answers,
+    required this.running,
+    required this.stopped,
+    required this.total,
+    required this.probed,
+    required this.supported,
+    required this.refused,
+    required this.absent,
+    required this.lastDid,
+    required this.elapsed,
+    this.bitmap,
+  });
+}
+
+/// Native latency histograms and counters of the adapter link.
+class AdapterLinkStats {
+  /// bytesReceived, bytesSent, responses, timeouts, writeFailures,
+  /// overflows and droppedBytes.
+  final Map<String, int> counters;
+  final List<CommandLatency> commands;
+  final List<ResponseCount> responseCounts;
+  final List<AdaptiveTimeout> timeouts;
+
+  /// ATST changes the link wrote ahead of requests.
+  final int atstChanges;
+
+  const AdapterLinkStats({
+    required this.counters,
+    required this.commands,
+    this.responseCounts = const [],
+    this.timeouts = const [],
+    this.atstChanges = 0,
+  });
+}
+
 /// Abstract interface for Bluetooth Classic communication.
 ///
 /// Backed by flutter_bluetooth_classic_serial for real hardware.
@@ -55,9 +376,13 @@ abstract class BluetoothAdapter {
   /// Returns a stream that emits devices as they are discovered.
   Stream<BluetoothDeviceInfo> scan({Duration? timeout});
 
-  /// Connect to a device by its MAC address.
-  /// Returns true on success.
-  Future<bool> connect(String address);
+  /// Connect to a device by its MAC address, trying RFCOMM [channel] first
+  /// when given (from a connection profile). Returns true on success.
+  Future<bool> connect(String address, {int? channel});
+
+  /// RFCOMM channel the connection to [address] came up on, or null if the
+  /// platform does not report it.
+  Future<int?> connectedChannel(String address);
 
   /// Disconnect from the current device.
   Future<void> disconnect();
@@ -68,6 +393,76 @@ abstract class BluetoothAdapter {
   /// Stream of raw bytes received from the connected device.
   Stream<Uint8List> get inputStream;
 
+  /// Switch the adapter link to native response framing. Returns false if
+  /// unsupported, in which case responses keep arriving on [inputStream].
+  Future<bool> enableResponseFraming();
+
+  /// Framed responses; only emits after [enableResponseFraming] returned true.
+  Stream<AdapterResponse> get responseStream;
+
+  /// Run [commands] back to back natively, one result per command. Returns
+  /// null if unsupported; callers then fall back to one command at a time.
+  Future<List<AdapterCommandResult>?> sendCommands(
+    List<String> commands, {
+    required Duration timeout,
+  });
+
+  /// Poll each command of [periods] natively at its target period. An
+  /// empty map stops polling. Returns false if unsupported. With
+  /// [packMode01], Mode 01 PIDs of equal period share multi-PID requests;
+  /// samples still arrive per command.
+  Future<bool> setPollSchedule(Map<String, Duration> periods,
+      {bool packMode01 = false});
+
+  /// Results of the native poll schedule.
+  Stream<AdapterPollSample> get pollSamples;
+
+  /// Achieved vs. target rate per scheduled command.
+  Future<List<PollRate>> getPollStats({bool reset = false});
+
+  /// Native per-command latency and link counters, optionally starting a
+  /// new measurement window with [reset]. Null if unsupported.
+  Future<AdapterLinkStats?> getLinkStats({bool reset = false});
+
+  /// Put the adapter in passive CAN monitor mode, decoding the J1939
+  /// broadcasts of [pgns] (all known if empty) natively. [stn] selects
+  /// OBDLink's STMA and per-PGN filters. Returns false if unsupported.
+  Future<bool> startJ1939Monitor({List<int> pgns = const [], bool stn = false});
+
+  /// End monitor mode; the adapter is restored before the next command.
+  Future<bool> stopJ1939Monitor();
+
+  /// Latest decoded J1939 values, or null if unsupported or not monitoring.
+  Future<List<J1939Reading>?> readJ1939();
+
+  /// Active faults of the latest DM1 of every ECU, or null if unsupported
+  /// or not monitoring.
+  Future<List<J1939Fault>?> readJ1939Faults();
+
+  /// Pick [command]'s value from its ECUs' answers by [policy]
+  /// (`preferred`, `max` or `consensus`). Returns false if unsupported.
+  Future<bool> setEcuPolicy(String command, String policy,
+      {String? preferred});
+
+  /// Send requests only one ECU answers to that ECU (ATSH).
+  Future<bool> setEcuRouting(bool enabled);
+
+  /// The value picked per request, or null if unsupported.
+  Future<List<EcuValue>?> readEcuValues();
+
+  /// Probe the Mode 22 DIDs of [ranges] natively, skipping those [bitmap]
+  /// settled. Returns the number of DIDs to probe, or null if unsupported.
+  Future<int?> startDidScan(List<(int, int)> ranges, {Uint8List? bitmap});
+
+  /// Stop the native scan after the requests under way.
+  Future<bool> stopDidScan();
+
+  /// The DID states of the native scan so far, or null if unsupported.
+  Future<Uint8List?> getDidScanBitmap();
+
+  /// Progress of the native DID scan.
+  Stream<AdapterDidScanEvent> get didScanEvents;
+
   /// Whether currently connected.
   bool get isConnected;
 
@@ -126,37 +521,34 @@ class RealBluetoothAdapter implements BluetoothAdapter {
     final effectiveTimeout = timeout ?? const Duration(seconds: 15);
     final seen = <String>{};
 
+    void emit(bt.BluetoothDevice d) {
+      final addr = d.address;
+      if (addr.isEmpty || seen.contains(addr) || controller.isClosed) return;
+      seen.add(addr);
+      controller.add(BluetoothDeviceInfo(
+        name: d.name.isEmpty ? 'Unknown' : d.name,
+        address: addr,
+      ));
+    }
+
     () async {
+      StreamSubscription<bt.BluetoothDevice>? found;
       try {
         // Phase 1: Yield paired devices instantly
         final paired = await _bt.getPairedDevices();
-        for (final d in paired) {
-          final addr = d.address;
-          if (addr.isEmpty || seen.contains(addr)) continue;
-          seen.add(addr);
-          controller.add(BluetoothDeviceInfo(
-            name: d.name.isEmpty ? 'Unknown' : d.name,
-            address: addr,
-          ));
-        }
+        paired.forEach(emit);
 
-        // Phase 2: Run discovery for the timeout period
+        // Phase 2: Run discovery for the timeout period. Devices stream in
+        // as the platform finds them; the poll covers platforms that only
+        // keep a list.
+        found = _bt.onDeviceDiscovered.listen(emit);
         await _bt.startDiscovery();
 
-        // Poll discovered devices during the discovery window
         final deadline = DateTime.now().add(effectiveTimeout);
         while (DateTime.now().isBefore(deadline) && !controller.isClosed) {
           await Future<void>.delayed(const Duration(milliseconds: 500));
           final discovered = await _bt.getDiscoveredDevices();
-          for (final d in discovered) {
-            final addr = d.address;
-            if (addr.isEmpty || seen.contains(addr)) continue;
-            seen.add(addr);
-            controller.add(BluetoothDeviceInfo(
-              name: d.name.isEmpty ? 'Unknown' : d.name,
-              address: addr,
-            ));
-          }
+          discovered.forEach(emit);
         }
 
         await _bt.stopDiscovery();
@@ -165,6 +557,7 @@ class RealBluetoothAdapter implements BluetoothAdapter {
           controller.addError(e);
         }
       } finally {
+        await found?.cancel();
         if (!controller.isClosed) {
           await controller.close();
         }
@@ -175,17 +568,18 @@ class RealBluetoothAdapter implements BluetoothAdapter {
   }
 
   @override
-  Future<bool> connect(String address) async {
+  Future<bool> connect(String address, {int? channel}) async {
     try {
       _connected = false;
-      diag.info('RFCOMM', 'Calling _bt.connect($address)');
+      diag.info('RFCOMM', 'Calling _bt.connect($address)',
+          channel == null ? null : 'cached channel $channel');
 
       // _bt.connect() returns immediately — it just spawns a coroutine.
       // The actual RFCOMM socket takes 2-10+ seconds to open.
       // The onConnectionChanged listener (in constructor) sets _connected
       // to true when the socket is really ready.
       try {
-        await _bt.connect(address);
+        await _bt.connect(address, channel: channel);
       } catch (e) {
         // Platform channel can throw SecurityException on Android 12+ if
         // BLUETOOTH_CONNECT is not granted, or other native errors.
@@ -215,6 +609,16 @@ class RealBluetoothAdapter implements BluetoothAdapter {
     }
   }
 
+  @override
+  Future<int?> connectedChannel(String address) async {
+    try {
+      return await _bt.getConnectedChannel(address);
+    } catch (e) {
+      diag.debug('RFCOMM', 'getConnectedChannel failed', '$e');
+      return null;
+    }
+  }
+
   @override
   Future<void> disconnect() async {
     try {
@@ -238,6 +642,217 @@ class RealBluetoothAdapter implements BluetoothAdapter {
   @override
   Stream<Uint8List> get inputStream => _inputController.stream;
 
+  @override
+  Future<bool> enableResponseFraming() async {
+    try {
+      return await _bt.setResponseFraming(true);
+    } catch (e) {
+      diag.error('BT-ADAPT', 'setResponseFraming native error', '$e');
+      return false;
+    }
+  }
+
+  @override
+  Stream<AdapterResponse> get responseStream =>
+      _bt.onResponseReceived.map((r) => AdapterResponse(
+            lines: r.lines,
+            timestamp: r.timestamp,
+            elapsed: r.elapsed,
+          ));
+
+  @override
+  Future<List<AdapterCommandResult>?> sendCommands(
+    List<String> commands, {
+    required Duration timeout,
+  }) async {
+    if (!_connected) throw StateError('Not connected');
+    final results = await _bt.sendCommands(commands, timeout: timeout);
+    return results
+        ?.map((r) => AdapterCommandResult(
+              command: r.command,
+              lines: r.isOk ? r.lines : null,
+              elapsed: r.elapsed,
+            ))
+        .toList();
+  }
+
+  @override
+  Future<bool> setPollSchedule(Map<String, Duration> periods,
+      {bool packMode01 = false}) async {
+    try {
+      return await _bt.setPollSchedule(
+          periods.entries
+              .map((e) => bt.BluetoothPollEntry(command: e.key, period: e.value))
+              .toList(),
+          packMode01: packMode01);
+    } catch (e) {
+      diag.error('BT-ADAPT', 'setPollSchedule native error', '$e');
+      return false;
+    }
+  }
+
+  @override
+  Stream<AdapterPollSample> get pollSamples =>
+      _bt.onPollSample.map((s) => AdapterPollSample(
+            command: s.command,
+            lines: s.isOk ? s.lines : null,
+            timestamp: s.timestamp,
+            elapsed: s.elapsed,
+          ));
+
+  @override
+  Future<List<PollRate>> getPollStats({bool reset = false}) async {
+    final stats = await _bt.getPollStats(reset: reset);
+    return stats
+        .map((s) => PollRate(
+              command: s.command,
+              targetHz: s.targetHz,
+              achievedHz: s.achievedHz,
+              samples: s.samples,
+              timeouts: s.timeouts,
+              deadlineMisses: s.deadlineMisses,
+            ))
+        .toList();
+  }
+
+  @override
+  Future<AdapterLinkStats?> getLinkStats({bool reset = false}) async {
+    final stats = await _bt.getStats();
+    if (stats == null) return null;
+    if (reset) await _bt.resetStats();
+    Duration phase(bt.BluetoothCommandLatency c, String name,
+            Duration Function(bt.BluetoothLatencySummary s) pick) =>
+        c.phases[name] == null ? Duration.zero : pick(c.phases[name]!);
+    return AdapterLinkStats(
+      counters: stats.counters,
+      commands: stats.commands
+          .map((c) => CommandLatency(
+                command: c.command,
+                completed: c.completed,
+                timeouts: c.timeouts,
+                p50: phase(c, 'roundTrip', (s) => s.p50),
+                p99: phase(c, 'roundTrip', (s) => s.p99),
+                firstByteP50: phase(c, 'firstByte', (s) => s.p50),
+                deliveryP99: phase(c, 'delivery', (s) => s.p99),
+              ))
+          .toList(),
+      responseCounts: stats.responseCounts
+          .map((r) => ResponseCount(
+                command: r.command,
+                count: r.count,
+                countedReplies: r.countedReplies,
+                saved: r.saved,
+              ))
+          .toList(),
+      timeouts: stats.timeouts
+          .map((t) => AdaptiveTimeout(
+                command: t.command,
+                counts: t.counts,
+                noData: t.noData,
+                backoffs: t.backoffs,
+              ))
+          .toList(),
+      atstChanges: stats.atstChanges,
+    );
+  }
+
+  @override
+  Future<bool> startJ1939Monitor(
+          {List<int> pgns = const [], bool stn = false}) =>
+      _bt.startJ1939Monitor(pgns: pgns, stn: stn);
+
+  @override
+  Future<bool> stopJ1939Monitor() => _bt.stopJ1939Monitor();
+
+  @override
+  Future<List<J1939Reading>?> readJ1939() async {
+    final values = await _bt.getJ1939Values();
+    if (values == null || !values.monitoring) return null;
+    return values.values
+        .map((v) => J1939Reading(
+              spn: v.spn,
+              pgn: v.pgn,
+              id: v.id,
+              unit: v.unit,
+              value: v.value,
+              source: v.source,
+              age: v.age,
+            ))
+        .toList();
+  }
+
+  @override
+  Future<List<J1939Fault>?> readJ1939Faults() async {
+    final values = await _bt.getJ1939Values();
+    if (values == null || !values.monitoring) return null;
+    return [
+      for (final dm1 in values.dm1)
+        for (final dtc in dm1.dtcs)
+          J1939Fault(
+            source: dm1.source,
+            spn: dtc.spn,
+            fmi: dtc.fmi,
+            occurrences: dtc.occurrences,
+            malfunctionLamp: dm1.malfunctionLamp,
+            redStopLamp: dm1.redStopLamp,
+            amberWarningLamp: dm1.amberWarningLamp,
+          ),
+    ];
+  }
+
+  @override
+  Future<bool> setEcuPolicy(String command, String policy,
+          {String? preferred}) =>
+      _bt.setEcuPolicies(
+          [bt.BluetoothEcuPolicy(command, policy, preferred: preferred)]);
+
+  @override
+  Future<bool> setEcuRouting(bool enabled) => _bt.setEcuRouting(enabled);
+
+  @override
+  Future<List<EcuValue>?> readEcuValues() async {
+    final values = await _bt.getEcuValues();
+    if (values == null) return null;
+    return values.values
+        .map((v) => EcuValue(
+              command: v.command,
+              value: v.value,
+              ecu: v.selectedEcu,
+              owner: v.owner,
+              ecus: v.ecus.length,
+            ))
+        .toList();
+  }
+
+  @override
+  Future<int?> startDidScan(List<(int, int)> ranges, {Uint8List? bitmap}) =>
+      _bt.startDidScan(ranges, bitmap: bitmap);
+
+  @override
+  Future<bool> stopDidScan() => _bt.stopDidScan();
+
+  @override
+  Future<Uint8List?> getDidScanBitmap() => _bt.getDidScanBitmap();
+
+  @override
+  Stream<AdapterDidScanEvent> get didScanEvents =>
+      _bt.onDidScanProgress.map((p) => AdapterDidScanEvent(
+            answers: p.answers
+                .map((a) => AdapterDidAnswer(
+                    did: a.did, ecu: a.ecu, bytes: a.bytes, nrc: a.nrc))
+                .toList(),
+            running: p.running,
+            stopped: p.stopped,
+            total: p.total,
+            probed: p.probed,
+            supported: p.supported,
+            refused: p.refused,
+            absent: p.absent,
+            lastDid: p.lastDid,
+            elapsed: p.elapsed,
+            bitmap: p.bitmap,
+          ));
+
   @override
   bool get isConnected => _connected;
 
@@ -294,8 +909,37 @@ class BluetoothService {
       StreamController<String>.broadcast();
 
   StreamSubscription<Uint8List>? _inputSubscription;
+  StreamSubscription<AdapterResponse>? _responseSubscription;
+
+  /// Whether the adapter frames responses natively. When false, responses
+  /// are framed here from the raw input stream.
+  bool _nativeFraming = false;
+
+  /// A [sendCommands] batch is running; single commands must wait.
+  bool _batchInFlight = false;
+
+  /// The adapter reported no batch support; skip asking again.
+  bool _batchUnsupported = false;
+
+  /// A native poll schedule owns the link; single commands must go through
+  /// the native pipeline too so only one command is ever outstanding.
+  bool _nativePolling = false;
 
-  // Response accumulation buffer
+  /// Hex OBD requests (`010C`, `22A09F`) without a response count. Sent
+  /// through the native pipeline, they get the responder count it learns.
+  static final RegExp _obdRequest = RegExp(r'^(?:[0-9A-Fa-f]{2}){2,}$');
+
+  /// Commands that set or reset the adapter's response timeout. Sent through
+  /// the native pipeline as well, so its per-request ATST knows the value
+  /// the adapter has and the one the app asked for.
+  static final RegExp _timeoutCommand =
+      RegExp(r'^AT ?(?:ST ?[0-9A-Fa-f]{2}|Z|WS|D)$', caseSensitive: false);
+
+  int? _rfcommChannel;
+  DateTime? _connectStartedAt;
+  final ConnectionProfileCache _profileCache = ConnectionProfileCache();
+
+  // Response accumulation buffer (Dart-side framing only)
   final StringBuffer _responseBuffer = StringBuffer();
   Completer<String>? _pendingResponse;
   Timer? _responseTimeout;
@@ -308,6 +952,13 @@ class BluetoothService {
   bool get isConnected => _state == BluetoothConnectionState.connected;
   int get reconnectAttempts => _reconnectAttempts;
 
+  /// RFCOMM channel of the current connection, when the platform reports it.
+  int? get rfcommChannel => _rfcommChannel;
+
+  /// When the current connection attempt began; start of the
+  /// connect-to-first-sample measurement.
+  DateTime? get connectStartedAt => _connectStartedAt;
+
   /// Current sleep reconnect phase (none when not sleeping).
   SleepReconnectPhase get sleepPhase => _sleepPhase;
 
@@ -362,11 +1013,17 @@ class BluetoothService {
     _setState(BluetoothConnectionState.connecting);
     _connectedAddress = address;
     _lastError = null;
+    _rfcommChannel = null;
+    _connectStartedAt = DateTime.now();
     diag.info('BT-SVC', 'Connecting to $address...');
 
     try {
+      // The channel that worked last time skips SDP and channel probing
+      final profile = await _profileCache.latestForAdapter(address);
+
       // This now waits for the RFCOMM socket to actually open
-      final success = await _adapter.connect(address);
+      final success =
+          await _adapter.connect(address, channel: profile?.rfcommChannel);
       if (!success) {
         diag.error('BT-SVC', 'Adapter connect failed');
         _setError('Connection refused by device');
@@ -374,7 +1031,9 @@ class BluetoothService {
         return false;
       }
 
-      diag.info('BT-SVC', 'Adapter connected, setting up streams');
+      _rfcommChannel = await _adapter.connectedChannel(address);
+      diag.info('BT-SVC', 'Adapter connected, setting up streams',
+          _rfcommChannel == null ? null : 'RFCOMM channel $_rfcommChannel');
 
       // Connection succeeded — clear all sleep/reconnect state
       _sleepDisconnect = false;
@@ -396,6 +1055,23 @@ class BluetoothService {
         },
       );
 
+      // Prefer native framing: whole responses arrive pre-split, so the
+      // isolate never rescans partial data
+      _responseSubscription?.cancel();
+      _responseSubscription = null;
+      _nativePolling = false;
+      _nativeFraming = await _adapter.enableResponseFraming();
+      if (_nativeFraming) {
+        _responseSubscription = _adapter.responseStream.listen(
+          _onResponseReceived,
+          onError: (Object error) {
+            diag.error('BT-SVC', 'Response stream error', '$error');
+          },
+        );
+      }
+      diag.info('BT-SVC',
+          'Response framing: ${_nativeFraming ? 'native' : 'Dart'}');
+
       _reconnectAttempts = 0;
       _responseBuffer.clear();
       _pendingResponse = null;
@@ -428,6 +1104,8 @@ class BluetoothService {
     _setSleepPhase(SleepReconnectPhase.none);
     _healthCheckTimer?.cancel();
     _inputSubscription?.cancel();
+    _responseSubscription?.cancel();
+    _nativePolling = false;
     _pendingResponse?.completeError(
       StateError('Disconnected while waiting for response'),
     );
@@ -480,6 +1158,7 @@ class BluetoothService {
     // Disconnect Bluetooth
     _healthCheckTimer?.cancel();
     _inputSubscription?.cancel();
+    _responseSubscription?.cancel();
     _pendingResponse?.completeError(
       StateError('Sleep disconnect'),
     );
@@ -516,10 +1195,12 @@ class BluetoothService {
     if (!isConnected) {
       throw StateError('Not connected to OBD adapter');
     }
-    if (_pendingResponse != null && !_pendingResponse!.isCompleted) {
+    if (_batchInFlight ||
+        (_pendingResponse != null && !_pendingResponse!.isCompleted)) {
       // Wait briefly for the previous response to complete, then fail
       await Future<void>.delayed(const Duration(milliseconds: 100));
-      if (_pendingResponse != null && !_pendingResponse!.isCompleted) {
+      if (_batchInFlight ||
+          (_pendingResponse != null && !_pendingResponse!.isCompleted)) {
         throw StateError(
           'Previous command still pending. Only one command at a time.',
         );
@@ -539,6 +1220,29 @@ class BluetoothService {
       }
     }
 
+    final effectiveTimeout = timeout ?? AppConstants.obdTimeout;
+    // Queued natively between two scheduled samples. OBD requests take the
+    // native path whenever it exists, so the link can append the learned
+    // response count and skip the adapter's wait for more ECUs; timeout
+    // changes follow them so the link's own ATST changes stay in step.
+    if (_nativePolling ||
+        (_nativeFraming &&
+            !_batchUnsupported &&
+            (_obdRequest.hasMatch(command) ||
+                _timeoutCommand.hasMatch(command)))) {
+      final results = await sendCommands([command], timeout: effectiveTimeout);
+      if (results != null || _nativePolling) {
+        final response = results?.first;
+        if (response == null) {
+          throw TimeoutException(
+            'OBD command timed out: $command',
+            effectiveTimeout,
+          );
+        }
+        return response;
+      }
+    }
+
     _responseBuffer.clear();
     _pendingResponse = Completer<String>();
 
@@ -553,7 +1257,6 @@ class BluetoothService {
     }
 
     // Set up timeout (use provided timeout or default)
-    final effectiveTimeout = timeout ?? AppConstants.obdTimeout;
     _responseTimeout?.cancel();
     _responseTimeout = Timer(effectiveTimeout, () {
       if (_pendingResponse != null && !_pendingResponse!.isCompleted) {
@@ -576,6 +1279,146 @@ class BluetoothService {
     }
   }
 
+  /// Send a batch of AT/OBD commands and return each one's response, in
+  /// order, or null for commands that timed out.
+  ///
+  /// The adapter runs the batch natively, writing each command as soon as
+  /// the previous prompt arrives. Returns null when the adapter has no
+  /// batch support; use [sendCommand] per command instead.
+  ///
+  /// Throws [StateError] if not connected or another command is pending.
+  Future<List<String?>?> sendCommands(
+    List<String> commands, {
+    Duration? timeout,
+  }) async {
+    if (!isConnected) {
+      throw StateError('Not connected to OBD adapter');
+    }
+    if (!_nativeFraming || _batchUnsupported) return null;
+    if (_batchInFlight ||
+        (_pendingResponse != null && !_pendingResponse!.isCompleted)) {
+      throw StateError(
+        'Previous command still pending. Only one command at a time.',
+      );
+    }
+
+    _batchInFlight = true;
+    try {
+      final results = await _adapter.sendCommands(
+        commands,
+        timeout: timeout ?? AppConstants.obdTimeout,
+      );
+      if (results == null) {
+        _batchUnsupported = true;
+        return null;
+      }
+      return results.map((r) => r.lines?.join('\n')).toList();
+    } finally {
+      _batchInFlight = false;
+    }
+  }
+
+  /// Hand periodic polling to the adapter link: each command of [periods]
+  /// is sent natively at its target period, earliest deadline first, and
+  /// its results arrive on [pollSamples]. Other commands keep working and
+  /// are slotted in between samples. An empty map stops native polling.
+  ///
+  /// Mode 01 PIDs of equal period can share multi-PID requests
+  /// ([packMode01]); their samples still arrive one per command.
+  ///
+  /// Returns false when the adapter has no native scheduler.
+  Future<bool> setPollSchedule(Map<String, Duration> periods,
+      {bool packMode01 = false}) async {
+    if (!isConnected || !_nativeFraming) return false;
+    final ok = await _adapter.setPollSchedule(periods, packMode01: packMode01);
+    _nativePolling = ok && periods.isNotEmpty;
+    return ok;
+  }
+
+  /// Results of the schedule set with [setPollSchedule].
+  Stream<AdapterPollSample> get pollSamples => _adapter.pollSamples;
+
+  /// Achieved vs. target rate per scheduled command.
+  Future<List<PollRate>> getPollStats({bool reset = false}) =>
+      _adapter.getPollStats(reset: reset);
+
+  /// Native per-command latency and link counters; null if unsupported.
+  Future<AdapterLinkStats?> getLinkStats({bool reset = false}) =>
+      _adapter.getLinkStats(reset: reset);
+
+  /// Listen to the bus instead of polling: the adapter prints every J1939
+  /// broadcast of [pgns] (all the native table knows if empty) and the link
+  /// decodes them as they arrive, so engine speed, load and temperatures
+  /// update at their broadcast rates (EEC1 every 10 ms) without a request
+  /// each. Stop native polling first; no command can be sent until
+  /// [stopJ1939Monitor]. [stn] is for OBDLink (STN) adapters, which filter
+  /// per PGN. Returns false when the adapter has no native monitor.
+  Future<bool> startJ1939Monitor(
+      {List<int> pgns = const [], bool stn = false}) async {
+    if (!isConnected || !_nativeFraming || _nativePolling) return false;
+    return _adapter.startJ1939Monitor(pgns: pgns, stn: stn);
+  }
+
+  /// End monitor mode started with [startJ1939Monitor].
+  Future<bool> stopJ1939Monitor() => _adapter.stopJ1939Monitor();
+
+  /// Latest values of the monitor, or null when it is not running (also
+  /// after the adapter stopped it with BUFFER FULL).
+  Future<List<J1939Reading>?> readJ1939() => _adapter.readJ1939();
+
+  /// Active faults the ECUs broadcast in their DM1s while the monitor runs,
+  /// multi-fault ones reassembled natively from their BAM packets. Null
+  /// when the monitor is not running.
+  Future<List<J1939Fault>?> readJ1939Faults() => _adapter.readJ1939Faults();
+
+  /// Have the link pick [command]'s value from every ECU's answer by
+  /// [policy]: `preferred` ([preferred], else the ECU owning the request),
+  /// `max` or `consensus`. Only with native framing, which sees the
+  /// headers of each answer; returns false otherwise.
+  Future<bool> setEcuPolicy(String command, String policy,
+      {String? preferred}) async {
+    if (!isConnected || !_nativeFraming) return false;
+    return _adapter.setEcuPolicy(command, policy, preferred: preferred);
+  }
+
+  /// Once every ECU has been heard, send each request that only one ECU
+  /// answers to that ECU alone (ATSH physical addressing), so the others
+  /// stop answering 7F to PIDs they do not have.
+  Future<bool> setEcuRouting(bool enabled) async {
+    if (!isConnected || !_nativeFraming) return false;
+    return _adapter.setEcuRouting(enabled);
+  }
+
+  /// The value the link picked per request; null without native framing.
+  Future<List<EcuValue>?> readEcuValues() async {
+    if (!isConnected || !_nativeFraming) return null;
+    return _adapter.readEcuValues();
+  }
+
+  /// Scan the Mode 22 DIDs of [ranges] on the link itself: requests are
+  /// pipelined to every ECU, several DIDs each while none answers, with
+  /// the learned response count so absent DIDs cost no timeout. DIDs
+  /// [bitmap] (from an earlier scan's last [didScanEvents] event) settled
+  /// are skipped. Returns the number of DIDs to probe, or null without
+  /// native framing; stop native polling first.
+  Future<int?> startDidScan(List<(int, int)> ranges,
+      {Uint8List? bitmap}) async {
+    if (!isConnected || !_nativeFraming || _nativePolling) return null;
+    return _adapter.startDidScan(ranges, bitmap: bitmap);
+  }
+
+  /// Stop the scan started with [startDidScan]; its last event follows.
+  Future<bool> stopDidScan() => _adapter.stopDidScan();
+
+  /// The DID states of the scan so far, for saving while it runs.
+  Future<Uint8List?> getDidScanBitmap() async {
+    if (!isConnected || !_nativeFraming) return null;
+    return _adapter.getDidScanBitmap();
+  }
+
+  /// Progress and finds of the scan started with [startDidScan].
+  Stream<AdapterDidScanEvent> get didScanEvents => _adapter.didScanEvents;
+
   // ─── Auto-Reconnect ───
 
   /// Enable auto-reconnect with exponential backoff.
@@ -621,6 +1464,7 @@ class BluetoothService {
     _sleepReconnectTimer?.cancel();
     _healthCheckTimer?.cancel();
     _inputSubscription?.cancel();
+    _responseSubscription?.cancel();
     _responseTimeout?.cancel();
     _pendingResponse?.completeError(
       StateError('BluetoothService disposed'),
@@ -665,31 +1509,48 @@ class BluetoothService {
       _dataController.add(chunk);
     }
 
-    // Accumulate into response buffer
-    _responseBuffer.write(chunk);
-    final bufferStr = _responseBuffer.toString();
-
-    // Check for prompt character '>' indicating response complete
-    if (bufferStr.contains('>')) {
-      final response = bufferStr
-          .replaceAll('>', '')
+    // Only the new chunk is scanned for the prompt character '>'; the
+    // accumulated buffer is joined and split once per response.
+    var start = 0;
+    var prompt = chunk.indexOf('>');
+    while (prompt >= 0) {
+      _responseBuffer.write(chunk.substring(start, prompt));
+      final response = _responseBuffer
+          .toString()
           .replaceAll('\r', '\n')
           .split('\n')
           .map((l) => l.trim())
           .where((l) => l.isNotEmpty)
-          .join('\n')
-          .trim();
-
-      if (_pendingResponse != null && !_pendingResponse!.isCompleted) {
-        _pendingResponse!.complete(response);
-      }
+          .join('\n');
       _responseBuffer.clear();
+      _completeResponse(response);
+      start = prompt + 1;
+      prompt = chunk.indexOf('>', start);
+    }
+    _responseBuffer.write(start == 0 ? chunk : chunk.substring(start));
+  }
+
+  void _onResponseReceived(AdapterResponse response) {
+    if (_disposed) return;
+
+    final text = response.lines.join('\n');
+    if (!_dataController.isClosed) {
+      _dataController.add(text);
+    }
+    _completeResponse(text);
+  }
+
+  void _completeResponse(String response) {
+    if (_pendingResponse != null && !_pendingResponse!.isCompleted) {
+      _pendingResponse!.complete(response);
     }
   }
 
   void _handleDisconnect() {
+    _nativePolling = false;
     _healthCheckTimer?.cancel();
     _inputSubscription?.cancel();
+    _responseSubscription?.cancel();
     _setState(BluetoothConnectionState.disconnected);
 
     if (_autoReconnectEnabled) {
@@ -0,0 +1,176 @@
+import 'dart:convert';
+
+import 'package:myapp/config/constants.dart';
+import 'package:myapp/services/diagnostic_service.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+
+const _tag = 'PROFILE';
+
+/// What a successful bring-up learned about one adapter + vehicle pair, so
+/// the next connect can skip channel discovery, protocol probing and the
+/// supported-PID queries.
+class ConnectionProfile {
+  final String adapterAddress;
+
+  /// Empty when the vehicle did not report one.
+  final String vin;
+
+  /// RFCOMM channel the adapter answered on; null where the platform does
+  /// not expose it.
+  final int? rfcommChannel;
+
+  /// Confirmed ELM327 protocol number (the ATSP argument).
+  final String atspCode;
+
+  /// Supported OBD2 PIDs from the 0100/0120/0140/0160 bitmaps; null if
+  /// the ECU never returned one.
+  final Set<int>? supportedPids;
+
+  /// Smoothed request-to-response time per PID id, in milliseconds.
+  final Map<String, double> pidLatencyMs;
+
+  final DateTime updatedAt;
+
+  const ConnectionProfile({
+    required this.adapterAddress,
+    required this.vin,
+    required this.rfcommChannel,
+    required this.atspCode,
+    required this.supportedPids,
+    required this.pidLatencyMs,
+    required this.updatedAt,
+  });
+
+  String get key => ConnectionProfileCache.keyFor(adapterAddress, vin);
+
+  Map<String, dynamic> toJson() => {
+        'adapterAddress': adapterAddress,
+        'vin': vin,
+        'rfcommChannel': rfcommChannel,
+        'atspCode': atspCode,
+        'supportedPids':
+            supportedPids == null ? null : (supportedPids!.toList()..sort()),
+        'pidLatencyMs': pidLatencyMs,
+        'updatedAt': updatedAt.toIso8601String(),
+      };
+
+  factory ConnectionProfile.fromJson(Map<String, dynamic> json) {
+    final pids = json['supportedPids'] as List<dynamic>?;
+    final latency = (json['pidLatencyMs'] as Map<String, dynamic>?) ?? {};
+    return ConnectionProfile(
+      adapterAddress: json['adapterAddress'] as String,
+      vin: json['vin'] as String? ?? '',
+      rfcommChannel: json['rfcommChannel'] as int?,
+      atspCode: json['atspCode'] as String,
+      supportedPids: pids?.map((p) => p as int).toSet(),
+      pidLatencyMs:
+          latency.map((id, ms) => MapEntry(id, (ms as num).toDouble())),
+      updatedAt: DateTime.tryParse(json['updatedAt'] as String? ?? '') ??
+          DateTime.fromMillisecondsSinceEpoch(0),
+    );
+  }
+
+  ConnectionProfile copyWith({
+    int? rfcommChannel,
+    String? atspCode,
+    Set<int>? supportedPids,
+    Map<String, double>? pidLatencyMs,
+  }) =>
+      ConnectionProfile(
+        adapterAddress: adapterAddress,
+        vin: vin,
+        rfcommChannel: rfcommChannel ?? this.rfcommChannel,
+        atspCode: atspCode ?? this.atspCode,
+        supportedPids: supportedPids ?? this.supportedPids,
+        pidLatencyMs: pidLatencyMs ?? this.pidLatencyMs,
+        updatedAt: DateTime.now(),
+      );
+}
+
+/// Connection profiles persisted in SharedPreferences, keyed by adapter
+/// address and VIN.
+///
+/// The stored document carries [version]; a document written by another
+/// version is ignored (and replaced on the next save) rather than
+/// migrated, since everything in it can be re-detected.
+class ConnectionProfileCache {
+  static const version = 1;
+
+  /// Oldest profiles beyond this are dropped on save.
+  static const maxProfiles = 8;
+
+  static String keyFor(String adapterAddress, String vin) =>
+      '${adapterAddress.toUpperCase()}|$vin';
+
+  /// Most recently updated profile for [adapterAddress], whatever the
+  /// vehicle. The VIN read after connecting decides whether it applies.
+  Future<ConnectionProfile?> latestForAdapter(String adapterAddress) async {
+    final address = adapterAddress.toUpperCase();
+    ConnectionProfile? latest;
+    for (final profile in (await _load()).values) {
+      if (profile.adapterAddress.toUpperCase() != address) continue;
+      if (latest == null || profile.updatedAt.isAfter(latest.updatedAt)) {
+        latest = profile;
+      }
+    }
+    return latest;
+  }
+
+  Future<ConnectionProfile?> lookup(String adapterAddress, String vin) async =>
+      (await _load())[keyFor(adapterAddress, vin)];
+
+  Future<void> save(ConnectionProfile profile) async {
+    final profiles = await _load();
+    profiles[profile.key] = profile;
+    if (profiles.length > maxProfiles) {
+      final byAge = profiles.values.toList()
+        ..sort((a, b) => b.updatedAt.compareTo(a.updatedAt));
+      profiles
+        ..clear()
+        ..addEntries(byAge.take(maxProfiles).map((p) => MapEntry(p.key, p)));
+    }
+    await _store(profiles);
+  }
+
+  Future<void> remove(String adapterAddress, String vin) async {
+    final profiles = await _load();
+    if (profiles.remove(keyFor(adapterAddress, vin)) != null) {
+      await _store(profiles);
+    }
+  }
+
+  Future<Map<String, ConnectionProfile>> _load() async {
+    try {
+      final prefs = await SharedPreferences.getInstance();
+      final raw = prefs.getString(AppConstants.connectionProfilesKey);
+      if (raw == null) return {};
+
+      final doc = jsonDecode(raw) as Map<String, dynamic>;
+      if (doc['version'] != version) {
+        diag.info(_tag, 'Ignoring profiles from version ${doc['version']}');
+        return {};
+      }
+      final profiles = doc['profiles'] as Map<String, dynamic>? ?? {};
+      return profiles.map((key, json) => MapEntry(
+          key, ConnectionProfile.fromJson(json as Map<String, dynamic>)));
+    } catch (e) {
+      diag.warn(_tag, 'Failed to read connection profiles', '$e');
+      return {};
+    }
+  }
+
+  Future<void> _store(Map<String, ConnectionProfile> profiles) async {
+    try {
+      final prefs = await SharedPreferences.getInstance();
+      await prefs.setString(
+        AppConstants.connectionProfilesKey,
+        jsonEncode({
+          'version': version,
+          'profiles': profiles.map((key, p) => MapEntry(key, p.toJson())),
+        }),
+      );
+    } catch (e) {
+      diag.warn(_tag, 'Failed to save connection profiles', '$e');
+    }
+  }
+}
@@ -0,0 +1,135 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:myapp/config/constants.dart';
+import 'package:myapp/models/did_scan_result.dart';
+import 'package:myapp/services/diagnostic_service.dart';
+import 'package:shared_preferences/shared_preferences.dart';
+
+const _tag = 'DID-SCAN';
+
+/// What the DID scans of one vehicle found so far.
+class DidScanState {
+  final String vin;
+
+  /// The native scan's DID states, two bits per DID (0 unknown, 1
+  /// supported, 2 refused, 3 absent); empty if it never ran.
+  final Uint8List bitmap;
+
+  /// Supported and refused DIDs, with the data or code they answered.
+  final List<DidScanResult> found;
+  final DateTime updatedAt;
+
+  const DidScanState({
+    required this.vin,
+    required this.bitmap,
+    required this.found,
+    required this.updatedAt,
+  });
+
+  Map<String, dynamic> toJson() => {
+        'vin': vin,
+        'bitmap': base64Encode(bitmap),
+        'found': found
+            .map((r) => {
+                  'did': r.did,
+                  'response': r.response,
+                  if (r.dataBytes != null) 'data': r.dataBytes,
+                  if (r.nrc != null) 'nrc': r.nrc,
+                  if (r.ecuAddress != null) 'ecu': r.ecuAddress,
+                })
+            .toList(),
+        'updatedAt': updatedAt.toIso8601String(),
+      };
+
+  factory DidScanState.fromJson(Map<String, dynamic> json) {
+    final found = (json['found'] as List<dynamic>? ?? const [])
+        .map((entry) => entry as Map<String, dynamic>)
+        .map((entry) => DidScanResult(
+              did: entry['did'] as int,
+              response: entry['response'] as String,
+              dataBytes: (entry['data'] as List<dynamic>?)
+                  ?.map((b) => b as int)
+                  .toList(),
+              nrc: entry['nrc'] as int?,
+              rawHex: '',
+              ecuAddress: entry['ecu'] as String?,
+            ))
+        .toList();
+    return DidScanState(
+      vin: json['vin'] as String,
+      bitmap: base64Decode(json['bitmap'] as String? ?? ''),
+      found: found,
+      updatedAt: DateTime.tryParse(json['updatedAt'] as String? ?? '') ??
+          DateTime.fromMillisecondsSinceEpoch(0),
+    );
+  }
+}
+
+/// DID scan states persisted in SharedPreferences per VIN, so a stopped
+/// scan resumes where it was and a rescan only probes the DIDs still
+/// unknown.
+///
+/// Versioned like [ConnectionProfileCache]: a document of another version
+/// is ignored and replaced on the next save.
+class DidScanStore {
+  static const version = 1;
+
+  /// Oldest vehicles beyond this are dropped on save; a bitmap is 16 KB.
+  static const maxVehicles = 4;
+
+  Future<DidScanState?> lookup(String vin) async => (await _load())[vin];
+
+  Future<void> save(DidScanState state) async {
+    final states = await _load();
+    states[state.vin] = state;
+    if (states.length > maxVehicles) {
+      final byAge = states.values.toList()
+        ..sort((a, b) => b.updatedAt.compareTo(a.updatedAt));
+      states
+        ..clear()
+        ..addEntries(byAge.take(maxVehicles).map((s) => MapEntry(s.vin, s)));
+    }
+    await _store(states);
+  }
+
+  Future<void> remove(String vin) async {
+    final states = await _load();
+    if (states.remove(vin) != null) await _store(states);
+  }
+
+  Future<Map<String, DidScanState>> _load() async {
+    try {
+      final prefs = await SharedPreferences.getInstance();
+      final raw = prefs.getString(AppConstants.didScanStatesKey);
+      if (raw == null) return {};
+
+      final doc = jsonDecode(raw) as Map<String, dynamic>;
+      if (doc['version'] != version) {
+        diag.info(_tag, 'Ignoring scan states from version ${doc['version']}');
+        return {};
+      }
+      final states = doc['vehicles'] as Map<String, dynamic>? ?? {};
+      return states.map((vin, json) =>
+          MapEntry(vin, DidScanState.fromJson(json as Map<String, dynamic>)));
+    } catch (e) {
+      diag.warn(_tag, 'Failed to read scan states', '$e');
+      return {};
+    }
+  }
+
+  Future<void> _store(Map<String, DidScanState> states) async {
+    try {
+      final prefs = await SharedPreferences.getInstance();
+      await prefs.setString(
+        AppConstants.didScanStatesKey,
+        jsonEncode({
+          'version': version,
+          'vehicles': states.map((vin, s) => MapEntry(vin, s.toJson())),
+        }),
+      );
+    } catch (e) {
+      diag.warn(_tag, 'Failed to save scan states', '$e');
+    }
+  }
+}
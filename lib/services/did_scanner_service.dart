@@ -1,8 +1,10 @@
 import 'dart:async';
+import 'dart:typed_data';
 
 import 'package:myapp/models/did_scan_result.dart';
 import 'package:myapp/services/bluetooth_service.dart';
 import 'package:myapp/services/diagnostic_service.dart';
+import 'package:myapp/services/did_scan_store.dart';
 import 'package:myapp/services/obd2_parser.dart';
 import 'package:myapp/services/obd_service.dart';
 
@@ -29,23 +31,39 @@ class DidRanges {
   }
 }
 
-/// Scans Mode $22 DID ranges via BluetoothService.sendCommand().
+/// Scans Mode $22 DID ranges, natively on the adapter link where it can
+/// (BluetoothService.startDidScan), else via BluetoothService.sendCommand().
 ///
 /// Automatically stops OBD polling and pauses health checks before scanning,
 /// then restores both when done. Read-only, warranty-safe.
+///
+/// The native scan keeps what it learned about every DID per VIN in
+/// [DidScanStore], so a stopped or disconnected scan resumes where it was
+/// and a rescan only probes the DIDs still unknown.
 class DidScannerService {
   final BluetoothService _bluetooth;
   final ObdService _obdService;
+  final DidScanStore _store;
 
   DidScannerService({
     required BluetoothService bluetooth,
     required ObdService obdService,
+    DidScanStore? store,
   })  : _bluetooth = bluetooth,
-        _obdService = obdService;
+        _obdService = obdService,
+        _store = store ?? DidScanStore();
+
+  /// How often a running native scan's DID states are saved.
+  static const _saveInterval = Duration(seconds: 5);
+
+  /// How long a running native scan may go without an event before it is
+  /// given up; each chunk of requests sends one.
+  static const _stallTimeout = Duration(seconds: 30);
 
   bool _scanning = false;
   bool _stopRequested = false;
   bool _wasPolling = false;
+  bool _nativeRunning = false;
 
   final _progressController = StreamController<DidScanProgress>.broadcast();
 
@@ -90,6 +108,7 @@ class DidScannerService {
     int negativeCount = 0;
     int timeoutCount = 0;
     int errorCount = 0;
+    int? scannedCount;
 
     final totalDids = DidRanges.totalDids(ranges);
     final rangeLabels = ranges.map(DidRanges.rangeLabel).toList();
@@ -104,82 +123,91 @@ class DidScannerService {
       // Set fast timeout: 0x1E = 30 decimal → 30 × 4.096ms ≈ 123ms
       await _bluetooth.sendCommand('ATST1E', timeout: const Duration(seconds: 1));
 
-      int current = 0;
-
-      for (final range in ranges) {
-        if (_stopRequested) break;
-
-        for (int did = range.$1; did <= range.$2; did++) {
+      final native = await _scanNatively(ranges, results);
+      if (native != null) {
+        // Finds of earlier scans of the vehicle included
+        foundCount = results.where((r) => r.response == 'ok').length;
+        negativeCount = native.refused + native.absent;
+        timeoutCount = native.unsettled;
+        scannedCount = native.probed;
+      } else {
+        int current = 0;
+
+        for (final range in ranges) {
           if (_stopRequested) break;
 
-          current++;
-          final didHex = did.toRadixString(16).toUpperCase().padLeft(4, '0');
-          final command = '22$didHex';
-
-          try {
-            final raw = await _bluetooth.sendCommand(
-              command,
-              timeout: timeout + const Duration(milliseconds: 80),
-            );
-
-            final result = _classifyResponse(did, raw, didHex);
-            results.add(result);
-
-            switch (result.response) {
-              case 'ok':
-                foundCount++;
-                diag.info(_tag, 'FOUND DID $didHex',
-                    'ecu=${result.ecuAddress ?? '?'} '
-                    '${result.dataBytes?.length ?? 0}B: ${result.dataBytesHex}');
-              case 'negative':
-                negativeCount++;
-              case 'timeout':
-                timeoutCount++;
-              case 'error':
-                errorCount++;
+          for (int did = range.$1; did <= range.$2; did++) {
+            if (_stopRequested) break;
+
+            current++;
+            final didHex = did.toRadixString(16).toUpperCase().padLeft(4, '0');
+            final command = '22$didHex';
+
+            try {
+              final raw = await _bluetooth.sendCommand(
+                command,
+                timeout: timeout + const Duration(milliseconds: 80),
+              );
+
+              final result = _classifyResponse(did, raw, didHex);
+              results.add(result);
+
+              switch (result.response) {
+                case 'ok':
+                  foundCount++;
+                  diag.info(_tag, 'FOUND DID $didHex',
+                      'ecu=${result.ecuAddress ?? '?'} '
+                      '${result.dataBytes?.length ?? 0}B: ${result.dataBytesHex}');
+                case 'negative':
+                  negativeCount++;
+                case 'timeout':
+                  timeoutCount++;
+                case 'error':
+                  errorCount++;
+              }
+            } on TimeoutException {
+              timeoutCount++;
+              results.add(DidScanResult(
+                did: did,
+                response: 'timeout',
+                rawHex: '',
+              ));
+            } on StateError catch (e) {
+              errorCount++;
+              results.add(DidScanResult(
+                did: did,
+                response: 'error',
+                rawHex: e.toString(),
+              ));
+              diag.error(_tag, 'StateError at DID $didHex', e.toString());
+              if (!_bluetooth.isConnected) {
+                diag.error(_tag, 'Adapter disconnected, aborting scan');
+                _stopRequested = true;
+                break;
+              }
+            } catch (e) {
+              errorCount++;
+              results.add(DidScanResult(
+                did: did,
+                response: 'error',
+                rawHex: e.toString(),
+              ));
             }
-          } on TimeoutException {
-            timeoutCount++;
-            results.add(DidScanResult(
-              did: did,
-              response: 'timeout',
-              rawHex: '',
-            ));
-          } on StateError catch (e) {
-            errorCount++;
-            results.add(DidScanResult(
-              did: did,
-              response: 'error',
-              rawHex: e.toString(),
-            ));
-            diag.error(_tag, 'StateError at DID $didHex', e.toString());
-            if (!_bluetooth.isConnected) {
-              diag.error(_tag, 'Adapter disconnected, aborting scan');
-              _stopRequested = true;
-              break;
-            }
-          } catch (e) {
-            errorCount++;
-            results.add(DidScanResult(
-              did: did,
-              response: 'error',
-              rawHex: e.toString(),
-            ));
-          }
 
-          // Emit progress
-          if (!_progressController.isClosed) {
-            _progressController.add(DidScanProgress(
-              current: current,
-              total: totalDids,
-              currentDid: did,
-              foundCount: foundCount,
-              negativeCount: negativeCount,
-              timeoutCount: timeoutCount,
-              errorCount: errorCount,
-              elapsed: stopwatch.elapsed,
-              lastResult: results.isNotEmpty ? results.last : null,
-            ));
+            // Emit progress
+            if (!_progressController.isClosed) {
+              _progressController.add(DidScanProgress(
+                current: current,
+                total: totalDids,
+                currentDid: did,
+                foundCount: foundCount,
+                negativeCount: negativeCount,
+                timeoutCount: timeoutCount,
+                errorCount: errorCount,
+                elapsed: stopwatch.elapsed,
+                lastResult: results.isNotEmpty ? results.last : null,
+              ));
+            }
           }
         }
       }
@@ -204,7 +232,7 @@ class DidScannerService {
 
     final summary = DidScanSummary(
       results: results,
-      totalScanned: results.length,
+      totalScanned: scannedCount ?? results.length,
       foundCount: foundCount,
       negativeCount: negativeCount,
       timeoutCount: timeoutCount,
@@ -228,9 +256,163 @@ class DidScannerService {
     if (_scanning) {
       _stopRequested = true;
       diag.info(_tag, 'Stop requested');
+      if (_nativeRunning) _bluetooth.stopDidScan();
     }
   }
 
+  /// Runs the scan on the adapter link, from the DID states saved for this
+  /// VIN, adding every DID found so far to [results]. Null when the link
+  /// has no native scan.
+  Future<_NativeScan?> _scanNatively(
+      List<(int, int)> ranges, List<DidScanResult> results) async {
+    final vin = _obdService.vin;
+    final saved = vin.isEmpty ? null : await _store.lookup(vin);
+    final found = <int, DidScanResult>{
+      for (final result in saved?.found ?? const <DidScanResult>[])
+        result.did: result,
+    };
+    Uint8List? bitmap = saved?.bitmap;
+
+    Future<void> save() async {
+      if (vin.isEmpty || bitmap == null) return;
+      await _store.save(DidScanState(
+        vin: vin,
+        bitmap: bitmap!,
+        found: found.values.toList(),
+        updatedAt: DateTime.now(),
+      ));
+    }
+
+    // Its last event never comes if the link drops or the adapter stops
+    // answering: a disconnect or [_stallTimeout] without an event ends the
+    // wait with an error instead
+    final finished = Completer<_NativeScan>();
+    var scan = const _NativeScan();
+    Timer? stall;
+    void fail(Object error) {
+      if (!finished.isCompleted) finished.completeError(error);
+    }
+
+    void watch() {
+      stall?.cancel();
+      stall = Timer(_stallTimeout,
+          () => fail(TimeoutException('No DID scan events', _stallTimeout)));
+    }
+
+    final connection = _bluetooth.stateStream.listen((state) {
+      if (state != BluetoothConnectionState.connected) {
+        fail(StateError('Adapter disconnected'));
+      }
+    });
+
+    // Listening before the start, so the first events are not missed
+    final subscription = _bluetooth.didScanEvents.listen((event) {
+      if (finished.isCompleted) return;
+      watch();
+      DidScanResult? last;
+      for (final answer in event.answers) {
+        final result = _answerResult(answer);
+        // Data from one ECU beats another's refusal
+        if (found[answer.did]?.response == 'ok' && result.response != 'ok') {
+          continue;
+        }
+        found[answer.did] = result;
+        last = result;
+        if (result.response == 'ok') {
+          diag.info(_tag, 'FOUND DID ${result.didHex}',
+              'ecu=${answer.ecu} ${answer.bytes.length}B: ${result.dataBytesHex}');
+        }
+      }
+      final unsettled =
+          event.probed - event.supported - event.refused - event.absent;
+      if (!_progressController.isClosed) {
+        _progressController.add(DidScanProgress(
+          current: event.probed,
+          total: event.total,
+          currentDid: event.lastDid,
+          foundCount: event.supported,
+          negativeCount: event.refused + event.absent,
+          timeoutCount: unsettled,
+          errorCount: 0,
+          elapsed: event.elapsed,
+          lastResult: last,
+        ));
+      }
+      scan = _NativeScan(
+        probed: event.probed,
+        supported: event.supported,
+        refused: event.refused,
+        absent: event.absent,
+        unsettled: unsettled,
+      );
+      if (!event.running) {
+        bitmap = event.bitmap ?? bitmap;
+        finished.complete(scan);
+      }
+    });
+
+    Timer? saver;
+    try {
+      final count = await _bluetooth.startDidScan(ranges, bitmap: bitmap);
+      if (count == null) return null;
+      _nativeRunning = true;
+      diag.info(_tag, 'Native scan',
+          '$count unknown DIDs, ${found.length} found before');
+
+      if (count > 0) {
+        // The stop may have come while it was starting
+        if (_stopRequested) await _bluetooth.stopDidScan();
+        saver = Timer.periodic(_saveInterval, (_) async {
+          bitmap = await _bluetooth.getDidScanBitmap() ?? bitmap;
+          await save();
+        });
+        watch();
+        try {
+          scan = await finished.future;
+        } catch (e) {
+          // Keep what the events brought; the saved states resume it
+          diag.error(_tag, 'Native scan aborted', e.toString());
+          _stopRequested = true;
+          if (_bluetooth.isConnected) await _bluetooth.stopDidScan();
+        }
+        if (scan.probed < count) _stopRequested = true;
+      }
+      await save();
+      results.addAll(found.values.toList()..sort((a, b) => a.did - b.did));
+      return scan;
+    } finally {
+      saver?.cancel();
+      stall?.cancel();
+      _nativeRunning = false;
+      await subscription.cancel();
+      await connection.cancel();
+    }
+  }
+
+  static DidScanResult _answerResult(AdapterDidAnswer answer) {
+    final didHex = answer.did.toRadixString(16).toUpperCase().padLeft(4, '0');
+    final bytes = answer.bytes
+        .map((b) => b.toRadixString(16).toUpperCase().padLeft(2, '0'))
+        .join();
+    if (answer.nrc != 0) {
+      final nrcHex = answer.nrc.toRadixString(16).toUpperCase().padLeft(2, '0');
+      return DidScanResult(
+        did: answer.did,
+        response: 'negative',
+        nrc: answer.nrc,
+        rawHex: '${answer.ecu} 7F22$nrcHex',
+        ecuAddress: answer.ecu,
+      );
+    }
+    return DidScanResult(
+      did: answer.did,
+      response: 'ok',
+      dataBytes: answer.bytes.toList(),
+      rawHex: '${answer.ecu} 62$didHex$bytes',
+      ecuAddress: answer.ecu,
+    );
+  }
+
   /// Restore adapter state after scan — resume health check and optionally
   /// restart OBD polling if it was running before.
   void _restoreAdapterState() {
@@ -327,3 +509,22 @@ class DidScannerService {
     _progressController.close();
   }
 }
+
+/// Counts of a native scan run.
+class _NativeScan {
+  final int probed;
+  final int supported;
+  final int refused;
+  final int absent;
+
+  /// Probed but never answered for certain; probed again by the next scan.
+  final int unsettled;
+
+  const _NativeScan({
+    this.probed = 0,
+    this.supported = 0,
+    this.refused = 0,
+    this.absent = 0,
+    this.unsettled = 0,
+  });
+}
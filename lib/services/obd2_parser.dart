@@ -242,4 +242,53 @@ class Obd2Parser {
     return null;
   }
 
+  static final _vinPattern = RegExp(r'^[A-HJ-NPR-Z0-9]{17}$');
+
+  /// Parses the VIN from a Mode $09 PID $02 response, read with headers off.
+  ///
+  /// Handles CAN multi-frame responses ("014" byte count followed by
+  /// "0:", "1:", ... segment lines) and legacy responses of one
+  /// "4902nn" + 4 data bytes line per message. Padding bytes (0x00) are
+  /// dropped. Returns null unless exactly 17 valid VIN characters remain.
+  static String? parseVin(String rawHex) {
+    final cleaned = rawHex
+        .replaceAll('\r', '\n')
+        .replaceAll('>', '')
+        .toUpperCase();
+    if (_isErrorResponse(cleaned.trim())) return null;
+
+    final lines = cleaned
+        .split('\n')
+        .map((l) => l.replaceAll(' ', '').trim())
+        .where((l) => l.isNotEmpty)
+        .toList();
+
+    final buffer = StringBuffer();
+    final segmented = lines.any((l) => RegExp(r'^[0-9A-F]:').hasMatch(l));
+    if (segmented) {
+      // The byte-count line has no colon and is skipped
+      for (final line in lines) {
+        final colon = line.indexOf(':');
+        if (colon > 0) buffer.write(line.substring(colon + 1));
+      }
+    } else {
+      for (final line in lines) {
+        if (line.startsWith('4902') && line.length > 6) {
+          buffer.write(line.substring(6));
+        }
+      }
+    }
+
+    var hex = buffer.toString();
+    if (segmented) {
+      final idx = hex.indexOf('490201');
+      if (idx < 0) return null;
+      hex = hex.substring(idx + 6);
+    }
+
+    final bytes = _hexStringToBytes(hex);
+    if (bytes == null) return null;
+    final vin = String.fromCharCodes(bytes.where((b) => b != 0x00));
+    return _vinPattern.hasMatch(vin) ? vin : null;
+  }
 }
@@ -3,6 +3,7 @@ import 'dart:async';
 import 'package:myapp/config/constants.dart';
 import 'package:myapp/config/pid_config.dart';
 import 'package:myapp/services/bluetooth_service.dart';
+import 'package:myapp/services/connection_profile_cache.dart';
 import 'package:myapp/services/diagnostic_service.dart';
 import 'package:myapp/services/obd2_parser.dart';
 
@@ -34,6 +35,11 @@ class PidStatus {
   DateTime? lastSuccess;
   /// Reason for last failure: 'no_response' | 'parse_fail' | 'negative_resp' | 'unsupported'
   String? failReason;
+  /// Native write-to-prompt latency percentiles of the last stats window.
+  Duration? latencyP50;
+  Duration? latencyP99;
+  /// Smoothed time spent parsing a response in Dart.
+  Duration? parseTime;
 
   PidStatus({
     required this.id,
@@ -49,8 +55,13 @@ class PidStatus {
 /// All polling tiers share a single sequential loop — no concurrent timers.
 class ObdService {
   final BluetoothService _bluetooth;
+  final ConnectionProfileCache _profileCache;
 
-  ObdService({required BluetoothService bluetooth}) : _bluetooth = bluetooth;
+  ObdService({
+    required BluetoothService bluetooth,
+    ConnectionProfileCache? profileCache,
+  })  : _bluetooth = bluetooth,
+        _profileCache = profileCache ?? ConnectionProfileCache();
 
   // ─── State ───
 
@@ -83,6 +94,12 @@ class ObdService {
   DateTime? _lowVoltageSince;
   double? _lastVoltageReading;
 
+  /// Values the adapter link picked per command from every ECU's answer
+  /// (battery voltage: the highest), refreshed before those PIDs are
+  /// parsed. Empty without native framing; Dart then parses the lines.
+  final Map<String, double> _ecuSelected = {};
+  bool _ecuSelection = false;
+
   /// Peak voltage observed while engine was running (alternator charging).
   /// Used for fast alternator-off detection: if peak was >13.5V and current
   /// drops below 13.0V, the alternator has stopped — engine is off.
@@ -107,15 +124,40 @@ class ObdService {
   final StreamController<EngineState> _engineStateController =
       StreamController<EngineState>.broadcast();
 
+  // ─── Native Poll Schedule ───
+
+  /// Results of the adapter link's native schedule, while one is set.
+  StreamSubscription<AdapterPollSample>? _pollSampleSubscription;
+
+  /// Scheduled command → PID, for routing samples.
+  Map<String, PidDefinition> _scheduledPids = {};
+
+  /// Identity of the schedule last handed to the adapter; null if none.
+  String? _nativeScheduleKey;
+
   /// Set of OBD2 PID codes this ECU supports (from 0100/0120/0140 queries).
   /// Null means we don't know — try everything.
   Set<int>? _supportedPids;
 
+  // ─── Connection Profile ───
+
+  /// VIN read during init; empty if the vehicle did not report one.
+  String _vin = '';
+
+  /// Smoothed request-to-response time per PID id, persisted with the
+  /// connection profile.
+  final Map<String, double> _pidLatencyMs = {};
+
+  /// Start of the connect-to-first-sample measurement; cleared once logged.
+  DateTime? _firstSampleClockStart;
+  bool _initFromProfile = false;
+
   // ─── Public getters ───
 
   ObdInitState get initState => _initState;
   ObdProtocol get protocol => _protocol;
   String? get lastError => _lastError;
+  String get vin => _vin;
   bool get isReady => _initState == ObdInitState.ready;
   bool get isPolling => _polling;
   bool get isConnected => _bluetooth.isConnected;
@@ -143,6 +185,10 @@ class ObdService {
     _bitmapRefreshedSinceRunning = false;
     _liveData.clear();
     _pidStatus.clear();
+    _pidLatencyMs.clear();
+    _vin = '';
+    _initFromProfile = false;
+    _firstSampleClockStart = _bluetooth.connectStartedAt ?? DateTime.now();
 
     // Reset engine state so the state machine can re-detect from scratch.
     // Without this, a stale EngineState.off from before disconnect gets
@@ -154,10 +200,29 @@ class ObdService {
     _alternatorOffSince = null;
     _accessoryTimeoutSince = null;
     _runningPeakVoltage = 0.0;
+    _ecuSelected.clear();
+    _ecuSelection = false;
 
     diag.info(_tag, 'Starting OBD initialization');
 
     try {
+      // Fast path: a profile for this adapter whose VIN still matches skips
+      // ATZ, protocol probing and the supported-PID queries
+      final address = _bluetooth.connectedAddress;
+      final profile = address == null
+          ? null
+          : await _profileCache.latestForAdapter(address);
+      if (profile != null && await _tryProfileInit(profile)) {
+        _initFromProfile = true;
+        await _setupEcuSelection();
+        _initState = ObdInitState.ready;
+        diag.info(_tag, 'OBD ready from cached profile',
+            'protocol=ATSP$_obd2AtspCode vin=$_vin '
+            'supportedPids=${_supportedPids?.length ?? "unknown"}');
+        _saveProfile();
+        return true;
+      }
+
       // Phase 1: Basic AT initialization
       // (NOT including ATSP/ATST — those are set during protocol detection)
       const initCmds = ['ATZ', 'ATE0', 'ATL0', 'ATS0', 'ATH1', 'ATAT1'];
@@ -195,6 +260,12 @@ class ObdService {
       _protocol = await _detectProtocol();
       diag.info(_tag, 'Protocol detected: ${_protocol.name}');
 
+      if (_protocol == ObdProtocol.obd2) {
+        _vin = await _readVin() ?? '';
+        _saveProfile();
+        await _setupEcuSelection();
+      }
+
       _initState = ObdInitState.ready;
       diag.info(_tag, 'OBD ready (protocol: ${_protocol.name})');
       return true;
@@ -206,6 +277,183 @@ class ObdService {
     }
   }
 
+  // ─── Connection Profile ───
+
+  /// Bring the adapter up from [profile]: a quick AT init without ATZ, the
+  /// cached protocol, then a VIN read and one 0100 to prove the vehicle is
+  /// the same and the protocol still answers. Returns false (leaving the
+  /// adapter for the full init to reset) on any mismatch. A profile without
+  /// a VIN proves nothing, so it is never used.
+  Future<bool> _tryProfileInit(ConnectionProfile profile) async {
+    if (profile.vin.isEmpty) {
+      diag.info(_tag, 'Cached profile rejected: no VIN');
+      return false;
+    }
+    diag.info(_tag, 'Trying cached profile',
+        'ATSP${profile.atspCode} vin=${profile.vin}');
+
+    // The cached protocol and timeout must take, like the rest
+    final quickInit = ['ATE0', 'ATL0', 'ATS0', 'ATH1', 'ATAT1',
+        'ATSP${profile.atspCode}', 'ATST32'];
+    for (final cmd in quickInit) {
+      final response = await _sendSafe(cmd);
+      if (response == null || !response.toUpperCase().contains('OK')) {
+        diag.info(_tag, 'Cached profile rejected: $cmd failed',
+            'response: ${_truncate(response)}');
+        return false;
+      }
+    }
+
+    final vin = await _readVin() ?? '';
+    if (vin != profile.vin) {
+      diag.info(_tag, 'Cached profile rejected: VIN changed',
+          '${profile.vin} → $vin');
+      return false;
+    }
+
+    final response =
+        await _sendSafe('0100', timeout: const Duration(seconds: 3));
+    final bytes = response == null
+        ? null
+        : Obd2Parser.parseResponse(response, expectedPid: 0x00, mode: 0x01);
+    if (bytes == null || bytes.length < 4) {
+      diag.info(_tag, 'Cached profile rejected: no 0100 on '
+          'ATSP${profile.atspCode}', 'raw: ${_truncate(response)}');
+      return false;
+    }
+
+    _vin = vin;
+    _obd2AtspCode = profile.atspCode;
+    _protocol = ObdProtocol.obd2;
+    // The fresh base bitmap wins over the cached one for 0x01-0x20; the
+    // cache only supplies the higher ranges
+    _parseSupportedPidBitmap(response!, 0x00);
+    if (profile.supportedPids != null) {
+      _supportedPids = {
+        ..._supportedPids ?? {},
+        ...profile.supportedPids!.where((pid) => pid > 0x20),
+      };
+    }
+    _pidLatencyMs.addAll(profile.pidLatencyMs);
+    return true;
+  }
+
+  /// Read the VIN (Mode 09 PID 02) with headers off. Null if the vehicle
+  /// does not report one.
+  Future<String?> _readVin() async {
+    await _sendSafe('ATH0');
+    final response =
+        await _sendSafe('0902', timeout: const Duration(seconds: 3));
+    await _sendSafe('ATH1');
+    final vin = response == null ? null : Obd2Parser.parseVin(response);
+    diag.debug(_tag, 'VIN read', vin ?? 'raw: ${_truncate(response)}');
+    return vin;
+  }
+
+  /// Persist what this session learned for the next connect.
+  Future<void> _saveProfile() async {
+    final address = _bluetooth.connectedAddress;
+    if (address == null || _protocol != ObdProtocol.obd2) return;
+    await _profileCache.save(ConnectionProfile(
+      adapterAddress: address,
+      vin: _vin,
+      rfcommChannel: _bluetooth.rfcommChannel,
+      atspCode: _obd2AtspCode,
+      supportedPids:
+          _supportedPids == null ? null : Set<int>.from(_supportedPids!),
+      pidLatencyMs: Map<String, double>.from(_pidLatencyMs),
+      updatedAt: DateTime.now(),
+    ));
+  }
+
+  /// Fold one successful response time into [pid]'s smoothed latency.
+  void _recordLatency(PidDefinition pid, Duration latency) {
+    final ms = latency.inMicroseconds / 1000.0;
+    final previous = _pidLatencyMs[pid.id];
+    _pidLatencyMs[pid.id] = previous == null ? ms : previous * 0.8 + ms * 0.2;
+  }
+
+  void _recordParseTime(PidDefinition pid, Duration elapsed) {
+    final status = _pidStatus[pid.id];
+    if (status == null) return;
+    final previous = status.parseTime;
+    status.parseTime = previous == null
+        ? elapsed
+        : Duration(
+            microseconds: (previous.inMicroseconds * 0.8 +
+                    elapsed.inMicroseconds * 0.2)
+                .round());
+  }
+
+  /// Copy the native latency percentiles of the last window into the PID
+  /// statuses, log the slowest commands and the link counters, and start a
+  /// new window.
+  Future<void> _logLinkStats() async {
+    try {
+      final stats = await _bluetooth.getLinkStats(reset: true);
+      if (stats == null) return;
+      final byCommand = {for (final c in stats.commands) c.command: c};
+      for (final status in _pidStatus.values) {
+        final latency = byCommand[status.command];
+        if (latency == null || latency.completed == 0) continue;
+        status.latencyP50 = latency.p50;
+        status.latencyP99 = latency.p99;
+      }
+      _statusController.add(Map.unmodifiable(_pidStatus));
+
+      final slowest = stats.commands.where((c) => c.completed > 0).toList()
+        ..sort((a, b) => b.p99.compareTo(a.p99));
+      final c = stats.counters;
+      diag.info(
+          _tag,
+          'Link latency',
+          'slowest=[${slowest.take(3).join(', ')}] '
+              'responses=${c['responses']} timeouts=${c['timeouts']} '
+              'rx=${c['bytesReceived']}B tx=${c['bytesSent']}B '
+              'overflows=${c['overflows']}');
+
+      // Requests the link sends with a learned responder count, so the
+      // adapter no longer waits out ATST after the last ECU
+      final counted = stats.responseCounts.where((r) => r.count > 0).toList();
+      if (counted.isNotEmpty) {
+        final saved = counted.fold<Duration>(
+            Duration.zero, (sum, r) => sum + r.totalSaved);
+        diag.info(
+            _tag,
+            'Response counts',
+            '${counted.length}/${stats.responseCounts.length} counted '
+                '[${counted.take(4).join(', ')}] '
+                'saved=${saved.inMilliseconds}ms since connect');
+      }
+
+      // Requests whose ATST the link lowered below the polling default
+      final tightened = stats.timeouts.where((t) => t.counts < 0x32).toList();
+      if (tightened.isNotEmpty || stats.atstChanges > 0) {
+        final backoffs =
+            stats.timeouts.fold<int>(0, (sum, t) => sum + t.backoffs);
+        diag.info(
+            _tag,
+            'Adaptive timeouts',
+            '${tightened.length}/${stats.timeouts.length} below ATST32 '
+                '[${tightened.take(4).join(', ')}] '
+                'changes=${stats.atstChanges} backoffs=$backoffs');
+      }
+    } catch (e) {
+      diag.warn(_tag, 'Link stats unavailable', '$e');
+    }
+  }
+
+  /// Log connect-to-first-sample once per initialize, tagged with the path
+  /// that brought the adapter up.
+  void _logFirstSample(PidDefinition pid) {
+    final start = _firstSampleClockStart;
+    if (start == null) return;
+    _firstSampleClockStart = null;
+    final ms = DateTime.now().difference(start).inMilliseconds;
+    diag.info(_tag, 'First sample ${ms}ms after connect',
+        'path=${_initFromProfile ? 'cached' : 'full'} pid=${pid.id}');
+  }
+
   // ─── Protocol Detection ───
 
   /// Tries explicit CAN protocols (fastest), then auto-detect.
@@ -460,6 +708,7 @@ class ObdService {
     }
 
     _bitmapRefreshedSinceRunning = true;
+    _saveProfile();
   }
 
   // ─── Polling ───
@@ -494,6 +743,7 @@ class ObdService {
   }
 
   void stopPolling() {
+    if (_polling) _saveProfile();
     _polling = false;
     // Clear stale values so the dashboard shows blanks instead of frozen data.
     _liveData.clear();
@@ -505,6 +755,7 @@ class ObdService {
     _rpmZeroSince = null;
     _lowVoltageSince = null;
     _lastVoltageReading = null;
+    _ecuSelected.clear();
     _runningPeakVoltage = 0.0;
     _alternatorOffSince = null;
     _accessoryTimeoutSince = null;
@@ -524,15 +775,24 @@ class ObdService {
   /// In accessory mode (engine off, key on), only RPM + voltage are polled
   /// at a slower interval to conserve battery while still detecting engine start.
   ///
-  /// Each PID is polled one-at-a-time. No concurrent commands ever.
+  /// Each PID is polled one-at-a-time. No concurrent commands ever; the
+  /// tick's PIDs go out as one native batch where the link supports it.
+  ///
+  /// Where the link has a native scheduler, the tiers are handed to it as
+  /// target periods instead (see [_syncNativeSchedule]) and this loop only
+  /// keeps the schedule in step with the active PID set and publishes
+  /// snapshots, so fast-tier rates no longer depend on how many slow PIDs
+  /// are active.
   Future<void> _runPollLoop() async {
     int tick = 0;
+    var native = await _startNativePolling();
 
     while (_polling && !_disposed && _bluetooth.isConnected) {
       // In accessory mode, only poll RPM + voltage at a slower rate.
       // This keeps the connection alive for engine-start detection
       // while minimizing adapter activity (letting BatterySaver timer tick).
       if (_engineState == EngineState.accessory) {
+        if (native) await _clearNativeSchedule();
         await _pollAccessoryMode();
 
         // Update engine state — may transition back to running or to off
@@ -575,20 +835,39 @@ class ObdService {
       // Periodic polling summary every 50 ticks (~25 seconds)
       if (tick > 0 && tick % 50 == 0) {
         _logPollingSummary(tick);
+        await _logLinkStats();
       }
 
-      // Build PID list for this tick based on tier rotation
-      final pids = <PidDefinition>[];
+      if (native) {
+        if (tick > 0 && tick % 50 == 0) await _logPollRates();
 
-      pids.addAll(_getActivePids(PollTier.fast));
-      if (tick % 2 == 0) pids.addAll(_getActivePids(PollTier.medium));
-      if (tick % 4 == 0) pids.addAll(_getActivePids(PollTier.slow));
-      if (tick % 10 == 0) pids.addAll(_getActivePids(PollTier.background));
+        // The adapter link samples on its own; wait one fast period and
+        // publish whatever arrived
+        native = await _syncNativeSchedule();
+        if (native) {
+          await Future<void>.delayed(
+              const Duration(milliseconds: AppConstants.pollFast));
+          if (!_polling || _disposed) break;
+        } else {
+          diag.warn(_tag, 'Native poll schedule rejected — tick polling');
+          await _stopNativePolling();
+        }
+      }
+
+      if (!native) {
+        // Build PID list for this tick based on tier rotation
+        final pids = <PidDefinition>[];
 
-      // Poll each OBD2/Mode22 PID sequentially — one at a time
-      for (final pid in pids) {
+        pids.addAll(_getActivePids(PollTier.fast));
+        if (tick % 2 == 0) pids.addAll(_getActivePids(PollTier.medium));
+        if (tick % 4 == 0) pids.addAll(_getActivePids(PollTier.slow));
+        if (tick % 10 == 0) pids.addAll(_getActivePids(PollTier.background));
+
+        // Poll the tick's OBD2/Mode22 PIDs as one batch — still one command
+        // on the wire at a time, but without a round trip to Dart between
+        // them
         if (!_polling || _disposed) return;
-        await requestPid(pid);
+        await requestPids(pids);
       }
 
       // Emit aggregated snapshots after each cycle
@@ -615,17 +894,161 @@ class ObdService {
       tick++;
 
       // Brief pause between cycles
-      if (_polling && !_disposed) {
+      if (!native && _polling && !_disposed) {
         await Future<void>.delayed(const Duration(milliseconds: 50));
       }
     }
 
     // Cleanup when loop exits
+    await _stopNativePolling();
     if (!_disposed) {
       _bluetooth.resumeHealthCheck();
     }
   }
 
+  /// Target sample period of each tier on the native schedule.
+  static Duration _tierPeriod(PollTier tier) {
+    switch (tier) {
+      case PollTier.fast:
+        return const Duration(milliseconds: AppConstants.pollFast);
+      case PollTier.medium:
+        return const Duration(milliseconds: AppConstants.pollMedium);
+      case PollTier.slow:
+        return const Duration(milliseconds: AppConstants.pollSlow);
+      case PollTier.background:
+        return const Duration(milliseconds: AppConstants.pollBackground);
+    }
+  }
+
+  /// Try to hand polling to the adapter link. Returns false (leaving
+  /// nothing behind) when the link has no native scheduler.
+  Future<bool> _startNativePolling() async {
+    _pollSampleSubscription ??= _bluetooth.pollSamples.listen(
+      _onPollSample,
+      onError: (Object error) {
+        diag.error(_tag, 'Poll sample stream error', '$error');
+      },
+    );
+    _nativeScheduleKey = null;
+    if (await _syncNativeSchedule()) return true;
+    await _pollSampleSubscription?.cancel();
+    _pollSampleSubscription = null;
+    return false;
+  }
+
+  Future<void> _stopNativePolling() async {
+    if (_nativeScheduleKey != null && _bluetooth.isConnected) {
+      await _bluetooth.setPollSchedule(const {});
+    }
+    _nativeScheduleKey = null;
+    await _pollSampleSubscription?.cancel();
+    _pollSampleSubscription = null;
+  }
+
+  /// Stop native sampling but keep listening, e.g. in accessory mode.
+  Future<void> _clearNativeSchedule() async {
+    if (_nativeScheduleKey == null || _nativeScheduleKey!.isEmpty) return;
+    if (await _bluetooth.setPollSchedule(const {})) _nativeScheduleKey = '';
+  }
+
+  /// Hand the active PIDs to the adapter link as per-tier target periods.
+  /// Only talks to the adapter when the active set changed (PIDs disabled
+  /// by failures, failure reset, bitmap refresh).
+  ///
+  /// Mode 01 PIDs of a tier are packed into multi-PID requests natively
+  /// (up to six per round trip); samples still arrive per PID command, and
+  /// a PID the ECU does not return in a packed reply reports NO DATA like
+  /// a single request would. The active set is already filtered by the
+  /// supported-PID bitmap, so packed requests only ask for PIDs the ECU
+  /// advertises.
+  Future<bool> _syncNativeSchedule() async {
+    final periods = <String, Duration>{};
+    final pids = <String, PidDefinition>{};
+    for (final tier in PollTier.values) {
+      for (final pid in _getActivePids(tier)) {
+        final command = _prepareRequest(pid);
+        if (command == null) continue;
+        pids[command] = pid;
+        periods[command] = _tierPeriod(tier);
+      }
+    }
+
+    final key = (periods.entries
+            .map((e) => '${e.key}@${e.value.inMilliseconds}')
+            .toList()
+          ..sort())
+        .join(',');
+    if (key == _nativeScheduleKey) return true;
+
+    _scheduledPids = pids;
+    if (!await _bluetooth.setPollSchedule(periods, packMode01: true)) {
+      return false;
+    }
+    _nativeScheduleKey = key;
+    diag.info(_tag, 'Native poll schedule set', '${periods.length} commands');
+    return true;
+  }
+
+  Future<void> _onPollSample(AdapterPollSample sample) async {
+    if (_disposed || !_polling) return;
+    final pid = _scheduledPids[sample.command];
+    if (pid == null) return;
+    if (pid.id == 'batteryVoltage') {
+      await _refreshEcuValues();
+      if (_disposed || !_polling) return;
+    }
+    try {
+      _handlePidResponse(pid, sample.command, sample.lines?.join('\n'),
+          latency: sample.elapsed);
+    } catch (e) {
+      _consecutiveFailures[pid.id] = (_consecutiveFailures[pid.id] ?? 0) + 1;
+      diag.error(_pidTag, '✗ ${pid.id} exception', '$e');
+    }
+  }
+
+  /// Log achieved vs. target rates of the fast tier and start a new
+  /// measurement window.
+  Future<void> _logPollRates() async {
+    try {
+      final rates = await _bluetooth.getPollStats(reset: true);
+      final fastHz = 1000 / AppConstants.pollFast;
+      final fast = rates.where((r) => r.targetHz >= fastHz).join(', ');
+      final misses = rates.fold<int>(0, (sum, r) => sum + r.deadlineMisses);
+      diag.info(_tag, 'Native poll rates', 'fast=[$fast] deadlineMisses=$misses');
+    } catch (e) {
+      diag.warn(_tag, 'Poll stats unavailable', '$e');
+    }
+  }
+
+  /// Have the link keep every ECU's answer natively once discovery has
+  /// heard them: battery voltage takes the highest ECU's (the one reading
+  /// closest to the alternator), and requests only the engine answers are
+  /// sent to it alone, so the TCM and body modules stop answering 7F to
+  /// each poll.
+  Future<void> _setupEcuSelection() async {
+    final battery = PidRegistry.get('batteryVoltage');
+    final command = battery == null ? null : _formatCommand(battery);
+    if (command == null) return;
+    _ecuSelection = await _bluetooth.setEcuPolicy(command, 'max');
+    if (!_ecuSelection) return;
+    await _bluetooth.setEcuRouting(true);
+    diag.info(_tag, 'Native ECU selection on', '$command=max routing=on');
+  }
+
+  /// Fetch the link's picked values for the next [_parseResponse] calls.
+  Future<void> _refreshEcuValues() async {
+    if (!_ecuSelection) return;
+    try {
+      final values = await _bluetooth.readEcuValues();
+      _ecuSelected.clear();
+      for (final v in values ?? const <EcuValue>[]) {
+        if (v.value != null) _ecuSelected[v.command] = v.value!;
+      }
+    } catch (e) {
+      diag.warn(_tag, 'ECU values unavailable', '$e');
+    }
+  }
+
   /// Reduced polling for accessory mode — voltage only (no CAN traffic).
   ///
   /// Uses AT RV (adapter pin 16 voltage) which reads the OBD port voltage
@@ -832,88 +1255,154 @@ class ObdService {
     if (!isReady) return null;
 
     try {
-      final command = _formatCommand(pid);
-      if (command == null) {
-        diag.warn(_pidTag, 'No command for ${pid.id}',
-            'protocol=${pid.protocol.name}');
-        _updatePidStatusFailure(pid, 'null', 'unsupported', null);
-        return null;
-      }
+      final command = _prepareRequest(pid);
+      if (command == null) return null;
+      final stopwatch = Stopwatch()..start();
+      final response = await _sendSafe(command);
+      return _handlePidResponse(pid, command, response,
+          latency: stopwatch.elapsed);
+    } catch (e) {
+      _consecutiveFailures[pid.id] =
+          (_consecutiveFailures[pid.id] ?? 0) + 1;
+      diag.error(_pidTag, '✗ ${pid.id} exception', '$e');
+      return null;
+    }
+  }
 
-      // Ensure PidStatus entry exists
-      _pidStatus.putIfAbsent(
-        pid.id,
-        () => PidStatus(
-          id: pid.id,
-          name: pid.name,
-          command: command,
-          protocol: pid.protocol,
-        ),
-      );
+  /// Poll [pids] as one native batch: the adapter link writes each next
+  /// command as soon as the previous prompt arrives, instead of waiting for
+  /// a platform channel round trip per PID. Falls back to [requestPid] one
+  /// at a time where batches are unsupported.
+  Future<void> requestPids(List<PidDefinition> pids) async {
+    if (!isReady || pids.isEmpty) return;
+
+    final batch = <PidDefinition>[];
+    final commands = <String>[];
+    for (final pid in pids) {
+      final command = _prepareRequest(pid);
+      if (command == null) continue;
+      batch.add(pid);
+      commands.add(command);
+    }
+    if (commands.isEmpty) return;
 
-      final response = await _sendSafe(command);
-      if (response == null) {
-        final fails = (_consecutiveFailures[pid.id] ?? 0) + 1;
-        _consecutiveFailures[pid.id] = fails;
-        _updatePidStatusFailure(pid, command, 'no_response', null);
-        if (fails == _maxConsecutiveFailures) {
-          _liveData.remove(pid.id);
-          diag.warn(_pidTag, '✗ ${pid.id} disabled — stale value evicted',
-              'cmd=$command reason=no_response fails=$fails');
-        } else if (fails == 1) {
-          diag.warn(_pidTag, '✗ ${pid.id} no_response',
-              'cmd=$command');
-        }
-        return null;
+    final responses = await _sendBatchSafe(commands);
+    if (responses == null) {
+      for (final pid in batch) {
+        if (!_polling || _disposed) return;
+        await requestPid(pid);
       }
+      return;
+    }
+    if (batch.any((pid) => pid.id == 'batteryVoltage')) {
+      await _refreshEcuValues();
+    }
 
-      final rawTruncated = _truncate(response, 80);
-
-      // Try parsing first — the parser handles multi-ECU responses correctly
-      // by scanning each line for the expected response header (41xx/62xxxx).
-      // On multi-ECU CAN buses (e.g. 2026 Ram with engine + TCM), one ECU
-      // may return valid data while another returns 7F (negative response).
-      // The old code checked for '7F' first and rejected the entire response,
-      // throwing away valid data from the correct ECU.
-      final value = _parseResponse(pid, response);
-
-      if (value != null) {
-        _liveData[pid.id] = value;
-        final wasFirstSuccess = (_pidStatus[pid.id]?.successCount ?? 0) == 0;
-        _updatePidStatusSuccess(pid, command, value, rawTruncated);
-        _consecutiveFailures[pid.id] = 0;
-
-        if (wasFirstSuccess) {
-          diag.info(_pidTag,
-              '✓ ${pid.id} first success = ${value.toStringAsFixed(2)} ${pid.unit}',
-              'cmd=$command raw=$rawTruncated');
-        }
-      } else {
-        // Parse failed — determine why for accurate failure tracking
-        final upper = response.toUpperCase().replaceAll(' ', '');
-        final isNegativeOnly = _isNegativeResponseOnly(upper);
-        final failReason = isNegativeOnly ? 'negative_resp' : 'parse_fail';
-
-        final fails = (_consecutiveFailures[pid.id] ?? 0) + 1;
-        _consecutiveFailures[pid.id] = fails;
-        _updatePidStatusFailure(pid, command, failReason, rawTruncated);
-        if (fails == _maxConsecutiveFailures) {
-          _liveData.remove(pid.id);
-          diag.warn(_pidTag, '✗ ${pid.id} disabled — stale value evicted',
-              'cmd=$command reason=$failReason fails=$fails');
-        } else if (fails == 1) {
-          diag.warn(_pidTag, '✗ ${pid.id} $failReason',
-              'cmd=$command raw=$rawTruncated');
-        }
+    for (var i = 0; i < batch.length; i++) {
+      final pid = batch[i];
+      try {
+        _handlePidResponse(pid, commands[i], responses[i]);
+      } catch (e) {
+        _consecutiveFailures[pid.id] =
+            (_consecutiveFailures[pid.id] ?? 0) + 1;
+        diag.error(_pidTag, '✗ ${pid.id} exception', '$e');
       }
+    }
+  }
 
-      return value;
-    } catch (e) {
-      _consecutiveFailures[pid.id] =
-          (_consecutiveFailures[pid.id] ?? 0) + 1;
-      diag.error(_pidTag, '✗ ${pid.id} exception', '$e');
+  /// Format [pid]'s command and make sure it has a status entry. Returns
+  /// null (recording the failure) when the PID has no command.
+  String? _prepareRequest(PidDefinition pid) {
+    final command = _formatCommand(pid);
+    if (command == null) {
+      diag.warn(_pidTag, 'No command for ${pid.id}',
+          'protocol=${pid.protocol.name}');
+      _updatePidStatusFailure(pid, 'null', 'unsupported', null);
       return null;
     }
+
+    // Ensure PidStatus entry exists
+    _pidStatus.putIfAbsent(
+      pid.id,
+      () => PidStatus(
+        id: pid.id,
+        name: pid.name,
+        command: command,
+        protocol: pid.protocol,
+      ),
+    );
+    return command;
+  }
+
+  /// Parse [response] to [command] and update live data, status, the
+  /// failure counter and (given [latency]) the PID's smoothed latency. A
+  /// null [response] counts as no response.
+  double? _handlePidResponse(
+    PidDefinition pid,
+    String command,
+    String? response, {
+    Duration? latency,
+  }) {
+    if (response == null) {
+      final fails = (_consecutiveFailures[pid.id] ?? 0) + 1;
+      _consecutiveFailures[pid.id] = fails;
+      _updatePidStatusFailure(pid, command, 'no_response', null);
+      if (fails == _maxConsecutiveFailures) {
+        _liveData.remove(pid.id);
+        diag.warn(_pidTag, '✗ ${pid.id} disabled — stale value evicted',
+            'cmd=$command reason=no_response fails=$fails');
+      } else if (fails == 1) {
+        diag.warn(_pidTag, '✗ ${pid.id} no_response',
+            'cmd=$command');
+      }
+      return null;
+    }
+
+    final rawTruncated = _truncate(response, 80);
+
+    // Try parsing first — the parser handles multi-ECU responses correctly
+    // by scanning each line for the expected response header (41xx/62xxxx).
+    // On multi-ECU CAN buses (e.g. 2026 Ram with engine + TCM), one ECU
+    // may return valid data while another returns 7F (negative response).
+    // The old code checked for '7F' first and rejected the entire response,
+    // throwing away valid data from the correct ECU.
+    final parseWatch = Stopwatch()..start();
+    final value = _parseResponse(pid, response);
+    _recordParseTime(pid, parseWatch.elapsed);
+
+    if (value != null) {
+      _liveData[pid.id] = value;
+      final wasFirstSuccess = (_pidStatus[pid.id]?.successCount ?? 0) == 0;
+      _updatePidStatusSuccess(pid, command, value, rawTruncated);
+      _consecutiveFailures[pid.id] = 0;
+      if (latency != null) _recordLatency(pid, latency);
+      _logFirstSample(pid);
+
+      if (wasFirstSuccess) {
+        diag.info(_pidTag,
+            '✓ ${pid.id} first success = ${value.toStringAsFixed(2)} ${pid.unit}',
+            'cmd=$command raw=$rawTruncated');
+      }
+    } else {
+      // Parse failed — determine why for accurate failure tracking
+      final upper = response.toUpperCase().replaceAll(' ', '');
+      final isNegativeOnly = _isNegativeResponseOnly(upper);
+      final failReason = isNegativeOnly ? 'negative_resp' : 'parse_fail';
+
+      final fails = (_consecutiveFailures[pid.id] ?? 0) + 1;
+      _consecutiveFailures[pid.id] = fails;
+      _updatePidStatusFailure(pid, command, failReason, rawTruncated);
+      if (fails == _maxConsecutiveFailures) {
+        _liveData.remove(pid.id);
+        diag.warn(_pidTag, '✗ ${pid.id} disabled — stale value evicted',
+            'cmd=$command reason=$failReason fails=$fails');
+      } else if (fails == 1) {
+        diag.warn(_pidTag, '✗ ${pid.id} $failReason',
+            'cmd=$command raw=$rawTruncated');
+      }
+    }
+
+    return value;
   }
 
   void _updatePidStatusSuccess(
@@ -996,10 +1485,16 @@ class ObdService {
 
   double? _parseResponse(PidDefinition pid, String response) {
     try {
-      // Special handling for battery voltage: multi-ECU responses may return
-      // different values. Pick the highest (most accurate from charging ECU).
-      // Also compare with AT RV reading and use whichever is higher.
+      // Battery voltage: every ECU reports its own. The link picks the
+      // highest (the charging ECU's) by its max policy; parsing the lines
+      // here is the fallback without native framing. Either way the AT RV
+      // reading wins if it is higher.
       if (pid.id == 'batteryVoltage') {
+        final selected = _ecuSelected.remove(_formatCommand(pid));
+        if (selected != null) {
+          if (selected <= 0 || selected >= 20) return null;
+          return _withAdapterVoltage(selected);
+        }
         return _parseBatteryVoltage(pid, response);
       }
 
@@ -1036,8 +1531,8 @@ class ObdService {
     }
   }
 
-  /// Battery voltage needs special multi-ECU handling: parse each ECU line
-  /// independently and pick the highest value. Also compare with AT RV.
+  /// Battery voltage from the lines when the link does not pick it: parse
+  /// each ECU line independently and take the highest value.
   double? _parseBatteryVoltage(PidDefinition pid, String response) {
     final lines = response.split(RegExp(r'[\r\n]+'))
         .where((l) => l.trim().isNotEmpty)
@@ -1060,14 +1555,13 @@ class ObdService {
       }
     }
 
-    // Compare with AT RV reading (stored in _lastVoltageReading)
-    if (bestValue != null && _lastVoltageReading != null) {
-      if (_lastVoltageReading! > bestValue) {
-        bestValue = _lastVoltageReading;
-      }
-    }
+    return bestValue == null ? null : _withAdapterVoltage(bestValue);
+  }
 
-    return bestValue;
+  /// [voltage] or the AT RV reading, whichever is higher.
+  double _withAdapterVoltage(double voltage) {
+    final adapter = _lastVoltageReading;
+    return adapter != null && adapter > voltage ? adapter : voltage;
   }
 
   double? _parseResponseRaw(PidDefinition pid, String response) {
@@ -1130,6 +1624,23 @@ class ObdService {
     }
   }
 
+  /// Send a batch of commands. Returns null if the link has no batch
+  /// support or the batch could not run; entries are null for commands
+  /// that got no response.
+  Future<List<String?>?> _sendBatchSafe(List<String> commands) async {
+    if (_disposed || !_bluetooth.isConnected) return null;
+
+    try {
+      return await _bluetooth.sendCommands(commands);
+    } on StateError catch (e) {
+      diag.error(_tag, 'Batch state error', '$e');
+      return null;
+    } catch (e) {
+      diag.error(_tag, 'Batch exception', '$e');
+      return null;
+    }
+  }
+
   // ─── Private: Polling Summary ───
 
   /// Log a periodic summary of polling health — which PIDs are working,
@@ -143,6 +143,9 @@ class FlutterBluetoothClassicPlugin: FlutterPlugin, MethodCallHandler, ActivityA
       "getDiscoveredDevices" -> {
         result.success(ArrayList(discoveredDevices))
       }
+      "isDiscovering" -> {
+        result.success(bluetoothAdapter?.isDiscovering ?: false)
+      }
       "startDiscovery" -> {
         if (bluetoothAdapter == null) {
           result.error("BLUETOOTH_UNAVAILABLE", "Bluetooth is not available on this device", null)
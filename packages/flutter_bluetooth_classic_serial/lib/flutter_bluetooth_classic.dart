@@ -1,5 +1,6 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:typed_data';
 import 'package:flutter/services.dart';
 
 class FlutterBluetoothClassic {
@@ -11,6 +12,12 @@ class FlutterBluetoothClassic {
       'com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_connection');
   static const EventChannel _dataChannel = EventChannel(
       'com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_data');
+  static const EventChannel _responseChannel = EventChannel(
+      'com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_response');
+  static const EventChannel _pollChannel = EventChannel(
+      'com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_poll');
+  static const EventChannel _didScanChannel = EventChannel(
+      'com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_did_scan');
 
   // Singleton instance
   static FlutterBluetoothClassic? _instance;
@@ -31,6 +38,27 @@ class FlutterBluetoothClassic {
   Stream<BluetoothDevice> get onDeviceDiscovered =>
       _deviceDiscoveryStreamController.stream;
 
+  /// Framed adapter responses, one per ELM327 '>' prompt. Only emits after
+  /// [setResponseFraming] returned true; listen to it only in that case.
+  late final Stream<BluetoothResponse> onResponseReceived = _responseChannel
+      .receiveBroadcastStream()
+      .map((dynamic event) => BluetoothResponse.fromMap(
+          Map<String, dynamic>.from(event as Map)));
+
+  /// Results of the native poll schedule, one per completed command (see
+  /// [setPollSchedule]).
+  late final Stream<BluetoothPollSample> onPollSample = _pollChannel
+      .receiveBroadcastStream()
+      .map((dynamic event) => BluetoothPollSample.fromMap(
+          Map<String, dynamic>.from(event as Map)));
+
+  /// Progress of the native DID scan, one event per chunk of requests
+  /// answered (see [startDidScan]).
+  late final Stream<BluetoothDidScanProgress> onDidScanProgress =
+      _didScanChannel.receiveBroadcastStream().map((dynamic event) =>
+          BluetoothDidScanProgress.fromMap(
+              Map<String, dynamic>.from(event as Map)));
+
   /// Factory constructor to maintain a single instance of the class
   factory FlutterBluetoothClassic() {
     _instance ??= FlutterBluetoothClassic._();
@@ -120,7 +148,8 @@ class FlutterBluetoothClassic {
     }
   }
 
-  /// Start discovery for nearby Bluetooth devices
+  /// Start discovery for nearby Bluetooth devices. Devices are delivered
+  /// on [onDeviceDiscovered] as they are found.
   Future<bool> startDiscovery() async {
     try {
       return await _channel.invokeMethod('startDiscovery');
@@ -138,15 +167,43 @@ class FlutterBluetoothClassic {
     }
   }
 
+  /// Whether a discovery session is running
+  Future<bool> isDiscovering() async {
+    try {
+      return await _channel.invokeMethod('isDiscovering');
+    } catch (e) {
+      throw BluetoothException('Failed to check discovery state: $e');
+    }
+  }
+
   /// Connect to a device
-  Future<bool> connect(String address) async {
+  ///
+  /// [channel] is the RFCOMM channel that worked last time; where supported
+  /// it is tried before the service lookup and channel probing.
+  Future<bool> connect(String address, {int? channel}) async {
     try {
-      return await _channel.invokeMethod('connect', {'address': address});
+      return await _channel.invokeMethod('connect', {
+        'address': address,
+        if (channel != null) 'channel': channel,
+      });
     } catch (e) {
       throw BluetoothException('Failed to connect to device: $e');
     }
   }
 
+  /// RFCOMM channel the connection to [address] came up on, or null if
+  /// unknown or unsupported on this platform.
+  Future<int?> getConnectedChannel(String address) async {
+    try {
+      return await _channel
+          .invokeMethod<int>('getConnectedChannel', {'address': address});
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to get connected channel: $e');
+    }
+  }
+
   /// Disconnect from a device
   Future<bool> disconnect() async {
     try {
@@ -156,10 +213,12 @@ class FlutterBluetoothClassic {
     }
   }
 
-  /// Send data to the connected device
+  /// Send data to the connected device. Bytes go over the channel as a
+  /// Uint8List so the platform side can write them without unboxing.
   Future<bool> sendData(List<int> data) async {
     try {
-      return await _channel.invokeMethod('sendData', {'data': data});
+      final Uint8List bytes = data is Uint8List ? data : Uint8List.fromList(data);
+      return await _channel.invokeMethod('sendData', {'data': bytes});
     } catch (e) {
       throw BluetoothException('Failed to send data: $e');
     }
@@ -168,13 +227,384 @@ class FlutterBluetoothClassic {
   /// Send string data to the connected device
   Future<bool> sendString(String message) async {
     try {
-      final List<int> data = List<int>.from(utf8.encode(message));
-      return await sendData(data);
+      return await sendData(utf8.encode(message));
     } catch (e) {
       throw BluetoothException('Failed to send string: $e');
     }
   }
 
+  /// Run [commands] back to back on the adapter link and return one result
+  /// per command, in order.
+  ///
+  /// Each next command is written natively as soon as the previous '>'
+  /// prompt arrives, so a batch costs one platform channel round trip
+  /// instead of one per command. Responses to the batch are not emitted on
+  /// [onResponseReceived] or [onDataReceived]. [timeout] applies to each
+  /// command. Returns null where the platform has no command pipeline.
+  Future<List<BluetoothCommandResult>?> sendCommands(
+    List<String> commands, {
+    String? address,
+    Duration timeout = const Duration(seconds: 1),
+  }) async {
+    try {
+      final List<dynamic>? results =
+          await _channel.invokeMethod('sendCommands', {
+        'commands': commands,
+        'timeoutMs': timeout.inMilliseconds,
+        if (address != null) 'address': address,
+      });
+      return results
+          ?.map((result) => BluetoothCommandResult.fromMap(
+              Map<String, dynamic>.from(result as Map)))
+          .toList();
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to send commands: $e');
+    }
+  }
+
+  /// Poll [entries] natively on the adapter link, each at its target period.
+  ///
+  /// Commands are scheduled earliest-deadline-first with one command on the
+  /// wire at a time; [sendCommands] batches run between two samples.
+  /// Results arrive on [onPollSample] instead of [onResponseReceived]. An
+  /// empty list stops polling. Returns false where the platform has no
+  /// native scheduler.
+  ///
+  /// With [packMode01], single-PID Mode 01 entries (`010C`) of equal period
+  /// are sent as multi-PID requests of up to six PIDs (`010C0D05`), and each
+  /// reply is split back into one [BluetoothPollSample] per scheduled
+  /// command, with a `41xx..` line per answering ECU. PIDs of a request the
+  /// ECU rejects are polled one per request from then on.
+  Future<bool> setPollSchedule(
+    List<BluetoothPollEntry> entries, {
+    String? address,
+    bool packMode01 = false,
+  }) async {
+    try {
+      return await _channel.invokeMethod('setPollSchedule', {
+            'entries': entries.map((e) => e.toMap()).toList(),
+            if (address != null) 'address': address,
+            if (packMode01) 'packMode01': true,
+          }) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to set poll schedule: $e');
+    }
+  }
+
+  /// Achieved vs. target rate of each scheduled command, optionally
+  /// starting a new measurement window with [reset].
+  Future<List<BluetoothPollStats>> getPollStats({
+    String? address,
+    bool reset = false,
+  }) async {
+    try {
+      final List<dynamic>? stats = await _channel.invokeMethod('getPollStats', {
+        'reset': reset,
+        if (address != null) 'address': address,
+      });
+      return (stats ?? const [])
+          .map((s) =>
+              BluetoothPollStats.fromMap(Map<String, dynamic>.from(s as Map)))
+          .toList();
+    } on MissingPluginException {
+      return const [];
+    } catch (e) {
+      throw BluetoothException('Failed to get poll stats: $e');
+    }
+  }
+
+  /// Native latency histograms and link counters of the adapter link: per
+  /// command, the time from write to first byte, first byte to prompt,
+  /// write to prompt and prompt to the platform thread, plus byte, response,
+  /// timeout and overflow counts since the last [resetStats]. Returns null
+  /// where the platform keeps no stats. Supported on Windows.
+  Future<BluetoothLinkStats?> getStats({String? address}) async {
+    try {
+      final Map<dynamic, dynamic>? stats = await _channel.invokeMethod(
+          'getStats', {if (address != null) 'address': address});
+      if (stats == null || stats.isEmpty) return null;
+      return BluetoothLinkStats.fromMap(stats);
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to get stats: $e');
+    }
+  }
+
+  /// Clears the histograms and counters [getStats] reports, starting a new
+  /// measurement window.
+  Future<bool> resetStats({String? address}) async {
+    try {
+      return await _channel.invokeMethod<bool>(
+              'resetStats', {if (address != null) 'address': address}) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to reset stats: $e');
+    }
+  }
+
+  /// Put the adapter in passive CAN monitor mode (ATMA, or STMA with [stn]
+  /// on OBDLink adapters) and decode the J1939 broadcasts of [pgns] (every
+  /// PGN the native SPN table knows if empty) as they arrive. The adapter
+  /// is filtered to those PGNs first; with ISO-TP formatting off it prints
+  /// every frame raw.
+  ///
+  /// Nothing else can be sent while monitoring: the call fails while
+  /// [sendCommands] batches or a poll schedule run, and the first byte
+  /// written ends it. Read the latest values with [getJ1939Values]; end it
+  /// with [stopJ1939Monitor]. Returns false where the platform has no
+  /// native monitor. Supported on Windows.
+  Future<bool> startJ1939Monitor({
+    String? address,
+    List<int> pgns = const [],
+    bool stn = false,
+  }) async {
+    try {
+      return await _channel.invokeMethod<bool>('startJ1939Monitor', {
+            'pgns': pgns,
+            'stn': stn,
+            if (address != null) 'address': address,
+          }) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to start J1939 monitor: $e');
+    }
+  }
+
+  /// Ends monitor mode. The adapter's filters and ISO-TP formatting are
+  /// restored before any later command runs.
+  Future<bool> stopJ1939Monitor({String? address}) async {
+    try {
+      return await _channel.invokeMethod<bool>(
+              'stopJ1939Monitor', {if (address != null) 'address': address}) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to stop J1939 monitor: $e');
+    }
+  }
+
+  /// Latest decoded value of every SPN seen since [startJ1939Monitor], the
+  /// latest DM1 of every ECU, and the monitor's frame counters. Returns null where the platform has no
+  /// native monitor.
+  Future<BluetoothJ1939Values?> getJ1939Values({String? address}) async {
+    try {
+      final Map<dynamic, dynamic>? values = await _channel.invokeMethod(
+          'getJ1939Values', {if (address != null) 'address': address});
+      if (values == null || values.isEmpty) return null;
+      return BluetoothJ1939Values.fromMap(values);
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to get J1939 values: $e');
+    }
+  }
+
+  /// Set how one value is picked per OBD request when several ECUs answer
+  /// it: `preferred` (the [BluetoothEcuPolicy.preferred] ECU, else the one
+  /// owning the request), `max` or `consensus` (the median). [policies]
+  /// name single-PID requests ("0142"). Needs headers on (ATH1). Returns
+  /// false where the platform keeps no per-ECU values. Supported on
+  /// Windows.
+  Future<bool> setEcuPolicies(List<BluetoothEcuPolicy> policies,
+      {String? address}) async {
+    try {
+      return await _channel.invokeMethod<bool>('setEcuPolicies', {
+            'policies': policies.map((policy) => policy.toMap()).toList(),
+            if (address != null) 'address': address,
+          }) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to set ECU policies: $e');
+    }
+  }
+
+  /// With [enabled], requests that only one ECU answers are sent to it
+  /// with physical addressing (ATSH) instead of to every ECU, so ECUs
+  /// without the PID stop answering. Requests with the `max` or
+  /// `consensus` policy stay functional. Turned off on its own if the
+  /// adapter rejects ATSH. Supported on Windows.
+  Future<bool> setEcuRouting(bool enabled, {String? address}) async {
+    try {
+      return await _channel.invokeMethod<bool>('setEcuRouting', {
+            'enabled': enabled,
+            if (address != null) 'address': address,
+          }) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to set ECU routing: $e');
+    }
+  }
+
+  /// Latest value and failure state of every (request, ECU) pair heard in
+  /// [sendCommands] and poll replies, with the value each request's policy
+  /// picks. Returns null where the platform keeps no per-ECU values.
+  Future<BluetoothEcuValues?> getEcuValues({String? address}) async {
+    try {
+      final Map<dynamic, dynamic>? values = await _channel.invokeMethod(
+          'getEcuValues', {if (address != null) 'address': address});
+      if (values == null || values.isEmpty) return null;
+      return BluetoothEcuValues.fromMap(values);
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to get ECU values: $e');
+    }
+  }
+
+  /// Probe the Mode 22 DIDs of [ranges] (first and last DID, inclusive)
+  /// on every ECU, pipelined through the adapter. DIDs are asked for
+  /// three per request until one of them answers, and with the learned
+  /// response count, so absent DIDs cost no timeout. Needs headers on
+  /// (ATH1) to tell the ECUs apart.
+  ///
+  /// [bitmap] is the [BluetoothDidScanProgress.bitmap] of an earlier scan
+  /// of the vehicle: the DIDs it settled are not probed again. Progress
+  /// and finds arrive on [onDidScanProgress]; the last event has
+  /// [BluetoothDidScanProgress.running] false and the new bitmap. Returns
+  /// the number of DIDs to probe (0: nothing left, and no events), or
+  /// null where the platform has no native scan. Supported on Windows.
+  Future<int?> startDidScan(List<(int, int)> ranges,
+      {Uint8List? bitmap, String? address}) async {
+    try {
+      return await _channel.invokeMethod<int>('startDidScan', {
+        'ranges': ranges.map((range) => [range.$1, range.$2]).toList(),
+        if (bitmap != null) 'bitmap': bitmap,
+        if (address != null) 'address': address,
+      });
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to start DID scan: $e');
+    }
+  }
+
+  /// Stops sending scan requests; the scan ends, with its last event, once
+  /// the requests under way are answered.
+  Future<bool> stopDidScan({String? address}) async {
+    try {
+      return await _channel.invokeMethod<bool>(
+              'stopDidScan', {if (address != null) 'address': address}) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to stop DID scan: $e');
+    }
+  }
+
+  /// What the scans of this connection found so far, two bits per DID
+  /// (see [BluetoothDidScanProgress.bitmap]); taken while a scan runs, it
+  /// lets the scan resume after a crash. Null where the platform has no
+  /// native scan.
+  Future<Uint8List?> getDidScanBitmap({String? address}) async {
+    try {
+      return await _channel.invokeMethod<Uint8List>(
+          'getDidScanBitmap', {if (address != null) 'address': address});
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to get DID scan bitmap: $e');
+    }
+  }
+
+  /// Configure how received chunks are merged before they are delivered on
+  /// [onDataReceived]. Data is delivered when [flushOnPrompt] is set and an
+  /// ELM327 '>' prompt arrives, when [maxBytes] are buffered, or [windowMs]
+  /// after the first buffered byte, whichever comes first. A [windowMs] of 0
+  /// delivers every chunk as it arrives. Supported on Windows.
+  Future<bool> setDataCoalescing({
+    int windowMs = 20,
+    int maxBytes = 4096,
+    bool flushOnPrompt = true,
+  }) async {
+    try {
+      return await _channel.invokeMethod('setDataCoalescing', {
+            'windowMs': windowMs,
+            'maxBytes': maxBytes,
+            'flushOnPrompt': flushOnPrompt,
+          }) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to set data coalescing: $e');
+    }
+  }
+
+  /// Frame received data natively into ELM327 responses.
+  ///
+  /// While enabled, received bytes are split at the '>' prompt into lines,
+  /// with the command echo and SEARCHING.../BUS INIT progress lines removed,
+  /// and delivered on [onResponseReceived] instead of [onDataReceived].
+  /// Returns false where the platform has no native framer.
+  Future<bool> setResponseFraming(bool enabled) async {
+    try {
+      return await _channel
+              .invokeMethod('setResponseFraming', {'enabled': enabled}) ??
+          false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to set response framing: $e');
+    }
+  }
+
+  /// The native trace of recent I/O, connects and errors as text, oldest
+  /// event first, or null where the platform keeps no trace. [maxEvents]
+  /// limits it to the newest events. Supported on Windows.
+  Future<String?> dumpTrace({int? maxEvents}) async {
+    try {
+      return await _channel.invokeMethod<String>(
+          'dumpTrace', {if (maxEvents != null) 'maxEvents': maxEvents});
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      throw BluetoothException('Failed to dump trace: $e');
+    }
+  }
+
+  /// Starts writing every byte sent to and received from each listening
+  /// connection to a capture file in [directory], one file per connection.
+  /// Captures replay through the native test harness. Returns false where
+  /// the platform cannot capture. Supported on Windows.
+  Future<bool> startWireCapture(String directory) async {
+    try {
+      final result = await _channel
+          .invokeMethod<bool>('startWireCapture', {'directory': directory});
+      return result ?? false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      throw BluetoothException('Failed to start wire capture: $e');
+    }
+  }
+
+  /// Stops wire capture and closes the capture files.
+  Future<void> stopWireCapture() async {
+    try {
+      await _channel.invokeMethod('stopWireCapture');
+    } on MissingPluginException {
+      return;
+    } catch (e) {
+      throw BluetoothException('Failed to stop wire capture: $e');
+    }
+  }
+
   /// Dispose of resources
   void dispose() {
     _stateStreamController.close();
@@ -277,3 +707,733 @@ class BluetoothData {
     );
   }
 }
+
+class BluetoothResponse {
+  final String deviceAddress;
+
+  /// Response lines without the prompt, echo and progress noise.
+  final List<String> lines;
+
+  /// When the '>' prompt arrived.
+  final DateTime timestamp;
+
+  /// Time from writing the command to the prompt.
+  final Duration elapsed;
+
+  BluetoothResponse({
+    required this.deviceAddress,
+    required this.lines,
+    required this.timestamp,
+    required this.elapsed,
+  });
+
+  factory BluetoothResponse.fromMap(dynamic map) {
+    return BluetoothResponse(
+      deviceAddress: map['deviceAddress'],
+      lines: List<String>.from(map['lines']),
+      timestamp: DateTime.fromMicrosecondsSinceEpoch(map['timestampUs']),
+      elapsed: Duration(microseconds: map['elapsedUs']),
+    );
+  }
+}
+
+class BluetoothCommandResult {
+  final String command;
+
+  /// Response lines without the prompt, echo and progress noise. Empty
+  /// unless [isOk].
+  final List<String> lines;
+
+  /// [lines] reassembled into one message per answering ECU, with ISO-TP
+  /// frames joined and checked against their sequence numbers.
+  final List<BluetoothEcuMessage> messages;
+
+  /// One of 'ok', 'timeout', 'writeFailed' or 'cancelled'.
+  final String status;
+
+  /// Time from writing the command to the prompt (or to the deadline).
+  final Duration elapsed;
+
+  BluetoothCommandResult({
+    required this.command,
+    required this.lines,
+    this.messages = const [],
+    required this.status,
+    required this.elapsed,
+  });
+
+  bool get isOk => status == 'ok';
+
+  factory BluetoothCommandResult.fromMap(dynamic map) {
+    return BluetoothCommandResult(
+      command: map['command'],
+      lines: List<String>.from(map['lines']),
+      messages: map['messages'] == null
+          ? const []
+          : List<BluetoothEcuMessage>.from(
+              map['messages'].map((m) => BluetoothEcuMessage.fromMap(m))),
+      status: map['status'],
+      elapsed: Duration(microseconds: map['elapsedUs']),
+    );
+  }
+}
+
+class BluetoothEcuMessage {
+  /// The CAN ID as printed ('7E8', '18DAF110'); empty without headers.
+  final String id;
+
+  final Uint8List bytes;
+
+  /// False if the message lost a frame or is shorter than it declared.
+  final bool complete;
+
+  BluetoothEcuMessage({
+    required this.id,
+    required this.bytes,
+    required this.complete,
+  });
+
+  factory BluetoothEcuMessage.fromMap(dynamic map) {
+    return BluetoothEcuMessage(
+      id: map['id'],
+      bytes: map['bytes'],
+      complete: map['complete'],
+    );
+  }
+}
+
+class BluetoothPollEntry {
+  final String command;
+
+  /// Target time between two samples.
+  final Duration period;
+
+  const BluetoothPollEntry({required this.command, required this.period});
+
+  Map<String, dynamic> toMap() {
+    return {
+      'command': command,
+      'periodMs': period.inMilliseconds,
+    };
+  }
+}
+
+class BluetoothPollSample {
+  final String deviceAddress;
+  final String command;
+
+  /// One of 'ok', 'timeout', 'writeFailed' or 'cancelled'.
+  final String status;
+  final List<String> lines;
+  final DateTime timestamp;
+  final Duration elapsed;
+
+  BluetoothPollSample({
+    required this.deviceAddress,
+    required this.command,
+    required this.status,
+    required this.lines,
+    required this.timestamp,
+    required this.elapsed,
+  });
+
+  bool get isOk => status == 'ok';
+
+  factory BluetoothPollSample.fromMap(dynamic map) {
+    return BluetoothPollSample(
+      deviceAddress: map['deviceAddress'],
+      command: map['command'],
+      status: map['status'],
+      lines: List<String>.from(map['lines']),
+      timestamp: DateTime.fromMicrosecondsSinceEpoch(map['timestampUs']),
+      elapsed: Duration(microseconds: map['elapsedUs']),
+    );
+  }
+}
+
+class BluetoothPollStats {
+  final String command;
+  final double targetHz;
+  final double achievedHz;
+  final int samples;
+  final int timeouts;
+  final int deadlineMisses;
+
+  BluetoothPollStats({
+    required this.command,
+    required this.targetHz,
+    required this.achievedHz,
+    required this.samples,
+    required this.timeouts,
+    required this.deadlineMisses,
+  });
+
+  factory BluetoothPollStats.fromMap(dynamic map) {
+    return BluetoothPollStats(
+      command: map['command'],
+      targetHz: (map['targetHz'] as num).toDouble(),
+      achievedHz: (map['achievedHz'] as num).toDouble(),
+      samples: map['samples'],
+      timeouts: map['timeouts'],
+      deadlineMisses: map['deadlineMisses'],
+    );
+  }
+}
+
+/// Distribution of one latency phase, from a native HDR-style histogram
+/// (percentiles are within about 3% of the exact value).
+class BluetoothLatencySummary {
+  final int count;
+  final Duration mean;
+  final Duration p50;
+  final Duration p90;
+  final Duration p99;
+  final Duration max;
+
+  BluetoothLatencySummary({
+    required this.count,
+    required this.mean,
+    required this.p50,
+    required this.p90,
+    required this.p99,
+    required this.max,
+  });
+
+  factory BluetoothLatencySummary.fromMap(dynamic map) {
+    return BluetoothLatencySummary(
+      count: map['count'],
+      mean: Duration(microseconds: map['meanUs']),
+      p50: Duration(microseconds: map['p50Us']),
+      p90: Duration(microseconds: map['p90Us']),
+      p99: Duration(microseconds: map['p99Us']),
+      max: Duration(microseconds: map['maxUs']),
+    );
+  }
+}
+
+class BluetoothCommandLatency {
+  final String command;
+  final int completed;
+  final int timeouts;
+
+  /// By phase: 'firstByte' (write to first response byte), 'prompt' (first
+  /// byte to '>'), 'roundTrip' (write to '>') and 'delivery' ('>' to the
+  /// platform thread). Phases without samples are absent.
+  final Map<String, BluetoothLatencySummary> phases;
+
+  BluetoothCommandLatency({
+    required this.command,
+    required this.completed,
+    required this.timeouts,
+    required this.phases,
+  });
+
+  BluetoothLatencySummary? get roundTrip => phases['roundTrip'];
+
+  factory BluetoothCommandLatency.fromMap(dynamic map) {
+    final phases = Map<dynamic, dynamic>.from(map['phases'] ?? const {});
+    return BluetoothCommandLatency(
+      command: map['command'],
+      completed: map['completed'],
+      timeouts: map['timeouts'],
+      phases: phases.map((name, summary) => MapEntry(
+          name as String, BluetoothLatencySummary.fromMap(summary))),
+    );
+  }
+}
+
+/// The responder count the native layer learned for one OBD request and
+/// appends to it (`010C` is sent as `010C2`), so the adapter stops
+/// listening at the last answer instead of waiting out its timeout.
+/// Accumulated since the connection came up; [BluetoothLinkStats] resets do
+/// not clear it.
+class BluetoothResponseCount {
+  final String command;
+
+  /// Appended count; 0 while the request is sent open-ended (still
+  /// learning, or the responders kept changing).
+  final int count;
+  final int openReplies;
+  final int countedReplies;
+
+  /// Mean round trip without and with the count.
+  final Duration openMean;
+  final Duration countedMean;
+
+  /// Round trip saved per counted request.
+  final Duration saved;
+
+  /// Times the count was dropped because the responders changed.
+  final int relearns;
+
+  BluetoothResponseCount({
+    required this.command,
+    required this.count,
+    required this.openReplies,
+    required this.countedReplies,
+    required this.openMean,
+    required this.countedMean,
+    required this.saved,
+    required this.relearns,
+  });
+
+  factory BluetoothResponseCount.fromMap(dynamic map) {
+    return BluetoothResponseCount(
+      command: map['command'],
+      count: map['count'],
+      openReplies: map['openReplies'],
+      countedReplies: map['countedReplies'],
+      openMean: Duration(microseconds: map['openMeanUs']),
+      countedMean: Duration(microseconds: map['countedMeanUs']),
+      saved: Duration(microseconds: map['savedUs']),
+      relearns: map['relearns'],
+    );
+  }
+}
+
+/// The response timeout (ATST) the native layer picks for one OBD request
+/// from its response times, and sets on the adapter ahead of it when it
+/// differs. Accumulated since the connection came up.
+class BluetoothAdaptiveTimeout {
+  final String command;
+
+  /// ATST value the request currently needs, in 4 ms counts.
+  final int counts;
+  final int replies;
+  final int noData;
+
+  /// 98th percentile of the recent first-response times.
+  final Duration quantile;
+
+  /// Times an answer showed the timeout had been cut too close.
+  final int backoffs;
+
+  BluetoothAdaptiveTimeout({
+    required this.command,
+    required this.counts,
+    required this.replies,
+    required this.noData,
+    required this.quantile,
+    required this.backoffs,
+  });
+
+  factory BluetoothAdaptiveTimeout.fromMap(dynamic map) {
+    return BluetoothAdaptiveTimeout(
+      command: map['command'],
+      counts: map['counts'],
+      replies: map['replies'],
+      noData: map['noData'],
+      quantile: Duration(microseconds: map['quantileUs']),
+      backoffs: map['backoffs'],
+    );
+  }
+}
+
+/// Latest value of one J1939 SPN decoded in monitor mode.
+class BluetoothJ1939Value {
+  final int spn;
+  final int pgn;
+
+  /// Parameter id of the app's config where one exists (`coolantTemp`),
+  /// otherwise the J1939 name.
+  final String id;
+  final String unit;
+  final double value;
+
+  /// Source address of the ECU that sent it.
+  final int source;
+
+  /// Time since the frame arrived.
+  final Duration age;
+  final int updates;
+
+  BluetoothJ1939Value({
+    required this.spn,
+    required this.pgn,
+    required this.id,
+    required this.unit,
+    required this.value,
+    required this.source,
+    required this.age,
+    required this.updates,
+  });
+
+  factory BluetoothJ1939Value.fromMap(dynamic map) {
+    return BluetoothJ1939Value(
+      spn: map['spn'],
+      pgn: map['pgn'],
+      id: map['id'],
+      unit: map['unit'],
+      value: (map['value'] as num).toDouble(),
+      source: map['source'],
+      age: Duration(microseconds: map['ageUs']),
+      updates: map['updates'],
+    );
+  }
+}
+
+/// One active fault of a DM1.
+class BluetoothJ1939Dtc {
+  final int spn;
+
+  /// Failure mode identifier.
+  final int fmi;
+
+  /// Occurrence count; 127 if the ECU does not count.
+  final int occurrences;
+
+  BluetoothJ1939Dtc({
+    required this.spn,
+    required this.fmi,
+    required this.occurrences,
+  });
+
+  factory BluetoothJ1939Dtc.fromMap(dynamic map) {
+    return BluetoothJ1939Dtc(
+      spn: map['spn'],
+      fmi: map['fmi'],
+      occurrences: map['occurrences'],
+    );
+  }
+}
+
+/// The latest DM1 (active faults and lamps) of one ECU, reassembled from
+/// its transport protocol packets when it has more than one fault.
+class BluetoothJ1939Dm1 {
+  /// Source address of the ECU.
+  final int source;
+  final bool malfunctionLamp;
+  final bool redStopLamp;
+  final bool amberWarningLamp;
+  final bool protectLamp;
+  final List<BluetoothJ1939Dtc> dtcs;
+
+  /// Time since it arrived.
+  final Duration age;
+  final int updates;
+
+  BluetoothJ1939Dm1({
+    required this.source,
+    required this.malfunctionLamp,
+    required this.redStopLamp,
+    required this.amberWarningLamp,
+    required this.protectLamp,
+    required this.dtcs,
+    required this.age,
+    required this.updates,
+  });
+
+  factory BluetoothJ1939Dm1.fromMap(dynamic map) {
+    return BluetoothJ1939Dm1(
+      source: map['source'],
+      malfunctionLamp: map['malfunctionLamp'] ?? false,
+      redStopLamp: map['redStopLamp'] ?? false,
+      amberWarningLamp: map['amberWarningLamp'] ?? false,
+      protectLamp: map['protectLamp'] ?? false,
+      dtcs: List<dynamic>.from(map['dtcs'] ?? const [])
+          .map(BluetoothJ1939Dtc.fromMap)
+          .toList(),
+      age: Duration(microseconds: map['ageUs']),
+      updates: map['updates'],
+    );
+  }
+}
+
+class BluetoothJ1939Values {
+  /// False once monitoring ended, also when the adapter stopped on its own
+  /// (BUFFER FULL).
+  final bool monitoring;
+  final List<BluetoothJ1939Value> values;
+  final List<BluetoothJ1939Dm1> dm1;
+
+  /// frames, decoded, ignored, malformed, overflows, transportMessages and
+  /// transportErrors (transfers lost to gaps, holes or aborts).
+  final Map<String, int> counters;
+
+  BluetoothJ1939Values({
+    required this.monitoring,
+    required this.values,
+    this.dm1 = const [],
+    required this.counters,
+  });
+
+  factory BluetoothJ1939Values.fromMap(dynamic map) {
+    return BluetoothJ1939Values(
+      monitoring: map['monitoring'] ?? false,
+      values: List<dynamic>.from(map['values'] ?? const [])
+          .map(BluetoothJ1939Value.fromMap)
+          .toList(),
+      dm1: List<dynamic>.from(map['dm1'] ?? const [])
+          .map(BluetoothJ1939Dm1.fromMap)
+          .toList(),
+      counters: Map<String, int>.from(map['counters'] ?? const {}),
+    );
+  }
+}
+
+/// How [FlutterBluetoothClassic.setEcuPolicies] picks the value of
+/// [command].
+class BluetoothEcuPolicy {
+  final String command;
+
+  /// `preferred`, `max` or `consensus`.
+  final String policy;
+
+  /// CAN ID of the ECU whose value `preferred` picks ("18DAF110", "7E8").
+  final String? preferred;
+
+  const BluetoothEcuPolicy(this.command, this.policy, {this.preferred});
+
+  Map<String, dynamic> toMap() => {
+        'command': command,
+        'policy': policy,
+        if (preferred != null) 'preferred': preferred,
+      };
+}
+
+/// One ECU's latest answer to one request.
+class BluetoothEcuReading {
+  /// CAN ID it answers from.
+  final String ecu;
+
+  /// Null until it returned a value the native PID table decodes.
+  final double? value;
+
+  /// Time since [value] arrived.
+  final Duration? age;
+
+  /// Replies in a row without a value from it.
+  final int failures;
+
+  /// Code of its last negative response, 0 if none.
+  final int nrc;
+  final int answers;
+
+  BluetoothEcuReading({
+    required this.ecu,
+    this.value,
+    this.age,
+    required this.failures,
+    required this.nrc,
+    required this.answers,
+  });
+
+  factory BluetoothEcuReading.fromMap(dynamic map) {
+    return BluetoothEcuReading(
+      ecu: map['ecu'],
+      value: (map['value'] as num?)?.toDouble(),
+      age: map['ageUs'] != null ? Duration(microseconds: map['ageUs']) : null,
+      failures: map['failures'] ?? 0,
+      nrc: map['nrc'] ?? 0,
+      answers: map['answers'] ?? 0,
+    );
+  }
+}
+
+/// The per-ECU readings of one single-PID request and the value its
+/// policy picks.
+class BluetoothEcuValue {
+  final String command;
+  final String policy;
+  final String preferred;
+
+  /// The ECU the request is routed to; empty while it goes to every ECU.
+  final String owner;
+
+  /// Null if no reading is fresh enough.
+  final double? value;
+  final String? selectedEcu;
+  final List<BluetoothEcuReading> ecus;
+
+  BluetoothEcuValue({
+    required this.command,
+    required this.policy,
+    this.preferred = '',
+    this.owner = '',
+    this.value,
+    this.selectedEcu,
+    required this.ecus,
+  });
+
+  factory BluetoothEcuValue.fromMap(dynamic map) {
+    return BluetoothEcuValue(
+      command: map['command'],
+      policy: map['policy'] ?? 'preferred',
+      preferred: map['preferred'] ?? '',
+      owner: map['owner'] ?? '',
+      value: (map['value'] as num?)?.toDouble(),
+      selectedEcu: map['selectedEcu'],
+      ecus: List<dynamic>.from(map['ecus'] ?? const [])
+          .map(BluetoothEcuReading.fromMap)
+          .toList(),
+    );
+  }
+}
+
+class BluetoothEcuValues {
+  final bool routing;
+
+  /// ATSH changes the native layer has written.
+  final int headerChanges;
+  final List<BluetoothEcuValue> values;
+
+  BluetoothEcuValues({
+    required this.routing,
+    required this.headerChanges,
+    required this.values,
+  });
+
+  factory BluetoothEcuValues.fromMap(dynamic map) {
+    return BluetoothEcuValues(
+      routing: map['routing'] ?? false,
+      headerChanges: map['headerChanges'] ?? 0,
+      values: List<dynamic>.from(map['values'] ?? const [])
+          .map(BluetoothEcuValue.fromMap)
+          .toList(),
+    );
+  }
+}
+
+/// One ECU's answer to a DID it has: data, or a refusal.
+class BluetoothDidAnswer {
+  final int did;
+
+  /// CAN ID it answered from.
+  final String ecu;
+
+  /// The data after `62 did`; empty for a refusal.
+  final Uint8List bytes;
+
+  /// The refusal's negative response code (0x22, 0x33), 0 for data.
+  final int nrc;
+
+  BluetoothDidAnswer({
+    required this.did,
+    required this.ecu,
+    required this.bytes,
+    required this.nrc,
+  });
+
+  factory BluetoothDidAnswer.fromMap(dynamic map) {
+    return BluetoothDidAnswer(
+      did: map['did'],
+      ecu: map['ecu'] ?? '',
+      bytes: map['bytes'] ?? Uint8List(0),
+      nrc: map['nrc'] ?? 0,
+    );
+  }
+}
+
+class BluetoothDidScanProgress {
+  final String deviceAddress;
+
+  /// Answers to the chunk this event reports.
+  final List<BluetoothDidAnswer> answers;
+  final bool running;
+
+  /// Ended by [FlutterBluetoothClassic.stopDidScan] or the link going away
+  /// before every DID was probed.
+  final bool stopped;
+
+  /// DIDs the scan probes, and those done with (resolved, or given up on
+  /// after three tries).
+  final int total;
+  final int probed;
+  final int supported;
+  final int refused;
+  final int absent;
+
+  /// Requests sent, retries included.
+  final int requests;
+  final int lastDid;
+
+  /// Response count appended to the requests; 0 while open-ended.
+  final int count;
+  final Duration elapsed;
+  final double didsPerSecond;
+
+  /// Supported and refused DIDs found per second.
+  final double hitsPerSecond;
+
+  /// Two bits per DID, DID d in byte d ~/ 4 from the low bits up: 0
+  /// unknown, 1 supported, 2 refused, 3 absent. Only on the last event.
+  final Uint8List? bitmap;
+
+  BluetoothDidScanProgress({
+    required this.deviceAddress,
+    required this.answers,
+    required this.running,
+    required this.stopped,
+    required this.total,
+    required this.probed,
+    required this.supported,
+    required this.refused,
+    required this.absent,
+    required this.requests,
+    required this.lastDid,
+    required this.count,
+    required this.elapsed,
+    required this.didsPerSecond,
+    required this.hitsPerSecond,
+    this.bitmap,
+  });
+
+  factory BluetoothDidScanProgress.fromMap(dynamic map) {
+    return BluetoothDidScanProgress(
+      deviceAddress: map['deviceAddress'] ?? '',
+      answers: List<dynamic>.from(map['answers'] ?? const [])
+          .map(BluetoothDidAnswer.fromMap)
+          .toList(),
+      running: map['running'] ?? false,
+      stopped: map['stopped'] ?? false,
+      total: map['total'] ?? 0,
+      probed: map['probed'] ?? 0,
+      supported: map['supported'] ?? 0,
+      refused: map['refused'] ?? 0,
+      absent: map['absent'] ?? 0,
+      requests: map['requests'] ?? 0,
+      lastDid: map['lastDid'] ?? 0,
+      count: map['count'] ?? 0,
+      elapsed: Duration(microseconds: map['elapsedUs'] ?? 0),
+      didsPerSecond: (map['didsPerSecond'] as num?)?.toDouble() ?? 0,
+      hitsPerSecond: (map['hitsPerSecond'] as num?)?.toDouble() ?? 0,
+      bitmap: map['bitmap'],
+    );
+  }
+}
+
+class BluetoothLinkStats {
+  /// bytesReceived, bytesSent, responses, timeouts, writeFailures,
+  /// overflows and droppedBytes.
+  final Map<String, int> counters;
+  final List<BluetoothCommandLatency> commands;
+  final List<BluetoothResponseCount> responseCounts;
+  final List<BluetoothAdaptiveTimeout> timeouts;
+
+  /// ATST changes the native layer has written.
+  final int atstChanges;
+
+  BluetoothLinkStats({
+    required this.counters,
+    required this.commands,
+    this.responseCounts = const [],
+    this.timeouts = const [],
+    this.atstChanges = 0,
+  });
+
+  factory BluetoothLinkStats.fromMap(dynamic map) {
+    return BluetoothLinkStats(
+      counters: Map<String, int>.from(map['counters'] ?? const {}),
+      commands: List<dynamic>.from(map['commands'] ?? const [])
+          .map(BluetoothCommandLatency.fromMap)
+          .toList(),
+      responseCounts: List<dynamic>.from(map['responseCounts'] ?? const [])
+          .map(BluetoothResponseCount.fromMap)
+          .toList(),
+      timeouts: List<dynamic>.from(map['timeouts'] ?? const [])
+          .map(BluetoothAdaptiveTimeout.fromMap)
+          .toList(),
+      atstChanges: map['atstChanges'] ?? 0,
+    );
+  }
+}
@@ -0,0 +1,214 @@
+#include "adaptive_timeouts.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "elm327_reply.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// ATST values commands are rounded up to, so that commands with similar
+// response times agree on one and the adapter's value changes rarely.
+constexpr int kLadder[] = {4, 6, 8, 12, 16, 24, 32, 0x32, 64, 96, 128, 192, 0xFF};
+
+// Hex OBD requests, with or without a response count.
+bool Managed(const std::string& command) {
+  if (command.size() < 4) return false;
+  for (char c : command) {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+  }
+  return true;
+}
+
+bool IsNoData(const std::vector<std::string>& lines) {
+  return std::find(lines.begin(), lines.end(), "NO DATA") != lines.end();
+}
+
+// Complete ECU messages in a reply.
+int Responders(const std::vector<std::string>& lines) {
+  int count = 0;
+  for (const auto& message : AssembleElmReply(lines)) {
+    if (message.complete) ++count;
+  }
+  return count;
+}
+
+int CountsFor(std::uint64_t quantile_us) {
+  const std::uint64_t needed =
+      (quantile_us * 3 / 2 + 3999) / 4000 + AdaptiveTimeouts::kMarginCounts;
+  for (int rung : kLadder) {
+    if (needed <= static_cast<std::uint64_t>(rung)) return rung;
+  }
+  return AdaptiveTimeouts::kMaxCounts;
+}
+
+}  // namespace
+
+void AdaptiveTimeouts::Window::Add(std::uint32_t value_us) {
+  if (values.size() < capacity) {
+    values.push_back(value_us);
+    return;
+  }
+  values[next] = value_us;
+  next = (next + 1) % capacity;
+}
+
+std::uint32_t AdaptiveTimeouts::Window::Quantile(double quantile) const {
+  if (values.empty()) return 0;
+  std::vector<std::uint32_t> sorted = values;
+  const std::size_t rank = std::min(
+      sorted.size() - 1, static_cast<std::size_t>(quantile * static_cast<double>(sorted.size())));
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  return sorted[rank];
+}
+
+std::uint32_t AdaptiveTimeouts::Window::Max() const {
+  return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+}
+
+int AdaptiveTimeouts::Needed(const std::string& command, const Entry& entry) const {
+  if (entry.sends < kMinSends || entry.backoff > 0) return default_;
+  if (entry.window.values.size() >= kMinSends) {
+    return CountsFor(entry.window.Quantile(kQuantile));
+  }
+  // Rarely answered: whatever it did answer in, and its service's usual times
+  auto service = services_.find(command.substr(0, 2));
+  if (service == services_.end() || service->second.values.size() < kMinSends) {
+    return default_;
+  }
+  return std::max(CountsFor(entry.window.Max()),
+                  std::min(default_, CountsFor(service->second.Quantile(kQuantile))));
+}
+
+int AdaptiveTimeouts::Select(const std::string& command, int current) {
+  if (!Managed(command)) return current;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (unsupported_) return current;
+  auto it = entries_.find(command);
+  if (it == entries_.end()) {
+    if (entries_.size() >= kMaxCommands) return std::max(current, default_);
+    it = entries_.emplace(command, Entry()).first;
+  }
+  Entry& entry = it->second;
+  const int needed = Needed(command, entry);
+  ++entry.sends;
+  if (entry.backoff > 0) --entry.backoff;
+  if (current < 0 || needed > current) return needed;
+  if (needed == current) return current;
+
+  // Lowering pays off through the NO DATA replies it shortens, and will
+  // likely cost a change back up for the next command
+  const double saving_us =
+      entry.miss_rate * static_cast<double>(CountsToTime(current - needed).count());
+  if (saving_us > 2.0 * static_cast<double>(change_cost_.count())) return needed;
+  return current;
+}
+
+void AdaptiveTimeouts::Observe(const std::string& command, int counts, const CommandResult& result,
+                               std::chrono::microseconds first_response) {
+  if (result.status == CommandResult::Status::kWriteFailed ||
+      result.status == CommandResult::Status::kCancelled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(command);
+  if (it == entries_.end() || unsupported_) return;
+  Entry& entry = it->second;
+  const bool lowered = counts >= 0 && counts < default_;
+
+  if (result.status == CommandResult::Status::kTimedOut) {
+    entry.backoff = kBackoffSends;
+    ++entry.backoffs;
+    return;
+  }
+  if (IsNoData(result.lines)) {
+    ++entry.no_data;
+    entry.miss_rate += (1.0 - entry.miss_rate) / 16;
+    // It has answered before, so the answer may just have been too slow
+    if (lowered && !entry.window.values.empty() && entry.backoff == 0) entry.backoff = 1;
+    return;
+  }
+
+  entry.miss_rate -= entry.miss_rate / 16;
+  const int responders = Responders(result.lines);
+  if (responders == 0) return;
+  ++entry.replies;
+  if (first_response.count() > 0) {
+    const auto value_us = static_cast<std::uint32_t>(
+        std::min<std::int64_t>(first_response.count(), CountsToTime(kMaxCounts).count()));
+    entry.window.Add(value_us);
+    Window& service = services_[command.substr(0, 2)];
+    service.capacity = 4 * kWindow;
+    service.Add(value_us);
+  }
+  // An ECU heard before went missing, or the answer came later than the
+  // lowered window would have waited
+  const bool too_close =
+      (lowered && responders < entry.max_responders) ||
+      (counts >= 0 && first_response > CountsToTime(std::min(counts, Needed(command, entry))));
+  if (too_close && entry.backoff <= 1) {
+    entry.backoff = kBackoffSends;
+    ++entry.backoffs;
+  }
+  // At the default every ECU that answers is heard, so the count is reset
+  // there: physical addressing (see EcuValues) answers from fewer
+  entry.max_responders = lowered ? std::max(entry.max_responders, responders) : responders;
+}
+
+void AdaptiveTimeouts::ObserveChange(std::chrono::microseconds elapsed, bool accepted) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!accepted) {
+    unsupported_ = true;
+    return;
+  }
+  ++changes_;
+  change_cost_ += (elapsed - change_cost_) / 8;
+}
+
+void AdaptiveTimeouts::SetDefault(int counts) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  default_ = counts;
+}
+
+int AdaptiveTimeouts::default_counts() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return default_;
+}
+
+std::vector<AdaptiveTimeoutStats> AdaptiveTimeouts::Snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<AdaptiveTimeoutStats> snapshot;
+  snapshot.reserve(entries_.size());
+  for (const auto& it : entries_) {
+    const Entry& entry = it.second;
+    AdaptiveTimeoutStats stats;
+    stats.command = it.first;
+    stats.counts = Needed(it.first, entry);
+    stats.replies = entry.replies;
+    stats.no_data = entry.no_data;
+    stats.quantile_us = entry.window.Quantile(kQuantile);
+    stats.backoffs = entry.backoffs;
+    snapshot.push_back(std::move(stats));
+  }
+  return snapshot;
+}
+
+std::uint64_t AdaptiveTimeouts::changes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return changes_;
+}
+
+void AdaptiveTimeouts::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  services_.clear();
+  change_cost_ = std::chrono::microseconds(10000);
+  changes_ = 0;
+  default_ = kDefaultCounts;
+  unsupported_ = false;
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,146 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_ADAPTIVE_TIMEOUTS_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_ADAPTIVE_TIMEOUTS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "command_pipeline.h"
+
+namespace flutter_bluetooth_classic {
+
+// What has been learned about the response times of one command.
+struct AdaptiveTimeoutStats {
+  std::string command;
+  // ATST counts (4 ms each) the command currently needs.
+  int counts = 0;
+  std::uint64_t replies = 0;
+  std::uint64_t no_data = 0;
+  // The kQuantile response time of the recent replies.
+  std::uint64_t quantile_us = 0;
+  // Times a reply showed the timeout had been cut too close.
+  int backoffs = 0;
+};
+
+// Picks the ELM327 response timeout (ATST) per OBD request from the
+// request's own response times, instead of one worst-case value for every
+// command on the link. A request nobody answers ends with NO DATA only
+// once ATST has run out, so every NO DATA costs the whole window.
+//
+// A command needs the kQuantile of its last kWindow first-response times,
+// times 1.5, plus kMarginCounts, rounded up to a rung of a fixed ladder so
+// that similar commands share a value. One that is rarely answered uses the
+// quantile of every command of its service (01, 22, ...) instead, but never
+// more than the default: waiting longer cannot help a command that went
+// unanswered under it. Until kMinSends results are in, and while backing
+// off, a command needs the default, which is the last ATST the app set
+// itself (ATST32 while polling, shorter during a DID scan).
+//
+// The adapter has one ATST for everything and changing it is an AT round
+// trip of its own, so Select() raises the value whenever the next command
+// needs more, but lowers it only when the command's NO DATA rate makes the
+// expected saving larger than changing down and back up again.
+//
+// A NO DATA under a lowered value from a command that has answered before
+// sends it once at the default to check; an answer later than the
+// lowered window, or from fewer ECUs than before, backs the command off
+// for kBackoffSends sends. A timeout does the same. An adapter that does
+// not accept ATST turns the controller off for the link.
+//
+// Only hex OBD requests are managed; AT and ST commands never change the
+// value. Select() and Observe() run on the link's receive thread,
+// Snapshot() on any thread.
+class AdaptiveTimeouts {
+ public:
+  // ELM327 power-up value and what the app polls with: 200 ms.
+  static constexpr int kDefaultCounts = 0x32;
+  static constexpr int kMaxCounts = 0xFF;
+  static constexpr std::size_t kWindow = 64;
+  static constexpr std::size_t kMinSends = 16;
+  static constexpr double kQuantile = 0.98;
+  static constexpr int kMarginCounts = 3;
+  static constexpr int kBackoffSends = 8;
+  // Commands beyond this many (a DID scan) keep the default.
+  static constexpr std::size_t kMaxCommands = 256;
+
+  AdaptiveTimeouts() = default;
+  AdaptiveTimeouts(const AdaptiveTimeouts&) = delete;
+  AdaptiveTimeouts& operator=(const AdaptiveTimeouts&) = delete;
+
+  // ATST counts to have in effect for |command| when the adapter's value is
+  // |current| (-1 if unknown). Returns |current| if no change is worth its
+  // round trip.
+  int Select(const std::string& command, int current);
+
+  // Reports |command|'s result under ATST |counts|; |first_response| is the
+  // time from the write to the first reply byte, 0 if unknown.
+  void Observe(const std::string& command, int counts, const CommandResult& result,
+               std::chrono::microseconds first_response);
+
+  // Reports one ATST change that took |elapsed| and was accepted or not.
+  void ObserveChange(std::chrono::microseconds elapsed, bool accepted);
+
+  // Makes |counts| the default, after the app set it or a reset restored
+  // kDefaultCounts.
+  void SetDefault(int counts);
+  int default_counts() const;
+
+  // Every managed command, in command order.
+  std::vector<AdaptiveTimeoutStats> Snapshot() const;
+  // ATST changes made so far.
+  std::uint64_t changes() const;
+
+  // Forgets everything, e.g. for another vehicle.
+  void Reset();
+
+  static std::chrono::microseconds CountsToTime(int counts) {
+    return std::chrono::microseconds(counts * 4000);
+  }
+
+ private:
+  // Recent first-response times in microseconds.
+  struct Window {
+    void Add(std::uint32_t value_us);
+    std::uint32_t Quantile(double quantile) const;
+    std::uint32_t Max() const;
+
+    std::vector<std::uint32_t> values;
+    std::size_t next = 0;
+    std::size_t capacity = kWindow;
+  };
+
+  struct Entry {
+    Window window;
+    std::uint64_t sends = 0;
+    std::uint64_t replies = 0;
+    std::uint64_t no_data = 0;
+    // Running NO DATA rate, 1/16 weight per result.
+    double miss_rate = 0;
+    int max_responders = 0;
+    // Sends left at the default.
+    int backoff = 0;
+    int backoffs = 0;
+  };
+
+  // Counts |command|'s |entry| needs; lock held.
+  int Needed(const std::string& command, const Entry& entry) const;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+  // First-response times of every command, by service (the request's
+  // first byte).
+  std::map<std::string, Window> services_;
+  // Running cost of one ATST change.
+  std::chrono::microseconds change_cost_{10000};
+  std::uint64_t changes_ = 0;
+  int default_ = kDefaultCounts;
+  bool unsupported_ = false;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_ADAPTIVE_TIMEOUTS_H_
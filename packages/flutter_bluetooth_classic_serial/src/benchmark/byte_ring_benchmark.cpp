@@ -0,0 +1,122 @@
+// Receive buffer throughput and read latency: ByteRing vs the previous
+// std::map<std::string, std::string> + mutex buffer.
+//
+// Each iteration streams 1 MiB from a producer thread in 64-byte recv()-sized
+// chunks while the benchmark thread drains it the way ReadData does. The
+// "p99_read_ns" counter is the 99th percentile duration of one read call.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "byte_ring.h"
+#include "handle_table.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kTransferBytes = 1 << 20;
+constexpr std::size_t kChunkBytes = 64;
+const char kAddress[] = "00:1D:A5:68:98:8B";
+
+double Percentile(std::vector<std::int64_t>& samples, double fraction) {
+  if (samples.empty()) return 0;
+  std::size_t index = static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+  return static_cast<double>(samples[index]);
+}
+
+// The previous buffer: one string per address under a global mutex.
+class MapBuffer {
+ public:
+  void Append(const std::string& address, const std::uint8_t* data, std::size_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    received_data_[address].append(reinterpret_cast<const char*>(data), length);
+  }
+
+  std::string Read(const std::string& address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = received_data_.find(address);
+    if (it == received_data_.end() || it->second.empty()) return std::string();
+    std::string data = it->second;
+    it->second.clear();
+    return data;
+  }
+
+ private:
+  std::map<std::string, std::string> received_data_;
+  std::mutex mutex_;
+};
+
+void BM_MapBufferStream(benchmark::State& state) {
+  MapBuffer buffer;
+  const std::string address(kAddress);
+  std::vector<std::int64_t> latencies;
+  std::uint8_t chunk[kChunkBytes];
+  std::memset(chunk, 'A', sizeof(chunk));
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      for (std::size_t sent = 0; sent < kTransferBytes; sent += kChunkBytes) {
+        buffer.Append(address, chunk, kChunkBytes);
+      }
+    });
+    std::size_t received = 0;
+    while (received < kTransferBytes) {
+      auto start = Clock::now();
+      std::string data = buffer.Read(address);
+      latencies.push_back((Clock::now() - start).count());
+      received += data.size();
+      if (data.empty()) std::this_thread::yield();
+    }
+    producer.join();
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * kTransferBytes));
+  state.counters["p99_read_ns"] = Percentile(latencies, 0.99);
+}
+BENCHMARK(BM_MapBufferStream)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_ByteRingStream(benchmark::State& state) {
+  HandleTable<ByteRing> rings;
+  HandleTable<ByteRing>::Handle handle = rings.Insert(std::make_unique<ByteRing>(64 * 1024));
+  ByteRing* producer_ring = rings.Get(handle);
+  std::vector<std::int64_t> latencies;
+  std::vector<std::uint8_t> out(64 * 1024);
+  std::uint8_t chunk[kChunkBytes];
+  std::memset(chunk, 'A', sizeof(chunk));
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      for (std::size_t sent = 0; sent < kTransferBytes; sent += kChunkBytes) {
+        while (producer_ring->Space() < kChunkBytes) std::this_thread::yield();
+        producer_ring->Write(chunk, kChunkBytes);
+      }
+    });
+    std::size_t received = 0;
+    while (received < kTransferBytes) {
+      auto start = Clock::now();
+      ByteRing* ring = rings.Get(handle);
+      std::size_t read = ring->Read(out.data(), out.size());
+      latencies.push_back((Clock::now() - start).count());
+      received += read;
+      if (read == 0) std::this_thread::yield();
+    }
+    producer.join();
+  }
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * kTransferBytes));
+  state.counters["p99_read_ns"] = Percentile(latencies, 0.99);
+  state.counters["dropped"] = static_cast<double>(rings.Get(handle)->dropped_bytes());
+}
+BENCHMARK(BM_ByteRingStream)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
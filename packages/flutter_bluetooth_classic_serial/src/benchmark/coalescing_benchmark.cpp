@@ -0,0 +1,123 @@
+// Platform messages per adapter response, with and without chunk coalescing.
+//
+// The remote end writes a multi-frame ELM327 reply in small fragments, the
+// way RFCOMM hands it to recv(). BM_UncoalescedResponse forwards every recv()
+// chunk as its own message (the previous behaviour); BM_CoalescedResponse runs
+// the chunks through ChunkCoalescer. The "messages" counter reports platform
+// messages per response.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "chunk_coalescer.h"
+#include "receive_loop.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const kFragments[] = {
+    "7E8 10 14 62 F1 90 ", "31 46 54\r7E8 21 ", "46 57 31 45 36 35\r",
+    "7E8 22 44 41 31 32 ", "33 34 35 36\r\r",    ">",
+};
+
+struct Pair {
+  Pair() {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    local = fds[0];
+    remote = fds[1];
+  }
+  ~Pair() {
+    close(local);
+    close(remote);
+  }
+  int local;
+  int remote;
+};
+
+// Writes one response fragment by fragment with a short gap between writes
+// so each fragment arrives as its own recv() chunk.
+bool WriteResponse(int fd) {
+  for (const char* fragment : kFragments) {
+    std::size_t length = std::strlen(fragment);
+    if (write(fd, fragment, length) != static_cast<ssize_t>(length)) return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  return true;
+}
+
+void WaitForResponses(const std::atomic<int>& responses, int target) {
+  while (responses.load(std::memory_order_acquire) < target) {
+  }
+}
+
+void BM_UncoalescedResponse(benchmark::State& state) {
+  Pair pair;
+  std::atomic<int> messages{0};
+  std::atomic<int> responses{0};
+  ReceiveLoop loop(
+      pair.local,
+      [&](const std::uint8_t* data, std::size_t length) {
+        messages.fetch_add(1, std::memory_order_relaxed);
+        if (std::memchr(data, '>', length)) responses.fetch_add(1, std::memory_order_release);
+      },
+      nullptr);
+  loop.Start();
+
+  int expected = 0;
+  for (auto _ : state) {
+    if (!WriteResponse(pair.remote)) state.SkipWithError("write failed");
+    WaitForResponses(responses, ++expected);
+  }
+  loop.Stop();
+  state.counters["messages"] =
+      static_cast<double>(messages.load()) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_UncoalescedResponse)->Unit(benchmark::kMicrosecond);
+
+void BM_CoalescedResponse(benchmark::State& state) {
+  Pair pair;
+  std::atomic<int> messages{0};
+  std::atomic<int> responses{0};
+  ChunkCoalescer coalescer;
+  auto flush = [&]() {
+    auto bytes = coalescer.Take();
+    messages.fetch_add(1, std::memory_order_relaxed);
+    if (std::memchr(bytes.data(), '>', bytes.size())) {
+      responses.fetch_add(1, std::memory_order_release);
+    }
+  };
+  ReceiveLoop loop(
+      pair.local,
+      [&](const std::uint8_t* data, std::size_t length) {
+        if (coalescer.Append(data, length, Clock::now())) flush();
+      },
+      nullptr);
+  loop.SetTimerHandler([&]() {
+    auto now = Clock::now();
+    if (coalescer.IsDue(now)) flush();
+    return coalescer.MillisecondsUntilDue(now);
+  });
+  loop.Start();
+
+  int expected = 0;
+  for (auto _ : state) {
+    if (!WriteResponse(pair.remote)) state.SkipWithError("write failed");
+    WaitForResponses(responses, ++expected);
+  }
+  loop.Stop();
+  state.counters["messages"] =
+      static_cast<double>(messages.load()) / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_CoalescedResponse)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
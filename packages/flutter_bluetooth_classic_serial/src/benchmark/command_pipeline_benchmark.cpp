@@ -0,0 +1,214 @@
+// PIDs/sec through a scripted adapter on a socketpair transport.
+//
+// BM_PerCommandRoundTrip reproduces the sendCommand path: every command is
+// handed from the app thread to the platform thread for the write, and its
+// framed response travels receive thread -> platform thread -> app thread
+// before the next command may be written. BM_PipelinedBatch submits the
+// same commands as one batch to the CommandPipeline, which writes each next
+// command from the receive thread as soon as the prompt arrives.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_framer.h"
+#include "native_socket.h"
+#include "receive_loop.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::vector<std::string> kPids = {"010C", "010D", "0105", "010F",
+                                        "0110", "0111", "010B", "0142"};
+
+struct Pair {
+  Pair() {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    local = fds[0];
+    remote = fds[1];
+  }
+  ~Pair() {
+    close(local);
+    if (remote >= 0) close(remote);
+  }
+  int local;
+  int remote;
+};
+
+// Answers every CR-terminated command with an echo-less Mode 01 reply, the
+// way an ELM327 does after ATE0. Exits when the link is closed.
+class ScriptedAdapter {
+ public:
+  explicit ScriptedAdapter(int socket) : thread_([this, socket]() { Run(socket); }) {}
+  ~ScriptedAdapter() { thread_.join(); }
+
+ private:
+  static void Run(int socket) {
+    char buffer[256];
+    std::string command;
+    for (;;) {
+      ssize_t received = read(socket, buffer, sizeof(buffer));
+      if (received <= 0) return;
+      for (ssize_t i = 0; i < received; ++i) {
+        if (buffer[i] != '\r') {
+          command.push_back(buffer[i]);
+          continue;
+        }
+        std::string reply = command.size() >= 4
+                                ? "4" + command.substr(1, 3) + " 1A F8\r\r>"
+                                : std::string("\r>");
+        if (write(socket, reply.data(), reply.size()) < 0) return;
+        command.clear();
+      }
+    }
+  }
+
+  std::thread thread_;
+};
+
+// Single-threaded task runner standing in for the platform thread.
+class TaskThread {
+ public:
+  TaskThread() : thread_([this]() { Run(); }) {}
+  ~TaskThread() {
+    Post(nullptr);
+    thread_.join();
+  }
+
+  void Post(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    cv_.notify_one();
+  }
+
+ private:
+  void Run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !tasks_.empty(); });
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      if (!task) return;
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::thread thread_;
+};
+
+// One-shot handoff to the waiting app thread.
+class Signal {
+ public:
+  void Notify() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++count_;
+    cv_.notify_one();
+  }
+  void WaitFor(int target) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return count_ >= target; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int count_ = 0;
+};
+
+bool WriteCommand(int socket, const std::string& data) {
+  return SendSome(socket, reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) ==
+         static_cast<int>(data.size());
+}
+
+void BM_PerCommandRoundTrip(benchmark::State& state) {
+  Pair pair;
+  ScriptedAdapter adapter(pair.remote);
+  TaskThread platform;
+  Signal answered;
+  Elm327Framer framer;
+  std::vector<ElmResponse> completed;
+
+  ReceiveLoop loop(
+      pair.local,
+      [&](const std::uint8_t* data, std::size_t length) {
+        framer.Feed(data, length, Clock::now(), &completed);
+        for (auto& response : completed) {
+          auto lines = std::make_shared<std::vector<std::string>>(std::move(response.lines));
+          platform.Post([&answered, lines]() { answered.Notify(); });
+        }
+        completed.clear();
+      },
+      nullptr);
+  loop.Start();
+
+  int expected = 0;
+  for (auto _ : state) {
+    for (const auto& pid : kPids) {
+      platform.Post([&pair, pid]() { WriteCommand(pair.local, pid + "\r"); });
+      answered.WaitFor(++expected);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kPids.size()));
+  loop.Stop();
+  shutdown(pair.local, SHUT_RDWR);
+}
+BENCHMARK(BM_PerCommandRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_PipelinedBatch(benchmark::State& state) {
+  Pair pair;
+  ScriptedAdapter adapter(pair.remote);
+  TaskThread platform;
+  Signal answered;
+  Elm327Framer framer;
+  std::vector<ElmResponse> completed;
+  CommandPipeline pipeline(
+      [&pair](const std::string& data) { return WriteCommand(pair.local, data); });
+
+  ReceiveLoop loop(
+      pair.local,
+      [&](const std::uint8_t* data, std::size_t length) {
+        framer.Feed(data, length, Clock::now(), &completed);
+        for (auto& response : completed) pipeline.OnResponse(std::move(response));
+        completed.clear();
+      },
+      nullptr);
+  loop.SetTimerHandler([&pipeline]() { return pipeline.OnTimer(Clock::now()); });
+  loop.Start();
+
+  int expected = 0;
+  for (auto _ : state) {
+    pipeline.Submit(kPids, std::chrono::milliseconds(1000),
+                    [&](std::vector<CommandResult>&& results) {
+                      auto shared = std::make_shared<std::vector<CommandResult>>(std::move(results));
+                      platform.Post([&answered, shared]() { answered.Notify(); });
+                    });
+    loop.Wake();
+    answered.WaitFor(++expected);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kPids.size()));
+  loop.Stop();
+  shutdown(pair.local, SHUT_RDWR);
+}
+BENCHMARK(BM_PipelinedBatch)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
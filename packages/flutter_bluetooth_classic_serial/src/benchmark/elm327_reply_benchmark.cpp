@@ -0,0 +1,53 @@
+// Replies/sec of AssembleElmReply on multi-ECU, multi-frame replies.
+//
+// BM_AssembleElmReply reassembles the lines of one reply per iteration:
+// Vin11 is Mode 09 02 from the ECM and TCM with their frames interleaved
+// (ATH1, 11-bit, spaces), Did29 a 43-byte Mode 22 DID from the ECM on
+// 29-bit ids without spaces, Segments the headerless "0:/1:" form of the
+// VIN, and Supported the single-frame 0100 answers of both ECUs.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "elm327_reply.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+const std::vector<std::string> kVin11 = {
+    "7E8 10 14 49 02 01 33 43 36", "7E9 10 14 49 02 01 33 43 36",
+    "7E8 21 55 52 35 46 4C 37 4B", "7E9 21 55 52 35 46 4C 37 4B",
+    "7E8 22 47 31 32 33 34 35 36", "7E9 22 47 31 32 33 34 35 36",
+};
+const std::vector<std::string> kDid29 = {
+    "18DAF110102B62F1904D3132",   "18DAF11021333435363738AA", "18DAF110223930414243444A",
+    "18DAF1102345464748494A4B", "18DAF110244C4D4E4F505152", "18DAF11025535455565758AA",
+    "18DAF11026595A5B5C000000",
+};
+const std::vector<std::string> kSegments = {
+    "014", "0: 49 02 01 33 43 36", "1: 55 52 35 46 4C 37 4B", "2: 47 31 32 33 34 35 36",
+};
+const std::vector<std::string> kSupported = {
+    "7E8 06 41 00 BE 3F A8 13",
+    "7E9 06 41 00 98 18 80 01",
+};
+
+void BM_AssembleElmReply(benchmark::State& state, const std::vector<std::string>* lines) {
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    auto messages = AssembleElmReply(*lines);
+    bytes += messages.empty() ? 0 : messages[0].bytes.size();
+    benchmark::DoNotOptimize(messages);
+  }
+  state.SetItemsProcessed(state.iterations());
+  benchmark::DoNotOptimize(bytes);
+}
+BENCHMARK_CAPTURE(BM_AssembleElmReply, Vin11, &kVin11);
+BENCHMARK_CAPTURE(BM_AssembleElmReply, Did29, &kDid29);
+BENCHMARK_CAPTURE(BM_AssembleElmReply, Segments, &kSegments);
+BENCHMARK_CAPTURE(BM_AssembleElmReply, Supported, &kSupported);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
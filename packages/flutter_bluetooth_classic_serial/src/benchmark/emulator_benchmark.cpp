@@ -0,0 +1,188 @@
+// PIDs/sec and per-command latency against the ELM327 emulator.
+//
+// BM_EmulatorPolling drives the app's init sequence and then batches of the
+// polling PIDs through the CommandPipeline, framer and receive loop to an
+// EmulatorLink on a socketpair. Arg 0 runs the Ram profile with zero ECU
+// latency, so only the host stack and the emulator are measured; arg 1
+// keeps the profile's engine/TCM reply times and jitter, so the numbers
+// track what a protocol-layer change buys on a real bus. The second arg
+// packs the PIDs into multi-PID Mode 01 requests with the Mode01Packer and
+// splits the replies, so items/s is PID samples per second either way.
+// The third arg lets ResponseCounts learn the responder count of each
+// request (warmed up outside the timing) and append it, so the adapter
+// returns at the last answer instead of waiting out its timeout.
+// p50_us and p99_us are the per-command elapsed times the pipeline reports.
+//
+// BM_TimeoutSimulation replays the captured latency traces of
+// TimeoutTraceProfile() in virtual time with a fixed ATST32 (arg 0) or
+// per-command AdaptiveTimeouts (arg 1). cycle_ms is the simulated time of
+// one pass over the poll list; no_data and replies per pass show that the
+// shorter cycle loses no answers.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_emulator.h"
+#include "elm327_framer.h"
+#include "emulator_link.h"
+#include "mode01_packer.h"
+#include "native_socket.h"
+#include "receive_loop.h"
+#include "response_counts.h"
+#include "timeout_simulation.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::vector<std::string> kInit = {"ATZ", "ATE0", "ATL0", "ATS0", "ATH1", "ATSP7", "ATST32"};
+const std::vector<std::string> kPids = {"010C", "010D", "0105", "010F",
+                                        "0110", "0104", "0149", "0142"};
+
+class BatchWaiter {
+ public:
+  void Done(std::vector<CommandResult>&& results) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_ = std::move(results);
+    done_ = true;
+    cv_.notify_one();
+  }
+  std::vector<CommandResult> Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return done_; });
+    done_ = false;
+    return std::move(results_);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<CommandResult> results_;
+  bool done_ = false;
+};
+
+void BM_EmulatorPolling(benchmark::State& state) {
+  EmulatorProfile profile = RamCumminsProfile();
+  if (state.range(0) == 0) {
+    for (auto& ecu : profile.ecus) ecu.latency = {};
+    profile.at_latency = std::chrono::microseconds(0);
+    profile.reset_latency = std::chrono::microseconds(0);
+    profile.adaptive_wait = std::chrono::microseconds(0);
+  }
+  Elm327Emulator emulator(profile);
+
+  int fds[2];
+  socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+  EmulatorLink link(&emulator);
+  std::thread server([&link, &fds]() { link.Serve(fds[1]); });
+
+  Elm327Framer framer;
+  std::vector<ElmResponse> completed;
+  CommandPipeline pipeline([&](const std::string& data) {
+    framer.ExpectEcho(data.substr(0, data.size() - 1));
+    return SendSome(fds[0], reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) ==
+           static_cast<int>(data.size());
+  });
+  ReceiveLoop loop(
+      fds[0],
+      [&](const std::uint8_t* data, std::size_t length) {
+        framer.Feed(data, length, Clock::now(), &completed);
+        for (auto& response : completed) pipeline.OnResponse(std::move(response));
+        completed.clear();
+      },
+      nullptr);
+  loop.SetTimerHandler([&pipeline]() { return pipeline.OnTimer(Clock::now()); });
+  loop.Start();
+
+  BatchWaiter waiter;
+  auto run = [&](const std::vector<std::string>& commands) {
+    pipeline.Submit(commands, std::chrono::milliseconds(1000),
+                    [&waiter](std::vector<CommandResult>&& results) {
+                      waiter.Done(std::move(results));
+                    });
+    loop.Wake();
+    return waiter.Wait();
+  };
+  ResponseCounts counts;
+  if (state.range(2) != 0) pipeline.SetResponseCounts(&counts);
+  run(kInit);
+
+  Mode01Packer packer;
+  std::vector<PollEntry> entries;
+  for (const auto& pid : kPids) entries.push_back({pid, std::chrono::milliseconds(100)});
+  std::vector<std::string> commands;
+  for (const auto& entry : packer.Pack(entries, state.range(1) != 0)) {
+    commands.push_back(entry.command);
+  }
+
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) run(commands);
+
+  std::vector<std::int64_t> latencies;
+  std::int64_t failed = 0;
+  std::vector<CommandResult> samples;
+  for (auto _ : state) {
+    for (auto& result : run(commands)) {
+      latencies.push_back(result.elapsed.count());
+      samples.clear();
+      if (packer.Split(std::move(result), &samples) == Mode01Packer::SplitOutcome::kPassThrough) {
+        samples.push_back(std::move(result));
+      }
+      for (const auto& sample : samples) {
+        if (sample.status != CommandResult::Status::kOk || sample.lines.empty() ||
+            sample.lines[0] == "NO DATA") {
+          ++failed;
+        }
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kPids.size()));
+  std::sort(latencies.begin(), latencies.end());
+  if (!latencies.empty()) {
+    state.counters["p50_us"] = static_cast<double>(latencies[latencies.size() / 2]);
+    state.counters["p99_us"] = static_cast<double>(latencies[latencies.size() * 99 / 100]);
+  }
+  state.counters["failed"] = static_cast<double>(failed);
+
+  loop.Stop();
+  link.Stop();
+  server.join();
+  shutdown(fds[0], SHUT_RDWR);
+  close(fds[0]);
+  close(fds[1]);
+}
+BENCHMARK(BM_EmulatorPolling)
+    ->ArgsProduct({{0, 1}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_TimeoutSimulation(benchmark::State& state) {
+  const EmulatorProfile profile = TimeoutTraceProfile();
+  const std::vector<std::string> commands = TimeoutTraceCommands();
+  TimeoutSimulationOptions options;
+  options.adaptive = state.range(0) != 0;
+  TimeoutSimulationResult result;
+  for (auto _ : state) {
+    result = SimulateTimeouts(profile, commands, options);
+    benchmark::DoNotOptimize(result);
+  }
+  const double cycles = static_cast<double>(result.cycles);
+  state.counters["cycle_ms"] = static_cast<double>(result.mean_cycle.count()) / 1000.0;
+  state.counters["no_data"] = static_cast<double>(result.no_data) / cycles;
+  state.counters["replies"] = static_cast<double>(result.replies) / cycles;
+  state.counters["atst_changes"] =
+      static_cast<double>(result.atst_changes) / static_cast<double>(options.cycles);
+}
+BENCHMARK(BM_TimeoutSimulation)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,126 @@
+// Frames/sec of the J1939 monitor decoder.
+//
+// BM_J1939MonitorFeed feeds one second of a loaded 500k bus as the adapter
+// prints it in monitor mode (ATH1, spaces off for arg 0, on for arg 1) in
+// 64-byte reads: the broadcast PGNs of kSpnTable at their J1939-71 rates
+// (EEC1 every 10 ms ... AMB every second) plus the engine's and
+// transmission's other and proprietary PGNs, about 2,500 frames in all.
+// items/s is frames decoded per second of CPU, against the bus's 2,500 per
+// second of wall time. The second arg adds four ECUs broadcasting a DM1 of
+// 20 faults each (BAM, 12 packets 50 ms apart) for J1939Transport to
+// reassemble; dm1s is the DM1s completed per bus second and tp_errors the
+// sessions lost.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "j1939_monitor.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+struct Broadcast {
+  std::uint32_t can_id;
+  int period_ms;
+};
+
+constexpr Broadcast kBus[] = {
+    {0x0CF00400, 10},   {0x0CF00300, 50},   {0x18F00503, 100},  {0x18FEEE00, 1000},
+    {0x18FEEF00, 500},  {0x18FEF100, 100},  {0x18FEF200, 100},  {0x18FEF500, 1000},
+    {0x18FEF600, 500},  {0x18FEF700, 1000}, {0x18FEFC17, 1000}, {0x18FEE500, 1000},
+    // Not decoded: TSC1, ERC1, EBC1, ETC1, aftertreatment and proprietary
+    {0x0C000003, 10},   {0x18F00010, 100},  {0x18F0010B, 100},  {0x0CF00203, 10},
+    {0x18FD7C00, 100},  {0x18FF0000, 20},   {0x18FF0103, 20},   {0x0CFF0200, 5},
+    {0x0CFF0300, 5},    {0x0CFF0400, 5},    {0x0CFF0500, 5},    {0x0CFF0603, 5},
+    {0x0CFF0703, 5},    {0x0CFF0810, 5},    {0x0CFF090B, 5},    {0x18FF1000, 10},
+    {0x18FF1100, 10},   {0x18FF1203, 10},   {0x18FF1303, 10},
+};
+
+// ECUs that broadcast a DM1 of kDm1Faults faults every second, by BAM
+constexpr std::uint8_t kDm1Sources[] = {0x00, 0x03, 0x0B, 0x17};
+constexpr unsigned kDm1Faults = 20;
+constexpr unsigned kDm1Size = 2 + 4 * kDm1Faults;
+constexpr unsigned kDm1Packets = (kDm1Size + 6) / 7;
+
+void AddFrame(std::string* text, bool spaces, std::uint32_t can_id, const unsigned bytes[8]) {
+  char line[64];
+  const char* format = spaces ? "%02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X\r"
+                              : "%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\r";
+  std::snprintf(line, sizeof(line), format, can_id >> 24, (can_id >> 16) & 0xFF,
+                (can_id >> 8) & 0xFF, can_id & 0xFF, bytes[0], bytes[1], bytes[2], bytes[3],
+                bytes[4], bytes[5], bytes[6], bytes[7]);
+  *text += line;
+}
+
+std::string BusSecond(bool spaces, bool dm1) {
+  std::string text;
+  for (int ms = 0; ms < 1000; ++ms) {
+    for (const auto& broadcast : kBus) {
+      if (ms % broadcast.period_ms != 0) continue;
+      const auto seed = static_cast<unsigned>(ms + broadcast.can_id);
+      const unsigned bytes[8] = {seed & 0x7F, 0x7D, (seed >> 3) & 0xFF, 0xF0, 0x35, 0x2E, 0x5A,
+                                 0xFF};
+      AddFrame(&text, spaces, broadcast.can_id, bytes);
+    }
+    if (!dm1) continue;
+    // Each ECU announces its DM1 and sends a packet every 50 ms
+    for (std::size_t i = 0; i < sizeof(kDm1Sources); ++i) {
+      const int since = ms - static_cast<int>(i) * 10;
+      if (since < 0 || since % 50 != 0 || since / 50 > static_cast<int>(kDm1Packets)) continue;
+      const std::uint32_t source = kDm1Sources[i];
+      const unsigned packet = static_cast<unsigned>(since / 50);
+      if (packet == 0) {
+        const unsigned bam[8] = {0x20, kDm1Size, 0x00, kDm1Packets, 0xFF, 0xCA, 0xFE, 0x00};
+        AddFrame(&text, spaces, 0x1CECFF00 | source, bam);
+        continue;
+      }
+      // Lamps, then SPN 100 + n FMI n % 32 seen n times
+      unsigned bytes[8] = {packet};
+      for (unsigned k = 0; k < 7; ++k) {
+        const unsigned offset = (packet - 1) * 7 + k;
+        const unsigned fault = (offset - 2) / 4;
+        unsigned byte = 0xFF;
+        if (offset == 0) {
+          byte = 0x44;
+        } else if (offset >= 2 && offset < kDm1Size) {
+          const unsigned field[4] = {100 + fault, 0, fault % 32, fault + 1};
+          byte = field[(offset - 2) % 4];
+        }
+        bytes[k + 1] = byte;
+      }
+      AddFrame(&text, spaces, 0x1CEBFF00 | source, bytes);
+    }
+  }
+  return text;
+}
+
+void BM_J1939MonitorFeed(benchmark::State& state) {
+  const std::string text = BusSecond(state.range(0) != 0, state.range(1) != 0);
+  const auto* data = reinterpret_cast<const std::uint8_t*>(text.data());
+  J1939Monitor monitor;
+  const auto now = J1939Monitor::Clock::now();
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < text.size(); i += 64) {
+      monitor.Feed(data + i, std::min<std::size_t>(64, text.size() - i), now);
+    }
+  }
+  const J1939MonitorCounters counters = monitor.counters();
+  state.SetItemsProcessed(static_cast<std::int64_t>(counters.frames));
+  state.SetBytesProcessed(static_cast<std::int64_t>(text.size() * state.iterations()));
+  state.counters["bus_frames"] =
+      static_cast<double>(counters.frames) / static_cast<double>(state.iterations());
+  state.counters["decoded"] =
+      static_cast<double>(counters.decoded) / static_cast<double>(counters.frames);
+  state.counters["dm1s"] = static_cast<double>(counters.transport.messages) /
+                           static_cast<double>(state.iterations());
+  state.counters["tp_errors"] = static_cast<double>(
+      counters.transport.sequence_errors + counters.transport.timeouts + counters.transport.aborts);
+}
+BENCHMARK(BM_J1939MonitorFeed)->ArgsProduct({{0, 1}, {0, 1}});
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
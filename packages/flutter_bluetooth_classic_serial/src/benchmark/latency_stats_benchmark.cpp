@@ -0,0 +1,59 @@
+// Cost of leaving latency stats on.
+//
+// BM_HistogramRecord is one histogram sample. BM_RecordCommand is what the
+// pipeline adds to every completed command: the command lookup, the outcome
+// count and three phase samples. BM_Snapshot is one getStats call over a
+// typical polling set of 24 commands.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "latency_stats.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using std::chrono::microseconds;
+
+void BM_HistogramRecord(benchmark::State& state) {
+  LatencyHistogram histogram;
+  std::int64_t value = 0;
+  for (auto _ : state) {
+    histogram.Record(microseconds(20000 + (value++ & 0x3FFF)));
+  }
+  benchmark::DoNotOptimize(histogram.count());
+}
+BENCHMARK(BM_HistogramRecord);
+
+void BM_RecordCommand(benchmark::State& state) {
+  LinkStats stats;
+  const std::vector<std::string> commands = {"010C", "010D", "0105", "010F",
+                                             "0110", "0111", "010B", "0142"};
+  std::size_t next = 0;
+  for (auto _ : state) {
+    CommandStats* command = stats.ForCommand(commands[next++ % commands.size()]);
+    command->completed.fetch_add(1, std::memory_order_relaxed);
+    command->Record(LatencyPhase::kFirstByte, microseconds(24000));
+    command->Record(LatencyPhase::kPrompt, microseconds(21000));
+    command->Record(LatencyPhase::kRoundTrip, microseconds(45000));
+  }
+}
+BENCHMARK(BM_RecordCommand);
+
+void BM_Snapshot(benchmark::State& state) {
+  LinkStats stats;
+  for (int i = 0; i < 24; ++i) {
+    CommandStats* command = stats.ForCommand("01" + std::to_string(10 + i));
+    for (int j = 0; j < 1000; ++j) command->Record(LatencyPhase::kRoundTrip, microseconds(j * 50));
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(stats.Snapshot());
+  }
+}
+BENCHMARK(BM_Snapshot)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,134 @@
+// Responses/sec of the native OBD-II parser.
+//
+// BM_StringPassesBaseline follows lib/services/obd2_parser.dart step by
+// step (replaceAll/toUpperCase/split copies, a regex per line, substring +
+// parse per byte) as the reference point. The native parser normalises the
+// framed buffer in place and decodes with DecodeHex.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "hex_decode.h"
+#include "obd2_parser.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+const char kSingleEcu[] = "41 0C 1A F8\r\r>";
+const char kMultiEcu[] = "7E9 03 7F 01 12\r7E8 04 41 0C 1A F8\r\r>";
+const char kLongMode22[] =
+    "7E8 10 14 62 F1 90 31 46\r7E8 21 54 46 57 31 45 54 35\r7E8 22 44 46 41 31 32 33 34\r\r>";
+
+std::string ReplaceAll(std::string text, const std::string& from, const std::string& to) {
+  std::string out;
+  std::size_t pos = 0;
+  for (std::size_t found; (found = text.find(from, pos)) != std::string::npos;
+       pos = found + from.size()) {
+    out.append(text, pos, found - pos).append(to);
+  }
+  return out.append(text, pos, std::string::npos);
+}
+
+std::string Trim(const std::string& text) {
+  std::size_t begin = text.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos) return std::string();
+  return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+bool BaselineParse(const std::string& raw, const std::string& header, std::vector<int>* bytes) {
+  static const std::regex kPositive("4[1-9A-F][0-9A-F]{2}");
+  static const char* kErrors[] = {"NO DATA", "UNABLE TO CONNECT", "BUS INIT", "BUS ERROR",
+                                  "CAN ERROR", "FB ERROR", "DATA ERROR", "BUFFER FULL",
+                                  "ACT ALERT", "LV RESET", "STOPPED", "ERROR", "?"};
+  std::string cleaned = Trim(ReplaceAll(ReplaceAll(raw, "\r", "\n"), ">", ""));
+  std::transform(cleaned.begin(), cleaned.end(), cleaned.begin(), ::toupper);
+  for (const char* error : kErrors) {
+    if (cleaned.find(error) != std::string::npos) return false;
+  }
+
+  std::vector<std::string> lines;
+  std::size_t pos = 0;
+  while (pos <= cleaned.size()) {
+    std::size_t end = cleaned.find('\n', pos);
+    if (end == std::string::npos) end = cleaned.size();
+    std::string line = Trim(cleaned.substr(pos, end - pos));
+    pos = end + 1;
+    if (line.empty()) continue;
+    std::string hex = ReplaceAll(line, " ", "");
+    if (hex.find("7F") != std::string::npos && !std::regex_search(hex, kPositive)) continue;
+    lines.push_back(line);
+  }
+
+  for (const auto& line : lines) {
+    std::string hex = ReplaceAll(line, " ", "");
+    std::size_t index = hex.find(header);
+    if (index == std::string::npos) continue;
+    std::string data = hex.substr(index + header.size());
+    bytes->clear();
+    for (std::size_t i = 0; i + 1 < data.size(); i += 2) {
+      bytes->push_back(std::stoi(data.substr(i, 2), nullptr, 16));
+    }
+    if (!bytes->empty()) return true;
+  }
+  return false;
+}
+
+void BM_StringPassesBaseline(benchmark::State& state, const char* response, const char* header) {
+  std::string raw = response;
+  std::vector<int> bytes;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BaselineParse(raw, header, &bytes));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_StringPassesBaseline, SingleEcu, kSingleEcu, "410C");
+BENCHMARK_CAPTURE(BM_StringPassesBaseline, MultiEcu, kMultiEcu, "410C");
+BENCHMARK_CAPTURE(BM_StringPassesBaseline, LongMode22, kLongMode22, "62F190");
+
+void BM_NativeObd2(benchmark::State& state, const char* response) {
+  const std::size_t length = std::strlen(response);
+  char buffer[256];
+  std::uint8_t out[64];
+  for (auto _ : state) {
+    // The parser works in place, so every iteration starts from a fresh copy
+    std::memcpy(buffer, response, length);
+    benchmark::DoNotOptimize(ParseObd2Response(buffer, length, 0x0C, out, sizeof(out)));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_NativeObd2, SingleEcu, kSingleEcu);
+BENCHMARK_CAPTURE(BM_NativeObd2, MultiEcu, kMultiEcu);
+
+void BM_NativeMode22Long(benchmark::State& state) {
+  const std::size_t length = std::strlen(kLongMode22);
+  char buffer[256];
+  std::uint8_t out[64];
+  for (auto _ : state) {
+    std::memcpy(buffer, kLongMode22, length);
+    benchmark::DoNotOptimize(ParseMode22Response(buffer, length, 0xF190, out, sizeof(out)));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NativeMode22Long);
+
+template <std::size_t (*Decode)(const char*, std::size_t, std::uint8_t*)>
+void BM_DecodeHex(benchmark::State& state) {
+  std::string hex;
+  for (int i = 0; i < state.range(0); ++i) hex += "1A";
+  std::vector<std::uint8_t> out(hex.size() / 2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Decode(hex.data(), hex.size(), out.data()));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(hex.size()));
+}
+BENCHMARK_TEMPLATE(BM_DecodeHex, DecodeHex)->Arg(8)->Arg(64);
+BENCHMARK_TEMPLATE(BM_DecodeHex, DecodeHexScalar)->Arg(8)->Arg(64);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
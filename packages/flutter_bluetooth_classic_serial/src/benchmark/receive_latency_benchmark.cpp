@@ -0,0 +1,92 @@
+// Write-to-delivery latency of the receive path on a socketpair transport.
+//
+// BM_ReactorFirstByte measures the event-driven ReceiveLoop. BM_SleepPollFirstByte
+// reproduces the previous DataListeningThread (non-blocking recv + 10 ms sleep)
+// as the baseline.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "native_socket.h"
+#include "receive_loop.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Pair {
+  Pair() {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    local = fds[0];
+    remote = fds[1];
+  }
+  ~Pair() {
+    close(local);
+    close(remote);
+  }
+  int local;
+  int remote;
+};
+
+void WaitForCount(const std::atomic<int>& counter, int target) {
+  while (counter.load(std::memory_order_acquire) < target) {
+  }
+}
+
+void BM_ReactorFirstByte(benchmark::State& state) {
+  Pair pair;
+  std::atomic<int> delivered{0};
+  ReceiveLoop loop(
+      pair.local,
+      [&delivered](const std::uint8_t*, std::size_t length) {
+        delivered.fetch_add(static_cast<int>(length), std::memory_order_release);
+      },
+      nullptr);
+  loop.Start();
+
+  int expected = 0;
+  for (auto _ : state) {
+    auto start = Clock::now();
+    if (write(pair.remote, ">", 1) != 1) state.SkipWithError("write failed");
+    WaitForCount(delivered, ++expected);
+    state.SetIterationTime(std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  loop.Stop();
+}
+BENCHMARK(BM_ReactorFirstByte)->UseManualTime()->Unit(benchmark::kMicrosecond);
+
+void BM_SleepPollFirstByte(benchmark::State& state) {
+  Pair pair;
+  SetNonBlocking(pair.local, true);
+  std::atomic<int> delivered{0};
+  std::atomic<bool> stop{false};
+  std::thread poller([&]() {
+    std::uint8_t buffer[1024];
+    while (!stop.load(std::memory_order_acquire)) {
+      int received = ReceiveSome(pair.local, buffer, sizeof(buffer));
+      if (received > 0) delivered.fetch_add(received, std::memory_order_release);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+
+  int expected = 0;
+  for (auto _ : state) {
+    auto start = Clock::now();
+    if (write(pair.remote, ">", 1) != 1) state.SkipWithError("write failed");
+    WaitForCount(delivered, ++expected);
+    state.SetIterationTime(std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  stop.store(true, std::memory_order_release);
+  poller.join();
+}
+BENCHMARK(BM_SleepPollFirstByte)->UseManualTime()->Unit(benchmark::kMicrosecond)->Iterations(50);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,55 @@
+// Cost of tracing one received chunk on the I/O thread.
+//
+// BM_FormatDebugString is the previous per-recv logging minus the
+// OutputDebugStringA call itself: a std::string of up to 50 printable
+// characters and [nn] escapes built for every chunk. BM_TraceRingRecord
+// stores the same chunk as a binary TraceRing event. BM_TraceRingRecord/4
+// runs four threads recording into one ring at once.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "trace_ring.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+// A typical RFCOMM chunk: one ELM327 reply with its prompt.
+const std::string kChunk = "7E8 06 41 0C 1A F8 00 00\r7E9 06 41 0C 1A F0 00 00\r\r>";
+const std::string kAddress = "00:1D:A5:68:98:8B";
+
+void BM_FormatDebugString(benchmark::State& state) {
+  const char* buffer = kChunk.data();
+  const int bytes_received = static_cast<int>(kChunk.size());
+  for (auto _ : state) {
+    std::string message =
+        "Received " + std::to_string(bytes_received) + " bytes from " + kAddress + ": ";
+    int max_chars = bytes_received < 50 ? bytes_received : 50;
+    for (int j = 0; j < max_chars; j++) {
+      if (buffer[j] >= 32 && buffer[j] <= 126) {
+        message += buffer[j];
+      } else {
+        message += "[" + std::to_string((unsigned char)buffer[j]) + "]";
+      }
+    }
+    if (bytes_received > 50) message += "...";
+    message += "\n";
+    benchmark::DoNotOptimize(message.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FormatDebugString);
+
+void BM_TraceRingRecord(benchmark::State& state) {
+  static TraceRing ring(4096);
+  for (auto _ : state) {
+    ring.Record<TraceLevel::kDebug>(TraceKind::kRecv, 1, static_cast<std::int64_t>(kChunk.size()),
+                                    0, kChunk.data(), kChunk.size());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceRingRecord)->Threads(1)->Threads(4);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,136 @@
+// Wire capture cost and replay throughput.
+//
+// BM_CaptureRecord is what capture mode adds to each chunk on the I/O
+// thread: one WireCaptureWriter::Record() of a typical adapter reply.
+// BM_ReplayUnthrottled replays a drive through the receive loop, framer and
+// command pipeline as fast as they take it; items are commands. It uses the
+// capture named by the WIRE_CAPTURE environment variable if set (for
+// example a recorded drive), otherwise a synthetic 200-command Mode 01
+// session.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_framer.h"
+#include "receive_loop.h"
+#include "wire_capture.h"
+#include "wire_replay.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::string kReply = "7E8 06 41 0C 1A F8 00 00\r7E9 06 41 0C 1A F0 00 00\r\r>";
+
+WireCapture SyntheticDrive() {
+  const std::vector<std::string> pids = {"010C", "010D", "0105", "010F", "0110", "0142"};
+  WireCapture capture;
+  capture.label = "synthetic";
+  std::chrono::microseconds at{0};
+  for (int i = 0; i < 200; ++i) {
+    const std::string& pid = pids[i % pids.size()];
+    capture.records.push_back({at, WireDirection::kSent, pid + "\r"});
+    at += std::chrono::microseconds(45000);
+    capture.records.push_back({at, WireDirection::kReceived, "4" + pid.substr(1) + " 1A F8\r\r>"});
+  }
+  return capture;
+}
+
+WireCapture LoadDrive() {
+  WireCapture capture;
+  const char* path = std::getenv("WIRE_CAPTURE");
+  if (path != nullptr && ReadWireCapture(path, &capture)) return capture;
+  return SyntheticDrive();
+}
+
+void BM_CaptureRecord(benchmark::State& state) {
+  const std::string path = "/tmp/wire_replay_benchmark.ccwire";
+  WireCaptureWriter writer;
+  if (!writer.Open(path, "benchmark")) {
+    state.SkipWithError("cannot open capture file");
+    return;
+  }
+  for (auto _ : state) {
+    writer.Record(WireDirection::kReceived, kReply.data(), kReply.size());
+  }
+  state.SetItemsProcessed(state.iterations());
+  writer.Close();
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_CaptureRecord);
+
+void BM_ReplayUnthrottled(benchmark::State& state) {
+  const WireCapture capture = LoadDrive();
+  ReplayOptions options;
+  options.speed = 0;
+  std::vector<std::string> commands;
+  for (const auto& step : BuildReplayScript(capture)) {
+    if (step.expects_command) commands.push_back(step.command);
+  }
+
+  for (auto _ : state) {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    WireReplay replay(capture, options);
+    ReplayReport report;
+    std::thread adapter([&]() { report = replay.Run(fds[1]); });
+
+    Elm327Framer framer;
+    std::vector<ElmResponse> completed;
+    CommandPipeline pipeline([&fds](const std::string& data) {
+      return SendSome(fds[0], reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) ==
+             static_cast<int>(data.size());
+    });
+    ReceiveLoop loop(
+        fds[0],
+        [&](const std::uint8_t* data, std::size_t length) {
+          framer.Feed(data, length, Clock::now(), &completed);
+          for (auto& response : completed) pipeline.OnResponse(std::move(response));
+          completed.clear();
+        },
+        nullptr);
+    loop.SetTimerHandler([&pipeline]() { return pipeline.OnTimer(Clock::now()); });
+    loop.Start();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    pipeline.Submit(commands, std::chrono::milliseconds(1000),
+                    [&](std::vector<CommandResult>&&) {
+                      std::lock_guard<std::mutex> lock(mutex);
+                      done = true;
+                      cv.notify_one();
+                    });
+    loop.Wake();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait_for(lock, std::chrono::seconds(30), [&]() { return done; });
+    }
+    loop.Stop();
+    shutdown(fds[0], SHUT_RDWR);
+    adapter.join();
+    close(fds[0]);
+    close(fds[1]);
+    if (!report.divergences.empty()) {
+      state.SkipWithError("replay diverged from the capture");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(commands.size()));
+}
+BENCHMARK(BM_ReplayUnthrottled)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
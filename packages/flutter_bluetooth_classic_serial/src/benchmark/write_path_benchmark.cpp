@@ -0,0 +1,132 @@
+// Commands/sec and send syscalls per command on a socketpair transport.
+//
+// BM_BoxedListSend reproduces the old writeData path: the command arrives as
+// a list of boxed ints, is copied byte by byte into a shared buffer and
+// goes out with one send() per command. BM_WriteQueueDirect writes the
+// Uint8List bytes through the WriteQueue from the caller's buffer.
+// BM_WriteQueueCoalesced/N issues N commands back to back while corked, so
+// they leave in one gather send.
+//
+// The remote side is drained on the benchmark thread between batches, so
+// the numbers are the write path alone.
+
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "native_socket.h"
+#include "write_queue.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+const std::vector<std::string> kCommands = {"010C\r", "010D\r", "0105\r", "010F\r",
+                                            "0110\r", "0111\r", "010B\r", "22A09F\r"};
+
+// Stand-in for flutter::EncodableValue holding an int.
+using BoxedByte = std::variant<std::monostate, bool, int, std::string>;
+
+struct Pair {
+  Pair() {
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    local = fds[0];
+    remote = fds[1];
+    SetNonBlocking(local, true);
+  }
+  ~Pair() {
+    close(local);
+    close(remote);
+  }
+  void Drain() {
+    char buffer[65536];
+    while (recv(remote, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+    }
+  }
+  int local;
+  int remote;
+};
+
+constexpr int kDrainEvery = 64;
+
+void BM_BoxedListSend(benchmark::State& state) {
+  Pair pair;
+  std::vector<std::vector<BoxedByte>> boxed;
+  for (const auto& command : kCommands) {
+    std::vector<BoxedByte> list;
+    for (char c : command) list.emplace_back(static_cast<int>(c));
+    boxed.push_back(std::move(list));
+  }
+
+  static std::vector<char> byte_buffer;
+  std::size_t next = 0;
+  std::int64_t commands = 0;
+  for (auto _ : state) {
+    const auto& list = boxed[next++ % boxed.size()];
+    byte_buffer.clear();
+    byte_buffer.reserve(list.size());
+    for (const auto& value : list) {
+      if (const auto* byte = std::get_if<int>(&value)) {
+        byte_buffer.push_back(static_cast<char>(*byte));
+      }
+    }
+    benchmark::DoNotOptimize(send(pair.local, byte_buffer.data(), byte_buffer.size(), 0));
+    if (++commands % kDrainEvery == 0) pair.Drain();
+  }
+  state.SetItemsProcessed(commands);
+  state.counters["syscalls_per_command"] = 1.0;
+}
+BENCHMARK(BM_BoxedListSend);
+
+void BM_WriteQueueDirect(benchmark::State& state) {
+  Pair pair;
+  std::vector<std::vector<std::uint8_t>> bytes;
+  for (const auto& command : kCommands) bytes.emplace_back(command.begin(), command.end());
+
+  WriteQueue queue;
+  queue.Reset(pair.local);
+  std::size_t next = 0;
+  std::int64_t commands = 0;
+  for (auto _ : state) {
+    const auto& command = bytes[next++ % bytes.size()];
+    benchmark::DoNotOptimize(queue.Write(command.data(), command.size()));
+    if (++commands % kDrainEvery == 0) pair.Drain();
+  }
+  state.SetItemsProcessed(commands);
+  state.counters["syscalls_per_command"] =
+      static_cast<double>(queue.stats().send_calls) / static_cast<double>(commands);
+}
+BENCHMARK(BM_WriteQueueDirect);
+
+void BM_WriteQueueCoalesced(benchmark::State& state) {
+  const auto batch = static_cast<std::size_t>(state.range(0));
+  Pair pair;
+  std::vector<std::vector<std::uint8_t>> bytes;
+  for (const auto& command : kCommands) bytes.emplace_back(command.begin(), command.end());
+
+  WriteQueue queue;
+  queue.Reset(pair.local);
+  std::int64_t commands = 0;
+  for (auto _ : state) {
+    queue.Cork();
+    for (std::size_t i = 0; i < batch; ++i) {
+      const auto& command = bytes[i % bytes.size()];
+      queue.Write(command.data(), command.size());
+    }
+    benchmark::DoNotOptimize(queue.Uncork());
+    commands += static_cast<std::int64_t>(batch);
+    pair.Drain();
+  }
+  state.SetItemsProcessed(commands);
+  state.counters["syscalls_per_command"] =
+      static_cast<double>(queue.stats().send_calls) / static_cast<double>(commands);
+}
+BENCHMARK(BM_WriteQueueCoalesced)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,90 @@
+#include "byte_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+ByteRing::ByteRing(std::size_t min_capacity)
+    : capacity_(RoundUpToPowerOfTwo(min_capacity > 0 ? min_capacity : 1)),
+      mask_(capacity_ - 1) {
+  buffer_.reset(new std::uint8_t[capacity_]);
+}
+
+std::size_t ByteRing::Write(const std::uint8_t* data, std::size_t length) {
+  std::size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+  std::size_t read_pos = read_pos_.load(std::memory_order_acquire);
+  std::size_t space = capacity_ - (write_pos - read_pos);
+
+  std::size_t count = std::min(length, space);
+  if (count < length) {
+    dropped_bytes_.fetch_add(length - count, std::memory_order_relaxed);
+    overflow_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (count == 0) return 0;
+
+  std::size_t offset = write_pos & mask_;
+  std::size_t first = std::min(count, capacity_ - offset);
+  std::memcpy(buffer_.get() + offset, data, first);
+  std::memcpy(buffer_.get(), data + first, count - first);
+
+  write_pos_.store(write_pos + count, std::memory_order_release);
+  return count;
+}
+
+std::size_t ByteRing::Space() const {
+  return capacity_ - (write_pos_.load(std::memory_order_relaxed) -
+                      read_pos_.load(std::memory_order_acquire));
+}
+
+std::size_t ByteRing::Available() const {
+  return write_pos_.load(std::memory_order_acquire) -
+         read_pos_.load(std::memory_order_relaxed);
+}
+
+int ByteRing::Peek(Region regions[2]) const {
+  std::size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  std::size_t available = write_pos_.load(std::memory_order_acquire) - read_pos;
+  if (available == 0) return 0;
+
+  std::size_t offset = read_pos & mask_;
+  std::size_t first = std::min(available, capacity_ - offset);
+  regions[0].data = buffer_.get() + offset;
+  regions[0].size = first;
+  if (first == available) return 1;
+
+  regions[1].data = buffer_.get();
+  regions[1].size = available - first;
+  return 2;
+}
+
+void ByteRing::Consume(std::size_t length) {
+  std::size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+  std::size_t available = write_pos_.load(std::memory_order_acquire) - read_pos;
+  read_pos_.store(read_pos + std::min(length, available), std::memory_order_release);
+}
+
+std::size_t ByteRing::Read(std::uint8_t* out, std::size_t length) {
+  Region regions[2];
+  int count = Peek(regions);
+  std::size_t copied = 0;
+  for (int i = 0; i < count && copied < length; ++i) {
+    std::size_t n = std::min(regions[i].size, length - copied);
+    std::memcpy(out + copied, regions[i].data, n);
+    copied += n;
+  }
+  Consume(copied);
+  return copied;
+}
+
+}  // namespace flutter_bluetooth_classic
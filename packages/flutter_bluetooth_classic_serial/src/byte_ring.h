@@ -0,0 +1,91 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_BYTE_RING_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_BYTE_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace flutter_bluetooth_classic {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324)  // padded due to alignment specifier
+#endif
+
+// Fixed-capacity single-producer/single-consumer byte ring.
+//
+// One receive thread writes and one reader (the platform thread) reads; no
+// lock is taken on either side. The producer never overwrites unread data:
+// bytes that do not fit are dropped and counted, so a stalled reader shows
+// up in the overflow counters instead of as silent corruption.
+class ByteRing {
+ public:
+  // A contiguous readable region. Readable data spans at most two regions
+  // because it may wrap around the end of the buffer.
+  struct Region {
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+  };
+
+  // Capacity is rounded up to a power of two.
+  explicit ByteRing(std::size_t min_capacity);
+
+  ByteRing(const ByteRing&) = delete;
+  ByteRing& operator=(const ByteRing&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+  // --- Producer side ---
+
+  // Copies as much of |data| as fits and returns the number of bytes
+  // written. The rest is dropped and added to the overflow counters.
+  std::size_t Write(const std::uint8_t* data, std::size_t length);
+
+  // Bytes that can be written without dropping any.
+  std::size_t Space() const;
+
+  // --- Consumer side ---
+
+  std::size_t Available() const;
+
+  // Fills |regions| with a zero-copy view of the readable bytes and returns
+  // how many regions are used (0-2). The view stays valid until Consume().
+  int Peek(Region regions[2]) const;
+
+  // Releases the first |length| readable bytes back to the producer.
+  void Consume(std::size_t length);
+
+  // Copies up to |length| bytes into |out| and consumes them.
+  std::size_t Read(std::uint8_t* out, std::size_t length);
+
+  // Consumes everything currently readable.
+  void Clear() { Consume(Available()); }
+
+  // --- Overflow accounting (any thread) ---
+
+  std::uint64_t dropped_bytes() const { return dropped_bytes_.load(std::memory_order_relaxed); }
+  // Number of Write() calls that dropped at least one byte.
+  std::uint64_t overflow_count() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+ private:
+  std::unique_ptr<std::uint8_t[]> buffer_;
+  std::size_t capacity_;
+  std::size_t mask_;
+
+  // Free-running positions; the difference is the readable size. Each is
+  // written by one side only and kept on its own cache line.
+  alignas(64) std::atomic<std::size_t> write_pos_{0};
+  alignas(64) std::atomic<std::size_t> read_pos_{0};
+
+  alignas(64) std::atomic<std::uint64_t> dropped_bytes_{0};
+  std::atomic<std::uint64_t> overflow_count_{0};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_BYTE_RING_H_
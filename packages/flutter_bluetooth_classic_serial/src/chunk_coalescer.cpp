@@ -0,0 +1,59 @@
+#include "chunk_coalescer.h"
+
+#include <cstring>
+
+namespace flutter_bluetooth_classic {
+
+CoalescingWindow::CoalescingWindow(CoalescingOptions options) : options_(options) {}
+
+bool CoalescingWindow::Add(const std::uint8_t* data, std::size_t length,
+                           Clock::time_point now) {
+  if (length == 0) return IsDue(now);
+  if (pending_ == 0) first_byte_at_ = now;
+  pending_ += length;
+
+  if (options_.flush_byte >= 0 && !flush_byte_seen_) {
+    flush_byte_seen_ =
+        std::memchr(data, options_.flush_byte, length) != nullptr;
+  }
+  return IsDue(now);
+}
+
+bool CoalescingWindow::IsDue(Clock::time_point now) const {
+  if (pending_ == 0) return false;
+  if (flush_byte_seen_) return true;
+  if (pending_ >= options_.max_bytes) return true;
+  return now - first_byte_at_ >= options_.window;
+}
+
+int CoalescingWindow::MillisecondsUntilDue(Clock::time_point now) const {
+  if (pending_ == 0) return -1;
+  if (IsDue(now)) return 0;
+  auto remaining = options_.window - (now - first_byte_at_);
+  // Round up so the wait never ends just before the window closes.
+  auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+  return ms > 0 ? static_cast<int>(ms) : 0;
+}
+
+void CoalescingWindow::Reset() {
+  pending_ = 0;
+  flush_byte_seen_ = false;
+}
+
+ChunkCoalescer::ChunkCoalescer(CoalescingOptions options) : window_(options) {}
+
+bool ChunkCoalescer::Append(const std::uint8_t* data, std::size_t length,
+                            Clock::time_point now) {
+  buffer_.insert(buffer_.end(), data, data + length);
+  return window_.Add(data, length, now);
+}
+
+std::vector<std::uint8_t> ChunkCoalescer::Take() {
+  std::vector<std::uint8_t> out;
+  out.swap(buffer_);
+  buffer_.reserve(out.capacity());
+  window_.Reset();
+  return out;
+}
+
+}  // namespace flutter_bluetooth_classic
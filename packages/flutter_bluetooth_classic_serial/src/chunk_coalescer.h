@@ -0,0 +1,94 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_CHUNK_COALESCER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_CHUNK_COALESCER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+struct CoalescingOptions {
+  // Longest time the oldest buffered byte may wait before it is delivered.
+  std::chrono::milliseconds window{20};
+  // Deliver as soon as this many bytes are buffered.
+  std::size_t max_bytes = 4096;
+  // Deliver immediately when this byte arrives (the ELM327 '>' prompt ends
+  // every response); -1 disables.
+  int flush_byte = '>';
+};
+
+// Decides when buffered receive data is due for delivery, without holding
+// the bytes itself. Used directly when the bytes live elsewhere (e.g. in a
+// ByteRing) and through ChunkCoalescer otherwise. Not thread-safe.
+class CoalescingWindow {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit CoalescingWindow(CoalescingOptions options = CoalescingOptions());
+
+  const CoalescingOptions& options() const { return options_; }
+  void set_options(const CoalescingOptions& options) { options_ = options; }
+
+  // Accounts for |length| newly buffered bytes. Returns true if a flush is
+  // due right away (size limit or flush byte reached).
+  bool Add(const std::uint8_t* data, std::size_t length, Clock::time_point now);
+
+  bool IsDue(Clock::time_point now) const;
+
+  // Milliseconds until the window closes: -1 if nothing is pending, 0 if a
+  // flush is already due.
+  int MillisecondsUntilDue(Clock::time_point now) const;
+
+  // Starts a new window after the pending bytes were delivered.
+  void Reset();
+
+  std::size_t pending() const { return pending_; }
+
+ private:
+  CoalescingOptions options_;
+  std::size_t pending_ = 0;
+  Clock::time_point first_byte_at_;
+  bool flush_byte_seen_ = false;
+};
+
+// Merges recv() chunks into one platform message per time/size window.
+//
+// RFCOMM delivers an adapter reply in several small fragments; without
+// coalescing each fragment becomes its own platform-channel event. Not
+// thread-safe: owned by the receive thread.
+class ChunkCoalescer {
+ public:
+  using Clock = CoalescingWindow::Clock;
+
+  explicit ChunkCoalescer(CoalescingOptions options = CoalescingOptions());
+
+  const CoalescingOptions& options() const { return window_.options(); }
+  void set_options(const CoalescingOptions& options) { window_.set_options(options); }
+
+  // Buffers |data|. Returns true if a flush is due right away (size limit
+  // or flush byte reached).
+  bool Append(const std::uint8_t* data, std::size_t length, Clock::time_point now);
+
+  bool IsDue(Clock::time_point now) const { return window_.IsDue(now); }
+
+  // Milliseconds until the window of the buffered data closes: -1 if nothing
+  // is buffered, 0 if a flush is already due.
+  int MillisecondsUntilDue(Clock::time_point now) const {
+    return window_.MillisecondsUntilDue(now);
+  }
+
+  // Moves the buffered bytes out and starts a new window.
+  std::vector<std::uint8_t> Take();
+
+  bool empty() const { return buffer_.empty(); }
+  std::size_t size() const { return buffer_.size(); }
+
+ private:
+  CoalescingWindow window_;
+  std::vector<std::uint8_t> buffer_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_CHUNK_COALESCER_H_
@@ -0,0 +1,416 @@
+#include "command_pipeline.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "adaptive_timeouts.h"
+#include "ecu_values.h"
+#include "response_counts.h"
+
+namespace flutter_bluetooth_classic {
+
+CommandPipeline::CommandPipeline(WriteFunction write) : write_(std::move(write)) {}
+
+void CommandPipeline::SetPollScheduler(PollScheduler* scheduler, std::chrono::milliseconds timeout,
+                                       SampleHandler on_sample) {
+  scheduler_ = scheduler;
+  poll_timeout_ = timeout;
+  on_sample_ = std::move(on_sample);
+}
+
+void CommandPipeline::Submit(std::vector<std::string> commands, std::chrono::milliseconds timeout,
+                             BatchHandler on_done) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Batch batch;
+  batch.commands = std::move(commands);
+  batch.timeout = timeout;
+  batch.on_done = std::move(on_done);
+  batch.results.reserve(batch.commands.size());
+  pending_.push_back(std::move(batch));
+  busy_.store(true, std::memory_order_release);
+}
+
+void CommandPipeline::SubmitRaw(std::vector<std::string> commands,
+                                std::chrono::milliseconds timeout, BatchHandler on_done) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Batch batch;
+  batch.commands = std::move(commands);
+  batch.timeout = timeout;
+  batch.on_done = std::move(on_done);
+  batch.results.reserve(batch.commands.size());
+  batch.raw = true;
+  pending_.push_back(std::move(batch));
+  busy_.store(true, std::memory_order_release);
+}
+
+bool CommandPipeline::OnResponse(ElmResponse&& response) {
+  if (state_ == State::kIdle) return false;
+
+  Clock::time_point now = response.completed_at;
+  if (state_ == State::kResyncing) {
+    // The prompt that ends the aborted command; nothing to record.
+    state_ = State::kIdle;
+  } else if (!routing_to_.empty()) {
+    state_ = State::kIdle;
+    FinishRoute(response.lines, now);
+  } else if (changing_to_ >= 0) {
+    state_ = State::kIdle;
+    FinishChange(response.lines, now);
+  } else {
+    state_ = State::kIdle;
+    Finish(CommandResult::Status::kOk, std::move(response.lines), now, response.first_byte_at);
+  }
+  Advance(now);
+  CompleteFinishedBatches();
+  return true;
+}
+
+int CommandPipeline::OnTimer(Clock::time_point now) {
+  if (state_ == State::kIdle) {
+    Advance(now);
+  } else if (now >= deadline_) {
+    if (state_ == State::kAwaitingResponse) {
+      // The request itself was never written
+      if (!routing_to_.empty()) {
+        routing_to_.clear();
+        header_known_ = false;
+        header_routed_ = true;
+      }
+      if (changing_to_ >= 0) {
+        changing_to_ = -1;
+        atst_ = -1;
+      }
+      Finish(CommandResult::Status::kTimedOut, {}, now);
+      // Any character aborts a command the adapter is still working on.
+      // Its prompt must not be taken as the answer to the next command.
+      if (write_("\r")) {
+        state_ = State::kResyncing;
+        deadline_ = now + timeout_;
+      } else {
+        state_ = State::kIdle;
+        Advance(now);
+      }
+    } else {
+      // The adapter never confirmed the abort; carry on regardless.
+      state_ = State::kIdle;
+      Advance(now);
+    }
+  }
+  CompleteFinishedBatches();
+
+  if (state_ == State::kIdle) {
+    return scheduler_ ? scheduler_->MillisecondsUntilNextRelease(now) : -1;
+  }
+  auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline_ - now).count();
+  return remaining > 0 ? static_cast<int>(remaining) : 0;
+}
+
+void CommandPipeline::Cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!pending_.empty()) {
+      running_.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+    busy_.store(false, std::memory_order_release);
+  }
+  for (auto& batch : running_) {
+    for (std::size_t i = batch.results.size(); i < batch.commands.size(); ++i) {
+      CommandResult result;
+      result.command = batch.commands[i];
+      result.status = CommandResult::Status::kCancelled;
+      batch.results.push_back(std::move(result));
+    }
+    finished_.push_back(std::move(batch));
+  }
+  running_.clear();
+  if (polling_ && state_ == State::kAwaitingResponse) {
+    scheduler_->Complete(poll_ticket_, false, Clock::now());
+  }
+  polling_ = false;
+  if (!routing_to_.empty()) {
+    routing_to_.clear();
+    header_known_ = false;
+    header_routed_ = true;
+  }
+  if (changing_to_ >= 0) {
+    changing_to_ = -1;
+    atst_ = -1;
+  }
+  state_ = State::kIdle;
+  CompleteFinishedBatches();
+}
+
+void CommandPipeline::Advance(Clock::time_point now) {
+  while (state_ == State::kIdle) {
+    if (running_.empty()) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (pending_.empty()) {
+        busy_.store(false, std::memory_order_release);
+        lock.unlock();
+        // Batches first; scheduled commands fill the idle link time
+        if (scheduler_) StartPoll(now);
+        return;
+      }
+      running_.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+
+    Batch& batch = running_.front();
+    std::size_t index = batch.results.size();
+    if (index == batch.commands.size()) {
+      finished_.push_back(std::move(batch));
+      running_.pop_front();
+      continue;
+    }
+
+    if (!Send(batch.commands[index], batch.timeout, batch.raw)) {
+      Finish(CommandResult::Status::kWriteFailed, {}, now);
+    }
+  }
+}
+
+bool CommandPipeline::StartPoll(Clock::time_point now) {
+  if (!scheduler_->Next(now, &poll_command_, &poll_ticket_)) return false;
+
+  polling_ = true;
+  if (!Send(poll_command_, poll_timeout_)) {
+    // Not retried here: a link that cannot write is about to close
+    Finish(CommandResult::Status::kWriteFailed, {}, now);
+    return false;
+  }
+  return true;
+}
+
+bool CommandPipeline::Send(const std::string& command, std::chrono::milliseconds timeout,
+                           bool raw) {
+  command_ = command;
+  raw_ = raw;
+  timeout_ = timeout;
+  sent_atst_ = atst_;
+  sent_routed_ = false;
+  if (raw) {
+    wire_ = command;
+    sent_count_ = 0;
+    // Back to the functional header if a routed request left a physical one
+    const std::string header =
+        ecus_ && header_routed_ ? ecus_->FunctionalHeader() : std::string();
+    if (!header.empty()) {
+      routing_to_ = header;
+      return WriteLine("ATSH" + header);
+    }
+    return WriteLine(wire_);
+  }
+  wire_ = WireCommand(command);
+  if (ecus_) {
+    std::string header = ecus_->Route(command);
+    sent_routed_ = !header.empty();
+    // Only a header routing set is undone; one the app set stays
+    if (header.empty() && header_routed_) header = ecus_->FunctionalHeader();
+    if (!header.empty()) {
+      const bool current = header_known_ && header == header_;
+      if (!current) {
+        routing_to_ = header;
+        return WriteLine("ATSH" + header);
+      }
+    }
+  }
+  return SendTimed();
+}
+
+bool CommandPipeline::SendTimed() {
+  if (timeouts_ && !raw_) {
+    const int counts = timeouts_->Select(command_, atst_);
+    if (counts != atst_) {
+      char change[8];
+      std::snprintf(change, sizeof(change), "ATST%02X", counts);
+      changing_to_ = counts;
+      return WriteLine(change);
+    }
+  }
+  return WriteLine(wire_);
+}
+
+bool CommandPipeline::WriteLine(const std::string& line) {
+  sent_at_ = Clock::now();
+  if (!write_(line + "\r")) {
+    if (!routing_to_.empty()) {
+      routing_to_.clear();
+      header_known_ = false;
+      header_routed_ = true;
+    }
+    changing_to_ = -1;
+    return false;
+  }
+  deadline_ = sent_at_ + timeout_;
+  state_ = State::kAwaitingResponse;
+  return true;
+}
+
+void CommandPipeline::FinishRoute(const std::vector<std::string>& lines, Clock::time_point now) {
+  const bool accepted = std::find(lines.begin(), lines.end(), "OK") != lines.end();
+  ecus_->ObserveRoute(accepted);
+  // A rejected header leaves the previous one in effect
+  if (accepted) {
+    header_ = routing_to_;
+    header_routed_ = !EcuValues::IsFunctional(routing_to_);
+  }
+  sent_routed_ = accepted && sent_routed_;
+  routing_to_.clear();
+  if (!SendTimed()) Finish(CommandResult::Status::kWriteFailed, {}, now);
+}
+
+void CommandPipeline::FinishChange(const std::vector<std::string>& lines, Clock::time_point now) {
+  const bool accepted = std::find(lines.begin(), lines.end(), "OK") != lines.end();
+  timeouts_->ObserveChange(std::chrono::duration_cast<std::chrono::microseconds>(now - sent_at_),
+                           accepted);
+  atst_ = accepted ? changing_to_ : -1;
+  changing_to_ = -1;
+  sent_atst_ = atst_;
+  if (!WriteLine(wire_)) Finish(CommandResult::Status::kWriteFailed, {}, now);
+}
+
+void CommandPipeline::Finish(CommandResult::Status status, std::vector<std::string> lines,
+                             Clock::time_point now, Clock::time_point first_byte_at) {
+  CommandResult result;
+  result.status = status;
+  result.lines = std::move(lines);
+  result.completed_at = now;
+  if (now > sent_at_) {
+    result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - sent_at_);
+  }
+  std::chrono::microseconds first_response{0};
+  if (first_byte_at >= sent_at_ && first_byte_at <= now) {
+    first_response =
+        std::chrono::duration_cast<std::chrono::microseconds>(first_byte_at - sent_at_);
+  }
+
+  if (polling_) {
+    polling_ = false;
+    result.command = poll_command_;
+    if (stats_) RecordStats(result, first_byte_at);
+    if (counts_) counts_->Observe(result.command, sent_count_, result);
+    if (timeouts_) timeouts_->Observe(result.command, sent_atst_, result, first_response);
+    if (ecus_) ecus_->Observe(result.command, sent_routed_, result);
+    scheduler_->Complete(poll_ticket_, status == CommandResult::Status::kOk, now);
+    if (on_sample_) on_sample_(std::move(result));
+    return;
+  }
+
+  Batch& batch = running_.front();
+  result.command = batch.commands[batch.results.size()];
+  if (batch.raw) {
+    if (stats_) RecordStats(result, first_byte_at, LinkStats::kOtherCommand);
+    batch.results.push_back(std::move(result));
+    return;
+  }
+  if (stats_) RecordStats(result, first_byte_at);
+  if (counts_) counts_->Observe(result.command, sent_count_, result);
+  if (timeouts_) {
+    timeouts_->Observe(result.command, sent_atst_, result, first_response);
+    TrackTimeout(result);
+  }
+  if (ecus_) {
+    ecus_->Observe(result.command, sent_routed_, result);
+    TrackHeader(result);
+  }
+  batch.results.push_back(std::move(result));
+}
+
+void CommandPipeline::RecordStats(const CommandResult& result, Clock::time_point first_byte_at,
+                                  const char* key) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  const std::string command = key ? std::string(key) : result.command;
+
+  switch (result.status) {
+    case CommandResult::Status::kOk:
+      break;
+    case CommandResult::Status::kTimedOut:
+      stats_->Add(LinkCounter::kTimeouts);
+      stats_->ForCommand(command)->timeouts.fetch_add(1, std::memory_order_relaxed);
+      return;
+    case CommandResult::Status::kWriteFailed:
+      stats_->Add(LinkCounter::kWriteFailures);
+      return;
+    case CommandResult::Status::kCancelled:
+      return;
+  }
+
+  CommandStats* entry = stats_->ForCommand(command);
+  entry->completed.fetch_add(1, std::memory_order_relaxed);
+  entry->Record(LatencyPhase::kRoundTrip, result.elapsed);
+  // A response whose first byte predates the write was already under way
+  // (a late answer); only its total is meaningful
+  if (first_byte_at >= sent_at_ && first_byte_at <= result.completed_at) {
+    entry->Record(LatencyPhase::kFirstByte, duration_cast<microseconds>(first_byte_at - sent_at_));
+    entry->Record(LatencyPhase::kPrompt,
+                  duration_cast<microseconds>(result.completed_at - first_byte_at));
+  }
+}
+
+std::string CommandPipeline::WireCommand(const std::string& command) {
+  sent_count_ = 0;
+  return counts_ ? counts_->Apply(command, &sent_count_) : command;
+}
+
+void CommandPipeline::TrackTimeout(const CommandResult& result) {
+  std::string command;
+  for (char c : result.command) {
+    if (c != ' ') command.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+  }
+  if (command.compare(0, 2, "AT") != 0) return;
+  // Resets may restore a saved (ATPP) value
+  if (command == "ATZ" || command == "ATWS" || command == "ATD") {
+    atst_ = -1;
+    timeouts_->SetDefault(AdaptiveTimeouts::kDefaultCounts);
+    return;
+  }
+  if (command.size() != 6 || command.compare(0, 4, "ATST") != 0) return;
+  const auto& lines = result.lines;
+  const bool accepted = result.status == CommandResult::Status::kOk &&
+                        std::find(lines.begin(), lines.end(), "OK") != lines.end();
+  char* end = nullptr;
+  const long value = std::strtol(command.c_str() + 4, &end, 16);
+  if (!accepted || *end != '\0') {
+    atst_ = -1;
+  } else {
+    atst_ = value == 0 ? AdaptiveTimeouts::kDefaultCounts : static_cast<int>(value);
+    timeouts_->SetDefault(atst_);
+  }
+}
+
+void CommandPipeline::TrackHeader(const CommandResult& result) {
+  std::string command;
+  for (char c : result.command) {
+    if (c != ' ') command.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+  }
+  if (command == "ATZ" || command == "ATWS" || command == "ATD") {
+    header_.clear();
+    header_known_ = true;
+    header_routed_ = false;
+    return;
+  }
+  if (command.compare(0, 4, "ATSH") != 0) return;
+  const auto& lines = result.lines;
+  const bool accepted = result.status == CommandResult::Status::kOk &&
+                        std::find(lines.begin(), lines.end(), "OK") != lines.end();
+  // Whatever the app set is not necessarily in the form Route() compares
+  header_ = command.substr(4);
+  header_known_ = accepted;
+  header_routed_ = false;
+}
+
+void CommandPipeline::CompleteFinishedBatches() {
+  if (finished_.empty()) return;
+  std::vector<Batch> finished;
+  finished.swap(finished_);
+  for (auto& batch : finished) {
+    if (batch.on_done) batch.on_done(std::move(batch.results));
+  }
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,225 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_COMMAND_PIPELINE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_COMMAND_PIPELINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "elm327_framer.h"
+#include "latency_stats.h"
+#include "poll_scheduler.h"
+
+namespace flutter_bluetooth_classic {
+
+class AdaptiveTimeouts;
+class EcuValues;
+class ResponseCounts;
+
+struct CommandResult {
+  enum class Status { kOk, kTimedOut, kWriteFailed, kCancelled };
+
+  std::string command;
+  Status status = Status::kOk;
+  std::vector<std::string> lines;
+  // From the write to the prompt (or to the deadline).
+  std::chrono::microseconds elapsed{0};
+  // When the prompt (or the deadline) ended the command.
+  std::chrono::steady_clock::time_point completed_at;
+};
+
+// Runs batches of ELM327 commands back to back on one adapter link.
+//
+// The adapter accepts one command at a time, so the pipeline keeps exactly
+// one outstanding and writes the next one from the receive thread as soon
+// as the previous '>' prompt has been framed, without a round trip through
+// the platform thread or Dart. Each response is correlated with the single
+// outstanding command; a batch completes with one result per command, in
+// order.
+//
+// With a PollScheduler attached, the link runs its periodic commands
+// whenever no batch is queued, so one-off batches are served between two
+// samples and there is still never more than one command outstanding.
+//
+// Submit() and busy() may be called from any thread. Everything else runs on
+// the link's receive thread, which also does all writes.
+class CommandPipeline {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // Writes raw bytes to the adapter. Called on the receive thread.
+  using WriteFunction = std::function<bool(const std::string& data)>;
+  // Called on the receive thread when every command of a batch has a result.
+  using BatchHandler = std::function<void(std::vector<CommandResult>&& results)>;
+  // Called on the receive thread with each completed scheduled command.
+  using SampleHandler = std::function<void(CommandResult&& result)>;
+
+  explicit CommandPipeline(WriteFunction write);
+
+  CommandPipeline(const CommandPipeline&) = delete;
+  CommandPipeline& operator=(const CommandPipeline&) = delete;
+
+  // Queues a batch behind any running one. |timeout| applies per command.
+  // The receive thread starts it on its next OnTimer() call, so the caller
+  // should wake the receive loop afterwards.
+  void Submit(std::vector<std::string> commands, std::chrono::milliseconds timeout,
+              BatchHandler on_done);
+
+  // Like Submit(), but the commands are written exactly as given and to
+  // every ECU: no response count, ATST change or physical header is added
+  // for them, and neither the learners nor the per-command stats hear of
+  // them (their latencies go to LinkStats::kOtherCommand). For scans,
+  // which send each request once and would only crowd the learners'
+  // tables.
+  void SubmitRaw(std::vector<std::string> commands, std::chrono::milliseconds timeout,
+                 BatchHandler on_done);
+
+  // Runs |scheduler|'s commands whenever the link is free, each with
+  // |timeout|. Must be called before the receive thread starts.
+  void SetPollScheduler(PollScheduler* scheduler, std::chrono::milliseconds timeout,
+                        SampleHandler on_sample);
+
+  // Records each command's phases, outcome and timeouts into |stats|. Must
+  // be called before the receive thread starts.
+  void SetLinkStats(LinkStats* stats) { stats_ = stats; }
+
+  // Appends learned response counts to OBD requests (see ResponseCounts).
+  // Results keep the command as submitted. Must be called before the
+  // receive thread starts.
+  void SetResponseCounts(ResponseCounts* counts) { counts_ = counts; }
+
+  // Sets the adapter's ATST ahead of each OBD request to what |timeouts|
+  // picks for it (see AdaptiveTimeouts). A change is written just before
+  // the request, from the receive thread, and its OK is not reported. ATST
+  // changes made through the raw write path are not seen. Must be called
+  // before the receive thread starts.
+  void SetAdaptiveTimeouts(AdaptiveTimeouts* timeouts) { timeouts_ = timeouts; }
+
+  // Reports every result to |ecus| and sets the request header (ATSH) ahead
+  // of each OBD request to the one it routes the request to (see
+  // EcuValues). A change is written before any ATST change, and its OK is
+  // not reported. Must be called before the receive thread starts.
+  void SetEcuValues(EcuValues* ecus) { ecus_ = ecus; }
+
+  // True while a batch is queued or running, or a poll schedule is set.
+  bool busy() const {
+    return busy_.load(std::memory_order_acquire) || (scheduler_ && scheduler_->active());
+  }
+
+  // Offers a framed response. Returns false if it does not belong to the
+  // pipeline (no command outstanding) and should be delivered elsewhere.
+  bool OnResponse(ElmResponse&& response);
+
+  // Starts queued batches or due scheduled commands and enforces the
+  // outstanding command's deadline. Returns milliseconds until the next
+  // deadline or release, -1 if none.
+  int OnTimer(Clock::time_point now);
+
+  // Completes every queued and running command as cancelled.
+  void Cancel();
+
+ private:
+  enum class State {
+    kIdle,
+    kAwaitingResponse,
+    // A command timed out; a bare CR was sent to abort it and the pipeline
+    // discards the response that prompt ends ("STOPPED" or a late answer).
+    kResyncing,
+  };
+
+  struct Batch {
+    std::vector<std::string> commands;
+    std::chrono::milliseconds timeout;
+    BatchHandler on_done;
+    std::vector<CommandResult> results;
+    // Submitted with SubmitRaw().
+    bool raw = false;
+  };
+
+  // Writes commands until one is outstanding or the batch is finished.
+  void Advance(Clock::time_point now);
+  // Records the outcome of the outstanding command. |first_byte_at| is set
+  // when a response ended it.
+  void Finish(CommandResult::Status status, std::vector<std::string> lines, Clock::time_point now,
+              Clock::time_point first_byte_at = Clock::time_point());
+  // Records under |key| instead of the command if set.
+  void RecordStats(const CommandResult& result, Clock::time_point first_byte_at,
+                   const char* key = nullptr);
+  // The line to write for |command|, with its response count if learned.
+  std::string WireCommand(const std::string& command);
+  // Makes |command| the outstanding one with |timeout|, writing a header
+  // or ATST change first if one is due (only the functional header for a
+  // |raw| one). False if a write failed.
+  bool Send(const std::string& command, std::chrono::milliseconds timeout, bool raw = false);
+  // Writes the outstanding command, or the ATST change it needs first.
+  bool SendTimed();
+  bool WriteLine(const std::string& line);
+  // Carries on with the command a header change was made for, now that
+  // |lines| answered the change.
+  void FinishRoute(const std::vector<std::string>& lines, Clock::time_point now);
+  // Writes the request an ATST change was made for, now that |lines|
+  // answered the change.
+  void FinishChange(const std::vector<std::string>& lines, Clock::time_point now);
+  // Follows ATST changes and resets made by submitted commands.
+  void TrackTimeout(const CommandResult& result);
+  // Follows header changes and resets made by submitted commands.
+  void TrackHeader(const CommandResult& result);
+  // Issues the next released scheduled command, if any.
+  bool StartPoll(Clock::time_point now);
+  void CompleteFinishedBatches();
+
+  WriteFunction write_;
+  PollScheduler* scheduler_ = nullptr;
+  LinkStats* stats_ = nullptr;
+  ResponseCounts* counts_ = nullptr;
+  AdaptiveTimeouts* timeouts_ = nullptr;
+  EcuValues* ecus_ = nullptr;
+  std::chrono::milliseconds poll_timeout_{0};
+  SampleHandler on_sample_;
+
+  // Guards pending_; the rest is receive-thread state.
+  std::mutex mutex_;
+  std::deque<Batch> pending_;
+  std::atomic<bool> busy_{false};
+
+  std::deque<Batch> running_;
+  std::vector<Batch> finished_;
+  State state_ = State::kIdle;
+  // The outstanding command came from the scheduler, not a batch.
+  bool polling_ = false;
+  std::string poll_command_;
+  PollScheduler::Ticket poll_ticket_;
+  std::chrono::milliseconds timeout_{0};
+  Clock::time_point sent_at_;
+  // The outstanding command as submitted, and whether it came from
+  // SubmitRaw().
+  std::string command_;
+  bool raw_ = false;
+  // Response count appended to the outstanding command, 0 if none.
+  int sent_count_ = 0;
+  // The line written once the outstanding ATST change is answered.
+  std::string wire_;
+  // The adapter's ATST (-1 if unknown), the value being set (-1 if no change
+  // is outstanding), and the value the outstanding command runs under.
+  int atst_ = -1;
+  int changing_to_ = -1;
+  int sent_atst_ = -1;
+  // The adapter's request header as written ("" for its default, the
+  // functional one) and whether it is known, whether it may be one routing
+  // set (only then is the functional one put back), the header being set
+  // (empty if no change is outstanding), and whether the outstanding
+  // command went to one ECU.
+  std::string header_;
+  bool header_known_ = true;
+  bool header_routed_ = false;
+  std::string routing_to_;
+  bool sent_routed_ = false;
+  Clock::time_point deadline_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_COMMAND_PIPELINE_H_
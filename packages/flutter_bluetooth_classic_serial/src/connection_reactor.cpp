@@ -0,0 +1,209 @@
+#include "connection_reactor.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+constexpr std::size_t kReceiveBufferSize = 4096;
+constexpr int kMaxEvents = 32;
+// Reads per readiness event, so one busy connection cannot starve the
+// others; the level-triggered reactor reports the rest on the next pass.
+constexpr int kMaxReadsPerEvent = 16;
+
+}  // namespace
+
+ConnectionReactor::ConnectionReactor() = default;
+
+ConnectionReactor::~ConnectionReactor() { Shutdown(); }
+
+bool ConnectionReactor::Start() {
+  if (started_ || stop_requested_.load(std::memory_order_acquire) || !reactor_.IsValid()) {
+    return false;
+  }
+  started_ = true;
+  thread_ = std::thread([this]() { Run(); });
+  return true;
+}
+
+void ConnectionReactor::Shutdown() {
+  stop_requested_.store(true, std::memory_order_release);
+  reactor_.Wake();
+  if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+    thread_.join();
+  }
+}
+
+ConnectionReactor::ConnectionId ConnectionReactor::Add(NativeSocket socket, Handlers handlers) {
+  if (!started_ || stop_requested_.load(std::memory_order_acquire)) return kInvalidConnection;
+  if (!SetNonBlocking(socket, true)) return kInvalidConnection;
+
+  auto connection = std::make_shared<Connection>();
+  connection->socket = socket;
+  connection->handlers = std::move(handlers);
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    connection->id = next_id_++;
+    connections_[connection->id] = connection;
+    ++registry_version_;
+  }
+  if (!reactor_.Add(socket, connection->id)) {
+    Unregister(connection->id);
+    return kInvalidConnection;
+  }
+  // Run the first timer pass promptly.
+  reactor_.Wake();
+  return connection->id;
+}
+
+bool ConnectionReactor::Remove(ConnectionId id) {
+  std::shared_ptr<Connection> connection = Unregister(id);
+  if (!connection) return false;
+  reactor_.Remove(connection->socket);
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    // Wait out a handler in progress; later passes see |removed|.
+    std::lock_guard<std::mutex> lock(dispatch_mutex_);
+    connection->handlers = Handlers();
+  }
+  return true;
+}
+
+bool ConnectionReactor::IsOpen(ConnectionId id) const { return Find(id) != nullptr; }
+
+bool ConnectionReactor::SetWriteInterest(ConnectionId id, bool enabled) {
+  std::shared_ptr<Connection> connection = Find(id);
+  return connection && reactor_.SetWriteInterest(connection->socket, id, enabled);
+}
+
+void ConnectionReactor::Wake(ConnectionId id) {
+  std::shared_ptr<Connection> connection = Find(id);
+  if (!connection) return;
+  connection->timer_requested.store(true, std::memory_order_release);
+  reactor_.Wake();
+}
+
+std::size_t ConnectionReactor::connection_count() const {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  return connections_.size();
+}
+
+std::shared_ptr<ConnectionReactor::Connection> ConnectionReactor::Find(ConnectionId id) const {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  auto it = connections_.find(id);
+  return it == connections_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<ConnectionReactor::Connection> ConnectionReactor::Unregister(ConnectionId id) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  auto it = connections_.find(id);
+  if (it == connections_.end()) return nullptr;
+  std::shared_ptr<Connection> connection = std::move(it->second);
+  connections_.erase(it);
+  ++registry_version_;
+  connection->removed.store(true, std::memory_order_release);
+  return connection;
+}
+
+void ConnectionReactor::Run() {
+  Reactor::Event events[kMaxEvents];
+
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    int timeout_ms = RunTimers();
+    int ready = reactor_.Wait(events, kMaxEvents, timeout_ms);
+    if (ready < 0) {
+      // The wait itself failed; no connection can make progress.
+      const int error = LastSocketError();
+      std::lock_guard<std::mutex> lock(dispatch_mutex_);
+      for (const auto& connection : snapshot_) {
+        if (!connection->removed.load(std::memory_order_acquire)) Close(connection, error);
+      }
+      break;
+    }
+
+    std::lock_guard<std::mutex> lock(dispatch_mutex_);
+    for (int i = 0; i < ready; ++i) {
+      std::shared_ptr<Connection> connection = Find(events[i].token);
+      if (!connection || connection->removed.load(std::memory_order_acquire)) continue;
+      if (events[i].readable || events[i].hangup) Drain(connection.get());
+      if (events[i].writable && !connection->removed.load(std::memory_order_acquire) &&
+          connection->handlers.on_writable) {
+        connection->handlers.on_writable();
+      }
+    }
+  }
+
+  // Drop whatever is still registered, without callbacks.
+  std::lock_guard<std::mutex> dispatch(dispatch_mutex_);
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  for (auto& pair : connections_) {
+    pair.second->removed.store(true, std::memory_order_release);
+    reactor_.Remove(pair.second->socket);
+  }
+  connections_.clear();
+  ++registry_version_;
+  snapshot_.clear();
+}
+
+int ConnectionReactor::RunTimers() {
+  std::lock_guard<std::mutex> dispatch(dispatch_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    if (snapshot_version_ != registry_version_) {
+      snapshot_.clear();
+      for (const auto& pair : connections_) snapshot_.push_back(pair.second);
+      snapshot_version_ = registry_version_;
+    }
+  }
+
+  Clock::time_point now = Clock::now();
+  Clock::time_point next_due = Clock::time_point::max();
+  for (const auto& connection : snapshot_) {
+    if (connection->removed.load(std::memory_order_acquire)) continue;
+    const bool requested = connection->timer_requested.exchange(false, std::memory_order_acq_rel);
+    if (requested || now >= connection->timer_due) {
+      connection->timer_due = Clock::time_point::max();
+      if (connection->handlers.on_timer) {
+        const int delay_ms = connection->handlers.on_timer();
+        if (delay_ms >= 0) connection->timer_due = now + std::chrono::milliseconds(delay_ms);
+      }
+    }
+    if (!connection->removed.load(std::memory_order_acquire)) {
+      next_due = std::min(next_due, connection->timer_due);
+    }
+  }
+
+  if (next_due == Clock::time_point::max()) return -1;
+  now = Clock::now();
+  if (next_due <= now) return 0;
+  // Round up so the wait never ends just before the timer is due.
+  return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next_due - now).count());
+}
+
+void ConnectionReactor::Drain(Connection* connection) {
+  std::uint8_t buffer[kReceiveBufferSize];
+  for (int reads = 0; reads < kMaxReadsPerEvent; ++reads) {
+    int received = ReceiveSome(connection->socket, buffer, sizeof(buffer));
+    if (received > 0) {
+      if (connection->handlers.on_data) {
+        connection->handlers.on_data(buffer, static_cast<std::size_t>(received));
+      }
+      if (connection->removed.load(std::memory_order_acquire)) return;
+      connection->timer_requested.store(true, std::memory_order_release);
+      continue;
+    }
+    int error = received == 0 ? 0 : LastSocketError();
+    if (received < 0 && IsWouldBlockError(error)) return;
+    Close(Find(connection->id), error);
+    return;
+  }
+}
+
+void ConnectionReactor::Close(const std::shared_ptr<Connection>& connection, int error) {
+  if (!connection || !Unregister(connection->id)) return;
+  reactor_.Remove(connection->socket);
+  if (connection->handlers.on_closed) connection->handlers.on_closed(error);
+}
+
+}  // namespace flutter_bluetooth_classic
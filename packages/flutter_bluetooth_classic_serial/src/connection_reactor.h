@@ -0,0 +1,134 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_CONNECTION_REACTOR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_CONNECTION_REACTOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "native_socket.h"
+#include "reactor.h"
+
+namespace flutter_bluetooth_classic {
+
+// One I/O thread that owns the socket events of every connection.
+//
+// Connections are registered with Add() and identified by an id that is
+// never reused. The thread blocks in a single Reactor over all sockets,
+// drains whichever are readable, reports writable ones that asked for it
+// and runs each connection's timer handler only when it is due, so an idle
+// connection costs no wakeups at all.
+//
+// Cancellation is deterministic: once Remove() returns, none of that
+// connection's handlers is running or will run again. Shutdown() joins the
+// thread. Sockets are never closed here; their owner closes them after
+// Remove() or Shutdown().
+class ConnectionReactor {
+ public:
+  using ConnectionId = std::uint64_t;
+  static constexpr ConnectionId kInvalidConnection = 0;
+
+  using DataHandler = std::function<void(const std::uint8_t* data, std::size_t length)>;
+  // |error| is 0 when the remote side closed the connection. The connection
+  // is already unregistered when this runs.
+  using ClosedHandler = std::function<void(int error)>;
+  // Does any time-based work and returns how long until it is next due in
+  // ms (-1 = only after data or Wake()). Runs once after Add(), after every
+  // chunk of data and after Wake().
+  using TimerHandler = std::function<int()>;
+  // Called while write interest is on and the socket can take more data.
+  using WritableHandler = std::function<void()>;
+
+  struct Handlers {
+    DataHandler on_data;
+    ClosedHandler on_closed;
+    TimerHandler on_timer;
+    WritableHandler on_writable;
+  };
+
+  ConnectionReactor();
+  // Calls Shutdown().
+  ~ConnectionReactor();
+
+  ConnectionReactor(const ConnectionReactor&) = delete;
+  ConnectionReactor& operator=(const ConnectionReactor&) = delete;
+
+  // Starts the I/O thread. False if it is already running, was shut down or
+  // the reactor backend failed to initialize.
+  bool Start();
+
+  // Stops and joins the thread. Connections still registered are dropped
+  // without a closed callback.
+  void Shutdown();
+
+  // Switches |socket| to non-blocking mode and registers it. Returns
+  // kInvalidConnection on failure. Thread-safe, handlers included.
+  ConnectionId Add(NativeSocket socket, Handlers handlers);
+
+  // Unregisters |id| and waits for any handler of it in progress. From one
+  // of its own handlers it only unregisters. False if |id| is not
+  // registered (never added, removed, or closed).
+  bool Remove(ConnectionId id);
+
+  bool IsOpen(ConnectionId id) const;
+
+  // Turns |id|'s writable notifications on or off. Thread-safe.
+  bool SetWriteInterest(ConnectionId id, bool enabled);
+
+  // Marks |id|'s timer as due and interrupts the current wait, e.g. after
+  // another thread queued work for it. Thread-safe.
+  void Wake(ConnectionId id);
+
+  std::size_t connection_count() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Connection {
+    ConnectionId id = kInvalidConnection;
+    NativeSocket socket = kInvalidSocket;
+    Handlers handlers;
+    // Set when unregistered; handlers are only called while it is false.
+    std::atomic<bool> removed{false};
+    std::atomic<bool> timer_requested{true};
+    // I/O thread only.
+    Clock::time_point timer_due = Clock::time_point::max();
+  };
+
+  void Run();
+  // Runs due timer handlers; returns the wait timeout in ms.
+  int RunTimers();
+  void Drain(Connection* connection);
+  // Unregisters |connection| on the I/O thread and reports |error|.
+  void Close(const std::shared_ptr<Connection>& connection, int error);
+  std::shared_ptr<Connection> Find(ConnectionId id) const;
+  std::shared_ptr<Connection> Unregister(ConnectionId id);
+
+  Reactor reactor_;
+  std::thread thread_;
+  std::atomic<bool> stop_requested_{false};
+  bool started_ = false;
+
+  mutable std::mutex registry_mutex_;
+  std::map<ConnectionId, std::shared_ptr<Connection>> connections_;
+  ConnectionId next_id_ = 1;
+  std::uint64_t registry_version_ = 0;
+
+  // Held by the I/O thread while it runs handlers; Remove() takes it to wait
+  // for a handler in progress.
+  std::mutex dispatch_mutex_;
+
+  // I/O thread only.
+  std::vector<std::shared_ptr<Connection>> snapshot_;
+  std::uint64_t snapshot_version_ = ~std::uint64_t{0};
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_CONNECTION_REACTOR_H_
@@ -0,0 +1,181 @@
+#include "device_discovery.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+bool SameRecord(const DeviceRecord& a, const DeviceRecord& b) {
+  return a.name == b.name && a.paired == b.paired && a.connected == b.connected;
+}
+
+}  // namespace
+
+DeviceCache::DeviceCache(DiscoveryBackend* backend, std::chrono::milliseconds max_age)
+    : backend_(backend), max_age_(max_age) {}
+
+RadioInfo DeviceCache::Radio() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = backend_->Now();
+  if (radio_valid_ && now - radio_read_at_ < max_age_) {
+    ++stats_.hits;
+    return radio_;
+  }
+  ++stats_.refreshes;
+  radio_ = backend_->QueryRadio();
+  radio_read_at_ = now;
+  radio_valid_ = true;
+  return radio_;
+}
+
+std::vector<DeviceRecord> DeviceCache::KnownDevices() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = backend_->Now();
+  if (devices_valid_ && now - devices_read_at_ < max_age_) {
+    ++stats_.hits;
+    return devices_;
+  }
+  ++stats_.refreshes;
+  devices_ = backend_->ListKnownDevices();
+  devices_read_at_ = now;
+  devices_valid_ = true;
+  return devices_;
+}
+
+void DeviceCache::StoreKnownDevices(std::vector<DeviceRecord> devices) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  devices_ = std::move(devices);
+  devices_read_at_ = backend_->Now();
+  devices_valid_ = true;
+}
+
+void DeviceCache::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  radio_valid_ = false;
+  devices_valid_ = false;
+}
+
+DeviceCache::Stats DeviceCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+DeviceDiscovery::DeviceDiscovery(DiscoveryBackend* backend, DeviceCache* cache)
+    : backend_(backend), cache_(cache) {}
+
+DeviceDiscovery::~DeviceDiscovery() {
+  Stop();
+  std::map<std::uint64_t, std::thread> workers;
+  {
+    std::lock_guard<std::mutex> lock(workers_mutex_);
+    workers.swap(workers_);
+  }
+  for (auto& worker : workers) worker.second.join();
+}
+
+bool DeviceDiscovery::Start(const DiscoveryOptions& options, FoundHandler on_found,
+                            FinishedHandler on_finished) {
+  if (IsDiscovering()) return false;
+  // A stopped session's worker may still be inside an inquiry round; the
+  // new generation makes it drop what the round returns and exit
+  const std::uint64_t generation = generation_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+  {
+    std::lock_guard<std::mutex> lock(found_mutex_);
+    found_.clear();
+    found_index_.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(handler_mutex_);
+    on_found_ = std::move(on_found);
+    on_finished_ = std::move(on_finished);
+  }
+  discovering_.store(true, std::memory_order_release);
+
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  JoinExitedWorkersLocked();
+  workers_.emplace(generation, std::thread(&DeviceDiscovery::Run, this, generation, options));
+  return true;
+}
+
+void DeviceDiscovery::Stop() {
+  discovering_.store(false, std::memory_order_release);
+  // Waits out a handler in progress; later ones see the flag
+  std::lock_guard<std::mutex> lock(handler_mutex_);
+  on_found_ = nullptr;
+  on_finished_ = nullptr;
+}
+
+std::vector<DeviceRecord> DeviceDiscovery::found() const {
+  std::lock_guard<std::mutex> lock(found_mutex_);
+  return found_;
+}
+
+bool DeviceDiscovery::IsCurrent(std::uint64_t generation) const {
+  return generation_.load(std::memory_order_acquire) == generation && IsDiscovering();
+}
+
+void DeviceDiscovery::JoinExitedWorkersLocked() {
+  for (std::uint64_t generation : exited_) {
+    auto it = workers_.find(generation);
+    // Returned already; the join only waits out the thread's exit
+    it->second.join();
+    workers_.erase(it);
+  }
+  exited_.clear();
+}
+
+void DeviceDiscovery::Run(std::uint64_t generation, DiscoveryOptions options) {
+  RunSession(generation, options);
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  exited_.push_back(generation);
+}
+
+void DeviceDiscovery::RunSession(std::uint64_t generation, const DiscoveryOptions& options) {
+  std::vector<DeviceRecord> known = backend_->ListKnownDevices();
+  if (cache_) cache_->StoreKnownDevices(known);
+  for (const auto& device : known) {
+    if (!Report(generation, device)) return;
+  }
+
+  for (int round = 0; round < options.inquiry_rounds; ++round) {
+    if (!IsCurrent(generation)) return;
+    backend_->Inquire(
+        [this, generation](const DeviceRecord& device) { return Report(generation, device); });
+  }
+
+  std::lock_guard<std::mutex> lock(handler_mutex_);
+  if (generation_.load(std::memory_order_acquire) != generation) return;
+  if (!discovering_.exchange(false, std::memory_order_acq_rel)) return;
+  if (on_finished_) on_finished_();
+}
+
+bool DeviceDiscovery::Report(std::uint64_t generation, const DeviceRecord& device) {
+  DeviceRecord report = device;
+  {
+    std::lock_guard<std::mutex> lock(found_mutex_);
+    // Start() clears the devices after moving to the next generation
+    if (generation_.load(std::memory_order_acquire) != generation) return false;
+    auto it = found_index_.find(device.address);
+    if (it != found_index_.end()) {
+      DeviceRecord& previous = found_[it->second];
+      // An inquiry may return a device without its name or pairing; keep
+      // what an earlier sighting learned
+      if (report.name.empty()) report.name = previous.name;
+      report.paired = report.paired || previous.paired;
+      if (SameRecord(previous, report)) return IsCurrent(generation);
+      previous = report;
+    } else {
+      found_index_[device.address] = found_.size();
+      found_.push_back(report);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(handler_mutex_);
+  if (!IsCurrent(generation)) return false;
+  if (on_found_) on_found_(report);
+  return true;
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,174 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_DEVICE_DISCOVERY_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_DEVICE_DISCOVERY_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+struct DeviceRecord {
+  // "AA:BB:CC:DD:EE:FF"
+  std::string address;
+  std::string name;
+  bool paired = false;
+  bool connected = false;
+};
+
+struct RadioInfo {
+  bool present = false;
+  bool enabled = false;
+};
+
+// Radio and device queries DeviceCache and DeviceDiscovery need. The Windows
+// plugin implements them over the Bluetooth APIs; tests substitute a
+// simulated radio.
+class DiscoveryBackend {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // Returns false to stop receiving devices.
+  using DeviceHandler = std::function<bool(const DeviceRecord& device)>;
+
+  virtual ~DiscoveryBackend() = default;
+
+  virtual Clock::time_point Now() { return Clock::now(); }
+
+  virtual RadioInfo QueryRadio() = 0;
+
+  // Devices the system already knows (paired, remembered or connected),
+  // without an inquiry.
+  virtual std::vector<DeviceRecord> ListKnownDevices() = 0;
+
+  // Runs one inquiry and reports each device it returns. The inquiry
+  // itself may not be interruptible; a false return only stops the
+  // reporting.
+  virtual void Inquire(const DeviceHandler& on_device) = 0;
+};
+
+// Radio state and known devices, refreshed from the backend at most once
+// per |max_age| or after Invalidate(). Thread-safe.
+class DeviceCache {
+ public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t refreshes = 0;
+  };
+
+  explicit DeviceCache(DiscoveryBackend* backend,
+                       std::chrono::milliseconds max_age = std::chrono::seconds(30));
+
+  RadioInfo Radio();
+  std::vector<DeviceRecord> KnownDevices();
+
+  // Replaces the known devices with a list just read from the backend.
+  void StoreKnownDevices(std::vector<DeviceRecord> devices);
+
+  // The next query goes to the backend, e.g. after the user may have
+  // paired or unpaired a device.
+  void Invalidate();
+
+  Stats stats() const;
+
+ private:
+  DiscoveryBackend* backend_;
+  std::chrono::milliseconds max_age_;
+  mutable std::mutex mutex_;
+  bool radio_valid_ = false;
+  DiscoveryBackend::Clock::time_point radio_read_at_;
+  RadioInfo radio_;
+  bool devices_valid_ = false;
+  DiscoveryBackend::Clock::time_point devices_read_at_;
+  std::vector<DeviceRecord> devices_;
+  Stats stats_;
+};
+
+struct DiscoveryOptions {
+  // Inquiry rounds after the known devices are reported. Each round is one
+  // backend inquiry; new devices are reported as each round returns them.
+  int inquiry_rounds = 10;
+};
+
+// Device discovery on a worker thread.
+//
+// Known devices are reported first, straight from the system's records, so
+// paired adapters show up at once. Inquiry rounds then follow until the
+// rounds run out or Stop() is called. Each address is reported once per
+// session, and again only if its name or flags change (an inquiry often
+// learns the name of a device it first saw without one).
+class DeviceDiscovery {
+ public:
+  // Called on the worker thread; must not call Start() or Stop().
+  using FoundHandler = std::function<void(const DeviceRecord& device)>;
+  // Called on the worker thread once the session ends, unless it was
+  // stopped.
+  using FinishedHandler = std::function<void()>;
+
+  // |cache| is optional; when set it receives the known devices read at
+  // the start of each session.
+  DeviceDiscovery(DiscoveryBackend* backend, DeviceCache* cache = nullptr);
+  // Stops and joins the workers, including stopped ones still inside an
+  // inquiry round.
+  ~DeviceDiscovery();
+
+  DeviceDiscovery(const DeviceDiscovery&) = delete;
+  DeviceDiscovery& operator=(const DeviceDiscovery&) = delete;
+
+  // Starts a new session and forgets the devices of the last one. False if
+  // a session is already running. Does not wait for the worker of a
+  // stopped session: it exits by itself once its inquiry round returns.
+  bool Start(const DiscoveryOptions& options, FoundHandler on_found,
+             FinishedHandler on_finished = nullptr);
+
+  // Ends the session without waiting for the inquiry in progress. On
+  // return no handler is running or will run again. Safe to call when idle.
+  void Stop();
+
+  bool IsDiscovering() const { return discovering_.load(std::memory_order_acquire); }
+
+  // Devices reported by the current or last session, in the order found.
+  std::vector<DeviceRecord> found() const;
+
+ private:
+  // Worker of session |generation|.
+  void Run(std::uint64_t generation, DiscoveryOptions options);
+  void RunSession(std::uint64_t generation, const DiscoveryOptions& options);
+  // Reports |device| unless it adds nothing to what was reported. False
+  // once the session is stopped or replaced.
+  bool Report(std::uint64_t generation, const DeviceRecord& device);
+  // True while session |generation| is the current one and running.
+  bool IsCurrent(std::uint64_t generation) const;
+  // Joins the workers that have exited. Called with workers_mutex_ held.
+  void JoinExitedWorkersLocked();
+
+  DiscoveryBackend* backend_;
+  DeviceCache* cache_;
+  std::atomic<bool> discovering_{false};
+  // Bumped by Start(); a worker whose session is no longer current stops
+  // reporting and exits.
+  std::atomic<std::uint64_t> generation_{0};
+
+  // Workers by session, and the sessions whose worker has returned.
+  std::mutex workers_mutex_;
+  std::map<std::uint64_t, std::thread> workers_;
+  std::vector<std::uint64_t> exited_;
+
+  // Held while a handler runs, so Stop() can wait it out.
+  std::mutex handler_mutex_;
+  FoundHandler on_found_;
+  FinishedHandler on_finished_;
+
+  mutable std::mutex found_mutex_;
+  std::vector<DeviceRecord> found_;
+  std::map<std::string, std::size_t> found_index_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_DEVICE_DISCOVERY_H_
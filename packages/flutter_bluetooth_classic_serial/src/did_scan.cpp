@@ -0,0 +1,349 @@
+#include "did_scan.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "elm327_reply.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// 22 and one or more DIDs, and the response count after them if there is
+// one.
+bool ParseRequest(const std::string& command, std::vector<std::uint16_t>* dids, int* count) {
+  if (command.size() < 6 || command.compare(0, 2, "22") != 0) return false;
+  const std::size_t end = 2 + (command.size() - 2) / 4 * 4;
+  if (command.size() - end > 1) return false;
+  dids->clear();
+  for (std::size_t i = 2; i < end; i += 4) {
+    int did = 0;
+    for (std::size_t j = i; j < i + 4; ++j) {
+      const int digit = HexValue(command[j]);
+      if (digit < 0) return false;
+      did = did << 4 | digit;
+    }
+    dids->push_back(static_cast<std::uint16_t>(did));
+  }
+  *count = end < command.size() ? HexValue(command[end]) : 0;
+  return *count >= 0;
+}
+
+bool Contains(const std::vector<std::string>& lines, const char* text) {
+  return std::find(lines.begin(), lines.end(), text) != lines.end();
+}
+
+// Negative responses that say the DID may well be there: ask again.
+bool Transient(std::uint8_t nrc) {
+  return nrc == 0x21 || nrc == 0x23 || nrc == 0x37 || nrc == 0x78;
+}
+
+// Negative responses from an ECU that has the DID.
+bool Refusal(std::uint8_t nrc) { return nrc == 0x22 || nrc == 0x33; }
+
+}  // namespace
+
+DidScan::DidScan() : bitmap_(kBitmapBytes, 0) {}
+
+bool DidScan::Load(const std::vector<std::uint8_t>& bitmap) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (bitmap.size() != kBitmapBytes) {
+    std::fill(bitmap_.begin(), bitmap_.end(), 0);
+    return false;
+  }
+  bitmap_ = bitmap;
+  return true;
+}
+
+std::vector<std::uint8_t> DidScan::Bitmap() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bitmap_;
+}
+
+DidState DidScan::state(std::uint16_t did) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<DidState>((bitmap_[did >> 2] >> ((did & 3) * 2)) & 3);
+}
+
+void DidScan::SetState(std::uint16_t did, DidState state) {
+  const int shift = (did & 3) * 2;
+  std::uint8_t& byte = bitmap_[did >> 2];
+  byte = static_cast<std::uint8_t>((byte & ~(3 << shift)) | (static_cast<int>(state) << shift));
+}
+
+std::size_t DidScan::Start(std::vector<Range> ranges, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) return 0;
+
+  queue_.clear();
+  singles_.clear();
+  attempts_.clear();
+  outstanding_ = 0;
+  stopped_ = false;
+  grouping_ = true;
+  progress_ = DidScanProgress();
+  std::sort(ranges.begin(), ranges.end());
+  std::size_t next = 0;
+  for (const auto& range : ranges) {
+    for (std::size_t did = std::max<std::size_t>(range.first, next); did <= range.second; ++did) {
+      const auto id = static_cast<std::uint16_t>(did);
+      if (((bitmap_[id >> 2] >> ((id & 3) * 2)) & 3) == 0) queue_.push_back(id);
+    }
+    next = std::max<std::size_t>(next, std::size_t{range.second} + 1);
+  }
+  progress_.total = queue_.size();
+  started_at_ = now;
+  finished_at_ = now;
+  running_ = !queue_.empty();
+  progress_.running = running_;
+  return queue_.size();
+}
+
+void DidScan::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) stopped_ = true;
+}
+
+bool DidScan::running() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+std::string DidScan::Request(const std::vector<std::uint16_t>& dids, bool open) const {
+  std::string request = "22";
+  char text[8];
+  for (std::uint16_t did : dids) {
+    std::snprintf(text, sizeof(text), "%04X", did);
+    request += text;
+  }
+  // One hex digit, 1-F, like the response counts the pipeline appends
+  if (!open && count_ > 0) request += "0123456789ABCDEF"[count_];
+  return request;
+}
+
+std::vector<std::string> DidScan::NextChunk() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> chunk;
+  if (!running_ || stopped_) return chunk;
+  std::vector<std::uint16_t> dids;
+  while (chunk.size() < kChunkSize) {
+    dids.clear();
+    if (!singles_.empty()) {
+      dids.push_back(singles_.front());
+      singles_.pop_front();
+    } else {
+      const std::size_t group = grouping_ ? kDidsPerRequest : 1;
+      while (dids.size() < group && !queue_.empty()) {
+        dids.push_back(queue_.front());
+        queue_.pop_front();
+      }
+    }
+    if (dids.empty()) break;
+    chunk.push_back(Request(dids, dids.size() == 1 && attempts_.count(dids[0]) != 0));
+  }
+  outstanding_ += chunk.size();
+  progress_.requests += chunk.size();
+  return chunk;
+}
+
+bool DidScan::Observe(const std::vector<CommandResult>& results, Clock::time_point now,
+                      std::vector<DidAnswer>* answers) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_) return false;
+  std::vector<std::uint16_t> dids;
+  for (const auto& result : results) {
+    outstanding_ -= std::min<std::size_t>(outstanding_, 1);
+    int sent_count = 0;
+    if (!ParseRequest(result.command, &dids, &sent_count)) continue;
+    progress_.last_did = dids.back();
+
+    if (result.status == CommandResult::Status::kCancelled) {
+      // The link is going away or the app took it back
+      stopped_ = true;
+      continue;
+    }
+    if (sent_count > 0 && Contains(result.lines, "?")) {
+      // Counts are ELM327 v1.3 and later; ask again without
+      counts_unsupported_ = true;
+      count_ = 0;
+      auto& queue = dids.size() > 1 ? queue_ : singles_;
+      queue.insert(queue.begin(), dids.begin(), dids.end());
+      continue;
+    }
+
+    LearnCount(sent_count, result);
+    if (dids.size() > 1) {
+      ObserveGroup(dids, result);
+      continue;
+    }
+    const std::uint16_t did = dids[0];
+    const DidState state = Classify(did, result, answers);
+    if (state != DidState::kUnknown) {
+      Resolve(did, state);
+    } else if (++attempts_[did] < kMaxAttempts) {
+      singles_.push_back(did);
+    } else {
+      ++progress_.probed;
+    }
+  }
+
+  const bool queued = !queue_.empty() || !singles_.empty();
+  if (outstanding_ > 0 || (queued && !stopped_)) return false;
+  Finish(now);
+  return true;
+}
+
+void DidScan::ObserveGroup(const std::vector<std::uint16_t>& dids, const CommandResult& result) {
+  bool settled = result.status == CommandResult::Status::kOk;
+  bool rejected = false;
+  for (const auto& message : AssembleElmReply(result.lines)) {
+    const auto& bytes = message.bytes;
+    if (!message.complete || bytes.size() < 3 || bytes[0] != 0x7F || bytes[1] != 0x22) {
+      // Data for some of them, or a message that did not make it
+      if (!bytes.empty()) settled = false;
+      continue;
+    }
+    const std::uint8_t nrc = bytes[2];
+    if (nrc == 0x13) {
+      // It takes one DID per request
+      grouping_ = false;
+      settled = false;
+    } else if (Transient(nrc) || Refusal(nrc)) {
+      settled = false;
+    } else {
+      rejected = true;
+    }
+  }
+
+  if (settled && (rejected || Contains(result.lines, "NO DATA"))) {
+    for (std::uint16_t did : dids) Resolve(did, DidState::kAbsent);
+  } else {
+    singles_.insert(singles_.end(), dids.begin(), dids.end());
+  }
+}
+
+void DidScan::Resolve(std::uint16_t did, DidState state) {
+  SetState(did, state);
+  ++progress_.probed;
+  switch (state) {
+    case DidState::kSupported:
+      ++progress_.supported;
+      break;
+    case DidState::kRefused:
+      ++progress_.refused;
+      break;
+    default:
+      ++progress_.absent;
+      break;
+  }
+}
+
+void DidScan::LearnCount(int sent_count, const CommandResult& result) {
+  if (result.status != CommandResult::Status::kOk || counts_unsupported_) return;
+  int responders = 0;
+  for (const auto& message : AssembleElmReply(result.lines)) {
+    // A pending answer counts as one message but is not the answer
+    if (!message.complete || (message.bytes.size() >= 3 && message.bytes[0] == 0x7F &&
+                              message.bytes[2] == 0x78)) {
+      responders = -1;
+      break;
+    }
+    ++responders;
+  }
+
+  if (sent_count > 0) {
+    // Someone answered late or not at all; the adapter waited out ATST
+    if (responders >= 0 && responders < sent_count && count_ == sent_count) {
+      count_ = 0;
+      streak_ = 0;
+      ++relearns_;
+    }
+    return;
+  }
+  if (responders <= 0 || responders > 0xF) return;
+  if (responders == candidate_) {
+    ++streak_;
+  } else {
+    candidate_ = responders;
+    streak_ = 1;
+  }
+  if (count_ == 0 && streak_ >= kLearnReplies && relearns_ < kMaxRelearns) count_ = candidate_;
+}
+
+DidState DidScan::Classify(std::uint16_t did, const CommandResult& result,
+                           std::vector<DidAnswer>* answers) {
+  if (result.status != CommandResult::Status::kOk) return DidState::kUnknown;
+
+  bool supported = false;
+  bool refused = false;
+  bool rejected = false;
+  bool unsure = false;
+  for (auto& message : AssembleElmReply(result.lines)) {
+    const auto& bytes = message.bytes;
+    if (bytes.size() < 3) continue;
+    if (bytes[0] == 0x62) {
+      // A late answer to an earlier request is not this DID's
+      if (((bytes[1] << 8) | bytes[2]) != did) continue;
+      if (!message.complete) {
+        unsure = true;
+        continue;
+      }
+      supported = true;
+      if (answers) {
+        answers->push_back({did, std::move(message.id),
+                            std::vector<std::uint8_t>(bytes.begin() + 3, bytes.end()), 0});
+      }
+    } else if (bytes[0] == 0x7F && bytes[1] == 0x22) {
+      const std::uint8_t nrc = bytes[2];
+      if (Transient(nrc)) {
+        unsure = true;
+      } else if (Refusal(nrc)) {
+        refused = true;
+        if (answers) answers->push_back({did, std::move(message.id), {}, nrc});
+      } else {
+        rejected = true;
+      }
+    }
+  }
+
+  if (supported) return DidState::kSupported;
+  if (refused) return DidState::kRefused;
+  if (unsure) return DidState::kUnknown;
+  if (rejected || Contains(result.lines, "NO DATA")) return DidState::kAbsent;
+  // "CAN ERROR", "BUFFER FULL", a reply cut off by the deadline...
+  return DidState::kUnknown;
+}
+
+void DidScan::Finish(Clock::time_point now) {
+  running_ = false;
+  progress_.stopped = stopped_ && progress_.probed < progress_.total;
+  queue_.clear();
+  singles_.clear();
+  attempts_.clear();
+  finished_at_ = now;
+}
+
+DidScanProgress DidScan::Progress(Clock::time_point now) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DidScanProgress progress = progress_;
+  progress.running = running_;
+  progress.count = count_;
+  const Clock::time_point end = running_ ? now : finished_at_;
+  if (end > started_at_) {
+    progress.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - started_at_);
+  }
+  const double seconds = static_cast<double>(progress.elapsed.count()) / 1e6;
+  if (seconds > 0) {
+    progress.dids_per_second = static_cast<double>(progress.probed) / seconds;
+    progress.hits_per_second = static_cast<double>(progress.supported + progress.refused) / seconds;
+  }
+  return progress;
+}
+
+}  // namespace flutter_bluetooth_classic
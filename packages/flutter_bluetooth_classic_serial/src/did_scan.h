@@ -0,0 +1,183 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_DID_SCAN_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_DID_SCAN_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "command_pipeline.h"
+
+namespace flutter_bluetooth_classic {
+
+// What a scan has found out about one DID, two bits of the scan bitmap.
+enum class DidState : std::uint8_t {
+  // Not answered for certain yet; the next scan probes it.
+  kUnknown = 0,
+  // Some ECU returned data for it.
+  kSupported = 1,
+  // Some ECU has it but would not read it out (7F 22 22 conditions not
+  // correct, 7F 22 33 security access denied).
+  kRefused = 2,
+  // Every ECU that answered rejected it (7F 22 31 and the like), or none
+  // answered at all.
+  kAbsent = 3,
+};
+
+// One ECU's answer to a DID that is there: its data, or its refusal.
+struct DidAnswer {
+  std::uint16_t did = 0;
+  // The CAN ID it answered from; empty without headers.
+  std::string ecu;
+  // The data after 62 did; empty for a refusal.
+  std::vector<std::uint8_t> bytes;
+  // The refusal's code, 0 for data.
+  std::uint8_t nrc = 0;
+};
+
+struct DidScanProgress {
+  bool running = false;
+  // Ended by Stop() or a cancelled request before every DID was probed.
+  bool stopped = false;
+  // DIDs the run probes (the unknown ones of its ranges), and those done
+  // with: resolved, or given up on after kMaxAttempts.
+  std::size_t total = 0;
+  std::size_t probed = 0;
+  std::size_t supported = 0;
+  std::size_t refused = 0;
+  std::size_t absent = 0;
+  // Requests sent, retries included.
+  std::uint64_t requests = 0;
+  // The last DID a result came in for.
+  std::uint16_t last_did = 0;
+  // Response count appended to the requests; 0 while open-ended.
+  int count = 0;
+  std::chrono::microseconds elapsed{0};
+  double dids_per_second = 0;
+  // Supported and refused DIDs found per second.
+  double hits_per_second = 0;
+};
+
+// Probes Mode 22 DIDs for a scan, a chunk of requests at a time, and keeps
+// what each probe found in a bitmap the app persists per vehicle, so a
+// stopped scan resumes where it was and a rescan only probes the DIDs
+// still unknown.
+//
+// Requests go to every ECU (functional addressing) and each reply is
+// split per ECU by its CAN ID, so one request finds a DID in any module.
+// Absent DIDs are the bulk of any range, so unknown DIDs are first asked
+// for kDidsPerRequest at a time: an ECU answers such a request with 7F 22
+// 31 only if it has none of them, which settles them all in one round
+// trip. Any other answer (data, a refusal, an unsure one) has its DIDs
+// asked for one per request, since the data of several DIDs cannot be
+// told apart without their lengths. An ECU answering 7F 22 13 to a
+// grouped request turns grouping off for the run.
+//
+// Once kLearnReplies open-ended replies in a row had the same number of
+// ECUs answer, that count is appended to the requests (22F1902), so the
+// adapter returns the prompt as soon as every ECU has answered instead of
+// waiting out ATST for more: on a bus where every ECU answers every DID,
+// positively or with 7F 22 31, no request waits out the timeout. A counted
+// reply with fewer answers drops the count; the count is relearned up to
+// kMaxRelearns times. An adapter that answers "?" to a count turns it off.
+//
+// A DID whose reply says nothing for certain (a timeout, 7F 22 21 busy,
+// 7F 22 78 response pending, a message cut short) is probed again
+// open-ended at the end of the run, up to kMaxAttempts times, and stays
+// unknown if it never resolves. A cancelled request ends the run.
+//
+// Start(), Stop() and Progress() run on any thread; NextChunk() and
+// Observe() on the link's receive thread.
+class DidScan {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Range = std::pair<std::uint16_t, std::uint16_t>;
+
+  static constexpr std::size_t kDids = 0x10000;
+  // Two bits per DID, DID d in byte d / 4 from the low bits up.
+  static constexpr std::size_t kBitmapBytes = kDids / 4;
+  // Requests per chunk.
+  static constexpr std::size_t kChunkSize = 16;
+  // 22 and three DIDs fill a single CAN frame.
+  static constexpr std::size_t kDidsPerRequest = 3;
+  static constexpr int kLearnReplies = 4;
+  static constexpr int kMaxRelearns = 3;
+  static constexpr int kMaxAttempts = 3;
+
+  DidScan();
+  DidScan(const DidScan&) = delete;
+  DidScan& operator=(const DidScan&) = delete;
+
+  // Replaces the DID states with a bitmap from Bitmap(). Returns false,
+  // leaving every DID unknown, if |bitmap| is not one.
+  bool Load(const std::vector<std::uint8_t>& bitmap);
+  std::vector<std::uint8_t> Bitmap() const;
+  DidState state(std::uint16_t did) const;
+
+  // Starts a run over the unknown DIDs of |ranges| (first and last DID,
+  // inclusive; overlaps are probed once), in DID order. Returns the number
+  // of DIDs it probes, 0 if a run is going already.
+  std::size_t Start(std::vector<Range> ranges, Clock::time_point now);
+  // Sends no more requests; the run ends with the chunks under way.
+  void Stop();
+  bool running() const;
+
+  // The next requests to send, empty once the run is stopped or every DID
+  // has been sent.
+  std::vector<std::string> NextChunk();
+
+  // Reports the results of a chunk from NextChunk(), appending every ECU's
+  // data or refusal to |answers|. Returns true if that ended the run.
+  bool Observe(const std::vector<CommandResult>& results, Clock::time_point now,
+               std::vector<DidAnswer>* answers);
+
+  DidScanProgress Progress(Clock::time_point now) const;
+
+ private:
+  // The request line for |dids|, counted unless |open|.
+  std::string Request(const std::vector<std::uint16_t>& dids, bool open) const;
+  // Settles the DIDs of a grouped request if every ECU rejected them, else
+  // queues them to be asked for singly. Lock held.
+  void ObserveGroup(const std::vector<std::uint16_t>& dids, const CommandResult& result);
+  void Resolve(std::uint16_t did, DidState state);
+  // The state a reply resolves |did| to, kUnknown if it does not. Lock
+  // held.
+  DidState Classify(std::uint16_t did, const CommandResult& result,
+                    std::vector<DidAnswer>* answers);
+  // Learns the response count from the number of ECUs in a reply sent
+  // with |sent_count|. Lock held.
+  void LearnCount(int sent_count, const CommandResult& result);
+  void SetState(std::uint16_t did, DidState state);
+  void Finish(Clock::time_point now);
+
+  mutable std::mutex mutex_;
+  std::vector<std::uint8_t> bitmap_;
+  // DIDs not asked for yet, and those to ask for one per request, which go
+  // first.
+  std::deque<std::uint16_t> queue_;
+  std::deque<std::uint16_t> singles_;
+  bool grouping_ = true;
+  // Failed tries of DIDs to be probed again; they go open-ended.
+  std::map<std::uint16_t, int> attempts_;
+  // Requests sent whose results have not come in.
+  std::size_t outstanding_ = 0;
+  bool running_ = false;
+  bool stopped_ = false;
+  int count_ = 0;
+  int candidate_ = 0;
+  int streak_ = 0;
+  int relearns_ = 0;
+  bool counts_unsupported_ = false;
+  DidScanProgress progress_;
+  Clock::time_point started_at_;
+  Clock::time_point finished_at_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_DID_SCAN_H_
@@ -0,0 +1,369 @@
+#include "ecu_values.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+#include "elm327_reply.h"
+#include "hex_decode.h"
+#include "mode01_packer.h"
+#include "pid_decoder.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Hex OBD requests as submitted, without a response count.
+bool IsRequest(const std::string& command) {
+  if (command.size() < 4 || command.size() % 2 != 0) return false;
+  for (char c : command) {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+  }
+  return true;
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  return std::toupper(static_cast<unsigned char>(c)) - 'A' + 10;
+}
+
+// The ATSH header that reaches only the ECU answering from |id|: 18DAF110
+// answers DA10F1 (priority 18 is the adapter's default), 7E8-7EF answer
+// 7E0-7E7. Empty for IDs whose request ID cannot be derived.
+std::string PhysicalHeader(const std::string& id) {
+  if (id.size() == 8 && id.compare(0, 4, "18DA") == 0) {
+    return "DA" + id.substr(6, 2) + id.substr(4, 2);
+  }
+  if (id.size() == 3 && id.compare(0, 2, "7E") == 0 && std::isxdigit(static_cast<unsigned char>(id[2]))) {
+    const int low = HexValue(id[2]);
+    if (low >= 8) return std::string("7E") + "0123456789ABCDEF"[low - 8];
+  }
+  return std::string();
+}
+
+bool Contains(const std::vector<std::string>& ids, const std::string& id) {
+  return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+std::string Mode01Command(std::uint8_t pid) {
+  char command[8];
+  std::snprintf(command, sizeof(command), "01%02X", pid);
+  return command;
+}
+
+}  // namespace
+
+void EcuValues::SetPolicy(const std::string& command, EcuPolicy policy,
+                          const std::string& preferred) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  policies_[command] = {policy, preferred};
+}
+
+void EcuValues::SetRouting(bool enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  routing_ = enabled;
+}
+
+bool EcuValues::routing() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return routing_ && !unsupported_;
+}
+
+std::string EcuValues::Route(const std::string& command) {
+  if (!IsRequest(command)) return std::string();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!routing_ || unsupported_) return std::string();
+  auto it = owners_.find(command);
+  if (it == owners_.end() || it->second.owner.empty()) return std::string();
+  if (++it->second.sends % kRecheckInterval == 0) return std::string();
+  return PhysicalHeader(it->second.owner);
+}
+
+std::string EcuValues::FunctionalHeader() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!heard_) return std::string();
+  return extended_ ? "DB33F1" : "7DF";
+}
+
+void EcuValues::ObserveRoute(bool accepted) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (accepted) {
+    ++header_changes_;
+  } else {
+    unsupported_ = true;
+  }
+}
+
+void EcuValues::Observe(const std::string& command, bool routed, const CommandResult& result) {
+  if (result.status == CommandResult::Status::kWriteFailed ||
+      result.status == CommandResult::Status::kCancelled || !IsRequest(command)) {
+    return;
+  }
+  std::uint8_t request[kMaxMode01PidsPerRequest + 1];
+  const std::size_t size = command.size() / 2;
+  if (size > sizeof(request) || DecodeHex(command.data(), command.size(), request) != size) {
+    // Longer requests carry no PID this tracks; their responders still count
+    std::fill(request, request + sizeof(request), 0);
+    if (DecodeHex(command.data(), 2, request) != 1) return;
+  }
+  const std::uint8_t service = request[0];
+
+  // Sort the ECUs into positive and negative answers
+  std::vector<std::string> positive;
+  std::vector<std::pair<std::string, std::uint8_t>> negative;
+  const bool ok = result.status == CommandResult::Status::kOk;
+  std::vector<ElmMessage> messages;
+  if (ok) messages = AssembleElmReply(result.lines);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& message : messages) {
+    // Without headers there is nothing to tell the ECUs apart by
+    if (message.id.empty() || !message.complete || message.bytes.empty()) continue;
+    heard_ = true;
+    if (message.id.size() == 8) extended_ = true;
+    const auto& bytes = message.bytes;
+    if (bytes[0] == static_cast<std::uint8_t>(service + 0x40)) {
+      positive.push_back(message.id);
+    } else if (bytes.size() >= 3 && bytes[0] == 0x7F && bytes[1] == service) {
+      negative.emplace_back(message.id, bytes[2]);
+    }
+  }
+
+  auto owner_it = owners_.find(command);
+  if (owner_it == owners_.end() && owners_.size() < kMaxCommands) {
+    owner_it = owners_.emplace(command, Ownership()).first;
+  }
+  std::string owner;
+  if (owner_it != owners_.end()) {
+    owner = owner_it->second.owner;
+    if (ok || result.status == CommandResult::Status::kTimedOut) {
+      Learn(&owner_it->second, PolicyOf(command), positive, routed);
+    }
+  }
+
+  // The single-PID requests the reply answers, and the values it carries
+  std::vector<std::string> keys;
+  Mode01Reply reply;
+  if (service == 0x01 && size >= 2 && size <= kMaxMode01PidsPerRequest + 1) {
+    for (std::size_t i = 1; i < size; ++i) keys.push_back(Mode01Command(request[i]));
+    if (ok) {
+      SplitMode01Reply(result.lines, std::vector<std::uint8_t>(request + 1, request + size),
+                       &reply);
+    }
+  } else {
+    keys.push_back(command);
+  }
+
+  for (const auto& key : keys) {
+    if (values_.find(key) == values_.end() && values_.size() >= kMaxCommands) continue;
+    std::vector<std::string> answered;
+    for (std::size_t e = 0; e < reply.ecus.size(); ++e) {
+      if (reply.ids[e].empty()) continue;
+      for (const auto& data : reply.ecus[e]) {
+        const PidDescriptor* pid = FindPid(0x01, data.pid);
+        if (!pid || Mode01Command(data.pid) != key) continue;
+        double value = 0;
+        if (!DecodePid(*pid, data.bytes.data(), data.bytes.size(), &value)) continue;
+        EcuReading* reading = Reading(key, reply.ids[e]);
+        if (!reading) continue;
+        reading->has_value = true;
+        reading->value = value;
+        reading->at = result.completed_at;
+        answered.push_back(reply.ids[e]);
+      }
+    }
+    // Positive answers the table cannot decode: responders only
+    if (keys.size() == 1) {
+      for (const auto& id : positive) {
+        if (!Contains(answered, id) && Reading(key, id)) answered.push_back(id);
+      }
+    }
+    for (const auto& id : answered) {
+      EcuReading* reading = Reading(key, id);
+      reading->failures = 0;
+      reading->nrc = 0;
+      ++reading->answers;
+    }
+    for (const auto& rejected : negative) {
+      EcuReading* reading = Reading(key, rejected.first);
+      if (!reading) continue;
+      ++reading->failures;
+      reading->nrc = rejected.second;
+      answered.push_back(rejected.first);
+    }
+    // Known ECUs that said nothing; routed, only the owner was asked
+    auto it = values_.find(key);
+    if (it == values_.end()) continue;
+    for (auto& reading : it->second) {
+      if (Contains(answered, reading.ecu) || (routed && reading.ecu != owner)) continue;
+      ++reading.failures;
+    }
+  }
+}
+
+EcuReading* EcuValues::Reading(const std::string& command, const std::string& ecu) {
+  auto& readings = values_[command];
+  for (auto& reading : readings) {
+    if (reading.ecu == ecu) return &reading;
+  }
+  if (readings.size() >= kMaxEcus) return nullptr;
+  readings.emplace_back();
+  readings.back().ecu = ecu;
+  return &readings.back();
+}
+
+EcuValues::Policy EcuValues::PolicyOf(const std::string& command) const {
+  auto it = policies_.find(command);
+  if (it != policies_.end()) return it->second;
+  if (command.compare(0, 2, "01") != 0) return Policy();
+  for (std::size_t i = 2; i + 2 <= command.size(); i += 2) {
+    it = policies_.find("01" + command.substr(i, 2));
+    if (it != policies_.end() && it->second.policy != EcuPolicy::kPreferred) {
+      return {it->second.policy, std::string()};
+    }
+  }
+  return Policy();
+}
+
+void EcuValues::Learn(Ownership* ownership, const Policy& policy,
+                      const std::vector<std::string>& positive, bool routed) {
+  if (routed) {
+    if (Contains(positive, ownership->owner)) {
+      ownership->misses = 0;
+    } else if (++ownership->misses >= kMaxMisses) {
+      Drop(ownership);
+    }
+    return;
+  }
+  // Combining policies need every ECU's answer
+  if (policy.policy != EcuPolicy::kPreferred) {
+    ownership->owner.clear();
+    return;
+  }
+  if (!ownership->owner.empty()) {
+    // A recheck
+    if (!Contains(positive, ownership->owner)) Drop(ownership);
+    return;
+  }
+  if (ownership->relearns >= kMaxRelearns) return;
+  if (!policy.preferred.empty() && Contains(positive, policy.preferred) &&
+      !PhysicalHeader(policy.preferred).empty()) {
+    ownership->owner = policy.preferred;
+    return;
+  }
+  if (positive.size() != 1 || PhysicalHeader(positive[0]).empty()) {
+    ownership->streak = 0;
+    return;
+  }
+  if (positive[0] == ownership->candidate) {
+    ++ownership->streak;
+  } else {
+    ownership->candidate = positive[0];
+    ownership->streak = 1;
+  }
+  if (ownership->streak >= kLearnReplies) ownership->owner = ownership->candidate;
+}
+
+void EcuValues::Drop(Ownership* ownership) {
+  ownership->owner.clear();
+  ownership->candidate.clear();
+  ownership->streak = 0;
+  ownership->misses = 0;
+  ++ownership->relearns;
+}
+
+bool EcuValues::Select(const std::string& command, Clock::time_point now, double* value,
+                       std::string* ecu) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return SelectLocked(command, now, value, ecu);
+}
+
+bool EcuValues::SelectLocked(const std::string& command, Clock::time_point now, double* value,
+                             std::string* ecu) const {
+  auto it = values_.find(command);
+  if (it == values_.end()) return false;
+  std::vector<const EcuReading*> fresh;
+  for (const auto& reading : it->second) {
+    if (reading.has_value && now - reading.at <= kMaxAge) fresh.push_back(&reading);
+  }
+  if (fresh.empty()) return false;
+
+  Policy policy;
+  auto policy_it = policies_.find(command);
+  if (policy_it != policies_.end()) policy = policy_it->second;
+  const EcuReading* picked = nullptr;
+  switch (policy.policy) {
+    case EcuPolicy::kPreferred: {
+      std::string preferred = policy.preferred;
+      if (preferred.empty()) {
+        auto owner_it = owners_.find(command);
+        if (owner_it != owners_.end()) preferred = owner_it->second.owner;
+      }
+      for (const auto* reading : fresh) {
+        if (reading->ecu == preferred) picked = reading;
+      }
+      if (!picked) {
+        picked = *std::max_element(fresh.begin(), fresh.end(),
+                                   [](const EcuReading* a, const EcuReading* b) {
+                                     return a->at < b->at;
+                                   });
+      }
+      break;
+    }
+    case EcuPolicy::kMax:
+      picked = *std::max_element(
+          fresh.begin(), fresh.end(),
+          [](const EcuReading* a, const EcuReading* b) { return a->value < b->value; });
+      break;
+    case EcuPolicy::kConsensus: {
+      // The lower median: a value some ECU actually reported
+      auto middle = fresh.begin() + static_cast<std::ptrdiff_t>((fresh.size() - 1) / 2);
+      std::nth_element(
+          fresh.begin(), middle, fresh.end(),
+          [](const EcuReading* a, const EcuReading* b) { return a->value < b->value; });
+      picked = *middle;
+      break;
+    }
+  }
+  *value = picked->value;
+  if (ecu) *ecu = picked->ecu;
+  return true;
+}
+
+std::vector<EcuValueStats> EcuValues::Snapshot(Clock::time_point now) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<EcuValueStats> snapshot;
+  snapshot.reserve(values_.size());
+  for (const auto& it : values_) {
+    EcuValueStats stats;
+    stats.command = it.first;
+    auto policy_it = policies_.find(it.first);
+    if (policy_it != policies_.end()) {
+      stats.policy = policy_it->second.policy;
+      stats.preferred = policy_it->second.preferred;
+    }
+    auto owner_it = owners_.find(it.first);
+    if (owner_it != owners_.end()) stats.owner = owner_it->second.owner;
+    stats.selected = SelectLocked(it.first, now, &stats.value, &stats.selected_ecu);
+    stats.ecus = it.second;
+    snapshot.push_back(std::move(stats));
+  }
+  return snapshot;
+}
+
+std::uint64_t EcuValues::header_changes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return header_changes_;
+}
+
+void EcuValues::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  owners_.clear();
+  values_.clear();
+  unsupported_ = false;
+  extended_ = false;
+  heard_ = false;
+  header_changes_ = 0;
+}
+
+}  // namespace flutter_bluetooth_classic
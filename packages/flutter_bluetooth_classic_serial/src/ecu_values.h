@@ -0,0 +1,184 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_ECU_VALUES_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_ECU_VALUES_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "command_pipeline.h"
+
+namespace flutter_bluetooth_classic {
+
+// How one value is picked when several ECUs report a PID.
+enum class EcuPolicy {
+  // The preferred ECU's value (the owner's if none is set), else the most
+  // recent one.
+  kPreferred,
+  // The highest value, e.g. battery voltage, which the charging ECU reads
+  // closest to the alternator.
+  kMax,
+  // The median, so one ECU reporting nonsense is outvoted.
+  kConsensus,
+};
+
+// One ECU's latest answer to one PID.
+struct EcuReading {
+  // The CAN ID it answers from ("18DAF110", "7E8").
+  std::string ecu;
+  bool has_value = false;
+  double value = 0;
+  // When |value| arrived.
+  std::chrono::steady_clock::time_point at;
+  // Replies in a row without a value from it: negative, missing or timed
+  // out.
+  int failures = 0;
+  // Code of its last negative response (7F xx nrc), 0 if none.
+  std::uint8_t nrc = 0;
+  // Positive answers, with or without a value the PID table decodes.
+  std::uint64_t answers = 0;
+};
+
+struct EcuValueStats {
+  // The single-PID request ("0142", "22F190").
+  std::string command;
+  EcuPolicy policy = EcuPolicy::kPreferred;
+  std::string preferred;
+  // The ECU requests for the command go to; empty while they are
+  // functionally addressed.
+  std::string owner;
+  // The value |policy| picks from the fresh readings, if any.
+  bool selected = false;
+  double value = 0;
+  std::string selected_ecu;
+  // In the order the ECUs were first heard.
+  std::vector<EcuReading> ecus;
+};
+
+// Keeps the latest value and failure state of every (PID, ECU) pair heard
+// in OBD replies with headers (ATH1), and picks one value per PID by the
+// PID's policy. Values are decoded with the PID table, so Mode 01 PIDs the
+// table knows get values (packed requests included); other requests are
+// tracked for their responders only.
+//
+// It also learns which ECU owns each request: one that kLearnReplies
+// functionally addressed replies in a row had exactly that ECU answer
+// positively, or the preferred ECU once it answered. With routing on,
+// Route() then names the owner's physical request header (ATSH), so ECUs
+// that do not have the PID stop answering 7F to every request. A request
+// with the kMax or kConsensus policy needs every ECU and stays functional.
+// kMaxMisses routed replies in a row without the owner's answer send the
+// request back to functional addressing to learn again, as does every
+// kRecheckInterval-th send, in case another ECU took over; a request whose
+// owner changed kMaxRelearns times stays functional. An adapter that
+// rejects ATSH turns routing off for the link.
+//
+// Route() and Observe() run on the link's receive thread, everything else
+// on any thread.
+class EcuValues {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int kLearnReplies = 3;
+  static constexpr int kMaxMisses = 3;
+  static constexpr std::uint32_t kRecheckInterval = 200;
+  static constexpr int kMaxRelearns = 3;
+  // Readings older than this are not selected.
+  static constexpr auto kMaxAge = std::chrono::seconds(5);
+  // Requests beyond this many (a DID scan) are not tracked, nor are ECUs
+  // beyond kMaxEcus per request.
+  static constexpr std::size_t kMaxCommands = 256;
+  static constexpr std::size_t kMaxEcus = 8;
+
+  EcuValues() = default;
+  EcuValues(const EcuValues&) = delete;
+  EcuValues& operator=(const EcuValues&) = delete;
+
+  // Sets the policy of the single-PID request |command|.
+  void SetPolicy(const std::string& command, EcuPolicy policy,
+                 const std::string& preferred = std::string());
+
+  // Turns physical addressing of owned requests on or off.
+  void SetRouting(bool enabled);
+  bool routing() const;
+
+  // The owner's physical header for |command| in ATSH form ("DA10F1",
+  // "7E0"). Empty if it is to go out under the header in effect: routing
+  // is off or unsupported, |command| is not a hex request, has no owner or
+  // is due a functional recheck.
+  std::string Route(const std::string& command);
+
+  // Reports whether an ATSH change was accepted.
+  void ObserveRoute(bool accepted);
+
+  // Reports the result of |command|, sent to its owner (|routed|) or to
+  // every ECU.
+  void Observe(const std::string& command, bool routed, const CommandResult& result);
+
+  // The value |command|'s policy picks from readings no older than kMaxAge
+  // at |now|. False if there is none.
+  bool Select(const std::string& command, Clock::time_point now, double* value,
+              std::string* ecu = nullptr) const;
+
+  // Every tracked single-PID request, in command order.
+  std::vector<EcuValueStats> Snapshot(Clock::time_point now) const;
+  // ATSH changes made so far.
+  std::uint64_t header_changes() const;
+
+  // The functional request header in ATSH form, empty until an ECU has
+  // been heard.
+  std::string FunctionalHeader() const;
+
+  static bool IsFunctional(const std::string& header) {
+    return header == "7DF" || header == "DB33F1";
+  }
+
+  // Forgets everything but the policies and the routing setting, e.g. for
+  // another vehicle.
+  void Reset();
+
+ private:
+  struct Ownership {
+    std::string owner;
+    std::string candidate;
+    int streak = 0;
+    int misses = 0;
+    int relearns = 0;
+    std::uint32_t sends = 0;
+  };
+
+  struct Policy {
+    EcuPolicy policy = EcuPolicy::kPreferred;
+    std::string preferred;
+  };
+
+  // |ecu|'s reading of |command|, added if there is room; lock held.
+  EcuReading* Reading(const std::string& command, const std::string& ecu);
+  // The policy that decides |command|'s routing: a packed Mode 01 request
+  // takes the first combining policy of its PIDs; lock held.
+  Policy PolicyOf(const std::string& command) const;
+  void Learn(Ownership* ownership, const Policy& policy, const std::vector<std::string>& positive,
+             bool routed);
+  static void Drop(Ownership* ownership);
+  bool SelectLocked(const std::string& command, Clock::time_point now, double* value,
+                    std::string* ecu) const;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Ownership> owners_;
+  // Single-PID request to its readings
+  std::map<std::string, std::vector<EcuReading>> values_;
+  std::map<std::string, Policy> policies_;
+  bool routing_ = false;
+  bool unsupported_ = false;
+  // Any 29-bit ID heard, so the functional header is 29-bit too.
+  bool extended_ = false;
+  bool heard_ = false;
+  std::uint64_t header_changes_ = 0;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_ECU_VALUES_H_
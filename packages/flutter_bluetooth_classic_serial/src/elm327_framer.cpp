@@ -0,0 +1,102 @@
+#include "elm327_framer.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+bool StartsWith(const std::string& text, const char* prefix) {
+  return text.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+}
+
+bool EqualsIgnoringSpaceAndCase(const std::string& a, const std::string& b) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  auto upper = [](char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 32) : c; };
+  while (true) {
+    while (i < a.size() && a[i] == ' ') ++i;
+    while (j < b.size() && b[j] == ' ') ++j;
+    if (i == a.size() || j == b.size()) return i == a.size() && j == b.size();
+    if (upper(a[i]) != upper(b[j])) return false;
+    ++i;
+    ++j;
+  }
+}
+
+}  // namespace
+
+bool IsElmNoiseLine(const std::string& line) {
+  if (StartsWith(line, "SEARCHING")) return true;
+  if (StartsWith(line, "BUS INIT")) {
+    // "BUS INIT: ...ERROR" is the actual answer and must reach the parser.
+    return line.find("ERROR") == std::string::npos;
+  }
+  return false;
+}
+
+void Elm327Framer::ExpectEcho(std::string command) { expected_echo_ = std::move(command); }
+
+std::size_t Elm327Framer::Feed(const std::uint8_t* data, std::size_t length,
+                               Clock::time_point now, std::vector<ElmResponse>* completed) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < length; ++i) {
+    char c = static_cast<char>(data[i]);
+    if (c == '\0') continue;
+    if (!started_) {
+      started_ = true;
+      current_.first_byte_at = now;
+    }
+    switch (c) {
+      case '\r':
+      case '\n':
+        EndLine();
+        break;
+      case '>':
+        EndLine();
+        EndResponse(now, completed);
+        ++count;
+        break;
+      default:
+        line_.push_back(c);
+        break;
+    }
+  }
+  return count;
+}
+
+void Elm327Framer::Reset() {
+  line_.clear();
+  current_ = ElmResponse();
+  started_ = false;
+}
+
+void Elm327Framer::EndLine() {
+  std::size_t begin = line_.find_first_not_of(' ');
+  if (begin == std::string::npos) {
+    line_.clear();
+    return;
+  }
+  std::size_t end = line_.find_last_not_of(' ');
+  std::string line = line_.substr(begin, end - begin + 1);
+  line_.clear();
+
+  if (current_.lines.empty() && !expected_echo_.empty() &&
+      EqualsIgnoringSpaceAndCase(line, expected_echo_)) {
+    expected_echo_.clear();
+    return;
+  }
+  if (IsElmNoiseLine(line)) return;
+  current_.lines.push_back(std::move(line));
+}
+
+void Elm327Framer::EndResponse(Clock::time_point now, std::vector<ElmResponse>* completed) {
+  current_.completed_at = now;
+  completed->push_back(std::move(current_));
+  current_ = ElmResponse();
+  started_ = false;
+  // An echo can only lead the response to the command it belongs to.
+  expected_echo_.clear();
+}
+
+}  // namespace flutter_bluetooth_classic
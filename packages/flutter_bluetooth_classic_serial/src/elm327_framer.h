@@ -0,0 +1,66 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_ELM327_FRAMER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_ELM327_FRAMER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// One complete adapter response: everything between two '>' prompts.
+struct ElmResponse {
+  using Clock = std::chrono::steady_clock;
+
+  // Trimmed, non-empty lines without the command echo and without
+  // SEARCHING... / BUS INIT progress noise.
+  std::vector<std::string> lines;
+  Clock::time_point first_byte_at;
+  // When the '>' prompt arrived.
+  Clock::time_point completed_at;
+};
+
+// Splits the ELM327 byte stream into one ElmResponse per command.
+//
+// Each byte is looked at once: '\r' and '\n' end a line, '>' ends the
+// response, NULs (sent by some clones) are dropped. Nothing is rescanned, so
+// cost is linear in the bytes received. Not thread-safe: owned by the
+// receive thread.
+class Elm327Framer {
+ public:
+  using Clock = ElmResponse::Clock;
+
+  // The command that was just written (without the trailing CR). If the
+  // next response starts with it, that line is the echo (ATE1) and is
+  // dropped.
+  void ExpectEcho(std::string command);
+
+  // Consumes received bytes and appends every response that completes to
+  // |completed|. Returns the number of responses appended.
+  std::size_t Feed(const std::uint8_t* data, std::size_t length, Clock::time_point now,
+                   std::vector<ElmResponse>* completed);
+
+  // Drops a partially received response, e.g. after a timeout.
+  void Reset();
+
+  // True while bytes of an unfinished response are buffered.
+  bool in_progress() const { return started_; }
+
+ private:
+  void EndLine();
+  void EndResponse(Clock::time_point now, std::vector<ElmResponse>* completed);
+
+  std::string expected_echo_;
+  std::string line_;
+  ElmResponse current_;
+  bool started_ = false;
+};
+
+// True for adapter progress lines that carry no response data:
+// "SEARCHING..." and "BUS INIT: ..." (unless the init ended in ERROR).
+bool IsElmNoiseLine(const std::string& line);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_ELM327_FRAMER_H_
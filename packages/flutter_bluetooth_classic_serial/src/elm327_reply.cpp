@@ -0,0 +1,194 @@
+#include "elm327_reply.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <utility>
+
+#include "hex_decode.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Longest line taken as a frame once spaces are dropped: a 29-bit id and
+// eight bytes is 24 digits, a headerless KWP line a few more.
+constexpr std::size_t kMaxHex = 64;
+
+// A message still waiting for consecutive frames or segments.
+struct OpenMessage {
+  std::size_t index;
+  std::size_t expected;
+  // Low nibble of the next sequence number (headered) or segment index.
+  unsigned next;
+};
+
+int HexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Adds |data| to an open message. Returns false once the message is done,
+// complete or not.
+bool Continue(OpenMessage* open, unsigned sequence, const std::uint8_t* data, std::size_t size,
+              std::vector<ElmMessage>* messages, std::vector<bool>* broken) {
+  auto& bytes = (*messages)[open->index].bytes;
+  // A lost, repeated or reordered frame, or one cut short before the last
+  // (only the last carries fewer than seven bytes, or six in segment 0):
+  // what follows cannot be placed
+  const std::size_t full = bytes.empty() ? 6 : 7;
+  if (sequence != open->next || (size < full && bytes.size() + size < open->expected)) {
+    (*broken)[open->index] = true;
+    return false;
+  }
+  bytes.insert(bytes.end(), data, data + size);
+  open->next = (open->next + 1) & 0x0F;
+  return bytes.size() < open->expected;
+}
+
+}  // namespace
+
+std::vector<ElmMessage> AssembleElmReply(const std::vector<std::string>& lines) {
+  std::vector<ElmMessage> messages;
+  // ISO-TP length of each message; 0 for single frames
+  std::vector<std::size_t> expected;
+  // Messages that lost a frame or segment
+  std::vector<bool> broken;
+  // Headerless multi-frame message the "N:" segments belong to
+  OpenMessage segmented = {0, 0, 0};
+  bool segmenting = false;
+  // Headered first frames still waiting for consecutive frames, by CAN ID
+  std::vector<OpenMessage> open;
+  char hex[kMaxHex];
+  std::uint8_t frame[kMaxHex / 2];
+
+  auto start = [&](std::string id, const std::uint8_t* data, std::size_t size,
+                   std::size_t length) {
+    messages.push_back({std::move(id), std::vector<std::uint8_t>(data, data + size), true});
+    expected.push_back(length);
+    broken.push_back(false);
+  };
+
+  for (const auto& line : lines) {
+    std::size_t size = 0;
+    bool fits = true;
+    for (char c : line) {
+      if (c == ' ') continue;
+      if (size == kMaxHex) {
+        fits = false;
+        break;
+      }
+      hex[size++] = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (size == 0 || !fits) continue;
+
+    // Headerless multi-frame: "N:" segments numbered from 0, wrapping at F
+    const char* colon = static_cast<const char*>(std::memchr(hex, ':', size));
+    if (colon) {
+      const std::size_t at = static_cast<std::size_t>(colon - hex);
+      if (at == 0 || at > 2 || !segmenting) continue;
+      const int low = HexDigit(hex[at - 1]);
+      const std::size_t data = size - at - 1;
+      if (low < 0 || (at == 2 && HexDigit(hex[0]) < 0) ||
+          DecodeHex(colon + 1, data, frame) == kInvalidHex) {
+        continue;
+      }
+      segmenting = Continue(&segmented, static_cast<unsigned>(low), frame, data / 2, &messages,
+                            &broken);
+      continue;
+    }
+
+    // ... after a line with the total length
+    if (size == 3) {
+      const int digits[3] = {HexDigit(hex[0]), HexDigit(hex[1]), HexDigit(hex[2])};
+      if (digits[0] < 0 || digits[1] < 0 || digits[2] < 0) continue;
+      // A message still open there lost its last segments
+      if (segmenting) broken[segmented.index] = true;
+      start(std::string(), frame, 0,
+            static_cast<std::size_t>(digits[0] << 8 | digits[1] << 4 | digits[2]));
+      segmented = {messages.size() - 1, expected.back(), 0};
+      segmenting = true;
+      continue;
+    }
+
+    // 11-bit headers make the line odd; 29-bit OBD replies come from 18DA..
+    std::size_t header = 0;
+    if (size % 2 == 1) {
+      // Too short for an ID and a PCI byte: "?" and the like
+      if (size < 5) continue;
+      header = 3;
+    } else if (size >= 10 && std::memcmp(hex, "18DA", 4) == 0) {
+      header = 8;
+    }
+    const std::size_t length = (size - header) / 2;
+    if (length == 0 || DecodeHex(hex + header, size - header, frame) == kInvalidHex) continue;
+    if (header == 0) {
+      start(std::string(), frame, length, 0);
+      continue;
+    }
+
+    auto open_it = std::find_if(open.begin(), open.end(), [&](const OpenMessage& message) {
+      return messages[message.index].id.compare(0, std::string::npos, hex, header) == 0;
+    });
+    switch (frame[0] >> 4) {
+      case 0x0: {
+        // Single frame: cut to its PCI length (the rest is padding)
+        const std::size_t declared = frame[0] & 0x0F;
+        if (declared == 0) break;
+        start(std::string(hex, header), frame + 1, std::min(declared, length - 1), 0);
+        if (declared > length - 1) broken.back() = true;
+        break;
+      }
+      case 0x1: {
+        // First frame: 12-bit length, or 0 and a 32-bit one (ISO 15765-2:2016)
+        if (length < 2) break;
+        std::size_t total = static_cast<std::size_t>(frame[0] & 0x0F) << 8 | frame[1];
+        std::size_t offset = 2;
+        if (total == 0) {
+          if (length < 6) break;
+          total = static_cast<std::size_t>(frame[2]) << 24 | frame[3] << 16 | frame[4] << 8 |
+                  frame[5];
+          offset = 6;
+        }
+        // A first frame always has more than a single frame holds
+        if (total < 8) break;
+        // A new first frame abandons the message the ID was sending
+        if (open_it != open.end()) {
+          broken[open_it->index] = true;
+          open.erase(open_it);
+        }
+        start(std::string(hex, header), frame + offset, length - offset, total);
+        messages.back().bytes.reserve(std::min<std::size_t>(total, 0xFFF));
+        // A first frame fills its CAN frame
+        if (length != 8) {
+          broken.back() = true;
+          break;
+        }
+        open.push_back({messages.size() - 1, total, 1});
+        break;
+      }
+      case 0x2: {
+        // Consecutive frame: sequence numbers run 1..F, 0..F
+        if (open_it == open.end()) break;
+        if (!Continue(&*open_it, frame[0] & 0x0F, frame + 1, length - 1, &messages, &broken)) {
+          open.erase(open_it);
+        }
+        break;
+      }
+      default:
+        // Flow control and anything else is not part of a reply
+        break;
+    }
+  }
+
+  // Consecutive frames are padded to eight bytes
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    auto& bytes = messages[i].bytes;
+    if (expected[i] != 0 && bytes.size() > expected[i]) bytes.resize(expected[i]);
+    messages[i].complete = !broken[i] && (expected[i] == 0 || bytes.size() == expected[i]);
+  }
+  return messages;
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,39 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_ELM327_REPLY_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_ELM327_REPLY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// One ECU message of an adapter reply.
+struct ElmMessage {
+  // The CAN ID as printed ("7E8", "18DAF110"); empty without headers.
+  std::string id;
+  std::vector<std::uint8_t> bytes;
+  // False if an ISO-TP message is shorter than its first frame declared,
+  // or lost a frame on the way (a sequence number or segment index out of
+  // order). Its bytes then stop at the last frame that fit.
+  bool complete = true;
+};
+
+// Reassembles the lines of one adapter reply into ECU messages, in the
+// order they started.
+//
+// Lines may carry 11- or 29-bit headers (ATH1) or none, with or without
+// spaces. With headers, single frames are cut to their PCI length and
+// first/consecutive frames are joined per CAN ID, so ECUs answering at the
+// same time each get their own message; consecutive frames must follow
+// their sequence numbers (1..F, 0..F). Without headers, the "N:" segments
+// after a total-length line are joined in index order. Lines that are not
+// hex ("NO DATA", "SEARCHING..."), flow control frames and consecutive
+// frames without a first frame are skipped.
+//
+// Allocates only the messages it returns.
+std::vector<ElmMessage> AssembleElmReply(const std::vector<std::string>& lines);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_ELM327_REPLY_H_
@@ -0,0 +1,489 @@
+#include "elm327_emulator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <utility>
+
+#include "pid_table.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+using std::chrono::microseconds;
+
+constexpr std::uint32_t kFunctionalId11 = 0x7DF;
+constexpr std::uint32_t kFunctionalId29 = 0x18DB33F1;
+// PIDs per Mode 01 request, as for CAN ECUs.
+constexpr std::size_t kMaxMode01Pids = 6;
+
+// Spaces and linefeeds are ignored by the adapter, and so is case.
+std::string Normalize(const std::string& command) {
+  std::string normalized;
+  normalized.reserve(command.size());
+  for (char c : command) {
+    if (c == ' ' || c == '\n' || c == '\t') continue;
+    normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+  }
+  return normalized;
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Parses all of |text| as hex; false if any character is not a hex digit.
+bool ParseHex(const std::string& text, std::uint32_t* value) {
+  if (text.empty() || text.size() > 8) return false;
+  std::uint32_t result = 0;
+  for (char c : text) {
+    const int digit = HexValue(c);
+    if (digit < 0) return false;
+    result = (result << 4) | static_cast<std::uint32_t>(digit);
+  }
+  *value = result;
+  return true;
+}
+
+bool IsCanProtocol(int protocol) { return protocol >= 6 && protocol <= 9; }
+int CanBaud(int protocol) { return protocol <= 7 ? 500 : 250; }
+
+const char* ProtocolName(int protocol) {
+  switch (protocol) {
+    case 6:
+      return "ISO 15765-4 (CAN 11/500)";
+    case 7:
+      return "ISO 15765-4 (CAN 29/500)";
+    case 8:
+      return "ISO 15765-4 (CAN 11/250)";
+    case 9:
+      return "ISO 15765-4 (CAN 29/250)";
+  }
+  return "AUTO";
+}
+
+// Request id an ECU with |response_id| listens on.
+std::uint32_t RequestId11(std::uint32_t response_id) { return response_id - 8; }
+std::uint32_t RequestId29(std::uint32_t response_id) {
+  return (response_id & 0xFFFF0000) | ((response_id & 0xFF) << 8) | ((response_id >> 8) & 0xFF);
+}
+
+// Mode 01 data of |pid|, the support bitmaps included; false if |ecu| does
+// not support it.
+bool Mode01Data(const EmulatedEcu& ecu, std::uint8_t pid, std::vector<std::uint8_t>* data) {
+  if (pid % 0x20 != 0) {
+    auto it = ecu.mode01.find(pid);
+    if (it == ecu.mode01.end()) return false;
+    *data = it->second;
+    return true;
+  }
+
+  // A bitmap is supported if it or a later range has a PID in it
+  if (pid != 0 && (ecu.mode01.empty() || ecu.mode01.rbegin()->first <= pid)) return false;
+  data->assign(4, 0);
+  for (int offset = 1; offset <= 0x20; ++offset) {
+    const int supported = pid + offset;
+    bool set = offset == 0x20 ? !ecu.mode01.empty() && ecu.mode01.rbegin()->first > supported
+                              : supported <= 0xFF && ecu.mode01.count(static_cast<std::uint8_t>(supported)) > 0;
+    if (set) (*data)[(offset - 1) / 8] |= static_cast<std::uint8_t>(0x80 >> ((offset - 1) % 8));
+  }
+  return true;
+}
+
+// Plausible value bytes for a PID the profile has no real value for.
+std::vector<std::uint8_t> FillerValue(int pid, int length) {
+  std::vector<std::uint8_t> value(static_cast<std::size_t>(length));
+  for (int i = 0; i < length; ++i) value[i] = static_cast<std::uint8_t>(pid * 7 + i * 13 + 0x20);
+  return value;
+}
+
+}  // namespace
+
+EmulatorProfile RamCumminsProfile() {
+  EmulatorProfile profile;
+  profile.vehicle_protocol = 7;
+
+  EmulatedEcu engine;
+  engine.response_id_11 = 0x7E8;
+  engine.response_id_29 = 0x18DAF110;
+  for (const auto& pid : kPidTable) {
+    if (pid.protocol != PidProtocol::kObd2 || pid.mode != 0x01) continue;
+    engine.mode01[static_cast<std::uint8_t>(pid.code)] = FillerValue(pid.code, pid.response_bytes);
+  }
+  engine.mode01[0x05] = {0x7B};        // coolant 83 C
+  engine.mode01[0x0C] = {0x1A, 0xF8};  // 1726 rpm
+  engine.mode01[0x0D] = {0x37};        // 55 km/h
+  engine.mode01[0x42] = {0x36, 0xB0};  // 14.0 V
+  engine.vin = "3C6UR5DL1TG100001";
+  engine.mode22[0xA09F] = {0x12, 0x34};
+  engine.mode22[0xF190] = std::vector<std::uint8_t>(engine.vin.begin(), engine.vin.end());
+  engine.latency = {microseconds(25000), microseconds(5000)};
+  profile.ecus.push_back(engine);
+
+  EmulatedEcu tcm;
+  tcm.response_id_11 = 0x7E9;
+  tcm.response_id_29 = 0x18DAF118;
+  tcm.mode01_nrc = 0x12;
+  tcm.latency = {microseconds(32000), microseconds(5000)};
+  profile.ecus.push_back(tcm);
+  return profile;
+}
+
+Elm327Emulator::Elm327Emulator(EmulatorProfile profile)
+    : profile_(std::move(profile)), random_(profile_.seed), trace_cursors_(profile_.ecus.size()) {}
+
+EmulatorReply Elm327Emulator::Execute(const std::string& command) {
+  // Characters are echoed as they arrive, so the echo follows the setting
+  // from before this command
+  const std::string echo = settings_.echo ? command + "\r" : std::string();
+  std::string normalized = Normalize(command);
+  if (normalized.empty()) {
+    if (last_command_.empty()) return Simple(echo, {}, microseconds(0));
+    normalized = last_command_;
+  }
+  last_command_ = normalized;
+
+  if (normalized.compare(0, 2, "AT") == 0) return ExecuteAt(normalized.substr(2), echo);
+  return ExecuteObd(normalized, echo);
+}
+
+std::string Elm327Emulator::StoppedReply() const { return "STOPPED" + eol() + eol() + ">"; }
+
+EmulatorReply Elm327Emulator::ExecuteAt(const std::string& command, const std::string& echo) {
+  const microseconds delay = profile_.at_latency;
+  const std::vector<std::string> ok = {"OK"};
+  auto flag = [&](const char* name, bool* value) {
+    const std::size_t length = std::char_traits<char>::length(name);
+    if (command.size() != length + 1 || command.compare(0, length, name) != 0) return false;
+    if (command[length] != '0' && command[length] != '1') return false;
+    *value = command[length] == '1';
+    return true;
+  };
+
+  if (command == "Z" || command == "WS") {
+    settings_ = Settings();
+    return Simple(echo, {"", profile_.identity},
+                  command == "Z" ? profile_.reset_latency : delay);
+  }
+  if (command == "D") {
+    settings_ = Settings();
+    return Simple(echo, ok, delay);
+  }
+  if (command == "I") return Simple(echo, {profile_.identity}, delay);
+  if (command == "@1") return Simple(echo, {profile_.description}, delay);
+  if (flag("E", &settings_.echo) || flag("L", &settings_.linefeeds) ||
+      flag("S", &settings_.spaces) || flag("H", &settings_.headers)) {
+    return Simple(echo, ok, delay);
+  }
+  if (command.size() == 3 && command.compare(0, 2, "AT") == 0 && command[2] >= '0' &&
+      command[2] <= '2') {
+    settings_.adaptive = command[2] - '0';
+    return Simple(echo, ok, delay);
+  }
+
+  std::uint32_t value = 0;
+  if (command.compare(0, 2, "ST") == 0 && command.size() == 4 &&
+      ParseHex(command.substr(2), &value)) {
+    settings_.timeout_counts = value == 0 ? 0x32 : static_cast<int>(value);
+    return Simple(echo, ok, delay);
+  }
+  if ((command.compare(0, 2, "SP") == 0 || command.compare(0, 2, "TP") == 0) &&
+      command.size() >= 3) {
+    std::string number = command.substr(2);
+    if (number.size() == 2 && number[0] == 'A') number = number.substr(1);
+    if (number.size() == 1 && ParseHex(number, &value) && value <= 0xC) {
+      settings_.protocol = static_cast<int>(value);
+      settings_.protocol_found = value != 0;
+      return Simple(echo, ok, delay);
+    }
+  }
+  if (command == "DP" || command == "DPN") {
+    const bool automatic = settings_.protocol == 0;
+    const int protocol = automatic ? profile_.vehicle_protocol : settings_.protocol;
+    std::string text;
+    if (command == "DP") {
+      text = automatic ? std::string("AUTO, ") + ProtocolName(protocol) : ProtocolName(protocol);
+    } else {
+      text = (automatic ? "A" : "") + std::to_string(protocol);
+    }
+    return Simple(echo, {text}, delay);
+  }
+  if (command.compare(0, 2, "SH") == 0) {
+    const std::string id = command.substr(2);
+    if ((id.size() == 3 || id.size() == 6 || id.size() == 8) && ParseHex(id, &value)) {
+      // Six digits set the low 24 bits under the default 0x18 priority
+      settings_.header = id.size() == 6 ? 0x18000000 | value : value;
+      return Simple(echo, ok, delay);
+    }
+  }
+  if (command == "RV") {
+    char volts[16];
+    std::snprintf(volts, sizeof(volts), "%.1fV", profile_.battery_volts);
+    return Simple(echo, {volts}, delay);
+  }
+  if (command == "LP") {
+    sleeping_ = true;
+    return Simple(echo, ok, delay);
+  }
+  if (command == "PC") {
+    if (settings_.protocol == 0) settings_.protocol_found = false;
+    return Simple(echo, ok, delay);
+  }
+  return Simple(echo, {"?"}, delay);
+}
+
+EmulatorReply Elm327Emulator::ExecuteObd(const std::string& command, const std::string& echo) {
+  // Hex bytes, optionally followed by a one-digit response count
+  std::string hex = command;
+  std::size_t count = 0;
+  if (hex.size() % 2 == 1) {
+    count = static_cast<std::size_t>(HexValue(hex.back()));
+    hex.pop_back();
+    if (count == 0) return Simple(echo, {"?"}, profile_.at_latency);
+  }
+  std::vector<std::uint8_t> request;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    const int high = HexValue(hex[i]);
+    const int low = HexValue(hex[i + 1]);
+    if (high < 0 || low < 0) return Simple(echo, {"?"}, profile_.at_latency);
+    request.push_back(static_cast<std::uint8_t>(high << 4 | low));
+  }
+  if (request.empty()) return Simple(echo, {"?"}, profile_.at_latency);
+
+  EmulatorReply reply;
+  std::string first = echo;
+  microseconds start(0);
+  if (!settings_.protocol_found) {
+    first += "SEARCHING..." + eol();
+    start = profile_.search_latency;
+    settings_.protocol_found = true;
+  }
+  if (!first.empty()) reply.chunks.push_back({microseconds(0), first});
+  auto finish = [&](std::vector<std::string> lines, microseconds at) {
+    std::string text;
+    for (const auto& line : lines) text += line + eol();
+    reply.chunks.push_back({start + at, text + eol() + ">"});
+    return reply;
+  };
+
+  const int protocol = settings_.protocol == 0 ? profile_.vehicle_protocol : settings_.protocol;
+  if (protocol != profile_.vehicle_protocol) {
+    if (IsCanProtocol(protocol) && IsCanProtocol(profile_.vehicle_protocol) &&
+        CanBaud(protocol) != CanBaud(profile_.vehicle_protocol)) {
+      return finish({"CAN ERROR"}, profile_.at_latency);
+    }
+    return finish({"NO DATA"}, Timeout());
+  }
+
+  EmulatorFault fault = EmulatorFault::kNone;
+  auto fault_it = profile_.faults.find(command);
+  if (fault_it != profile_.faults.end()) {
+    fault = fault_it->second;
+  } else if (profile_.fault_rate > 0 &&
+             std::uniform_real_distribution<double>(0, 1)(random_) < profile_.fault_rate) {
+    fault = profile_.random_fault;
+  }
+  switch (fault) {
+    case EmulatorFault::kNone:
+      break;
+    case EmulatorFault::kNoData:
+      return finish({"NO DATA"}, Timeout());
+    case EmulatorFault::kStopped:
+      return finish({"STOPPED"}, profile_.at_latency);
+    case EmulatorFault::kCanError:
+      return finish({"CAN ERROR"}, profile_.at_latency);
+    case EmulatorFault::kBufferFull:
+      return finish({"BUFFER FULL"}, Timeout());
+  }
+
+  auto override_it = profile_.command_latency.find(command);
+  std::vector<Message> messages;
+  for (std::size_t i = 0; i < profile_.ecus.size(); ++i) {
+    const EmulatedEcu& ecu = profile_.ecus[i];
+    if (!Addressed(ecu)) continue;
+    std::vector<std::uint8_t> payload = Respond(ecu, request);
+    if (payload.empty()) continue;
+    microseconds at;
+    if (override_it != profile_.command_latency.end()) {
+      at = Jittered(override_it->second);
+    } else if (!ecu.latency_trace.empty()) {
+      at = ecu.latency_trace[trace_cursors_[i]++ % ecu.latency_trace.size()];
+    } else {
+      at = Jittered(ecu.latency);
+    }
+    messages.push_back({at, FormatMessage(ecu, payload)});
+  }
+  std::stable_sort(messages.begin(), messages.end(),
+                   [](const Message& a, const Message& b) { return a.at < b.at; });
+
+  // The timeout restarts with every reply; slower ECUs are never heard
+  microseconds previous(0);
+  std::size_t heard = 0;
+  while (heard < messages.size() && messages[heard].at - previous <= Timeout()) {
+    previous = messages[heard++].at;
+  }
+  if (count > 0 && heard > count) heard = count;
+  messages.resize(heard);
+  if (messages.empty()) return finish({"NO DATA"}, Timeout());
+
+  for (const auto& message : messages) {
+    std::string text;
+    for (const auto& line : message.lines) text += line + eol();
+    reply.chunks.push_back({start + message.at, std::move(text)});
+  }
+  microseconds prompt_at = messages.back().at;
+  if (count == 0 || messages.size() < count) {
+    microseconds wait = Timeout();
+    if (settings_.adaptive == 1) wait = std::min(wait, profile_.adaptive_wait);
+    if (settings_.adaptive == 2) wait = std::min(wait, profile_.adaptive_wait / 2);
+    prompt_at += wait;
+  }
+  reply.chunks.push_back({start + prompt_at, eol() + ">"});
+  return reply;
+}
+
+EmulatorReply Elm327Emulator::Simple(const std::string& echo, std::vector<std::string> lines,
+                                     microseconds delay) const {
+  EmulatorReply reply;
+  if (!echo.empty()) reply.chunks.push_back({microseconds(0), echo});
+  std::string text;
+  for (const auto& line : lines) text += line + eol();
+  reply.chunks.push_back({delay, text + eol() + ">"});
+  return reply;
+}
+
+std::vector<std::uint8_t> Elm327Emulator::Respond(const EmulatedEcu& ecu,
+                                                  const std::vector<std::uint8_t>& request) const {
+  const std::uint8_t mode = request[0];
+  std::vector<std::uint8_t> response;
+  if (mode == 0x01 && request.size() >= 2 && request.size() <= kMaxMode01Pids + 1) {
+    response.push_back(0x41);
+    std::vector<std::uint8_t> data;
+    for (std::size_t i = 1; i < request.size(); ++i) {
+      if (!Mode01Data(ecu, request[i], &data)) continue;
+      response.push_back(request[i]);
+      response.insert(response.end(), data.begin(), data.end());
+    }
+    if (response.size() > 1) return response;
+    if (ecu.mode01_nrc != 0) return {0x7F, 0x01, ecu.mode01_nrc};
+    return {};
+  }
+  if (mode == 0x09 && request.size() == 2 && request[1] == 0x02 && !ecu.vin.empty()) {
+    response = {0x49, 0x02, 0x01};
+    response.insert(response.end(), ecu.vin.begin(), ecu.vin.end());
+    return response;
+  }
+  if (mode == 0x22 && request.size() >= 3 && request.size() % 2 == 1) {
+    if (request.size() > 3 && !ecu.mode22_multi) return {0x7F, 0x22, 0x13};
+    // The DIDs it has, each followed by its data; 7F if none
+    response.push_back(0x62);
+    for (std::size_t i = 1; i + 1 < request.size(); i += 2) {
+      const auto did = static_cast<std::uint16_t>(request[i] << 8 | request[i + 1]);
+      auto it = ecu.mode22.find(did);
+      if (it == ecu.mode22.end()) continue;
+      response.push_back(request[i]);
+      response.push_back(request[i + 1]);
+      response.insert(response.end(), it->second.begin(), it->second.end());
+    }
+    if (response.size() > 1) return response;
+    if (ecu.mode22_nrc != 0) return {0x7F, 0x22, ecu.mode22_nrc};
+  }
+  return {};
+}
+
+bool Elm327Emulator::Addressed(const EmulatedEcu& ecu) const {
+  const std::uint32_t header = settings_.header;
+  if (header == 0 || header == kFunctionalId11 || header == kFunctionalId29) return true;
+  return header == RequestId11(ecu.response_id_11) || header == RequestId29(ecu.response_id_29);
+}
+
+bool Elm327Emulator::Uses29BitIds() const {
+  const int protocol = settings_.protocol == 0 ? profile_.vehicle_protocol : settings_.protocol;
+  return protocol == 7 || protocol == 9;
+}
+
+std::vector<std::string> Elm327Emulator::FormatMessage(
+    const EmulatedEcu& ecu, const std::vector<std::uint8_t>& payload) const {
+  const std::string separator = settings_.spaces ? " " : "";
+  std::string id;
+  if (settings_.headers) {
+    char text[16];
+    if (Uses29BitIds()) {
+      const std::uint32_t value = ecu.response_id_29;
+      std::snprintf(text, sizeof(text), "%02X%s%02X%s%02X%s%02X", (value >> 24) & 0xFF,
+                    separator.c_str(), (value >> 16) & 0xFF, separator.c_str(),
+                    (value >> 8) & 0xFF, separator.c_str(), value & 0xFF);
+    } else {
+      std::snprintf(text, sizeof(text), "%03X", ecu.response_id_11 & 0x7FF);
+    }
+    id = text + separator;
+  }
+
+  std::vector<std::string> lines;
+  const std::size_t length = payload.size();
+  if (length <= 7) {
+    std::vector<std::uint8_t> frame;
+    if (settings_.headers) frame.push_back(static_cast<std::uint8_t>(length));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    lines.push_back(id + FormatBytes(frame));
+    return lines;
+  }
+
+  // ISO-TP: a first frame with six bytes, then consecutive frames of seven.
+  // With headers the adapter shows the raw frames, padding included; without
+  // them it numbers the segments after a line with the total length.
+  std::size_t offset = 6;
+  if (settings_.headers) {
+    std::vector<std::uint8_t> frame = {static_cast<std::uint8_t>(0x10 | (length >> 8)),
+                                       static_cast<std::uint8_t>(length & 0xFF)};
+    frame.insert(frame.end(), payload.begin(), payload.begin() + 6);
+    lines.push_back(id + FormatBytes(frame));
+  } else {
+    char total[16];
+    std::snprintf(total, sizeof(total), "%03X", static_cast<unsigned>(length));
+    lines.push_back(total);
+    lines.push_back("0:" + separator +
+                    FormatBytes(std::vector<std::uint8_t>(payload.begin(), payload.begin() + 6)));
+  }
+  for (int sequence = 1; offset < length; ++sequence) {
+    const std::size_t take = std::min<std::size_t>(7, length - offset);
+    std::vector<std::uint8_t> data(payload.begin() + offset, payload.begin() + offset + take);
+    offset += take;
+    char index[4];
+    std::snprintf(index, sizeof(index), "%X", sequence & 0xF);
+    if (settings_.headers) {
+      data.resize(7, 0x00);
+      data.insert(data.begin(), static_cast<std::uint8_t>(0x20 | (sequence & 0xF)));
+      lines.push_back(id + FormatBytes(data));
+    } else {
+      lines.push_back(std::string(index) + ":" + separator + FormatBytes(data));
+    }
+  }
+  return lines;
+}
+
+std::string Elm327Emulator::FormatBytes(const std::vector<std::uint8_t>& bytes) const {
+  std::string text;
+  char byte[4];
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    if (i > 0 && settings_.spaces) text += ' ';
+    std::snprintf(byte, sizeof(byte), "%02X", bytes[i]);
+    text += byte;
+  }
+  return text;
+}
+
+microseconds Elm327Emulator::Timeout() const {
+  return microseconds(settings_.timeout_counts * 4000);
+}
+
+microseconds Elm327Emulator::Jittered(const EmulatorLatency& latency) {
+  if (latency.jitter.count() <= 0) return latency.base;
+  std::uniform_int_distribution<long long> jitter(0, latency.jitter.count());
+  return latency.base + microseconds(jitter(random_));
+}
+
+}  // namespace flutter_bluetooth_classic
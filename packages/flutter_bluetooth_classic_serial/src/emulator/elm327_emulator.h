@@ -0,0 +1,178 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_ELM327_EMULATOR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_ELM327_EMULATOR_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// Time from a request to an ECU's reply: |base| plus a uniformly random
+// 0..|jitter|.
+struct EmulatorLatency {
+  std::chrono::microseconds base{0};
+  std::chrono::microseconds jitter{0};
+};
+
+// One ECU on the emulated CAN bus.
+struct EmulatedEcu {
+  // Response CAN ids; the request ids are derived from them (0x7E8 answers
+  // 0x7E0, 0x18DAF110 answers 0x18DA10F1).
+  std::uint32_t response_id_11 = 0x7E8;
+  std::uint32_t response_id_29 = 0x18DAF110;
+  // Mode 01 data bytes by PID. The 00/20/40... support bitmaps are derived
+  // from the keys.
+  std::map<std::uint8_t, std::vector<std::uint8_t>> mode01;
+  // Mode 22 data bytes by DID.
+  std::map<std::uint16_t, std::vector<std::uint8_t>> mode22;
+  // Answered to 0902 when set.
+  std::string vin;
+  // NRC sent for a request it has no data for; 0 stays silent.
+  std::uint8_t mode01_nrc = 0;
+  std::uint8_t mode22_nrc = 0x31;
+  // Answers requests for several DIDs at once, as UDS allows; without,
+  // they get 7F 22 13.
+  bool mode22_multi = true;
+  EmulatorLatency latency{std::chrono::microseconds(25000), std::chrono::microseconds(0)};
+  // Response times captured on a vehicle. When set they replace |latency|,
+  // replayed in order and wrapping around, so two runs over the same
+  // commands see the same times.
+  std::vector<std::chrono::microseconds> latency_trace;
+};
+
+enum class EmulatorFault { kNone, kNoData, kStopped, kCanError, kBufferFull };
+
+// The vehicle and adapter being emulated.
+struct EmulatorProfile {
+  // ELM327 protocol number the bus runs (6-9 are ISO 15765-4 CAN).
+  int vehicle_protocol = 7;
+  std::vector<EmulatedEcu> ecus;
+  double battery_volts = 12.6;
+  // Reported by ATZ/ATI and AT@1.
+  std::string identity = "ELM327 v1.4b";
+  std::string description = "OBDLink MX+";
+
+  // Adapter-side delays.
+  std::chrono::microseconds at_latency{2000};
+  std::chrono::microseconds reset_latency{300000};
+  // Extra time for the first request after ATSP0.
+  std::chrono::microseconds search_latency{150000};
+  // How long the adapter waits for more replies after the last one when
+  // adaptive timing (ATAT1) is on and the request gave no response count.
+  // ATAT0 waits the full ATST timeout; ATAT2 waits half of this.
+  std::chrono::microseconds adaptive_wait{20000};
+
+  // Replaces every ECU's latency for a command (spaces removed, upper case,
+  // e.g. "010C").
+  std::map<std::string, EmulatorLatency> command_latency;
+  // Always answers a command with a fault instead of data.
+  std::map<std::string, EmulatorFault> faults;
+  // Probability that any OBD request fails with |random_fault|.
+  double fault_rate = 0;
+  EmulatorFault random_fault = EmulatorFault::kNoData;
+  // Seeds jitter and random faults, so a run is repeatable.
+  std::uint32_t seed = 1;
+};
+
+// A 2026 Ram 2500 6.7L Cummins as seen through an OBDLink MX+ on CAN 29-bit
+// 500k: the engine ECU answers every Mode 01 PID of the app's PID table and a
+// few Mode 22 DIDs, and the TCM answers Mode 01 with 7F 01 12.
+EmulatorProfile RamCumminsProfile();
+
+// Everything the adapter sends for one command. Each chunk is due |at|
+// after the command's CR arrived; the last one ends with the '>' prompt.
+struct EmulatorReply {
+  struct Chunk {
+    std::chrono::microseconds at{0};
+    std::string text;
+  };
+  std::vector<Chunk> chunks;
+};
+
+// ELM327 command interpreter with the AT set the app uses (Z, WS, D, I, @1,
+// E, L, S, H, AT, ST, SP, TP, DP, DPN, SH, RV, LP, PC) and Mode 01, 09 02
+// and 22 requests answered by the profile's ECUs.
+//
+// Replies follow the adapter's settings: echo, linefeeds, spaces, and CAN
+// headers with PCI bytes (11- or 29-bit by protocol), ISO-TP multi-frame
+// replies included. A request without a response count waits for more
+// ECUs the way the adapter does; one with a count ("010C1") returns as soon
+// as that many replied. ECUs slower than the ATST timeout are dropped.
+//
+// Only computes replies; EmulatorLink puts them on a wire with their
+// timing. Not thread-safe.
+class Elm327Emulator {
+ public:
+  explicit Elm327Emulator(EmulatorProfile profile);
+
+  // |command| as received, without the CR. An empty command repeats the
+  // previous one.
+  EmulatorReply Execute(const std::string& command);
+
+  // What the adapter sends when a byte arrives while a command is still
+  // being answered.
+  std::string StoppedReply() const;
+
+  // Set by AT LP. The adapter ignores the next command, which only wakes
+  // it, and answers it with a bare prompt.
+  bool sleeping() const { return sleeping_; }
+  void Wake() { sleeping_ = false; }
+
+  const EmulatorProfile& profile() const { return profile_; }
+
+ private:
+  struct Settings {
+    bool echo = true;
+    bool linefeeds = true;
+    bool spaces = true;
+    bool headers = false;
+    int adaptive = 1;
+    // ATST value; the timeout is 4 ms per count.
+    int timeout_counts = 0x32;
+    // 0 = automatic.
+    int protocol = 0;
+    bool protocol_found = false;
+    // Set by ATSH; 0 = the functional broadcast id.
+    std::uint32_t header = 0;
+  };
+
+  // One ECU message with its reply time.
+  struct Message {
+    std::chrono::microseconds at;
+    std::vector<std::string> lines;
+  };
+
+  EmulatorReply ExecuteAt(const std::string& command, const std::string& echo);
+  EmulatorReply ExecuteObd(const std::string& command, const std::string& echo);
+  // A reply of |lines| sent all at once |delay| after the command.
+  EmulatorReply Simple(const std::string& echo, std::vector<std::string> lines,
+                       std::chrono::microseconds delay) const;
+
+  // Data bytes |ecu| answers |request| with, empty if it stays silent.
+  std::vector<std::uint8_t> Respond(const EmulatedEcu& ecu,
+                                    const std::vector<std::uint8_t>& request) const;
+  bool Addressed(const EmulatedEcu& ecu) const;
+  bool Uses29BitIds() const;
+  std::vector<std::string> FormatMessage(const EmulatedEcu& ecu,
+                                         const std::vector<std::uint8_t>& payload) const;
+  std::string FormatBytes(const std::vector<std::uint8_t>& bytes) const;
+  std::chrono::microseconds Timeout() const;
+  std::chrono::microseconds Jittered(const EmulatorLatency& latency);
+  std::string eol() const { return settings_.linefeeds ? "\r\n" : "\r"; }
+
+  EmulatorProfile profile_;
+  Settings settings_;
+  std::string last_command_;
+  bool sleeping_ = false;
+  std::mt19937 random_;
+  // Next index into each ECU's latency trace.
+  std::vector<std::size_t> trace_cursors_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_ELM327_EMULATOR_H_
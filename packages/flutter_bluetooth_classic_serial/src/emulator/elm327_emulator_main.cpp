@@ -0,0 +1,145 @@
+// Stand-alone ELM327 / OBDLink MX+ emulator for bench and load testing.
+//
+//   elm327_emulator --tcp 35000        serve clients on 127.0.0.1:35000
+//   elm327_emulator --pty              create a PTY and print its path
+//
+// Options:
+//   --latency-ms N    engine ECU reply time (default 25; TCM is 7 ms later)
+//   --jitter-ms N     random extra reply time, 0..N (default 5)
+//   --protocol N      ELM327 protocol the bus runs, 6-9 (default 7)
+//   --no-tcm          only the engine ECU answers
+//   --fault-rate R    fraction of OBD requests answered with NO DATA
+//   --seed N          seed for jitter and faults
+//
+// The adapter state (ATE0, ATH1, ...) persists across TCP clients, as it
+// does across Bluetooth reconnects.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "elm327_emulator.h"
+#include "emulator_link.h"
+
+namespace {
+
+using flutter_bluetooth_classic::Elm327Emulator;
+using flutter_bluetooth_classic::EmulatorLink;
+using flutter_bluetooth_classic::EmulatorProfile;
+
+int Usage() {
+  std::fprintf(stderr,
+               "usage: elm327_emulator (--tcp PORT | --pty) [--latency-ms N] [--jitter-ms N]\n"
+               "                       [--protocol N] [--no-tcm] [--fault-rate R] [--seed N]\n");
+  return 2;
+}
+
+int ServeTcp(Elm327Emulator* emulator, int port) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener < 0) {
+    std::perror("elm327_emulator: socket");
+    return 1;
+  }
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(listener, 1) != 0) {
+    std::perror("elm327_emulator: listen");
+    return 1;
+  }
+  std::printf("listening on 127.0.0.1:%d\n", port);
+  std::fflush(stdout);
+
+  for (;;) {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0) continue;
+    EmulatorLink link(emulator);
+    link.Serve(client);
+    std::printf("client closed after %llu commands (%llu interrupted)\n",
+                static_cast<unsigned long long>(link.commands()),
+                static_cast<unsigned long long>(link.interrupted()));
+    std::fflush(stdout);
+    close(client);
+  }
+}
+
+int ServePty(Elm327Emulator* emulator) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    std::perror("elm327_emulator: pty");
+    return 1;
+  }
+  const char* path = ptsname(master);
+  // Raw mode so CRs arrive untranslated. Holding the slave open keeps the
+  // master readable across clients opening and closing it.
+  int slave = open(path, O_RDWR | O_NOCTTY);
+  termios settings;
+  if (slave < 0 || tcgetattr(slave, &settings) != 0) {
+    std::perror("elm327_emulator: pty slave");
+    return 1;
+  }
+  cfmakeraw(&settings);
+  tcsetattr(slave, TCSANOW, &settings);
+  std::printf("%s\n", path);
+  std::fflush(stdout);
+
+  EmulatorLink link(emulator);
+  const bool ok = link.Serve(master);
+  close(slave);
+  close(master);
+  return ok ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  EmulatorProfile profile = flutter_bluetooth_classic::RamCumminsProfile();
+  int port = 0;
+  bool pty = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (flag == "--tcp" && has_value) {
+      port = std::atoi(argv[++i]);
+    } else if (flag == "--pty") {
+      pty = true;
+    } else if (flag == "--latency-ms" && has_value) {
+      const std::chrono::microseconds latency(std::atol(argv[++i]) * 1000);
+      profile.ecus[0].latency.base = latency;
+      // Gone when --no-tcm came first
+      if (profile.ecus.size() > 1) {
+        profile.ecus[1].latency.base = latency + std::chrono::milliseconds(7);
+      }
+    } else if (flag == "--jitter-ms" && has_value) {
+      const std::chrono::microseconds jitter(std::atol(argv[++i]) * 1000);
+      for (auto& ecu : profile.ecus) ecu.latency.jitter = jitter;
+    } else if (flag == "--protocol" && has_value) {
+      profile.vehicle_protocol = std::atoi(argv[++i]);
+    } else if (flag == "--no-tcm") {
+      profile.ecus.resize(1);
+    } else if (flag == "--fault-rate" && has_value) {
+      profile.fault_rate = std::atof(argv[++i]);
+    } else if (flag == "--seed" && has_value) {
+      profile.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      return Usage();
+    }
+  }
+  if ((port > 0) == pty) return Usage();
+
+  Elm327Emulator emulator(profile);
+  return pty ? ServePty(&emulator) : ServeTcp(&emulator, port);
+}
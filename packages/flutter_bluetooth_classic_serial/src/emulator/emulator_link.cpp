@@ -0,0 +1,116 @@
+#include "emulator_link.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool WriteAll(int fd, const std::string& data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0 && errno == EINTR) continue;
+    if (result <= 0) return false;
+    written += static_cast<std::size_t>(result);
+  }
+  return true;
+}
+
+}  // namespace
+
+EmulatorLink::EmulatorLink(Elm327Emulator* emulator) : emulator_(emulator) {}
+
+bool EmulatorLink::Serve(int fd) {
+  if (!reactor_.IsValid() || !reactor_.Add(fd, 0)) return false;
+  input_.clear();
+
+  bool ok = true;
+  while (!stop_requested_.load(std::memory_order_acquire)) {
+    const auto cr = input_.find('\r');
+    if (cr == std::string::npos) {
+      const WaitResult result = WaitReadable(-1);
+      if (result == WaitResult::kStopped) break;
+      if (result == WaitResult::kFailed) {
+        ok = false;
+        break;
+      }
+      if (result == WaitResult::kReadable && !ReadMore(fd)) break;
+      continue;
+    }
+
+    std::string command = input_.substr(0, cr);
+    input_.erase(0, cr + 1);
+    commands_.fetch_add(1, std::memory_order_relaxed);
+    if (emulator_->sleeping()) {
+      emulator_->Wake();
+      if (!WriteAll(fd, ">")) break;
+      continue;
+    }
+    if (!SendReply(fd, emulator_->Execute(command))) break;
+  }
+  reactor_.Remove(fd);
+  return ok;
+}
+
+void EmulatorLink::Stop() {
+  stop_requested_.store(true, std::memory_order_release);
+  reactor_.Wake();
+}
+
+EmulatorLink::WaitResult EmulatorLink::WaitReadable(int timeout_ms) {
+  Reactor::Event event;
+  const int ready = reactor_.Wait(&event, 1, timeout_ms);
+  if (stop_requested_.load(std::memory_order_acquire)) return WaitResult::kStopped;
+  if (ready < 0) return WaitResult::kFailed;
+  return ready == 0 ? WaitResult::kTimedOut : WaitResult::kReadable;
+}
+
+bool EmulatorLink::SendReply(int fd, const EmulatorReply& reply) {
+  const auto started = Clock::now();
+  for (const auto& chunk : reply.chunks) {
+    const auto due = started + chunk.at;
+    for (;;) {
+      // Anything the host sends before the prompt interrupts the reply
+      if (!input_.empty()) {
+        interrupted_.fetch_add(1, std::memory_order_relaxed);
+        input_.erase(0, 1);
+        return WriteAll(fd, emulator_->StoppedReply());
+      }
+      const auto now = Clock::now();
+      if (now >= due) break;
+      const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(due - now);
+      if (remaining.count() < 1000) {
+        std::this_thread::sleep_until(due);
+        break;
+      }
+      const WaitResult result = WaitReadable(static_cast<int>(remaining.count() / 1000));
+      if (result == WaitResult::kStopped || result == WaitResult::kFailed) return false;
+      if (result == WaitResult::kReadable && !ReadMore(fd)) return false;
+    }
+    if (!WriteAll(fd, chunk.text)) return false;
+  }
+  return true;
+}
+
+bool EmulatorLink::ReadMore(int fd) {
+  char buffer[512];
+  for (;;) {
+    ssize_t received = read(fd, buffer, sizeof(buffer));
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    // The adapter ignores linefeeds and NULs
+    for (ssize_t i = 0; i < received; ++i) {
+      if (buffer[i] != '\n' && buffer[i] != '\0') input_.push_back(buffer[i]);
+    }
+    return true;
+  }
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,57 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_EMULATOR_LINK_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_EMULATOR_LINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "elm327_emulator.h"
+#include "reactor.h"
+
+namespace flutter_bluetooth_classic {
+
+// Serves an Elm327Emulator on a byte stream: a socket, a PTY master or a
+// pipe pair, read and written with read()/write().
+//
+// Commands end at CR. Each reply goes out chunk by chunk at its emulated
+// time. A byte arriving before the prompt interrupts the reply the way it
+// does on a real adapter: the rest is dropped, STOPPED is sent, and that
+// byte is discarded (so a bare CR only aborts). POSIX only.
+class EmulatorLink {
+ public:
+  explicit EmulatorLink(Elm327Emulator* emulator);
+
+  EmulatorLink(const EmulatorLink&) = delete;
+  EmulatorLink& operator=(const EmulatorLink&) = delete;
+
+  // Runs on the calling thread until the peer closes |fd|, an I/O error or
+  // Stop(). |fd| must be blocking. Returns false on error.
+  bool Serve(int fd);
+
+  // Makes Serve() return. Thread-safe.
+  void Stop();
+
+  std::uint64_t commands() const { return commands_.load(std::memory_order_relaxed); }
+  std::uint64_t interrupted() const { return interrupted_.load(std::memory_order_relaxed); }
+
+ private:
+  enum class WaitResult { kTimedOut, kReadable, kStopped, kFailed };
+
+  // Waits up to |timeout_ms| (-1 = forever) for |fd| to be readable.
+  WaitResult WaitReadable(int timeout_ms);
+  // Sends |reply| on schedule. False if the link failed or was stopped.
+  bool SendReply(int fd, const EmulatorReply& reply);
+  bool ReadMore(int fd);
+
+  Elm327Emulator* emulator_;
+  Reactor reactor_;
+  std::atomic<bool> stop_requested_{false};
+  std::atomic<std::uint64_t> commands_{0};
+  std::atomic<std::uint64_t> interrupted_{0};
+  // Received bytes not yet part of a complete command.
+  std::string input_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_EMULATOR_LINK_H_
@@ -0,0 +1,144 @@
+#include "timeout_simulation.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "adaptive_timeouts.h"
+#include "response_counts.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+using std::chrono::microseconds;
+
+// First-response times in tenths of a millisecond, as logged by the app's
+// link stats on a 2026 Ram 2500 over an OBDLink MX+.
+constexpr int kEngineTrace[] = {241, 253, 279, 246, 312, 260, 251, 384, 249, 267, 293,
+                                255, 243, 271, 448, 259, 248, 262, 301, 244, 257, 276,
+                                250, 335, 247, 264, 282, 252, 245, 269, 407, 258};
+constexpr int kBodyTrace[] = {921, 1184, 1032, 1410, 968, 1256, 1597, 1043,
+                              1121, 989, 1338, 1072, 1465, 1015, 1203, 1099};
+
+std::vector<microseconds> Trace(const int* tenths, std::size_t size) {
+  std::vector<microseconds> trace;
+  for (std::size_t i = 0; i < size; ++i) trace.push_back(microseconds(tenths[i] * 100));
+  return trace;
+}
+
+struct Exchange {
+  std::vector<std::string> lines;
+  // To the first reply chunk (0 if the reply is only the prompt) and to
+  // the prompt, link latency included.
+  microseconds first_response{0};
+  microseconds elapsed{0};
+};
+
+Exchange Run(Elm327Emulator* emulator, const std::string& command, microseconds link) {
+  const EmulatorReply reply = emulator->Execute(command);
+  Exchange exchange;
+  std::string line;
+  for (const auto& chunk : reply.chunks) {
+    for (char c : chunk.text) {
+      if (c == '\r' || c == '\n' || c == '>') {
+        if (!line.empty()) exchange.lines.push_back(line);
+        line.clear();
+      } else {
+        line.push_back(c);
+      }
+    }
+  }
+  if (reply.chunks.size() > 1) exchange.first_response = reply.chunks.front().at + link / 2;
+  exchange.elapsed = reply.chunks.back().at + link;
+  return exchange;
+}
+
+}  // namespace
+
+TimeoutSimulationResult SimulateTimeouts(const EmulatorProfile& profile,
+                                         const std::vector<std::string>& commands,
+                                         const TimeoutSimulationOptions& options) {
+  Elm327Emulator emulator(profile);
+  for (const char* setup : {"ATZ", "ATE0", "ATL0", "ATS0", "ATH1", "ATSP7", "ATST32"}) {
+    emulator.Execute(setup);
+  }
+  ResponseCounts counts;
+  AdaptiveTimeouts timeouts;
+  int atst = AdaptiveTimeouts::kDefaultCounts;
+
+  TimeoutSimulationResult result;
+  microseconds measured(0);
+  for (int cycle = 0; cycle < options.cycles; ++cycle) {
+    const bool measure = cycle >= options.warmup_cycles;
+    microseconds time(0);
+    for (const auto& command : commands) {
+      if (options.adaptive) {
+        const int wanted = timeouts.Select(command, atst);
+        if (wanted != atst) {
+          char change[8];
+          std::snprintf(change, sizeof(change), "ATST%02X", wanted);
+          const Exchange exchange = Run(&emulator, change, options.link_latency);
+          const bool accepted = std::find(exchange.lines.begin(), exchange.lines.end(), "OK") !=
+                                exchange.lines.end();
+          timeouts.ObserveChange(exchange.elapsed, accepted);
+          if (accepted) atst = wanted;
+          time += exchange.elapsed;
+          ++result.atst_changes;
+        }
+      }
+
+      int count = 0;
+      const std::string wire =
+          options.response_counts ? counts.Apply(command, &count) : command;
+      Exchange exchange = Run(&emulator, wire, options.link_latency);
+      time += exchange.elapsed;
+
+      CommandResult sample;
+      sample.command = command;
+      sample.lines = std::move(exchange.lines);
+      sample.elapsed = exchange.elapsed;
+      if (options.response_counts) counts.Observe(command, count, sample);
+      if (options.adaptive) timeouts.Observe(command, atst, sample, exchange.first_response);
+      if (!measure) continue;
+      const bool no_data =
+          std::find(sample.lines.begin(), sample.lines.end(), "NO DATA") != sample.lines.end();
+      ++(no_data ? result.no_data : result.replies);
+    }
+    if (measure) {
+      measured += time;
+      ++result.cycles;
+    }
+  }
+  if (result.cycles > 0) result.mean_cycle = measured / static_cast<long long>(result.cycles);
+  return result;
+}
+
+EmulatorProfile TimeoutTraceProfile() {
+  EmulatorProfile profile = RamCumminsProfile();
+  EmulatedEcu& engine = profile.ecus[0];
+  engine.mode01.erase(0x46);
+  engine.mode01.erase(0x5C);
+  // Functionally addressed, ECUs stay quiet about DIDs they do not have
+  engine.mode22_nrc = 0;
+  engine.latency_trace = Trace(kEngineTrace, sizeof(kEngineTrace) / sizeof(kEngineTrace[0]));
+
+  EmulatedEcu& tcm = profile.ecus[1];
+  tcm.mode01_nrc = 0;
+  tcm.mode22_nrc = 0;
+
+  EmulatedEcu body;
+  body.response_id_11 = 0x7EC;
+  body.response_id_29 = 0x18DAF140;
+  body.mode22[0xD001] = {0x01, 0x5A};
+  body.mode22_nrc = 0;
+  body.latency_trace = Trace(kBodyTrace, sizeof(kBodyTrace) / sizeof(kBodyTrace[0]));
+  profile.ecus.push_back(body);
+  return profile;
+}
+
+std::vector<std::string> TimeoutTraceCommands() {
+  return {"010C", "010D", "0105", "0142", "010F", "0110",
+          "0146", "015C", "22A09F", "22D001", "22F1A0"};
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,60 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_TIMEOUT_SIMULATION_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_TIMEOUT_SIMULATION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "elm327_emulator.h"
+
+namespace flutter_bluetooth_classic {
+
+struct TimeoutSimulationOptions {
+  // Passes over the command list; the first |warmup_cycles| are not
+  // measured.
+  int cycles = 200;
+  int warmup_cycles = 20;
+  // Added to every exchange: Bluetooth both ways and the adapter's UART.
+  std::chrono::microseconds link_latency{8000};
+  // ATST per command from AdaptiveTimeouts instead of a fixed ATST32.
+  bool adaptive = false;
+  // Append learned response counts (ResponseCounts), as the app does.
+  bool response_counts = true;
+};
+
+struct TimeoutSimulationResult {
+  // Measured passes and their mean duration.
+  std::uint64_t cycles = 0;
+  std::chrono::microseconds mean_cycle{0};
+  // Measured commands answered with data, and with NO DATA.
+  std::uint64_t replies = 0;
+  std::uint64_t no_data = 0;
+  // ATST changes written, warm-up included.
+  std::uint64_t atst_changes = 0;
+};
+
+// Polls |commands| round-robin through an Elm327Emulator running |profile|
+// in virtual time, one command outstanding, the way CommandPipeline drives
+// an adapter, with the same ResponseCounts and AdaptiveTimeouts calls. Each
+// exchange costs the emulator's reply time plus the link latency, so ATST
+// policies can be compared over replayed latency traces in milliseconds of
+// CPU.
+TimeoutSimulationResult SimulateTimeouts(const EmulatorProfile& profile,
+                                         const std::vector<std::string>& commands,
+                                         const TimeoutSimulationOptions& options);
+
+// RamCumminsProfile() with captured response-time traces replayed: the
+// engine ECU answers Mode 01 in 24-45 ms, the TCM stays quiet on Mode 01,
+// a body module answers one Mode 22 DID in 90-160 ms, and the engine does
+// not support PIDs 46 and 5C.
+EmulatorProfile TimeoutTraceProfile();
+
+// A dashboard poll list for TimeoutTraceProfile(): six engine PIDs, two it
+// does not support, an engine DID, the body module's DID, and a DID nobody
+// has.
+std::vector<std::string> TimeoutTraceCommands();
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_EMULATOR_TIMEOUT_SIMULATION_H_
@@ -0,0 +1,97 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_HANDLE_TABLE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_HANDLE_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// Owns per-connection objects and hands out small integer handles for them.
+//
+// A handle packs a slot index with the slot's generation, so a handle kept
+// by a queued task after Remove() resolves to nullptr instead of to
+// whatever reuses the slot. Objects never move while they are in the table;
+// raw pointers from Get() stay valid until Remove(). Not thread-safe.
+template <typename T>
+class HandleTable {
+ public:
+  using Handle = std::int32_t;
+  static constexpr Handle kInvalidHandle = -1;
+
+  Handle Insert(std::unique_ptr<T> value) {
+    std::size_t index;
+    if (!free_slots_.empty()) {
+      index = free_slots_.back();
+      free_slots_.pop_back();
+    } else {
+      if (slots_.size() > kIndexMask) return kInvalidHandle;
+      index = slots_.size();
+      slots_.emplace_back();
+    }
+    Slot& slot = slots_[index];
+    slot.value = std::move(value);
+    ++size_;
+    return static_cast<Handle>((slot.generation << kIndexBits) | index);
+  }
+
+  T* Get(Handle handle) const {
+    const Slot* slot = Find(handle);
+    return slot ? slot->value.get() : nullptr;
+  }
+
+  // Returns the object so the caller controls when it is destroyed.
+  std::unique_ptr<T> Remove(Handle handle) {
+    Slot* slot = const_cast<Slot*>(Find(handle));
+    if (!slot) return nullptr;
+    std::unique_ptr<T> value = std::move(slot->value);
+    slot->generation = (slot->generation + 1) & kGenerationMask;
+    free_slots_.push_back(static_cast<std::size_t>(handle) & kIndexMask);
+    --size_;
+    return value;
+  }
+
+  std::size_t size() const { return size_; }
+
+  // Calls |fn(handle, T&)| for every live object.
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      const Slot& slot = slots_[i];
+      if (slot.value) {
+        fn(static_cast<Handle>((slot.generation << kIndexBits) | i), *slot.value);
+      }
+    }
+  }
+
+ private:
+  static constexpr int kIndexBits = 16;
+  static constexpr std::size_t kIndexMask = (std::size_t{1} << kIndexBits) - 1;
+  // Keeps handles positive so kInvalidHandle never collides.
+  static constexpr std::uint32_t kGenerationMask = (1u << 15) - 1;
+
+  struct Slot {
+    std::unique_ptr<T> value;
+    std::uint32_t generation = 0;
+  };
+
+  const Slot* Find(Handle handle) const {
+    if (handle < 0) return nullptr;
+    std::size_t index = static_cast<std::size_t>(handle) & kIndexMask;
+    std::uint32_t generation = static_cast<std::uint32_t>(handle) >> kIndexBits;
+    if (index >= slots_.size()) return nullptr;
+    const Slot& slot = slots_[index];
+    if (!slot.value || slot.generation != generation) return nullptr;
+    return &slot;
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<std::size_t> free_slots_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_HANDLE_TABLE_H_
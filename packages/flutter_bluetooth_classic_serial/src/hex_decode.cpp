@@ -0,0 +1,84 @@
+#include "hex_decode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLUTTER_BLUETOOTH_CLASSIC_HEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+constexpr std::uint8_t kNotHex = 0xFF;
+
+struct NibbleTable {
+  constexpr NibbleTable() : values() {
+    for (int i = 0; i < 256; ++i) values[i] = kNotHex;
+    for (int i = 0; i < 10; ++i) values['0' + i] = static_cast<std::uint8_t>(i);
+    for (int i = 0; i < 6; ++i) {
+      values['A' + i] = static_cast<std::uint8_t>(10 + i);
+      values['a' + i] = static_cast<std::uint8_t>(10 + i);
+    }
+  }
+  std::uint8_t values[256];
+};
+
+constexpr NibbleTable kNibbles;
+
+// Decodes |pairs| digit pairs; false on the first non-hex character.
+bool DecodePairs(const char* hex, std::size_t pairs, std::uint8_t* out) {
+  for (std::size_t i = 0; i < pairs; ++i) {
+    std::uint8_t high = kNibbles.values[static_cast<std::uint8_t>(hex[2 * i])];
+    std::uint8_t low = kNibbles.values[static_cast<std::uint8_t>(hex[2 * i + 1])];
+    if ((high | low) > 0x0F) return false;
+    out[i] = static_cast<std::uint8_t>((high << 4) | low);
+  }
+  return true;
+}
+
+#ifdef FLUTTER_BLUETOOTH_CLASSIC_HEX_SSE2
+
+// 16 digits -> 8 bytes. False if any of the 16 is not a hex digit.
+inline bool Decode16(const char* hex, std::uint8_t* out) {
+  const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex));
+
+  // Unsigned range checks via min: x <= n  <=>  min(x, n) == x
+  const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  const __m128i letter =
+      _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF) return false;
+
+  const __m128i nibbles =
+      _mm_or_si128(_mm_and_si128(is_digit, digit),
+                   _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+  // Each 16-bit lane holds (high digit, low digit) in memory order
+  const __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4);
+  const __m128i low = _mm_srli_epi16(nibbles, 8);
+  const __m128i bytes = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+  return true;
+}
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_HEX_SSE2
+
+}  // namespace
+
+std::size_t DecodeHexScalar(const char* hex, std::size_t length, std::uint8_t* out) {
+  std::size_t pairs = length / 2;
+  return DecodePairs(hex, pairs, out) ? pairs : kInvalidHex;
+}
+
+std::size_t DecodeHex(const char* hex, std::size_t length, std::uint8_t* out) {
+  std::size_t pairs = length / 2;
+  std::size_t done = 0;
+#ifdef FLUTTER_BLUETOOTH_CLASSIC_HEX_SSE2
+  for (; done + 8 <= pairs; done += 8) {
+    if (!Decode16(hex + 2 * done, out + done)) return kInvalidHex;
+  }
+#endif
+  return DecodePairs(hex + 2 * done, pairs - done, out + done) ? pairs : kInvalidHex;
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,25 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_HEX_DECODE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_HEX_DECODE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_bluetooth_classic {
+
+// Returned by the decoders when the input holds a non-hex character.
+constexpr std::size_t kInvalidHex = static_cast<std::size_t>(-1);
+
+// Decodes |length| / 2 bytes from hex digit pairs (either case) into |out|,
+// which must hold that many bytes. A trailing odd digit is ignored. Returns
+// the number of bytes written, or kInvalidHex if any decoded character is
+// not a hex digit.
+//
+// Converts 16 digits per step with SSE2 where available.
+std::size_t DecodeHex(const char* hex, std::size_t length, std::uint8_t* out);
+
+// Table-driven reference implementation with the same contract.
+std::size_t DecodeHexScalar(const char* hex, std::size_t length, std::uint8_t* out);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_HEX_DECODE_H_
@@ -0,0 +1,129 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_J1939_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_J1939_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_bluetooth_classic {
+
+// Parameter groups handled outside kSpnTable.
+// Transport protocol connection management (TP.CM) and data transfer
+// (TP.DT), J1939-21.
+constexpr std::uint32_t kPgnTpCm = 0xEC00;
+constexpr std::uint32_t kPgnTpDt = 0xEB00;
+// Active diagnostic trouble codes, J1939-73.
+constexpr std::uint32_t kPgnDm1 = 0xFECA;
+
+// The fields of a 29-bit J1939 CAN identifier.
+struct J1939Id {
+  std::uint8_t priority = 0;
+  // Parameter group number. For PDU1 groups (PF < 240) the PS byte is a
+  // destination address and is not part of the PGN.
+  std::uint32_t pgn = 0;
+  std::uint8_t source = 0;
+  // 0xFF (global) for PDU2 groups.
+  std::uint8_t destination = 0xFF;
+};
+
+constexpr J1939Id DecodeJ1939Id(std::uint32_t can_id) {
+  J1939Id id;
+  id.priority = static_cast<std::uint8_t>((can_id >> 26) & 0x7);
+  id.source = static_cast<std::uint8_t>(can_id & 0xFF);
+  const std::uint32_t pf = (can_id >> 16) & 0xFF;
+  const std::uint32_t ps = (can_id >> 8) & 0xFF;
+  const std::uint32_t dp = (can_id >> 24) & 0x3;
+  if (pf < 240) {
+    id.pgn = dp << 16 | pf << 8;
+    id.destination = static_cast<std::uint8_t>(ps);
+  } else {
+    id.pgn = dp << 16 | pf << 8 | ps;
+  }
+  return id;
+}
+
+// Where one SPN sits in its parameter group and how it scales (SAE
+// J1939-71). Values are little-endian; |byte| is 0-based (J1939 documents
+// count from 1).
+struct SpnDescriptor {
+  std::uint32_t spn;
+  std::uint32_t pgn;
+  std::uint8_t byte;
+  std::uint8_t bit;
+  std::uint8_t bits;
+  double scale;
+  double offset;
+  const char* id;
+  const char* unit;
+};
+
+// Decodes |spn| from a frame's data bytes to SAE units (raw * scale +
+// offset). Returns false if the frame is too short or the raw value is in
+// the error / not-available range (0xFE.., 0xFF.. and their bit-field
+// equivalents).
+inline bool DecodeSpn(const SpnDescriptor& spn, const std::uint8_t* data, std::size_t size,
+                      double* value) {
+  const std::size_t end_bit = std::size_t{spn.byte} * 8 + spn.bit + spn.bits;
+  if (end_bit > size * 8 || spn.bits == 0 || spn.bits > 32) return false;
+  std::uint64_t raw = 0;
+  const std::size_t last = (end_bit - 1) / 8;
+  for (std::size_t i = last + 1; i-- > spn.byte;) raw = raw << 8 | data[i];
+  raw = (raw >> spn.bit) & ((std::uint64_t{1} << spn.bits) - 1);
+  // Valid ranges end at 0xFA, 0xFAFF, 0xFAFFFFFF; short fields at max - 2
+  const std::uint64_t max_valid =
+      spn.bits >= 8 ? (std::uint64_t{0xFB} << (spn.bits - 8)) - 1
+                    : (std::uint64_t{1} << spn.bits) - 3;
+  if (raw > max_valid) return false;
+  *value = static_cast<double>(raw) * spn.scale + spn.offset;
+  return true;
+}
+
+// Lamp states of a DM1 (J1939-73). On means the lamp is commanded on;
+// |flash| is the second byte as sent, 2 bits per lamp in the same order
+// (00 slow, 01 fast, 11 not flashing).
+struct J1939Lamps {
+  bool malfunction = false;
+  bool red_stop = false;
+  bool amber_warning = false;
+  bool protect = false;
+  std::uint8_t flash = 0xFF;
+};
+
+// One active fault of a DM1.
+struct J1939Dtc {
+  std::uint32_t spn = 0;
+  // Failure mode identifier.
+  std::uint8_t fmi = 0;
+  // Occurrence count; 0x7F if not available.
+  std::uint8_t occurrences = 0;
+};
+
+// Decodes a DM1 payload: two lamp bytes, then 4 bytes per DTC. Only SPN
+// conversion method 4 is decoded; entries with the CM bit set (the
+// pre-1996 byte orders) are skipped. Up to
+// |capacity| DTCs are written to |dtcs| and their number returned. The
+// all-zero "no active faults" entry and 0xFF padding are skipped. Returns 0
+// with the lamps untouched if |size| is below 2.
+inline std::size_t DecodeDm1(const std::uint8_t* data, std::size_t size, J1939Lamps* lamps,
+                             J1939Dtc* dtcs, std::size_t capacity) {
+  if (size < 2) return 0;
+  lamps->malfunction = (data[0] >> 6 & 0x3) == 1;
+  lamps->red_stop = (data[0] >> 4 & 0x3) == 1;
+  lamps->amber_warning = (data[0] >> 2 & 0x3) == 1;
+  lamps->protect = (data[0] & 0x3) == 1;
+  lamps->flash = data[1];
+  std::size_t count = 0;
+  for (std::size_t i = 2; i + 4 <= size && count < capacity; i += 4) {
+    const std::uint32_t spn = data[i] | static_cast<std::uint32_t>(data[i + 1]) << 8 |
+                              static_cast<std::uint32_t>(data[i + 2] >> 5) << 16;
+    if (spn == 0 || spn == 0x7FFFF || (data[i + 3] & 0x80) != 0) continue;
+    dtcs[count].spn = spn;
+    dtcs[count].fmi = data[i + 2] & 0x1F;
+    dtcs[count].occurrences = data[i + 3] & 0x7F;
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_J1939_H_
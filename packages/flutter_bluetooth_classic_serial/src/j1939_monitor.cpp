@@ -0,0 +1,292 @@
+#include "j1939_monitor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#include "hex_decode.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Where |pgn| sits in a 29-bit id, and which of its bits identify it: the
+// PS byte of a PDU1 group is the destination address.
+std::uint32_t PgnBits(std::uint32_t pgn) { return pgn << 8; }
+std::uint32_t PgnMask(std::uint32_t pgn) {
+  return ((pgn >> 8) & 0xFF) < 240 ? 0x03FF0000 : 0x03FFFF00;
+}
+
+std::vector<std::uint32_t> TablePgns() {
+  std::vector<std::uint32_t> pgns;
+  for (const auto& spn : kSpnTable) {
+    if (pgns.empty() || pgns.back() != spn.pgn) pgns.push_back(spn.pgn);
+  }
+  pgns.push_back(kPgnDm1);
+  return pgns;
+}
+
+bool WantsDm1(const std::vector<std::uint32_t>& pgns) {
+  return pgns.empty() || std::find(pgns.begin(), pgns.end(), kPgnDm1) != pgns.end();
+}
+
+std::string Hex32(const char* format, std::uint32_t a, std::uint32_t b = 0) {
+  char text[32];
+  std::snprintf(text, sizeof(text), format, a, b);
+  return text;
+}
+
+}  // namespace
+
+J1939MonitorCommands MakeJ1939MonitorCommands(const std::vector<std::uint32_t>& pgns, bool stn) {
+  std::vector<std::uint32_t> wanted = pgns.empty() ? TablePgns() : pgns;
+  if (WantsDm1(pgns)) {
+    wanted.push_back(kPgnTpCm);
+    wanted.push_back(kPgnTpDt);
+  }
+  J1939MonitorCommands commands;
+  commands.setup = {"ATH1", "ATS0", "ATCAF0"};
+  if (stn) {
+    commands.setup.push_back("STFCP");
+    for (std::uint32_t pgn : wanted) {
+      commands.setup.push_back(Hex32("STFAP %08X,%08X", PgnBits(pgn), PgnMask(pgn)));
+    }
+    commands.start = "STMA";
+    commands.restore = {"ATCAF1", "STFCP"};
+    return commands;
+  }
+
+  // The bits every wanted id agrees on
+  std::uint32_t mask = 0x03FFFF00;
+  for (std::uint32_t pgn : wanted) {
+    mask &= PgnMask(pgn) & ~(PgnBits(pgn) ^ PgnBits(wanted.front()));
+  }
+  commands.setup.push_back(Hex32("ATCF%08X", PgnBits(wanted.front()) & mask));
+  commands.setup.push_back(Hex32("ATCM%08X", mask));
+  commands.start = "ATMA";
+  commands.restore = {"ATCAF1", "ATCF00000000", "ATCM00000000", "ATAR"};
+  return commands;
+}
+
+J1939Monitor::J1939Monitor() { SetPgns({}); }
+
+void J1939Monitor::SetPgns(const std::vector<std::uint32_t>& pgns) {
+  for (std::size_t i = 0; i < kSpnCount; ++i) {
+    enabled_[i] = pgns.empty() ||
+                  std::find(pgns.begin(), pgns.end(), kSpnTable[i].pgn) != pgns.end();
+  }
+  dm1_enabled_ = WantsDm1(pgns);
+}
+
+bool J1939Monitor::Feed(const std::uint8_t* data, std::size_t length, Clock::time_point now) {
+  for (std::size_t i = 0; i < length; ++i) {
+    const char c = static_cast<char>(data[i]);
+    switch (c) {
+      case '>':
+        // Nothing follows the prompt until the next command is written
+        EndLine(now);
+        return true;
+      case '\r':
+      case '\n':
+        EndLine(now);
+        break;
+      case ' ':
+      case '\0':
+        break;
+      default:
+        if (line_length_ == kMaxLine) {
+          line_overlong_ = true;
+          break;
+        }
+        line_[line_length_++] = c;
+        if (!std::isxdigit(static_cast<unsigned char>(c))) line_hex_ = false;
+        break;
+    }
+  }
+  return false;
+}
+
+void J1939Monitor::EndLine(Clock::time_point now) {
+  const std::size_t length = line_length_;
+  const bool hex = line_hex_ && !line_overlong_;
+  line_length_ = 0;
+  line_hex_ = true;
+  line_overlong_ = false;
+  if (length == 0) return;
+
+  // A 29-bit id and 0-8 data bytes
+  if (hex && length >= 8 && length <= 24 && length % 2 == 0) {
+    std::uint8_t bytes[12];
+    DecodeHex(line_, length, bytes);
+    const std::uint32_t can_id = static_cast<std::uint32_t>(bytes[0]) << 24 |
+                                 static_cast<std::uint32_t>(bytes[1]) << 16 |
+                                 static_cast<std::uint32_t>(bytes[2]) << 8 | bytes[3];
+    if (can_id <= 0x1FFFFFFF) {
+      OnFrame(can_id, bytes + 4, length / 2 - 4, now);
+      return;
+    }
+  }
+  if (length >= 10 && std::memcmp(line_, "BUFFERFULL", 10) == 0) {
+    Add(&overflows_);
+  } else if (length == 7 && std::memcmp(line_, "STOPPED", 7) == 0) {
+    // The adapter's answer to the byte that ended monitoring
+  } else {
+    Add(&malformed_);
+  }
+}
+
+void J1939Monitor::OnFrame(std::uint32_t can_id, const std::uint8_t* data, std::size_t size,
+                           Clock::time_point now) {
+  Add(&frames_);
+  const J1939Id id = DecodeJ1939Id(can_id);
+  if (dm1_enabled_ && (id.pgn == kPgnDm1 || J1939Transport::IsTransport(id.pgn))) {
+    if (id.pgn == kPgnDm1) {
+      Add(OnDm1(id.source, data, size, now) ? &decoded_ : &ignored_);
+      return;
+    }
+    // Packets of a transfer in progress are neither decoded nor ignored
+    J1939Message message;
+    if (!transport_.Offer(id, data, size, now, &message)) return;
+    const bool dm1 = message.pgn == kPgnDm1 &&
+                     OnDm1(message.source, message.data, message.size, now);
+    Add(dm1 ? &decoded_ : &ignored_);
+    return;
+  }
+  const SpnDescriptor* first = std::lower_bound(
+      std::begin(kSpnTable), std::end(kSpnTable), id.pgn,
+      [](const SpnDescriptor& spn, std::uint32_t pgn) { return spn.pgn < pgn; });
+  bool wanted = false;
+  bool decoded = false;
+  for (const SpnDescriptor* spn = first; spn != std::end(kSpnTable) && spn->pgn == id.pgn; ++spn) {
+    const auto index = static_cast<std::size_t>(spn - kSpnTable);
+    if (!enabled_[index]) continue;
+    wanted = true;
+    double value;
+    if (!DecodeSpn(*spn, data, size, &value)) continue;
+    Publish(index, value, id.source, now);
+    decoded = true;
+  }
+  if (!wanted) {
+    Add(&ignored_);
+  } else if (decoded) {
+    Add(&decoded_);
+  }
+}
+
+void J1939Monitor::Publish(std::size_t index, double value, std::uint8_t source,
+                           Clock::time_point now) {
+  Slot& slot = slots_[index];
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const std::uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.value_bits.store(bits, std::memory_order_relaxed);
+  slot.at_ns.store(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+      std::memory_order_relaxed);
+  slot.source.store(source, std::memory_order_relaxed);
+  slot.updates.store(slot.updates.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool J1939Monitor::OnDm1(std::uint8_t source, const std::uint8_t* data, std::size_t size,
+                         Clock::time_point now) {
+  if (size < 2) return false;
+  std::lock_guard<std::mutex> lock(dm1_mutex_);
+  Dm1Slot* slot = nullptr;
+  for (auto& candidate : dm1_) {
+    if (candidate.used && candidate.source == source) {
+      slot = &candidate;
+      break;
+    }
+    if (!candidate.used && !slot) slot = &candidate;
+  }
+  if (!slot) return false;
+  slot->used = true;
+  slot->source = source;
+  slot->count = DecodeDm1(data, size, &slot->lamps, slot->dtcs, kMaxDm1Dtcs);
+  slot->at = now;
+  ++slot->updates;
+  return true;
+}
+
+std::vector<J1939Value> J1939Monitor::Snapshot() const {
+  std::vector<J1939Value> values;
+  for (std::size_t i = 0; i < kSpnCount; ++i) {
+    const Slot& slot = slots_[i];
+    J1939Value value;
+    std::uint64_t bits;
+    std::int64_t at_ns;
+    std::uint32_t before;
+    std::uint32_t after;
+    do {
+      before = slot.sequence.load(std::memory_order_acquire);
+      bits = slot.value_bits.load(std::memory_order_relaxed);
+      at_ns = slot.at_ns.load(std::memory_order_relaxed);
+      value.source = static_cast<std::uint8_t>(slot.source.load(std::memory_order_relaxed));
+      value.updates = slot.updates.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = slot.sequence.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1) != 0);
+    if (value.updates == 0) continue;
+    value.spn = &kSpnTable[i];
+    std::memcpy(&value.value, &bits, sizeof(bits));
+    value.at = Clock::time_point(
+        std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(at_ns)));
+    values.push_back(value);
+  }
+  return values;
+}
+
+std::vector<J1939Dm1> J1939Monitor::Dm1Snapshot() const {
+  std::vector<J1939Dm1> dm1s;
+  std::lock_guard<std::mutex> lock(dm1_mutex_);
+  for (const auto& slot : dm1_) {
+    if (!slot.used) continue;
+    J1939Dm1 dm1;
+    dm1.source = slot.source;
+    dm1.lamps = slot.lamps;
+    dm1.dtcs.assign(slot.dtcs, slot.dtcs + slot.count);
+    dm1.at = slot.at;
+    dm1.updates = slot.updates;
+    dm1s.push_back(std::move(dm1));
+  }
+  std::sort(dm1s.begin(), dm1s.end(),
+            [](const J1939Dm1& a, const J1939Dm1& b) { return a.source < b.source; });
+  return dm1s;
+}
+
+J1939MonitorCounters J1939Monitor::counters() const {
+  J1939MonitorCounters counters;
+  counters.frames = frames_.load(std::memory_order_relaxed);
+  counters.decoded = decoded_.load(std::memory_order_relaxed);
+  counters.ignored = ignored_.load(std::memory_order_relaxed);
+  counters.malformed = malformed_.load(std::memory_order_relaxed);
+  counters.overflows = overflows_.load(std::memory_order_relaxed);
+  counters.transport = transport_.counters();
+  return counters;
+}
+
+void J1939Monitor::Reset() {
+  for (auto& slot : slots_) {
+    slot.sequence.store(0, std::memory_order_relaxed);
+    slot.updates.store(0, std::memory_order_relaxed);
+  }
+  transport_.Reset();
+  {
+    std::lock_guard<std::mutex> lock(dm1_mutex_);
+    for (auto& slot : dm1_) slot = Dm1Slot();
+  }
+  line_length_ = 0;
+  line_hex_ = true;
+  line_overlong_ = false;
+  frames_.store(0, std::memory_order_relaxed);
+  decoded_.store(0, std::memory_order_relaxed);
+  ignored_.store(0, std::memory_order_relaxed);
+  malformed_.store(0, std::memory_order_relaxed);
+  overflows_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace flutter_bluetooth_classic
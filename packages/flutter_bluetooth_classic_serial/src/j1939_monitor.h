@@ -0,0 +1,168 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_J1939_MONITOR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_J1939_MONITOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "j1939_spn_table.h"
+#include "j1939_transport.h"
+
+namespace flutter_bluetooth_classic {
+
+// Adapter commands around a monitoring session.
+struct J1939MonitorCommands {
+  // Headers on, spaces off, raw CAN data (no ISO-TP formatting), and
+  // hardware filters for the wanted PGNs.
+  std::vector<std::string> setup;
+  // Starts monitoring: ATMA, or STMA on OBDLink (STN) adapters. Any byte
+  // written afterwards stops it.
+  std::string start;
+  // Puts ISO-TP formatting back and clears the filters.
+  std::vector<std::string> restore;
+};
+
+// Commands to monitor |pgns| (every PGN of kSpnTable and DM1 if empty).
+// DM1 brings the transport protocol groups its multi-fault messages arrive
+// in. ELM327 has one filter/mask pair, so it passes the PGN bits all of
+// them share and the monitor drops the rest; STN adapters get a pass
+// filter per PGN.
+J1939MonitorCommands MakeJ1939MonitorCommands(const std::vector<std::uint32_t>& pgns, bool stn);
+
+// Latest value of one SPN.
+struct J1939Value {
+  const SpnDescriptor* spn = nullptr;
+  double value = 0;
+  // Source address of the frame it came from.
+  std::uint8_t source = 0;
+  std::chrono::steady_clock::time_point at;
+  std::uint64_t updates = 0;
+};
+
+// Latest DM1 (active faults) of one ECU.
+struct J1939Dm1 {
+  std::uint8_t source = 0;
+  J1939Lamps lamps;
+  std::vector<J1939Dtc> dtcs;
+  std::chrono::steady_clock::time_point at;
+  std::uint64_t updates = 0;
+};
+
+struct J1939MonitorCounters {
+  std::uint64_t frames = 0;
+  // Frames with at least one SPN decoded, or that completed a DM1.
+  std::uint64_t decoded = 0;
+  // Frames of PGNs not in kSpnTable or not asked for.
+  std::uint64_t ignored = 0;
+  // Lines that are not a 29-bit frame ("<DATA ERROR", 11-bit ids, noise).
+  std::uint64_t malformed = 0;
+  // "BUFFER FULL": the adapter could not send frames as fast as the bus
+  // delivered them, and stopped.
+  std::uint64_t overflows = 0;
+  J1939TransportCounters transport;
+};
+
+// Decodes the frame stream of an adapter in monitor mode (ATMA / STMA with
+// ATH1): lines of a 29-bit id and up to 8 data bytes, with or without
+// spaces. Each frame's PGN is looked up in kSpnTable, its SPNs decoded, and
+// the latest value and timestamp of each published. DM1s are decoded per
+// sending ECU, multi-packet ones once J1939Transport has reassembled them.
+//
+// Bytes are looked at once and lines are assembled in a fixed buffer, so
+// Feed() does not allocate. Each SPN's value sits behind its own sequence
+// lock: Feed() runs on the link's receive thread, Snapshot() on any thread
+// and never blocks it. DM1s, sent about once a second, are stored in fixed
+// slots under a mutex.
+class J1939Monitor {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Longest line kept: "18 FE F1 00" plus 8 spaced bytes is 35 characters.
+  static constexpr std::size_t kMaxLine = 48;
+
+  J1939Monitor();
+  J1939Monitor(const J1939Monitor&) = delete;
+  J1939Monitor& operator=(const J1939Monitor&) = delete;
+
+  // Most ECUs whose DM1 is kept; later ones are counted as ignored.
+  static constexpr std::size_t kMaxDm1Sources = 8;
+  // Faults that fit one transport protocol message.
+  static constexpr std::size_t kMaxDm1Dtcs = (J1939Transport::kMaxPayload - 2) / 4;
+
+  // Decodes only |pgns| (every PGN of kSpnTable and DM1 if empty). Not safe
+  // while Feed() runs; call before monitoring starts.
+  void SetPgns(const std::vector<std::uint32_t>& pgns);
+
+  // Consumes monitor output received at |now|. Returns true when the '>'
+  // prompt that ends monitoring arrived; the bytes after it are not
+  // consumed.
+  bool Feed(const std::uint8_t* data, std::size_t length, Clock::time_point now);
+
+  // Decodes one frame.
+  void OnFrame(std::uint32_t can_id, const std::uint8_t* data, std::size_t size,
+               Clock::time_point now);
+
+  // Every SPN seen since the last Reset(), in table order.
+  std::vector<J1939Value> Snapshot() const;
+  // The latest DM1 of every ECU that sent one, by source address.
+  std::vector<J1939Dm1> Dm1Snapshot() const;
+  J1939MonitorCounters counters() const;
+
+  // Forgets values, counters and any partial line. Not safe while Feed()
+  // runs.
+  void Reset();
+
+ private:
+  struct Slot {
+    // Odd while the receive thread is writing the slot.
+    std::atomic<std::uint32_t> sequence{0};
+    std::atomic<std::uint64_t> value_bits{0};
+    std::atomic<std::int64_t> at_ns{0};
+    std::atomic<std::uint32_t> source{0};
+    std::atomic<std::uint64_t> updates{0};
+  };
+
+  struct Dm1Slot {
+    bool used = false;
+    std::uint8_t source = 0;
+    J1939Lamps lamps;
+    std::size_t count = 0;
+    J1939Dtc dtcs[kMaxDm1Dtcs];
+    Clock::time_point at;
+    std::uint64_t updates = 0;
+  };
+
+  void EndLine(Clock::time_point now);
+  bool OnDm1(std::uint8_t source, const std::uint8_t* data, std::size_t size,
+             Clock::time_point now);
+  void Publish(std::size_t index, double value, std::uint8_t source, Clock::time_point now);
+  static void Add(std::atomic<std::uint64_t>* counter) {
+    counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  bool enabled_[kSpnCount];
+  Slot slots_[kSpnCount];
+  bool dm1_enabled_ = true;
+  J1939Transport transport_;
+  mutable std::mutex dm1_mutex_;
+  Dm1Slot dm1_[kMaxDm1Sources];
+
+  char line_[kMaxLine];
+  std::size_t line_length_ = 0;
+  bool line_hex_ = true;
+  bool line_overlong_ = false;
+
+  std::atomic<std::uint64_t> frames_{0};
+  std::atomic<std::uint64_t> decoded_{0};
+  std::atomic<std::uint64_t> ignored_{0};
+  std::atomic<std::uint64_t> malformed_{0};
+  std::atomic<std::uint64_t> overflows_{0};
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_J1939_MONITOR_H_
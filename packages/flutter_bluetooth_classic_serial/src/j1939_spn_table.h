@@ -0,0 +1,71 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_J1939_SPN_TABLE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_J1939_SPN_TABLE_H_
+
+#include <cstddef>
+
+#include "j1939.h"
+
+namespace flutter_bluetooth_classic {
+
+// Broadcast parameters the monitor decodes, sorted by PGN. Units are SAE's
+// (C, kPa, L/h); the app converts for display.
+inline constexpr SpnDescriptor kSpnTable[] = {
+    // EEC2 - Electronic Engine Controller 2
+    {91, 0xF003, 1, 0, 8, 0.4, 0, "acceleratorPedal", "%"},
+    {92, 0xF003, 2, 0, 8, 1, 0, "engineLoad", "%"},
+    // EEC1 - Electronic Engine Controller 1
+    {512, 0xF004, 1, 0, 8, 1, -125, "driverDemandTorque", "%"},
+    {513, 0xF004, 2, 0, 8, 1, -125, "actualTorque", "%"},
+    {190, 0xF004, 3, 0, 16, 0.125, 0, "engineSpeed", "rpm"},
+    // ETC2 - Electronic Transmission Controller 2
+    {524, 0xF005, 0, 0, 8, 1, -125, "selectedGear", ""},
+    {526, 0xF005, 1, 0, 16, 0.001, 0, "gearRatio", ""},
+    {523, 0xF005, 3, 0, 8, 1, -125, "currentGear", ""},
+    // HOURS - Engine Hours, Revolutions
+    {247, 0xFEE5, 0, 0, 32, 0.05, 0, "engineHours", "h"},
+    // LFC - Fuel Consumption (Liquid)
+    {250, 0xFEE9, 4, 0, 32, 0.5, 0, "totalFuelUsed", "L"},
+    // ET1 - Engine Temperature 1
+    {110, 0xFEEE, 0, 0, 8, 1, -40, "coolantTemp", "C"},
+    {174, 0xFEEE, 1, 0, 8, 1, -40, "fuelTemp", "C"},
+    {175, 0xFEEE, 2, 0, 16, 0.03125, -273, "oilTemp", "C"},
+    {52, 0xFEEE, 6, 0, 8, 1, -40, "intercoolerTemp", "C"},
+    // EFL/P1 - Engine Fluid Level/Pressure 1
+    {94, 0xFEEF, 0, 0, 8, 4, 0, "fuelDeliveryPressure", "kPa"},
+    {98, 0xFEEF, 2, 0, 8, 0.4, 0, "oilLevel", "%"},
+    {100, 0xFEEF, 3, 0, 8, 4, 0, "oilPressure", "kPa"},
+    {109, 0xFEEF, 6, 0, 8, 2, 0, "coolantPressure", "kPa"},
+    // CCVS - Cruise Control/Vehicle Speed
+    {84, 0xFEF1, 1, 0, 16, 1.0 / 256, 0, "wheelSpeed", "km/h"},
+    // LFE - Fuel Economy (Liquid)
+    {183, 0xFEF2, 0, 0, 16, 0.05, 0, "fuelRate", "L/h"},
+    {184, 0xFEF2, 2, 0, 16, 1.0 / 512, 0, "fuelEconomy", "km/L"},
+    {51, 0xFEF2, 6, 0, 8, 0.4, 0, "throttlePosition", "%"},
+    // AMB - Ambient Conditions
+    {108, 0xFEF5, 0, 0, 8, 0.5, 0, "barometricPressure", "kPa"},
+    {171, 0xFEF5, 3, 0, 16, 0.03125, -273, "ambientTemp", "C"},
+    // IC1 - Inlet/Exhaust Conditions 1
+    {81, 0xFEF6, 0, 0, 8, 0.5, 0, "dpfInletPressure", "kPa"},
+    {102, 0xFEF6, 1, 0, 8, 2, 0, "boostPressure", "kPa"},
+    {105, 0xFEF6, 2, 0, 8, 1, -40, "intakeManifoldTemp", "C"},
+    {106, 0xFEF6, 3, 0, 8, 2, 0, "airInletPressure", "kPa"},
+    {173, 0xFEF6, 5, 0, 16, 0.03125, -273, "exhaustGasTemp", "C"},
+    // VEP1 - Vehicle Electrical Power 1
+    {168, 0xFEF7, 4, 0, 16, 0.05, 0, "batteryVoltage", "V"},
+    // DD - Dash Display
+    {96, 0xFEFC, 1, 0, 8, 0.4, 0, "fuelLevel", "%"},
+};
+
+inline constexpr std::size_t kSpnCount = sizeof(kSpnTable) / sizeof(kSpnTable[0]);
+
+constexpr bool SpnTableSorted() {
+  for (std::size_t i = 1; i < kSpnCount; ++i) {
+    if (kSpnTable[i].pgn < kSpnTable[i - 1].pgn) return false;
+  }
+  return true;
+}
+static_assert(SpnTableSorted(), "kSpnTable must be sorted by PGN");
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_J1939_SPN_TABLE_H_
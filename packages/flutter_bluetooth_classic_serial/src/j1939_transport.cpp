@@ -0,0 +1,184 @@
+#include "j1939_transport.h"
+
+#include <cstring>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// TP.CM control bytes
+constexpr std::uint8_t kRts = 16;
+constexpr std::uint8_t kCts = 17;
+constexpr std::uint8_t kEndOfMessageAck = 19;
+constexpr std::uint8_t kBam = 32;
+constexpr std::uint8_t kAbort = 255;
+
+std::uint32_t ControlPgn(const std::uint8_t* data) {
+  return data[5] | static_cast<std::uint32_t>(data[6]) << 8 |
+         static_cast<std::uint32_t>(data[7]) << 16;
+}
+
+}  // namespace
+
+bool J1939Transport::Offer(const J1939Id& id, const std::uint8_t* data, std::size_t size,
+                           Clock::time_point now, J1939Message* message) {
+  // Both groups are always sent as 8-byte frames
+  if (size < 8) {
+    Add(&malformed_);
+    return false;
+  }
+  if (id.pgn == kPgnTpCm) {
+    OnControl(id, data, now);
+    return false;
+  }
+  if (id.pgn == kPgnTpDt) return OnData(id, data, size, now, message);
+  return false;
+}
+
+void J1939Transport::OnControl(const J1939Id& id, const std::uint8_t* data,
+                               Clock::time_point now) {
+  switch (data[0]) {
+    case kBam:
+    case kRts: {
+      const bool broadcast = data[0] == kBam;
+      // A BAM goes to the global address; an RTS to one ECU
+      if (broadcast != (id.destination == 0xFF)) {
+        Add(&malformed_);
+        return;
+      }
+      const std::size_t bytes = data[1] | static_cast<std::size_t>(data[2]) << 8;
+      if (bytes < 9 || bytes > kMaxPayload || data[3] != (bytes + 6) / 7) {
+        Add(&malformed_);
+        return;
+      }
+      // A new announcement ends the sender's transfer to the same place
+      Session* session = Find(id.source, id.destination);
+      if (session) {
+        Add(&aborts_);
+      } else {
+        for (auto& slot : sessions_) {
+          if (!slot.active || !Live(&slot, now)) {
+            session = &slot;
+            break;
+          }
+        }
+        if (!session) {
+          Add(&pool_full_);
+          return;
+        }
+      }
+      session->active = true;
+      session->broadcast = broadcast;
+      session->source = id.source;
+      session->destination = id.destination;
+      session->pgn = ControlPgn(data);
+      session->size = static_cast<std::uint16_t>(bytes);
+      session->packets = data[3];
+      session->next = 1;
+      session->last = now;
+      return;
+    }
+    case kCts: {
+      // From the receiver: the sender is its destination
+      Session* session = Find(id.destination, id.source);
+      if (!session || !Live(session, now)) return;
+      session->last = now;
+      // 0 packets means "wait"; otherwise it names the packet to send next,
+      // which is earlier than expected when the receiver wants a resend
+      if (data[1] != 0 && data[2] >= 1 && data[2] <= session->next) session->next = data[2];
+      return;
+    }
+    case kAbort: {
+      Session* session = Find(id.source, id.destination);
+      if (!session) session = Find(id.destination, id.source);
+      if (!session || session->broadcast) return;
+      session->active = false;
+      Add(&aborts_);
+      return;
+    }
+    case kEndOfMessageAck:
+    default:
+      return;
+  }
+}
+
+bool J1939Transport::OnData(const J1939Id& id, const std::uint8_t* data, std::size_t size,
+                            Clock::time_point now, J1939Message* message) {
+  Session* session = Find(id.source, id.destination);
+  if (!session || !Live(session, now)) return false;
+  if (data[0] != session->next) {
+    // A repeat of the packet just taken is harmless (a resend the CTS asked
+    // for arrives again); anything else leaves a hole
+    if (data[0] + 1 == session->next) return false;
+    session->active = false;
+    Add(&sequence_errors_);
+    return false;
+  }
+  const std::size_t offset = std::size_t{data[0] - 1u} * 7;
+  const std::size_t take = session->size - offset < 7 ? session->size - offset : 7;
+  std::memcpy(session->data + offset, data + 1, take < size - 1 ? take : size - 1);
+  session->last = now;
+  if (session->next++ != session->packets) return false;
+
+  session->active = false;
+  Add(&messages_);
+  message->pgn = session->pgn;
+  message->source = session->source;
+  message->destination = session->destination;
+  message->data = session->data;
+  message->size = session->size;
+  return true;
+}
+
+J1939Transport::Session* J1939Transport::Find(std::uint8_t source, std::uint8_t destination) {
+  for (auto& session : sessions_) {
+    if (session.active && session.source == source && session.destination == destination) {
+      return &session;
+    }
+  }
+  return nullptr;
+}
+
+bool J1939Transport::Live(Session* session, Clock::time_point now) {
+  const auto timeout = session->broadcast ? Clock::duration(kBamTimeout)
+                                          : Clock::duration(kConnectionTimeout);
+  if (now - session->last <= timeout) return true;
+  session->active = false;
+  Add(&timeouts_);
+  return false;
+}
+
+void J1939Transport::Expire(Clock::time_point now) {
+  for (auto& session : sessions_) {
+    if (session.active) Live(&session, now);
+  }
+}
+
+std::size_t J1939Transport::active() const {
+  std::size_t count = 0;
+  for (const auto& session : sessions_) count += session.active ? 1 : 0;
+  return count;
+}
+
+J1939TransportCounters J1939Transport::counters() const {
+  J1939TransportCounters counters;
+  counters.messages = messages_.load(std::memory_order_relaxed);
+  counters.sequence_errors = sequence_errors_.load(std::memory_order_relaxed);
+  counters.timeouts = timeouts_.load(std::memory_order_relaxed);
+  counters.aborts = aborts_.load(std::memory_order_relaxed);
+  counters.pool_full = pool_full_.load(std::memory_order_relaxed);
+  counters.malformed = malformed_.load(std::memory_order_relaxed);
+  return counters;
+}
+
+void J1939Transport::Reset() {
+  for (auto& session : sessions_) session.active = false;
+  messages_.store(0, std::memory_order_relaxed);
+  sequence_errors_.store(0, std::memory_order_relaxed);
+  timeouts_.store(0, std::memory_order_relaxed);
+  aborts_.store(0, std::memory_order_relaxed);
+  pool_full_.store(0, std::memory_order_relaxed);
+  malformed_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,119 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_J1939_TRANSPORT_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_J1939_TRANSPORT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "j1939.h"
+
+namespace flutter_bluetooth_classic {
+
+// A reassembled multi-packet message.
+struct J1939Message {
+  std::uint32_t pgn = 0;
+  std::uint8_t source = 0;
+  // 0xFF for a broadcast (BAM) transfer.
+  std::uint8_t destination = 0xFF;
+  // Owned by the transport; valid until its next Offer() or Reset().
+  const std::uint8_t* data = nullptr;
+  std::size_t size = 0;
+};
+
+struct J1939TransportCounters {
+  std::uint64_t messages = 0;
+  // Sessions dropped for a packet out of order.
+  std::uint64_t sequence_errors = 0;
+  // Sessions dropped for a gap longer than J1939-21 allows.
+  std::uint64_t timeouts = 0;
+  // Sessions aborted by either side or replaced by a new announcement.
+  std::uint64_t aborts = 0;
+  // Announcements ignored because every session slot was in use.
+  std::uint64_t pool_full = 0;
+  // Announcements with an impossible size or packet count.
+  std::uint64_t malformed = 0;
+};
+
+// Reassembles J1939-21 transport protocol transfers as they pass on the
+// bus: broadcast (BAM) and, listening to both sides, connection mode
+// (RTS/CTS) transfers of up to 1785 bytes. Sessions are kept per sender
+// and destination, so every ECU can be mid-transfer at once.
+//
+// Each session reassembles into a slot of a fixed pool, so Offer() never
+// allocates. A packet out of sequence drops its session, as does a gap
+// longer than T1 (750 ms between BAM packets) or T2 (1250 ms for
+// connection mode, which waits on the receiver's CTS). Connection mode
+// transfers complete when the last packet arrives; the receiver's
+// acknowledgement is not waited for.
+//
+// Offer() runs on one thread; counters() may be read from any.
+class J1939Transport {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr std::size_t kMaxSessions = 16;
+  // 255 packets of 7 bytes.
+  static constexpr std::size_t kMaxPayload = 1785;
+  static constexpr auto kBamTimeout = std::chrono::milliseconds(750);
+  static constexpr auto kConnectionTimeout = std::chrono::milliseconds(1250);
+
+  J1939Transport() = default;
+  J1939Transport(const J1939Transport&) = delete;
+  J1939Transport& operator=(const J1939Transport&) = delete;
+
+  static bool IsTransport(std::uint32_t pgn) { return pgn == kPgnTpCm || pgn == kPgnTpDt; }
+
+  // Takes one TP.CM or TP.DT frame. Returns true and fills |message| when
+  // it completes a transfer.
+  bool Offer(const J1939Id& id, const std::uint8_t* data, std::size_t size,
+             Clock::time_point now, J1939Message* message);
+
+  // Drops sessions that have timed out. Offer() does this for the slots
+  // it touches; call it when the bus goes quiet.
+  void Expire(Clock::time_point now);
+
+  // Sessions in progress. Offer()'s thread only.
+  std::size_t active() const;
+  J1939TransportCounters counters() const;
+
+  void Reset();
+
+ private:
+  struct Session {
+    bool active = false;
+    bool broadcast = false;
+    std::uint8_t source = 0;
+    std::uint8_t destination = 0;
+    std::uint32_t pgn = 0;
+    std::uint16_t size = 0;
+    std::uint8_t packets = 0;
+    // Sequence number of the packet expected next, from 1.
+    std::uint8_t next = 1;
+    Clock::time_point last;
+    std::uint8_t data[kMaxPayload];
+  };
+
+  void OnControl(const J1939Id& id, const std::uint8_t* data, Clock::time_point now);
+  bool OnData(const J1939Id& id, const std::uint8_t* data, std::size_t size,
+              Clock::time_point now, J1939Message* message);
+  Session* Find(std::uint8_t source, std::uint8_t destination);
+  // Drops |session| if it has timed out; returns whether it is still active.
+  bool Live(Session* session, Clock::time_point now);
+  static void Add(std::atomic<std::uint64_t>* counter) {
+    counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  Session sessions_[kMaxSessions];
+
+  std::atomic<std::uint64_t> messages_{0};
+  std::atomic<std::uint64_t> sequence_errors_{0};
+  std::atomic<std::uint64_t> timeouts_{0};
+  std::atomic<std::uint64_t> aborts_{0};
+  std::atomic<std::uint64_t> pool_full_{0};
+  std::atomic<std::uint64_t> malformed_{0};
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_J1939_TRANSPORT_H_
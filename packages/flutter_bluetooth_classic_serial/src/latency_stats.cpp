@@ -0,0 +1,166 @@
+#include "latency_stats.h"
+
+#include <cmath>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Index of the highest set bit of a non-zero |value|.
+int FloorLog2(std::uint64_t value) {
+  int result = 0;
+  for (int shift = 32; shift > 0; shift /= 2) {
+    if (value >> shift) {
+      value >>= shift;
+      result += shift;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+std::size_t LatencyHistogram::BucketIndex(std::uint64_t value_us) {
+  if (value_us < kSubBuckets) return static_cast<std::size_t>(value_us);
+  const int exponent = FloorLog2(value_us);
+  if (exponent > kMaxExponent) return kBucketCount - 1;
+  const int shift = exponent - kSubBucketBits;
+  return static_cast<std::size_t>(shift + 1) * kSubBuckets +
+         static_cast<std::size_t>((value_us >> shift) - kSubBuckets);
+}
+
+std::uint64_t LatencyHistogram::BucketUpperBound(std::size_t index) {
+  if (index < kSubBuckets) return index;
+  const int shift = static_cast<int>(index / kSubBuckets) - 1;
+  const std::uint64_t lower = static_cast<std::uint64_t>(kSubBuckets + index % kSubBuckets)
+                              << shift;
+  return lower + (std::uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds value) {
+  const std::uint64_t us = value.count() > 0 ? static_cast<std::uint64_t>(value.count()) : 0;
+  buckets_[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_us_.fetch_add(us, std::memory_order_relaxed);
+  std::uint64_t max = max_us_.load(std::memory_order_relaxed);
+  while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+std::uint64_t LatencyHistogram::ValueAtQuantile(double quantile) const {
+  // Counted from the buckets so a concurrent Record() cannot push the rank
+  // past what the loop sees
+  std::uint64_t total = 0;
+  for (const auto& bucket : buckets_) total += bucket.load(std::memory_order_relaxed);
+  if (total == 0) return 0;
+
+  if (quantile < 0.0) quantile = 0.0;
+  if (quantile > 1.0) quantile = 1.0;
+  std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(total)));
+  if (rank == 0) rank = 1;
+
+  const std::uint64_t max = max_us_.load(std::memory_order_relaxed);
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      const std::uint64_t bound = BucketUpperBound(i);
+      return bound < max ? bound : max;
+    }
+  }
+  return max;
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+  LatencySummary summary;
+  summary.count = count_.load(std::memory_order_relaxed);
+  if (summary.count == 0) return summary;
+  summary.mean_us = sum_us_.load(std::memory_order_relaxed) / summary.count;
+  summary.p50_us = ValueAtQuantile(0.50);
+  summary.p90_us = ValueAtQuantile(0.90);
+  summary.p99_us = ValueAtQuantile(0.99);
+  summary.max_us = max_us_.load(std::memory_order_relaxed);
+  return summary;
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  sum_us_.store(0, std::memory_order_relaxed);
+  max_us_.store(0, std::memory_order_relaxed);
+}
+
+const char* LatencyPhaseName(LatencyPhase phase) {
+  switch (phase) {
+    case LatencyPhase::kFirstByte:
+      return "firstByte";
+    case LatencyPhase::kPrompt:
+      return "prompt";
+    case LatencyPhase::kRoundTrip:
+      return "roundTrip";
+    case LatencyPhase::kDelivery:
+      return "delivery";
+  }
+  return "unknown";
+}
+
+const char* LinkCounterName(LinkCounter counter) {
+  switch (counter) {
+    case LinkCounter::kBytesReceived:
+      return "bytesReceived";
+    case LinkCounter::kBytesSent:
+      return "bytesSent";
+    case LinkCounter::kResponses:
+      return "responses";
+    case LinkCounter::kTimeouts:
+      return "timeouts";
+    case LinkCounter::kWriteFailures:
+      return "writeFailures";
+    case LinkCounter::kOverflows:
+      return "overflows";
+    case LinkCounter::kDroppedBytes:
+      return "droppedBytes";
+  }
+  return "unknown";
+}
+
+CommandStats* LinkStats::ForCommand(const std::string& command) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = commands_.find(command);
+  if (it != commands_.end()) return it->second.get();
+
+  // One slot stays free for the overflow entry
+  const bool full = commands_.size() >= kMaxCommands - 1;
+  auto& entry = commands_[full ? std::string(kOtherCommand) : command];
+  if (!entry) entry = std::make_unique<CommandStats>();
+  return entry.get();
+}
+
+std::vector<CommandLatency> LinkStats::Snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<CommandLatency> snapshot;
+  snapshot.reserve(commands_.size());
+  for (const auto& entry : commands_) {
+    CommandLatency latency;
+    latency.command = entry.first;
+    latency.completed = entry.second->completed.load(std::memory_order_relaxed);
+    latency.timeouts = entry.second->timeouts.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < kLatencyPhaseCount; ++i) {
+      latency.phases[i] = entry.second->phases[i].Summarize();
+    }
+    snapshot.push_back(std::move(latency));
+  }
+  return snapshot;
+}
+
+void LinkStats::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : commands_) {
+    entry.second->completed.store(0, std::memory_order_relaxed);
+    entry.second->timeouts.store(0, std::memory_order_relaxed);
+    for (auto& phase : entry.second->phases) phase.Reset();
+  }
+  for (auto& counter : counters_) counter.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace flutter_bluetooth_classic
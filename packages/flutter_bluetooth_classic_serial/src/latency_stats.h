@@ -0,0 +1,163 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_LATENCY_STATS_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_LATENCY_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// Count, mean and percentiles of one histogram, in microseconds.
+struct LatencySummary {
+  std::uint64_t count = 0;
+  std::uint64_t mean_us = 0;
+  std::uint64_t p50_us = 0;
+  std::uint64_t p90_us = 0;
+  std::uint64_t p99_us = 0;
+  std::uint64_t max_us = 0;
+};
+
+// HDR-style histogram of durations in microseconds.
+//
+// Buckets are log-linear: values below 32 us get a bucket each, and every
+// power-of-two range above is split into 32 equal buckets, so a reported
+// percentile is within 1/32 (3.1%) of the true value from 1 us up to
+// kMaxTrackedUs. Longer values land in the last bucket; the maximum is
+// still exact.
+//
+// Record() is lock-free and wait-free (relaxed atomic adds) and safe from
+// any number of threads. Summarize() may run concurrently with recording
+// and then reflects some of the concurrent records.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+  // Highest power of two with full resolution: 2^24 us, about 16.8 s.
+  static constexpr int kMaxExponent = 23;
+  static constexpr std::uint64_t kMaxTrackedUs = (std::uint64_t{1} << (kMaxExponent + 1)) - 1;
+  static constexpr std::size_t kBucketCount =
+      static_cast<std::size_t>(kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(std::chrono::microseconds value);
+  LatencySummary Summarize() const;
+  void Reset();
+
+  // Smallest value whose bucket holds at least |quantile| of the records,
+  // reported as the bucket's upper bound (capped at the maximum); 0 when
+  // empty.
+  std::uint64_t ValueAtQuantile(double quantile) const;
+
+  std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  static std::size_t BucketIndex(std::uint64_t value_us);
+  // Highest value that maps to |index|.
+  static std::uint64_t BucketUpperBound(std::size_t index);
+
+ private:
+  std::atomic<std::uint32_t> buckets_[kBucketCount] = {};
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::uint64_t> sum_us_{0};
+  std::atomic<std::uint64_t> max_us_{0};
+};
+
+// Where the time of one adapter command goes.
+enum class LatencyPhase : std::uint8_t {
+  // Command written to first response byte: adapter and ECU time.
+  kFirstByte,
+  // First response byte to the '>' prompt: the rest of the reply, including
+  // the adapter's wait for more ECUs.
+  kPrompt,
+  // Command written to the prompt.
+  kRoundTrip,
+  // Prompt to the result being handed to Dart on the platform thread.
+  kDelivery,
+};
+constexpr std::size_t kLatencyPhaseCount = 4;
+
+const char* LatencyPhaseName(LatencyPhase phase);
+
+enum class LinkCounter : std::uint8_t {
+  kBytesReceived,
+  kBytesSent,
+  // Responses framed at the '>' prompt.
+  kResponses,
+  kTimeouts,
+  kWriteFailures,
+  // Receive ring overflows and the bytes they dropped.
+  kOverflows,
+  kDroppedBytes,
+};
+constexpr std::size_t kLinkCounterCount = 7;
+
+const char* LinkCounterName(LinkCounter counter);
+
+// Histograms and outcome counts of one command.
+struct CommandStats {
+  void Record(LatencyPhase phase, std::chrono::microseconds value) {
+    phases[static_cast<std::size_t>(phase)].Record(value);
+  }
+
+  LatencyHistogram phases[kLatencyPhaseCount];
+  std::atomic<std::uint64_t> completed{0};
+  std::atomic<std::uint64_t> timeouts{0};
+};
+
+struct CommandLatency {
+  std::string command;
+  std::uint64_t completed = 0;
+  std::uint64_t timeouts = 0;
+  LatencySummary phases[kLatencyPhaseCount];
+};
+
+// Latency histograms per command and phase plus the counters of one
+// adapter link, cheap enough to leave on.
+//
+// Recording is one relaxed atomic add per counter and a few per histogram;
+// looking a command up takes a mutex that only Snapshot() and the first
+// sighting of a command contend on. Commands beyond kMaxCommands share the
+// kOtherCommand entry, so a DID scan cannot grow the table without bound.
+class LinkStats {
+ public:
+  static constexpr std::size_t kMaxCommands = 128;
+  static constexpr const char* kOtherCommand = "*";
+
+  LinkStats() = default;
+  LinkStats(const LinkStats&) = delete;
+  LinkStats& operator=(const LinkStats&) = delete;
+
+  // The entry of |command|, created on first use. Stays valid for the
+  // lifetime of the LinkStats; Reset() only zeroes it.
+  CommandStats* ForCommand(const std::string& command);
+
+  void Add(LinkCounter counter, std::uint64_t amount = 1) {
+    counters_[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+  }
+  std::uint64_t counter(LinkCounter counter) const {
+    return counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+  }
+
+  // Every command seen since creation, in command order.
+  std::vector<CommandLatency> Snapshot() const;
+
+  // Starts a new measurement window.
+  void Reset();
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<CommandStats>> commands_;
+  std::atomic<std::uint64_t> counters_[kLinkCounterCount] = {};
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_LATENCY_STATS_H_
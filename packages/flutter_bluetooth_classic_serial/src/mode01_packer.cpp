@@ -0,0 +1,209 @@
+#include "mode01_packer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#include "elm327_reply.h"
+#include "hex_decode.h"
+#include "pid_decoder.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Reply length of a Mode 01 PID, 0 if the table does not know it.
+std::size_t ReplyBytes(std::uint8_t pid) {
+  const PidDescriptor* descriptor = FindPid(0x01, pid);
+  return descriptor ? static_cast<std::size_t>(descriptor->response_bytes) : 0;
+}
+
+bool Requested(const std::vector<std::uint8_t>& pids, std::uint8_t pid) {
+  for (std::uint8_t requested : pids) {
+    if (requested == pid) return true;
+  }
+  return false;
+}
+
+// The PID of a single-PID Mode 01 command ("010C") the packer can split.
+bool PackablePid(const std::string& command, std::uint8_t* pid) {
+  if (command.size() != 4 || command[0] != '0' || command[1] != '1') return false;
+  if (DecodeHex(command.data() + 2, 2, pid) != 1) return false;
+  return ReplyBytes(*pid) > 0;
+}
+
+std::string FormatCommand(const std::vector<std::uint8_t>& pids) {
+  std::string command = "01";
+  char byte[4];
+  for (std::uint8_t pid : pids) {
+    std::snprintf(byte, sizeof(byte), "%02X", pid);
+    command += byte;
+  }
+  return command;
+}
+
+// A single-PID reply line the app's parser reads like the adapter's own.
+std::string FormatReply(const Mode01PidData& data) {
+  std::string line = "41";
+  char byte[4];
+  std::snprintf(byte, sizeof(byte), "%02X", data.pid);
+  line += byte;
+  for (std::uint8_t value : data.bytes) {
+    std::snprintf(byte, sizeof(byte), "%02X", value);
+    line += byte;
+  }
+  return line;
+}
+
+}  // namespace
+
+bool SplitMode01Reply(const std::vector<std::string>& lines,
+                      const std::vector<std::uint8_t>& pids, Mode01Reply* reply) {
+  reply->ecus.clear();
+  reply->ids.clear();
+  reply->negative = false;
+  bool any = false;
+
+  for (const auto& message : AssembleElmReply(lines)) {
+    const auto& bytes = message.bytes;
+    if (bytes.size() >= 2 && bytes[0] == 0x7F && bytes[1] == 0x01) {
+      reply->negative = true;
+      continue;
+    }
+    if (bytes.empty() || bytes[0] != 0x41) continue;
+
+    std::vector<Mode01PidData> ecu;
+    std::size_t offset = 1;
+    while (offset < bytes.size()) {
+      const std::uint8_t pid = bytes[offset];
+      const std::size_t length = ReplyBytes(pid);
+      if (!Requested(pids, pid) || length == 0 || offset + 1 + length > bytes.size()) break;
+      const auto first = bytes.begin() + static_cast<std::ptrdiff_t>(offset) + 1;
+      ecu.push_back(
+          {pid, std::vector<std::uint8_t>(first, first + static_cast<std::ptrdiff_t>(length))});
+      offset += 1 + length;
+    }
+    if (ecu.empty()) continue;
+    any = true;
+    reply->ecus.push_back(std::move(ecu));
+    reply->ids.push_back(message.id);
+  }
+  return any;
+}
+
+std::vector<PollEntry> Mode01Packer::Pack(std::vector<PollEntry> entries, bool pack) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_ = std::move(entries);
+  pack_ = pack;
+  return PackLocked();
+}
+
+std::vector<PollEntry> Mode01Packer::Repack() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return PackLocked();
+}
+
+std::vector<PollEntry> Mode01Packer::PackLocked() {
+  groups_.clear();
+  if (!pack_) return entries_;
+
+  struct Bucket {
+    std::chrono::milliseconds period;
+    std::vector<std::uint8_t> pids;
+    std::vector<std::string> commands;
+  };
+  std::vector<PollEntry> schedule;
+  std::vector<Bucket> buckets;
+  std::set<std::uint8_t> seen;
+  for (const auto& entry : entries_) {
+    std::uint8_t pid = 0;
+    if (!PackablePid(entry.command, &pid) || rejected_.count(pid) > 0 || !seen.insert(pid).second) {
+      schedule.push_back(entry);
+      continue;
+    }
+    Bucket* bucket = nullptr;
+    for (auto& candidate : buckets) {
+      if (candidate.period == entry.period) bucket = &candidate;
+    }
+    if (!bucket) {
+      buckets.push_back({entry.period, {}, {}});
+      bucket = &buckets.back();
+    }
+    bucket->pids.push_back(pid);
+    bucket->commands.push_back(entry.command);
+  }
+
+  for (const auto& bucket : buckets) {
+    for (std::size_t first = 0; first < bucket.pids.size(); first += kMaxMode01PidsPerRequest) {
+      const std::size_t last = std::min(first + kMaxMode01PidsPerRequest, bucket.pids.size());
+      if (last - first == 1) {
+        schedule.push_back({bucket.commands[first], bucket.period});
+        continue;
+      }
+      Group group;
+      group.pids.assign(bucket.pids.begin() + first, bucket.pids.begin() + last);
+      group.commands.assign(bucket.commands.begin() + first, bucket.commands.begin() + last);
+      std::string command = FormatCommand(group.pids);
+      schedule.push_back({command, bucket.period});
+      groups_[command] = std::move(group);
+    }
+  }
+  return schedule;
+}
+
+Mode01Packer::SplitOutcome Mode01Packer::Split(CommandResult&& sample,
+                                               std::vector<CommandResult>* samples) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = groups_.find(sample.command);
+  if (it == groups_.end()) return SplitOutcome::kPassThrough;
+  const Group& group = it->second;
+
+  Mode01Reply reply;
+  const bool answered = sample.status == CommandResult::Status::kOk &&
+                        SplitMode01Reply(sample.lines, group.pids, &reply);
+  if (sample.status == CommandResult::Status::kOk && !answered && reply.negative) {
+    rejected_.insert(group.pids.begin(), group.pids.end());
+    groups_.erase(it);
+    return SplitOutcome::kRejected;
+  }
+
+  for (std::size_t i = 0; i < group.pids.size(); ++i) {
+    CommandResult result;
+    result.command = group.commands[i];
+    result.status = sample.status;
+    result.elapsed = sample.elapsed;
+    result.completed_at = sample.completed_at;
+    if (sample.status == CommandResult::Status::kOk && !answered) {
+      // NO DATA, CAN ERROR, BUFFER FULL...: what a single request would
+      // have got, not a reason to unpack the group
+      result.lines = sample.lines;
+    } else if (sample.status == CommandResult::Status::kOk) {
+      // One line per ECU, so multi-ECU PIDs stay visible to the app
+      for (const auto& ecu : reply.ecus) {
+        for (const auto& data : ecu) {
+          if (data.pid == group.pids[i]) result.lines.push_back(FormatReply(data));
+        }
+      }
+      if (result.lines.empty()) result.lines.push_back("NO DATA");
+    }
+    samples->push_back(std::move(result));
+  }
+  return SplitOutcome::kSplit;
+}
+
+void Mode01Packer::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  pack_ = false;
+  groups_.clear();
+  rejected_.clear();
+}
+
+std::vector<std::uint8_t> Mode01Packer::PidsOf(const std::string& command) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = groups_.find(command);
+  return it == groups_.end() ? std::vector<std::uint8_t>() : it->second.pids;
+}
+
+}  // namespace flutter_bluetooth_classic
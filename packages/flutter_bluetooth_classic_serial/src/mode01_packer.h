@@ -0,0 +1,108 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_MODE01_PACKER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_MODE01_PACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "poll_scheduler.h"
+
+namespace flutter_bluetooth_classic {
+
+// Most Mode 01 PIDs ISO 15765-4 lets one request carry.
+constexpr std::size_t kMaxMode01PidsPerRequest = 6;
+
+// One ECU's data for one PID of a Mode 01 reply.
+struct Mode01PidData {
+  std::uint8_t pid = 0;
+  std::vector<std::uint8_t> bytes;
+};
+
+struct Mode01Reply {
+  // Per ECU that answered positively, the requested PIDs it returned, in
+  // reply order.
+  std::vector<std::vector<Mode01PidData>> ecus;
+  // The CAN ID of each entry of |ecus|; empty without headers.
+  std::vector<std::string> ids;
+  // Some ECU answered 7F 01.
+  bool negative = false;
+};
+
+// Splits the reply to a Mode 01 request for |pids| (one or more) into the
+// data of each PID.
+//
+// |lines| are the adapter's lines with or without headers (11- or 29-bit)
+// and spaces; ISO-TP first/consecutive frames and the headerless "0:"
+// segments are reassembled per ECU. Each positive message is walked as
+// 41 pid data pid data..., using the response_bytes of the PID table;
+// the walk stops at a PID that was not requested, has no table entry or
+// is cut short. Returns true if any ECU returned data for a requested PID.
+bool SplitMode01Reply(const std::vector<std::string>& lines,
+                      const std::vector<std::uint8_t>& pids, Mode01Reply* reply);
+
+// Packs the single-PID Mode 01 entries of a poll schedule into multi-PID
+// requests and splits their samples back into one sample per PID, so
+// whoever consumes the samples sees the commands it scheduled.
+//
+// Entries with the same period are packed in schedule order, up to
+// kMaxMode01PidsPerRequest per request; only PIDs whose reply length the
+// PID table knows are packed, everything else is scheduled as given. If
+// an ECU rejects a packed request (a negative reply or no data for any of
+// its PIDs), its PIDs are polled one per request from then on.
+//
+// Pack() and Repack() run on the platform thread, Split() on the link's
+// receive thread.
+class Mode01Packer {
+ public:
+  enum class SplitOutcome {
+    // |sample| was not a packed request and is passed through.
+    kPassThrough,
+    // One sample per PID, in request order. PIDs no ECU answered get a
+    // "NO DATA" line, like a single request would; a reply with no data
+    // at all (NO DATA, CAN ERROR, ...) is given to every PID as it is.
+    kSplit,
+    // The ECU rejected the request with 7F 01 and nothing answered it; no
+    // samples. Repack() now schedules its PIDs one per request.
+    kRejected,
+  };
+
+  // Returns the schedule to run for |entries|; with |pack| false that is
+  // |entries| unchanged.
+  std::vector<PollEntry> Pack(std::vector<PollEntry> entries, bool pack = true);
+
+  // The last Pack() input packed again, without the rejected requests.
+  std::vector<PollEntry> Repack();
+
+  SplitOutcome Split(CommandResult&& sample, std::vector<CommandResult>* samples);
+
+  // Forgets the schedule and the rejected PIDs, e.g. for a new connection.
+  void Reset();
+
+  // The PIDs of a packed command, empty if |command| is not one.
+  std::vector<std::uint8_t> PidsOf(const std::string& command) const;
+
+ private:
+  struct Group {
+    std::vector<std::uint8_t> pids;
+    // The scheduled single-PID command of each PID.
+    std::vector<std::string> commands;
+  };
+
+  std::vector<PollEntry> PackLocked();
+
+  mutable std::mutex mutex_;
+  std::vector<PollEntry> entries_;
+  bool pack_ = false;
+  // Packed command to its PIDs
+  std::map<std::string, Group> groups_;
+  std::set<std::uint8_t> rejected_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_MODE01_PACKER_H_
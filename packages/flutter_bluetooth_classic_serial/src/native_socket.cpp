@@ -0,0 +1,182 @@
+#include "native_socket.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+int PendingSocketError(NativeSocket socket) {
+  int error = 0;
+#ifdef _WIN32
+  int size = sizeof(error);
+  if (getsockopt(static_cast<SOCKET>(socket), SOL_SOCKET, SO_ERROR,
+                 reinterpret_cast<char*>(&error), &size) != 0) {
+    return WSAGetLastError();
+  }
+#else
+  socklen_t size = sizeof(error);
+  if (getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &size) != 0) return errno;
+#endif
+  return error;
+}
+
+}  // namespace
+
+int LastSocketError() {
+#ifdef _WIN32
+  return WSAGetLastError();
+#else
+  return errno;
+#endif
+}
+
+bool IsWouldBlockError(int error) {
+#ifdef _WIN32
+  return error == WSAEWOULDBLOCK;
+#else
+  return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+}
+
+bool SetNonBlocking(NativeSocket socket, bool non_blocking) {
+#ifdef _WIN32
+  u_long mode = non_blocking ? 1 : 0;
+  return ioctlsocket(static_cast<SOCKET>(socket), FIONBIO, &mode) == 0;
+#else
+  int flags = fcntl(socket, F_GETFL, 0);
+  if (flags < 0) return false;
+  flags = non_blocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+  return fcntl(socket, F_SETFL, flags) == 0;
+#endif
+}
+
+void CloseNativeSocket(NativeSocket socket) {
+  if (socket == kInvalidSocket) return;
+#ifdef _WIN32
+  closesocket(static_cast<SOCKET>(socket));
+#else
+  close(socket);
+#endif
+}
+
+int ReceiveSome(NativeSocket socket, std::uint8_t* buffer, std::size_t length) {
+#ifdef _WIN32
+  return recv(static_cast<SOCKET>(socket), reinterpret_cast<char*>(buffer),
+              static_cast<int>(length), 0);
+#else
+  return static_cast<int>(recv(socket, buffer, length, 0));
+#endif
+}
+
+int SendSome(NativeSocket socket, const std::uint8_t* data, std::size_t length) {
+#ifdef _WIN32
+  return send(static_cast<SOCKET>(socket), reinterpret_cast<const char*>(data),
+              static_cast<int>(length), 0);
+#else
+#ifdef MSG_NOSIGNAL
+  return static_cast<int>(send(socket, data, length, MSG_NOSIGNAL));
+#else
+  return static_cast<int>(send(socket, data, length, 0));
+#endif
+#endif
+}
+
+int SendGather(NativeSocket socket, const SendBuffer* buffers, std::size_t count) {
+  if (count > kMaxSendBuffers) count = kMaxSendBuffers;
+#ifdef _WIN32
+  WSABUF wsa_buffers[kMaxSendBuffers];
+  for (std::size_t i = 0; i < count; ++i) {
+    wsa_buffers[i].buf = reinterpret_cast<CHAR*>(const_cast<std::uint8_t*>(buffers[i].data));
+    wsa_buffers[i].len = static_cast<ULONG>(buffers[i].length);
+  }
+  DWORD sent = 0;
+  if (WSASend(static_cast<SOCKET>(socket), wsa_buffers, static_cast<DWORD>(count), &sent,
+              0, nullptr, nullptr) != 0) {
+    return -1;
+  }
+  return static_cast<int>(sent);
+#else
+  // sendmsg() rather than writev() so a closed peer is an EPIPE, not a
+  // SIGPIPE.
+  iovec iov[kMaxSendBuffers];
+  for (std::size_t i = 0; i < count; ++i) {
+    iov[i].iov_base = const_cast<std::uint8_t*>(buffers[i].data);
+    iov[i].iov_len = buffers[i].length;
+  }
+  msghdr message = {};
+  message.msg_iov = iov;
+  message.msg_iovlen = count;
+#ifdef MSG_NOSIGNAL
+  return static_cast<int>(sendmsg(socket, &message, MSG_NOSIGNAL));
+#else
+  return static_cast<int>(sendmsg(socket, &message, 0));
+#endif
+#endif
+}
+
+int WaitForConnect(const NativeSocket* sockets, int* results, std::size_t count, int timeout_ms) {
+  if (count == 0) return 0;
+#ifdef _WIN32
+  // select() rather than WSAPoll: older WSAPoll never reports a failed
+  // connect. Writable = connected, except = failed.
+  if (count > FD_SETSIZE) return -1;
+  fd_set writable;
+  fd_set failed;
+  FD_ZERO(&writable);
+  FD_ZERO(&failed);
+  for (std::size_t i = 0; i < count; ++i) {
+    FD_SET(static_cast<SOCKET>(sockets[i]), &writable);
+    FD_SET(static_cast<SOCKET>(sockets[i]), &failed);
+  }
+  timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+  if (select(0, nullptr, &writable, &failed, timeout_ms < 0 ? nullptr : &timeout) < 0) return -1;
+
+  int finished = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto socket = static_cast<SOCKET>(sockets[i]);
+    if (FD_ISSET(socket, &failed)) {
+      const int error = PendingSocketError(sockets[i]);
+      results[i] = error != 0 ? error : WSAECONNREFUSED;
+    } else if (FD_ISSET(socket, &writable)) {
+      results[i] = 0;
+    } else {
+      continue;
+    }
+    ++finished;
+  }
+  return finished;
+#else
+  std::vector<pollfd> fds(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    fds[i].fd = sockets[i];
+    fds[i].events = POLLOUT;
+  }
+  if (poll(fds.data(), static_cast<nfds_t>(count), timeout_ms) < 0) return -1;
+
+  int finished = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (fds[i].revents == 0) continue;
+    // A failed connect is writable too; SO_ERROR tells them apart.
+    results[i] = PendingSocketError(sockets[i]);
+    ++finished;
+  }
+  return finished;
+#endif
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,58 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_NATIVE_SOCKET_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_NATIVE_SOCKET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_bluetooth_classic {
+
+// Platform socket handle. On Windows this has the same representation as
+// SOCKET (UINT_PTR) so winsock headers do not leak into every includer.
+#ifdef _WIN32
+using NativeSocket = std::uintptr_t;
+constexpr NativeSocket kInvalidSocket = ~static_cast<NativeSocket>(0);
+#else
+using NativeSocket = int;
+constexpr NativeSocket kInvalidSocket = -1;
+#endif
+
+// Last socket error for the calling thread (WSAGetLastError / errno).
+int LastSocketError();
+
+// True if |error| means the operation would block on a non-blocking socket.
+bool IsWouldBlockError(int error);
+
+// Switches |socket| between blocking and non-blocking mode.
+bool SetNonBlocking(NativeSocket socket, bool non_blocking);
+
+void CloseNativeSocket(NativeSocket socket);
+
+// recv()/send() with the platform signature differences smoothed over.
+// Same return convention: bytes transferred, 0 on orderly close, -1 on error.
+int ReceiveSome(NativeSocket socket, std::uint8_t* buffer, std::size_t length);
+int SendSome(NativeSocket socket, const std::uint8_t* data, std::size_t length);
+
+// One buffer of a gather send.
+struct SendBuffer {
+  const std::uint8_t* data;
+  std::size_t length;
+};
+
+constexpr std::size_t kMaxSendBuffers = 16;
+
+// Sends up to kMaxSendBuffers buffers with one sendmsg()/WSASend() call, in
+// order. Same return convention as SendSome(); may send only part of them.
+int SendGather(NativeSocket socket, const SendBuffer* buffers, std::size_t count);
+
+// Result slot value for a connect that has not finished yet.
+constexpr int kConnectPending = -1;
+
+// Waits up to |timeout_ms| for non-blocking connects on |sockets| to finish.
+// For each socket that finished, sets results[i] to 0 (connected) or the
+// socket error; the rest keep kConnectPending. Returns the number that
+// finished, or -1 on error.
+int WaitForConnect(const NativeSocket* sockets, int* results, std::size_t count, int timeout_ms);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_NATIVE_SOCKET_H_
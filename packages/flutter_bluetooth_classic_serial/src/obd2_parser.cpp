@@ -0,0 +1,165 @@
+#include "obd2_parser.h"
+
+#include <cstring>
+
+#include "hex_decode.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Same list, same order as Obd2Parser._errorPatterns.
+constexpr const char* kErrorPatterns[] = {
+    "NO DATA",  "UNABLE TO CONNECT", "BUS INIT",  "BUS ERROR", "CAN ERROR",
+    "FB ERROR", "DATA ERROR",        "BUFFER FULL", "ACT ALERT", "LV RESET",
+    "STOPPED",  "ERROR",             "?",
+};
+
+// Lines searched one by one. Lines past this still take part in the joined
+// search; no adapter response comes close.
+constexpr std::size_t kMaxLines = 64;
+
+constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+struct Line {
+  std::size_t begin;
+  std::size_t end;
+};
+
+// Dart String.trim() whitespace, ASCII subset.
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool IsUpperHex(char c) { return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F'); }
+
+std::size_t Find(const char* text, std::size_t length, const char* needle,
+                 std::size_t needle_length) {
+  if (needle_length == 0 || needle_length > length) return kNotFound;
+  const char* end = text + length - needle_length + 1;
+  for (const char* p = text; p < end; ++p) {
+    p = static_cast<const char*>(std::memchr(p, needle[0], static_cast<std::size_t>(end - p)));
+    if (!p) return kNotFound;
+    if (std::memcmp(p, needle, needle_length) == 0) return static_cast<std::size_t>(p - text);
+  }
+  return kNotFound;
+}
+
+bool IsErrorLine(const char* line, std::size_t length) {
+  for (const char* pattern : kErrorPatterns) {
+    if (Find(line, length, pattern, std::strlen(pattern)) != kNotFound) return true;
+  }
+  return false;
+}
+
+// Obd2Parser._isNegativeResponseLine on a line without spaces: has 7F and
+// no positive response header 4[1-9A-F][0-9A-F]{2}.
+bool IsNegativeLine(const char* hex, std::size_t length) {
+  if (Find(hex, length, "7F", 2) == kNotFound) return false;
+  for (std::size_t i = 0; i + 4 <= length; ++i) {
+    if (hex[i] == '4' && IsUpperHex(hex[i + 1]) && hex[i + 1] != '0' && IsUpperHex(hex[i + 2]) &&
+        IsUpperHex(hex[i + 3])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Upper-case hex of |value|, at least |digits| wide. Returns the length.
+std::size_t FormatHex(unsigned value, std::size_t digits, char* out) {
+  char reversed[8];
+  std::size_t count = 0;
+  do {
+    reversed[count++] = "0123456789ABCDEF"[value & 0xF];
+    value >>= 4;
+  } while (value != 0 && count < sizeof(reversed));
+  while (count < digits) reversed[count++] = '0';
+  for (std::size_t i = 0; i < count; ++i) out[i] = reversed[count - 1 - i];
+  return count;
+}
+
+int DecodeData(const char* hex, std::size_t length, std::uint8_t* out, std::size_t capacity) {
+  std::size_t pairs = length / 2;
+  if (pairs == 0 || pairs > capacity) return -1;
+  std::size_t decoded = DecodeHex(hex, length, out);
+  return decoded == kInvalidHex ? -1 : static_cast<int>(decoded);
+}
+
+int Parse(char* text, std::size_t length, const char* header, std::size_t header_length,
+          std::uint8_t* out, std::size_t capacity) {
+  // Line breaks and prompts out, upper case in
+  std::size_t size = 0;
+  for (std::size_t i = 0; i < length; ++i) {
+    char c = text[i];
+    if (c == '>') continue;
+    if (c == '\r') c = '\n';
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - ('a' - 'A'));
+    text[size++] = c;
+  }
+
+  // Compact the kept lines to the front without spaces. Joined, they are
+  // the multi-frame search text.
+  Line lines[kMaxLines];
+  std::size_t line_count = 0;
+  std::size_t kept_lines = 0;
+  std::size_t joined = 0;
+  std::size_t pos = 0;
+  while (pos < size) {
+    const char* newline = static_cast<const char*>(std::memchr(text + pos, '\n', size - pos));
+    std::size_t line_end = newline ? static_cast<std::size_t>(newline - text) : size;
+    std::size_t begin = pos;
+    std::size_t end = line_end;
+    pos = line_end + 1;
+
+    while (begin < end && IsSpace(text[begin])) ++begin;
+    while (end > begin && IsSpace(text[end - 1])) --end;
+    if (begin == end) continue;
+    if (IsErrorLine(text + begin, end - begin)) return -1;
+
+    std::size_t start = joined;
+    for (std::size_t i = begin; i < end; ++i) {
+      if (text[i] != ' ') text[joined++] = text[i];
+    }
+    if (IsNegativeLine(text + start, joined - start)) {
+      joined = start;
+      continue;
+    }
+    ++kept_lines;
+    if (line_count < kMaxLines) lines[line_count++] = {start, joined};
+  }
+  if (kept_lines == 0) return -1;
+
+  for (std::size_t i = 0; i < line_count; ++i) {
+    const Line& line = lines[i];
+    std::size_t index = Find(text + line.begin, line.end - line.begin, header, header_length);
+    if (index == kNotFound) continue;
+    std::size_t data = line.begin + index + header_length;
+    int result = DecodeData(text + data, line.end - data, out, capacity);
+    if (result >= 0) return result;
+  }
+
+  if (kept_lines < 2) return -1;
+  std::size_t index = Find(text, joined, header, header_length);
+  if (index == kNotFound) return -1;
+  std::size_t data = index + header_length;
+  return DecodeData(text + data, joined - data, out, capacity);
+}
+
+}  // namespace
+
+int ParseObd2Response(char* response, std::size_t length, int pid, std::uint8_t* out,
+                      std::size_t capacity, int mode) {
+  char header[16];
+  std::size_t header_length = FormatHex(static_cast<unsigned>(mode + 0x40), 2, header);
+  header_length += FormatHex(static_cast<unsigned>(pid), 2, header + header_length);
+  return Parse(response, length, header, header_length, out, capacity);
+}
+
+int ParseMode22Response(char* response, std::size_t length, int data_id, std::uint8_t* out,
+                        std::size_t capacity) {
+  char header[16] = {'6', '2'};
+  std::size_t header_length = 2 + FormatHex(static_cast<unsigned>(data_id), 4, header + 2);
+  return Parse(response, length, header, header_length, out, capacity);
+}
+
+}  // namespace flutter_bluetooth_classic
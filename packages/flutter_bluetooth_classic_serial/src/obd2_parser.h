@@ -0,0 +1,37 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_OBD2_PARSER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_OBD2_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_bluetooth_classic {
+
+// Native counterpart of Obd2Parser in lib/services/obd2_parser.dart, with
+// the same results (see obd2_parser_test.cpp for the golden cases).
+//
+// |response| is the adapter text for one command, lines separated by CR or
+// LF, with or without the '>' prompt. It is normalised in place (upper
+// case, prompt and spaces removed, rejected lines dropped), so its contents
+// are unspecified afterwards; nothing is allocated.
+//
+// A response is rejected if any line holds an adapter error (NO DATA,
+// UNABLE TO CONNECT, ..., '?'). Lines that are negative responses (7F
+// without a positive 4xxx header) from other ECUs are skipped. Each
+// remaining line is searched for the expected header; failing that, the
+// lines are searched joined together, for responses split over several
+// frames.
+//
+// Both return the number of data bytes after the header written to |out|,
+// or -1 if there is no valid data or it does not fit in |capacity|.
+
+// Mode 01-style response to |pid|: header is (|mode| + 0x40, |pid|).
+int ParseObd2Response(char* response, std::size_t length, int pid, std::uint8_t* out,
+                      std::size_t capacity, int mode = 0x01);
+
+// Mode 22 response to |data_id|: header is (0x62, high byte, low byte).
+int ParseMode22Response(char* response, std::size_t length, int data_id, std::uint8_t* out,
+                        std::size_t capacity);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_OBD2_PARSER_H_
@@ -0,0 +1,32 @@
+#include "pid_decoder.h"
+
+#include "obd2_parser.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Longer than any single-frame PID; longer responses fail to parse.
+constexpr std::size_t kMaxDataBytes = 64;
+
+}  // namespace
+
+bool DecodePid(const PidDescriptor& pid, const std::uint8_t* bytes, std::size_t length,
+               double* value) {
+  const auto needed = static_cast<std::size_t>(pid.response_bytes);
+  if (length < needed) return false;
+  return pid.decode(bytes, needed, pid.formula, value);
+}
+
+bool ParsePidResponse(const PidDescriptor& pid, char* response, std::size_t length,
+                      double* value) {
+  std::uint8_t bytes[kMaxDataBytes];
+  const int count = pid.protocol == PidProtocol::kMode22
+                        ? ParseMode22Response(response, length, pid.code, bytes, sizeof(bytes))
+                        : ParseObd2Response(response, length, pid.code, bytes, sizeof(bytes),
+                                            pid.mode);
+  if (count < 0) return false;
+  return DecodePid(pid, bytes, static_cast<std::size_t>(count), value);
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,33 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_PID_DECODER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_PID_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pid_kernels.h"
+#include "pid_table.h"
+
+namespace flutter_bluetooth_classic {
+
+// Looks up a PID in the generated table; nullptr if it is not configured.
+constexpr const PidDescriptor* FindPid(int mode, int code) {
+  for (const auto& pid : kPidTable) {
+    if (pid.mode == mode && pid.code == code) return &pid;
+  }
+  return nullptr;
+}
+
+// Decodes the data bytes of a response to |pid| the way ObdService does:
+// fails if fewer than pid.response_bytes arrived, otherwise applies the
+// kernel to the first response_bytes.
+bool DecodePid(const PidDescriptor& pid, const std::uint8_t* bytes, std::size_t length,
+               double* value);
+
+// ParseObd2Response / ParseMode22Response followed by DecodePid. Modifies
+// |response| in place like the parsers do.
+bool ParsePidResponse(const PidDescriptor& pid, char* response, std::size_t length,
+                      double* value);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_PID_DECODER_H_
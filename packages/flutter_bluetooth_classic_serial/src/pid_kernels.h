@@ -0,0 +1,91 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_PID_KERNELS_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_PID_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flutter_bluetooth_classic {
+
+// Mirrors PollTier and PidProtocol in lib/config/pid_config.dart.
+enum class PollTier { kFast, kMedium, kSlow, kBackground };
+enum class PidProtocol { kObd2, kMode22 };
+
+// Constants of a formula kernel. Kernels evaluate in the same order as the
+// Dart parsers (raw * scale / divisor + offset), so results are identical
+// to the last bit rather than merely close.
+struct PidFormula {
+  double scale = 1;
+  double divisor = 1;
+  double offset = 0;
+  // The Dart parser returns 0 instead of failing when the data is too short
+  // for its raw value (a `b.length >= n ? ... : 0` guard).
+  bool zero_when_short = false;
+};
+
+// Decodes data bytes (after the response header) to engineering units.
+// Returns false if |length| is too short for the raw value.
+using PidKernel = bool (*)(const std::uint8_t* bytes, std::size_t length,
+                           const PidFormula& formula, double* value);
+
+// === Raw value extractors ===
+
+template <std::size_t kIndex>
+struct Uint8At {
+  static constexpr std::size_t kEnd = kIndex + 1;
+  static double Read(const std::uint8_t* bytes) { return bytes[kIndex]; }
+};
+
+template <std::size_t kIndex>
+struct Uint16BigEndianAt {
+  static constexpr std::size_t kEnd = kIndex + 2;
+  static double Read(const std::uint8_t* bytes) {
+    return bytes[kIndex] * 256 + bytes[kIndex + 1];
+  }
+};
+
+// === Conversions ===
+
+struct Linear {
+  static double Apply(double raw, const PidFormula& f) { return raw * f.scale / f.divisor + f.offset; }
+};
+
+// Unsigned byte re-centred on a bias, e.g. torque percent (A - 125).
+struct SignedOffset {
+  static double Apply(double raw, const PidFormula& f) { return raw + f.offset; }
+};
+
+// Linear value in degrees C, reported in degrees F.
+struct CelsiusToFahrenheit {
+  static double Apply(double raw, const PidFormula& f) {
+    return (raw * f.scale / f.divisor + f.offset) * 9 / 5 + 32;
+  }
+};
+
+template <typename Raw, typename Conversion>
+bool DecodeKernel(const std::uint8_t* bytes, std::size_t length, const PidFormula& formula,
+                  double* value) {
+  if (length < Raw::kEnd) {
+    if (!formula.zero_when_short) return false;
+    *value = 0;
+    return true;
+  }
+  *value = Conversion::Apply(Raw::Read(bytes), formula);
+  return true;
+}
+
+struct PidDescriptor {
+  const char* id;
+  // Name of the Dart parser function the kernel was generated from.
+  const char* parser;
+  PidProtocol protocol;
+  int code;
+  int mode;
+  int response_bytes;
+  PollTier tier;
+  PidFormula formula;
+  PidKernel decode;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_PID_KERNELS_H_
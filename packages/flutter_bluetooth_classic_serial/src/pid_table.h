@@ -0,0 +1,128 @@
+// Generated by scripts/gen_pid_table.js from lib/config/pid_config.dart.
+// Do not edit; change the Dart config and rerun the generator.
+
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
+
+#include "pid_kernels.h"
+
+namespace flutter_bluetooth_classic {
+
+inline constexpr PidDescriptor kPidTable[] = {
+    {"engineLoadObd2", "_parsePercent", PidProtocol::kObd2,
+     0x04, 0x01, 1, PollTier::kFast,
+     {100, 255, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"coolantTemp", "_parseTemp", PidProtocol::kObd2,
+     0x05, 0x01, 1, PollTier::kFast,
+     {1, 1, -40, false},
+     &DecodeKernel<Uint8At<0>, CelsiusToFahrenheit>},
+    {"rpm", "_parseRpm", PidProtocol::kObd2,
+     0x0C, 0x01, 2, PollTier::kFast,
+     {1, 4, 0, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"speed", "_parseSingleByte", PidProtocol::kObd2,
+     0x0D, 0x01, 1, PollTier::kFast,
+     {1, 1, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"intakeTemp", "_parseTemp", PidProtocol::kObd2,
+     0x0F, 0x01, 1, PollTier::kSlow,
+     {1, 1, -40, false},
+     &DecodeKernel<Uint8At<0>, CelsiusToFahrenheit>},
+    {"maf", "_parseMaf", PidProtocol::kObd2,
+     0x10, 0x01, 2, PollTier::kMedium,
+     {1, 100, 0, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"runTime", "_parseRuntime", PidProtocol::kObd2,
+     0x1F, 0x01, 2, PollTier::kBackground,
+     {1, 1, 0, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"fuelLevel", "_parsePercent", PidProtocol::kObd2,
+     0x2F, 0x01, 1, PollTier::kBackground,
+     {100, 255, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"barometric", "_parseBarometric", PidProtocol::kObd2,
+     0x33, 0x01, 1, PollTier::kBackground,
+     {1, 1, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"batteryVoltage", "_parseVoltage", PidProtocol::kObd2,
+     0x42, 0x01, 2, PollTier::kBackground,
+     {1, 1000, 0, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"ambientTemp", "_parseTemp", PidProtocol::kObd2,
+     0x46, 0x01, 1, PollTier::kBackground,
+     {1, 1, -40, false},
+     &DecodeKernel<Uint8At<0>, CelsiusToFahrenheit>},
+    {"intercoolerOutletTemp", "_parseIntercoolerOutletTemp", PidProtocol::kObd2,
+     0x6B, 0x01, 3, PollTier::kSlow,
+     {1, 10, -40, true},
+     &DecodeKernel<Uint16BigEndianAt<1>, CelsiusToFahrenheit>},
+    {"railPressure", "_parseRailPressureActual", PidProtocol::kObd2,
+     0x6D, 0x01, 6, PollTier::kMedium,
+     {1.45, 1, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<3>, Linear>},
+    {"exhaustBackpressure", "_parseExhaustBackpressure", PidProtocol::kObd2,
+     0x73, 0x01, 2, PollTier::kSlow,
+     {0.01, 1, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"accelPedalD", "_parsePercent", PidProtocol::kObd2,
+     0x49, 0x01, 1, PollTier::kFast,
+     {100, 255, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"demandTorque", "_parseTorquePercent", PidProtocol::kObd2,
+     0x61, 0x01, 1, PollTier::kMedium,
+     {1, 1, -125, false},
+     &DecodeKernel<Uint8At<0>, SignedOffset>},
+    {"actualTorque", "_parseTorquePercent", PidProtocol::kObd2,
+     0x62, 0x01, 1, PollTier::kMedium,
+     {1, 1, -125, false},
+     &DecodeKernel<Uint8At<0>, SignedOffset>},
+    {"referenceTorque", "_parseReferenceTorque", PidProtocol::kObd2,
+     0x63, 0x01, 2, PollTier::kBackground,
+     {1, 1, 0, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"commandedEgr", "_parsePercent", PidProtocol::kObd2,
+     0x69, 0x01, 2, PollTier::kMedium,
+     {100, 255, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"commandedThrottle", "_parsePercent", PidProtocol::kObd2,
+     0x6C, 0x01, 1, PollTier::kMedium,
+     {100, 255, 0, false},
+     &DecodeKernel<Uint8At<0>, Linear>},
+    {"boostPressureCtrl", "_parseBoostPressureCtrl", PidProtocol::kObd2,
+     0x70, 0x01, 4, PollTier::kMedium,
+     {0.0045324375, 1, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"vgtControlObd", "_parseVgtCtrlObd", PidProtocol::kObd2,
+     0x71, 0x01, 4, PollTier::kMedium,
+     {100, 65535, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"turboInletPressure", "_parseTurboInletPressure", PidProtocol::kObd2,
+     0x74, 0x01, 2, PollTier::kSlow,
+     {0.0045324375, 1, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+    {"turboInletTemp", "_parseTurboInletTemp", PidProtocol::kObd2,
+     0x75, 0x01, 2, PollTier::kSlow,
+     {1, 10, -40, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, CelsiusToFahrenheit>},
+    {"chargeAirTemp", "_parseTurboInletTemp", PidProtocol::kObd2,
+     0x77, 0x01, 2, PollTier::kSlow,
+     {1, 10, -40, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, CelsiusToFahrenheit>},
+    {"egtObd2", "_parseEgtObd2", PidProtocol::kObd2,
+     0x78, 0x01, 2, PollTier::kFast,
+     {1, 10, -40, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, CelsiusToFahrenheit>},
+    {"dpfTemp", "_parseDpfTemp", PidProtocol::kObd2,
+     0x7A, 0x01, 2, PollTier::kSlow,
+     {1, 10, -40, false},
+     &DecodeKernel<Uint16BigEndianAt<0>, CelsiusToFahrenheit>},
+    {"runtimeExtended", "_parseRuntimeExtended", PidProtocol::kObd2,
+     0x7F, 0x01, 2, PollTier::kBackground,
+     {1, 1, 0, true},
+     &DecodeKernel<Uint16BigEndianAt<0>, Linear>},
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
@@ -0,0 +1,111 @@
+#include "poll_scheduler.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Weight of the newest interval in the achieved-period average.
+constexpr int kSmoothingShift = 3;  // 1/8
+
+}  // namespace
+
+void PollScheduler::SetSchedule(std::vector<PollEntry> entries, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  slots_.clear();
+  slots_.reserve(entries.size());
+  for (auto& entry : entries) {
+    if (entry.period.count() <= 0) continue;
+    Slot slot;
+    slot.release = now;
+    slot.deadline = now + entry.period;
+    slot.stats.command = entry.command;
+    slot.stats.target_period = entry.period;
+    slot.entry = std::move(entry);
+    slots_.push_back(std::move(slot));
+  }
+  ++generation_;
+}
+
+bool PollScheduler::active() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !slots_.empty();
+}
+
+bool PollScheduler::Next(Clock::time_point now, std::string* command, Ticket* ticket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slot* best = nullptr;
+  for (auto& slot : slots_) {
+    if (slot.in_flight || slot.release > now) continue;
+    if (!best || slot.release + slot.entry.period < best->release + best->entry.period) {
+      best = &slot;
+    }
+  }
+  if (!best) return false;
+
+  best->in_flight = true;
+  best->deadline = best->release + best->entry.period;
+  // Next period starts when this one ends, or now if already past it
+  best->release = best->deadline > now ? best->deadline : now;
+
+  *command = best->entry.command;
+  ticket->generation = generation_;
+  ticket->index = static_cast<std::size_t>(best - slots_.data());
+  return true;
+}
+
+void PollScheduler::Complete(const Ticket& ticket, bool ok, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ticket.generation != generation_ || ticket.index >= slots_.size()) return;
+
+  Slot& slot = slots_[ticket.index];
+  slot.in_flight = false;
+  if (!ok) {
+    ++slot.stats.timeouts;
+    return;
+  }
+
+  if (now > slot.deadline) ++slot.stats.deadline_misses;
+  if (slot.stats.samples > 0) {
+    auto interval = std::chrono::duration_cast<std::chrono::microseconds>(now - slot.last_sample_at);
+    auto& average = slot.stats.achieved_period;
+    average = average.count() == 0 ? interval : average + (interval - average) / (1 << kSmoothingShift);
+  }
+  slot.last_sample_at = now;
+  ++slot.stats.samples;
+}
+
+int PollScheduler::MillisecondsUntilNextRelease(Clock::time_point now) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool found = false;
+  Clock::time_point next;
+  for (const auto& slot : slots_) {
+    if (slot.in_flight) continue;
+    if (!found || slot.release < next) next = slot.release;
+    found = true;
+  }
+  if (!found) return -1;
+  if (next <= now) return 0;
+  return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next - now).count());
+}
+
+std::vector<PollStats> PollScheduler::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<PollStats> stats;
+  stats.reserve(slots_.size());
+  for (const auto& slot : slots_) stats.push_back(slot.stats);
+  return stats;
+}
+
+void PollScheduler::ResetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& slot : slots_) {
+    PollStats fresh;
+    fresh.command = slot.stats.command;
+    fresh.target_period = slot.stats.target_period;
+    slot.stats = std::move(fresh);
+  }
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,89 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_POLL_SCHEDULER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_POLL_SCHEDULER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+struct PollEntry {
+  std::string command;
+  // Target sample period.
+  std::chrono::milliseconds period{1000};
+};
+
+struct PollStats {
+  std::string command;
+  std::chrono::milliseconds target_period{0};
+  // Smoothed interval between successful samples; 0 until two samples.
+  std::chrono::microseconds achieved_period{0};
+  std::uint64_t samples = 0;
+  std::uint64_t timeouts = 0;
+  // Samples that completed after their deadline (one period after release).
+  std::uint64_t deadline_misses = 0;
+};
+
+// Earliest-deadline-first schedule of periodic adapter commands.
+//
+// Each entry is released once per period and must complete by the next
+// release. Whenever the link is free, Next() picks the released entry with
+// the earliest deadline, so short-period entries keep their rate while
+// long-period entries only fill the remaining link time. An entry that
+// falls behind is released again immediately instead of bursting to catch
+// up on missed periods.
+//
+// The scheduler does no I/O: the link owner asks it what to send and
+// reports completions, and keeps at most one command outstanding. All
+// methods are thread-safe; SetSchedule() and Stats() are called from the
+// platform thread, the rest from the link's receive thread.
+class PollScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Identifies an issued command across schedule changes.
+  struct Ticket {
+    std::uint32_t generation = 0;
+    std::size_t index = 0;
+  };
+
+  // Replaces the schedule; every entry is released immediately. An empty
+  // schedule stops polling.
+  void SetSchedule(std::vector<PollEntry> entries, Clock::time_point now = Clock::now());
+
+  bool active() const;
+
+  // Picks the next command if any entry is released at |now|.
+  bool Next(Clock::time_point now, std::string* command, Ticket* ticket);
+
+  // Reports the outcome of the command issued with |ticket|. Ignored if the
+  // schedule was replaced since.
+  void Complete(const Ticket& ticket, bool ok, Clock::time_point now);
+
+  // Milliseconds until the next release, 0 if one is pending, -1 if idle.
+  int MillisecondsUntilNextRelease(Clock::time_point now) const;
+
+  std::vector<PollStats> Stats() const;
+  void ResetStats();
+
+ private:
+  struct Slot {
+    PollEntry entry;
+    Clock::time_point release;
+    Clock::time_point deadline;
+    Clock::time_point last_sample_at;
+    bool in_flight = false;
+    PollStats stats;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Slot> slots_;
+  std::uint32_t generation_ = 0;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_POLL_SCHEDULER_H_
@@ -0,0 +1,287 @@
+#include "reactor.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+#if defined(__linux__)
+
+// ─── epoll backend ───
+
+struct Reactor::Impl {
+  int epoll_fd = -1;
+  int wake_fd = -1;
+};
+
+Reactor::Reactor() : impl_(std::make_unique<Impl>()) {
+  impl_->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  impl_->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (impl_->epoll_fd < 0 || impl_->wake_fd < 0) return;
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = kWakeToken;
+  epoll_ctl(impl_->epoll_fd, EPOLL_CTL_ADD, impl_->wake_fd, &ev);
+}
+
+Reactor::~Reactor() {
+  if (impl_->wake_fd >= 0) close(impl_->wake_fd);
+  if (impl_->epoll_fd >= 0) close(impl_->epoll_fd);
+}
+
+bool Reactor::IsValid() const {
+  return impl_->epoll_fd >= 0 && impl_->wake_fd >= 0;
+}
+
+bool Reactor::Add(NativeSocket socket, std::uint64_t token) {
+  if (token == kWakeToken) return false;
+  epoll_event ev = {};
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.u64 = token;
+  return epoll_ctl(impl_->epoll_fd, EPOLL_CTL_ADD, socket, &ev) == 0;
+}
+
+bool Reactor::Remove(NativeSocket socket) {
+  return epoll_ctl(impl_->epoll_fd, EPOLL_CTL_DEL, socket, nullptr) == 0;
+}
+
+bool Reactor::SetWriteInterest(NativeSocket socket, std::uint64_t token, bool enabled) {
+  epoll_event ev = {};
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  if (enabled) ev.events |= EPOLLOUT;
+  ev.data.u64 = token;
+  return epoll_ctl(impl_->epoll_fd, EPOLL_CTL_MOD, socket, &ev) == 0;
+}
+
+int Reactor::Wait(Event* events, int max_events, int timeout_ms) {
+  epoll_event raw[64];
+  int capacity = std::min(max_events + 1, 64);
+  int n = epoll_wait(impl_->epoll_fd, raw, capacity, timeout_ms);
+  if (n < 0) return errno == EINTR ? 0 : -1;
+
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    if (raw[i].data.u64 == kWakeToken) {
+      std::uint64_t drained;
+      while (read(impl_->wake_fd, &drained, sizeof(drained)) > 0) {
+      }
+      continue;
+    }
+    if (count == max_events) break;
+    Event& event = events[count++];
+    event.token = raw[i].data.u64;
+    event.readable = (raw[i].events & EPOLLIN) != 0;
+    event.writable = (raw[i].events & EPOLLOUT) != 0;
+    event.hangup = (raw[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+  }
+  return count;
+}
+
+void Reactor::Wake() {
+  std::uint64_t one = 1;
+  ssize_t written = write(impl_->wake_fd, &one, sizeof(one));
+  (void)written;
+}
+
+#else
+
+// ─── poll / WSAPoll backend ───
+
+#if defined(_WIN32)
+using PollFd = WSAPOLLFD;
+static int PollSockets(PollFd* fds, size_t count, int timeout_ms) {
+  return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+}
+#else
+using PollFd = pollfd;
+static int PollSockets(PollFd* fds, size_t count, int timeout_ms) {
+  return poll(fds, static_cast<nfds_t>(count), timeout_ms);
+}
+#endif
+
+struct Reactor::Impl {
+  struct Entry {
+    NativeSocket socket;
+    std::uint64_t token;
+    bool write_interest;
+  };
+
+  std::mutex mutex;
+  std::vector<Entry> entries;
+  // Windows: one UDP socket connected to itself. POSIX: a pipe.
+  NativeSocket wake_read = kInvalidSocket;
+  NativeSocket wake_write = kInvalidSocket;
+  bool valid = false;
+
+  void DrainWake() {
+    char scratch[64];
+#if defined(_WIN32)
+    while (recv(static_cast<SOCKET>(wake_read), scratch, sizeof(scratch), 0) > 0) {
+    }
+#else
+    while (read(wake_read, scratch, sizeof(scratch)) > 0) {
+    }
+#endif
+  }
+};
+
+Reactor::Reactor() : impl_(std::make_unique<Impl>()) {
+#if defined(_WIN32)
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return;
+
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET) return;
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int addr_len = sizeof(addr);
+  if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0 ||
+      connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    closesocket(sock);
+    return;
+  }
+  impl_->wake_read = impl_->wake_write = static_cast<NativeSocket>(sock);
+#else
+  int fds[2];
+  if (pipe(fds) != 0) return;
+  impl_->wake_read = fds[0];
+  impl_->wake_write = fds[1];
+#endif
+  SetNonBlocking(impl_->wake_read, true);
+  impl_->valid = true;
+}
+
+Reactor::~Reactor() {
+  CloseNativeSocket(impl_->wake_read);
+  if (impl_->wake_write != impl_->wake_read) {
+    CloseNativeSocket(impl_->wake_write);
+  }
+#if defined(_WIN32)
+  WSACleanup();
+#endif
+}
+
+bool Reactor::IsValid() const { return impl_->valid; }
+
+bool Reactor::Add(NativeSocket socket, std::uint64_t token) {
+  if (token == kWakeToken) return false;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    for (const auto& entry : impl_->entries) {
+      if (entry.socket == socket) return false;
+    }
+    impl_->entries.push_back({socket, token, false});
+  }
+  // A Wait() already in progress must pick up the new descriptor.
+  Wake();
+  return true;
+}
+
+bool Reactor::Remove(NativeSocket socket) {
+  bool removed = false;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = std::find_if(impl_->entries.begin(), impl_->entries.end(),
+                           [socket](const Impl::Entry& e) { return e.socket == socket; });
+    if (it != impl_->entries.end()) {
+      impl_->entries.erase(it);
+      removed = true;
+    }
+  }
+  if (removed) Wake();
+  return removed;
+}
+
+bool Reactor::SetWriteInterest(NativeSocket socket, std::uint64_t token, bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    auto it = std::find_if(impl_->entries.begin(), impl_->entries.end(),
+                           [socket](const Impl::Entry& e) { return e.socket == socket; });
+    if (it == impl_->entries.end() || it->token != token) return false;
+    it->write_interest = enabled;
+  }
+  Wake();
+  return true;
+}
+
+int Reactor::Wait(Event* events, int max_events, int timeout_ms) {
+  std::vector<PollFd> fds;
+  std::vector<std::uint64_t> tokens;
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    fds.reserve(impl_->entries.size() + 1);
+    tokens.reserve(impl_->entries.size() + 1);
+    PollFd wake = {};
+    wake.fd = impl_->wake_read;
+    wake.events = POLLIN;
+    fds.push_back(wake);
+    tokens.push_back(kWakeToken);
+    for (const auto& entry : impl_->entries) {
+      PollFd fd = {};
+      fd.fd = entry.socket;
+      fd.events = entry.write_interest ? (POLLIN | POLLOUT) : POLLIN;
+      fds.push_back(fd);
+      tokens.push_back(entry.token);
+    }
+  }
+
+  int n = PollSockets(fds.data(), fds.size(), timeout_ms);
+  if (n < 0) {
+#if !defined(_WIN32)
+    if (errno == EINTR) return 0;
+#endif
+    return -1;
+  }
+
+  int count = 0;
+  for (size_t i = 0; i < fds.size() && n > 0; ++i) {
+    if (fds[i].revents == 0) continue;
+    --n;
+    if (tokens[i] == kWakeToken) {
+      impl_->DrainWake();
+      continue;
+    }
+    if (count == max_events) break;
+    Event& event = events[count++];
+    event.token = tokens[i];
+    event.readable = (fds[i].revents & POLLIN) != 0;
+    event.writable = (fds[i].revents & POLLOUT) != 0;
+    event.hangup = (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+  }
+  return count;
+}
+
+void Reactor::Wake() {
+  const char one = 1;
+#if defined(_WIN32)
+  send(static_cast<SOCKET>(impl_->wake_write), &one, 1, 0);
+#else
+  ssize_t written = write(impl_->wake_write, &one, 1);
+  (void)written;
+#endif
+}
+
+#endif
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,65 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_REACTOR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_REACTOR_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "native_socket.h"
+
+namespace flutter_bluetooth_classic {
+
+// Readiness reactor: blocks until a registered socket has data to read (or,
+// when asked for, room to write), instead of sleeping and polling recv().
+//
+// Backends: epoll + eventfd on Linux, WSAPoll + a loopback wake socket on
+// Windows, poll + a self-pipe on other POSIX systems. All methods except
+// Wait() are thread-safe; Wait() must only be called from one thread at a
+// time.
+class Reactor {
+ public:
+  // Token reserved for the internal wake-up handle.
+  static constexpr std::uint64_t kWakeToken = ~static_cast<std::uint64_t>(0);
+
+  struct Event {
+    std::uint64_t token = 0;
+    bool readable = false;
+    bool writable = false;
+    // Peer closed or socket error; the next recv() reports which.
+    bool hangup = false;
+  };
+
+  Reactor();
+  ~Reactor();
+
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  // False if the backend failed to initialize.
+  bool IsValid() const;
+
+  // Registers |socket| for read readiness. |token| is returned in Events and
+  // must not be kWakeToken.
+  bool Add(NativeSocket socket, std::uint64_t token);
+  bool Remove(NativeSocket socket);
+
+  // Starts or stops reporting |socket| writable. Off after Add(); turn it on
+  // only while there is data waiting to be sent, since an idle socket is
+  // always writable.
+  bool SetWriteInterest(NativeSocket socket, std::uint64_t token, bool enabled);
+
+  // Waits up to |timeout_ms| (-1 = forever) for readiness. Returns the
+  // number of events written to |events|, 0 on timeout or Wake(), -1 on
+  // error.
+  int Wait(Event* events, int max_events, int timeout_ms);
+
+  // Interrupts a blocked Wait() from any thread.
+  void Wake();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_REACTOR_H_
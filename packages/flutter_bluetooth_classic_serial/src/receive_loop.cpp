@@ -0,0 +1,40 @@
+#include "receive_loop.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+ReceiveLoop::ReceiveLoop(NativeSocket socket, DataHandler on_data, ClosedHandler on_closed,
+                         ConnectionReactor* reactor)
+    : socket_(socket),
+      on_data_(std::move(on_data)),
+      on_closed_(std::move(on_closed)),
+      reactor_(reactor) {
+  if (!reactor_) {
+    owned_reactor_ = std::make_unique<ConnectionReactor>();
+    reactor_ = owned_reactor_.get();
+  }
+}
+
+ReceiveLoop::~ReceiveLoop() { Stop(); }
+
+bool ReceiveLoop::Start() {
+  if (IsRunning()) return false;
+  // A private reactor starts with the first Start() and keeps running.
+  if (owned_reactor_) owned_reactor_->Start();
+
+  ConnectionReactor::Handlers handlers;
+  handlers.on_data = on_data_;
+  handlers.on_closed = on_closed_;
+  handlers.on_timer = on_timer_;
+  handlers.on_writable = on_writable_;
+  ConnectionReactor::ConnectionId id = reactor_->Add(socket_, std::move(handlers));
+  id_.store(id, std::memory_order_release);
+  return id != ConnectionReactor::kInvalidConnection;
+}
+
+void ReceiveLoop::Stop() {
+  reactor_->Remove(id_.exchange(ConnectionReactor::kInvalidConnection, std::memory_order_acq_rel));
+}
+
+}  // namespace flutter_bluetooth_classic
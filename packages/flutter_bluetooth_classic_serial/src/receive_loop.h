@@ -0,0 +1,88 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_RECEIVE_LOOP_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_RECEIVE_LOOP_H_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include "connection_reactor.h"
+#include "native_socket.h"
+
+namespace flutter_bluetooth_classic {
+
+// Event-driven receive path for one connected socket.
+//
+// The socket is registered with a ConnectionReactor, which blocks until it
+// is readable, drains it with non-blocking recv() and hands each chunk to
+// the data handler, so the first byte of a reply is delivered as soon as
+// the kernel has it rather than on the next poll tick. Loops given a shared
+// reactor all run on its one thread; without one, the loop owns a private
+// reactor and thread.
+class ReceiveLoop {
+ public:
+  using DataHandler = ConnectionReactor::DataHandler;
+  // |error| is 0 when the remote side closed the connection.
+  using ClosedHandler = ConnectionReactor::ClosedHandler;
+  // Called on the reactor thread once after Start(), after every chunk of
+  // data, after Wake() and whenever the delay it last returned runs out.
+  // Does any time-based work (e.g. flushing a coalescing window) and returns
+  // how long until it is next due in ms (-1 = until data arrives).
+  using TimerHandler = ConnectionReactor::TimerHandler;
+  // Called on the reactor thread while write interest is on and the socket
+  // can take more data.
+  using WritableHandler = ConnectionReactor::WritableHandler;
+
+  // |reactor| must outlive the loop; null gives the loop its own.
+  ReceiveLoop(NativeSocket socket, DataHandler on_data, ClosedHandler on_closed,
+              ConnectionReactor* reactor = nullptr);
+  // Stops the loop. The socket itself is not closed.
+  ~ReceiveLoop();
+
+  ReceiveLoop(const ReceiveLoop&) = delete;
+  ReceiveLoop& operator=(const ReceiveLoop&) = delete;
+
+  // Must be set before Start().
+  void SetTimerHandler(TimerHandler on_timer) { on_timer_ = std::move(on_timer); }
+  // Must be set before Start().
+  void SetWritableHandler(WritableHandler on_writable) {
+    on_writable_ = std::move(on_writable);
+  }
+
+  // Switches the socket to non-blocking mode and registers it.
+  bool Start();
+
+  // Unregisters the socket. On return no handler is running or will run.
+  void Stop();
+
+  // Interrupts the current wait so the timer handler runs promptly, e.g.
+  // after another thread queued work for the loop. Safe from any thread.
+  void Wake() { reactor_->Wake(id_.load(std::memory_order_acquire)); }
+
+  // Turns writable notifications on or off, e.g. from a WriteQueue's
+  // backlog handler. Safe from any thread.
+  bool SetWriteInterest(bool enabled) {
+    return reactor_->SetWriteInterest(id_.load(std::memory_order_acquire), enabled);
+  }
+
+  // The socket's registration; kInvalidConnection before Start() or if it
+  // failed. Ids are never reused, so a stale one is safe to pass to the
+  // reactor after the loop is gone.
+  ConnectionReactor::ConnectionId id() const { return id_.load(std::memory_order_acquire); }
+
+  // False once stopped, or after a remote close or error.
+  bool IsRunning() const { return reactor_->IsOpen(id_.load(std::memory_order_acquire)); }
+
+ private:
+  NativeSocket socket_;
+  DataHandler on_data_;
+  ClosedHandler on_closed_;
+  TimerHandler on_timer_;
+  WritableHandler on_writable_;
+  std::unique_ptr<ConnectionReactor> owned_reactor_;
+  ConnectionReactor* reactor_;
+  std::atomic<ConnectionReactor::ConnectionId> id_{ConnectionReactor::kInvalidConnection};
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_RECEIVE_LOOP_H_
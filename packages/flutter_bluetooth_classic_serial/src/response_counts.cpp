@@ -0,0 +1,147 @@
+#include "response_counts.h"
+
+#include <cctype>
+
+#include "elm327_reply.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Hex OBD requests: a mode byte and at least one more, no count yet.
+bool Countable(const std::string& command) {
+  if (command.size() < 4 || command.size() % 2 != 0) return false;
+  for (char c : command) {
+    if (!std::isxdigit(static_cast<unsigned char>(c))) return false;
+  }
+  return true;
+}
+
+// Complete ECU messages in a reply; 0 if any message was cut short.
+int Responders(const std::vector<std::string>& lines) {
+  int count = 0;
+  for (const auto& message : AssembleElmReply(lines)) {
+    if (!message.complete) return 0;
+    ++count;
+  }
+  return count;
+}
+
+std::uint64_t Micros(std::chrono::microseconds elapsed) {
+  return elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0;
+}
+
+}  // namespace
+
+std::string ResponseCounts::Apply(const std::string& command, int* count) {
+  *count = 0;
+  if (!Countable(command)) return command;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (unsupported_) return command;
+  auto it = entries_.find(command);
+  if (it == entries_.end()) {
+    if (entries_.size() >= kMaxCommands) return command;
+    it = entries_.emplace(command, Entry()).first;
+  }
+  Entry& entry = it->second;
+  ++entry.sends;
+  if (entry.count == 0 || entry.sends % kRecheckInterval == 0) return command;
+
+  *count = entry.count;
+  return command + "0123456789ABCDEF"[entry.count];
+}
+
+void ResponseCounts::Observe(const std::string& command, int count, const CommandResult& result) {
+  if (result.status == CommandResult::Status::kWriteFailed ||
+      result.status == CommandResult::Status::kCancelled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(command);
+  if (it == entries_.end() || unsupported_) return;
+  Entry& entry = it->second;
+  const bool ok = result.status == CommandResult::Status::kOk;
+
+  if (count > 0) {
+    for (const auto& line : result.lines) {
+      if (ok && line == "?") {
+        // The adapter does not take counts at all
+        unsupported_ = true;
+        for (auto& other : entries_) other.second.count = 0;
+        return;
+      }
+    }
+    if (ok && Responders(result.lines) == count) {
+      ++entry.counted_replies;
+      entry.counted_sum_us += Micros(result.elapsed);
+      return;
+    }
+    Drop(&entry);
+    return;
+  }
+
+  if (!ok) {
+    entry.streak = 0;
+    return;
+  }
+  const int responders = Responders(result.lines);
+  ++entry.open_replies;
+  entry.open_sum_us += Micros(result.elapsed);
+  if (entry.count > 0) {
+    // A recheck
+    if (responders != entry.count) Drop(&entry);
+    return;
+  }
+  if (responders == 0 || responders > kMaxCount || entry.relearns >= kMaxRelearns) {
+    entry.streak = 0;
+    return;
+  }
+  if (responders == entry.candidate) {
+    ++entry.streak;
+  } else {
+    entry.candidate = responders;
+    entry.streak = 1;
+  }
+  if (entry.streak >= kLearnReplies) entry.count = responders;
+}
+
+void ResponseCounts::Drop(Entry* entry) {
+  entry->count = 0;
+  entry->candidate = 0;
+  entry->streak = 0;
+  ++entry->relearns;
+}
+
+std::vector<ResponseCountStats> ResponseCounts::Snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ResponseCountStats> snapshot;
+  snapshot.reserve(entries_.size());
+  for (const auto& it : entries_) {
+    const Entry& entry = it.second;
+    ResponseCountStats stats;
+    stats.command = it.first;
+    stats.count = entry.count;
+    stats.open_replies = entry.open_replies;
+    stats.counted_replies = entry.counted_replies;
+    if (entry.open_replies > 0) stats.open_mean_us = entry.open_sum_us / entry.open_replies;
+    if (entry.counted_replies > 0) {
+      stats.counted_mean_us = entry.counted_sum_us / entry.counted_replies;
+    }
+    if (stats.open_replies > 0 && stats.counted_replies > 0 &&
+        stats.open_mean_us > stats.counted_mean_us) {
+      stats.saved_us = stats.open_mean_us - stats.counted_mean_us;
+    }
+    stats.relearns = entry.relearns;
+    snapshot.push_back(std::move(stats));
+  }
+  return snapshot;
+}
+
+void ResponseCounts::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  unsupported_ = false;
+}
+
+}  // namespace flutter_bluetooth_classic
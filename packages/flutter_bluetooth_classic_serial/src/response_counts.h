@@ -0,0 +1,96 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_RESPONSE_COUNTS_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_RESPONSE_COUNTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "command_pipeline.h"
+
+namespace flutter_bluetooth_classic {
+
+// What has been learned about the responders of one command.
+struct ResponseCountStats {
+  std::string command;
+  // Count appended to the command; 0 while it is sent open-ended.
+  int count = 0;
+  std::uint64_t open_replies = 0;
+  std::uint64_t counted_replies = 0;
+  // Mean round trip without and with the count.
+  std::uint64_t open_mean_us = 0;
+  std::uint64_t counted_mean_us = 0;
+  // open_mean_us - counted_mean_us once both are known, else 0.
+  std::uint64_t saved_us = 0;
+  // Times a learned count was dropped because the responders changed.
+  int relearns = 0;
+};
+
+// Learns how many ECUs answer each OBD request and appends that count to
+// the request (010C -> 010C2), so the adapter returns the prompt as soon
+// as the last ECU has answered instead of waiting out ATST for more.
+//
+// A count is used once kLearnReplies open-ended replies in a row had the
+// same number of complete messages. A counted reply with fewer messages
+// (an ECU went quiet and the adapter timed out) or a cut-short message
+// drops the count, as does a periodic open-ended recheck that hears a
+// different number (an ECU joined). A command whose responders changed
+// kMaxRelearns times stays open-ended. An adapter that answers "?" to a
+// count (ELM327 before v1.3) turns counting off for the link.
+//
+// Only hex OBD requests are counted; AT and ST commands pass unchanged.
+// Apply() and Observe() run on the link's receive thread, Snapshot() on
+// any thread.
+class ResponseCounts {
+ public:
+  static constexpr int kLearnReplies = 3;
+  // Every kRecheckInterval-th send of a counted command goes open-ended.
+  static constexpr std::uint32_t kRecheckInterval = 100;
+  static constexpr int kMaxRelearns = 3;
+  // The count is one hex digit.
+  static constexpr int kMaxCount = 0xF;
+  // Commands beyond this many (a DID scan) are sent open-ended.
+  static constexpr std::size_t kMaxCommands = 256;
+
+  ResponseCounts() = default;
+  ResponseCounts(const ResponseCounts&) = delete;
+  ResponseCounts& operator=(const ResponseCounts&) = delete;
+
+  // The command to write for |command|; |*count| is set to the count it
+  // carries, 0 if none.
+  std::string Apply(const std::string& command, int* count);
+
+  // Reports the result of |command| sent with |count| by Apply().
+  void Observe(const std::string& command, int count, const CommandResult& result);
+
+  // Every counted command, in command order.
+  std::vector<ResponseCountStats> Snapshot() const;
+
+  // Forgets everything, e.g. for another vehicle.
+  void Reset();
+
+ private:
+  struct Entry {
+    int count = 0;
+    int candidate = 0;
+    int streak = 0;
+    int relearns = 0;
+    std::uint32_t sends = 0;
+    std::uint64_t open_replies = 0;
+    std::uint64_t counted_replies = 0;
+    std::uint64_t open_sum_us = 0;
+    std::uint64_t counted_sum_us = 0;
+  };
+
+  static void Drop(Entry* entry);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+  bool unsupported_ = false;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_RESPONSE_COUNTS_H_
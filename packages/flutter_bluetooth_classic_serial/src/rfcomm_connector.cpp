@@ -0,0 +1,140 @@
+#include "rfcomm_connector.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+using Clock = ConnectTransport::Clock;
+
+struct Attempt {
+  NativeSocket socket;
+  int channel;
+  Clock::time_point started;
+};
+
+int MillisecondsUntil(Clock::time_point when, Clock::time_point now) {
+  if (when <= now) return 0;
+  // Round up so the wait never ends just before the timeout.
+  return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(when - now).count());
+}
+
+// Runs connects to |channels| in order, at most |max_parallel| at a time.
+// Returns true with the winner in |result|, false once every channel failed
+// or |deadline| passed.
+bool Probe(ConnectTransport* transport, const std::vector<int>& channels, std::size_t max_parallel,
+           std::chrono::milliseconds attempt_timeout, Clock::time_point deadline,
+           RfcommConnectResult* result) {
+  std::vector<Attempt> in_flight;
+  std::vector<NativeSocket> sockets;
+  std::vector<int> outcomes;
+  std::size_t next = 0;
+
+  auto close_all = [&]() {
+    for (const auto& attempt : in_flight) transport->Close(attempt.socket);
+    in_flight.clear();
+  };
+
+  for (;;) {
+    Clock::time_point now = transport->Now();
+    if (now >= deadline) break;
+
+    while (in_flight.size() < max_parallel && next < channels.size()) {
+      const int channel = channels[next++];
+      int error = 0;
+      ++result->attempts;
+      NativeSocket socket = transport->StartConnect(channel, &error);
+      if (socket == kInvalidSocket) {
+        result->last_error = error;
+        continue;
+      }
+      in_flight.push_back({socket, channel, now});
+    }
+    if (in_flight.empty()) return false;
+
+    Clock::time_point wake = deadline;
+    for (const auto& attempt : in_flight) {
+      wake = std::min(wake, attempt.started + attempt_timeout);
+    }
+
+    sockets.clear();
+    for (const auto& attempt : in_flight) sockets.push_back(attempt.socket);
+    outcomes.assign(in_flight.size(), kConnectPending);
+    if (transport->WaitConnect(sockets.data(), outcomes.data(), sockets.size(),
+                               MillisecondsUntil(wake, now)) < 0) {
+      break;
+    }
+
+    // Lowest channel among those that connected during this wait wins.
+    std::size_t winner = in_flight.size();
+    for (std::size_t i = 0; i < in_flight.size(); ++i) {
+      if (outcomes[i] == 0 &&
+          (winner == in_flight.size() || in_flight[i].channel < in_flight[winner].channel)) {
+        winner = i;
+      }
+    }
+    if (winner < in_flight.size()) {
+      result->socket = in_flight[winner].socket;
+      result->channel = in_flight[winner].channel;
+      in_flight.erase(in_flight.begin() + static_cast<std::ptrdiff_t>(winner));
+      close_all();
+      return true;
+    }
+
+    now = transport->Now();
+    std::vector<Attempt> still_pending;
+    for (std::size_t i = 0; i < in_flight.size(); ++i) {
+      const bool failed = outcomes[i] != kConnectPending;
+      const bool expired = now - in_flight[i].started >= attempt_timeout;
+      if (failed || expired) {
+        if (failed) result->last_error = outcomes[i];
+        transport->Close(in_flight[i].socket);
+      } else {
+        still_pending.push_back(in_flight[i]);
+      }
+    }
+    in_flight.swap(still_pending);
+  }
+
+  close_all();
+  return false;
+}
+
+}  // namespace
+
+RfcommConnectResult ConnectRfcomm(ConnectTransport* transport, const RfcommConnectOptions& options) {
+  RfcommConnectResult result;
+  const Clock::time_point start = transport->Now();
+  const Clock::time_point deadline = start + options.deadline;
+  auto finish = [&]() {
+    result.elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(transport->Now() - start);
+    return result;
+  };
+
+  const int cached = options.cached_channel;
+  if (cached > 0 && Probe(transport, {cached}, 1, options.attempt_timeout, deadline, &result)) {
+    result.from_cache = true;
+    return finish();
+  }
+
+  const int advertised = transport->LookupServiceChannel();
+  if (advertised > 0 && advertised != cached) {
+    if (Probe(transport, {advertised}, 1, options.attempt_timeout, deadline, &result)) {
+      result.from_service_lookup = true;
+      return finish();
+    }
+  }
+
+  std::vector<int> channels;
+  for (int channel = options.first_channel; channel <= options.last_channel; ++channel) {
+    if (channel != advertised && channel != cached) channels.push_back(channel);
+  }
+  Probe(transport, channels, std::max<std::size_t>(options.max_parallel, 1),
+        options.attempt_timeout, deadline, &result);
+  return finish();
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,77 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_RFCOMM_CONNECTOR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_RFCOMM_CONNECTOR_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "native_socket.h"
+
+namespace flutter_bluetooth_classic {
+
+// Socket operations ConnectRfcomm needs for one remote device. The Windows
+// plugin implements them over AF_BTH sockets and SDP; tests substitute a
+// simulated device.
+class ConnectTransport {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  virtual ~ConnectTransport() = default;
+
+  virtual Clock::time_point Now() { return Clock::now(); }
+
+  // RFCOMM channel the device advertises for the serial port service, or -1
+  // if the lookup failed or found none.
+  virtual int LookupServiceChannel() = 0;
+
+  // Opens a new non-blocking socket and starts connecting it to |channel|.
+  // Returns kInvalidSocket and sets |error| if that fails immediately.
+  virtual NativeSocket StartConnect(int channel, int* error) = 0;
+
+  // Same contract as WaitForConnect().
+  virtual int WaitConnect(const NativeSocket* sockets, int* results, std::size_t count,
+                          int timeout_ms) {
+    return WaitForConnect(sockets, results, count, timeout_ms);
+  }
+
+  virtual void Close(NativeSocket socket) { CloseNativeSocket(socket); }
+};
+
+struct RfcommConnectOptions {
+  // Channel that worked last time (from a connection profile), tried before
+  // the SDP lookup; 0 = none.
+  int cached_channel = 0;
+  // Channels probed when SDP does not resolve one.
+  int first_channel = 1;
+  int last_channel = 30;
+  // Probe connects in flight at once.
+  std::size_t max_parallel = 4;
+  // A connect still pending after this long is abandoned.
+  std::chrono::milliseconds attempt_timeout{4000};
+  // Bound on the whole call, lookup included.
+  std::chrono::milliseconds deadline{20000};
+};
+
+struct RfcommConnectResult {
+  // Connected socket, still non-blocking; kInvalidSocket on failure.
+  NativeSocket socket = kInvalidSocket;
+  int channel = -1;
+  bool from_service_lookup = false;
+  bool from_cache = false;
+  int attempts = 0;
+  // Error of the last failed attempt, 0 if none failed with one.
+  int last_error = 0;
+  std::chrono::milliseconds elapsed{0};
+};
+
+// Connects to the device's serial port service.
+//
+// A cached channel is tried first, then the channel advertised over SDP.
+// If neither connects, channels first..last are probed in ascending order with
+// up to max_parallel non-blocking connects at a time, each on its own
+// socket. The first connect to succeed wins (the lowest channel if several
+// finish together) and every other socket is closed.
+RfcommConnectResult ConnectRfcomm(ConnectTransport* transport, const RfcommConnectOptions& options);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_RFCOMM_CONNECTOR_H_
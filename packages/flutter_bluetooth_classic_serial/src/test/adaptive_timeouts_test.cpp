@@ -0,0 +1,119 @@
+#include "adaptive_timeouts.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "timeout_simulation.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Lines = std::vector<std::string>;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+constexpr int kDefault = AdaptiveTimeouts::kDefaultCounts;
+
+CommandResult Reply(const std::string& command, Lines lines) {
+  CommandResult result;
+  result.command = command;
+  result.lines = std::move(lines);
+  return result;
+}
+
+// Sends |command| until it has enough results, each answered by |lines|
+// after |first_response|, under whatever Select() picks.
+int Learn(AdaptiveTimeouts* timeouts, const std::string& command, const Lines& lines,
+          microseconds first_response, int current = kDefault) {
+  for (std::size_t i = 0; i < AdaptiveTimeouts::kMinSends; ++i) {
+    current = timeouts->Select(command, current);
+    timeouts->Observe(command, current, Reply(command, lines), first_response);
+  }
+  return current;
+}
+
+TEST(AdaptiveTimeoutsTest, NeedsAQuantileWithMarginOnceLearned) {
+  AdaptiveTimeouts timeouts;
+  // Not managed: AT commands and unknown values pass through
+  EXPECT_EQ(timeouts.Select("ATRV", 0x19), 0x19);
+  EXPECT_EQ(timeouts.Select("010C", -1), kDefault);
+
+  EXPECT_EQ(Learn(&timeouts, "010C", {"7E8 04 41 0C 1A F8"}, milliseconds(25)), kDefault);
+  // 25 ms * 1.5 is 10 counts, plus the margin, rounded up to the ladder
+  EXPECT_EQ(timeouts.Select("010C", -1), 16);
+  EXPECT_EQ(timeouts.Select("010C", 8), 16);
+  // Always answered, so lowering would never pay for the change
+  EXPECT_EQ(timeouts.Select("010C", kDefault), kDefault);
+
+  auto snapshot = timeouts.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1u);
+  EXPECT_EQ(snapshot[0].counts, 16);
+  EXPECT_EQ(snapshot[0].quantile_us, 25000u);
+  EXPECT_EQ(snapshot[0].replies, AdaptiveTimeouts::kMinSends);
+}
+
+TEST(AdaptiveTimeoutsTest, LowersForCommandsNobodyAnswers) {
+  AdaptiveTimeouts timeouts;
+  Learn(&timeouts, "010C", {"7E8 04 41 0C 1A F8"}, milliseconds(40));
+  // Unanswered commands use their service's response times
+  Learn(&timeouts, "0146", {"NO DATA"}, microseconds(0));
+  EXPECT_EQ(timeouts.Select("0146", kDefault), 24);
+  EXPECT_EQ(timeouts.Select("010C", 24), 24);
+
+  // A slow module needs more than the default, but never lifts a command
+  // nobody answers above it
+  Learn(&timeouts, "22D001", {"7EC 05 62 D0 01 01 5A"}, milliseconds(150));
+  EXPECT_EQ(timeouts.Select("22D001", 24), 64);
+  Learn(&timeouts, "22F1A0", {"NO DATA"}, microseconds(0), 64);
+  EXPECT_EQ(timeouts.Select("22F1A0", 64), kDefault);
+}
+
+TEST(AdaptiveTimeoutsTest, BacksOffWhenTheTimeoutWasCutClose) {
+  AdaptiveTimeouts timeouts;
+  const Lines both = {"7E8 04 41 0C 1A F8", "7E9 04 41 0C 1A F8"};
+  Learn(&timeouts, "010C", both, milliseconds(25));
+  EXPECT_EQ(timeouts.Select("010C", -1), 16);
+
+  // A NO DATA under the lowered value is checked once at the default
+  timeouts.Observe("010C", 16, Reply("010C", {"NO DATA"}), microseconds(0));
+  EXPECT_EQ(timeouts.Select("010C", 16), kDefault);
+  timeouts.Observe("010C", kDefault, Reply("010C", both), milliseconds(25));
+  EXPECT_EQ(timeouts.Select("010C", -1), 16);
+
+  // An ECU went missing under the lowered value
+  timeouts.Observe("010C", 16, Reply("010C", {both[0]}), milliseconds(25));
+  for (int i = 0; i < AdaptiveTimeouts::kBackoffSends; ++i) {
+    EXPECT_EQ(timeouts.Select("010C", 16), kDefault);
+  }
+  EXPECT_EQ(timeouts.Select("010C", -1), 16);
+  EXPECT_EQ(timeouts.Snapshot()[0].backoffs, 1);
+
+  // An adapter that rejects ATST turns the controller off
+  timeouts.ObserveChange(milliseconds(10), false);
+  EXPECT_EQ(timeouts.Select("010C", -1), -1);
+  timeouts.Reset();
+  EXPECT_TRUE(timeouts.Snapshot().empty());
+}
+
+TEST(AdaptiveTimeoutsTest, ReplayedTracesCycleFasterWithoutMoreNoData) {
+  const EmulatorProfile profile = TimeoutTraceProfile();
+  const auto commands = TimeoutTraceCommands();
+  TimeoutSimulationOptions options;
+  const TimeoutSimulationResult fixed = SimulateTimeouts(profile, commands, options);
+  options.adaptive = true;
+  const TimeoutSimulationResult adaptive = SimulateTimeouts(profile, commands, options);
+
+  EXPECT_EQ(fixed.atst_changes, 0u);
+  EXPECT_GT(adaptive.atst_changes, 0u);
+  // The same answers arrive; only the waits for missing ones are shorter
+  EXPECT_EQ(adaptive.replies, fixed.replies);
+  EXPECT_EQ(adaptive.no_data, fixed.no_data);
+  EXPECT_LT(adaptive.mean_cycle.count(), fixed.mean_cycle.count() * 17 / 20)
+      << "fixed " << fixed.mean_cycle.count() << " us, adaptive " << adaptive.mean_cycle.count()
+      << " us";
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,118 @@
+#include "byte_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+std::size_t WriteString(ByteRing& ring, const std::string& text) {
+  return ring.Write(reinterpret_cast<const std::uint8_t*>(text.data()), text.size());
+}
+
+std::string ReadAll(ByteRing& ring) {
+  std::string out(ring.Available(), '\0');
+  std::size_t read = ring.Read(reinterpret_cast<std::uint8_t*>(&out[0]), out.size());
+  out.resize(read);
+  return out;
+}
+
+TEST(ByteRingTest, RoundsCapacityUpToPowerOfTwo) {
+  EXPECT_EQ(ByteRing(100).capacity(), 128u);
+  EXPECT_EQ(ByteRing(64).capacity(), 64u);
+  EXPECT_EQ(ByteRing(0).capacity(), 1u);
+}
+
+TEST(ByteRingTest, ReadsBackWhatWasWritten) {
+  ByteRing ring(16);
+  EXPECT_EQ(WriteString(ring, "41 0C 1A F8\r>"), 13u);
+  EXPECT_EQ(ring.Available(), 13u);
+  EXPECT_EQ(ReadAll(ring), "41 0C 1A F8\r>");
+  EXPECT_EQ(ring.Available(), 0u);
+}
+
+TEST(ByteRingTest, PeekSplitsWrappedDataIntoTwoRegions) {
+  ByteRing ring(8);
+  WriteString(ring, "abcdef");
+  ring.Consume(5);
+  WriteString(ring, "ghijk");  // wraps: "f" + "ghijk" spans the end
+
+  ByteRing::Region regions[2];
+  ASSERT_EQ(ring.Peek(regions), 2);
+  std::string joined(reinterpret_cast<const char*>(regions[0].data), regions[0].size);
+  joined.append(reinterpret_cast<const char*>(regions[1].data), regions[1].size);
+  EXPECT_EQ(joined, "fghijk");
+
+  // Peek does not consume.
+  EXPECT_EQ(ring.Available(), 6u);
+  ring.Consume(2);
+  EXPECT_EQ(ReadAll(ring), "hijk");
+}
+
+TEST(ByteRingTest, DropsAndCountsBytesThatDoNotFit) {
+  ByteRing ring(8);
+  EXPECT_EQ(WriteString(ring, "0123456"), 7u);
+  EXPECT_EQ(ring.overflow_count(), 0u);
+
+  EXPECT_EQ(WriteString(ring, "789"), 1u);
+  EXPECT_EQ(WriteString(ring, "X"), 0u);
+  EXPECT_EQ(ring.dropped_bytes(), 3u);
+  EXPECT_EQ(ring.overflow_count(), 2u);
+
+  // Unread data is never overwritten.
+  EXPECT_EQ(ReadAll(ring), "01234567");
+}
+
+TEST(ByteRingTest, ClearDiscardsReadableBytes) {
+  ByteRing ring(8);
+  WriteString(ring, "stale");
+  ring.Clear();
+  EXPECT_EQ(ring.Available(), 0u);
+  WriteString(ring, "new");
+  EXPECT_EQ(ReadAll(ring), "new");
+}
+
+TEST(ByteRingTest, ConcurrentProducerAndConsumerPreserveOrder) {
+  constexpr std::size_t kTotal = 1 << 20;
+  ByteRing ring(256);
+
+  std::thread producer([&]() {
+    std::uint8_t chunk[37];
+    std::size_t sent = 0;
+    while (sent < kTotal) {
+      std::size_t n = std::min(sizeof(chunk), kTotal - sent);
+      for (std::size_t i = 0; i < n; ++i) chunk[i] = static_cast<std::uint8_t>(sent + i);
+      while (ring.Space() < n) std::this_thread::yield();
+      EXPECT_EQ(ring.Write(chunk, n), n);
+      sent += n;
+    }
+  });
+
+  std::size_t received = 0;
+  bool in_order = true;
+  while (received < kTotal) {
+    ByteRing::Region regions[2];
+    int count = ring.Peek(regions);
+    if (count == 0) std::this_thread::yield();
+    for (int r = 0; r < count; ++r) {
+      for (std::size_t i = 0; i < regions[r].size; ++i) {
+        if (regions[r].data[i] != static_cast<std::uint8_t>(received + i)) in_order = false;
+      }
+      ring.Consume(regions[r].size);
+      received += regions[r].size;
+    }
+  }
+  producer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(received, kTotal);
+  EXPECT_EQ(ring.dropped_bytes(), 0u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
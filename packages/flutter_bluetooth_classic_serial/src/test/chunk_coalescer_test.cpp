@@ -0,0 +1,77 @@
+#include "chunk_coalescer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = ChunkCoalescer::Clock;
+using std::chrono::milliseconds;
+
+bool AppendString(ChunkCoalescer& coalescer, const std::string& text, Clock::time_point now) {
+  return coalescer.Append(reinterpret_cast<const std::uint8_t*>(text.data()), text.size(), now);
+}
+
+std::string TakeString(ChunkCoalescer& coalescer) {
+  auto bytes = coalescer.Take();
+  return std::string(bytes.begin(), bytes.end());
+}
+
+TEST(ChunkCoalescerTest, EmptyBufferIsNeverDue) {
+  ChunkCoalescer coalescer;
+  auto now = Clock::now();
+  EXPECT_FALSE(coalescer.IsDue(now + milliseconds(1000)));
+  EXPECT_EQ(coalescer.MillisecondsUntilDue(now), -1);
+}
+
+TEST(ChunkCoalescerTest, MergesFragmentsUntilPrompt) {
+  ChunkCoalescer coalescer;
+  auto now = Clock::now();
+
+  EXPECT_FALSE(AppendString(coalescer, "7E8 04 41", now));
+  EXPECT_FALSE(AppendString(coalescer, " 0C 1A F8\r", now + milliseconds(1)));
+  EXPECT_TRUE(AppendString(coalescer, "\r>", now + milliseconds(2)));
+
+  EXPECT_EQ(TakeString(coalescer), "7E8 04 41 0C 1A F8\r\r>");
+  EXPECT_TRUE(coalescer.empty());
+  EXPECT_FALSE(coalescer.IsDue(now + milliseconds(100)));
+}
+
+TEST(ChunkCoalescerTest, FlushesWhenWindowCloses) {
+  CoalescingOptions options;
+  options.window = milliseconds(10);
+  options.flush_byte = -1;
+  ChunkCoalescer coalescer(options);
+  auto start = Clock::now();
+
+  EXPECT_FALSE(AppendString(coalescer, "AB", start));
+  EXPECT_EQ(coalescer.MillisecondsUntilDue(start + milliseconds(4)), 6);
+  // Later fragments do not extend the window of the first byte.
+  EXPECT_FALSE(AppendString(coalescer, "CD", start + milliseconds(9)));
+  EXPECT_TRUE(coalescer.IsDue(start + milliseconds(10)));
+  EXPECT_EQ(coalescer.MillisecondsUntilDue(start + milliseconds(10)), 0);
+}
+
+TEST(ChunkCoalescerTest, FlushesAtSizeLimit) {
+  CoalescingOptions options;
+  options.max_bytes = 4;
+  options.flush_byte = -1;
+  ChunkCoalescer coalescer(options);
+  auto now = Clock::now();
+
+  EXPECT_FALSE(AppendString(coalescer, "123", now));
+  EXPECT_TRUE(AppendString(coalescer, "45", now));
+  EXPECT_EQ(TakeString(coalescer), "12345");
+}
+
+TEST(ChunkCoalescerTest, IgnoresPromptWhenDisabled) {
+  CoalescingOptions options;
+  options.flush_byte = -1;
+  ChunkCoalescer coalescer(options);
+  EXPECT_FALSE(AppendString(coalescer, "OK\r>", Clock::now()));
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
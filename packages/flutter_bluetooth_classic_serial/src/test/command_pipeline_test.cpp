@@ -0,0 +1,303 @@
+#include "command_pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "adaptive_timeouts.h"
+#include "response_counts.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = CommandPipeline::Clock;
+using Lines = std::vector<std::string>;
+using Status = CommandResult::Status;
+using std::chrono::milliseconds;
+
+ElmResponse MakeResponse(Lines lines, Clock::time_point at = Clock::now()) {
+  ElmResponse response;
+  response.lines = std::move(lines);
+  response.first_byte_at = at;
+  response.completed_at = at;
+  return response;
+}
+
+class CommandPipelineTest : public ::testing::Test {
+ protected:
+  CommandPipelineTest()
+      : pipeline_([this](const std::string& data) {
+          writes_.push_back(data);
+          return write_ok_;
+        }) {}
+
+  void Submit(Lines commands, milliseconds timeout = milliseconds(100)) {
+    pipeline_.Submit(std::move(commands), timeout, [this](std::vector<CommandResult>&& results) {
+      batches_.push_back(std::move(results));
+    });
+  }
+
+  CommandPipeline pipeline_;
+  Lines writes_;
+  bool write_ok_ = true;
+  std::vector<std::vector<CommandResult>> batches_;
+};
+
+TEST_F(CommandPipelineTest, WritesNextCommandAsSoonAsPromptArrives) {
+  Submit({"010C", "010D", "0105"});
+  EXPECT_TRUE(pipeline_.busy());
+  EXPECT_TRUE(writes_.empty());  // started by the receive thread
+
+  EXPECT_GT(pipeline_.OnTimer(Clock::now()), 0);
+  EXPECT_EQ(writes_, Lines({"010C\r"}));
+
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"})));
+  EXPECT_EQ(writes_, Lines({"010C\r", "010D\r"}));
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"41 0D 37"})));
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"41 05 7B"})));
+  EXPECT_EQ(writes_.size(), 3u);
+
+  ASSERT_EQ(batches_.size(), 1u);
+  const auto& results = batches_[0];
+  ASSERT_EQ(results.size(), 3u);
+  EXPECT_EQ(results[0].command, "010C");
+  EXPECT_EQ(results[0].lines, Lines({"41 0C 1A F8"}));
+  EXPECT_EQ(results[1].lines, Lines({"41 0D 37"}));
+  EXPECT_EQ(results[2].command, "0105");
+  EXPECT_EQ(results[2].status, Status::kOk);
+  EXPECT_FALSE(pipeline_.busy());
+}
+
+TEST_F(CommandPipelineTest, IgnoresResponsesWhenIdle) {
+  EXPECT_FALSE(pipeline_.OnResponse(MakeResponse({"OK"})));
+  EXPECT_EQ(pipeline_.OnTimer(Clock::now()), -1);
+}
+
+TEST_F(CommandPipelineTest, RunsQueuedBatchesInOrder) {
+  Submit({"010C"});
+  Submit({"AT RV"});
+  pipeline_.OnTimer(Clock::now());
+  pipeline_.OnResponse(MakeResponse({"41 0C 00 00"}));
+  EXPECT_EQ(writes_, Lines({"010C\r", "AT RV\r"}));
+  pipeline_.OnResponse(MakeResponse({"12.6V"}));
+
+  ASSERT_EQ(batches_.size(), 2u);
+  EXPECT_EQ(batches_[1][0].lines, Lines({"12.6V"}));
+}
+
+TEST_F(CommandPipelineTest, TimeoutAbortsCommandAndDiscardsItsPrompt) {
+  Submit({"22F190", "010C"}, milliseconds(50));
+  auto start = Clock::now();
+  pipeline_.OnTimer(start);
+
+  // Deadline passes: the command is abandoned with a bare CR.
+  EXPECT_EQ(pipeline_.OnTimer(start + milliseconds(60)), 50);
+  EXPECT_EQ(writes_, Lines({"22F190\r", "\r"}));
+
+  // The prompt after the abort belongs to the abandoned command.
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"STOPPED"})));
+  EXPECT_EQ(writes_.back(), "010C\r");
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"})));
+
+  ASSERT_EQ(batches_.size(), 1u);
+  EXPECT_EQ(batches_[0][0].status, Status::kTimedOut);
+  EXPECT_TRUE(batches_[0][0].lines.empty());
+  EXPECT_EQ(batches_[0][1].status, Status::kOk);
+  EXPECT_EQ(batches_[0][1].lines, Lines({"41 0C 1A F8"}));
+}
+
+TEST_F(CommandPipelineTest, ReportsWriteFailures) {
+  write_ok_ = false;
+  Submit({"010C", "010D"});
+  pipeline_.OnTimer(Clock::now());
+  ASSERT_EQ(batches_.size(), 1u);
+  EXPECT_EQ(batches_[0][0].status, Status::kWriteFailed);
+  EXPECT_EQ(batches_[0][1].status, Status::kWriteFailed);
+  EXPECT_FALSE(pipeline_.busy());
+}
+
+TEST_F(CommandPipelineTest, CancelCompletesEverythingAsCancelled) {
+  Submit({"010C", "010D"});
+  Submit({"0105"});
+  pipeline_.OnTimer(Clock::now());
+  pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}));
+  pipeline_.Cancel();
+
+  ASSERT_EQ(batches_.size(), 2u);
+  EXPECT_EQ(batches_[0][0].status, Status::kOk);
+  EXPECT_EQ(batches_[0][1].status, Status::kCancelled);
+  EXPECT_EQ(batches_[1][0].status, Status::kCancelled);
+  EXPECT_FALSE(pipeline_.busy());
+  EXPECT_FALSE(pipeline_.OnResponse(MakeResponse({"41 0D 37"})));
+}
+
+TEST_F(CommandPipelineTest, RunsScheduledCommandsWhileIdle) {
+  PollScheduler scheduler;
+  std::vector<CommandResult> samples;
+  pipeline_.SetPollScheduler(&scheduler, milliseconds(100), [&samples](CommandResult&& result) {
+    samples.push_back(std::move(result));
+  });
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"010C", milliseconds(100)}}, start);
+  EXPECT_TRUE(pipeline_.busy());
+
+  EXPECT_GT(pipeline_.OnTimer(start), 0);
+  EXPECT_EQ(writes_, Lines({"010C\r"}));
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}, start + milliseconds(20))));
+
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].command, "010C");
+  EXPECT_EQ(samples[0].lines, Lines({"41 0C 1A F8"}));
+  // Not released again until the period is over
+  EXPECT_EQ(writes_.size(), 1u);
+  EXPECT_EQ(pipeline_.OnTimer(start + milliseconds(20)), 80);
+  pipeline_.OnTimer(start + milliseconds(100));
+  EXPECT_EQ(writes_.size(), 2u);
+}
+
+TEST_F(CommandPipelineTest, BatchRunsBetweenScheduledCommands) {
+  PollScheduler scheduler;
+  std::vector<CommandResult> samples;
+  pipeline_.SetPollScheduler(&scheduler, milliseconds(100), [&samples](CommandResult&& result) {
+    samples.push_back(std::move(result));
+  });
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"010C", milliseconds(10)}}, start);
+  pipeline_.OnTimer(start);
+  Submit({"AT RV"});
+
+  // The outstanding sample completes first, then the batch goes ahead of
+  // the next release even though it is already due
+  pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}, start + milliseconds(20)));
+  EXPECT_EQ(writes_, Lines({"010C\r", "AT RV\r"}));
+  pipeline_.OnResponse(MakeResponse({"12.6V"}, start + milliseconds(30)));
+  EXPECT_EQ(writes_.back(), "010C\r");
+
+  ASSERT_EQ(batches_.size(), 1u);
+  EXPECT_EQ(batches_[0][0].lines, Lines({"12.6V"}));
+  EXPECT_EQ(samples.size(), 1u);
+}
+
+TEST_F(CommandPipelineTest, ScheduledCommandTimeoutIsReportedAsSample) {
+  PollScheduler scheduler;
+  std::vector<CommandResult> samples;
+  pipeline_.SetPollScheduler(&scheduler, milliseconds(50), [&samples](CommandResult&& result) {
+    samples.push_back(std::move(result));
+  });
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"22F190", milliseconds(1000)}}, start);
+  pipeline_.OnTimer(start);
+  pipeline_.OnTimer(start + milliseconds(60));
+
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].status, Status::kTimedOut);
+  EXPECT_EQ(scheduler.Stats()[0].timeouts, 1u);
+  EXPECT_EQ(writes_.back(), "\r");
+}
+
+TEST_F(CommandPipelineTest, RecordsPhasesAndTimeoutsIntoLinkStats) {
+  LinkStats stats;
+  pipeline_.SetLinkStats(&stats);
+  Submit({"010C", "22F190"}, milliseconds(50));
+  auto start = Clock::now();
+  pipeline_.OnTimer(start);
+
+  ElmResponse response = MakeResponse({"41 0C 1A F8"});
+  response.first_byte_at = Clock::now() + milliseconds(20);
+  response.completed_at = response.first_byte_at + milliseconds(5);
+  pipeline_.OnResponse(std::move(response));
+  pipeline_.OnTimer(Clock::now() + milliseconds(200));
+  pipeline_.OnResponse(MakeResponse({"STOPPED"}));
+
+  auto snapshot = stats.Snapshot();
+  ASSERT_EQ(snapshot.size(), 2u);
+  const CommandLatency& rpm = snapshot[0];
+  EXPECT_EQ(rpm.command, "010C");
+  EXPECT_EQ(rpm.completed, 1u);
+  const auto& first_byte = rpm.phases[static_cast<int>(LatencyPhase::kFirstByte)];
+  const auto& prompt = rpm.phases[static_cast<int>(LatencyPhase::kPrompt)];
+  const auto& round_trip = rpm.phases[static_cast<int>(LatencyPhase::kRoundTrip)];
+  EXPECT_EQ(first_byte.count, 1u);
+  EXPECT_GE(first_byte.max_us, 20000u);
+  EXPECT_EQ(prompt.max_us, 5000u);
+  EXPECT_EQ(round_trip.max_us, first_byte.max_us + prompt.max_us);
+  ASSERT_EQ(batches_.size(), 1u);
+  EXPECT_EQ(static_cast<std::uint64_t>(batches_[0][0].elapsed.count()), round_trip.max_us);
+
+  EXPECT_EQ(snapshot[1].command, "22F190");
+  EXPECT_EQ(snapshot[1].timeouts, 1u);
+  EXPECT_EQ(snapshot[1].phases[static_cast<int>(LatencyPhase::kRoundTrip)].count, 0u);
+  EXPECT_EQ(stats.counter(LinkCounter::kTimeouts), 1u);
+}
+
+TEST_F(CommandPipelineTest, AppendsLearnedResponseCounts) {
+  ResponseCounts counts;
+  pipeline_.SetResponseCounts(&counts);
+  const Lines reply = {"18DAF110 04 41 0C 1A F8", "18DAF118 03 7F 01 12"};
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) {
+    Submit({"010C", "ATRV"});
+    pipeline_.OnTimer(Clock::now());
+    pipeline_.OnResponse(MakeResponse(reply));
+    pipeline_.OnResponse(MakeResponse({"12.6V"}));
+  }
+  EXPECT_EQ(writes_.back(), "ATRV\r");
+  EXPECT_EQ(writes_[writes_.size() - 2], "010C\r");
+
+  Submit({"010C", "ATRV"});
+  pipeline_.OnTimer(Clock::now());
+  EXPECT_EQ(writes_.back(), "010C2\r");
+  pipeline_.OnResponse(MakeResponse(reply));
+  EXPECT_EQ(writes_.back(), "ATRV\r");
+  pipeline_.OnResponse(MakeResponse({"12.6V"}));
+
+  // Results carry the command as submitted
+  ASSERT_EQ(batches_.size(), static_cast<std::size_t>(ResponseCounts::kLearnReplies) + 1);
+  EXPECT_EQ(batches_.back()[0].command, "010C");
+  EXPECT_EQ(batches_.back()[0].lines, reply);
+  auto snapshot = counts.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1u);
+  EXPECT_EQ(snapshot[0].count, 2);
+  EXPECT_EQ(snapshot[0].counted_replies, 1u);
+}
+
+TEST_F(CommandPipelineTest, ChangesTimeoutAheadOfRequests) {
+  AdaptiveTimeouts timeouts;
+  pipeline_.SetAdaptiveTimeouts(&timeouts);
+
+  // The adapter's value is unknown until something sets it
+  Submit({"010C"});
+  pipeline_.OnTimer(Clock::now());
+  EXPECT_EQ(writes_, Lines({"ATST32\r"}));
+  EXPECT_TRUE(pipeline_.OnResponse(MakeResponse({"OK"})));
+  EXPECT_EQ(writes_.back(), "010C\r");
+  pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}));
+  ASSERT_EQ(batches_.size(), 1u);
+  ASSERT_EQ(batches_[0].size(), 1u);
+  EXPECT_EQ(batches_[0][0].lines, Lines({"41 0C 1A F8"}));
+  EXPECT_EQ(timeouts.changes(), 1u);
+
+  // A submitted ATST is followed, so the next request needs no change
+  writes_.clear();
+  Submit({"ATSZ", "ATST64", "010C"});
+  pipeline_.OnTimer(Clock::now());
+  pipeline_.OnResponse(MakeResponse({"?"}));
+  pipeline_.OnResponse(MakeResponse({"OK"}));
+  pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}));
+  EXPECT_EQ(writes_, Lines({"ATSZ\r", "ATST64\r", "010C\r"}));
+  EXPECT_EQ(timeouts.default_counts(), 0x64);
+
+  // A reset makes it unknown again
+  writes_.clear();
+  Submit({"ATZ", "010C"});
+  pipeline_.OnTimer(Clock::now());
+  pipeline_.OnResponse(MakeResponse({"ELM327 v1.4b"}));
+  pipeline_.OnResponse(MakeResponse({"OK"}));
+  pipeline_.OnResponse(MakeResponse({"41 0C 1A F8"}));
+  EXPECT_EQ(writes_, Lines({"ATZ\r", "ATST32\r", "010C\r"}));
+  EXPECT_EQ(timeouts.default_counts(), AdaptiveTimeouts::kDefaultCounts);
+  EXPECT_EQ(batches_.back().size(), 2u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
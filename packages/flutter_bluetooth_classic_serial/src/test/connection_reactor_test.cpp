@@ -0,0 +1,288 @@
+#include "connection_reactor.h"
+
+#include <gtest/gtest.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "socket_pair.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::SocketPair;
+using Clock = std::chrono::steady_clock;
+using ConnectionId = ConnectionReactor::ConnectionId;
+
+// Per-connection delivery counters every handler reports into.
+class Tally {
+ public:
+  explicit Tally(std::size_t connections) : bytes_(connections, 0), closes_(connections, 0) {}
+
+  ConnectionReactor::Handlers HandlersFor(std::size_t index) {
+    ConnectionReactor::Handlers handlers;
+    handlers.on_data = [this, index](const std::uint8_t*, std::size_t length) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bytes_[index] += length;
+      total_bytes_ += length;
+      cv_.notify_all();
+    };
+    handlers.on_closed = [this, index](int) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++closes_[index];
+      ++total_closes_;
+      cv_.notify_all();
+    };
+    return handlers;
+  }
+
+  bool WaitForBytes(std::size_t total) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&]() { return total_bytes_ >= total; });
+  }
+
+  bool WaitForCloses(std::size_t total) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&]() { return total_closes_ >= total; });
+  }
+
+  std::size_t bytes(std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_[index];
+  }
+  int closes(std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closes_[index];
+  }
+  std::size_t total_closes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_closes_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::size_t> bytes_;
+  std::vector<int> closes_;
+  std::size_t total_bytes_ = 0;
+  std::size_t total_closes_ = 0;
+};
+
+std::chrono::nanoseconds ProcessCpuTime() {
+  timespec now = {};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+TEST(ConnectionReactorTest, DeliversEachConnectionsBytesToItsHandler) {
+  constexpr std::size_t kConnections = 8;
+  std::vector<std::unique_ptr<SocketPair>> pairs;
+  Tally tally(kConnections);
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+
+  for (std::size_t i = 0; i < kConnections; ++i) {
+    pairs.push_back(std::make_unique<SocketPair>());
+    ASSERT_NE(reactor.Add(pairs[i]->local, tally.HandlersFor(i)),
+              ConnectionReactor::kInvalidConnection);
+  }
+  EXPECT_EQ(reactor.connection_count(), kConnections);
+
+  // Connection i receives i + 1 bytes.
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < kConnections; ++i) {
+    const std::string data(i + 1, '>');
+    ASSERT_EQ(write(pairs[i]->remote, data.data(), data.size()),
+              static_cast<ssize_t>(data.size()));
+    total += data.size();
+  }
+
+  ASSERT_TRUE(tally.WaitForBytes(total));
+  for (std::size_t i = 0; i < kConnections; ++i) EXPECT_EQ(tally.bytes(i), i + 1);
+}
+
+TEST(ConnectionReactorTest, RemoteCloseIsReportedOnceAndUnregisters) {
+  SocketPair pair;
+  Tally tally(1);
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+  ConnectionId id = reactor.Add(pair.local, tally.HandlersFor(0));
+  ASSERT_TRUE(reactor.IsOpen(id));
+
+  pair.CloseRemote();
+
+  ASSERT_TRUE(tally.WaitForCloses(1));
+  EXPECT_FALSE(reactor.IsOpen(id));
+  EXPECT_FALSE(reactor.Remove(id));
+  EXPECT_EQ(tally.closes(0), 1);
+  EXPECT_EQ(reactor.connection_count(), 0u);
+}
+
+TEST(ConnectionReactorTest, RemoveWaitsForTheRunningHandler) {
+  SocketPair pair;
+  std::atomic<bool> in_handler{false};
+  std::atomic<bool> handler_done{false};
+  std::atomic<int> calls{0};
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+
+  ConnectionReactor::Handlers handlers;
+  handlers.on_data = [&](const std::uint8_t*, std::size_t) {
+    ++calls;
+    in_handler = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    handler_done = true;
+  };
+  ConnectionId id = reactor.Add(pair.local, std::move(handlers));
+
+  ASSERT_EQ(write(pair.remote, "A", 1), 1);
+  while (!in_handler) std::this_thread::yield();
+
+  EXPECT_TRUE(reactor.Remove(id));
+  EXPECT_TRUE(handler_done);
+
+  // Nothing reaches a removed connection's handlers.
+  ASSERT_EQ(write(pair.remote, "B", 1), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(ConnectionReactorTest, HandlerCanRemoveItsOwnConnection) {
+  SocketPair pair;
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+  std::atomic<ConnectionId> id{ConnectionReactor::kInvalidConnection};
+  std::atomic<bool> removed{false};
+
+  ConnectionReactor::Handlers handlers;
+  handlers.on_data = [&](const std::uint8_t*, std::size_t) { removed = reactor.Remove(id); };
+  id = reactor.Add(pair.local, std::move(handlers));
+
+  ASSERT_EQ(write(pair.remote, "A", 1), 1);
+  auto deadline = Clock::now() + std::chrono::seconds(2);
+  while (!removed && Clock::now() < deadline) std::this_thread::yield();
+  EXPECT_TRUE(removed);
+  EXPECT_FALSE(reactor.IsOpen(id));
+}
+
+TEST(ConnectionReactorTest, TimerRunsOnlyWhenDueOrWoken) {
+  SocketPair pair;
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+  std::mutex mutex;
+  std::condition_variable cv;
+  int ticks = 0;
+
+  ConnectionReactor::Handlers handlers;
+  handlers.on_timer = [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++ticks;
+    cv.notify_all();
+    return -1;
+  };
+  ConnectionId id = reactor.Add(pair.local, std::move(handlers));
+
+  auto wait_for_ticks = [&](int count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, std::chrono::seconds(2), [&]() { return ticks >= count; });
+  };
+  // Once after Add(), then not again while idle.
+  ASSERT_TRUE(wait_for_ticks(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(ticks, 1);
+  }
+
+  reactor.Wake(id);
+  EXPECT_TRUE(wait_for_ticks(2));
+  ASSERT_EQ(write(pair.remote, "A", 1), 1);
+  EXPECT_TRUE(wait_for_ticks(3));
+}
+
+TEST(ConnectionReactorTest, ShutdownJoinsWithoutClosedCallbacks) {
+  SocketPair pair;
+  Tally tally(1);
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+  ConnectionId id = reactor.Add(pair.local, tally.HandlersFor(0));
+
+  reactor.Shutdown();
+
+  EXPECT_FALSE(reactor.IsOpen(id));
+  EXPECT_EQ(tally.total_closes(), 0u);
+  EXPECT_EQ(reactor.Add(pair.local, tally.HandlersFor(0)), ConnectionReactor::kInvalidConnection);
+}
+
+// Hundreds of socketpair connections on the one thread: open, exchange a
+// byte, then close half from the remote end and remove the rest, several
+// rounds over. Then measure what idle connections cost and how long a
+// shutdown with all of them registered takes.
+TEST(ConnectionReactorTest, StressOpenCloseHundredsOfConnections) {
+  constexpr std::size_t kConnections = 256;
+  constexpr int kRounds = 4;
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+
+  for (int round = 0; round < kRounds; ++round) {
+    std::vector<std::unique_ptr<SocketPair>> pairs;
+    std::vector<ConnectionId> ids;
+    Tally tally(kConnections);
+    for (std::size_t i = 0; i < kConnections; ++i) {
+      pairs.push_back(std::make_unique<SocketPair>());
+      ASSERT_TRUE(pairs[i]->IsValid());
+      ids.push_back(reactor.Add(pairs[i]->local, tally.HandlersFor(i)));
+      ASSERT_NE(ids[i], ConnectionReactor::kInvalidConnection);
+    }
+    for (const auto& pair : pairs) ASSERT_EQ(write(pair->remote, ">", 1), 1);
+    ASSERT_TRUE(tally.WaitForBytes(kConnections));
+
+    for (std::size_t i = 0; i < kConnections; i += 2) pairs[i]->CloseRemote();
+    for (std::size_t i = 1; i < kConnections; i += 2) EXPECT_TRUE(reactor.Remove(ids[i]));
+    ASSERT_TRUE(tally.WaitForCloses(kConnections / 2));
+
+    for (std::size_t i = 0; i < kConnections; ++i) {
+      EXPECT_EQ(tally.closes(i), i % 2 == 0 ? 1 : 0) << "connection " << i;
+    }
+    EXPECT_EQ(reactor.connection_count(), 0u);
+  }
+
+  std::vector<std::unique_ptr<SocketPair>> idle;
+  Tally tally(kConnections);
+  for (std::size_t i = 0; i < kConnections; ++i) {
+    idle.push_back(std::make_unique<SocketPair>());
+    ASSERT_NE(reactor.Add(idle[i]->local, tally.HandlersFor(i)),
+              ConnectionReactor::kInvalidConnection);
+  }
+  // Let the first timer pass settle before measuring.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  const auto cpu_before = ProcessCpuTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  const auto idle_cpu = ProcessCpuTime() - cpu_before;
+  const auto idle_cpu_ns_per_connection = idle_cpu.count() / static_cast<long long>(kConnections);
+  RecordProperty("idle_cpu_ns_per_connection_per_500ms",
+                 static_cast<int>(idle_cpu_ns_per_connection));
+  // Idle connections never wake the thread; allow for test-process noise.
+  EXPECT_LT(idle_cpu, std::chrono::milliseconds(25));
+
+  const auto shutdown_started = Clock::now();
+  reactor.Shutdown();
+  const auto shutdown_latency =
+      std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - shutdown_started);
+  RecordProperty("shutdown_latency_us", static_cast<int>(shutdown_latency.count()));
+  EXPECT_LT(shutdown_latency, std::chrono::milliseconds(100));
+  EXPECT_EQ(reactor.connection_count(), 0u);
+  EXPECT_EQ(tally.total_closes(), 0u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,272 @@
+#include "device_discovery.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using std::chrono::milliseconds;
+using Clock = DiscoveryBackend::Clock;
+
+DeviceRecord Device(const std::string& address, const std::string& name, bool paired = false) {
+  DeviceRecord device;
+  device.address = address;
+  device.name = name;
+  device.paired = paired;
+  return device;
+}
+
+// Simulated radio. Each inquiry round returns the next scripted list, and
+// rounds block until the test releases them when |gated| is set.
+class FakeRadio : public DiscoveryBackend {
+ public:
+  Clock::time_point Now() override { return now_; }
+  void Advance(milliseconds by) { now_ += by; }
+
+  RadioInfo QueryRadio() override {
+    ++radio_queries;
+    RadioInfo info;
+    info.present = true;
+    info.enabled = true;
+    return info;
+  }
+
+  std::vector<DeviceRecord> ListKnownDevices() override {
+    ++known_queries;
+    return known;
+  }
+
+  void Inquire(const DeviceHandler& on_device) override {
+    std::vector<DeviceRecord> round;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++rounds_started_;
+      changed_.notify_all();
+      changed_.wait_for(lock, std::chrono::seconds(5), [&] { return !gated || released_ > 0; });
+      if (gated) --released_;
+      if (!rounds.empty()) {
+        round = rounds.front();
+        rounds.erase(rounds.begin());
+      }
+    }
+    for (const auto& device : round) {
+      if (!on_device(device)) return;
+    }
+  }
+
+  void ReleaseRound() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++released_;
+    changed_.notify_all();
+  }
+
+  void WaitForRound(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait_for(lock, std::chrono::seconds(5), [&] { return rounds_started_ >= count; });
+  }
+
+  std::vector<DeviceRecord> known;
+  std::vector<std::vector<DeviceRecord>> rounds;
+  bool gated = false;
+  int radio_queries = 0;
+  int known_queries = 0;
+
+ private:
+  Clock::time_point now_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  int rounds_started_ = 0;
+  int released_ = 0;
+};
+
+// Collects reports from the worker thread.
+class Collector {
+ public:
+  DeviceDiscovery::FoundHandler OnFound() {
+    return [this](const DeviceRecord& device) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      devices_.push_back(device);
+      changed_.notify_all();
+    };
+  }
+  DeviceDiscovery::FinishedHandler OnFinished() {
+    return [this]() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+      changed_.notify_all();
+    };
+  }
+
+  bool WaitForDevices(std::size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, std::chrono::seconds(5),
+                             [&] { return devices_.size() >= count; });
+  }
+  bool WaitFinished() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return changed_.wait_for(lock, std::chrono::seconds(5), [&] { return finished_; });
+  }
+
+  std::vector<DeviceRecord> devices() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_;
+  }
+  bool finished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<DeviceRecord> devices_;
+  bool finished_ = false;
+};
+
+TEST(DeviceDiscoveryTest, KnownDevicesArriveBeforeTheInquiryReturns) {
+  FakeRadio radio;
+  radio.gated = true;
+  radio.known = {Device("00:1D:A5:00:00:01", "OBDLink MX+", true)};
+  radio.rounds = {{Device("00:1D:A5:00:00:02", "OBDII")}};
+  DeviceDiscovery discovery(&radio);
+  Collector collector;
+
+  DiscoveryOptions options;
+  options.inquiry_rounds = 1;
+  ASSERT_TRUE(discovery.Start(options, collector.OnFound(), collector.OnFinished()));
+  ASSERT_TRUE(collector.WaitForDevices(1));
+  radio.WaitForRound(1);
+  // The inquiry is still running, but the paired adapter is already out
+  EXPECT_EQ(collector.devices().size(), 1u);
+  EXPECT_TRUE(collector.devices()[0].paired);
+  EXPECT_TRUE(discovery.IsDiscovering());
+
+  radio.ReleaseRound();
+  ASSERT_TRUE(collector.WaitFinished());
+  ASSERT_EQ(collector.devices().size(), 2u);
+  EXPECT_EQ(collector.devices()[1].name, "OBDII");
+  EXPECT_FALSE(discovery.IsDiscovering());
+  EXPECT_EQ(discovery.found().size(), 2u);
+}
+
+TEST(DeviceDiscoveryTest, RepeatSightingsAreReportedOnlyWhenTheyChange) {
+  FakeRadio radio;
+  radio.known = {Device("00:1D:A5:00:00:01", "OBDLink MX+", true)};
+  radio.rounds = {
+      {Device("00:1D:A5:00:00:01", ""), Device("AA:BB:CC:00:00:02", "")},
+      {Device("AA:BB:CC:00:00:02", "Vgate iCar")},
+      {Device("AA:BB:CC:00:00:02", ""), Device("00:1D:A5:00:00:01", "OBDLink MX+", true)},
+  };
+  DeviceDiscovery discovery(&radio);
+  Collector collector;
+
+  DiscoveryOptions options;
+  options.inquiry_rounds = 3;
+  ASSERT_TRUE(discovery.Start(options, collector.OnFound(), collector.OnFinished()));
+  ASSERT_TRUE(collector.WaitFinished());
+
+  // The bare inquiry sightings of the paired device add nothing, and the
+  // second device is reported again once its name is known
+  auto devices = collector.devices();
+  ASSERT_EQ(devices.size(), 3u);
+  EXPECT_EQ(devices[0].name, "OBDLink MX+");
+  EXPECT_EQ(devices[1].address, "AA:BB:CC:00:00:02");
+  EXPECT_EQ(devices[1].name, "");
+  EXPECT_EQ(devices[2].name, "Vgate iCar");
+
+  auto found = discovery.found();
+  ASSERT_EQ(found.size(), 2u);
+  EXPECT_EQ(found[1].name, "Vgate iCar");
+}
+
+TEST(DeviceDiscoveryTest, StopEndsTheSessionWithoutWaitingForTheInquiry) {
+  FakeRadio radio;
+  radio.gated = true;
+  radio.rounds = {{Device("AA:BB:CC:00:00:02", "OBDII")}};
+  Collector collector;
+  Collector next;
+  {
+    DeviceDiscovery discovery(&radio);
+    ASSERT_TRUE(discovery.Start(DiscoveryOptions(), collector.OnFound(), collector.OnFinished()));
+    radio.WaitForRound(1);
+    discovery.Stop();
+    EXPECT_FALSE(discovery.IsDiscovering());
+
+    // The next session runs while the stopped one is still in its round
+    radio.known = {Device("00:1D:A5:00:00:01", "OBDLink MX+", true)};
+    DiscoveryOptions options;
+    options.inquiry_rounds = 0;
+    ASSERT_TRUE(discovery.Start(options, next.OnFound(), next.OnFinished()));
+    ASSERT_TRUE(next.WaitFinished());
+
+    // That round returns a device after the stop: reported to neither
+    radio.ReleaseRound();
+  }
+
+  EXPECT_TRUE(collector.devices().empty());
+  EXPECT_FALSE(collector.finished());
+  ASSERT_EQ(next.devices().size(), 1u);
+  EXPECT_EQ(next.devices()[0].name, "OBDLink MX+");
+}
+
+TEST(DeviceDiscoveryTest, StartWhileDiscoveringIsRejected) {
+  FakeRadio radio;
+  radio.gated = true;
+  DeviceDiscovery discovery(&radio);
+  Collector collector;
+
+  ASSERT_TRUE(discovery.Start(DiscoveryOptions(), collector.OnFound()));
+  EXPECT_FALSE(discovery.Start(DiscoveryOptions(), collector.OnFound()));
+  discovery.Stop();
+  radio.ReleaseRound();
+}
+
+TEST(DeviceCacheTest, RepeatQueriesAreServedFromTheCache) {
+  FakeRadio radio;
+  radio.known = {Device("00:1D:A5:00:00:01", "OBDLink MX+", true)};
+  DeviceCache cache(&radio, milliseconds(30000));
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(cache.Radio().enabled);
+    EXPECT_EQ(cache.KnownDevices().size(), 1u);
+  }
+  EXPECT_EQ(radio.radio_queries, 1);
+  EXPECT_EQ(radio.known_queries, 1);
+  EXPECT_EQ(cache.stats().refreshes, 2u);
+  EXPECT_EQ(cache.stats().hits, 198u);
+
+  // Invalidation and age both send the next query to the radio
+  radio.known.push_back(Device("AA:BB:CC:00:00:02", "Vgate iCar", true));
+  cache.Invalidate();
+  EXPECT_EQ(cache.KnownDevices().size(), 2u);
+  EXPECT_EQ(radio.known_queries, 2);
+  radio.Advance(milliseconds(30000));
+  cache.Radio();
+  EXPECT_EQ(radio.radio_queries, 2);
+}
+
+TEST(DeviceCacheTest, DiscoveryRefreshesTheKnownDevices) {
+  FakeRadio radio;
+  DeviceCache cache(&radio);
+  EXPECT_TRUE(cache.KnownDevices().empty());
+
+  radio.known = {Device("00:1D:A5:00:00:01", "OBDLink MX+", true)};
+  DeviceDiscovery discovery(&radio, &cache);
+  Collector collector;
+  DiscoveryOptions options;
+  options.inquiry_rounds = 0;
+  ASSERT_TRUE(discovery.Start(options, collector.OnFound(), collector.OnFinished()));
+  ASSERT_TRUE(collector.WaitFinished());
+
+  EXPECT_EQ(cache.KnownDevices().size(), 1u);
+  EXPECT_EQ(radio.known_queries, 2);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
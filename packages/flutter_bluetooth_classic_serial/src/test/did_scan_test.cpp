@@ -0,0 +1,214 @@
+#include "did_scan.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "elm327_emulator.h"
+#include "emulated_adapter.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::EmulatedAdapter;
+using Clock = DidScan::Clock;
+using Lines = std::vector<std::string>;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+// The app's DID ranges: powertrain, enhanced, body, UDS and manufacturer.
+const std::vector<DidScan::Range> kRanges = {
+    {0x0100, 0x02FF}, {0xA000, 0xA0FF}, {0xB000, 0xB0FF}, {0xF100, 0xF2FF}, {0xFD00, 0xFDFF}};
+
+// Bluetooth both ways and the adapter's UART, per exchange.
+constexpr microseconds kLinkLatency(8000);
+
+CommandResult Reply(const std::string& command, Lines lines,
+                    CommandResult::Status status = CommandResult::Status::kOk) {
+  CommandResult result;
+  result.command = command;
+  result.status = status;
+  result.lines = std::move(lines);
+  return result;
+}
+
+// Drives |scan| through |adapter| two chunks at a time, as the plugin does.
+struct Driver {
+  void Submit() {
+    std::vector<std::string> chunk = scan->NextChunk();
+    if (chunk.empty()) return;
+    adapter->pipeline().SubmitRaw(std::move(chunk), milliseconds(1000),
+                                  [this](std::vector<CommandResult>&& results) {
+                                    if (scan->Observe(results, Clock::now(), &answers)) {
+                                      done = true;
+                                    } else {
+                                      Submit();
+                                    }
+                                  });
+  }
+
+  void Run(const std::vector<DidScan::Range>& ranges) {
+    scan->Start(ranges, Clock::now());
+    Submit();
+    Submit();
+    adapter->Run();
+  }
+
+  DidScan* scan = nullptr;
+  EmulatedAdapter* adapter = nullptr;
+  std::vector<DidAnswer> answers{};
+  bool done = false;
+};
+
+const DidAnswer* FindAnswer(const std::vector<DidAnswer>& answers, std::uint16_t did) {
+  for (const auto& answer : answers) {
+    if (answer.did == did) return &answer;
+  }
+  return nullptr;
+}
+
+TEST(DidScanTest, ScansEveryRangeThroughTheAdapter) {
+  // The engine has DIDs A09F and F190; it and the TCM answer 7F 22 31 to
+  // the rest
+  EmulatedAdapter adapter(RamCumminsProfile(), kLinkLatency);
+  DidScan scan;
+  Driver driver{&scan, &adapter};
+  driver.Run(kRanges);
+  ASSERT_TRUE(driver.done);
+
+  const DidScanProgress progress = scan.Progress(Clock::now());
+  EXPECT_FALSE(progress.running);
+  EXPECT_FALSE(progress.stopped);
+  EXPECT_EQ(progress.total, 1792u);
+  EXPECT_EQ(progress.probed, progress.total);
+  EXPECT_EQ(progress.supported, 2u);
+  EXPECT_EQ(progress.absent, 1790u);
+  EXPECT_EQ(progress.count, 2);
+  EXPECT_EQ(scan.state(0xA09F), DidState::kSupported);
+  EXPECT_EQ(scan.state(0xF190), DidState::kSupported);
+  EXPECT_EQ(scan.state(0xF191), DidState::kAbsent);
+  EXPECT_EQ(scan.state(0x0300), DidState::kUnknown);
+
+  ASSERT_EQ(driver.answers.size(), 2u);
+  const DidAnswer* vin = FindAnswer(driver.answers, 0xF190);
+  ASSERT_NE(vin, nullptr);
+  EXPECT_EQ(vin->ecu, "18DAF110");
+  EXPECT_EQ(std::string(vin->bytes.begin(), vin->bytes.end()), "3C6UR5DL1TG100001");
+  EXPECT_EQ(FindAnswer(driver.answers, 0xA09F)->bytes, (std::vector<std::uint8_t>{0x12, 0x34}));
+
+  // Three DIDs a request, with the count once both ECUs were heard four
+  // times; the DIDs of a request that found something are asked singly
+  const Lines& writes = adapter.writes();
+  EXPECT_EQ(writes.front(), "22010001010102\r");
+  EXPECT_NE(std::find(writes.begin(), writes.end(), "22A09DA09EA09F2\r"), writes.end());
+  EXPECT_NE(std::find(writes.begin(), writes.end(), "22A09F2\r"), writes.end());
+  EXPECT_LT(writes.size(), 610u);
+  // Tens of seconds for what takes minutes one open-ended request at a time
+  EXPECT_LT(adapter.elapsed(), std::chrono::seconds(40));
+
+  EmulatedAdapter single(RamCumminsProfile(), kLinkLatency);
+  for (const auto& range : kRanges) {
+    for (int did = range.first; did <= range.second; ++did) {
+      char command[8];
+      std::snprintf(command, sizeof(command), "22%04X", did);
+      single.pipeline().Submit({command}, milliseconds(1000), nullptr);
+      single.Run();
+    }
+  }
+  EXPECT_GT(single.elapsed(), std::chrono::seconds(100));
+}
+
+TEST(DidScanTest, ResumesFromItsBitmap) {
+  EmulatedAdapter adapter(RamCumminsProfile(), kLinkLatency);
+  DidScan scan;
+  Driver driver{&scan, &adapter};
+  driver.Run({{0xF180, 0xF19F}});
+  ASSERT_TRUE(driver.done);
+
+  DidScan resumed;
+  EXPECT_FALSE(resumed.Load({1, 2, 3}));
+  ASSERT_TRUE(resumed.Load(scan.Bitmap()));
+  EXPECT_EQ(resumed.state(0xF190), DidState::kSupported);
+  // Nothing left to probe in what was scanned; only the new DIDs of a
+  // wider range, overlaps once
+  EXPECT_EQ(resumed.Start({{0xF180, 0xF19F}}, Clock::now()), 0u);
+  EXPECT_FALSE(resumed.running());
+  EXPECT_EQ(resumed.Start({{0xF170, 0xF1AF}, {0xF1A0, 0xF1A3}}, Clock::now()), 32u);
+  EXPECT_EQ(resumed.NextChunk().front(), "22F170F171F172");
+}
+
+TEST(DidScanTest, AsksAgainUntilAReplySettlesTheDid) {
+  DidScan scan;
+  ASSERT_EQ(scan.Start({{0x0100, 0x0102}}, Clock::now()), 3u);
+  std::vector<std::string> chunk = scan.NextChunk();
+  ASSERT_EQ(chunk, (Lines{"22010001010102"}));
+
+  // Response pending settles nothing; the DIDs are asked for singly
+  std::vector<DidAnswer> answers;
+  EXPECT_FALSE(scan.Observe({Reply(chunk[0], {"18DAF110037F2278AAAAAAAA"})}, Clock::now(),
+                            &answers));
+  chunk = scan.NextChunk();
+  ASSERT_EQ(chunk, (Lines{"220100", "220101", "220102"}));
+  EXPECT_FALSE(scan.Observe({Reply(chunk[0], {"18DAF11005620100AABBAAAA"}),
+                             Reply(chunk[1], {"18DAF118037F2233AAAAAAAA"}),
+                             Reply(chunk[2], {}, CommandResult::Status::kTimedOut)},
+                            Clock::now(), &answers));
+  ASSERT_EQ(answers.size(), 2u);
+  EXPECT_EQ(answers[0].bytes, (std::vector<std::uint8_t>{0xAA, 0xBB}));
+  EXPECT_EQ(answers[1].ecu, "18DAF118");
+  EXPECT_EQ(answers[1].nrc, 0x33);
+
+  // Up to kMaxAttempts tries, then it stays unknown for the next scan
+  for (int attempt = 1; attempt < DidScan::kMaxAttempts; ++attempt) {
+    chunk = scan.NextChunk();
+    ASSERT_EQ(chunk, (Lines{"220102"}));
+    const bool done = scan.Observe({Reply(chunk[0], {"BUS BUSY"})}, Clock::now(), &answers);
+    EXPECT_EQ(done, attempt + 1 == DidScan::kMaxAttempts);
+  }
+  EXPECT_EQ(scan.state(0x0100), DidState::kSupported);
+  EXPECT_EQ(scan.state(0x0101), DidState::kRefused);
+  EXPECT_EQ(scan.state(0x0102), DidState::kUnknown);
+  const DidScanProgress progress = scan.Progress(Clock::now());
+  EXPECT_EQ(progress.probed, 3u);
+  EXPECT_EQ(progress.supported, 1u);
+  EXPECT_EQ(progress.refused, 1u);
+  EXPECT_EQ(progress.requests, 6u);
+
+  // A cancelled request ends the run with what it has
+  ASSERT_EQ(scan.Start({{0x0200, 0x0205}}, Clock::now()), 6u);
+  chunk = scan.NextChunk();
+  ASSERT_EQ(chunk.size(), 2u);
+  EXPECT_TRUE(scan.Observe({Reply(chunk[0], {"18DAF110037F2231AAAAAAAA"}),
+                            Reply(chunk[1], {}, CommandResult::Status::kCancelled)},
+                           Clock::now(), &answers));
+  EXPECT_TRUE(scan.Progress(Clock::now()).stopped);
+  EXPECT_EQ(scan.state(0x0202), DidState::kAbsent);
+  EXPECT_EQ(scan.state(0x0203), DidState::kUnknown);
+}
+
+TEST(DidScanTest, AsksForOneDidAtATimeWhereEcusWantThat) {
+  EmulatorProfile profile = RamCumminsProfile();
+  profile.ecus[1].mode22_multi = false;
+  EmulatedAdapter adapter(profile, kLinkLatency);
+  DidScan scan;
+  Driver driver{&scan, &adapter};
+  driver.Run({{0xA090, 0xA0AF}});
+  ASSERT_TRUE(driver.done);
+
+  EXPECT_EQ(scan.state(0xA09F), DidState::kSupported);
+  EXPECT_EQ(scan.state(0xA0A0), DidState::kAbsent);
+  EXPECT_EQ(scan.Progress(Clock::now()).absent, 31u);
+  // The TCM answers 7F 22 13 to the grouped requests, which were all
+  // under way; each of their DIDs is asked again on its own
+  const Lines& writes = adapter.writes();
+  EXPECT_EQ(std::count_if(writes.begin(), writes.end(),
+                          [](const std::string& line) { return line.size() <= 8; }),
+            32);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
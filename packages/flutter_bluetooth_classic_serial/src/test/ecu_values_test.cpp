@@ -0,0 +1,214 @@
+#include "ecu_values.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_emulator.h"
+#include "emulated_adapter.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::EmulatedAdapter;
+using Clock = EcuValues::Clock;
+using Lines = std::vector<std::string>;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+CommandResult Reply(const std::string& command, Lines lines, Clock::time_point at = Clock::now()) {
+  CommandResult result;
+  result.command = command;
+  result.lines = std::move(lines);
+  result.completed_at = at;
+  return result;
+}
+
+const EcuReading* Find(const std::vector<EcuValueStats>& snapshot, const std::string& command,
+                       const std::string& ecu) {
+  for (const auto& stats : snapshot) {
+    if (stats.command != command) continue;
+    for (const auto& reading : stats.ecus) {
+      if (reading.ecu == ecu) return &reading;
+    }
+  }
+  return nullptr;
+}
+
+TEST(EcuValuesTest, KeepsEachEcusValueAndPicksOneByPolicy) {
+  EcuValues values;
+  const Clock::time_point at = Clock::now();
+  // Battery voltage from the engine (14.0 V), the TCM (12.5 V) and a body
+  // module (13.8 V)
+  const Lines voltages = {"18DAF11004414236B0AAAAAA", "18DAF11804414230D4AAAAAA",
+                          "18DAF14004414235E8AAAAAA"};
+  values.Observe("0142", false, Reply("0142", voltages, at));
+
+  double value = 0;
+  std::string ecu;
+  // No owner and no preference: the most recent, here the first heard
+  ASSERT_TRUE(values.Select("0142", at, &value, &ecu));
+  EXPECT_EQ(ecu, "18DAF110");
+  values.SetPolicy("0142", EcuPolicy::kPreferred, "18DAF118");
+  ASSERT_TRUE(values.Select("0142", at, &value, &ecu));
+  EXPECT_DOUBLE_EQ(value, 12.5);
+  values.SetPolicy("0142", EcuPolicy::kMax);
+  ASSERT_TRUE(values.Select("0142", at, &value, &ecu));
+  EXPECT_DOUBLE_EQ(value, 14.0);
+  EXPECT_EQ(ecu, "18DAF110");
+  values.SetPolicy("0142", EcuPolicy::kConsensus);
+  ASSERT_TRUE(values.Select("0142", at, &value, &ecu));
+  EXPECT_DOUBLE_EQ(value, 13.8);
+
+  // Stale readings are not picked
+  EXPECT_FALSE(values.Select("0142", at + seconds(6), &value));
+  EXPECT_FALSE(values.Select("010C", at, &value));
+
+  // A packed request fills each of its PIDs
+  values.Observe("010C0D", false, Reply("010C0D", {"18DAF11006410C1AF80D37AA"}, at));
+  ASSERT_TRUE(values.Select("010C", at, &value));
+  EXPECT_DOUBLE_EQ(value, 1726);
+  ASSERT_TRUE(values.Select("010D", at, &value));
+  EXPECT_DOUBLE_EQ(value, 55);
+}
+
+TEST(EcuValuesTest, CountsFailuresPerEcu) {
+  EcuValues values;
+  values.Observe("010C", false,
+                 Reply("010C", {"18DAF11004410C1AF8AAAAAA", "18DAF118037F0112AAAAAAAA"}));
+  auto snapshot = values.Snapshot(Clock::now());
+  const EcuReading* engine = Find(snapshot, "010C", "18DAF110");
+  const EcuReading* tcm = Find(snapshot, "010C", "18DAF118");
+  ASSERT_TRUE(engine && tcm);
+  EXPECT_TRUE(engine->has_value);
+  EXPECT_EQ(engine->failures, 0);
+  EXPECT_EQ(engine->answers, 1u);
+  EXPECT_FALSE(tcm->has_value);
+  EXPECT_EQ(tcm->failures, 1);
+  EXPECT_EQ(tcm->nrc, 0x12);
+
+  // Nobody answered: every known ECU failed once more
+  values.Observe("010C", false, Reply("010C", {"NO DATA"}));
+  CommandResult timeout = Reply("010C", {});
+  timeout.status = CommandResult::Status::kTimedOut;
+  values.Observe("010C", false, timeout);
+  snapshot = values.Snapshot(Clock::now());
+  EXPECT_EQ(Find(snapshot, "010C", "18DAF110")->failures, 2);
+  EXPECT_EQ(Find(snapshot, "010C", "18DAF118")->failures, 3);
+  // The last value is kept
+  EXPECT_TRUE(Find(snapshot, "010C", "18DAF110")->has_value);
+}
+
+TEST(EcuValuesTest, RoutesRequestsToTheEcuThatOwnsThem) {
+  EcuValues values;
+  const Lines rpm = {"18DAF11004410C1AF8AAAAAA", "18DAF118037F0112AAAAAAAA"};
+  // Routing off, nor while the owner is being learned: no header of its own
+  values.Observe("010C", false, Reply("010C", rpm));
+  EXPECT_EQ(values.Route("010C"), "");
+  values.Reset();
+  values.SetRouting(true);
+  for (int i = 0; i < EcuValues::kLearnReplies; ++i) {
+    EXPECT_EQ(values.Route("010C"), "");
+    values.Observe("010C", false, Reply("010C", rpm));
+  }
+  EXPECT_EQ(values.Route("010C"), "DA10F1");
+  EXPECT_EQ(values.Route("ATRV"), "");
+  ASSERT_EQ(values.Snapshot(Clock::now())[0].owner, "18DAF110");
+
+  // Battery voltage takes every ECU's answer, so it is never routed
+  values.SetPolicy("0142", EcuPolicy::kMax);
+  for (int i = 0; i < EcuValues::kLearnReplies; ++i) {
+    values.Observe("0142", false, Reply("0142", {"18DAF11004414236B0AAAAAA"}));
+  }
+  EXPECT_EQ(values.Route("0142"), "");
+
+  // Routed, only the owner is asked; its silence sends the request back
+  values.Observe("010C", true, Reply("010C", {"18DAF11004410C1AF8AAAAAA"}));
+  EXPECT_EQ(Find(values.Snapshot(Clock::now()), "010C", "18DAF118")->failures, 3);
+  for (int i = 0; i < EcuValues::kMaxMisses; ++i) {
+    EXPECT_EQ(values.Route("010C"), "DA10F1");
+    values.Observe("010C", true, Reply("010C", {"NO DATA"}));
+  }
+  EXPECT_EQ(values.Route("010C"), "");
+
+  // 11-bit IDs route to 7E0-7E7; an adapter without ATSH turns routing off
+  values.Reset();
+  for (int i = 0; i < EcuValues::kLearnReplies; ++i) {
+    values.Observe("010D", false, Reply("010D", {"7E9 03 41 0D 37"}));
+  }
+  EXPECT_EQ(values.Route("010D"), "7E1");
+  values.ObserveRoute(false);
+  EXPECT_FALSE(values.routing());
+  EXPECT_EQ(values.Route("010D"), "");
+}
+
+TEST(EcuValuesTest, PhysicalAddressingSilencesEcusWithoutThePid) {
+  // The engine answers every PID; the TCM answers 7F 01 12 to each
+  EmulatedAdapter adapter(RamCumminsProfile());
+  CommandPipeline& pipeline = adapter.pipeline();
+  const Lines& writes = adapter.writes();
+  EcuValues values;
+  values.SetRouting(true);
+  pipeline.SetEcuValues(&values);
+
+  std::vector<CommandResult> results;
+  const Lines dashboard = {"010C", "010D", "0105"};
+  for (int pass = 0; pass < EcuValues::kLearnReplies + 2; ++pass) {
+    pipeline.Submit(dashboard, milliseconds(1000), [&results](std::vector<CommandResult>&& batch) {
+      for (auto& result : batch) results.push_back(std::move(result));
+    });
+    adapter.Run();
+  }
+  ASSERT_EQ(results.size(), dashboard.size() * (EcuValues::kLearnReplies + 2));
+
+  // One header change, once the owner was learned; after it, only the
+  // engine answers
+  EXPECT_EQ(values.header_changes(), 1u);
+  EXPECT_EQ(std::count(writes.begin(), writes.end(), "ATSHDA10F1\r"), 1);
+  const CommandResult& routed = results.back();
+  EXPECT_EQ(routed.command, "0105");
+  ASSERT_EQ(routed.lines.size(), 1u);
+  EXPECT_EQ(routed.lines[0].compare(0, 8, "18DAF110"), 0);
+  double value = 0;
+  ASSERT_TRUE(values.Select("0105", Clock::now(), &value));
+  EXPECT_NEAR(value, 181.4, 0.01);  // 83 C
+
+  // A reset puts the functional header back; the next routed request sets
+  // it again
+  pipeline.Submit({"ATZ", "010C"}, milliseconds(1000), nullptr);
+  adapter.Run();
+  EXPECT_EQ(std::count(writes.begin(), writes.end(), "ATSHDA10F1\r"), 2);
+}
+
+TEST(EcuValuesTest, LeavesAHeaderTheAppSetAlone) {
+  EmulatedAdapter adapter(RamCumminsProfile());
+  CommandPipeline& pipeline = adapter.pipeline();
+  const Lines& writes = adapter.writes();
+  EcuValues values;
+  pipeline.SetEcuValues(&values);
+  pipeline.Submit({"010C", "010C"}, milliseconds(1000), nullptr);
+  adapter.Run();
+
+  // Both ECUs heard, routing off: the engine's header stays for its DIDs
+  pipeline.Submit({"ATSHDA10F1", "22A09F", "010C"}, milliseconds(1000), nullptr);
+  adapter.Run();
+  pipeline.SubmitRaw({"22F190"}, milliseconds(1000), nullptr);
+  adapter.Run();
+  EXPECT_EQ(writes.back(), "22F190\r");
+
+  // With routing on, a request without an owner keeps it too
+  values.SetRouting(true);
+  pipeline.Submit({"010D"}, milliseconds(1000), nullptr);
+  adapter.Run();
+  for (const auto& line : writes) {
+    EXPECT_TRUE(line.compare(0, 4, "ATSH") != 0 || line == "ATSHDA10F1\r") << line;
+  }
+  EXPECT_EQ(values.header_changes(), 0u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
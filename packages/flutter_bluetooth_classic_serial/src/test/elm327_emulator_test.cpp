@@ -0,0 +1,353 @@
+#include "elm327_emulator.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_framer.h"
+#include "emulator_link.h"
+#include "receive_loop.h"
+#include "socket_pair.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::SocketPair;
+using Clock = std::chrono::steady_clock;
+using Lines = std::vector<std::string>;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+std::string Text(const EmulatorReply& reply) {
+  std::string text;
+  for (const auto& chunk : reply.chunks) text += chunk.text;
+  return text;
+}
+
+// The Ram profile without jitter, with ECUs at 25 and 32 ms.
+EmulatorProfile QuietProfile() {
+  EmulatorProfile profile = RamCumminsProfile();
+  for (auto& ecu : profile.ecus) ecu.latency.jitter = microseconds(0);
+  return profile;
+}
+
+// Runs the app's init sequence (echo, linefeeds and spaces off, headers on,
+// CAN 29-bit 500k), then |extra|.
+void Init(Elm327Emulator* emulator, const Lines& extra = {}) {
+  for (const auto& command : {"ATZ", "ATE0", "ATL0", "ATS0", "ATH1", "ATAT1", "ATSP7"}) {
+    emulator->Execute(command);
+  }
+  for (const auto& command : extra) emulator->Execute(command);
+}
+
+TEST(Elm327EmulatorTest, AnswersTheAppsAtCommands) {
+  Elm327Emulator emulator(QuietProfile());
+  EXPECT_EQ(Text(emulator.Execute("ATZ")), "ATZ\r\r\nELM327 v1.4b\r\n\r\n>");
+  EXPECT_EQ(Text(emulator.Execute("ATE0")), "ATE0\rOK\r\n\r\n>");
+  EXPECT_EQ(Text(emulator.Execute("ATL0")), "OK\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("ATS0")), "OK\r\r>");
+  for (const auto& command : {"ATH1", "ATAT1", "ATSP0", "ATST64", "ATSTFF", "AT SP A7"}) {
+    EXPECT_EQ(Text(emulator.Execute(command)), "OK\r\r>") << command;
+  }
+  EXPECT_EQ(Text(emulator.Execute("AT RV")), "12.6V\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("AT@1")), "OBDLink MX+\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("ATDPN")), "7\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("ATXYZ")), "?\r\r>");
+
+  EXPECT_FALSE(emulator.sleeping());
+  EXPECT_EQ(Text(emulator.Execute("AT LP")), "OK\r\r>");
+  EXPECT_TRUE(emulator.sleeping());
+}
+
+TEST(Elm327EmulatorTest, MultiEcuRepliesWith29BitHeaders) {
+  Elm327Emulator emulator(QuietProfile());
+  Init(&emulator);
+
+  EmulatorReply reply = emulator.Execute("010C");
+  EXPECT_EQ(Text(reply), "18DAF11004410C1AF8\r18DAF118037F0112\r\r>");
+  ASSERT_EQ(reply.chunks.size(), 3u);
+  EXPECT_EQ(reply.chunks[0].at, milliseconds(25));
+  EXPECT_EQ(reply.chunks[1].at, milliseconds(32));
+  // ATAT1 waits the adaptive time after the last reply
+  EXPECT_EQ(reply.chunks[2].at, milliseconds(52));
+
+  emulator.Execute("ATS1");
+  EXPECT_EQ(Text(emulator.Execute("010D")),
+            "18 DA F1 10 03 41 0D 37\r18 DA F1 18 03 7F 01 12\r\r>");
+  emulator.Execute("ATH0");
+  EXPECT_EQ(Text(emulator.Execute("0105")), "41 05 7B\r7F 01 12\r\r>");
+}
+
+TEST(Elm327EmulatorTest, ElevenBitHeadersOnProtocolSix) {
+  EmulatorProfile profile = QuietProfile();
+  profile.vehicle_protocol = 6;
+  Elm327Emulator emulator(profile);
+  Init(&emulator, {"ATSP6", "ATS1"});
+  EXPECT_EQ(Text(emulator.Execute("010C")), "7E8 04 41 0C 1A F8\r7E9 03 7F 01 12\r\r>");
+}
+
+TEST(Elm327EmulatorTest, WrongProtocolsFail) {
+  Elm327Emulator emulator(QuietProfile());
+  Init(&emulator, {"ATSP6"});
+  EXPECT_EQ(Text(emulator.Execute("0100")), "NO DATA\r\r>");
+  emulator.Execute("ATSP9");
+  EXPECT_EQ(Text(emulator.Execute("0100")), "CAN ERROR\r\r>");
+
+  emulator.Execute("ATSP0");
+  EmulatorReply reply = emulator.Execute("0100");
+  EXPECT_EQ(reply.chunks[0].text, "SEARCHING...\r");
+  EXPECT_NE(Text(reply).find("18DAF110064100"), std::string::npos) << Text(reply);
+  EXPECT_EQ(Text(emulator.Execute("ATDP")), "AUTO, ISO 15765-4 (CAN 29/500)\r\r>");
+}
+
+TEST(Elm327EmulatorTest, SupportBitmapsFollowTheConfiguredPids) {
+  EmulatorProfile profile = QuietProfile();
+  profile.ecus.resize(1);
+  profile.ecus[0].mode01 = {{0x0C, {0x1A, 0xF8}}, {0x0D, {0x37}}, {0x42, {0x36, 0xB0}}};
+  Elm327Emulator emulator(profile);
+  Init(&emulator, {"ATH0"});
+
+  // 0C and 0D, plus bit 0x20 because a later range has PIDs
+  EXPECT_EQ(Text(emulator.Execute("0100")), "410000180001\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("0120")), "412000000001\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("0140")), "414040000000\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("0160")), "NO DATA\r\r>");
+}
+
+TEST(Elm327EmulatorTest, MultiPidAndVinRepliesUseIsoTpFrames) {
+  Elm327Emulator emulator(QuietProfile());
+  Init(&emulator, {"ATS1", "ATH0"});
+
+  EXPECT_EQ(Text(emulator.Execute("010C0D05")),
+            "008\r0: 41 0C 1A F8 0D 37\r1: 05 7B\r7F 01 12\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("0902")),
+            "014\r0: 49 02 01 33 43 36\r1: 55 52 35 44 4C 31 54\r2: 47 31 30 30 30 30 31\r\r>");
+
+  emulator.Execute("ATH1");
+  EXPECT_EQ(Text(emulator.Execute("0902")),
+            "18 DA F1 10 10 14 49 02 01 33 43 36\r"
+            "18 DA F1 10 21 55 52 35 44 4C 31 54\r"
+            "18 DA F1 10 22 47 31 30 30 30 30 31\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("010C0D05")),
+            "18 DA F1 10 10 08 41 0C 1A F8 0D 37\r"
+            "18 DA F1 10 21 05 7B 00 00 00 00 00\r"
+            "18 DA F1 18 03 7F 01 12\r\r>");
+}
+
+TEST(Elm327EmulatorTest, Mode22AndPhysicalAddressing) {
+  Elm327Emulator emulator(QuietProfile());
+  Init(&emulator, {"ATH0"});
+  EXPECT_EQ(Text(emulator.Execute("22A09F")), "62A09F1234\r7F2231\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("22BEEF")), "7F2231\r7F2231\r\r>");
+
+  EXPECT_EQ(Text(emulator.Execute("ATSHDA10F1")), "OK\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("22A09F")), "62A09F1234\r\r>");
+  emulator.Execute("ATSH18DA18F1");
+  EXPECT_EQ(Text(emulator.Execute("010C")), "7F0112\r\r>");
+  emulator.Execute("ATSH18DB33F1");
+  EXPECT_EQ(Text(emulator.Execute("010C")), "410C1AF8\r7F0112\r\r>");
+}
+
+TEST(Elm327EmulatorTest, ResponseCountAndTimeoutEndTheWait) {
+  EmulatorProfile profile = QuietProfile();
+  profile.ecus[1].latency.base = milliseconds(80);
+  Elm327Emulator emulator(profile);
+  Init(&emulator, {"ATAT0", "ATST19"});
+
+  // Without a count the adapter waits the whole ATST timeout (25 x 4 ms)
+  EmulatorReply reply = emulator.Execute("010C");
+  EXPECT_EQ(reply.chunks.back().at, milliseconds(80 + 100));
+  // With one it returns as soon as that many ECUs replied
+  reply = emulator.Execute("010C1");
+  ASSERT_EQ(reply.chunks.size(), 2u);
+  EXPECT_EQ(reply.chunks.back().at, milliseconds(25));
+  EXPECT_EQ(Text(reply), "18DAF11004410C1AF8\r\r>");
+
+  // An ECU slower than the timeout, counted from the previous reply, is
+  // never heard
+  emulator.Execute("ATST01");
+  reply = emulator.Execute("010C");
+  EXPECT_EQ(Text(reply), "NO DATA\r\r>");
+  EXPECT_EQ(reply.chunks.back().at, milliseconds(4));
+  emulator.Execute("ATST07");
+  EXPECT_EQ(Text(emulator.Execute("010C")), "18DAF11004410C1AF8\r\r>");
+}
+
+TEST(Elm327EmulatorTest, InjectsFaultsAndRepeatsOnBareCr) {
+  EmulatorProfile profile = QuietProfile();
+  profile.faults["0105"] = EmulatorFault::kNoData;
+  profile.faults["010D"] = EmulatorFault::kStopped;
+  profile.command_latency["010C"] = {microseconds(90000), microseconds(0)};
+  Elm327Emulator emulator(profile);
+  Init(&emulator);
+
+  EXPECT_EQ(Text(emulator.Execute("0105")), "NO DATA\r\r>");
+  EXPECT_EQ(Text(emulator.Execute("010D")), "STOPPED\r\r>");
+  EmulatorReply reply = emulator.Execute("010C");
+  EXPECT_EQ(reply.chunks.front().at, milliseconds(90));
+  EXPECT_EQ(Text(emulator.Execute("")), Text(reply));
+
+  profile.faults.clear();
+  profile.fault_rate = 1;
+  profile.random_fault = EmulatorFault::kBufferFull;
+  Elm327Emulator faulty(profile);
+  Init(&faulty);
+  EXPECT_EQ(Text(faulty.Execute("010C")), "BUFFER FULL\r\r>");
+}
+
+TEST(Elm327EmulatorTest, JitterIsRepeatableForASeed) {
+  EmulatorProfile profile = RamCumminsProfile();
+  profile.seed = 42;
+  Elm327Emulator first(profile);
+  Elm327Emulator second(profile);
+  Init(&first);
+  Init(&second);
+  bool jittered = false;
+  for (int i = 0; i < 20; ++i) {
+    EmulatorReply a = first.Execute("010C");
+    EmulatorReply b = second.Execute("010C");
+    ASSERT_EQ(a.chunks.size(), b.chunks.size());
+    EXPECT_EQ(a.chunks[0].at, b.chunks[0].at);
+    EXPECT_GE(a.chunks[0].at, milliseconds(25));
+    EXPECT_LE(a.chunks[0].at, milliseconds(30));
+    jittered = jittered || a.chunks[0].at != milliseconds(25);
+  }
+  EXPECT_TRUE(jittered);
+}
+
+// Serves |emulator| on the remote end of |pair| until the pair closes.
+class LinkThread {
+ public:
+  LinkThread(Elm327Emulator* emulator, NativeSocket socket)
+      : link_(emulator), thread_([this, socket]() { link_.Serve(socket); }) {}
+  ~LinkThread() {
+    link_.Stop();
+    thread_.join();
+  }
+  EmulatorLink& link() { return link_; }
+
+ private:
+  EmulatorLink link_;
+  std::thread thread_;
+};
+
+std::string ReadUntilPrompt(NativeSocket socket) {
+  std::string text;
+  char buffer[256];
+  while (text.empty() || text.back() != '>') {
+    ssize_t received = read(socket, buffer, sizeof(buffer));
+    if (received <= 0) break;
+    text.append(buffer, static_cast<std::size_t>(received));
+  }
+  return text;
+}
+
+TEST(EmulatorLinkTest, DrivesTheCommandPipeline) {
+  EmulatorProfile profile = QuietProfile();
+  profile.ecus[0].latency.base = milliseconds(2);
+  profile.ecus[1].latency.base = milliseconds(3);
+  profile.adaptive_wait = milliseconds(2);
+  profile.reset_latency = microseconds(0);
+  Elm327Emulator emulator(profile);
+  SocketPair pair;
+  LinkThread server(&emulator, pair.remote);
+
+  Elm327Framer framer;
+  std::vector<ElmResponse> completed;
+  CommandPipeline pipeline([&](const std::string& data) {
+    framer.ExpectEcho(data.substr(0, data.size() - 1));
+    return SendSome(pair.local, reinterpret_cast<const std::uint8_t*>(data.data()),
+                    data.size()) == static_cast<int>(data.size());
+  });
+  ReceiveLoop loop(
+      pair.local,
+      [&](const std::uint8_t* data, std::size_t length) {
+        framer.Feed(data, length, Clock::now(), &completed);
+        for (auto& response : completed) pipeline.OnResponse(std::move(response));
+        completed.clear();
+      },
+      nullptr);
+  loop.SetTimerHandler([&pipeline]() { return pipeline.OnTimer(Clock::now()); });
+  ASSERT_TRUE(loop.Start());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<CommandResult> results;
+  pipeline.Submit({"ATZ", "ATE0", "ATL0", "ATS0", "ATH1", "ATSP7", "010C", "010C1", "0902"},
+                  milliseconds(1000), [&](std::vector<CommandResult>&& batch) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    results = std::move(batch);
+                    cv.notify_all();
+                  });
+  loop.Wake();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return !results.empty(); }));
+  }
+  loop.Stop();
+
+  ASSERT_EQ(results.size(), 9u);
+  for (const auto& result : results) EXPECT_EQ(result.status, CommandResult::Status::kOk);
+  EXPECT_EQ(results[1].lines, Lines({"OK"}));  // echo of ATE0 stripped by the framer
+  EXPECT_EQ(results[6].lines, Lines({"18DAF11004410C1AF8", "18DAF118037F0112"}));
+  EXPECT_EQ(results[7].lines, Lines({"18DAF11004410C1AF8"}));
+  EXPECT_EQ(results[8].lines.size(), 3u);
+  // How soon the count ends the wait is checked in emulated time by
+  // ResponseCountAndTimeoutEndTheWait; wall-clock time here varies too much
+  EXPECT_EQ(server.link().commands(), 9u);
+}
+
+TEST(EmulatorLinkTest, ByteBeforeThePromptStopsTheReply) {
+  EmulatorProfile profile = QuietProfile();
+  profile.ecus[0].latency.base = milliseconds(200);
+  profile.ecus[1].latency.base = milliseconds(210);
+  Elm327Emulator emulator(profile);
+  SocketPair pair;
+  LinkThread server(&emulator, pair.remote);
+
+  const std::string init = "ATE0\r";
+  ASSERT_EQ(write(pair.local, init.data(), init.size()), static_cast<ssize_t>(init.size()));
+  EXPECT_EQ(ReadUntilPrompt(pair.local), "ATE0\rOK\r\n\r\n>");
+
+  const std::string command = "010C\r";
+  ASSERT_EQ(write(pair.local, command.data(), command.size()),
+            static_cast<ssize_t>(command.size()));
+  std::this_thread::sleep_for(milliseconds(20));
+  ASSERT_EQ(write(pair.local, "\r", 1), 1);
+  const auto aborted_at = Clock::now();
+  EXPECT_EQ(ReadUntilPrompt(pair.local), "SEARCHING...\r\nSTOPPED\r\n\r\n>");
+  EXPECT_LT(Clock::now() - aborted_at, milliseconds(150));
+  EXPECT_EQ(server.link().interrupted(), 1u);
+
+  // The aborting CR was discarded, not run as a repeat
+  const std::string next = "ATRV\r";
+  ASSERT_EQ(write(pair.local, next.data(), next.size()), static_cast<ssize_t>(next.size()));
+  EXPECT_EQ(ReadUntilPrompt(pair.local), "12.6V\r\n\r\n>");
+}
+
+TEST(EmulatorLinkTest, FirstCommandAfterLowPowerOnlyWakes) {
+  EmulatorProfile profile = QuietProfile();
+  Elm327Emulator emulator(profile);
+  SocketPair pair;
+  LinkThread server(&emulator, pair.remote);
+
+  const std::string sleep = "ATE0\rAT LP\r";
+  ASSERT_EQ(write(pair.local, sleep.data(), 5), 5);
+  ReadUntilPrompt(pair.local);
+  ASSERT_EQ(write(pair.local, sleep.data() + 5, 6), 6);
+  EXPECT_EQ(ReadUntilPrompt(pair.local), "OK\r\n\r\n>");
+  ASSERT_EQ(write(pair.local, "ATI\r", 4), 4);
+  EXPECT_EQ(ReadUntilPrompt(pair.local), ">");
+  ASSERT_EQ(write(pair.local, "ATI\r", 4), 4);
+  EXPECT_EQ(ReadUntilPrompt(pair.local), "ELM327 v1.4b\r\n\r\n>");
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
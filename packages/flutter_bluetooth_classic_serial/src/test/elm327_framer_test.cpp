@@ -0,0 +1,99 @@
+#include "elm327_framer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = Elm327Framer::Clock;
+using Lines = std::vector<std::string>;
+
+class Elm327FramerTest : public ::testing::Test {
+ protected:
+  std::size_t Feed(const std::string& text, Clock::time_point now = Clock::now()) {
+    return framer_.Feed(reinterpret_cast<const std::uint8_t*>(text.data()), text.size(), now,
+                        &responses_);
+  }
+
+  Elm327Framer framer_;
+  std::vector<ElmResponse> responses_;
+};
+
+TEST_F(Elm327FramerTest, EmitsOneRecordPerPrompt) {
+  EXPECT_EQ(Feed("41 0C 1A F8\r\r>41 0D 37\r\r>"), 2u);
+  ASSERT_EQ(responses_.size(), 2u);
+  EXPECT_EQ(responses_[0].lines, Lines({"41 0C 1A F8"}));
+  EXPECT_EQ(responses_[1].lines, Lines({"41 0D 37"}));
+}
+
+TEST_F(Elm327FramerTest, JoinsFragmentsAndSplitsLines) {
+  auto start = Clock::now();
+  Feed("7E8 10 14 49 02 01 31 ", start);
+  Feed("46 54\r7E8 21 46 57 ", start + std::chrono::milliseconds(3));
+  EXPECT_TRUE(responses_.empty());
+  EXPECT_TRUE(framer_.in_progress());
+
+  Feed("31 45 36\n\r\r>", start + std::chrono::milliseconds(7));
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines,
+            Lines({"7E8 10 14 49 02 01 31 46 54", "7E8 21 46 57 31 45 36"}));
+  EXPECT_EQ(responses_[0].first_byte_at, start);
+  EXPECT_EQ(responses_[0].completed_at, start + std::chrono::milliseconds(7));
+  EXPECT_FALSE(framer_.in_progress());
+}
+
+TEST_F(Elm327FramerTest, DropsEchoOfTheExpectedCommand) {
+  framer_.ExpectEcho("010C");
+  Feed("010C\r41 0C 1A F8\r\r>");
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines, Lines({"41 0C 1A F8"}));
+
+  // The expectation is consumed by the response it belongs to.
+  Feed("010C\r>");
+  ASSERT_EQ(responses_.size(), 2u);
+  EXPECT_EQ(responses_[1].lines, Lines({"010C"}));
+}
+
+TEST_F(Elm327FramerTest, KeepsFirstLineThatIsNotTheEcho) {
+  framer_.ExpectEcho("ATZ");
+  Feed("\r\rELM327 v1.5\r\r>");
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines, Lines({"ELM327 v1.5"}));
+}
+
+TEST_F(Elm327FramerTest, StripsSearchingAndBusInitNoise) {
+  Feed("0100\rSEARCHING...\r41 00 BE 3E B8 11\r\r>");
+  Feed("BUS INIT: ...OK\r41 00 BE 1F A8 13\r\r>");
+  ASSERT_EQ(responses_.size(), 2u);
+  EXPECT_EQ(responses_[0].lines, Lines({"0100", "41 00 BE 3E B8 11"}));
+  EXPECT_EQ(responses_[1].lines, Lines({"41 00 BE 1F A8 13"}));
+}
+
+TEST_F(Elm327FramerTest, KeepsBusInitError) {
+  Feed("BUS INIT: ...ERROR\r\r>");
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines, Lines({"BUS INIT: ...ERROR"}));
+}
+
+TEST_F(Elm327FramerTest, IgnoresNulBytesAndBlankLines) {
+  std::string text("  NO DATA  \r\r", 13);
+  text.push_back('\0');
+  text += "\r>";
+  Feed(text);
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines, Lines({"NO DATA"}));
+}
+
+TEST_F(Elm327FramerTest, ResetDropsPartialResponse) {
+  Feed("41 0C 1A");
+  framer_.Reset();
+  Feed("41 0D 37\r>");
+  ASSERT_EQ(responses_.size(), 1u);
+  EXPECT_EQ(responses_[0].lines, Lines({"41 0D 37"}));
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
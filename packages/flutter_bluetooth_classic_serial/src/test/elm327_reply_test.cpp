@@ -0,0 +1,211 @@
+#include "elm327_reply.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+using Lines = std::vector<std::string>;
+
+// The frames an ECU sends for |payload| as the adapter prints them with
+// headers: a single frame, or a first frame and consecutive frames padded
+// to eight bytes. Each frame is sized up front: built with inserts, GCC 12
+// reports overreads (-Wstringop-overread) once this is inlined.
+Lines Frames(const std::string& id, const Bytes& payload, bool spaces) {
+  std::vector<Bytes> frames;
+  if (payload.size() <= 7) {
+    Bytes single(1 + payload.size());
+    single[0] = static_cast<std::uint8_t>(payload.size());
+    std::copy(payload.begin(), payload.end(), single.begin() + 1);
+    frames.push_back(std::move(single));
+  } else {
+    Bytes first(8);
+    first[0] = static_cast<std::uint8_t>(0x10 | payload.size() >> 8);
+    first[1] = static_cast<std::uint8_t>(payload.size() & 0xFF);
+    std::copy_n(payload.begin(), 6, first.begin() + 2);
+    frames.push_back(std::move(first));
+    for (std::size_t offset = 6, sequence = 1; offset < payload.size(); offset += 7, ++sequence) {
+      Bytes frame(8, 0xAA);
+      frame[0] = static_cast<std::uint8_t>(0x20 | (sequence & 0x0F));
+      const std::size_t end = std::min(offset + 7, payload.size());
+      std::copy(payload.begin() + offset, payload.begin() + end, frame.begin() + 1);
+      frames.push_back(std::move(frame));
+    }
+  }
+  Lines lines;
+  for (const auto& frame : frames) {
+    std::string line = id;
+    char byte[4];
+    for (std::uint8_t value : frame) {
+      std::snprintf(byte, sizeof(byte), spaces ? " %02X" : "%02X", value);
+      line += byte;
+    }
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+TEST(AssembleElmReplyTest, JoinsHeaderedFramesPerCanId) {
+  const auto messages = AssembleElmReply({
+      "18DAF110 10 0A 41 0C 1A F8 0D 37",
+      "18DAF118037F0112AAAAAAAA",  // another ECU in between
+      "18DAF110 21 05 7B 42 36 B0 00 00",
+  });
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0].id, "18DAF110");
+  EXPECT_EQ(messages[0].bytes, (Bytes{0x41, 0x0C, 0x1A, 0xF8, 0x0D, 0x37, 0x05, 0x7B, 0x42, 0x36}));
+  EXPECT_TRUE(messages[0].complete);
+  EXPECT_EQ(messages[1].id, "18DAF118");
+  EXPECT_EQ(messages[1].bytes, (Bytes{0x7F, 0x01, 0x12}));
+
+  const auto eleven = AssembleElmReply({"7E8 03 41 0D 37 AA AA AA AA", "7E9 02 41 0D"});
+  ASSERT_EQ(eleven.size(), 2u);
+  EXPECT_EQ(eleven[0].id, "7E8");
+  EXPECT_EQ(eleven[0].bytes, (Bytes{0x41, 0x0D, 0x37}));
+  // Shorter than its PCI length says: keep what arrived
+  EXPECT_EQ(eleven[1].bytes, (Bytes{0x41, 0x0D}));
+}
+
+TEST(AssembleElmReplyTest, JoinsHeaderlessSegments) {
+  const auto messages =
+      AssembleElmReply({"SEARCHING...", "00A", "0: 41 0C 1A F8 0D 37", "1: 05 7B 42 36", "7F 01 12"});
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_TRUE(messages[0].id.empty());
+  EXPECT_EQ(messages[0].bytes.size(), 10u);
+  EXPECT_TRUE(messages[0].complete);
+  EXPECT_EQ(messages[1].bytes, (Bytes{0x7F, 0x01, 0x12}));
+}
+
+TEST(AssembleElmReplyTest, FollowsSequenceNumbers) {
+  // A lost consecutive frame: nothing after the hole is taken
+  const Lines vin = Frames("7E8", Bytes(20, 0x31), true);
+  auto messages = AssembleElmReply({vin[0], vin[2], vin[1]});
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_FALSE(messages[0].complete);
+  EXPECT_EQ(messages[0].bytes.size(), 6u);
+  // A repeated one
+  messages = AssembleElmReply({vin[0], vin[1], vin[1], vin[2]});
+  EXPECT_FALSE(messages[0].complete);
+
+  // Sequence numbers wrap from F to 0 on long DIDs
+  Bytes did(200);
+  for (std::size_t i = 0; i < did.size(); ++i) did[i] = static_cast<std::uint8_t>(i);
+  messages = AssembleElmReply(Frames("18DAF110", did, false));
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_TRUE(messages[0].complete);
+  EXPECT_EQ(messages[0].bytes, did);
+
+  // A new first frame from the same ECU abandons the old message
+  messages = AssembleElmReply({vin[0], vin[1], vin[0], vin[1], vin[2]});
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_FALSE(messages[0].complete);
+  EXPECT_TRUE(messages[1].complete);
+
+  // Headerless segments in index order only
+  messages = AssembleElmReply({"014", "0: 49 02 01 33 43 36", "2: 47 31 32 33 34 35 36"});
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_FALSE(messages[0].complete);
+  EXPECT_EQ(messages[0].bytes.size(), 6u);
+  // and a length line before the last segment arrived
+  messages = AssembleElmReply({"014", "0: 49 02 01 33 43 36", "014", "0: 49 02 01 33 43 36"});
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_FALSE(messages[0].complete);
+}
+
+TEST(AssembleElmReplyTest, FuzzedMultiEcuReplies) {
+  std::mt19937 random(1939);
+  const std::vector<std::string> ids11 = {"7E8", "7E9", "7EA", "7EB"};
+  const std::vector<std::string> ids29 = {"18DAF110", "18DAF118", "18DAF100", "18DAF1A0"};
+  for (int round = 0; round < 2000; ++round) {
+    const bool eleven = random() % 2 == 0;
+    const bool spaces = random() % 2 == 0;
+    const std::size_t ecus = 1 + random() % 4;
+    std::vector<Bytes> payloads(ecus);
+    std::vector<Lines> frames(ecus);
+    for (std::size_t e = 0; e < ecus; ++e) {
+      payloads[e].resize(1 + random() % 120);
+      for (auto& byte : payloads[e]) byte = static_cast<std::uint8_t>(random());
+      frames[e] = Frames((eleven ? ids11 : ids29)[e], payloads[e], spaces);
+    }
+
+    // Interleave the ECUs' frames the way the bus may, each ECU in order
+    Lines lines;
+    std::vector<std::size_t> next(ecus, 0);
+    for (std::size_t left = 0; ; left = 0) {
+      for (std::size_t e = 0; e < ecus; ++e) left += frames[e].size() - next[e];
+      if (left == 0) break;
+      std::size_t e = random() % ecus;
+      while (next[e] == frames[e].size()) e = (e + 1) % ecus;
+      lines.push_back(frames[e][next[e]++]);
+    }
+
+    // Intact: one complete payload per ECU
+    auto messages = AssembleElmReply(lines);
+    ASSERT_EQ(messages.size(), ecus) << round;
+    for (const auto& message : messages) {
+      const std::size_t e = static_cast<std::size_t>(
+          std::find(eleven ? ids11.begin() : ids29.begin(), eleven ? ids11.end() : ids29.end(),
+                    message.id) -
+          (eleven ? ids11.begin() : ids29.begin()));
+      ASSERT_LT(e, ecus) << round;
+      EXPECT_TRUE(message.complete) << round;
+      EXPECT_EQ(message.bytes, payloads[e]) << round;
+    }
+
+    // Damaged: drop, repeat or swap a line, or cut one short. Whatever is
+    // reported complete must still be exactly what was sent.
+    const std::size_t at = random() % lines.size();
+    Lines garbled = lines;
+    switch (random() % 4) {
+      case 0:
+        lines.erase(lines.begin() + at);
+        break;
+      case 1:
+        lines.insert(lines.begin() + at, lines[at]);
+        break;
+      case 2:
+        std::swap(lines[at], lines[(at + 1) % lines.size()]);
+        break;
+      default:
+        lines[at].resize(random() % lines[at].size());
+        break;
+    }
+    for (const auto& message : AssembleElmReply(lines)) {
+      // A line cut into its CAN ID reads as a headerless one
+      if (!message.complete || message.id.empty()) continue;
+      EXPECT_TRUE(std::any_of(payloads.begin(), payloads.end(),
+                              [&](const Bytes& payload) { return payload == message.bytes; }))
+          << round;
+    }
+
+    // A garbled character is only caught where it breaks the framing (ISO-TP
+    // has no checksum), but must never take the reassembler out of bounds
+    for (int i = 0; i < 4; ++i) {
+      std::string& line = garbled[random() % garbled.size()];
+      line[random() % line.size()] = "0123456789ABCDEF: ?"[random() % 19];
+    }
+    for (const auto& message : AssembleElmReply(garbled)) {
+      EXPECT_LE(message.bytes.size(), 0xFFFu) << round;
+    }
+  }
+}
+
+TEST(AssembleElmReplyTest, FlagsMessagesMissingFrames) {
+  const auto messages = AssembleElmReply({"18DAF110 10 14 49 02 01 31 44 34", "18DAF110 21 47 50"});
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_FALSE(messages[0].complete);
+  EXPECT_TRUE(AssembleElmReply({"NO DATA"}).empty());
+  EXPECT_TRUE(AssembleElmReply({"?", "STOPPED", ""}).empty());
+  // A stray consecutive frame has nothing to join
+  EXPECT_TRUE(AssembleElmReply({"7E8 21 00 11 22 33 44 55 66"}).empty());
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,81 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_TEST_EMULATED_ADAPTER_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_TEST_EMULATED_ADAPTER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_emulator.h"
+
+namespace flutter_bluetooth_classic {
+namespace testing {
+
+// A CommandPipeline wired straight to an Elm327Emulator, without a socket:
+// every line the pipeline writes is answered synchronously by Run(). The
+// adapter starts initialized the way the app leaves it (echo, linefeeds
+// and spaces off, headers on, 29-bit CAN), and adds up the time its
+// replies would have taken plus |link_latency| per exchange.
+class EmulatedAdapter {
+ public:
+  explicit EmulatedAdapter(EmulatorProfile profile,
+                           std::chrono::microseconds link_latency = std::chrono::microseconds(0))
+      : emulator_(std::move(profile)),
+        link_latency_(link_latency),
+        pipeline_([this](const std::string& data) {
+          writes_.push_back(data);
+          return true;
+        }) {
+    for (const char* command : {"ATZ", "ATE0", "ATL0", "ATS0", "ATH1", "ATSP7"}) {
+      emulator_.Execute(command);
+    }
+  }
+
+  EmulatedAdapter(const EmulatedAdapter&) = delete;
+  EmulatedAdapter& operator=(const EmulatedAdapter&) = delete;
+
+  CommandPipeline& pipeline() { return pipeline_; }
+  // Every line the pipeline wrote, with its CR.
+  const std::vector<std::string>& writes() const { return writes_; }
+  std::chrono::microseconds elapsed() const { return elapsed_; }
+
+  // Answers every line written until the pipeline goes idle.
+  void Run() {
+    std::size_t done = writes_.size();
+    pipeline_.OnTimer(CommandPipeline::Clock::now());
+    while (done < writes_.size()) {
+      const std::string command = writes_[done++];
+      ElmResponse response;
+      std::string line;
+      const EmulatorReply reply = emulator_.Execute(command.substr(0, command.size() - 1));
+      for (const auto& chunk : reply.chunks) {
+        for (char c : chunk.text) {
+          if (c == '\r' || c == '\n' || c == '>') {
+            if (!line.empty()) response.lines.push_back(line);
+            line.clear();
+          } else {
+            line.push_back(c);
+          }
+        }
+      }
+      elapsed_ += reply.chunks.back().at + link_latency_;
+      response.completed_at = CommandPipeline::Clock::now();
+      pipeline_.OnResponse(std::move(response));
+      // Batches submitted from a batch handler start on the next timer
+      if (done == writes_.size()) pipeline_.OnTimer(CommandPipeline::Clock::now());
+    }
+  }
+
+ private:
+  Elm327Emulator emulator_;
+  std::chrono::microseconds link_latency_;
+  std::vector<std::string> writes_;
+  CommandPipeline pipeline_;
+  std::chrono::microseconds elapsed_{0};
+};
+
+}  // namespace testing
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_TEST_EMULATED_ADAPTER_H_
@@ -0,0 +1,57 @@
+#include "handle_table.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Table = HandleTable<std::string>;
+
+TEST(HandleTableTest, InsertAndGet) {
+  Table table;
+  Table::Handle a = table.Insert(std::make_unique<std::string>("00:1D:A5:00:00:01"));
+  Table::Handle b = table.Insert(std::make_unique<std::string>("00:1D:A5:00:00:02"));
+  ASSERT_NE(a, Table::kInvalidHandle);
+  ASSERT_NE(a, b);
+  EXPECT_EQ(*table.Get(a), "00:1D:A5:00:00:01");
+  EXPECT_EQ(*table.Get(b), "00:1D:A5:00:00:02");
+  EXPECT_EQ(table.size(), 2u);
+}
+
+TEST(HandleTableTest, RemovedHandleGoesStaleWhenSlotIsReused) {
+  Table table;
+  Table::Handle old_handle = table.Insert(std::make_unique<std::string>("old"));
+  auto removed = table.Remove(old_handle);
+  ASSERT_TRUE(removed);
+  EXPECT_EQ(*removed, "old");
+
+  Table::Handle new_handle = table.Insert(std::make_unique<std::string>("new"));
+  EXPECT_NE(new_handle, old_handle);
+  EXPECT_EQ(table.Get(old_handle), nullptr);
+  EXPECT_EQ(table.Remove(old_handle), nullptr);
+  EXPECT_EQ(*table.Get(new_handle), "new");
+  EXPECT_EQ(table.size(), 1u);
+}
+
+TEST(HandleTableTest, RejectsInvalidHandles) {
+  Table table;
+  EXPECT_EQ(table.Get(Table::kInvalidHandle), nullptr);
+  EXPECT_EQ(table.Get(12345), nullptr);
+}
+
+TEST(HandleTableTest, ForEachVisitsLiveObjects) {
+  Table table;
+  Table::Handle a = table.Insert(std::make_unique<std::string>("a"));
+  table.Insert(std::make_unique<std::string>("b"));
+  table.Remove(a);
+
+  std::string seen;
+  table.ForEach([&](Table::Handle, const std::string& value) { seen += value; });
+  EXPECT_EQ(seen, "b");
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
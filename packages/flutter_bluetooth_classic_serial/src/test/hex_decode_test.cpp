@@ -0,0 +1,62 @@
+#include "hex_decode.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+TEST(HexDecodeTest, DecodesBothCases) {
+  const std::string hex = "0123456789abcdefABCDEF";
+  std::uint8_t out[11];
+  ASSERT_EQ(DecodeHex(hex.data(), hex.size(), out), 11u);
+  const std::uint8_t expected[] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB,
+                                   0xCD, 0xEF, 0xAB, 0xCD, 0xEF};
+  EXPECT_EQ(std::vector<std::uint8_t>(out, out + 11),
+            std::vector<std::uint8_t>(expected, expected + 11));
+}
+
+TEST(HexDecodeTest, IgnoresTrailingOddDigit) {
+  std::uint8_t out[2];
+  EXPECT_EQ(DecodeHex("1AF", 3, out), 1u);
+  EXPECT_EQ(out[0], 0x1A);
+  EXPECT_EQ(DecodeHex("F", 1, out), 0u);
+}
+
+// Every byte value in every position of a 16-digit block (the vector
+// path) and of the scalar tail must agree with the reference decoder.
+TEST(HexDecodeTest, VectorPathMatchesScalarForEveryCharacter) {
+  for (int position = 0; position < 20; ++position) {
+    for (int c = 0; c < 256; ++c) {
+      std::string hex(20, '5');
+      hex[position] = static_cast<char>(c);
+      std::uint8_t vector_out[10] = {};
+      std::uint8_t scalar_out[10] = {};
+      std::size_t vector_count = DecodeHex(hex.data(), hex.size(), vector_out);
+      std::size_t scalar_count = DecodeHexScalar(hex.data(), hex.size(), scalar_out);
+      ASSERT_EQ(vector_count, scalar_count) << "position " << position << " char " << c;
+      if (scalar_count != kInvalidHex) {
+        ASSERT_EQ(std::vector<std::uint8_t>(vector_out, vector_out + 10),
+                  std::vector<std::uint8_t>(scalar_out, scalar_out + 10));
+      }
+    }
+  }
+}
+
+TEST(HexDecodeTest, RoundTripsEveryByteValue) {
+  static const char kDigits[] = "0123456789ABCDEF";
+  std::string hex;
+  for (int value = 0; value < 256; ++value) {
+    hex.push_back(kDigits[value >> 4]);
+    hex.push_back(kDigits[value & 0xF]);
+  }
+  std::vector<std::uint8_t> out(256);
+  ASSERT_EQ(DecodeHex(hex.data(), hex.size(), out.data()), 256u);
+  for (int value = 0; value < 256; ++value) EXPECT_EQ(out[value], value);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
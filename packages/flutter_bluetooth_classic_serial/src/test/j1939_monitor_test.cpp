@@ -0,0 +1,181 @@
+#include "j1939_monitor.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = J1939Monitor::Clock;
+using Lines = std::vector<std::string>;
+
+const J1939Value* Find(const std::vector<J1939Value>& values, std::uint32_t spn) {
+  for (const auto& value : values) {
+    if (value.spn->spn == spn) return &value;
+  }
+  return nullptr;
+}
+
+bool Feed(J1939Monitor* monitor, const std::string& text, std::size_t chunk,
+          Clock::time_point at = Clock::now()) {
+  const auto* data = reinterpret_cast<const std::uint8_t*>(text.data());
+  bool stopped = false;
+  for (std::size_t i = 0; i < text.size() && !stopped; i += chunk) {
+    stopped = monitor->Feed(data + i, std::min(chunk, text.size() - i), at);
+  }
+  return stopped;
+}
+
+TEST(J1939Test, DecodesIdsOfBothPduFormats) {
+  // EEC1 from the engine, broadcast
+  J1939Id id = DecodeJ1939Id(0x0CF00400);
+  EXPECT_EQ(id.priority, 3);
+  EXPECT_EQ(id.pgn, 0xF004u);
+  EXPECT_EQ(id.source, 0x00);
+  EXPECT_EQ(id.destination, 0xFF);
+
+  // A request (PDU1) from the service tool to the engine
+  id = DecodeJ1939Id(0x18EA00F9);
+  EXPECT_EQ(id.priority, 6);
+  EXPECT_EQ(id.pgn, 0xEA00u);
+  EXPECT_EQ(id.source, 0xF9);
+  EXPECT_EQ(id.destination, 0x00);
+}
+
+TEST(J1939Test, DecodesSpnsAndRejectsNotAvailable) {
+  const std::uint8_t eec1[] = {0xF0, 0xFF, 0x9B, 0xF0, 0x35, 0x00, 0xF0, 0xFF};
+  double value = 0;
+  const SpnDescriptor engine_speed = {190, 0xF004, 3, 0, 16, 0.125, 0, "engineSpeed", "rpm"};
+  ASSERT_TRUE(DecodeSpn(engine_speed, eec1, sizeof(eec1), &value));
+  EXPECT_DOUBLE_EQ(value, 1726);
+  const SpnDescriptor actual_torque = {513, 0xF004, 2, 0, 8, 1, -125, "actualTorque", "%"};
+  ASSERT_TRUE(DecodeSpn(actual_torque, eec1, sizeof(eec1), &value));
+  EXPECT_DOUBLE_EQ(value, 30);
+  // 0xFF is "not available", and the frame may be cut short
+  const SpnDescriptor demand = {512, 0xF004, 1, 0, 8, 1, -125, "driverDemandTorque", "%"};
+  EXPECT_FALSE(DecodeSpn(demand, eec1, sizeof(eec1), &value));
+  EXPECT_FALSE(DecodeSpn(engine_speed, eec1, 4, &value));
+
+  // Bit fields: 2-bit states 10 (error) and 11 (not available)
+  const SpnDescriptor state = {0, 0, 0, 2, 2, 1, 0, "state", ""};
+  const std::uint8_t states[] = {0x04, 0x08, 0x0C};
+  EXPECT_TRUE(DecodeSpn(state, &states[0], 1, &value));
+  EXPECT_DOUBLE_EQ(value, 1);
+  EXPECT_FALSE(DecodeSpn(state, &states[1], 1, &value));
+  EXPECT_FALSE(DecodeSpn(state, &states[2], 1, &value));
+}
+
+TEST(J1939MonitorTest, DecodesMonitorOutputInAnyChunking) {
+  const std::string stream =
+      "0CF00400F0FF9BF03500F0FF\r\n"  // EEC1, no spaces
+      "18 FE EE 00 7B 54 00 2E FF FF 5A FF\r\n"  // ET1, spaced
+      "18FEF600FF54FFFFFF002EFF\r"  // IC1: boost and EGT
+      "18FECA00 0000\r"  // DM1: lamps off, no faults
+      "<DATA ERROR\r"
+      "7E8 03 41 0D 37\r"
+      "BUFFER FULL\r\r>";
+  for (std::size_t chunk : {std::size_t{1}, std::size_t{7}, stream.size()}) {
+    J1939Monitor monitor;
+    const Clock::time_point at = Clock::now();
+    EXPECT_TRUE(Feed(&monitor, stream, chunk, at)) << chunk;
+
+    const auto values = monitor.Snapshot();
+    ASSERT_NE(Find(values, 190), nullptr) << chunk;
+    EXPECT_DOUBLE_EQ(Find(values, 190)->value, 1726);
+    EXPECT_EQ(Find(values, 190)->at, at);
+    EXPECT_EQ(Find(values, 190)->source, 0x00);
+    EXPECT_EQ(Find(values, 512), nullptr);  // not available
+    EXPECT_DOUBLE_EQ(Find(values, 110)->value, 83);
+    EXPECT_DOUBLE_EQ(Find(values, 175)->value, 95);
+    EXPECT_DOUBLE_EQ(Find(values, 52)->value, 50);
+    EXPECT_DOUBLE_EQ(Find(values, 102)->value, 168);
+    EXPECT_DOUBLE_EQ(Find(values, 173)->value, 95);
+
+    const J1939MonitorCounters counters = monitor.counters();
+    EXPECT_EQ(counters.frames, 4u);
+    EXPECT_EQ(counters.decoded, 4u);
+    EXPECT_EQ(counters.ignored, 0u);
+    EXPECT_EQ(counters.malformed, 2u);
+    EXPECT_EQ(counters.overflows, 1u);
+  }
+}
+
+TEST(J1939MonitorTest, KeepsTheLatestValueOfWantedPgns) {
+  J1939Monitor monitor;
+  monitor.SetPgns({0xF004});
+  EXPECT_FALSE(Feed(&monitor, "0CF00400F0FF9BF03500F0FF\r18FEEE007B54002EFFFF5AFF\r", 64));
+  EXPECT_FALSE(Feed(&monitor, "0CF00400F0FF9B004000F0FF\r", 64));
+  auto values = monitor.Snapshot();
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_EQ(values[1].spn->spn, 190u);
+  EXPECT_DOUBLE_EQ(values[1].value, 2048);
+  EXPECT_EQ(values[1].updates, 2u);
+  EXPECT_EQ(monitor.counters().ignored, 1u);
+
+  monitor.Reset();
+  EXPECT_TRUE(monitor.Snapshot().empty());
+  EXPECT_EQ(monitor.counters().frames, 0u);
+}
+
+TEST(J1939MonitorTest, KeepsTheLatestDm1OfEachEcu) {
+  J1939Monitor monitor;
+  // A single-frame DM1 from the transmission, then a two-fault one from
+  // the engine by BAM
+  Feed(&monitor,
+       "18FECA03 04FF 6E000003 FFFF\r"
+       "1CECFF00 20 0A 00 02 FF CA FE 00\r"
+       "1CEBFF00 01 50 FF 6E 00 00 03 B3\r"
+       "1CEBFF00 02 0C 02 05 FF FF FF FF\r",
+       16);
+  auto dm1s = monitor.Dm1Snapshot();
+  ASSERT_EQ(dm1s.size(), 2u);
+  EXPECT_EQ(dm1s[0].source, 0x00);
+  EXPECT_TRUE(dm1s[0].lamps.malfunction);
+  EXPECT_TRUE(dm1s[0].lamps.red_stop);
+  ASSERT_EQ(dm1s[0].dtcs.size(), 2u);
+  EXPECT_EQ(dm1s[0].dtcs[1].spn, 3251u);
+  EXPECT_EQ(dm1s[1].source, 0x03);
+  EXPECT_TRUE(dm1s[1].lamps.amber_warning);
+  ASSERT_EQ(dm1s[1].dtcs.size(), 1u);
+  EXPECT_EQ(monitor.counters().decoded, 2u);
+  EXPECT_EQ(monitor.counters().transport.messages, 1u);
+
+  // The fault clears
+  Feed(&monitor, "18FECA03 00FF 00000000 FFFF\r", 64);
+  dm1s = monitor.Dm1Snapshot();
+  EXPECT_TRUE(dm1s[1].dtcs.empty());
+  EXPECT_EQ(dm1s[1].updates, 2u);
+
+  // Not asked for
+  monitor.Reset();
+  monitor.SetPgns({0xF004});
+  Feed(&monitor, "18FECA03 04FF 6E000003 FFFF\r", 64);
+  EXPECT_TRUE(monitor.Dm1Snapshot().empty());
+}
+
+TEST(J1939MonitorTest, BuildsAdapterFilters) {
+  // EEC1 and ET1 share only some PGN bits; the monitor drops the rest
+  J1939MonitorCommands elm = MakeJ1939MonitorCommands({0xF004, 0xFEEE}, false);
+  EXPECT_EQ(elm.setup, (Lines{"ATH1", "ATS0", "ATCAF0", "ATCF00F00400", "ATCM03F11500"}));
+  EXPECT_EQ(elm.start, "ATMA");
+  EXPECT_EQ(elm.restore.front(), "ATCAF1");
+
+  J1939MonitorCommands stn = MakeJ1939MonitorCommands({0xF004, 0xEA00}, true);
+  EXPECT_EQ(stn.setup, (Lines{"ATH1", "ATS0", "ATCAF0", "STFCP", "STFAP 00F00400,03FFFF00",
+                              "STFAP 00EA0000,03FF0000"}));
+  EXPECT_EQ(stn.start, "STMA");
+
+  // DM1 brings the transport protocol groups
+  EXPECT_EQ(MakeJ1939MonitorCommands({0xFECA}, true).setup,
+            (Lines{"ATH1", "ATS0", "ATCAF0", "STFCP", "STFAP 00FECA00,03FFFF00",
+                   "STFAP 00EC0000,03FF0000", "STFAP 00EB0000,03FF0000"}));
+
+  // Every table PGN by default
+  EXPECT_GT(MakeJ1939MonitorCommands({}, true).setup.size(), 10u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
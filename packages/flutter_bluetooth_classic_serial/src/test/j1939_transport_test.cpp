@@ -0,0 +1,171 @@
+#include "j1939_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+using Clock = J1939Transport::Clock;
+using std::chrono::milliseconds;
+
+// Offers one frame; returns the completed payload, or an empty one.
+Bytes Offer(J1939Transport* transport, std::uint32_t can_id, const Bytes& data,
+            Clock::time_point at, J1939Message* message = nullptr) {
+  J1939Message completed;
+  if (!transport->Offer(DecodeJ1939Id(can_id), data.data(), data.size(), at, &completed)) {
+    return {};
+  }
+  if (message) *message = completed;
+  return Bytes(completed.data, completed.data + completed.size);
+}
+
+TEST(J1939Dm1Test, DecodesLampsAndFaults) {
+  const std::uint8_t dm1[] = {
+      0x44, 0xFF,              // MIL and amber warning on, not flashing
+      0x6E, 0x00, 0x00, 0x03,  // SPN 110 FMI 0, 3 times
+      0xB3, 0x0C, 0x02, 0x05,  // SPN 3251 FMI 2, 5 times
+      0x00, 0xF0, 0xFF, 0x01,  // SPN 520192 FMI 31: the top SPN bits
+      0x6E, 0x00, 0x00, 0x81,  // old conversion method: skipped
+      0xFF, 0xFF, 0xFF, 0xFF,  // padding
+  };
+  J1939Lamps lamps;
+  J1939Dtc dtcs[8];
+  ASSERT_EQ(DecodeDm1(dm1, sizeof(dm1), &lamps, dtcs, 8), 3u);
+  EXPECT_TRUE(lamps.malfunction);
+  EXPECT_FALSE(lamps.red_stop);
+  EXPECT_TRUE(lamps.amber_warning);
+  EXPECT_FALSE(lamps.protect);
+  EXPECT_EQ(lamps.flash, 0xFF);
+  EXPECT_EQ(dtcs[0].spn, 110u);
+  EXPECT_EQ(dtcs[0].fmi, 0);
+  EXPECT_EQ(dtcs[0].occurrences, 3);
+  EXPECT_EQ(dtcs[1].spn, 3251u);
+  EXPECT_EQ(dtcs[1].fmi, 2);
+  EXPECT_EQ(dtcs[2].spn, 520192u);
+  EXPECT_EQ(dtcs[2].fmi, 31);
+
+  // No active faults, and a capacity cut
+  const std::uint8_t clear[] = {0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF};
+  EXPECT_EQ(DecodeDm1(clear, sizeof(clear), &lamps, dtcs, 8), 0u);
+  EXPECT_FALSE(lamps.malfunction);
+  EXPECT_EQ(DecodeDm1(dm1, sizeof(dm1), &lamps, dtcs, 1), 1u);
+}
+
+TEST(J1939TransportTest, ReassemblesConcurrentBroadcasts) {
+  J1939Transport transport;
+  const Clock::time_point at = Clock::now();
+  // DM1s of 14 and 10 bytes from the engine and the transmission, packets
+  // interleaved the way the bus carries them
+  EXPECT_TRUE(Offer(&transport, 0x1CECFF00, {0x20, 0x0E, 0x00, 0x02, 0xFF, 0xCA, 0xFE, 0x00}, at)
+                  .empty());
+  EXPECT_TRUE(Offer(&transport, 0x1CECFF03, {0x20, 0x0A, 0x00, 0x02, 0xFF, 0xCA, 0xFE, 0x00}, at)
+                  .empty());
+  EXPECT_EQ(transport.active(), 2u);
+  EXPECT_TRUE(Offer(&transport, 0x1CEBFF00, {1, 1, 2, 3, 4, 5, 6, 7}, at + milliseconds(50))
+                  .empty());
+  EXPECT_TRUE(Offer(&transport, 0x1CEBFF03, {1, 11, 12, 13, 14, 15, 16, 17}, at + milliseconds(50))
+                  .empty());
+  J1939Message message;
+  EXPECT_EQ(Offer(&transport, 0x1CEBFF03, {2, 18, 19, 20, 0xFF, 0xFF, 0xFF, 0xFF},
+                  at + milliseconds(100), &message),
+            (Bytes{11, 12, 13, 14, 15, 16, 17, 18, 19, 20}));
+  EXPECT_EQ(message.pgn, kPgnDm1);
+  EXPECT_EQ(message.source, 0x03);
+  EXPECT_EQ(message.destination, 0xFF);
+  EXPECT_EQ(Offer(&transport, 0x1CEBFF00, {2, 8, 9, 10, 11, 12, 13, 14}, at + milliseconds(100),
+                  &message),
+            (Bytes{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14}));
+  EXPECT_EQ(message.source, 0x00);
+  EXPECT_EQ(transport.active(), 0u);
+  EXPECT_EQ(transport.counters().messages, 2u);
+}
+
+TEST(J1939TransportTest, DropsTransfersWithHolesOrGaps) {
+  J1939Transport transport;
+  const Clock::time_point at = Clock::now();
+  const Bytes bam = {0x20, 0x14, 0x00, 0x03, 0xFF, 0xCA, 0xFE, 0x00};
+
+  // Packet 2 lost
+  Offer(&transport, 0x1CECFF00, bam, at);
+  Offer(&transport, 0x1CEBFF00, {1, 1, 2, 3, 4, 5, 6, 7}, at);
+  EXPECT_TRUE(Offer(&transport, 0x1CEBFF00, {3, 1, 2, 3, 4, 5, 6, 7}, at).empty());
+  EXPECT_EQ(transport.counters().sequence_errors, 1u);
+  EXPECT_EQ(transport.active(), 0u);
+
+  // More than T1 between packets
+  Offer(&transport, 0x1CECFF00, bam, at);
+  Offer(&transport, 0x1CEBFF00, {1, 1, 2, 3, 4, 5, 6, 7}, at);
+  EXPECT_TRUE(
+      Offer(&transport, 0x1CEBFF00, {2, 1, 2, 3, 4, 5, 6, 7}, at + milliseconds(800)).empty());
+  EXPECT_EQ(transport.counters().timeouts, 1u);
+
+  // A new announcement replaces the transfer in progress
+  Offer(&transport, 0x1CECFF00, bam, at);
+  Offer(&transport, 0x1CEBFF00, {1, 1, 2, 3, 4, 5, 6, 7}, at);
+  Offer(&transport, 0x1CECFF00, bam, at);
+  EXPECT_EQ(transport.counters().aborts, 1u);
+  EXPECT_TRUE(Offer(&transport, 0x1CEBFF00, {2, 1, 2, 3, 4, 5, 6, 7}, at).empty());
+
+  // Sizes the packet count cannot carry, and a BAM to one ECU
+  Offer(&transport, 0x1CECFF00, {0x20, 0x14, 0x00, 0x02, 0xFF, 0xCA, 0xFE, 0x00}, at);
+  Offer(&transport, 0x1CECFF00, {0x20, 0xFA, 0x06, 0xFF, 0xFF, 0xCA, 0xFE, 0x00}, at);
+  Offer(&transport, 0x1CECF900, bam, at);
+  EXPECT_EQ(transport.counters().malformed, 3u);
+  EXPECT_EQ(transport.counters().messages, 0u);
+}
+
+TEST(J1939TransportTest, FollowsConnectionModeTransfersAndResends) {
+  J1939Transport transport;
+  const Clock::time_point at = Clock::now();
+  // The engine sends 17 bytes of component ID to the service tool (F9),
+  // which asks for packet 2 again
+  Offer(&transport, 0x1CECF900, {0x10, 0x11, 0x00, 0x03, 0x02, 0xEB, 0xFE, 0x00}, at);
+  Offer(&transport, 0x1CEC00F9, {0x11, 0x02, 0x01, 0xFF, 0xFF, 0xEB, 0xFE, 0x00}, at);
+  Offer(&transport, 0x1CEBF900, {1, 'C', 'M', 'M', 'N', 'S', '*', 'I'}, at);
+  Offer(&transport, 0x1CEBF900, {2, 'S', 'X', '*', 'X', 'X', 'X', 'X'}, at);
+  // Waiting on the tool's CTS is allowed longer than T1
+  Offer(&transport, 0x1CEC00F9, {0x11, 0x02, 0x02, 0xFF, 0xFF, 0xEB, 0xFE, 0x00},
+        at + milliseconds(1000));
+  Offer(&transport, 0x1CEBF900, {2, 'S', 'X', '1', '5', '*', '7', '9'}, at + milliseconds(1000));
+  J1939Message message;
+  const Bytes payload = Offer(&transport, 0x1CEBF900, {3, '0', '1', '2', 0xFF, 0xFF, 0xFF, 0xFF},
+                              at + milliseconds(1000), &message);
+  EXPECT_EQ(std::string(payload.begin(), payload.end()), "CMMNS*ISX15*79012");
+  EXPECT_EQ(message.pgn, 0xFEEBu);
+  EXPECT_EQ(message.destination, 0xF9);
+  EXPECT_EQ(transport.counters().sequence_errors, 0u);
+
+  // The receiver gives up
+  Offer(&transport, 0x1CECF900, {0x10, 0x11, 0x00, 0x03, 0x02, 0xEB, 0xFE, 0x00}, at);
+  Offer(&transport, 0x1CEC00F9, {0xFF, 0x03, 0xFF, 0xFF, 0xFF, 0xEB, 0xFE, 0x00}, at);
+  EXPECT_EQ(transport.counters().aborts, 1u);
+  EXPECT_EQ(transport.active(), 0u);
+}
+
+TEST(J1939TransportTest, ReusesPoolSlotsOnceSessionsTimeOut) {
+  J1939Transport transport;
+  const Clock::time_point at = Clock::now();
+  for (std::uint32_t source = 0; source <= J1939Transport::kMaxSessions; ++source) {
+    Offer(&transport, 0x1CECFF00 | source, {0x20, 0x14, 0x00, 0x03, 0xFF, 0xCA, 0xFE, 0x00}, at);
+  }
+  EXPECT_EQ(transport.active(), J1939Transport::kMaxSessions);
+  EXPECT_EQ(transport.counters().pool_full, 1u);
+
+  // Stale sessions make room for new announcements
+  const Clock::time_point later = at + milliseconds(1000);
+  Offer(&transport, 0x1CECFF40, {0x20, 0x0A, 0x00, 0x02, 0xFF, 0xCA, 0xFE, 0x00}, later);
+  Offer(&transport, 0x1CEBFF40, {1, 1, 2, 3, 4, 5, 6, 7}, later);
+  EXPECT_EQ(Offer(&transport, 0x1CEBFF40, {2, 8, 9, 10, 0xFF, 0xFF, 0xFF, 0xFF}, later).size(),
+            10u);
+  transport.Expire(later);
+  EXPECT_EQ(transport.active(), 0u);
+  EXPECT_EQ(transport.counters().timeouts, J1939Transport::kMaxSessions);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,148 @@
+#include "latency_stats.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using std::chrono::microseconds;
+
+TEST(LatencyHistogramTest, BucketsCoverEveryValueContiguously) {
+  EXPECT_EQ(LatencyHistogram::BucketIndex(0), 0u);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(31), 31u);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(32), 32u);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(64), 64u);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(65), 64u);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(LatencyHistogram::kMaxTrackedUs),
+            LatencyHistogram::kBucketCount - 1);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(LatencyHistogram::kMaxTrackedUs * 10),
+            LatencyHistogram::kBucketCount - 1);
+
+  // Each bucket starts right after the previous one ends
+  for (std::size_t i = 1; i < LatencyHistogram::kBucketCount; ++i) {
+    const std::uint64_t first = LatencyHistogram::BucketUpperBound(i - 1) + 1;
+    ASSERT_EQ(LatencyHistogram::BucketIndex(first), i) << first;
+    ASSERT_EQ(LatencyHistogram::BucketIndex(LatencyHistogram::BucketUpperBound(i)), i);
+  }
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1),
+            LatencyHistogram::kMaxTrackedUs);
+}
+
+TEST(LatencyHistogramTest, PercentilesAreWithinBucketPrecision) {
+  LatencyHistogram histogram;
+  std::mt19937 random(7);
+  // Log-normal-ish adapter latencies: mostly 20-60 ms with a long tail
+  std::lognormal_distribution<double> latency(std::log(35000.0), 0.5);
+  std::vector<std::uint64_t> values;
+  for (int i = 0; i < 20000; ++i) {
+    const auto value = static_cast<std::uint64_t>(latency(random));
+    values.push_back(value);
+    histogram.Record(microseconds(value));
+  }
+  std::sort(values.begin(), values.end());
+
+  for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+    const std::uint64_t exact =
+        values[static_cast<std::size_t>(quantile * static_cast<double>(values.size())) - 1];
+    const std::uint64_t reported = histogram.ValueAtQuantile(quantile);
+    EXPECT_GE(reported, exact) << quantile;
+    EXPECT_LE(static_cast<double>(reported), static_cast<double>(exact) * (1.0 + 1.0 / 32))
+        << quantile;
+  }
+
+  LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(summary.count, values.size());
+  EXPECT_EQ(summary.max_us, values.back());
+  EXPECT_EQ(histogram.ValueAtQuantile(1.0), values.back());
+  EXPECT_LE(summary.p50_us, summary.p90_us);
+  EXPECT_LE(summary.p90_us, summary.p99_us);
+  EXPECT_LE(summary.p99_us, summary.max_us);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExactAndResetEmpties) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Summarize().count, 0u);
+  EXPECT_EQ(histogram.ValueAtQuantile(0.5), 0u);
+
+  for (int i = 1; i <= 10; ++i) histogram.Record(microseconds(i));
+  histogram.Record(microseconds(-5));  // clock skew counts as zero
+  LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(summary.count, 11u);
+  EXPECT_EQ(summary.mean_us, 5u);
+  EXPECT_EQ(summary.p50_us, 5u);
+  EXPECT_EQ(summary.max_us, 10u);
+
+  // Beyond the tracked range the maximum is still exact
+  histogram.Record(microseconds(60 * 1000 * 1000));
+  EXPECT_EQ(histogram.Summarize().max_us, 60u * 1000 * 1000);
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.Summarize().count, 0u);
+  EXPECT_EQ(histogram.Summarize().max_us, 0u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordsAreAllCounted) {
+  LatencyHistogram histogram;
+  constexpr int kThreads = 4;
+  constexpr int kRecords = 50000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (int i = 0; i < kRecords; ++i) histogram.Record(microseconds(t * 1000 + i % 1000));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  LatencySummary summary = histogram.Summarize();
+  EXPECT_EQ(summary.count, static_cast<std::uint64_t>(kThreads * kRecords));
+  EXPECT_EQ(summary.max_us, static_cast<std::uint64_t>((kThreads - 1) * 1000 + 999));
+}
+
+TEST(LinkStatsTest, KeepsOneEntryPerCommandUpToTheCap) {
+  LinkStats stats;
+  CommandStats* rpm = stats.ForCommand("010C");
+  EXPECT_EQ(stats.ForCommand("010C"), rpm);
+  rpm->Record(LatencyPhase::kRoundTrip, microseconds(40000));
+  rpm->completed.fetch_add(1);
+  stats.Add(LinkCounter::kBytesReceived, 17);
+  stats.Add(LinkCounter::kResponses);
+
+  for (int i = 0; i < 300; ++i) stats.ForCommand("22" + std::to_string(1000 + i));
+  auto snapshot = stats.Snapshot();
+  EXPECT_EQ(snapshot.size(), LinkStats::kMaxCommands);
+  EXPECT_TRUE(std::any_of(snapshot.begin(), snapshot.end(), [](const CommandLatency& entry) {
+    return entry.command == LinkStats::kOtherCommand;
+  }));
+  EXPECT_EQ(stats.ForCommand("22FFFF"), stats.ForCommand(LinkStats::kOtherCommand));
+
+  auto it = std::find_if(snapshot.begin(), snapshot.end(),
+                         [](const CommandLatency& entry) { return entry.command == "010C"; });
+  ASSERT_NE(it, snapshot.end());
+  EXPECT_EQ(it->completed, 1u);
+  EXPECT_EQ(it->phases[static_cast<int>(LatencyPhase::kRoundTrip)].max_us, 40000u);
+  EXPECT_EQ(stats.counter(LinkCounter::kBytesReceived), 17u);
+
+  // Reset zeroes in place; handed-out entries stay valid
+  stats.Reset();
+  EXPECT_EQ(stats.counter(LinkCounter::kResponses), 0u);
+  EXPECT_EQ(rpm->completed.load(), 0u);
+  EXPECT_EQ(rpm->phases[static_cast<int>(LatencyPhase::kRoundTrip)].count(), 0u);
+  EXPECT_EQ(stats.ForCommand("010C"), rpm);
+}
+
+TEST(LinkStatsTest, NamesEveryPhaseAndCounter) {
+  EXPECT_STREQ(LatencyPhaseName(LatencyPhase::kFirstByte), "firstByte");
+  EXPECT_STREQ(LatencyPhaseName(LatencyPhase::kDelivery), "delivery");
+  EXPECT_STREQ(LinkCounterName(LinkCounter::kBytesSent), "bytesSent");
+  EXPECT_STREQ(LinkCounterName(LinkCounter::kWriteFailures), "writeFailures");
+  EXPECT_STREQ(LinkCounterName(LinkCounter::kDroppedBytes), "droppedBytes");
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
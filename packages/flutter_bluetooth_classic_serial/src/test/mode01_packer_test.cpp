@@ -0,0 +1,205 @@
+#include "mode01_packer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "elm327_emulator.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Lines = std::vector<std::string>;
+using Bytes = std::vector<std::uint8_t>;
+using std::chrono::milliseconds;
+
+// The reply lines the emulator sends for |command|, without the prompt.
+Lines Reply(Elm327Emulator* emulator, const std::string& command) {
+  std::string text;
+  for (const auto& chunk : emulator->Execute(command).chunks) text += chunk.text;
+  Lines lines;
+  std::string line;
+  for (char c : text) {
+    if (c == '\r' || c == '\n' || c == '>') {
+      if (!line.empty()) lines.push_back(line);
+      line.clear();
+    } else {
+      line.push_back(c);
+    }
+  }
+  return lines;
+}
+
+Elm327Emulator RamEmulator(const Lines& settings) {
+  EmulatorProfile profile = RamCumminsProfile();
+  for (auto& ecu : profile.ecus) ecu.latency = {};
+  Elm327Emulator emulator(profile);
+  for (const auto& command : {"ATZ", "ATE0", "ATL0", "ATSP7"}) emulator.Execute(command);
+  for (const auto& command : settings) emulator.Execute(command);
+  return emulator;
+}
+
+const Bytes* Find(const std::vector<Mode01PidData>& ecu, std::uint8_t pid) {
+  for (const auto& data : ecu) {
+    if (data.pid == pid) return &data.bytes;
+  }
+  return nullptr;
+}
+
+TEST(SplitMode01ReplyTest, SplitsTheEmulatorsMultiFrameReplies) {
+  const Bytes pids = {0x0C, 0x0D, 0x05, 0x42, 0x0F, 0x10};
+  for (const Lines& settings : {Lines{"ATS0", "ATH1"}, Lines{"ATS1", "ATH1"},
+                                Lines{"ATS0", "ATH0"}, Lines{"ATS1", "ATH0"}}) {
+    Elm327Emulator emulator = RamEmulator(settings);
+    const Lines lines = Reply(&emulator, "010C0D05420F10");
+    ASSERT_GT(lines.size(), 2u) << settings[0] << settings[1];
+
+    Mode01Reply reply;
+    ASSERT_TRUE(SplitMode01Reply(lines, pids, &reply)) << settings[0] << settings[1];
+    // The engine answers every PID; the TCM's 7F only sets the flag
+    ASSERT_EQ(reply.ecus.size(), 1u);
+    EXPECT_TRUE(reply.negative);
+    const auto& engine = reply.ecus[0];
+    ASSERT_EQ(engine.size(), pids.size());
+    for (std::size_t i = 0; i < pids.size(); ++i) EXPECT_EQ(engine[i].pid, pids[i]);
+    EXPECT_EQ(*Find(engine, 0x0C), (Bytes{0x1A, 0xF8}));
+    EXPECT_EQ(*Find(engine, 0x0D), (Bytes{0x37}));
+    EXPECT_EQ(*Find(engine, 0x05), (Bytes{0x7B}));
+    EXPECT_EQ(*Find(engine, 0x42), (Bytes{0x36, 0xB0}));
+    EXPECT_EQ(Find(engine, 0x10)->size(), 2u);
+  }
+}
+
+TEST(SplitMode01ReplyTest, ReassemblesElevenBitFramesPerEcu) {
+  const Lines lines = {
+      "7E8 10 08 41 0C 1A F8 0D 37",
+      "7E9 03 41 0D 38 AA AA AA AA",  // second ECU, single frame with padding
+      "7E8 21 05 7B 00 00 00 00 00",
+  };
+  Mode01Reply reply;
+  ASSERT_TRUE(SplitMode01Reply(lines, {0x0C, 0x0D, 0x05}, &reply));
+  EXPECT_FALSE(reply.negative);
+  ASSERT_EQ(reply.ecus.size(), 2u);
+  ASSERT_EQ(reply.ecus[0].size(), 3u);
+  EXPECT_EQ(*Find(reply.ecus[0], 0x05), (Bytes{0x7B}));
+  ASSERT_EQ(reply.ecus[1].size(), 1u);
+  EXPECT_EQ(*Find(reply.ecus[1], 0x0D), (Bytes{0x38}));
+}
+
+TEST(SplitMode01ReplyTest, StopsAtUnrequestedOrShortPids) {
+  Mode01Reply reply;
+  // 0x11 was not requested, so nothing after it can be trusted
+  ASSERT_TRUE(SplitMode01Reply({"410C1AF8110D37"}, {0x0C, 0x0D}, &reply));
+  ASSERT_EQ(reply.ecus.size(), 1u);
+  EXPECT_EQ(reply.ecus[0].size(), 1u);
+
+  // RPM needs two bytes
+  ASSERT_TRUE(SplitMode01Reply({"410D37 0C1A"}, {0x0C, 0x0D}, &reply));
+  ASSERT_EQ(reply.ecus[0].size(), 1u);
+  EXPECT_EQ(reply.ecus[0][0].pid, 0x0D);
+
+  EXPECT_FALSE(SplitMode01Reply({"NO DATA"}, {0x0C, 0x0D}, &reply));
+  EXPECT_FALSE(SplitMode01Reply({"18DAF1180 37F0112"}, {0x0C, 0x0D}, &reply));
+  EXPECT_TRUE(reply.negative);
+  EXPECT_FALSE(SplitMode01Reply({"SEARCHING...", "7E8 0 3 41 0C"}, {0x0C}, &reply));
+}
+
+TEST(Mode01PackerTest, PacksSinglePidsOfEachPeriodUpToSix) {
+  Mode01Packer packer;
+  std::vector<PollEntry> entries = {
+      {"010C", milliseconds(100)}, {"010D", milliseconds(100)}, {"0105", milliseconds(1000)},
+      {"22A09F", milliseconds(100)}, {"0104", milliseconds(100)}, {"0149", milliseconds(100)},
+      {"0178", milliseconds(100)},  {"0100", milliseconds(100)}, {"0110", milliseconds(100)},
+      {"0142", milliseconds(100)},  {"010F", milliseconds(2000)}, {"010F", milliseconds(100)},
+  };
+
+  // Unchanged unless asked to pack
+  auto schedule = packer.Pack(entries, false);
+  ASSERT_EQ(schedule.size(), entries.size());
+  EXPECT_TRUE(packer.PidsOf("010C0D").empty());
+
+  schedule = packer.Pack(entries);
+  std::vector<std::string> commands;
+  for (const auto& entry : schedule) commands.push_back(entry.command);
+  // Mode 22 and the bitmap PID pass through, a duplicate PID stays single,
+  // and a period with one PID keeps its command
+  EXPECT_EQ(commands, (std::vector<std::string>{"22A09F", "0100", "010F", "010C0D04497810",
+                                                "0142", "0105", "010F"}));
+  EXPECT_EQ(schedule[3].period, milliseconds(100));
+  EXPECT_EQ(packer.PidsOf("010C0D04497810"), (Bytes{0x0C, 0x0D, 0x04, 0x49, 0x78, 0x10}));
+  EXPECT_TRUE(packer.PidsOf("0142").empty());
+}
+
+TEST(Mode01PackerTest, SplitsSamplesPerPidAndFallsBackWhenRejected) {
+  Mode01Packer packer;
+  auto schedule = packer.Pack({{"010C", milliseconds(100)},
+                               {"010D", milliseconds(100)},
+                               {"0105", milliseconds(100)}});
+  ASSERT_EQ(schedule.size(), 1u);
+  ASSERT_EQ(schedule[0].command, "010C0D05");
+
+  std::vector<CommandResult> samples;
+  CommandResult other;
+  other.command = "22A09F";
+  EXPECT_EQ(packer.Split(std::move(other), &samples), Mode01Packer::SplitOutcome::kPassThrough);
+  EXPECT_TRUE(samples.empty());
+
+  // Two ECUs answer RPM, nobody answers coolant
+  CommandResult sample;
+  sample.command = "010C0D05";
+  sample.lines = {"18DAF110 06 41 0C 1A F8 0D 37 AA", "18DAF11A 04 41 0C 1B 00 AA AA AA",
+                  "18DAF118 03 7F 01 12 AA AA AA AA"};
+  sample.elapsed = std::chrono::microseconds(41000);
+  ASSERT_EQ(packer.Split(std::move(sample), &samples), Mode01Packer::SplitOutcome::kSplit);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[0].command, "010C");
+  EXPECT_EQ(samples[0].lines, (Lines{"410C1AF8", "410C1B00"}));
+  EXPECT_EQ(samples[0].elapsed.count(), 41000);
+  EXPECT_EQ(samples[1].lines, (Lines{"410D37"}));
+  EXPECT_EQ(samples[2].command, "0105");
+  EXPECT_EQ(samples[2].lines, (Lines{"NO DATA"}));
+
+  // A timeout times every PID out
+  samples.clear();
+  CommandResult timeout;
+  timeout.command = "010C0D05";
+  timeout.status = CommandResult::Status::kTimedOut;
+  ASSERT_EQ(packer.Split(std::move(timeout), &samples), Mode01Packer::SplitOutcome::kSplit);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[1].status, CommandResult::Status::kTimedOut);
+
+  // A reply without data, e.g. from a sleeping ECU, fails each PID but
+  // keeps the group packed
+  for (const char* line : {"NO DATA", "CAN ERROR", "BUFFER FULL"}) {
+    samples.clear();
+    CommandResult empty;
+    empty.command = "010C0D05";
+    empty.lines = {line};
+    ASSERT_EQ(packer.Split(std::move(empty), &samples), Mode01Packer::SplitOutcome::kSplit);
+    ASSERT_EQ(samples.size(), 3u);
+    EXPECT_EQ(samples[0].lines, (Lines{line}));
+    EXPECT_EQ(samples[2].lines, (Lines{line}));
+  }
+  EXPECT_EQ(packer.PidsOf("010C0D05").size(), 3u);
+
+  // An ECU that only takes one PID per request
+  samples.clear();
+  CommandResult rejected;
+  rejected.command = "010C0D05";
+  rejected.lines = {"7E8 03 7F 01 12"};
+  ASSERT_EQ(packer.Split(std::move(rejected), &samples), Mode01Packer::SplitOutcome::kRejected);
+  EXPECT_TRUE(samples.empty());
+  schedule = packer.Repack();
+  ASSERT_EQ(schedule.size(), 3u);
+  EXPECT_EQ(schedule[0].command, "010C");
+  EXPECT_EQ(schedule[2].command, "0105");
+
+  // Rejections stick across new schedules until Reset()
+  EXPECT_EQ(packer.Pack({{"010C", milliseconds(100)}, {"010D", milliseconds(100)}}).size(), 2u);
+  packer.Reset();
+  EXPECT_EQ(packer.Pack({{"010C", milliseconds(100)}, {"010D", milliseconds(100)}}).size(), 1u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
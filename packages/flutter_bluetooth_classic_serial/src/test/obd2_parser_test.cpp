@@ -0,0 +1,103 @@
+#include "obd2_parser.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+
+// Expected values are what Obd2Parser.parseResponse / parseMode22Response
+// in lib/services/obd2_parser.dart return for the same input (null = none).
+struct GoldenCase {
+  const char* name;
+  const char* response;
+  bool mode22;
+  int id;    // PID, or data identifier for Mode 22
+  int mode;  // Mode 01-style requests only
+  bool has_data;
+  Bytes data;
+};
+
+const GoldenCase kGoldenCases[] = {
+    {"Plain", "41 0C 1A F8", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"WithPrompt", "41 0C 1A F8\r\r>", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"NoSpaces", "410C1AF8", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"LowerCase", "41 0c 1a f8", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"CanHeader", "7E8 04 41 0C 1A F8", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"OtherEcuNegative", "7E9 03 7F 01 12\r7E8 04 41 0C 1A F8", false, 0x0C, 0x01, true,
+     {0x1A, 0xF8}},
+    {"NegativeAndPositiveOnOneLine", "7F 01 12 41 0C 00 00", false, 0x0C, 0x01, true,
+     {0x00, 0x00}},
+    {"DataByte7F", "41 05 7F", false, 0x05, 0x01, true, {0x7F}},
+    {"OnlyNegative", "7F 01 12", false, 0x0C, 0x01, false, {}},
+    {"OddDigitDropped", "41 0C 1A F", false, 0x0C, 0x01, true, {0x1A}},
+    {"HeaderOnly", "41 0C", false, 0x0C, 0x01, false, {}},
+    {"OtherPid", "41 0D 37", false, 0x0C, 0x01, false, {}},
+    {"TrailingGarbage", "41 0C 1A F8 ZZ", false, 0x0C, 0x01, false, {}},
+    {"SplitOverLines", "41 0C\r1A F8", false, 0x0C, 0x01, true, {0x1A, 0xF8}},
+    {"NoData", "NO DATA", false, 0x0C, 0x01, false, {}},
+    {"UnableToConnect", "SEARCHING...\rUNABLE TO CONNECT", false, 0x0C, 0x01, false, {}},
+    {"Unknown", "?", false, 0x0C, 0x01, false, {}},
+    {"Stopped", "STOPPED", false, 0x0C, 0x01, false, {}},
+    {"ErrorAnywhereRejects", "41 0C 1A F8\rCAN ERROR", false, 0x0C, 0x01, false, {}},
+    {"BusInitRejects", "BUS INIT: ...OK\r41 0C 1A F8", false, 0x0C, 0x01, false, {}},
+    {"Empty", "", false, 0x0C, 0x01, false, {}},
+    {"PromptOnly", "\r>", false, 0x0C, 0x01, false, {}},
+    {"Mode09", "49 02 01 31 44 34", false, 0x02, 0x09, true, {0x01, 0x31, 0x44, 0x34}},
+    {"Mode09Long", "49 02 01 31 46 54 46 57 31 45 54 35 44 46 41 31 32 33 34 35", false, 0x02,
+     0x09, true,
+     {0x01, 0x31, 0x46, 0x54, 0x46, 0x57, 0x31, 0x45, 0x54, 0x35, 0x44, 0x46, 0x41, 0x31, 0x32,
+      0x33, 0x34, 0x35}},
+    {"Mode22", "62 A0 9F 12 34", true, 0xA09F, 0, true, {0x12, 0x34}},
+    {"Mode22Padded", "62 00 1C 05", true, 0x001C, 0, true, {0x05}},
+    {"Mode22Split", "62 A0\r9F 01 02", true, 0xA09F, 0, true, {0x01, 0x02}},
+    {"Mode22OtherEcuNegative", "7E9 03 7F 22 31\r7E8 05 62 A0 9F 12 34", true, 0xA09F, 0, true,
+     {0x12, 0x34}},
+    {"Mode22OtherDid", "62 A0 9E 12 34", true, 0xA09F, 0, false, {}},
+    {"Mode22NoData", "NO DATA", true, 0xA09F, 0, false, {}},
+};
+
+class Obd2ParserGoldenTest : public ::testing::TestWithParam<GoldenCase> {};
+
+TEST_P(Obd2ParserGoldenTest, MatchesDartParser) {
+  const GoldenCase& golden = GetParam();
+  std::string buffer = golden.response;
+  std::uint8_t out[64];
+  int count = golden.mode22
+                  ? ParseMode22Response(&buffer[0], buffer.size(), golden.id, out, sizeof(out))
+                  : ParseObd2Response(&buffer[0], buffer.size(), golden.id, out, sizeof(out),
+                                      golden.mode);
+  if (!golden.has_data) {
+    EXPECT_EQ(count, -1);
+    return;
+  }
+  ASSERT_GE(count, 0);
+  EXPECT_EQ(Bytes(out, out + count), golden.data);
+}
+
+INSTANTIATE_TEST_SUITE_P(Golden, Obd2ParserGoldenTest, ::testing::ValuesIn(kGoldenCases),
+                         [](const ::testing::TestParamInfo<GoldenCase>& info) {
+                           return std::string(info.param.name);
+                         });
+
+TEST(Obd2ParserTest, RejectsDataLargerThanTheOutputSpan) {
+  std::string buffer = "41 0C 1A F8";
+  std::uint8_t out[1];
+  EXPECT_EQ(ParseObd2Response(&buffer[0], buffer.size(), 0x0C, out, sizeof(out)), -1);
+}
+
+TEST(Obd2ParserTest, WritesNothingPastTheData) {
+  std::string buffer = "41 0D 37";
+  std::uint8_t out[4] = {0xAA, 0xAA, 0xAA, 0xAA};
+  ASSERT_EQ(ParseObd2Response(&buffer[0], buffer.size(), 0x0D, out, sizeof(out)), 1);
+  EXPECT_EQ(out[0], 0x37);
+  EXPECT_EQ(out[1], 0xAA);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,140 @@
+#include "pid_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using DartParser = std::function<double(const std::vector<int>& b)>;
+
+// The parser functions of lib/config/pid_config.dart, transliterated with
+// Dart's arithmetic (int operands until the first double or '/').
+const std::map<std::string, DartParser>& DartParsers() {
+  static const auto* parsers = new std::map<std::string, DartParser>{
+      {"_parseTemp", [](const auto& b) { return (b[0] - 40) * 9 / 5.0 + 32; }},
+      {"_parseRpm", [](const auto& b) { return ((b[0] * 256) + b[1]) / 4.0; }},
+      {"_parseSingleByte", [](const auto& b) { return static_cast<double>(b[0]); }},
+      {"_parseMaf", [](const auto& b) { return ((b[0] * 256) + b[1]) / 100.0; }},
+      {"_parseVoltage", [](const auto& b) { return ((b[0] * 256) + b[1]) / 1000.0; }},
+      {"_parseRuntime", [](const auto& b) { return static_cast<double>((b[0] * 256) + b[1]); }},
+      {"_parsePercent", [](const auto& b) { return b[0] * 100 / 255.0; }},
+      {"_parseBarometric", [](const auto& b) { return static_cast<double>(b[0]); }},
+      {"_parseRailPressureActual",
+       [](const auto& b) { return b.size() >= 5 ? (b[3] * 256 + b[4]) * 1.45 : 0; }},
+      {"_parseExhaustBackpressure",
+       [](const auto& b) { return b.size() >= 2 ? (b[0] * 256 + b[1]) * 0.01 : 0; }},
+      {"_parseTorquePercent", [](const auto& b) { return b[0] - 125.0; }},
+      {"_parseReferenceTorque",
+       [](const auto& b) { return static_cast<double>(b[0] * 256 + b[1]); }},
+      {"_parseEgtObd2",
+       [](const auto& b) { return ((b[0] * 256 + b[1]) / 10.0 - 40) * 9 / 5 + 32; }},
+      {"_parseDpfTemp",
+       [](const auto& b) { return ((b[0] * 256 + b[1]) / 10.0 - 40) * 9 / 5 + 32; }},
+      {"_parseIntercoolerOutletTemp",
+       [](const auto& b) {
+         return b.size() >= 3 ? ((b[1] * 256 + b[2]) / 10.0 - 40) * 9 / 5 + 32 : 0;
+       }},
+      {"_parseBoostPressureCtrl",
+       [](const auto& b) {
+         return b.size() >= 2 ? (b[0] * 256 + b[1]) * 0.03125 * 0.145038 : 0;
+       }},
+      {"_parseVgtCtrlObd",
+       [](const auto& b) { return b.size() >= 2 ? (b[0] * 256 + b[1]) * 100 / 65535.0 : 0; }},
+      {"_parseTurboInletPressure",
+       [](const auto& b) {
+         return b.size() >= 2 ? (b[0] * 256 + b[1]) * 0.03125 * 0.145038 : 0;
+       }},
+      {"_parseTurboInletTemp",
+       [](const auto& b) {
+         return b.size() >= 2 ? ((b[0] * 256 + b[1]) / 10.0 - 40) * 9 / 5 + 32 : 0;
+       }},
+      {"_parseRuntimeExtended",
+       [](const auto& b) {
+         return b.size() >= 2 ? static_cast<double>(b[0] * 256 + b[1]) : 0;
+       }},
+  };
+  return *parsers;
+}
+
+constexpr bool HasPid(int mode, int code) { return FindPid(mode, code) != nullptr; }
+
+static_assert(FindPid(0x01, 0x0C)->response_bytes == 2, "rpm is in the generated table");
+static_assert(!HasPid(0x01, 0x00), "PID 00 is not a value PID");
+
+TEST(PidDecoderTest, EveryKernelMatchesItsDartParserOverTheFullByteRange) {
+  for (const auto& pid : kPidTable) {
+    SCOPED_TRACE(pid.id);
+    auto reference = DartParsers().find(pid.parser);
+    ASSERT_NE(reference, DartParsers().end())
+        << pid.parser << " has no reference here; transliterate it from pid_config.dart";
+
+    // Alternating a and b over the data puts every (a, b) pair on every two
+    // adjacent bytes, which covers the full range of 8- and 16-bit kernels.
+    std::vector<int> dart_bytes(pid.response_bytes);
+    std::vector<std::uint8_t> bytes(pid.response_bytes);
+    int mismatches = 0;
+    for (int a = 0; a < 256; ++a) {
+      for (int b = 0; b < 256; ++b) {
+        for (int i = 0; i < pid.response_bytes; ++i) {
+          dart_bytes[i] = i % 2 == 0 ? a : b;
+          bytes[i] = static_cast<std::uint8_t>(dart_bytes[i]);
+        }
+        double value = -1;
+        ASSERT_TRUE(DecodePid(pid, bytes.data(), bytes.size(), &value));
+        const double expected = reference->second(dart_bytes);
+        if (value != expected && ++mismatches <= 5) {
+          ADD_FAILURE() << "bytes " << a << "," << b << ": " << value << " != " << expected;
+        }
+      }
+    }
+    EXPECT_EQ(mismatches, 0);
+  }
+}
+
+TEST(PidDecoderTest, ShortDataFails) {
+  const PidDescriptor* rpm = FindPid(0x01, 0x0C);
+  ASSERT_NE(rpm, nullptr);
+  const std::uint8_t bytes[] = {0x1A};
+  double value = 0;
+  EXPECT_FALSE(DecodePid(*rpm, bytes, sizeof(bytes), &value));
+}
+
+TEST(PidDecoderTest, GuardedKernelReturnsZeroWhenShort) {
+  // Called directly, a guarded kernel behaves like its Dart parser given a
+  // short list: 0 rather than a failure.
+  const PidDescriptor* rail = FindPid(0x01, 0x6D);
+  ASSERT_NE(rail, nullptr);
+  const std::uint8_t bytes[] = {0x00, 0x12, 0x34, 0x56};
+  double value = -1;
+  EXPECT_TRUE(rail->decode(bytes, sizeof(bytes), rail->formula, &value));
+  EXPECT_EQ(value, 0);
+  EXPECT_FALSE(DecodePid(*rail, bytes, sizeof(bytes), &value));
+}
+
+TEST(PidDecoderTest, ParsesAdapterTextToEngineeringUnits) {
+  const PidDescriptor* rpm = FindPid(0x01, 0x0C);
+  ASSERT_NE(rpm, nullptr);
+  char response[] = "7E9 03 7F 01 12\r7E8 04 41 0C 1A F8\r\r>";
+  double value = 0;
+  ASSERT_TRUE(ParsePidResponse(*rpm, response, std::strlen(response), &value));
+  EXPECT_EQ(value, 1726.0);
+
+  const PidDescriptor* coolant = FindPid(0x01, 0x05);
+  ASSERT_NE(coolant, nullptr);
+  char coolant_response[] = "41 05 7B";
+  ASSERT_TRUE(ParsePidResponse(*coolant, coolant_response, std::strlen(coolant_response), &value));
+  EXPECT_EQ(value, (0x7B - 40) * 9 / 5.0 + 32);
+
+  char no_data[] = "NO DATA\r\r>";
+  EXPECT_FALSE(ParsePidResponse(*rpm, no_data, std::strlen(no_data), &value));
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
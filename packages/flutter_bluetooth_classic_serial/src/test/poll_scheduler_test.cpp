@@ -0,0 +1,159 @@
+#include "poll_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Clock = PollScheduler::Clock;
+using std::chrono::milliseconds;
+
+// Runs the scheduler against a link where every command takes |service|,
+// returning how many samples each command got in |duration|.
+std::map<std::string, int> Simulate(PollScheduler* scheduler, milliseconds service,
+                                    milliseconds duration, Clock::time_point start) {
+  std::map<std::string, int> samples;
+  auto now = start;
+  while (now < start + duration) {
+    std::string command;
+    PollScheduler::Ticket ticket;
+    if (!scheduler->Next(now, &command, &ticket)) {
+      int wait = scheduler->MillisecondsUntilNextRelease(now);
+      now += milliseconds(wait > 0 ? wait : 1);
+      continue;
+    }
+    now += service;
+    scheduler->Complete(ticket, true, now);
+    ++samples[command];
+  }
+  return samples;
+}
+
+TEST(PollSchedulerTest, IdleWithoutSchedule) {
+  PollScheduler scheduler;
+  std::string command;
+  PollScheduler::Ticket ticket;
+  EXPECT_FALSE(scheduler.active());
+  EXPECT_FALSE(scheduler.Next(Clock::now(), &command, &ticket));
+  EXPECT_EQ(scheduler.MillisecondsUntilNextRelease(Clock::now()), -1);
+}
+
+TEST(PollSchedulerTest, PicksEarliestDeadlineFirst) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"0105", milliseconds(2000)}, {"010C", milliseconds(100)},
+                         {"010B", milliseconds(500)}},
+                        start);
+
+  std::vector<std::string> order;
+  std::string command;
+  PollScheduler::Ticket ticket;
+  while (scheduler.Next(start, &command, &ticket)) order.push_back(command);
+  EXPECT_EQ(order, std::vector<std::string>({"010C", "010B", "0105"}));
+}
+
+TEST(PollSchedulerTest, WaitsForTheNextRelease) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"010C", milliseconds(100)}}, start);
+
+  std::string command;
+  PollScheduler::Ticket ticket;
+  ASSERT_TRUE(scheduler.Next(start, &command, &ticket));
+  // In flight: nothing to wait for until it completes
+  EXPECT_EQ(scheduler.MillisecondsUntilNextRelease(start), -1);
+  scheduler.Complete(ticket, true, start + milliseconds(30));
+
+  EXPECT_EQ(scheduler.MillisecondsUntilNextRelease(start + milliseconds(30)), 70);
+  EXPECT_FALSE(scheduler.Next(start + milliseconds(30), &command, &ticket));
+  EXPECT_TRUE(scheduler.Next(start + milliseconds(100), &command, &ticket));
+}
+
+TEST(PollSchedulerTest, MeetsTargetRatesWhenLinkHasCapacity) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"fast", milliseconds(100)}, {"slow", milliseconds(1000)}}, start);
+
+  auto samples = Simulate(&scheduler, milliseconds(20), milliseconds(10000), start);
+  EXPECT_NEAR(samples["fast"], 100, 1);
+  EXPECT_NEAR(samples["slow"], 10, 1);
+
+  for (const auto& stats : scheduler.Stats()) {
+    EXPECT_EQ(stats.deadline_misses, 0u) << stats.command;
+    EXPECT_NEAR(static_cast<double>(stats.achieved_period.count()),
+                static_cast<double>(stats.target_period.count()) * 1000, 1000)
+        << stats.command;
+  }
+}
+
+TEST(PollSchedulerTest, FastTierKeepsItsRateWhenSlowTiersGrow) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  std::vector<PollEntry> entries = {{"rpm", milliseconds(200)}, {"boost", milliseconds(200)}};
+  for (int i = 0; i < 40; ++i) {
+    entries.push_back({"bg" + std::to_string(i), milliseconds(5000)});
+  }
+  scheduler.SetSchedule(entries, start);
+
+  // 40 ms per command: the fast pair needs 40% of the link, the 40
+  // background commands another 32%.
+  auto samples = Simulate(&scheduler, milliseconds(40), milliseconds(20000), start);
+  EXPECT_NEAR(samples["rpm"], 100, 2);
+  EXPECT_NEAR(samples["boost"], 100, 2);
+  EXPECT_NEAR(samples["bg0"], 4, 1);
+  EXPECT_NEAR(samples["bg39"], 4, 1);
+}
+
+TEST(PollSchedulerTest, OverloadDoesNotStarveLongPeriods) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"fast", milliseconds(50)}, {"slow", milliseconds(1000)}}, start);
+
+  // Each command takes longer than the fast period
+  auto samples = Simulate(&scheduler, milliseconds(100), milliseconds(10000), start);
+  EXPECT_GT(samples["slow"], 5);
+  EXPECT_GT(samples["fast"], 80);
+
+  auto stats = scheduler.Stats();
+  EXPECT_GT(stats[0].deadline_misses, 0u);
+}
+
+TEST(PollSchedulerTest, IgnoresCompletionsFromAReplacedSchedule) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"010C", milliseconds(100)}}, start);
+  std::string command;
+  PollScheduler::Ticket ticket;
+  ASSERT_TRUE(scheduler.Next(start, &command, &ticket));
+
+  scheduler.SetSchedule({{"010D", milliseconds(100)}}, start);
+  scheduler.Complete(ticket, true, start + milliseconds(10));
+  EXPECT_EQ(scheduler.Stats()[0].samples, 0u);
+}
+
+TEST(PollSchedulerTest, CountsTimeoutsAndResetsStats) {
+  PollScheduler scheduler;
+  auto start = Clock::now();
+  scheduler.SetSchedule({{"22F190", milliseconds(100)}}, start);
+  std::string command;
+  PollScheduler::Ticket ticket;
+  ASSERT_TRUE(scheduler.Next(start, &command, &ticket));
+  scheduler.Complete(ticket, false, start + milliseconds(100));
+
+  auto stats = scheduler.Stats();
+  EXPECT_EQ(stats[0].timeouts, 1u);
+  EXPECT_EQ(stats[0].samples, 0u);
+
+  scheduler.ResetStats();
+  stats = scheduler.Stats();
+  EXPECT_EQ(stats[0].timeouts, 0u);
+  EXPECT_EQ(stats[0].command, "22F190");
+  EXPECT_EQ(stats[0].target_period, milliseconds(100));
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
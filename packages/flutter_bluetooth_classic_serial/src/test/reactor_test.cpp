@@ -0,0 +1,85 @@
+#include "reactor.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "socket_pair.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::SocketPair;
+
+TEST(ReactorTest, TimesOutWithNoData) {
+  Reactor reactor;
+  SocketPair pair;
+  ASSERT_TRUE(reactor.IsValid());
+  ASSERT_TRUE(reactor.Add(pair.local, 7));
+
+  Reactor::Event events[4];
+  EXPECT_EQ(reactor.Wait(events, 4, 10), 0);
+}
+
+TEST(ReactorTest, ReportsReadableSocketWithToken) {
+  Reactor reactor;
+  SocketPair pair;
+  ASSERT_TRUE(reactor.Add(pair.local, 42));
+
+  ASSERT_EQ(write(pair.remote, "4", 1), 1);
+
+  Reactor::Event events[4];
+  ASSERT_EQ(reactor.Wait(events, 4, 1000), 1);
+  EXPECT_EQ(events[0].token, 42u);
+  EXPECT_TRUE(events[0].readable);
+  EXPECT_FALSE(events[0].hangup);
+}
+
+TEST(ReactorTest, ReportsHangupWhenPeerCloses) {
+  Reactor reactor;
+  SocketPair pair;
+  ASSERT_TRUE(reactor.Add(pair.local, 1));
+  pair.CloseRemote();
+
+  Reactor::Event events[4];
+  ASSERT_EQ(reactor.Wait(events, 4, 1000), 1);
+  EXPECT_TRUE(events[0].hangup);
+}
+
+TEST(ReactorTest, RemovedSocketIsNoLongerReported) {
+  Reactor reactor;
+  SocketPair pair;
+  ASSERT_TRUE(reactor.Add(pair.local, 1));
+  ASSERT_TRUE(reactor.Remove(pair.local));
+  ASSERT_EQ(write(pair.remote, "x", 1), 1);
+
+  Reactor::Event events[4];
+  EXPECT_EQ(reactor.Wait(events, 4, 10), 0);
+}
+
+TEST(ReactorTest, RejectsReservedWakeToken) {
+  Reactor reactor;
+  SocketPair pair;
+  EXPECT_FALSE(reactor.Add(pair.local, Reactor::kWakeToken));
+}
+
+TEST(ReactorTest, WakeInterruptsBlockingWait) {
+  Reactor reactor;
+  std::thread waker([&reactor]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    reactor.Wake();
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  Reactor::Event events[1];
+  EXPECT_EQ(reactor.Wait(events, 1, 5000), 0);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  waker.join();
+
+  EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,139 @@
+#include "response_counts.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using Lines = std::vector<std::string>;
+using std::chrono::microseconds;
+
+const Lines kEngineAndTcm = {"18DAF110 04 41 0C 1A F8", "18DAF118 03 7F 01 12"};
+const Lines kEngineOnly = {"18DAF110 04 41 0C 1A F8"};
+
+CommandResult Reply(const Lines& lines, microseconds elapsed = microseconds(55000)) {
+  CommandResult result;
+  result.lines = lines;
+  result.elapsed = elapsed;
+  return result;
+}
+
+// Sends |command| once and answers with |lines|; returns what was written.
+std::string RoundTrip(ResponseCounts* counts, const std::string& command, const Lines& lines,
+                      microseconds elapsed = microseconds(55000)) {
+  int count = 0;
+  std::string wire = counts->Apply(command, &count);
+  CommandResult result = Reply(lines, elapsed);
+  result.command = command;
+  counts->Observe(command, count, result);
+  return wire;
+}
+
+TEST(ResponseCountsTest, AppendsTheCountAfterIdenticalReplies) {
+  ResponseCounts counts;
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) {
+    EXPECT_EQ(RoundTrip(&counts, "010C", kEngineAndTcm), "010C");
+  }
+  EXPECT_EQ(RoundTrip(&counts, "010C", kEngineAndTcm, microseconds(35000)), "010C2");
+  EXPECT_EQ(RoundTrip(&counts, "010C", kEngineAndTcm, microseconds(35000)), "010C2");
+
+  // Only OBD requests without a count are touched
+  int count = -1;
+  for (const std::string command : {"ATRV", "AT SH 7E0", "STDI", "010C1", "01", "0"}) {
+    EXPECT_EQ(counts.Apply(command, &count), command);
+    EXPECT_EQ(count, 0);
+  }
+
+  auto snapshot = counts.Snapshot();
+  ASSERT_EQ(snapshot.size(), 1u);
+  EXPECT_EQ(snapshot[0].command, "010C");
+  EXPECT_EQ(snapshot[0].count, 2);
+  EXPECT_EQ(snapshot[0].open_replies, 3u);
+  EXPECT_EQ(snapshot[0].counted_replies, 2u);
+  EXPECT_EQ(snapshot[0].open_mean_us, 55000u);
+  EXPECT_EQ(snapshot[0].counted_mean_us, 35000u);
+  EXPECT_EQ(snapshot[0].saved_us, 20000u);
+}
+
+TEST(ResponseCountsTest, NeedsAStableCountOfCompleteMessages) {
+  ResponseCounts counts;
+  RoundTrip(&counts, "0902", kEngineOnly);
+  RoundTrip(&counts, "0902", kEngineAndTcm);
+  RoundTrip(&counts, "0902", kEngineOnly);
+  // A message missing frames never counts
+  RoundTrip(&counts, "0902", {"18DAF110 10 14 49 02 01 31 44 34"});
+  RoundTrip(&counts, "0902", kEngineOnly);
+  RoundTrip(&counts, "0902", {"NO DATA"});
+  RoundTrip(&counts, "0902", kEngineOnly);
+  EXPECT_EQ(RoundTrip(&counts, "0902", kEngineOnly), "0902");
+  EXPECT_EQ(RoundTrip(&counts, "0902", kEngineOnly), "0902");
+  EXPECT_EQ(RoundTrip(&counts, "0902", kEngineOnly), "09021");
+}
+
+TEST(ResponseCountsTest, DropsTheCountWhenRespondersChange) {
+  ResponseCounts counts;
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) RoundTrip(&counts, "22A09F", kEngineAndTcm);
+  ASSERT_EQ(RoundTrip(&counts, "22A09F", kEngineAndTcm), "22A09F2");
+
+  // The TCM went quiet: the adapter waited out ATST for it
+  EXPECT_EQ(RoundTrip(&counts, "22A09F", kEngineOnly), "22A09F2");
+  EXPECT_EQ(RoundTrip(&counts, "22A09F", kEngineOnly), "22A09F");
+  EXPECT_EQ(counts.Snapshot()[0].relearns, 1);
+  for (int i = 0; i < ResponseCounts::kLearnReplies - 1; ++i) RoundTrip(&counts, "22A09F", kEngineOnly);
+  EXPECT_EQ(RoundTrip(&counts, "22A09F", kEngineOnly), "22A09F1");
+
+  // A timeout with a count also means the count is off
+  int count = 0;
+  ASSERT_EQ(counts.Apply("22A09F", &count), "22A09F1");
+  CommandResult timeout;
+  timeout.status = CommandResult::Status::kTimedOut;
+  counts.Observe("22A09F", count, timeout);
+  EXPECT_EQ(counts.Snapshot()[0].relearns, 2);
+  EXPECT_EQ(counts.Apply("22A09F", &count), "22A09F");
+}
+
+TEST(ResponseCountsTest, RechecksOpenEndedAndGivesUpOnUnstableCommands) {
+  ResponseCounts counts;
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) RoundTrip(&counts, "010D", kEngineOnly);
+  std::size_t open = 0;
+  for (std::uint32_t i = 0; i < ResponseCounts::kRecheckInterval; ++i) {
+    if (RoundTrip(&counts, "010D", kEngineOnly) == "010D") ++open;
+  }
+  EXPECT_EQ(open, 1u);
+
+  // The responders keep changing
+  for (int relearn = 0; relearn < ResponseCounts::kMaxRelearns; ++relearn) {
+    const Lines& lines = relearn % 2 == 0 ? kEngineAndTcm : kEngineOnly;
+    while (RoundTrip(&counts, "010D", lines).size() == 5) {
+    }
+    for (int i = 0; i < ResponseCounts::kLearnReplies - 1; ++i) RoundTrip(&counts, "010D", lines);
+    if (relearn + 1 < ResponseCounts::kMaxRelearns) {
+      ASSERT_EQ(RoundTrip(&counts, "010D", relearn % 2 == 0 ? kEngineOnly : kEngineAndTcm).size(),
+                5u);
+    }
+  }
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(RoundTrip(&counts, "010D", kEngineOnly), "010D");
+  EXPECT_EQ(counts.Snapshot()[0].relearns, ResponseCounts::kMaxRelearns);
+}
+
+TEST(ResponseCountsTest, StopsCountingOnAdaptersThatRejectIt) {
+  ResponseCounts counts;
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) {
+    RoundTrip(&counts, "010C", kEngineOnly);
+    RoundTrip(&counts, "010D", kEngineOnly);
+  }
+  ASSERT_EQ(RoundTrip(&counts, "010C", {"?"}), "010C1");
+  EXPECT_EQ(RoundTrip(&counts, "010D", kEngineOnly), "010D");
+  EXPECT_EQ(RoundTrip(&counts, "010C", kEngineOnly), "010C");
+
+  counts.Reset();
+  EXPECT_TRUE(counts.Snapshot().empty());
+  for (int i = 0; i < ResponseCounts::kLearnReplies; ++i) RoundTrip(&counts, "010C", kEngineOnly);
+  EXPECT_EQ(RoundTrip(&counts, "010C", kEngineOnly), "010C1");
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
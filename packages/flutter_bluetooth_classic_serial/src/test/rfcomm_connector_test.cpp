@@ -0,0 +1,323 @@
+#include "rfcomm_connector.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using std::chrono::milliseconds;
+using Clock = ConnectTransport::Clock;
+
+constexpr int kRefused = ECONNREFUSED;
+
+// Simulated remote device on a simulated clock. Every channel not scripted
+// refuses after |refuse_delay|, like an adapter with nothing listening.
+class FakeDevice : public ConnectTransport {
+ public:
+  enum class Kind { kAccept, kRefuse, kHang, kStartFails };
+
+  void SetAdvertisedChannel(int channel, milliseconds lookup_time) {
+    advertised_ = channel;
+    lookup_time_ = lookup_time;
+  }
+  void Script(int channel, Kind kind, milliseconds delay = milliseconds(0)) {
+    channels_[channel] = {kind, delay};
+  }
+  void set_refuse_delay(milliseconds delay) { refuse_delay_ = delay; }
+
+  Clock::time_point Now() override { return now_; }
+
+  int LookupServiceChannel() override {
+    now_ += lookup_time_;
+    return advertised_;
+  }
+
+  NativeSocket StartConnect(int channel, int* error) override {
+    attempted_.push_back(channel);
+    Behaviour behaviour{Kind::kRefuse, refuse_delay_};
+    auto it = channels_.find(channel);
+    if (it != channels_.end()) behaviour = it->second;
+    if (behaviour.kind == Kind::kStartFails) {
+      *error = EHOSTUNREACH;
+      return kInvalidSocket;
+    }
+
+    Socket socket;
+    socket.channel = channel;
+    socket.done_at = behaviour.kind == Kind::kHang ? Clock::time_point::max() : now_ + behaviour.delay;
+    socket.outcome = behaviour.kind == Kind::kAccept ? 0 : kRefused;
+    sockets_.push_back(socket);
+    max_open_ = std::max(max_open_, ++open_);
+    return static_cast<NativeSocket>(sockets_.size() - 1);
+  }
+
+  int WaitConnect(const NativeSocket* sockets, int* results, std::size_t count,
+                  int timeout_ms) override {
+    Clock::time_point until = now_ + milliseconds(timeout_ms);
+    for (std::size_t i = 0; i < count; ++i) until = std::min(until, sockets_[sockets[i]].done_at);
+    now_ = until;
+
+    int finished = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      const Socket& socket = sockets_[sockets[i]];
+      if (socket.done_at <= now_) {
+        results[i] = socket.outcome;
+        ++finished;
+      }
+    }
+    return finished;
+  }
+
+  void Close(NativeSocket socket) override {
+    ASSERT_TRUE(sockets_[socket].open);
+    sockets_[socket].open = false;
+    --open_;
+  }
+
+  int ChannelOf(NativeSocket socket) const { return sockets_[socket].channel; }
+  const std::vector<int>& attempted() const { return attempted_; }
+  int open() const { return open_; }
+  int max_open() const { return max_open_; }
+
+ private:
+  struct Behaviour {
+    Kind kind;
+    milliseconds delay;
+  };
+  struct Socket {
+    int channel = 0;
+    Clock::time_point done_at;
+    int outcome = 0;
+    bool open = true;
+  };
+
+  Clock::time_point now_ = Clock::time_point() + std::chrono::hours(1);
+  int advertised_ = -1;
+  milliseconds lookup_time_{0};
+  milliseconds refuse_delay_{1500};
+  std::map<int, Behaviour> channels_;
+  std::vector<Socket> sockets_;
+  std::vector<int> attempted_;
+  int open_ = 0;
+  int max_open_ = 0;
+};
+
+TEST(RfcommConnectorTest, UsesTheAdvertisedChannel) {
+  FakeDevice device;
+  device.SetAdvertisedChannel(5, milliseconds(300));
+  device.Script(5, FakeDevice::Kind::kAccept, milliseconds(800));
+
+  RfcommConnectResult result = ConnectRfcomm(&device, RfcommConnectOptions());
+
+  ASSERT_NE(result.socket, kInvalidSocket);
+  EXPECT_EQ(result.channel, 5);
+  EXPECT_EQ(device.ChannelOf(result.socket), 5);
+  EXPECT_TRUE(result.from_service_lookup);
+  EXPECT_EQ(device.attempted(), std::vector<int>{5});
+  EXPECT_EQ(result.elapsed, milliseconds(1100));
+  EXPECT_EQ(device.open(), 1);
+}
+
+TEST(RfcommConnectorTest, TriesTheCachedChannelBeforeTheLookup) {
+  FakeDevice device;
+  device.SetAdvertisedChannel(5, milliseconds(2000));
+  device.Script(5, FakeDevice::Kind::kAccept, milliseconds(800));
+
+  RfcommConnectOptions options;
+  options.cached_channel = 5;
+  RfcommConnectResult result = ConnectRfcomm(&device, options);
+
+  EXPECT_EQ(result.channel, 5);
+  EXPECT_TRUE(result.from_cache);
+  // No SDP round trip
+  EXPECT_EQ(result.elapsed, milliseconds(800));
+}
+
+TEST(RfcommConnectorTest, StaleCachedChannelFallsBackToTheLookup) {
+  FakeDevice device;
+  device.SetAdvertisedChannel(2, milliseconds(300));
+  device.Script(4, FakeDevice::Kind::kRefuse, milliseconds(200));
+  device.Script(2, FakeDevice::Kind::kAccept, milliseconds(500));
+
+  RfcommConnectOptions options;
+  options.cached_channel = 4;
+  RfcommConnectResult result = ConnectRfcomm(&device, options);
+
+  EXPECT_EQ(result.channel, 2);
+  EXPECT_FALSE(result.from_cache);
+  EXPECT_TRUE(result.from_service_lookup);
+  EXPECT_EQ(device.attempted(), (std::vector<int>{4, 2}));
+}
+
+TEST(RfcommConnectorTest, ProbesChannelsInParallelWithoutServiceRecord) {
+  FakeDevice device;
+  device.Script(7, FakeDevice::Kind::kAccept, milliseconds(900));
+
+  RfcommConnectOptions options;
+  options.max_parallel = 4;
+  RfcommConnectResult result = ConnectRfcomm(&device, options);
+
+  ASSERT_NE(result.socket, kInvalidSocket);
+  EXPECT_EQ(result.channel, 7);
+  EXPECT_FALSE(result.from_service_lookup);
+  EXPECT_EQ(result.last_error, kRefused);
+  // Channels 1-4 refuse at 1.5 s, then 5-8 start and 7 answers 0.9 s later
+  EXPECT_EQ(result.elapsed, milliseconds(2400));
+  EXPECT_EQ(device.max_open(), 4);
+  EXPECT_EQ(device.open(), 1);
+}
+
+TEST(RfcommConnectorTest, ParallelProbingBeatsTheSequentialScan) {
+  auto time_to_connect = [](std::size_t max_parallel) {
+    FakeDevice device;
+    device.Script(7, FakeDevice::Kind::kAccept, milliseconds(900));
+    RfcommConnectOptions options;
+    options.max_parallel = max_parallel;
+    return ConnectRfcomm(&device, options).elapsed;
+  };
+
+  // One blocking connect per channel, as the old connect loop did
+  EXPECT_EQ(time_to_connect(1), milliseconds(6 * 1500 + 900));
+  EXPECT_LT(time_to_connect(4) * 3, time_to_connect(1));
+}
+
+TEST(RfcommConnectorTest, AbandonsAHangingChannelAfterTheAttemptTimeout) {
+  FakeDevice device;
+  device.Script(1, FakeDevice::Kind::kHang);
+  device.Script(2, FakeDevice::Kind::kAccept, milliseconds(500));
+
+  RfcommConnectOptions options;
+  options.max_parallel = 1;
+  options.attempt_timeout = milliseconds(4000);
+  RfcommConnectResult result = ConnectRfcomm(&device, options);
+
+  EXPECT_EQ(result.channel, 2);
+  EXPECT_EQ(result.elapsed, milliseconds(4500));
+  EXPECT_EQ(device.open(), 1);
+}
+
+TEST(RfcommConnectorTest, FallsBackToProbingWhenTheAdvertisedChannelFails) {
+  FakeDevice device;
+  device.SetAdvertisedChannel(3, milliseconds(200));
+  device.Script(3, FakeDevice::Kind::kRefuse, milliseconds(100));
+  device.Script(1, FakeDevice::Kind::kAccept, milliseconds(700));
+
+  RfcommConnectResult result = ConnectRfcomm(&device, RfcommConnectOptions());
+
+  EXPECT_EQ(result.channel, 1);
+  EXPECT_FALSE(result.from_service_lookup);
+  // The advertised channel is not probed a second time
+  EXPECT_EQ(std::count(device.attempted().begin(), device.attempted().end(), 3), 1);
+  EXPECT_EQ(result.elapsed, milliseconds(1000));
+}
+
+TEST(RfcommConnectorTest, PrefersTheLowestChannelWhenSeveralConnectTogether) {
+  FakeDevice device;
+  device.Script(4, FakeDevice::Kind::kAccept, milliseconds(1000));
+  device.Script(2, FakeDevice::Kind::kAccept, milliseconds(1000));
+
+  RfcommConnectResult result = ConnectRfcomm(&device, RfcommConnectOptions());
+
+  EXPECT_EQ(result.channel, 2);
+  EXPECT_EQ(device.open(), 1);
+}
+
+TEST(RfcommConnectorTest, SkipsChannelsThatFailToStart) {
+  FakeDevice device;
+  device.Script(1, FakeDevice::Kind::kStartFails);
+  device.Script(2, FakeDevice::Kind::kAccept, milliseconds(300));
+
+  RfcommConnectResult result = ConnectRfcomm(&device, RfcommConnectOptions());
+
+  EXPECT_EQ(result.channel, 2);
+  EXPECT_EQ(result.elapsed, milliseconds(300));
+}
+
+TEST(RfcommConnectorTest, GivesUpAtTheDeadlineAndClosesEverySocket) {
+  FakeDevice device;
+  for (int channel = 1; channel <= 30; ++channel) device.Script(channel, FakeDevice::Kind::kHang);
+
+  RfcommConnectOptions options;
+  options.attempt_timeout = milliseconds(4000);
+  options.deadline = milliseconds(10000);
+  RfcommConnectResult result = ConnectRfcomm(&device, options);
+
+  EXPECT_EQ(result.socket, kInvalidSocket);
+  EXPECT_EQ(result.elapsed, milliseconds(10000));
+  // Two rounds of four abandoned at 4 s and 8 s, a third cut off at 10 s
+  EXPECT_EQ(result.attempts, 12);
+  EXPECT_EQ(device.open(), 0);
+}
+
+// Real non-blocking connects over loopback TCP, through the default
+// WaitConnect (WaitForConnect).
+class LoopbackTransport : public ConnectTransport {
+ public:
+  explicit LoopbackTransport(std::map<int, int> ports) : ports_(std::move(ports)) {}
+
+  int LookupServiceChannel() override { return -1; }
+
+  NativeSocket StartConnect(int channel, int* error) override {
+    NativeSocket socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    SetNonBlocking(socket, true);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(ports_[channel]));
+    if (connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 &&
+        errno != EINPROGRESS) {
+      *error = errno;
+      close(socket);
+      return kInvalidSocket;
+    }
+    return socket;
+  }
+
+ private:
+  std::map<int, int> ports_;
+};
+
+// Binds a loopback port; listening or not.
+int BindLoopback(bool listen_on_it, NativeSocket* out) {
+  NativeSocket socket = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+  if (listen_on_it) listen(socket, 4);
+  socklen_t size = sizeof(address);
+  getsockname(socket, reinterpret_cast<sockaddr*>(&address), &size);
+  *out = socket;
+  return ntohs(address.sin_port);
+}
+
+TEST(RfcommConnectorTest, ConnectsOverRealNonBlockingSockets) {
+  NativeSocket closed;
+  NativeSocket listening;
+  const int closed_port = BindLoopback(false, &closed);
+  const int listening_port = BindLoopback(true, &listening);
+
+  LoopbackTransport transport({{1, closed_port}, {2, listening_port}});
+  RfcommConnectOptions options;
+  options.last_channel = 2;
+  RfcommConnectResult result = ConnectRfcomm(&transport, options);
+
+  EXPECT_EQ(result.channel, 2);
+  EXPECT_NE(result.socket, kInvalidSocket);
+  CloseNativeSocket(result.socket);
+  CloseNativeSocket(closed);
+  CloseNativeSocket(listening);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
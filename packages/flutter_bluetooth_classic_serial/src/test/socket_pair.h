@@ -0,0 +1,49 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_TEST_SOCKET_PAIR_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_TEST_SOCKET_PAIR_H_
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "native_socket.h"
+
+namespace flutter_bluetooth_classic {
+namespace testing {
+
+// Connected AF_UNIX stream pair standing in for an RFCOMM socket: |local| is
+// handed to the code under test, |remote| plays the adapter.
+class SocketPair {
+ public:
+  SocketPair() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0) {
+      local = fds[0];
+      remote = fds[1];
+    }
+  }
+  ~SocketPair() {
+    CloseLocal();
+    CloseRemote();
+  }
+
+  SocketPair(const SocketPair&) = delete;
+  SocketPair& operator=(const SocketPair&) = delete;
+
+  bool IsValid() const { return local != kInvalidSocket && remote != kInvalidSocket; }
+
+  void CloseLocal() {
+    CloseNativeSocket(local);
+    local = kInvalidSocket;
+  }
+  void CloseRemote() {
+    CloseNativeSocket(remote);
+    remote = kInvalidSocket;
+  }
+
+  NativeSocket local = kInvalidSocket;
+  NativeSocket remote = kInvalidSocket;
+};
+
+}  // namespace testing
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_TEST_SOCKET_PAIR_H_
@@ -0,0 +1,131 @@
+#include "trace_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+TEST(TraceRingTest, DumpFormatsEventsOldestFirst) {
+  TraceRing ring(16);
+  const char address[] = "00:1D:A5:68:98:8B";
+  ring.Record<TraceLevel::kInfo>(TraceKind::kConnectAttempt, 0, 5, 0, address,
+                                 sizeof(address) - 1);
+  ring.Record<TraceLevel::kInfo>(TraceKind::kConnected, 0, 5, 412);
+  const std::string reply = "41 0C 1A F8\r\r>";
+  ring.Record<TraceLevel::kDebug>(TraceKind::kRecv, 3, static_cast<std::int64_t>(reply.size()),
+                                  0, reply.data(), reply.size());
+
+  auto events = ring.Snapshot(16);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].kind, TraceKind::kConnectAttempt);
+  EXPECT_EQ(events[2].connection, 3u);
+  EXPECT_LE(events[0].time_ns, events[2].time_ns);
+
+  std::string dump = ring.Dump(16);
+  EXPECT_NE(dump.find("I #0 connect cached_channel=5 \"00:1D:A5:68:98:8B\"\n"), std::string::npos)
+      << dump;
+  EXPECT_NE(dump.find("connected channel=5 ms=412\n"), std::string::npos) << dump;
+  EXPECT_NE(dump.find("D #3 recv bytes=14 \"41 0C 1A F8[13][13]>\"\n"), std::string::npos)
+      << dump;
+}
+
+TEST(TraceRingTest, LongPayloadsAreTruncated) {
+  TraceRing ring(4);
+  std::string data(100, 'A');
+  ring.Record<TraceLevel::kDebug>(TraceKind::kWrite, 1, 100, 0, data.data(), data.size());
+
+  auto events = ring.Snapshot(1);
+  ASSERT_EQ(events.size(), 1u);
+  EXPECT_EQ(events[0].payload_length, TraceEvent::kPayloadBytes);
+  EXPECT_EQ(events[0].value, 100);
+  std::string line = FormatTraceEvent(events[0]);
+  EXPECT_NE(line.find("\"" + std::string(TraceEvent::kPayloadBytes, 'A') + "\"..."),
+            std::string::npos)
+      << line;
+}
+
+TEST(TraceRingTest, FullRingKeepsTheNewestEvents) {
+  TraceRing ring(5);
+  EXPECT_EQ(ring.capacity(), 8u);
+  for (int i = 0; i < 20; ++i) {
+    ring.Record<TraceLevel::kError>(TraceKind::kError, 0, i);
+  }
+
+  EXPECT_EQ(ring.recorded(), 20u);
+  auto events = ring.Snapshot(100);
+  ASSERT_EQ(events.size(), 8u);
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(events[i].value, 12 + i);
+
+  events = ring.Snapshot(3);
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].value, 17);
+}
+
+TEST(TraceRingTest, LevelsAboveTheLimitAreDisabled) {
+  static_assert(TraceLevelEnabled(TraceLevel::kError, 1), "");
+  static_assert(!TraceLevelEnabled(TraceLevel::kInfo, 1), "");
+  static_assert(!TraceLevelEnabled(TraceLevel::kError, 0), "");
+  static_assert(TraceLevelEnabled(TraceLevel::kDebug, 3), "");
+
+  TraceRing ring(4);
+  ring.Record<TraceLevel::kDebug>(TraceKind::kRecv, 0, 1);
+  EXPECT_EQ(ring.recorded(),
+            TraceLevelEnabled(TraceLevel::kDebug) ? 1u : 0u);
+}
+
+TEST(TraceRingTest, ConcurrentWritersNeverProduceTornEvents) {
+  TraceRing ring(256);
+  constexpr int kWriters = 4;
+  constexpr int kEventsPerWriter = 20000;
+  std::atomic<bool> done{false};
+
+  // Each event's payload repeats its value, so a torn copy shows up as a
+  // mismatch.
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; ++w) {
+    writers.emplace_back([&ring, w]() {
+      for (int i = 0; i < kEventsPerWriter; ++i) {
+        std::int64_t value = static_cast<std::int64_t>(w) * kEventsPerWriter + i;
+        std::uint8_t payload[TraceEvent::kPayloadBytes];
+        for (std::size_t b = 0; b < sizeof(payload); ++b) {
+          payload[b] = static_cast<std::uint8_t>(value + b);
+        }
+        ring.Record<TraceLevel::kError>(TraceKind::kWrite, static_cast<std::uint32_t>(w), value,
+                                        static_cast<std::int32_t>(value), payload,
+                                        sizeof(payload));
+      }
+    });
+  }
+
+  std::size_t checked = 0;
+  std::thread reader([&]() {
+    while (!done.load()) {
+      for (const auto& event : ring.Snapshot(256)) {
+        ASSERT_EQ(event.detail, static_cast<std::int32_t>(event.value));
+        ASSERT_EQ(event.connection, static_cast<std::uint32_t>(event.value / kEventsPerWriter));
+        for (std::size_t b = 0; b < event.payload_length; ++b) {
+          ASSERT_EQ(event.payload[b], static_cast<std::uint8_t>(event.value + b));
+        }
+        ++checked;
+      }
+    }
+  });
+
+  for (auto& writer : writers) writer.join();
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(ring.recorded(), static_cast<std::uint64_t>(kWriters) * kEventsPerWriter);
+  // A writer preempted for a whole lap may cost one of the newest events
+  EXPECT_GE(ring.Snapshot(256).size() + ring.dropped(), 256u);
+  EXPECT_GT(checked, 0u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
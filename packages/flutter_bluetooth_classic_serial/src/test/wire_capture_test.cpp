@@ -0,0 +1,169 @@
+#include "wire_capture.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using std::chrono::microseconds;
+
+// A capture file of the running test's own, so tests run in parallel do
+// not write over each other's.
+std::string TempCapturePath() {
+  return ::testing::TempDir() + ::testing::UnitTest::GetInstance()->current_test_info()->name() +
+         "_" + std::to_string(getpid()) + ".ccwire";
+}
+
+WireCapture SampleCapture() {
+  WireCapture capture;
+  capture.label = "00:1D:A5:68:98:8B";
+  capture.started_unix_ms = 1791000000123;
+  capture.records.push_back({microseconds(0), WireDirection::kSent, "010C\r"});
+  capture.records.push_back({microseconds(41250), WireDirection::kReceived, "41 0C 1A"});
+  capture.records.push_back({microseconds(43000), WireDirection::kReceived, " F8\r\r>"});
+  capture.records.push_back({microseconds(5000000), WireDirection::kSent, "ATRV\r"});
+  return capture;
+}
+
+std::string Encode(const WireCapture& capture) {
+  std::string bytes;
+  EncodeWireHeader(capture.label, capture.started_unix_ms, &bytes);
+  microseconds previous{0};
+  for (const auto& record : capture.records) {
+    EncodeWireRecord(record.at - previous, record.direction, record.data.data(),
+                     record.data.size(), &bytes);
+    previous = record.at;
+  }
+  return bytes;
+}
+
+void ExpectSameRecords(const WireCapture& actual, const WireCapture& expected) {
+  EXPECT_EQ(actual.label, expected.label);
+  EXPECT_EQ(actual.started_unix_ms, expected.started_unix_ms);
+  ASSERT_EQ(actual.records.size(), expected.records.size());
+  for (std::size_t i = 0; i < expected.records.size(); ++i) {
+    EXPECT_EQ(actual.records[i].at, expected.records[i].at) << i;
+    EXPECT_EQ(actual.records[i].direction, expected.records[i].direction) << i;
+    EXPECT_EQ(actual.records[i].data, expected.records[i].data) << i;
+  }
+}
+
+TEST(WireCaptureTest, RoundTripsRecords) {
+  const WireCapture expected = SampleCapture();
+  const std::string bytes = Encode(expected);
+
+  WireCapture parsed;
+  ASSERT_TRUE(ParseWireCapture(bytes, &parsed));
+  ExpectSameRecords(parsed, expected);
+
+  // 18 header bytes plus 3-5 bytes of framing per record
+  std::size_t payload = expected.label.size();
+  for (const auto& record : expected.records) payload += record.data.size();
+  EXPECT_LE(bytes.size(), payload + 18 + 4 * 5);
+
+  const std::string path = TempCapturePath();
+  ASSERT_TRUE(WriteWireCapture(path, expected));
+  WireCapture read;
+  ASSERT_TRUE(ReadWireCapture(path, &read));
+  ExpectSameRecords(read, expected);
+  std::remove(path.c_str());
+}
+
+TEST(WireCaptureTest, DropsATruncatedLastRecord) {
+  const WireCapture expected = SampleCapture();
+  const std::string bytes = Encode(expected);
+
+  WireCapture parsed;
+  ASSERT_TRUE(ParseWireCapture(bytes.substr(0, bytes.size() - 2), &parsed));
+  ASSERT_EQ(parsed.records.size(), expected.records.size() - 1);
+  EXPECT_EQ(parsed.records.back().data, " F8\r\r>");
+}
+
+TEST(WireCaptureTest, RejectsMalformedFiles) {
+  WireCapture parsed;
+  EXPECT_FALSE(ParseWireCapture("", &parsed));
+  EXPECT_FALSE(ParseWireCapture("NOTWIRE-and-some-more-bytes", &parsed));
+
+  std::string bytes = Encode(SampleCapture());
+  std::string wrong_version = bytes;
+  wrong_version[6] = 2;
+  EXPECT_FALSE(ParseWireCapture(wrong_version, &parsed));
+
+  // Direction byte of the first record
+  std::string bad_direction = bytes;
+  bad_direction[18 + SampleCapture().label.size() + 1] = 7;
+  EXPECT_FALSE(ParseWireCapture(bad_direction, &parsed));
+
+  EXPECT_FALSE(ReadWireCapture(::testing::TempDir() + "missing.ccwire", &parsed));
+}
+
+TEST(WireCaptureTest, WriterRecordsOnlyWhileOpen) {
+  const std::string path = TempCapturePath();
+  WireCaptureWriter writer;
+  writer.Record(WireDirection::kSent, "ATZ\r", 4);
+  EXPECT_FALSE(writer.is_open());
+
+  ASSERT_TRUE(writer.Open(path, "AA:BB:CC:DD:EE:FF"));
+  writer.Record(WireDirection::kSent, "010C\r", 5);
+  writer.Record(WireDirection::kReceived, "41 0C 1A F8\r\r>", 14);
+  writer.Record(WireDirection::kReceived, "", 0);
+  EXPECT_EQ(writer.records(), 2u);
+  ASSERT_TRUE(writer.Close());
+  writer.Record(WireDirection::kSent, "0105\r", 5);
+
+  WireCapture capture;
+  ASSERT_TRUE(ReadWireCapture(path, &capture));
+  EXPECT_EQ(capture.label, "AA:BB:CC:DD:EE:FF");
+  EXPECT_GT(capture.started_unix_ms, 0);
+  ASSERT_EQ(capture.records.size(), 2u);
+  EXPECT_EQ(capture.records[0].direction, WireDirection::kSent);
+  EXPECT_EQ(capture.records[0].data, "010C\r");
+  EXPECT_EQ(capture.records[1].direction, WireDirection::kReceived);
+  EXPECT_EQ(capture.records[1].data, "41 0C 1A F8\r\r>");
+  EXPECT_LE(capture.records[0].at, capture.records[1].at);
+  std::remove(path.c_str());
+}
+
+TEST(WireCaptureTest, ConcurrentRecordsStayIntact) {
+  const std::string path = TempCapturePath();
+  WireCaptureWriter writer;
+  ASSERT_TRUE(writer.Open(path, "concurrent"));
+
+  constexpr int kRecordsPerThread = 2000;
+  auto record = [&writer](WireDirection direction, char fill) {
+    for (int i = 0; i < kRecordsPerThread; ++i) {
+      const std::string data(1 + i % 40, fill);
+      writer.Record(direction, data.data(), data.size());
+    }
+  };
+  std::thread sender(record, WireDirection::kSent, 'S');
+  std::thread receiver(record, WireDirection::kReceived, 'R');
+  sender.join();
+  receiver.join();
+  ASSERT_TRUE(writer.Close());
+
+  WireCapture capture;
+  ASSERT_TRUE(ReadWireCapture(path, &capture));
+  ASSERT_EQ(capture.records.size(), 2u * kRecordsPerThread);
+  int sent = 0;
+  for (std::size_t i = 0; i < capture.records.size(); ++i) {
+    const auto& r = capture.records[i];
+    const char fill = r.direction == WireDirection::kSent ? 'S' : 'R';
+    if (r.direction == WireDirection::kSent) ++sent;
+    EXPECT_EQ(r.data, std::string(r.data.size(), fill));
+    if (i > 0) {
+      EXPECT_GE(r.at, capture.records[i - 1].at);
+    }
+  }
+  EXPECT_EQ(sent, kRecordsPerThread);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,300 @@
+#include "wire_replay.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "command_pipeline.h"
+#include "elm327_framer.h"
+#include "receive_loop.h"
+#include "socket_pair.h"
+#include "wire_capture.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::SocketPair;
+using Clock = std::chrono::steady_clock;
+using Lines = std::vector<std::string>;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+// The plugin's receive stack on the host end of |socket|: receive loop,
+// ELM327 framer and command pipeline, optionally capturing the wire the way
+// the plugin does.
+class HostStack {
+ public:
+  HostStack(NativeSocket socket, WireCaptureWriter* capture)
+      : socket_(socket),
+        capture_(capture),
+        pipeline_([this](const std::string& data) { return Write(data); }),
+        loop_(
+            socket,
+            [this](const std::uint8_t* data, std::size_t length) {
+              if (capture_) capture_->Record(WireDirection::kReceived, data, length);
+              framer_.Feed(data, length, Clock::now(), &completed_);
+              for (auto& response : completed_) pipeline_.OnResponse(std::move(response));
+              completed_.clear();
+            },
+            nullptr) {
+    loop_.SetTimerHandler([this]() { return pipeline_.OnTimer(Clock::now()); });
+    loop_.Start();
+  }
+  ~HostStack() { loop_.Stop(); }
+
+  std::vector<CommandResult> Run(Lines commands, milliseconds timeout = milliseconds(1000)) {
+    std::vector<CommandResult> results;
+    bool done = false;
+    pipeline_.Submit(std::move(commands), timeout, [&](std::vector<CommandResult>&& batch) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      results = std::move(batch);
+      done = true;
+      cv_.notify_all();
+    });
+    loop_.Wake();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::seconds(5), [&]() { return done; });
+    return results;
+  }
+
+ private:
+  bool Write(const std::string& data) {
+    if (capture_) capture_->Record(WireDirection::kSent, data.data(), data.size());
+    return SendSome(socket_, reinterpret_cast<const std::uint8_t*>(data.data()), data.size()) ==
+           static_cast<int>(data.size());
+  }
+
+  NativeSocket socket_;
+  WireCaptureWriter* capture_;
+  Elm327Framer framer_;
+  std::vector<ElmResponse> completed_;
+  CommandPipeline pipeline_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  ReceiveLoop loop_;
+};
+
+// Answers each command like an ELM327 after ATE0, with Mode 01 replies split
+// across two writes the way RFCOMM often delivers them.
+void RunAdapter(NativeSocket socket) {
+  char buffer[256];
+  std::string command;
+  for (;;) {
+    ssize_t received = read(socket, buffer, sizeof(buffer));
+    if (received <= 0) return;
+    for (ssize_t i = 0; i < received; ++i) {
+      if (buffer[i] != '\r') {
+        command.push_back(buffer[i]);
+        continue;
+      }
+      if (command.rfind("01", 0) == 0) {
+        const std::string head = "41 " + command.substr(2, 2);
+        if (write(socket, head.data(), head.size()) < 0) return;
+        std::this_thread::sleep_for(milliseconds(2));
+        const std::string tail = " 1A F8\r\r>";
+        if (write(socket, tail.data(), tail.size()) < 0) return;
+      } else {
+        const std::string reply = "OK\r\r>";
+        if (write(socket, reply.data(), reply.size()) < 0) return;
+      }
+      command.clear();
+    }
+  }
+}
+
+const Lines kSession = {"ATE0", "ATSP0", "010C", "010D", "0105", "010C"};
+
+// Drives kSession against the scripted adapter and returns the capture.
+WireCapture RecordSession(std::vector<CommandResult>* results) {
+  // Named after the running test, so tests run in parallel do not share it
+  const std::string path = ::testing::TempDir() +
+                           ::testing::UnitTest::GetInstance()->current_test_info()->name() + "_" +
+                           std::to_string(getpid()) + ".ccwire";
+  WireCaptureWriter writer;
+  EXPECT_TRUE(writer.Open(path, "2026 Ram 2500"));
+  {
+    SocketPair pair;
+    std::thread adapter(RunAdapter, pair.remote);
+    {
+      HostStack host(pair.local, &writer);
+      *results = host.Run(kSession);
+    }
+    shutdown(pair.local, SHUT_RDWR);
+    adapter.join();
+  }
+  EXPECT_TRUE(writer.Close());
+
+  WireCapture capture;
+  EXPECT_TRUE(ReadWireCapture(path, &capture));
+  std::remove(path.c_str());
+  return capture;
+}
+
+// Runs |commands| against a replay of |capture|.
+ReplayReport Replay(const WireCapture& capture, ReplayOptions options, const Lines& commands,
+                    std::vector<CommandResult>* results,
+                    milliseconds timeout = milliseconds(1000)) {
+  SocketPair pair;
+  WireReplay replay(capture, options);
+  ReplayReport report;
+  std::thread adapter([&]() { report = replay.Run(pair.remote); });
+  {
+    HostStack host(pair.local, nullptr);
+    *results = host.Run(commands, timeout);
+  }
+  shutdown(pair.local, SHUT_RDWR);
+  adapter.join();
+  return report;
+}
+
+WireCapture OneCommandCapture(microseconds reply_after) {
+  WireCapture capture;
+  capture.records.push_back({microseconds(1000), WireDirection::kSent, "010C\r"});
+  capture.records.push_back(
+      {microseconds(1000) + reply_after, WireDirection::kReceived, "41 0C 1A F8\r\r>"});
+  return capture;
+}
+
+TEST(WireReplayTest, ScriptSplitsCommandsAcrossWrites) {
+  WireCapture capture;
+  capture.records.push_back({microseconds(0), WireDirection::kReceived, "ELM327 v1.5\r\r>"});
+  capture.records.push_back({microseconds(10), WireDirection::kSent, "AT"});
+  capture.records.push_back({microseconds(20), WireDirection::kSent, "Z\r010C\r"});
+  capture.records.push_back({microseconds(30), WireDirection::kReceived, "41 0C"});
+  capture.records.push_back({microseconds(40), WireDirection::kReceived, " 1A F8\r\r>"});
+  capture.records.push_back({microseconds(50), WireDirection::kSent, "\r"});
+
+  auto script = BuildReplayScript(capture);
+  ASSERT_EQ(script.size(), 4u);
+  EXPECT_FALSE(script[0].expects_command);
+  ASSERT_EQ(script[0].replies.size(), 1u);
+  EXPECT_EQ(script[1].command, "ATZ");
+  EXPECT_TRUE(script[1].replies.empty());
+  EXPECT_EQ(script[2].command, "010C");
+  EXPECT_EQ(script[2].sent_at, microseconds(20));
+  ASSERT_EQ(script[2].replies.size(), 2u);
+  EXPECT_EQ(script[2].replies[1].data, " 1A F8\r\r>");
+  EXPECT_EQ(script[3].command, "");
+}
+
+TEST(WireReplayTest, RecordedSessionReplaysThroughTheReceiveStack) {
+  std::vector<CommandResult> recorded;
+  const WireCapture capture = RecordSession(&recorded);
+  ASSERT_EQ(recorded.size(), kSession.size());
+  EXPECT_EQ(recorded[2].lines, Lines({"41 0C 1A F8"}));
+  EXPECT_EQ(capture.label, "2026 Ram 2500");
+
+  std::vector<CommandResult> replayed;
+  ReplayOptions options;
+  options.speed = 0;
+  const ReplayReport report = Replay(capture, options, kSession, &replayed);
+
+  EXPECT_TRUE(report.completed);
+  EXPECT_TRUE(report.divergences.empty());
+  EXPECT_EQ(report.commands_expected, kSession.size());
+  EXPECT_EQ(report.commands_matched, kSession.size());
+  ASSERT_EQ(replayed.size(), recorded.size());
+  for (std::size_t i = 0; i < recorded.size(); ++i) {
+    EXPECT_EQ(replayed[i].status, CommandResult::Status::kOk) << i;
+    EXPECT_EQ(replayed[i].lines, recorded[i].lines) << i;
+  }
+}
+
+TEST(WireReplayTest, ReportsTheFirstDivergentCommand) {
+  std::vector<CommandResult> recorded;
+  const WireCapture capture = RecordSession(&recorded);
+
+  // Spacing and case differences are not divergences
+  Lines commands = {"AT E0", "atsp0", "010C", "0111", "0105", "010C"};
+  std::vector<CommandResult> replayed;
+  ReplayOptions options;
+  options.speed = 0;
+  const ReplayReport report = Replay(capture, options, commands, &replayed, milliseconds(100));
+
+  EXPECT_FALSE(report.completed);
+  EXPECT_FALSE(report.stalled);
+  EXPECT_EQ(report.commands_matched, 3u);
+  ASSERT_EQ(report.divergences.size(), 1u);
+  EXPECT_EQ(report.divergences[0].index, 3u);
+  EXPECT_EQ(report.divergences[0].expected, "010D");
+  EXPECT_EQ(report.divergences[0].actual, "0111");
+  ASSERT_EQ(replayed.size(), commands.size());
+  EXPECT_EQ(replayed[3].status, CommandResult::Status::kTimedOut);
+}
+
+TEST(WireReplayTest, KeepsGoingUpToTheDivergenceLimit) {
+  std::vector<CommandResult> recorded;
+  const WireCapture capture = RecordSession(&recorded);
+
+  Lines commands = kSession;
+  commands[3] = "0111";
+  commands[4] = "0142";
+  std::vector<CommandResult> replayed;
+  ReplayOptions options;
+  options.speed = 0;
+  options.max_divergences = 10;
+  const ReplayReport report = Replay(capture, options, commands, &replayed);
+
+  EXPECT_TRUE(report.completed);
+  EXPECT_EQ(report.commands_matched, kSession.size() - 2);
+  ASSERT_EQ(report.divergences.size(), 2u);
+  EXPECT_EQ(report.divergences[1].index, 4u);
+  // The captured replies still went out
+  EXPECT_EQ(replayed[4].lines, recorded[4].lines);
+}
+
+TEST(WireReplayTest, PacesRepliesByTheSpeedFactor) {
+  // Lower bounds only: an upper one would time the machine, not the replay
+  const WireCapture capture = OneCommandCapture(microseconds(120000));
+  std::vector<CommandResult> results;
+
+  ReplayOptions real_time;
+  ASSERT_TRUE(Replay(capture, real_time, {"010C"}, &results).completed);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_GE(results[0].elapsed, milliseconds(110));
+
+  ReplayOptions four_times;
+  four_times.speed = 4;
+  ASSERT_TRUE(Replay(capture, four_times, {"010C"}, &results).completed);
+  EXPECT_GE(results[0].elapsed, milliseconds(25));
+
+  ReplayOptions unthrottled;
+  unthrottled.speed = 0;
+  ASSERT_TRUE(Replay(capture, unthrottled, {"010C"}, &results).completed);
+  EXPECT_EQ(results[0].lines, Lines({"41 0C 1A F8"}));
+}
+
+TEST(WireReplayTest, StallsWhenTheHostStopsSending) {
+  WireCapture capture = OneCommandCapture(microseconds(0));
+  capture.records.push_back({microseconds(5000), WireDirection::kSent, "010D\r"});
+
+  std::vector<CommandResult> results;
+  ReplayOptions options;
+  options.speed = 0;
+  options.stall_timeout = milliseconds(50);
+  SocketPair pair;
+  WireReplay replay(capture, options);
+  ReplayReport report;
+  std::thread adapter([&]() { report = replay.Run(pair.remote); });
+  {
+    HostStack host(pair.local, nullptr);
+    results = host.Run({"010C"});
+    adapter.join();
+  }
+
+  EXPECT_TRUE(report.stalled);
+  EXPECT_FALSE(report.completed);
+  EXPECT_EQ(report.commands_expected, 2u);
+  EXPECT_EQ(report.commands_matched, 1u);
+  EXPECT_EQ(report.bytes_sent, 14u);
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,188 @@
+#include "write_queue.h"
+
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "connection_reactor.h"
+#include "socket_pair.h"
+
+namespace flutter_bluetooth_classic {
+namespace {
+
+using testing::SocketPair;
+
+std::vector<std::uint8_t> Bytes(const std::string& text) {
+  return std::vector<std::uint8_t>(text.begin(), text.end());
+}
+
+// Reads whatever |socket| has within |timeout_ms|.
+std::string ReadAvailable(NativeSocket socket, int timeout_ms = 100) {
+  std::string received;
+  pollfd fd = {socket, POLLIN, 0};
+  while (poll(&fd, 1, timeout_ms) > 0) {
+    char buffer[65536];
+    ssize_t n = recv(socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (n <= 0) break;
+    received.append(buffer, static_cast<std::size_t>(n));
+    timeout_ms = 0;
+  }
+  return received;
+}
+
+// Shrinks the pair's buffers so a few KB fill the socket.
+void ShrinkBuffers(const SocketPair& pair) {
+  int size = 4096;
+  setsockopt(pair.local, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  setsockopt(pair.remote, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+TEST(WriteQueueTest, IdleWriteGoesStraightToTheSocket) {
+  SocketPair pair;
+  ASSERT_TRUE(SetNonBlocking(pair.local, true));
+  WriteQueue queue;
+  queue.Reset(pair.local);
+
+  ASSERT_TRUE(queue.Write(Bytes("010C\r").data(), 5));
+
+  EXPECT_EQ(ReadAvailable(pair.remote), "010C\r");
+  EXPECT_EQ(queue.pending_bytes(), 0u);
+  EXPECT_EQ(queue.stats().send_calls, 1u);
+  EXPECT_EQ(queue.stats().gather_sends, 0u);
+}
+
+TEST(WriteQueueTest, CorkedWritesLeaveInOneGatherSend) {
+  SocketPair pair;
+  ASSERT_TRUE(SetNonBlocking(pair.local, true));
+  WriteQueue queue;
+  queue.Reset(pair.local);
+
+  queue.Cork();
+  const std::vector<std::string> commands = {"010C\r", "010D\r", "0105\r", "22A09F\r"};
+  for (const auto& command : commands) {
+    ASSERT_TRUE(queue.Write(Bytes(command)));
+  }
+  EXPECT_EQ(queue.stats().send_calls, 0u);
+  ASSERT_TRUE(queue.Uncork());
+
+  EXPECT_EQ(ReadAvailable(pair.remote), "010C\r010D\r0105\r22A09F\r");
+  EXPECT_EQ(queue.stats().writes, 4u);
+  EXPECT_EQ(queue.stats().send_calls, 1u);
+  EXPECT_EQ(queue.stats().gather_sends, 1u);
+}
+
+TEST(WriteQueueTest, NestedCorkSendsOnTheOutermostUncork) {
+  SocketPair pair;
+  ASSERT_TRUE(SetNonBlocking(pair.local, true));
+  WriteQueue queue;
+  queue.Reset(pair.local);
+
+  queue.Cork();
+  queue.Cork();
+  ASSERT_TRUE(queue.Write(Bytes("AT")));
+  ASSERT_TRUE(queue.Uncork());
+  EXPECT_EQ(queue.pending_bytes(), 2u);
+  ASSERT_TRUE(queue.Write(Bytes("Z\r")));
+  ASSERT_TRUE(queue.Uncork());
+
+  EXPECT_EQ(ReadAvailable(pair.remote), "ATZ\r");
+}
+
+TEST(WriteQueueTest, PartialSendsResumeInOrder) {
+  SocketPair pair;
+  ShrinkBuffers(pair);
+  ASSERT_TRUE(SetNonBlocking(pair.local, true));
+  std::vector<bool> backlog_changes;
+  WriteQueue queue([&](bool backlogged) { backlog_changes.push_back(backlogged); });
+  queue.Reset(pair.local);
+
+  // Far more than the socket buffers hold: one block the socket can only
+  // take part of, then command-sized pieces that queue behind it.
+  std::string expected(65536, 'x');
+  ASSERT_TRUE(queue.Write(reinterpret_cast<const std::uint8_t*>(expected.data()),
+                          expected.size()));
+  for (int i = 0; i < 4000; ++i) {
+    std::string command = std::to_string(i) + "\r";
+    expected += command;
+    ASSERT_TRUE(queue.Write(reinterpret_cast<const std::uint8_t*>(command.data()),
+                            command.size()));
+  }
+  ASSERT_GT(queue.pending_bytes(), 0u);
+
+  std::string received;
+  while (received.size() < expected.size()) {
+    std::string chunk = ReadAvailable(pair.remote);
+    ASSERT_FALSE(chunk.empty() && queue.pending_bytes() == 0) << "stalled";
+    received += chunk;
+    ASSERT_TRUE(queue.Flush());
+  }
+
+  EXPECT_EQ(received, expected);
+  EXPECT_EQ(queue.pending_bytes(), 0u);
+  EXPECT_GT(queue.stats().partial_sends, 0u);
+  EXPECT_GT(queue.stats().gather_sends, 0u);
+  EXPECT_EQ(queue.stats().bytes_sent, expected.size());
+  ASSERT_EQ(backlog_changes.size(), 2u);
+  EXPECT_TRUE(backlog_changes[0]);
+  EXPECT_FALSE(backlog_changes[1]);
+}
+
+TEST(WriteQueueTest, ClosedPeerFailsTheQueue) {
+  SocketPair pair;
+  ASSERT_TRUE(SetNonBlocking(pair.local, true));
+  WriteQueue queue;
+  queue.Reset(pair.local);
+  pair.CloseRemote();
+
+  EXPECT_FALSE(queue.Write(Bytes("ATZ\r")));
+  EXPECT_TRUE(queue.failed());
+  EXPECT_FALSE(queue.Write(Bytes("ATZ\r")));
+
+  // A new socket starts clean.
+  SocketPair next;
+  queue.Reset(next.local);
+  EXPECT_FALSE(queue.failed());
+  EXPECT_TRUE(queue.Write(Bytes("ATZ\r")));
+}
+
+TEST(WriteQueueTest, ReactorFlushesTheBacklogWhenWritable) {
+  SocketPair pair;
+  ShrinkBuffers(pair);
+  ConnectionReactor reactor;
+  ASSERT_TRUE(reactor.Start());
+  std::atomic<ConnectionReactor::ConnectionId> id{ConnectionReactor::kInvalidConnection};
+
+  WriteQueue queue([&](bool backlogged) { reactor.SetWriteInterest(id, backlogged); });
+  ConnectionReactor::Handlers handlers;
+  handlers.on_writable = [&]() { queue.Flush(); };
+  id = reactor.Add(pair.local, std::move(handlers));
+  ASSERT_NE(id, ConnectionReactor::kInvalidConnection);
+  queue.Reset(pair.local);
+
+  std::string expected;
+  for (int i = 0; i < 4000; ++i) {
+    std::string command = "01" + std::to_string(i % 100) + "\r";
+    expected += command;
+    ASSERT_TRUE(queue.Write(reinterpret_cast<const std::uint8_t*>(command.data()),
+                            command.size()));
+  }
+
+  // Only reading here; the reactor thread does all the flushing.
+  std::string received;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (received.size() < expected.size() && std::chrono::steady_clock::now() < deadline) {
+    received += ReadAvailable(pair.remote, 10);
+  }
+  EXPECT_EQ(received, expected);
+  EXPECT_EQ(queue.pending_bytes(), 0u);
+  reactor.Shutdown();
+}
+
+}  // namespace
+}  // namespace flutter_bluetooth_classic
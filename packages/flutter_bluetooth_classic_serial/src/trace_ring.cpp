@@ -0,0 +1,182 @@
+#include "trace_ring.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+// Names of |value| and |detail| per kind; null when unused.
+struct KindFormat {
+  const char* name;
+  const char* value;
+  const char* detail;
+};
+
+KindFormat FormatOf(TraceKind kind) {
+  switch (kind) {
+    case TraceKind::kRecv:
+      return {"recv", "bytes", nullptr};
+    case TraceKind::kRead:
+      return {"read", "bytes", nullptr};
+    case TraceKind::kWrite:
+      return {"write", "bytes", nullptr};
+    case TraceKind::kWriteFailed:
+      return {"write_failed", "bytes", "error"};
+    case TraceKind::kConnectAttempt:
+      return {"connect", "cached_channel", nullptr};
+    case TraceKind::kConnected:
+      return {"connected", "channel", "ms"};
+    case TraceKind::kConnectFailed:
+      return {"connect_failed", "error", "ms"};
+    case TraceKind::kClosed:
+      return {"closed", "error", nullptr};
+    case TraceKind::kOverflow:
+      return {"overflow", "dropped", nullptr};
+    case TraceKind::kError:
+      return {"error", "code", nullptr};
+  }
+  return {"unknown", "value", "detail"};
+}
+
+const char* LevelName(TraceLevel level) {
+  switch (level) {
+    case TraceLevel::kError:
+      return "E";
+    case TraceLevel::kInfo:
+      return "I";
+    case TraceLevel::kDebug:
+      return "D";
+  }
+  return "?";
+}
+
+}  // namespace
+
+TraceRing::TraceRing(std::size_t capacity)
+    : slots_(new Slot[RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1))]),
+      mask_(RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1)) - 1),
+      epoch_(std::chrono::steady_clock::now()) {}
+
+void TraceRing::Append(TraceLevel level, TraceKind kind, std::uint32_t connection,
+                       std::int64_t value, std::int32_t detail, const void* payload,
+                       std::size_t payload_length) {
+  TraceEvent event;
+  event.time_ns = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                           epoch_)
+          .count());
+  event.value = value;
+  event.connection = connection;
+  event.detail = detail;
+  event.kind = kind;
+  event.level = level;
+  if (payload != nullptr) {
+    event.payload_length =
+        static_cast<std::uint8_t>(std::min(payload_length, TraceEvent::kPayloadBytes));
+    std::memcpy(event.payload, payload, event.payload_length);
+  }
+
+  std::uint64_t words[kWords];
+  std::memcpy(words, &event, sizeof(event));
+
+  const std::uint64_t ticket = head_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[ticket & mask_];
+  // Only a writer a lap or more behind finds the slot being written or
+  // holding a newer event; writing as well would tear one of them
+  std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  do {
+    if ((sequence & 1) != 0 || sequence > 2 * ticket) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!slot.sequence.compare_exchange_weak(sequence, 2 * ticket + 1,
+                                                std::memory_order_relaxed));
+  std::atomic_thread_fence(std::memory_order_release);
+  for (std::size_t i = 0; i < kWords; ++i) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+}
+
+std::vector<TraceEvent> TraceRing::Snapshot(std::size_t max_events) const {
+  const std::uint64_t head = head_.load(std::memory_order_acquire);
+  const std::uint64_t count = std::min<std::uint64_t>({head, capacity(), max_events});
+
+  std::vector<TraceEvent> events;
+  events.reserve(static_cast<std::size_t>(count));
+  for (std::uint64_t ticket = head - count; ticket < head; ++ticket) {
+    const Slot& slot = slots_[ticket & mask_];
+    const std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    // Still being written, or already overwritten by a newer event
+    if (before != 2 * ticket + 2) continue;
+
+    std::uint64_t words[kWords];
+    for (std::size_t i = 0; i < kWords; ++i) {
+      words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+
+    TraceEvent event;
+    std::memcpy(&event, words, sizeof(event));
+    events.push_back(event);
+  }
+  return events;
+}
+
+std::string TraceRing::Dump(std::size_t max_events) const {
+  std::string text;
+  for (const auto& event : Snapshot(max_events)) {
+    text += FormatTraceEvent(event);
+    text += '\n';
+  }
+  return text;
+}
+
+const char* TraceKindName(TraceKind kind) { return FormatOf(kind).name; }
+
+std::string FormatTraceEvent(const TraceEvent& event) {
+  const KindFormat format = FormatOf(event.kind);
+  char line[128];
+  std::snprintf(line, sizeof(line), "%12.6f %s #%" PRIu32 " %s %s=%" PRId64,
+                static_cast<double>(event.time_ns) / 1e9, LevelName(event.level),
+                event.connection, format.name, format.value, event.value);
+  std::string text(line);
+  if (format.detail != nullptr) {
+    std::snprintf(line, sizeof(line), " %s=%" PRId32, format.detail, event.detail);
+    text += line;
+  }
+
+  if (event.payload_length > 0) {
+    // Printable bytes as is, the rest as [nn] like the old debug output
+    text += " \"";
+    for (std::size_t i = 0; i < event.payload_length; ++i) {
+      const std::uint8_t byte = event.payload[i];
+      if (byte >= 32 && byte <= 126 && byte != '"') {
+        text += static_cast<char>(byte);
+      } else {
+        std::snprintf(line, sizeof(line), "[%u]", static_cast<unsigned>(byte));
+        text += line;
+      }
+    }
+    text += '"';
+    const bool data = event.kind == TraceKind::kRecv || event.kind == TraceKind::kRead ||
+                      event.kind == TraceKind::kWrite;
+    if (data && event.value > event.payload_length) {
+      text += "...";
+    }
+  }
+  return text;
+}
+
+}  // namespace flutter_bluetooth_classic
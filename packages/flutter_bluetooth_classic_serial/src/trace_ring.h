@@ -0,0 +1,127 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_TRACE_RING_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_TRACE_RING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Highest trace level compiled in: 0 off, 1 errors, 2 info, 3 debug. Set by
+// the build (BLUETOOTH_CLASSIC_TRACE_LEVEL); records above it compile to
+// nothing.
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_TRACE_LEVEL
+#define FLUTTER_BLUETOOTH_CLASSIC_TRACE_LEVEL 3
+#endif
+
+namespace flutter_bluetooth_classic {
+
+enum class TraceLevel : std::uint8_t { kError = 1, kInfo = 2, kDebug = 3 };
+
+constexpr bool TraceLevelEnabled(TraceLevel level,
+                                 int max_level = FLUTTER_BLUETOOTH_CLASSIC_TRACE_LEVEL) {
+  return static_cast<int>(level) <= max_level;
+}
+
+enum class TraceKind : std::uint8_t {
+  kRecv,
+  kRead,
+  kWrite,
+  kWriteFailed,
+  kConnectAttempt,
+  kConnected,
+  kConnectFailed,
+  kClosed,
+  kOverflow,
+  kError,
+};
+
+// One traced event. |value| and |detail| depend on the kind (byte count,
+// channel, error code, elapsed ms); the payload holds the first bytes of
+// the data or a short text such as the device address.
+struct TraceEvent {
+  static constexpr std::size_t kPayloadBytes = 36;
+
+  // Since the ring was created, from the steady clock.
+  std::uint64_t time_ns = 0;
+  std::int64_t value = 0;
+  std::uint32_t connection = 0;
+  std::int32_t detail = 0;
+  TraceKind kind = TraceKind::kError;
+  TraceLevel level = TraceLevel::kError;
+  std::uint8_t payload_length = 0;
+  std::uint8_t reserved = 0;
+  std::uint8_t payload[kPayloadBytes] = {};
+};
+
+// Fixed-size ring of binary trace events, formatted only when dumped.
+//
+// Recording is lock-free for any number of threads: a writer claims a slot
+// with one fetch_add and publishes it with a sequence number, overwriting
+// the oldest event once the ring is full. A writer stalled for a whole lap
+// of the ring shares its slot with a newer one; one of the two events is
+// then dropped rather than torn. Readers copy slots optimistically and skip
+// any that changed while they were copied.
+class TraceRing {
+ public:
+  // |capacity| is rounded up to a power of two.
+  explicit TraceRing(std::size_t capacity = 4096);
+
+  TraceRing(const TraceRing&) = delete;
+  TraceRing& operator=(const TraceRing&) = delete;
+
+  // Records an event at |kLevel|; compiles to nothing when that level is
+  // above FLUTTER_BLUETOOTH_CLASSIC_TRACE_LEVEL. Payloads longer than
+  // TraceEvent::kPayloadBytes are truncated; |value| still carries the full
+  // length where it matters.
+  template <TraceLevel kLevel>
+  void Record(TraceKind kind, std::uint32_t connection, std::int64_t value,
+              std::int32_t detail = 0, const void* payload = nullptr,
+              std::size_t payload_length = 0) {
+    if constexpr (TraceLevelEnabled(kLevel)) {
+      Append(kLevel, kind, connection, value, detail, payload, payload_length);
+    }
+  }
+
+  // Up to |max_events| of the newest events, oldest first.
+  std::vector<TraceEvent> Snapshot(std::size_t max_events) const;
+
+  // Snapshot() as text, one line per event.
+  std::string Dump(std::size_t max_events) const;
+
+  // Events recorded since creation, including overwritten ones.
+  std::uint64_t recorded() const { return head_.load(std::memory_order_relaxed); }
+  // Events lost to a writer stalled for a whole lap.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  std::size_t capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr std::size_t kWords = sizeof(TraceEvent) / sizeof(std::uint64_t);
+  static_assert(sizeof(TraceEvent) % sizeof(std::uint64_t) == 0, "TraceEvent must be word-sized");
+
+  struct Slot {
+    // 2 * ticket + 1 while being written, 2 * ticket + 2 once published.
+    std::atomic<std::uint64_t> sequence{0};
+    std::atomic<std::uint64_t> words[kWords];
+  };
+
+  void Append(TraceLevel level, TraceKind kind, std::uint32_t connection, std::int64_t value,
+              std::int32_t detail, const void* payload, std::size_t payload_length);
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t mask_;
+  std::chrono::steady_clock::time_point epoch_;
+  std::atomic<std::uint64_t> head_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+const char* TraceKindName(TraceKind kind);
+
+// One line of Dump() output, without the newline.
+std::string FormatTraceEvent(const TraceEvent& event);
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_TRACE_RING_H_
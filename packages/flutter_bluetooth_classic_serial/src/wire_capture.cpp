@@ -0,0 +1,186 @@
+#include "wire_capture.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+constexpr std::size_t kMagicLength = sizeof(kWireCaptureMagic) - 1;
+constexpr std::size_t kHeaderLength = kMagicLength + 2 + 8 + 2;
+// Far above any RFCOMM chunk; a larger length means a corrupt file.
+constexpr std::uint64_t kMaxRecordLength = 1 << 20;
+
+void PutVarint(std::uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutLittleEndian(std::uint64_t value, std::size_t bytes, std::string* out) {
+  for (std::size_t i = 0; i < bytes; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+// Reads from |bytes| at |*offset|; false (offset unchanged) when the input
+// ends first or the varint is longer than 64 bits.
+bool GetVarint(const std::string& bytes, std::size_t* offset, std::uint64_t* value) {
+  std::uint64_t result = 0;
+  std::size_t at = *offset;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (at >= bytes.size()) return false;
+    const auto byte = static_cast<std::uint8_t>(bytes[at++]);
+    result |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *offset = at;
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::uint64_t GetLittleEndian(const std::string& bytes, std::size_t offset, std::size_t count) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(bytes[offset + i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+void EncodeWireHeader(const std::string& label, std::int64_t started_unix_ms, std::string* out) {
+  out->append(kWireCaptureMagic, kMagicLength);
+  out->push_back(static_cast<char>(kWireCaptureVersion));
+  out->push_back(0);
+  PutLittleEndian(static_cast<std::uint64_t>(started_unix_ms), 8, out);
+  const std::size_t label_length = label.size() < 0xFFFF ? label.size() : 0xFFFF;
+  PutLittleEndian(label_length, 2, out);
+  out->append(label, 0, label_length);
+}
+
+void EncodeWireRecord(std::chrono::microseconds delta, WireDirection direction,
+                      const void* data, std::size_t length, std::string* out) {
+  PutVarint(delta.count() > 0 ? static_cast<std::uint64_t>(delta.count()) : 0, out);
+  out->push_back(static_cast<char>(direction));
+  PutVarint(length, out);
+  out->append(static_cast<const char*>(data), length);
+}
+
+bool ParseWireCapture(const std::string& bytes, WireCapture* capture) {
+  if (bytes.size() < kHeaderLength ||
+      std::memcmp(bytes.data(), kWireCaptureMagic, kMagicLength) != 0 ||
+      static_cast<std::uint8_t>(bytes[kMagicLength]) != kWireCaptureVersion) {
+    return false;
+  }
+  capture->started_unix_ms =
+      static_cast<std::int64_t>(GetLittleEndian(bytes, kMagicLength + 2, 8));
+  const auto label_length =
+      static_cast<std::size_t>(GetLittleEndian(bytes, kMagicLength + 10, 2));
+  if (bytes.size() < kHeaderLength + label_length) return false;
+  capture->label = bytes.substr(kHeaderLength, label_length);
+  capture->records.clear();
+
+  std::size_t offset = kHeaderLength + label_length;
+  std::chrono::microseconds at{0};
+  while (offset < bytes.size()) {
+    std::uint64_t delta = 0;
+    std::uint64_t length = 0;
+    std::size_t at_offset = offset;
+    if (!GetVarint(bytes, &at_offset, &delta) || at_offset >= bytes.size()) break;
+    const auto direction = static_cast<std::uint8_t>(bytes[at_offset++]);
+    if (direction > static_cast<std::uint8_t>(WireDirection::kReceived)) return false;
+    if (!GetVarint(bytes, &at_offset, &length)) break;
+    if (length > kMaxRecordLength) return false;
+    if (bytes.size() - at_offset < length) break;
+
+    at += std::chrono::microseconds(delta);
+    WireRecord record;
+    record.at = at;
+    record.direction = static_cast<WireDirection>(direction);
+    record.data = bytes.substr(at_offset, static_cast<std::size_t>(length));
+    capture->records.push_back(std::move(record));
+    offset = at_offset + static_cast<std::size_t>(length);
+  }
+  return true;
+}
+
+bool ReadWireCapture(const std::string& path, WireCapture* capture) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return !file.bad() && ParseWireCapture(bytes, capture);
+}
+
+bool WriteWireCapture(const std::string& path, const WireCapture& capture) {
+  std::string bytes;
+  EncodeWireHeader(capture.label, capture.started_unix_ms, &bytes);
+  std::chrono::microseconds previous{0};
+  for (const auto& record : capture.records) {
+    EncodeWireRecord(record.at - previous, record.direction, record.data.data(),
+                     record.data.size(), &bytes);
+    previous = record.at;
+  }
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  file.close();
+  return !file.fail();
+}
+
+WireCaptureWriter::~WireCaptureWriter() { Close(); }
+
+bool WireCaptureWriter::Open(const std::string& path, const std::string& label) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  CloseLocked();
+  file_.clear();
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_) return false;
+
+  const auto started = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  buffer_.clear();
+  EncodeWireHeader(label, started.count(), &buffer_);
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  last_at_ = Clock::now();
+  records_ = 0;
+  open_.store(true, std::memory_order_release);
+  return true;
+}
+
+void WireCaptureWriter::Record(WireDirection direction, const void* data, std::size_t length) {
+  if (!open_.load(std::memory_order_acquire) || length == 0) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!open_.load(std::memory_order_relaxed)) return;
+
+  const auto now = Clock::now();
+  buffer_.clear();
+  EncodeWireRecord(std::chrono::duration_cast<std::chrono::microseconds>(now - last_at_),
+                   direction, data, length, &buffer_);
+  // The file's own buffer batches these into large writes
+  file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  last_at_ = now;
+  ++records_;
+}
+
+bool WireCaptureWriter::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return CloseLocked();
+}
+
+std::uint64_t WireCaptureWriter::records() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+bool WireCaptureWriter::CloseLocked() {
+  if (!open_.exchange(false, std::memory_order_acq_rel)) return true;
+  file_.close();
+  return !file_.fail();
+}
+
+}  // namespace flutter_bluetooth_classic
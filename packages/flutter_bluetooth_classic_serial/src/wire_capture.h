@@ -0,0 +1,99 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_WIRE_CAPTURE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_WIRE_CAPTURE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// Direction of captured bytes, seen from the host.
+enum class WireDirection : std::uint8_t { kSent = 0, kReceived = 1 };
+
+struct WireRecord {
+  // Since the capture started.
+  std::chrono::microseconds at{0};
+  WireDirection direction = WireDirection::kSent;
+  std::string data;
+};
+
+// Every byte written to and received from one adapter connection, in the
+// order it crossed the socket.
+struct WireCapture {
+  // Free text identifying the connection, normally the device address.
+  std::string label;
+  // Wall-clock start of the capture, ms since the Unix epoch.
+  std::int64_t started_unix_ms = 0;
+  std::vector<WireRecord> records;
+};
+
+// Capture file layout, all integers little-endian:
+//
+//   header  "CCWIRE" version(u8 = 1) reserved(u8)
+//           started_unix_ms(i64) label_length(u16) label
+//   record  delta_us(varint) direction(u8) length(varint) bytes
+//
+// |delta_us| is the time since the previous record, so a typical ELM327
+// command or reply costs three bytes of framing.
+constexpr char kWireCaptureMagic[] = "CCWIRE";
+constexpr std::uint8_t kWireCaptureVersion = 1;
+
+// Appends the encoded header or record to |out|.
+void EncodeWireHeader(const std::string& label, std::int64_t started_unix_ms, std::string* out);
+void EncodeWireRecord(std::chrono::microseconds delta, WireDirection direction,
+                      const void* data, std::size_t length, std::string* out);
+
+// Parses a whole capture. A record cut short at the end (the app died
+// mid-write) is dropped; anything else malformed fails the parse.
+bool ParseWireCapture(const std::string& bytes, WireCapture* capture);
+bool ReadWireCapture(const std::string& path, WireCapture* capture);
+bool WriteWireCapture(const std::string& path, const WireCapture& capture);
+
+// Streams a connection's traffic to a capture file.
+//
+// Record() is called from the write path and the I/O thread alike; a mutex
+// gives the records one order, so a command always precedes the reply it
+// caused as long as it is recorded before it is sent. While closed,
+// Record() costs one atomic load. Thread-safe.
+class WireCaptureWriter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  WireCaptureWriter() = default;
+  ~WireCaptureWriter();
+
+  WireCaptureWriter(const WireCaptureWriter&) = delete;
+  WireCaptureWriter& operator=(const WireCaptureWriter&) = delete;
+
+  // Closes any open file and starts a new capture at |path|.
+  bool Open(const std::string& path, const std::string& label);
+
+  void Record(WireDirection direction, const void* data, std::size_t length);
+
+  // Flushes and closes. False if any write to the file failed.
+  bool Close();
+
+  bool is_open() const { return open_.load(std::memory_order_acquire); }
+  // Records written since Open().
+  std::uint64_t records() const;
+
+ private:
+  bool CloseLocked();
+
+  std::atomic<bool> open_{false};
+  mutable std::mutex mutex_;
+  std::ofstream file_;
+  Clock::time_point last_at_;
+  std::uint64_t records_ = 0;
+  // Reused so recording does not allocate.
+  std::string buffer_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_WIRE_CAPTURE_H_
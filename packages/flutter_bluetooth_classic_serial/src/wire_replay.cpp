@@ -0,0 +1,158 @@
+#include "wire_replay.h"
+
+#include <cctype>
+#include <thread>
+#include <utility>
+
+#include "reactor.h"
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// The ELM327 ignores spaces and case in commands.
+std::string Normalize(const std::string& command) {
+  std::string normalized;
+  normalized.reserve(command.size());
+  for (char c : command) {
+    if (c == ' ' || c == '\n' || c == '\t') continue;
+    normalized.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+  }
+  return normalized;
+}
+
+bool SendAll(NativeSocket socket, const std::string& data) {
+  std::size_t sent = 0;
+  while (sent < data.size()) {
+    int result = SendSome(socket, reinterpret_cast<const std::uint8_t*>(data.data()) + sent,
+                          data.size() - sent);
+    if (result <= 0) return false;
+    sent += static_cast<std::size_t>(result);
+  }
+  return true;
+}
+
+}  // namespace
+
+std::vector<ReplayStep> BuildReplayScript(const WireCapture& capture) {
+  std::vector<ReplayStep> script;
+  std::string command;
+  for (const auto& record : capture.records) {
+    if (record.direction == WireDirection::kReceived) {
+      if (script.empty()) {
+        script.emplace_back();
+        script.back().expects_command = false;
+      }
+      script.back().replies.push_back(record);
+      continue;
+    }
+    for (char c : record.data) {
+      if (c != '\r') {
+        command.push_back(c);
+        continue;
+      }
+      ReplayStep step;
+      step.command = std::move(command);
+      step.sent_at = record.at;
+      script.push_back(std::move(step));
+      command.clear();
+    }
+  }
+  return script;
+}
+
+WireReplay::WireReplay(const WireCapture& capture, ReplayOptions options)
+    : script_(BuildReplayScript(capture)), options_(options) {}
+
+ReplayReport WireReplay::Run(NativeSocket socket) {
+  ReplayReport report;
+  for (const auto& step : script_) {
+    if (step.expects_command) ++report.commands_expected;
+  }
+
+  Reactor reactor;
+  if (!reactor.IsValid() || !reactor.Add(socket, 0)) return report;
+
+  const auto started = Clock::now();
+  pending_.clear();
+  std::size_t index = 0;
+  bool finished = true;
+  for (const auto& step : script_) {
+    auto command_at = started;
+    if (step.expects_command) {
+      std::string actual;
+      if (!ReadCommand(&reactor, socket, &actual, &report)) {
+        finished = false;
+        break;
+      }
+      command_at = Clock::now();
+      if (Normalize(actual) == Normalize(step.command)) {
+        ++report.commands_matched;
+      } else {
+        report.divergences.push_back({index, step.command, std::move(actual)});
+        if (report.divergences.size() >= options_.max_divergences) {
+          finished = false;
+          break;
+        }
+      }
+      ++index;
+    }
+    if (!SendReplies(socket, step, command_at, &report)) {
+      finished = false;
+      break;
+    }
+  }
+  report.completed = finished;
+  reactor.Remove(socket);
+  report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started);
+  return report;
+}
+
+bool WireReplay::ReadCommand(Reactor* reactor, NativeSocket socket, std::string* command,
+                             ReplayReport* report) {
+  const auto deadline = Clock::now() + options_.stall_timeout;
+  for (;;) {
+    const auto cr = pending_.find('\r');
+    if (cr != std::string::npos) {
+      command->assign(pending_, 0, cr);
+      pending_.erase(0, cr + 1);
+      return true;
+    }
+
+    const auto now = Clock::now();
+    if (now >= deadline) {
+      report->stalled = true;
+      return false;
+    }
+    const auto wait_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+    Reactor::Event event;
+    const int ready = reactor->Wait(&event, 1, static_cast<int>(wait_ms));
+    if (ready < 0) return false;
+    if (ready == 0) continue;
+
+    std::uint8_t buffer[512];
+    const int received = ReceiveSome(socket, buffer, sizeof(buffer));
+    if (received <= 0) return false;
+    pending_.append(reinterpret_cast<const char*>(buffer), static_cast<std::size_t>(received));
+  }
+}
+
+bool WireReplay::SendReplies(NativeSocket socket, const ReplayStep& step,
+                             Clock::time_point command_at, ReplayReport* report) {
+  for (const auto& reply : step.replies) {
+    if (options_.speed > 0) {
+      const auto offset = reply.at > step.sent_at ? reply.at - step.sent_at
+                                                  : std::chrono::microseconds(0);
+      const std::chrono::duration<double, std::micro> scaled(
+          static_cast<double>(offset.count()) / options_.speed);
+      std::this_thread::sleep_until(command_at +
+                                    std::chrono::duration_cast<Clock::duration>(scaled));
+    }
+    if (!SendAll(socket, reply.data)) return false;
+    report->bytes_sent += reply.data.size();
+  }
+  return true;
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,103 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_WIRE_REPLAY_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_WIRE_REPLAY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "native_socket.h"
+#include "wire_capture.h"
+
+namespace flutter_bluetooth_classic {
+
+class Reactor;
+
+// One command of a capture and what the adapter sent back for it.
+struct ReplayStep {
+  // Without the CR. Empty for a bare CR (repeat or abort).
+  std::string command;
+  // False only for a leading step holding what the adapter sent before the
+  // first command.
+  bool expects_command = true;
+  // When the CR ending the command was written.
+  std::chrono::microseconds sent_at{0};
+  // Received records up to the next command, |at| still on the capture's
+  // timeline.
+  std::vector<WireRecord> replies;
+};
+
+// Splits a capture into commands, however the writes were chunked, and
+// attaches every received record to the command before it.
+std::vector<ReplayStep> BuildReplayScript(const WireCapture& capture);
+
+struct ReplayOptions {
+  // Time scale for the replies: 1 replays at captured speed, 4 four times
+  // faster, 0 sends each reply as soon as its command arrives.
+  double speed = 1.0;
+  // How long to wait for the next command before giving up.
+  std::chrono::milliseconds stall_timeout{2000};
+  // Stop once this many commands have differed from the capture.
+  std::size_t max_divergences = 1;
+};
+
+struct ReplayDivergence {
+  // Position in the command sequence, from 0.
+  std::size_t index = 0;
+  std::string expected;
+  std::string actual;
+};
+
+struct ReplayReport {
+  std::size_t commands_expected = 0;
+  // Commands received that matched the capture.
+  std::size_t commands_matched = 0;
+  std::vector<ReplayDivergence> divergences;
+  // Every captured command arrived and was answered.
+  bool completed = false;
+  // No command arrived within the stall timeout.
+  bool stalled = false;
+  std::uint64_t bytes_sent = 0;
+  std::chrono::microseconds elapsed{0};
+};
+
+// Plays the adapter side of a capture on a socket, so a recorded drive runs
+// through the real receive, framing and pipeline code as a repeatable
+// regression and timing fixture.
+//
+// Each command the host writes is checked against the capture (ignoring
+// spaces and case, as the ELM327 does) before the replies recorded after it
+// are sent, paced by ReplayOptions::speed relative to when the command
+// arrived. A command that differs is reported as a divergence; its captured
+// replies are still sent so the host keeps going.
+class WireReplay {
+ public:
+  WireReplay(const WireCapture& capture, ReplayOptions options);
+
+  // Runs on the calling thread until the script ends, the host closes the
+  // link, it stalls or too many commands diverge. |socket| must be
+  // blocking.
+  ReplayReport Run(NativeSocket socket);
+
+  const std::vector<ReplayStep>& script() const { return script_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  // Reads up to the next CR into |command|. False on close, error or stall.
+  bool ReadCommand(Reactor* reactor, NativeSocket socket, std::string* command,
+                   ReplayReport* report);
+  // Sends |step|'s replies paced from |command_at|. False if the send fails.
+  bool SendReplies(NativeSocket socket, const ReplayStep& step, Clock::time_point command_at,
+                   ReplayReport* report);
+
+  std::vector<ReplayStep> script_;
+  ReplayOptions options_;
+  // Bytes received after the last CR.
+  std::string pending_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_WIRE_REPLAY_H_
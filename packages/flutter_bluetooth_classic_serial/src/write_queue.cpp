@@ -0,0 +1,166 @@
+#include "write_queue.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+WriteQueue::WriteQueue(BacklogHandler on_backlog) : on_backlog_(std::move(on_backlog)) {}
+
+void WriteQueue::Reset(NativeSocket socket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  socket_ = socket;
+  segments_.clear();
+  head_offset_ = 0;
+  pending_bytes_ = 0;
+  cork_depth_ = 0;
+  backlogged_ = false;
+  failed_ = false;
+  stats_ = Stats();
+}
+
+bool WriteQueue::Write(const std::uint8_t* data, std::size_t length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (failed_ || socket_ == kInvalidSocket) return false;
+  ++stats_.writes;
+  if (length == 0) return true;
+
+  std::size_t taken = 0;
+  if (segments_.empty() && cork_depth_ == 0) {
+    // Idle: send from the caller's buffer and keep only the rest.
+    if (!SendNowLocked(data, length, &taken)) return false;
+    if (taken == length) return true;
+  }
+  segments_.emplace_back(data + taken, data + length);
+  pending_bytes_ += length - taken;
+  // Corked writes wait for Uncork(), not for the socket.
+  if (cork_depth_ == 0) SetBacklogLocked(true);
+  return true;
+}
+
+bool WriteQueue::Write(std::vector<std::uint8_t>&& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (failed_ || socket_ == kInvalidSocket) return false;
+  ++stats_.writes;
+  if (data.empty()) return true;
+
+  const std::size_t length = data.size();
+  std::size_t taken = 0;
+  if (segments_.empty() && cork_depth_ == 0) {
+    if (!SendNowLocked(data.data(), length, &taken)) return false;
+    if (taken == length) return true;
+    // The only segment, so the sent prefix can stay in place.
+    head_offset_ = taken;
+  }
+  segments_.push_back(std::move(data));
+  pending_bytes_ += length - taken;
+  // Corked writes wait for Uncork(), not for the socket.
+  if (cork_depth_ == 0) SetBacklogLocked(true);
+  return true;
+}
+
+void WriteQueue::Cork() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++cork_depth_;
+}
+
+bool WriteQueue::Uncork() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (cork_depth_ > 0 && --cork_depth_ > 0) return !failed_;
+  // A backlogged queue waits for the socket to report writable instead.
+  if (backlogged_) return !failed_;
+  return FlushLocked();
+}
+
+bool WriteQueue::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return FlushLocked();
+}
+
+std::size_t WriteQueue::pending_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_bytes_;
+}
+
+bool WriteQueue::failed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return failed_;
+}
+
+WriteQueue::Stats WriteQueue::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool WriteQueue::FlushLocked() {
+  if (failed_) return false;
+  if (socket_ == kInvalidSocket) return segments_.empty();
+
+  while (!segments_.empty()) {
+    SendBuffer buffers[kMaxSendBuffers];
+    std::size_t count = 0;
+    std::size_t batch_bytes = 0;
+    for (auto it = segments_.begin(); it != segments_.end() && count < kMaxSendBuffers; ++it) {
+      const std::size_t offset = count == 0 ? head_offset_ : 0;
+      buffers[count++] = {it->data() + offset, it->size() - offset};
+      batch_bytes += it->size() - offset;
+    }
+
+    ++stats_.send_calls;
+    if (count > 1) ++stats_.gather_sends;
+    int sent = SendGather(socket_, buffers, count);
+    if (sent < 0) {
+      if (IsWouldBlockError(LastSocketError())) break;
+      failed_ = true;
+      segments_.clear();
+      head_offset_ = 0;
+      pending_bytes_ = 0;
+      SetBacklogLocked(false);
+      return false;
+    }
+
+    auto remaining = static_cast<std::size_t>(sent);
+    stats_.bytes_sent += remaining;
+    pending_bytes_ -= remaining;
+    if (remaining < batch_bytes) ++stats_.partial_sends;
+    while (remaining > 0) {
+      const std::size_t left_in_head = segments_.front().size() - head_offset_;
+      if (remaining < left_in_head) {
+        head_offset_ += remaining;
+        break;
+      }
+      remaining -= left_in_head;
+      segments_.pop_front();
+      head_offset_ = 0;
+    }
+    // The socket is full; wait for it to report writable.
+    if (static_cast<std::size_t>(sent) < batch_bytes) break;
+  }
+
+  SetBacklogLocked(!segments_.empty());
+  return true;
+}
+
+bool WriteQueue::SendNowLocked(const std::uint8_t* data, std::size_t length,
+                               std::size_t* taken) {
+  ++stats_.send_calls;
+  int sent = SendSome(socket_, data, length);
+  if (sent < 0) {
+    if (!IsWouldBlockError(LastSocketError())) {
+      failed_ = true;
+      return false;
+    }
+    sent = 0;
+  }
+  *taken = static_cast<std::size_t>(sent);
+  stats_.bytes_sent += *taken;
+  if (*taken > 0 && *taken < length) ++stats_.partial_sends;
+  return true;
+}
+
+void WriteQueue::SetBacklogLocked(bool backlogged) {
+  if (backlogged == backlogged_) return;
+  backlogged_ = backlogged;
+  if (on_backlog_) on_backlog_(backlogged);
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,90 @@
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_WRITE_QUEUE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_WRITE_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "native_socket.h"
+
+namespace flutter_bluetooth_classic {
+
+// Outgoing bytes of one non-blocking connection.
+//
+// A write to an idle queue goes straight to the socket from the caller's
+// buffer; only what the socket does not take is copied and queued. Writes
+// made while bytes are queued (or while corked) are appended and later
+// sent together in one gather send, so commands issued back to back cost
+// one syscall instead of one each. Partial sends resume where they
+// stopped. Thread-safe.
+class WriteQueue {
+ public:
+  // Called with true when bytes are left queued and false once they are all
+  // sent. The owner turns the socket's write interest on and off with it so
+  // Flush() runs when the socket drains. Called with the queue locked; must
+  // not call back into the queue.
+  using BacklogHandler = std::function<void(bool backlogged)>;
+
+  struct Stats {
+    std::uint64_t writes = 0;
+    std::uint64_t bytes_sent = 0;
+    // send()/sendmsg() calls, including ones that would have blocked.
+    std::uint64_t send_calls = 0;
+    // Send calls that carried more than one write.
+    std::uint64_t gather_sends = 0;
+    // Send calls the socket took only part of.
+    std::uint64_t partial_sends = 0;
+  };
+
+  explicit WriteQueue(BacklogHandler on_backlog = nullptr);
+
+  WriteQueue(const WriteQueue&) = delete;
+  WriteQueue& operator=(const WriteQueue&) = delete;
+
+  // Targets |socket| and drops anything queued for the previous one. The
+  // backlog handler is not called.
+  void Reset(NativeSocket socket);
+
+  // Returns false if the socket failed (now or on an earlier send); the
+  // data is then dropped.
+  bool Write(const std::uint8_t* data, std::size_t length);
+  // Same, taking ownership so queueing needs no copy.
+  bool Write(std::vector<std::uint8_t>&& data);
+
+  // While corked, writes only queue. Uncork() sends them in one gather send.
+  void Cork();
+  bool Uncork();
+
+  // Sends as much queued data as the socket takes. Call when writable.
+  bool Flush();
+
+  std::size_t pending_bytes() const;
+  bool failed() const;
+  Stats stats() const;
+
+ private:
+  bool FlushLocked();
+  // One send of |data|; sets |taken| to what the socket took (0 if it would
+  // block). False if the socket failed.
+  bool SendNowLocked(const std::uint8_t* data, std::size_t length, std::size_t* taken);
+  void SetBacklogLocked(bool backlogged);
+
+  BacklogHandler on_backlog_;
+  mutable std::mutex mutex_;
+  NativeSocket socket_ = kInvalidSocket;
+  std::deque<std::vector<std::uint8_t>> segments_;
+  // Bytes of segments_.front() already sent.
+  std::size_t head_offset_ = 0;
+  std::size_t pending_bytes_ = 0;
+  int cork_depth_ = 0;
+  bool backlogged_ = false;
+  bool failed_ = false;
+  Stats stats_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_WRITE_QUEUE_H_
@@ -0,0 +1,92 @@
+#include "bluetooth_radio.h"
+
+#include <cstdio>
+#include <string>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+DeviceRecord ToRecord(const BLUETOOTH_DEVICE_INFO& info) {
+  DeviceRecord record;
+
+  int len = WideCharToMultiByte(CP_UTF8, 0, info.szName, -1, NULL, 0, NULL, NULL);
+  if (len > 1) {
+    record.name.resize(len - 1);
+    WideCharToMultiByte(CP_UTF8, 0, info.szName, -1, &record.name[0], len, NULL, NULL);
+  }
+
+  char address[18];
+  sprintf_s(address, "%02X:%02X:%02X:%02X:%02X:%02X",
+            info.Address.rgBytes[5], info.Address.rgBytes[4], info.Address.rgBytes[3],
+            info.Address.rgBytes[2], info.Address.rgBytes[1], info.Address.rgBytes[0]);
+  record.address = address;
+  record.paired = info.fAuthenticated == TRUE;
+  record.connected = info.fConnected == TRUE;
+  return record;
+}
+
+// Runs one device search and reports each result until |on_device|
+// returns false.
+void FindDevices(BLUETOOTH_DEVICE_SEARCH_PARAMS* params,
+                 const DiscoveryBackend::DeviceHandler& on_device) {
+  BLUETOOTH_DEVICE_INFO info = {0};
+  info.dwSize = sizeof(BLUETOOTH_DEVICE_INFO);
+
+  HBLUETOOTH_DEVICE_FIND find = BluetoothFindFirstDevice(params, &info);
+  if (find == NULL) return;
+  do {
+    if (!on_device(ToRecord(info))) break;
+  } while (BluetoothFindNextDevice(find, &info));
+  BluetoothFindDeviceClose(find);
+}
+
+}  // namespace
+
+RadioInfo BluetoothRadio::QueryRadio() {
+  RadioInfo info;
+  BLUETOOTH_FIND_RADIO_PARAMS params = {sizeof(BLUETOOTH_FIND_RADIO_PARAMS)};
+  HANDLE radio;
+  HBLUETOOTH_RADIO_FIND find = BluetoothFindFirstRadio(&params, &radio);
+  if (find == NULL) return info;
+
+  info.present = true;
+  BLUETOOTH_RADIO_INFO radio_info = {sizeof(BLUETOOTH_RADIO_INFO)};
+  info.enabled = BluetoothGetRadioInfo(radio, &radio_info) == ERROR_SUCCESS;
+  CloseHandle(radio);
+  BluetoothFindRadioClose(find);
+  return info;
+}
+
+std::vector<DeviceRecord> BluetoothRadio::ListKnownDevices() {
+  BLUETOOTH_DEVICE_SEARCH_PARAMS params = {0};
+  params.dwSize = sizeof(BLUETOOTH_DEVICE_SEARCH_PARAMS);
+  params.fReturnAuthenticated = TRUE;
+  params.fReturnRemembered = TRUE;
+  params.fReturnConnected = TRUE;
+  params.fReturnUnknown = FALSE;
+  params.fIssueInquiry = FALSE;
+  params.cTimeoutMultiplier = 1;
+
+  std::vector<DeviceRecord> devices;
+  FindDevices(&params, [&devices](const DeviceRecord& device) {
+    devices.push_back(device);
+    return true;
+  });
+  return devices;
+}
+
+void BluetoothRadio::Inquire(const DeviceHandler& on_device) {
+  BLUETOOTH_DEVICE_SEARCH_PARAMS params = {0};
+  params.dwSize = sizeof(BLUETOOTH_DEVICE_SEARCH_PARAMS);
+  params.fReturnAuthenticated = TRUE;
+  params.fReturnRemembered = TRUE;
+  params.fReturnConnected = TRUE;
+  params.fReturnUnknown = TRUE;
+  params.fIssueInquiry = TRUE;
+  params.cTimeoutMultiplier = inquiry_multiplier_;
+
+  FindDevices(&params, on_device);
+}
+
+}  // namespace flutter_bluetooth_classic
@@ -0,0 +1,34 @@
+#ifndef FLUTTER_PLUGIN_BLUETOOTH_RADIO_H_
+#define FLUTTER_PLUGIN_BLUETOOTH_RADIO_H_
+
+#include <windows.h>
+#include <bluetoothapis.h>
+
+#include <vector>
+
+#include "device_discovery.h"
+
+namespace flutter_bluetooth_classic {
+
+// DiscoveryBackend over the Win32 Bluetooth APIs of the first local radio.
+class BluetoothRadio : public DiscoveryBackend {
+ public:
+  // Inquiry length in units of 1.28 s.
+  explicit BluetoothRadio(UCHAR inquiry_multiplier = 1)
+      : inquiry_multiplier_(inquiry_multiplier) {}
+
+  RadioInfo QueryRadio() override;
+
+  std::vector<DeviceRecord> ListKnownDevices() override;
+
+  // BluetoothFindFirstDevice with fIssueInquiry blocks for the whole
+  // inquiry, so devices arrive per round rather than one by one.
+  void Inquire(const DeviceHandler& on_device) override;
+
+ private:
+  UCHAR inquiry_multiplier_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_PLUGIN_BLUETOOTH_RADIO_H_
@@ -1,5 +1,6 @@
 #include "include/flutter_bluetooth_classic_serial/flutter_bluetooth_classic_plugin.h"
 
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
@@ -8,6 +9,13 @@
 #include <ws2bth.h>
 #include <initguid.h>
 
+#include "bluetooth_radio.h"
+#include "platform_thread_dispatcher.h"
+#include "rfcomm_transport.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -16,6 +24,116 @@
 
 namespace flutter_bluetooth_classic {
 
+namespace {
+
+// Per-connection receive ring. Holds several seconds of adapter output so a
+// briefly busy platform thread never loses data.
+constexpr size_t kReceiveRingCapacity = 64 * 1024;
+
+// Per-command deadline for sendCommands when Dart gives none.
+constexpr int64_t kDefaultCommandTimeoutMs = 1000;
+
+using EventSinkPtr = std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>;
+using StreamHandlerErrorPtr = std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>>;
+
+// Keeps |sink| pointed at the active Dart listener of |channel|.
+void SetEventSinkHandler(flutter::EventChannel<flutter::EncodableValue>* channel,
+                         EventSinkPtr* sink) {
+  channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [sink](const flutter::EncodableValue* arguments,
+                 EventSinkPtr&& events) -> StreamHandlerErrorPtr {
+            *sink = std::move(events);
+            return nullptr;
+          },
+          [sink](const flutter::EncodableValue* arguments) -> StreamHandlerErrorPtr {
+            sink->reset();
+            return nullptr;
+          }));
+}
+
+// Reads an integer argument that the codec may have sent as 32 or 64 bit.
+bool GetIntArgument(const flutter::EncodableMap& args, const char* key, int64_t* value) {
+  auto it = args.find(flutter::EncodableValue(key));
+  if (it == args.end()) return false;
+  if (const auto* v32 = std::get_if<int32_t>(&it->second)) {
+    *value = *v32;
+    return true;
+  }
+  if (const auto* v64 = std::get_if<int64_t>(&it->second)) {
+    *value = *v64;
+    return true;
+  }
+  return false;
+}
+
+// Discovery inquiry rounds of 1.28 s each, about as long as an Android
+// discovery session.
+constexpr int kDiscoveryInquiryRounds = 10;
+
+flutter::EncodableValue EncodeDevice(const DeviceRecord& device) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("name")] = flutter::EncodableValue(device.name);
+  map[flutter::EncodableValue("address")] = flutter::EncodableValue(device.address);
+  map[flutter::EncodableValue("type")] = flutter::EncodableValue("classic");
+  map[flutter::EncodableValue("paired")] = flutter::EncodableValue(device.paired);
+  map[flutter::EncodableValue("isConnected")] = flutter::EncodableValue(device.connected);
+  return flutter::EncodableValue(std::move(map));
+}
+
+flutter::EncodableList EncodeDevices(const std::vector<DeviceRecord>& devices) {
+  flutter::EncodableList list;
+  list.reserve(devices.size());
+  for (const auto& device : devices) list.push_back(EncodeDevice(device));
+  return list;
+}
+
+const char* CommandStatusName(CommandResult::Status status) {
+  switch (status) {
+    case CommandResult::Status::kOk:
+      return "ok";
+    case CommandResult::Status::kTimedOut:
+      return "timeout";
+    case CommandResult::Status::kWriteFailed:
+      return "writeFailed";
+    case CommandResult::Status::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+flutter::EncodableList EncodeCommandResults(const std::vector<CommandResult>& results) {
+  flutter::EncodableList list;
+  list.reserve(results.size());
+  for (const auto& result : results) {
+    flutter::EncodableList lines;
+    lines.reserve(result.lines.size());
+    for (const auto& line : result.lines) {
+      lines.push_back(flutter::EncodableValue(line));
+    }
+    // The reply reassembled per ECU, so Dart does not rejoin ISO-TP frames
+    flutter::EncodableList messages;
+    for (auto& message : AssembleElmReply(result.lines)) {
+      flutter::EncodableMap encoded;
+      encoded[flutter::EncodableValue("id")] = flutter::EncodableValue(std::move(message.id));
+      encoded[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(message.bytes));
+      encoded[flutter::EncodableValue("complete")] = flutter::EncodableValue(message.complete);
+      messages.push_back(flutter::EncodableValue(std::move(encoded)));
+    }
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(result.command);
+    entry[flutter::EncodableValue("status")] = flutter::EncodableValue(CommandStatusName(result.status));
+    entry[flutter::EncodableValue("lines")] = flutter::EncodableValue(std::move(lines));
+    entry[flutter::EncodableValue("messages")] = flutter::EncodableValue(std::move(messages));
+    entry[flutter::EncodableValue("elapsedUs")] =
+        flutter::EncodableValue(static_cast<int64_t>(result.elapsed.count()));
+    list.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  return list;
+}
+
+}  // namespace
+
 // static
 void FlutterBluetoothClassicPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrarWindows* registrar) {  // Register the main channel
@@ -24,52 +142,79 @@ void FlutterBluetoothClassicPlugin::RegisterWithRegistrar(
           registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic",
           &flutter::StandardMethodCodec::GetInstance());
 
-  // Register the state channel
+  // State, data and connection are event channels: the plugin pushes to Dart
+  // instead of Dart polling readData.
   auto state_channel =
-      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
           registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_state",
           &flutter::StandardMethodCodec::GetInstance());
 
-  // Register the data channel
   auto data_channel =
-      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
           registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_data",
           &flutter::StandardMethodCodec::GetInstance());
 
-  // Register the connection channel
   auto connection_channel =
-      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
           registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_connection",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<FlutterBluetoothClassicPlugin>();
+  // Framed ELM327 responses, one event per '>' prompt (see setResponseFraming)
+  auto response_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_response",
+          &flutter::StandardMethodCodec::GetInstance());
 
-  main_channel->SetMethodCallHandler(
-      [plugin_pointer = plugin.get()](const auto& call, auto result) {
-        plugin_pointer->HandleMethodCall(call, std::move(result));
-      });
+  // Samples of the native poll schedule (see setPollSchedule)
+  auto poll_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_poll",
+          &flutter::StandardMethodCodec::GetInstance());
 
-  state_channel->SetMethodCallHandler(
-      [plugin_pointer = plugin.get()](const auto& call, auto result) {
-        plugin_pointer->HandleMethodCall(call, std::move(result));
-      });
+  // Progress and finds of the native DID scan (see startDidScan)
+  auto did_scan_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "com.flutter_bluetooth_classic.plugin/flutter_bluetooth_classic_did_scan",
+          &flutter::StandardMethodCodec::GetInstance());
 
-  data_channel->SetMethodCallHandler(
-      [plugin_pointer = plugin.get()](const auto& call, auto result) {
-        plugin_pointer->HandleMethodCall(call, std::move(result));
-      });
+  auto plugin = std::make_unique<FlutterBluetoothClassicPlugin>(registrar);
 
-  connection_channel->SetMethodCallHandler(
+  main_channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto& call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
 
+  SetEventSinkHandler(state_channel.get(), &plugin->state_sink_);
+  SetEventSinkHandler(data_channel.get(), &plugin->data_sink_);
+  SetEventSinkHandler(connection_channel.get(), &plugin->connection_sink_);
+  SetEventSinkHandler(response_channel.get(), &plugin->response_sink_);
+  SetEventSinkHandler(poll_channel.get(), &plugin->poll_sink_);
+  SetEventSinkHandler(did_scan_channel.get(), &plugin->did_scan_sink_);
+
   registrar->AddPlugin(std::move(plugin));
 }
 
-FlutterBluetoothClassicPlugin::FlutterBluetoothClassicPlugin() {}
+FlutterBluetoothClassicPlugin::FlutterBluetoothClassicPlugin(
+    flutter::PluginRegistrarWindows* registrar)
+    : dispatcher_(std::make_unique<PlatformThreadDispatcher>(registrar)),
+      radio_(std::make_unique<BluetoothRadio>()),
+      device_cache_(radio_.get()),
+      discovery_(radio_.get(), &device_cache_) {
+  if (!io_reactor_.Start()) {
+    OutputDebugStringA("FlutterBluetoothClassicPlugin: Failed to start I/O reactor\n");
+  }
+}
 
-FlutterBluetoothClassicPlugin::~FlutterBluetoothClassicPlugin() {}
+FlutterBluetoothClassicPlugin::~FlutterBluetoothClassicPlugin() {
+  discovery_.Stop();
+  // Unregister every connection and join the I/O thread before the sockets
+  // and buffers it uses go away
+  RemoveAllReceiveChannels();
+  io_reactor_.Shutdown();
+  for (auto& pair : connected_sockets_) {
+    closesocket(pair.second);
+  }
+}
 
 void FlutterBluetoothClassicPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
@@ -130,18 +275,22 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
   } else if (method.compare("requestEnable") == 0) {
     result->Success(flutter::EncodableValue(false));
   } else if (method.compare("openSettings") == 0) {
+    // The user may pair or unpair devices there
+    device_cache_.Invalidate();
     OpenBluetoothSettings();
     result->Success(flutter::EncodableValue(true));
   } else if (method.compare("getPairedDevices") == 0) {
     auto devices = GetPairedDevices();
     result->Success(flutter::EncodableValue(devices));
   } else if (method.compare("startDiscovery") == 0) {
-    auto devices = StartDiscovery();
-    result->Success(flutter::EncodableValue(devices));
+    result->Success(flutter::EncodableValue(StartDiscovery()));
   } else if (method.compare("stopDiscovery") == 0) {
+    discovery_.Stop();
     result->Success(flutter::EncodableValue(true));
   } else if (method.compare("isDiscovering") == 0) {
-    result->Success(flutter::EncodableValue(false));
+    result->Success(flutter::EncodableValue(discovery_.IsDiscovering()));
+  } else if (method.compare("getDiscoveredDevices") == 0) {
+    result->Success(flutter::EncodableValue(GetDiscoveredDevices()));
   }
   
   // Main channel methods
@@ -152,8 +301,11 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
       OutputDebugStringA("HandleMethodCall: Connection successful, notifying state change\n");
       NotifyConnectionStateChange(method_call.arguments(), true);
       
-      // Don't auto-start data listening here - let Flutter app call listen when ready
-      OutputDebugStringA("Connection established, waiting for data channel listen request\n");
+      // Start receiving right away; bytes are pushed through the data event
+      // channel, or buffered for readData while nothing listens.
+      const auto* args = std::get_if<flutter::EncodableMap>(method_call.arguments());
+      const auto* address = std::get_if<std::string>(&args->at(flutter::EncodableValue("address")));
+      StartDataListening(*address);
     } else {
       OutputDebugStringA("HandleMethodCall: Connection failed\n");
     }
@@ -162,6 +314,7 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
     bool success = DisconnectDevice(method_call.arguments());
     // Send disconnection state change event and cleanup data channels
     if (success) {
+      device_cache_.Invalidate();
       NotifyConnectionStateChange(method_call.arguments(), false);
       CleanupDataChannels(method_call.arguments());
     }
@@ -169,12 +322,50 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
   } else if (method.compare("isConnected") == 0) {
     bool connected = IsDeviceConnected(method_call.arguments());
     result->Success(flutter::EncodableValue(connected));
+  } else if (method.compare("getConnectedChannel") == 0) {
+    result->Success(GetConnectedChannel(method_call.arguments()));
   }
   
   // Data channel methods
-  else if (method.compare("writeData") == 0) {
+  else if (method.compare("writeData") == 0 || method.compare("sendData") == 0) {
     bool success = WriteData(method_call.arguments());
     result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("sendCommands") == 0) {
+    // Answered from the I/O thread once the whole batch has run
+    SendCommands(method_call.arguments(), std::move(result));
+  } else if (method.compare("setPollSchedule") == 0) {
+    bool success = SetPollSchedule(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("getPollStats") == 0) {
+    result->Success(flutter::EncodableValue(GetPollStats(method_call.arguments())));
+  } else if (method.compare("getStats") == 0) {
+    result->Success(flutter::EncodableValue(GetStats(method_call.arguments())));
+  } else if (method.compare("resetStats") == 0) {
+    bool success = ResetStats(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("startJ1939Monitor") == 0) {
+    // Answered from the I/O thread once the adapter is monitoring
+    StartJ1939Monitor(method_call.arguments(), std::move(result));
+  } else if (method.compare("stopJ1939Monitor") == 0) {
+    bool success = StopJ1939Monitor(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("getJ1939Values") == 0) {
+    result->Success(flutter::EncodableValue(GetJ1939Values(method_call.arguments())));
+  } else if (method.compare("setEcuPolicies") == 0) {
+    bool success = SetEcuPolicies(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("setEcuRouting") == 0) {
+    bool success = SetEcuRouting(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("getEcuValues") == 0) {
+    result->Success(flutter::EncodableValue(GetEcuValues(method_call.arguments())));
+  } else if (method.compare("startDidScan") == 0) {
+    StartDidScan(method_call.arguments(), std::move(result));
+  } else if (method.compare("stopDidScan") == 0) {
+    bool success = StopDidScan(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("getDidScanBitmap") == 0) {
+    result->Success(GetDidScanBitmap(method_call.arguments()));
   } else if (method.compare("readData") == 0) {
     std::string data = ReadData(method_call.arguments());
     result->Success(flutter::EncodableValue(data));
@@ -184,6 +375,22 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
   } else if (method.compare("flush") == 0) {
     bool success = FlushData(method_call.arguments());
     result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("getReceiveBufferStats") == 0) {
+    result->Success(flutter::EncodableValue(GetReceiveBufferStats(method_call.arguments())));
+  } else if (method.compare("setResponseFraming") == 0) {
+    bool success = SetResponseFraming(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("setDataCoalescing") == 0) {
+    bool success = SetDataCoalescing(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("dumpTrace") == 0) {
+    result->Success(flutter::EncodableValue(DumpTrace(method_call.arguments())));
+  } else if (method.compare("startWireCapture") == 0) {
+    bool success = StartWireCapture(method_call.arguments());
+    result->Success(flutter::EncodableValue(success));
+  } else if (method.compare("stopWireCapture") == 0) {
+    StopWireCapture();
+    result->Success(flutter::EncodableValue(true));
   } 
   
   // Generic methods that might be called on any channel
@@ -201,32 +408,11 @@ void FlutterBluetoothClassicPlugin::HandleMethodCall(
 }
 
 bool FlutterBluetoothClassicPlugin::IsBluetoothAvailable() {
-  BLUETOOTH_FIND_RADIO_PARAMS params = { sizeof(BLUETOOTH_FIND_RADIO_PARAMS) };
-  HANDLE hRadio;
-  HBLUETOOTH_RADIO_FIND hFind = BluetoothFindFirstRadio(&params, &hRadio);
-  
-  if (hFind != NULL) {
-    CloseHandle(hRadio);
-    BluetoothFindRadioClose(hFind);
-    return true;
-  }
-  return false;
+  return device_cache_.Radio().present;
 }
 
 bool FlutterBluetoothClassicPlugin::IsBluetoothEnabled() {
-  BLUETOOTH_FIND_RADIO_PARAMS params = { sizeof(BLUETOOTH_FIND_RADIO_PARAMS) };
-  HANDLE hRadio;
-  HBLUETOOTH_RADIO_FIND hFind = BluetoothFindFirstRadio(&params, &hRadio);
-  
-  if (hFind != NULL) {
-    BLUETOOTH_RADIO_INFO radioInfo = { sizeof(BLUETOOTH_RADIO_INFO) };
-    DWORD result = BluetoothGetRadioInfo(hRadio, &radioInfo);
-    CloseHandle(hRadio);
-    BluetoothFindRadioClose(hFind);
-    
-    return (result == ERROR_SUCCESS);
-  }
-  return false;
+  return device_cache_.Radio().enabled;
 }
 
 void FlutterBluetoothClassicPlugin::OpenBluetoothSettings() {
@@ -234,106 +420,33 @@ void FlutterBluetoothClassicPlugin::OpenBluetoothSettings() {
 }
 
 flutter::EncodableList FlutterBluetoothClassicPlugin::GetPairedDevices() {
-  flutter::EncodableList devices;
-  
-  BLUETOOTH_DEVICE_SEARCH_PARAMS searchParams = { 0 };
-  searchParams.dwSize = sizeof(BLUETOOTH_DEVICE_SEARCH_PARAMS);
-  searchParams.fReturnAuthenticated = TRUE;
-  searchParams.fReturnRemembered = TRUE;
-  searchParams.fReturnConnected = TRUE;
-  searchParams.fReturnUnknown = FALSE;
-  searchParams.fIssueInquiry = FALSE;
-  searchParams.cTimeoutMultiplier = 1;
-  
-  BLUETOOTH_DEVICE_INFO deviceInfo = { 0 };
-  deviceInfo.dwSize = sizeof(BLUETOOTH_DEVICE_INFO);
-  
-  HBLUETOOTH_DEVICE_FIND hFind = BluetoothFindFirstDevice(&searchParams, &deviceInfo);
-  
-  if (hFind != NULL) {
-    do {
-      flutter::EncodableMap device;
-      
-      // Convert wide string to UTF-8 properly
-      std::wstring wname(deviceInfo.szName);
-      int len = WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, NULL, 0, NULL, NULL);
-      std::string name(len - 1, 0);
-      WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, &name[0], len, NULL, NULL);
-      
-      // Convert address to string
-      char addressStr[18];
-      sprintf_s(addressStr, "%02X:%02X:%02X:%02X:%02X:%02X",
-        deviceInfo.Address.rgBytes[5],
-        deviceInfo.Address.rgBytes[4],
-        deviceInfo.Address.rgBytes[3],
-        deviceInfo.Address.rgBytes[2],
-        deviceInfo.Address.rgBytes[1],
-        deviceInfo.Address.rgBytes[0]);
-      
-      device[flutter::EncodableValue("name")] = flutter::EncodableValue(name);
-      device[flutter::EncodableValue("address")] = flutter::EncodableValue(std::string(addressStr));
-      device[flutter::EncodableValue("type")] = flutter::EncodableValue("classic");
-      device[flutter::EncodableValue("isConnected")] = flutter::EncodableValue(deviceInfo.fConnected == TRUE);
-      
-      devices.push_back(flutter::EncodableValue(device));
-      
-    } while (BluetoothFindNextDevice(hFind, &deviceInfo));
-    
-    BluetoothFindDeviceClose(hFind);
-  }
-  
-  return devices;
+  return EncodeDevices(device_cache_.KnownDevices());
 }
 
-flutter::EncodableList FlutterBluetoothClassicPlugin::StartDiscovery() {
-  flutter::EncodableList devices;
-  
-  BLUETOOTH_DEVICE_SEARCH_PARAMS searchParams = { 0 };
-  searchParams.dwSize = sizeof(BLUETOOTH_DEVICE_SEARCH_PARAMS);
-  searchParams.fReturnAuthenticated = TRUE;
-  searchParams.fReturnRemembered = TRUE;
-  searchParams.fReturnConnected = TRUE;
-  searchParams.fReturnUnknown = TRUE;
-  searchParams.fIssueInquiry = TRUE;
-  searchParams.cTimeoutMultiplier = 2;
-  
-  BLUETOOTH_DEVICE_INFO deviceInfo = { 0 };
-  deviceInfo.dwSize = sizeof(BLUETOOTH_DEVICE_INFO);
-  
-  HBLUETOOTH_DEVICE_FIND hFind = BluetoothFindFirstDevice(&searchParams, &deviceInfo);
-  
-  if (hFind != NULL) {
-    do {
-      flutter::EncodableMap device;
-      
-      // Convert wide string to UTF-8 properly
-      std::wstring wname(deviceInfo.szName);
-      int len = WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, NULL, 0, NULL, NULL);
-      std::string name(len - 1, 0);
-      WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, &name[0], len, NULL, NULL);
-      
-      char addressStr[18];
-      sprintf_s(addressStr, "%02X:%02X:%02X:%02X:%02X:%02X",
-        deviceInfo.Address.rgBytes[5],
-        deviceInfo.Address.rgBytes[4],
-        deviceInfo.Address.rgBytes[3],
-        deviceInfo.Address.rgBytes[2],
-        deviceInfo.Address.rgBytes[1],
-        deviceInfo.Address.rgBytes[0]);
-      
-      device[flutter::EncodableValue("name")] = flutter::EncodableValue(name);
-      device[flutter::EncodableValue("address")] = flutter::EncodableValue(std::string(addressStr));
-      device[flutter::EncodableValue("type")] = flutter::EncodableValue("classic");
-      device[flutter::EncodableValue("isConnected")] = flutter::EncodableValue(deviceInfo.fConnected == TRUE);
-      
-      devices.push_back(flutter::EncodableValue(device));
-      
-    } while (BluetoothFindNextDevice(hFind, &deviceInfo));
-    
-    BluetoothFindDeviceClose(hFind);
-  }
-  
-  return devices;
+bool FlutterBluetoothClassicPlugin::StartDiscovery() {
+  // A session already running keeps going; its devices still stream
+  if (discovery_.IsDiscovering()) return true;
+  
+  DiscoveryOptions options;
+  options.inquiry_rounds = kDiscoveryInquiryRounds;
+  bool started = discovery_.Start(
+      options,
+      [this](const DeviceRecord& device) {
+        dispatcher_->Post([this, device]() {
+          if (!state_sink_) return;
+          flutter::EncodableMap event;
+          event[flutter::EncodableValue("event")] = flutter::EncodableValue("deviceFound");
+          event[flutter::EncodableValue("device")] = EncodeDevice(device);
+          state_sink_->Success(flutter::EncodableValue(event));
+        });
+      },
+      []() { OutputDebugStringA("StartDiscovery: Inquiry rounds finished\n"); });
+  if (!started) OutputDebugStringA("StartDiscovery: Failed to start discovery\n");
+  return started;
+}
+
+flutter::EncodableList FlutterBluetoothClassicPlugin::GetDiscoveredDevices() {
+  return EncodeDevices(discovery_.found());
 }
 
 flutter::EncodableList FlutterBluetoothClassicPlugin::GetConnectedDevices() {
@@ -426,61 +539,43 @@ bool FlutterBluetoothClassicPlugin::ConnectToDevice(const flutter::EncodableValu
   
   OutputDebugStringA("ConnectToDevice: MAC address parsed successfully\n");
   
-  // Create socket
-  SOCKET sock = socket(AF_BTH, SOCK_STREAM, BTHPROTO_RFCOMM);
-  if (sock == INVALID_SOCKET) {
-    int error = WSAGetLastError();
-    char error_msg[256];
-    sprintf_s(error_msg, "ConnectToDevice: Socket creation failed with error %d\n", error);
-    OutputDebugStringA(error_msg);
-    WSACleanup();
-    return false;
-  }
-  
-  OutputDebugStringA("ConnectToDevice: Socket created successfully\n");
-  
-  // Set up connection address
-  SOCKADDR_BTH sockAddr = { 0 };
-  sockAddr.addressFamily = AF_BTH;
-  sockAddr.btAddr = btAddr;
-  sockAddr.port = BT_PORT_ANY; // Try common RFCOMM port
-  
-  // Try connecting to different RFCOMM channels (1-30)
-  bool connected = false;
-  for (int channel = 1; channel <= 30 && !connected; ++channel) {
-    sockAddr.port = channel;
-    
-    char channel_msg[256];
-    sprintf_s(channel_msg, "ConnectToDevice: Trying RFCOMM channel %d\n", channel);
-    OutputDebugStringA(channel_msg);
-    
-    int result = connect(sock, (SOCKADDR*)&sockAddr, sizeof(sockAddr));
-    if (result == 0) {
-      connected = true;
-      char success_msg[256];
-      sprintf_s(success_msg, "ConnectToDevice: Connected successfully on channel %d\n", channel);
-      OutputDebugStringA(success_msg);
-      break;
-    } else {
-      int error = WSAGetLastError();
-      if (error != WSAECONNREFUSED && error != WSAETIMEDOUT) {
-        // Only log non-connection errors
-        char error_msg[256];
-        sprintf_s(error_msg, "ConnectToDevice: Channel %d failed with error %d\n", channel, error);
-        OutputDebugStringA(error_msg);
-      }
+  // Cached channel, then SDP lookup, then parallel probing of channels 1-30
+  RfcommConnectOptions connect_options;
+  auto channel_it = args->find(flutter::EncodableValue("channel"));
+  if (channel_it != args->end()) {
+    if (const auto* channel = std::get_if<int32_t>(&channel_it->second)) {
+      connect_options.cached_channel = *channel;
     }
   }
-  
-  if (!connected) {
+  trace_.Record<TraceLevel::kInfo>(TraceKind::kConnectAttempt, 0, connect_options.cached_channel,
+                                   0, address_str->data(), address_str->size());
+  RfcommTransport transport(btAddr);
+  RfcommConnectResult connection = ConnectRfcomm(&transport, connect_options);
+  const auto elapsed_ms = static_cast<int32_t>(connection.elapsed.count());
+  if (connection.socket == kInvalidSocket) {
+    trace_.Record<TraceLevel::kError>(TraceKind::kConnectFailed, 0, connection.last_error,
+                                      elapsed_ms, address_str->data(), address_str->size());
     OutputDebugStringA("ConnectToDevice: Failed to connect on any RFCOMM channel\n");
-    closesocket(sock);
     WSACleanup();
     return false;
   }
   
+  // Payload says how the channel was found
+  const char* source =
+      connection.from_cache ? "cached" : connection.from_service_lookup ? "SDP" : "probed";
+  trace_.Record<TraceLevel::kInfo>(TraceKind::kConnected, 0, connection.channel, elapsed_ms,
+                                   source, strlen(source));
+
+  // The rest of the plugin expects a blocking socket until the receive loop
+  // takes it over.
+  SOCKET sock = static_cast<SOCKET>(connection.socket);
+  SetNonBlocking(connection.socket, false);
+
   // Store successful connection
   connected_sockets_[*address_str] = sock;
+  connected_channels_[*address_str] = connection.channel;
+  // Pairing and connected flags of the known devices may have changed
+  device_cache_.Invalidate();
   OutputDebugStringA("ConnectToDevice: Connection stored successfully\n");
   
   return true;
@@ -488,11 +583,15 @@ bool FlutterBluetoothClassicPlugin::ConnectToDevice(const flutter::EncodableValu
 
 bool FlutterBluetoothClassicPlugin::DisconnectDevice(const flutter::EncodableValue* arguments) {
   if (!arguments) {
-    // Disconnect all devices
+    // Disconnect all devices - receive loops must stop before their sockets close
+    receive_channels_.ForEach([](HandleTable<ReceiveChannel>::Handle, ReceiveChannel& channel) {
+      channel.loop.reset();
+    });
     for (auto& pair : connected_sockets_) {
       closesocket(pair.second);
     }
     connected_sockets_.clear();
+    connected_channels_.clear();
     return true;
   }
   
@@ -507,8 +606,10 @@ bool FlutterBluetoothClassicPlugin::DisconnectDevice(const flutter::EncodableVal
   
   auto sock_it = connected_sockets_.find(*address_str);
   if (sock_it != connected_sockets_.end()) {
+    StopDataListening(*address_str);
     closesocket(sock_it->second);
     connected_sockets_.erase(sock_it);
+    connected_channels_.erase(*address_str);
     return true;
   }
   
@@ -530,189 +631,632 @@ bool FlutterBluetoothClassicPlugin::IsDeviceConnected(const flutter::EncodableVa
   return connected_sockets_.find(*address_str) != connected_sockets_.end();
 }
 
+flutter::EncodableValue FlutterBluetoothClassicPlugin::GetConnectedChannel(
+    const flutter::EncodableValue* arguments) {
+  if (!arguments) return flutter::EncodableValue();
+
+  const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+  if (!args) return flutter::EncodableValue();
+
+  auto address_it = args->find(flutter::EncodableValue("address"));
+  if (address_it == args->end()) return flutter::EncodableValue();
+
+  const auto* address_str = std::get_if<std::string>(&address_it->second);
+  if (!address_str) return flutter::EncodableValue();
+
+  auto channel_it = connected_channels_.find(*address_str);
+  if (channel_it == connected_channels_.end()) return flutter::EncodableValue();
+  return flutter::EncodableValue(channel_it->second);
+}
+
 void FlutterBluetoothClassicPlugin::NotifyConnectionStateChange(const flutter::EncodableValue* arguments, bool connected) {
-  // This would typically send an event through a method channel
-  // For now, we'll just update internal state
-  // In a full implementation, you'd need to store channel references to send events
+  if (!connection_sink_) return;
+  
+  // Dart's disconnect() sends no address; report an empty one in that case
+  std::string address;
+  if (arguments) {
+    const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+    if (args) {
+      auto address_it = args->find(flutter::EncodableValue("address"));
+      if (address_it != args->end()) {
+        const auto* address_str = std::get_if<std::string>(&address_it->second);
+        if (address_str) address = *address_str;
+      }
+    }
+  }
+  
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("isConnected")] = flutter::EncodableValue(connected);
+  event[flutter::EncodableValue("deviceAddress")] = flutter::EncodableValue(address);
+  event[flutter::EncodableValue("status")] =
+      flutter::EncodableValue(connected ? "connected" : "disconnected");
+  connection_sink_->Success(flutter::EncodableValue(event));
+}
+
+FlutterBluetoothClassicPlugin::ReceiveChannel::ReceiveChannel(const std::string& device_address,
+                                                              const CoalescingOptions& options)
+    : address(device_address),
+      writes([this](bool backlogged) {
+        // A connection that was unregistered meanwhile is simply not found
+        if (reactor) {
+          reactor->SetWriteInterest(connection.load(std::memory_order_acquire), backlogged);
+        }
+      }),
+      ring(kReceiveRingCapacity),
+      window(options),
+      pipeline([this](const std::string& data) { return WriteCommand(data); }) {
+  pipeline.SetLinkStats(&stats);
+  pipeline.SetResponseCounts(&response_counts);
+  pipeline.SetAdaptiveTimeouts(&timeouts);
+  pipeline.SetEcuValues(&ecu_values);
+}
+
+bool FlutterBluetoothClassicPlugin::ReceiveChannel::WriteCommand(const std::string& data) {
+  // The framer strips the echo of the command the pipeline just wrote
+  size_t length = data.size();
+  while (length > 0 && (data[length - 1] == '\r' || data[length - 1] == '\n')) --length;
+  framer.ExpectEcho(data.substr(0, length));
+  command_sent_at = std::chrono::steady_clock::now();
+  
+  trace->Record<TraceLevel::kDebug>(TraceKind::kWrite, static_cast<uint32_t>(handle),
+                                    static_cast<int64_t>(data.size()), 0, data.data(),
+                                    data.size());
+  capture.Record(WireDirection::kSent, data.data(), data.size());
+  if (writes.Write(reinterpret_cast<const uint8_t*>(data.data()), data.size())) {
+    stats.Add(LinkCounter::kBytesSent, data.size());
+    return true;
+  }
+  trace->Record<TraceLevel::kError>(TraceKind::kWriteFailed, static_cast<uint32_t>(handle),
+                                    static_cast<int64_t>(data.size()));
+  return false;
 }
 
 void FlutterBluetoothClassicPlugin::StartDataListening(const std::string& device_address) {
   std::string debug_msg = "StartDataListening called for: " + device_address + "\n";
   OutputDebugStringA(debug_msg.c_str());
   
-  // Check if already listening for this device
-  if (listening_devices_.find(device_address) != listening_devices_.end()) {
-    OutputDebugStringA("Data listening already active for device\n");
-    return;
-  }
-  
   auto sock_it = connected_sockets_.find(device_address);
   if (sock_it == connected_sockets_.end()) {
     OutputDebugStringA("Cannot start data listening - device not connected\n");
     return;
   }
   
-  SOCKET sock = sock_it->second;
+  ReceiveChannel* channel = nullptr;
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it != receive_handles_.end()) {
+    channel = receive_channels_.Get(handle_it->second);
+    if (channel->loop && channel->loop->IsRunning()) {
+      OutputDebugStringA("Data listening already active for device\n");
+      return;
+    }
+    // Previous loop ended (remote close or error) - replace it. With no
+    // producer running the ring can be reset from this side.
+    channel->loop.reset();
+    channel->ring.Clear();
+    channel->window.Reset();
+    channel->framer.Reset();
+    channel->pipeline.Cancel();
+    channel->packer.Reset();
+    channel->response_counts.Reset();
+    channel->timeouts.Reset();
+    channel->ecu_values.Reset();
+    channel->monitoring.store(false, std::memory_order_relaxed);
+    channel->monitor.Reset();
+  } else {
+    std::lock_guard<std::mutex> lock(coalescing_mutex_);
+    auto new_channel = std::make_unique<ReceiveChannel>(device_address, coalescing_options_);
+    new_channel->options_version = coalescing_version_.load(std::memory_order_relaxed);
+    new_channel->trace = &trace_;
+    new_channel->reactor = &io_reactor_;
+    channel = new_channel.get();
+    channel->handle = receive_channels_.Insert(std::move(new_channel));
+    receive_handles_[device_address] = channel->handle;
+    channel->pipeline.SetPollScheduler(
+        &channel->scheduler, std::chrono::milliseconds(kDefaultCommandTimeoutMs),
+        [this, channel](CommandResult&& sample) {
+          std::vector<CommandResult> samples;
+          switch (channel->packer.Split(std::move(sample), &samples)) {
+            case Mode01Packer::SplitOutcome::kPassThrough:
+              samples.push_back(std::move(sample));
+              break;
+            case Mode01Packer::SplitOutcome::kSplit:
+              break;
+            case Mode01Packer::SplitOutcome::kRejected:
+              // Rescheduled on the platform thread so it stays ordered with
+              // setPollSchedule
+              dispatcher_->Post([this, device_address = channel->address]() {
+                RepackPollSchedule(device_address);
+              });
+              return;
+          }
+          dispatcher_->Post(
+              [this, device_address = channel->address, samples = std::move(samples)]() {
+                for (const auto& result : samples) DeliverPollSample(device_address, result);
+              });
+        });
+  }
+  channel->socket = sock_it->second;
+  channel->writes.Reset(sock_it->second);
+  if (!wire_capture_directory_.empty() && !channel->capture.is_open()) OpenWireCapture(channel);
+  
+  // The shared I/O thread blocks in the reactor until a socket is readable,
+  // so bytes reach the ring as soon as the kernel has them instead of on a
+  // 10 ms poll tick. The timer handler closes coalescing windows no new
+  // chunk closed.
+  auto loop = std::make_unique<ReceiveLoop>(
+      sock_it->second,
+      [this, channel](const uint8_t* data, size_t length) {
+        OnDataReceived(channel, data, length);
+      },
+      [this, channel](int error) {
+        const auto id = static_cast<uint32_t>(channel->handle);
+        if (error == 0) {
+          trace_.Record<TraceLevel::kInfo>(TraceKind::kClosed, id, 0);
+        } else {
+          trace_.Record<TraceLevel::kError>(TraceKind::kClosed, id, error);
+        }
+        // Deliver whatever the adapter sent before the link dropped
+        if (channel->window.pending() > 0) RequestDrain(channel);
+        channel->pipeline.Cancel();
+        channel->scheduler.SetSchedule({});
+        dispatcher_->Post([this, device_address = channel->address]() {
+          flutter::EncodableMap args;
+          args[flutter::EncodableValue("address")] = flutter::EncodableValue(device_address);
+          flutter::EncodableValue arguments(args);
+          NotifyConnectionStateChange(&arguments, false);
+        });
+      },
+      &io_reactor_);
+  loop->SetTimerHandler([this, channel]() { return OnDataTimer(channel); });
+  loop->SetWritableHandler([channel]() { channel->writes.Flush(); });
+  
+  if (!loop->Start()) {
+    OutputDebugStringA("StartDataListening: Failed to start receive loop\n");
+    return;
+  }
+  channel->connection.store(loop->id(), std::memory_order_release);
+  channel->loop = std::move(loop);
   
-  // Set socket to non-blocking mode for polling
-  u_long mode = 1;
-  ioctlsocket(sock, FIONBIO, &mode);
+  OutputDebugStringA("Data listening registered with the I/O reactor\n");
+}
+
+void FlutterBluetoothClassicPlugin::StopDataListening(const std::string& device_address) {
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it != receive_handles_.end()) {
+    ReceiveChannel* channel = receive_channels_.Get(handle_it->second);
+    channel->loop.reset();
+    // With the socket unregistered, answer any batch it was still running
+    channel->pipeline.Cancel();
+    channel->scheduler.SetSchedule({});
+  }
+}
+
+FlutterBluetoothClassicPlugin::ReceiveChannel* FlutterBluetoothClassicPlugin::FindReceiveChannel(
+    const flutter::EncodableValue* arguments) {
+  if (!arguments) return nullptr;
   
-  // Store device for data monitoring
-  listening_devices_.insert(device_address);
+  const auto* args = std::get_if<flutter::EncodableMap>(arguments);
+  if (!args) return nullptr;
   
-  // Clear any existing data buffer for fresh start
-  {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    received_data_[device_address].clear();
-  }
+  auto address_it = args->find(flutter::EncodableValue("address"));
+  if (address_it == args->end()) return nullptr;
   
-  // Start background thread for data monitoring
-  std::thread data_thread([this, device_address, sock]() {
-    this->DataListeningThread(device_address, sock);
-  });
-  data_thread.detach();
+  const auto* address_str = std::get_if<std::string>(&address_it->second);
+  if (!address_str) return nullptr;
   
-  OutputDebugStringA("Data listening thread started for device\n");
+  auto handle_it = receive_handles_.find(*address_str);
+  if (handle_it == receive_handles_.end()) return nullptr;
+  return receive_channels_.Get(handle_it->second);
 }
 
-void FlutterBluetoothClassicPlugin::DataListeningThread(const std::string& device_address, SOCKET sock) {
-  char buffer[1024];
-  
-  std::string thread_debug_msg = "DataListeningThread: Started for device: " + device_address + "\n";
-  OutputDebugStringA(thread_debug_msg.c_str());
+FlutterBluetoothClassicPlugin::ReceiveChannel* FlutterBluetoothClassicPlugin::FindCommandChannel(
+    const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindReceiveChannel(arguments);
+  if (channel) return channel;
+  
+  // Like sendData, no address means the single connection
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  bool has_address = args && args->find(flutter::EncodableValue("address")) != args->end();
+  if (has_address || receive_handles_.size() != 1) return nullptr;
+  return receive_channels_.Get(receive_handles_.begin()->second);
+}
+
+void FlutterBluetoothClassicPlugin::RemoveReceiveChannel(const std::string& device_address) {
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it == receive_handles_.end()) return;
+  // Unregister the socket before the channel is destroyed
+  auto channel = receive_channels_.Remove(handle_it->second);
+  receive_handles_.erase(handle_it);
+  channel->loop.reset();
+  channel->pipeline.Cancel();
+}
+
+void FlutterBluetoothClassicPlugin::RemoveAllReceiveChannels() {
+  for (const auto& pair : receive_handles_) {
+    auto channel = receive_channels_.Remove(pair.second);
+    channel->loop.reset();
+    channel->pipeline.Cancel();
+  }
+  receive_handles_.clear();
+}
+
+void FlutterBluetoothClassicPlugin::OnDataReceived(ReceiveChannel* channel,
+                                                   const uint8_t* data, size_t length) {
+  trace_.Record<TraceLevel::kDebug>(TraceKind::kRecv, static_cast<uint32_t>(channel->handle),
+                                    static_cast<int64_t>(length), 0, data, length);
+  channel->capture.Record(WireDirection::kReceived, data, length);
+  channel->stats.Add(LinkCounter::kBytesReceived, length);
+  
+  if (channel->monitoring.load(std::memory_order_acquire)) {
+    // Monitor output is decoded here on the I/O thread; only the values
+    // cross to the platform thread, when getJ1939Values asks for them
+    if (!channel->monitor.Feed(data, length, std::chrono::steady_clock::now())) return;
+    // The prompt: monitoring ended (stopJ1939Monitor, BUFFER FULL or a
+    // write). Put ISO-TP formatting back before anything else runs.
+    channel->monitoring.store(false, std::memory_order_release);
+    channel->framer.Reset();
+    channel->pipeline.Submit(channel->monitor_restore,
+                             std::chrono::milliseconds(kDefaultCommandTimeoutMs), nullptr);
+    // Not through |loop|: the platform thread may be resetting it
+    io_reactor_.Wake(channel->connection.load(std::memory_order_acquire));
+    return;
+  }
   
-  while (listening_devices_.find(device_address) != listening_devices_.end() && 
-         connected_sockets_.find(device_address) != connected_sockets_.end()) {
-    
-    int bytes_received = recv(sock, buffer, sizeof(buffer), 0);
-    
-    if (bytes_received > 0) {
-      // Store raw received data WITHOUT any modifications (like Android)
-      {
-        std::lock_guard<std::mutex> lock(data_mutex_);
-        received_data_[device_address].append(buffer, bytes_received);
-      }
-      
-      // Debug: Log received data in detail
-      std::string recv_debug_msg = "Received " + std::to_string(bytes_received) + " bytes from " + device_address + ": ";
-      int max_chars = bytes_received < 50 ? bytes_received : 50;
-      for (int j = 0; j < max_chars; j++) {
-        if (buffer[j] >= 32 && buffer[j] <= 126) {
-          recv_debug_msg += buffer[j];
-        } else {
-          recv_debug_msg += "[" + std::to_string((unsigned char)buffer[j]) + "]";
-        }
-      }
-      if (bytes_received > 50) recv_debug_msg += "...";
-      recv_debug_msg += "\n";
-      OutputDebugStringA(recv_debug_msg.c_str());
-      
-    } else if (bytes_received == 0) {
-      OutputDebugStringA("DataListeningThread: Connection closed by remote device\n");
-      break;
-    } else {
-      int error = WSAGetLastError();
-      if (error != WSAEWOULDBLOCK) {
-        char error_msg[256];
-        sprintf_s(error_msg, "DataListeningThread: Receive error: %d\n", error);
-        OutputDebugStringA(error_msg);
-        break;
-      }
+  if (response_framing_.load(std::memory_order_acquire) || channel->pipeline.busy()) {
+    FrameResponses(channel, data, length);
+  } else {
+    // Store raw received data WITHOUT any modifications (like Android)
+    size_t stored = channel->ring.Write(data, length);
+    if (stored < length) {
+      channel->stats.Add(LinkCounter::kOverflows);
+      channel->stats.Add(LinkCounter::kDroppedBytes, length - stored);
+      trace_.Record<TraceLevel::kError>(TraceKind::kOverflow,
+                                        static_cast<uint32_t>(channel->handle),
+                                        static_cast<int64_t>(length - stored));
     }
     
-    // Use same delay as Android (10ms)
-    Sleep(10);
+    // Merge RFCOMM fragments so one adapter reply becomes one platform message
+    SyncCoalescingOptions(channel);
+    if (channel->window.Add(data, stored, CoalescingWindow::Clock::now())) {
+      RequestDrain(channel);
+    }
   }
-  
-  OutputDebugStringA("DataListeningThread: Ending for device\n");
-  listening_devices_.erase(device_address);
 }
 
-std::string FlutterBluetoothClassicPlugin::ReadData(const flutter::EncodableValue* arguments) {
-  if (!arguments) return "";
+int FlutterBluetoothClassicPlugin::OnDataTimer(ReceiveChannel* channel) {
+  SyncCoalescingOptions(channel);
+  auto now = CoalescingWindow::Clock::now();
+  if (channel->window.IsDue(now)) RequestDrain(channel);
+  int window_ms = channel->window.MillisecondsUntilDue(now);
+  int pipeline_ms = channel->pipeline.OnTimer(now);
+  if (window_ms < 0) return pipeline_ms;
+  if (pipeline_ms < 0) return window_ms;
+  return window_ms < pipeline_ms ? window_ms : pipeline_ms;
+}
+
+void FlutterBluetoothClassicPlugin::SyncCoalescingOptions(ReceiveChannel* channel) {
+  uint32_t version = coalescing_version_.load(std::memory_order_acquire);
+  if (version == channel->options_version) return;
+  std::lock_guard<std::mutex> lock(coalescing_mutex_);
+  channel->window.set_options(coalescing_options_);
+  channel->options_version = version;
+}
+
+void FlutterBluetoothClassicPlugin::RequestDrain(ReceiveChannel* channel) {
+  // The bytes stay in the ring; the platform thread takes whatever is there
+  // when the task runs, so a late task simply finds less (or nothing).
+  channel->window.Reset();
+  dispatcher_->Post([this, handle = channel->handle]() { DrainReceiveChannel(handle); });
+}
+
+void FlutterBluetoothClassicPlugin::DrainReceiveChannel(HandleTable<ReceiveChannel>::Handle handle) {
+  // Without a listener the data stays buffered for readData (like Android)
+  ReceiveChannel* channel = receive_channels_.Get(handle);
+  if (!channel || !data_sink_) return;
+  
+  ByteRing::Region regions[2];
+  int region_count = channel->ring.Peek(regions);
+  if (region_count == 0) return;
+  
+  std::vector<uint8_t> data;
+  data.reserve(regions[0].size + (region_count > 1 ? regions[1].size : 0));
+  for (int i = 0; i < region_count; ++i) {
+    data.insert(data.end(), regions[i].data, regions[i].data + regions[i].size);
+  }
+  channel->ring.Consume(data.size());
   
-  const auto* args = std::get_if<flutter::EncodableMap>(arguments);
-  if (!args) return "";
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("deviceAddress")] = flutter::EncodableValue(channel->address);
+  event[flutter::EncodableValue("data")] = flutter::EncodableValue(std::move(data));
+  data_sink_->Success(flutter::EncodableValue(event));
+}
+
+void FlutterBluetoothClassicPlugin::FrameResponses(ReceiveChannel* channel,
+                                                   const uint8_t* data, size_t length) {
+  uint32_t version = channel->last_command_version.load(std::memory_order_acquire);
+  if (version != channel->command_version) {
+    std::lock_guard<std::mutex> lock(channel->command_mutex);
+    channel->framer.ExpectEcho(channel->last_command);
+    channel->framed_command = channel->last_command;
+    channel->command_sent_at = channel->last_command_at;
+    channel->command_version = version;
+  }
   
-  auto address_it = args->find(flutter::EncodableValue("address"));
-  if (address_it == args->end()) return "";
+  size_t count = channel->framer.Feed(data, length, ElmResponse::Clock::now(),
+                                      &channel->completed_responses);
+  if (count == 0) return;
+  channel->stats.Add(LinkCounter::kResponses, count);
   
-  const auto* address_str = std::get_if<std::string>(&address_it->second);
-  if (!address_str) return "";
-  
-  std::lock_guard<std::mutex> lock(data_mutex_);
-  auto data_it = received_data_.find(*address_str);
-  if (data_it != received_data_.end()) {
-    std::string data = data_it->second;
-    if (!data.empty()) {
-      data_it->second.clear(); // Clear after reading
-      
-      // Debug: Log what's being returned to Flutter
-      std::string read_debug_msg = "ReadData returning " + std::to_string(data.length()) + " bytes: ";
-      size_t max_chars = data.length() < 50 ? data.length() : 50;
-      for (size_t k = 0; k < max_chars; k++) {
-        if (data[k] >= 32 && data[k] <= 126) {
-          read_debug_msg += data[k];
-        } else {
-          read_debug_msg += "[" + std::to_string((unsigned char)data[k]) + "]";
-        }
-      }
-      if (data.length() > 50) read_debug_msg += "...";
-      read_debug_msg += "\n";
-      OutputDebugStringA(read_debug_msg.c_str());
-      
-      // Return raw data exactly as received - no processing
-      return data;
+  bool deliver = response_framing_.load(std::memory_order_acquire);
+  for (auto& response : channel->completed_responses) {
+    // Answers to sendCommands batches go back with the batch result
+    if (channel->pipeline.OnResponse(std::move(response))) continue;
+    if (!deliver) continue;
+    
+    // Round trip from the write when the response belongs to a known
+    // command, otherwise from the first byte of the response
+    bool known = channel->command_version != 0 && channel->command_sent_at <= response.first_byte_at;
+    auto start = known ? channel->command_sent_at : response.first_byte_at;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(response.completed_at - start);
+    std::string command;
+    if (known) {
+      command = channel->framed_command;
+      CommandStats* stats = channel->stats.ForCommand(command);
+      stats->completed.fetch_add(1, std::memory_order_relaxed);
+      stats->Record(LatencyPhase::kFirstByte, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  response.first_byte_at - start));
+      stats->Record(LatencyPhase::kPrompt, std::chrono::duration_cast<std::chrono::microseconds>(
+                                               response.completed_at - response.first_byte_at));
+      stats->Record(LatencyPhase::kRoundTrip, elapsed);
     }
+    dispatcher_->Post([this, device_address = channel->address, command = std::move(command),
+                       response = std::move(response), elapsed_us = elapsed.count()]() {
+      if (!command.empty()) RecordDelivery(device_address, command, response.completed_at);
+      DeliverResponse(device_address, response, elapsed_us);
+    });
+  }
+  channel->completed_responses.clear();
+}
+
+void FlutterBluetoothClassicPlugin::DeliverResponse(const std::string& device_address,
+                                                    const ElmResponse& response, int64_t elapsed_us) {
+  if (!response_sink_) return;
+  
+  flutter::EncodableList lines;
+  lines.reserve(response.lines.size());
+  for (const auto& line : response.lines) {
+    lines.push_back(flutter::EncodableValue(line));
   }
   
-  return "";
+  // Wall-clock time of the prompt, for correlating with Dart timestamps
+  auto age = ElmResponse::Clock::now() - response.completed_at;
+  int64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      (std::chrono::system_clock::now() - age).time_since_epoch()).count();
+  
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("deviceAddress")] = flutter::EncodableValue(device_address);
+  event[flutter::EncodableValue("lines")] = flutter::EncodableValue(std::move(lines));
+  event[flutter::EncodableValue("timestampUs")] = flutter::EncodableValue(timestamp_us);
+  event[flutter::EncodableValue("elapsedUs")] = flutter::EncodableValue(elapsed_us);
+  response_sink_->Success(flutter::EncodableValue(event));
 }
 
-int FlutterBluetoothClassicPlugin::GetAvailableBytes(const flutter::EncodableValue* arguments) {
-  if (!arguments) return 0;
+void FlutterBluetoothClassicPlugin::DeliverPollSample(const std::string& device_address,
+                                                      const CommandResult& sample) {
+  if (!poll_sink_) return;
+  
+  flutter::EncodableList lines;
+  lines.reserve(sample.lines.size());
+  for (const auto& line : sample.lines) {
+    lines.push_back(flutter::EncodableValue(line));
+  }
+  int64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  RecordDelivery(device_address, sample.command, sample.completed_at);
+  
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("deviceAddress")] = flutter::EncodableValue(device_address);
+  event[flutter::EncodableValue("command")] = flutter::EncodableValue(sample.command);
+  event[flutter::EncodableValue("status")] = flutter::EncodableValue(CommandStatusName(sample.status));
+  event[flutter::EncodableValue("lines")] = flutter::EncodableValue(std::move(lines));
+  event[flutter::EncodableValue("timestampUs")] = flutter::EncodableValue(timestamp_us);
+  event[flutter::EncodableValue("elapsedUs")] =
+      flutter::EncodableValue(static_cast<int64_t>(sample.elapsed.count()));
+  poll_sink_->Success(flutter::EncodableValue(event));
+}
+
+void FlutterBluetoothClassicPlugin::RepackPollSchedule(const std::string& device_address) {
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it == receive_handles_.end()) return;
+  ReceiveChannel* channel = receive_channels_.Get(handle_it->second);
+  if (!channel || !channel->loop || !channel->loop->IsRunning()) return;
+  
+  OutputDebugStringA("SetPollSchedule: multi-PID request rejected, polling its PIDs singly\n");
+  channel->scheduler.SetSchedule(channel->packer.Repack());
+  channel->loop->Wake();
+}
+
+void FlutterBluetoothClassicPlugin::RecordDelivery(
+    const std::string& device_address, const std::string& command,
+    std::chrono::steady_clock::time_point completed_at) {
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it == receive_handles_.end()) return;
+  // Cancelled commands never completed
+  if (completed_at == std::chrono::steady_clock::time_point()) return;
+  ReceiveChannel* channel = receive_channels_.Get(handle_it->second);
+  auto hop = std::chrono::steady_clock::now() - completed_at;
+  channel->stats.ForCommand(command)->Record(
+      LatencyPhase::kDelivery, std::chrono::duration_cast<std::chrono::microseconds>(hop));
+}
+
+void FlutterBluetoothClassicPlugin::NoteCommandWritten(const std::string& device_address,
+                                                       const char* data, size_t length) {
+  auto handle_it = receive_handles_.find(device_address);
+  if (handle_it == receive_handles_.end()) return;
+  ReceiveChannel* channel = receive_channels_.Get(handle_it->second);
+  
+  // The adapter echoes the command without its CR terminator
+  while (length > 0 && (data[length - 1] == '\r' || data[length - 1] == '\n')) --length;
+  
+  std::lock_guard<std::mutex> lock(channel->command_mutex);
+  channel->last_command.assign(data, length);
+  channel->last_command_at = std::chrono::steady_clock::now();
+  channel->last_command_version.fetch_add(1, std::memory_order_release);
+}
+
+bool FlutterBluetoothClassicPlugin::SetResponseFraming(const flutter::EncodableValue* arguments) {
+  if (!arguments) return false;
   
   const auto* args = std::get_if<flutter::EncodableMap>(arguments);
-  if (!args) return 0;
+  if (!args) return false;
   
-  auto address_it = args->find(flutter::EncodableValue("address"));
-  if (address_it == args->end()) return 0;
+  auto enabled_it = args->find(flutter::EncodableValue("enabled"));
+  if (enabled_it == args->end()) return false;
   
-  const auto* address_str = std::get_if<std::string>(&address_it->second);
-  if (!address_str) return 0;
-  
-  std::lock_guard<std::mutex> lock(data_mutex_);
-  auto data_it = received_data_.find(*address_str);
-  if (data_it != received_data_.end()) {
-    int available = (int)data_it->second.length();
-    if (available > 0) {
-      std::string debug_msg = "GetAvailableBytes: " + std::to_string(available) + " bytes available\n";
-      OutputDebugStringA(debug_msg.c_str());
-    }
-    return available;
-  }
+  const auto* enabled = std::get_if<bool>(&enabled_it->second);
+  if (!enabled) return false;
   
-  return 0;
+  response_framing_.store(*enabled, std::memory_order_release);
+  return true;
 }
 
-bool FlutterBluetoothClassicPlugin::FlushData(const flutter::EncodableValue* arguments) {
+bool FlutterBluetoothClassicPlugin::SetDataCoalescing(const flutter::EncodableValue* arguments) {
   if (!arguments) return false;
   
   const auto* args = std::get_if<flutter::EncodableMap>(arguments);
   if (!args) return false;
   
-  auto address_it = args->find(flutter::EncodableValue("address"));
-  if (address_it == args->end()) return false;
+  std::lock_guard<std::mutex> lock(coalescing_mutex_);
+  CoalescingOptions options = coalescing_options_;
   
-  const auto* address_str = std::get_if<std::string>(&address_it->second);
-  if (!address_str) return false;
+  int64_t value = 0;
+  if (GetIntArgument(*args, "windowMs", &value)) {
+    if (value < 0) return false;
+    options.window = std::chrono::milliseconds(value);
+  }
+  if (GetIntArgument(*args, "maxBytes", &value)) {
+    if (value <= 0) return false;
+    options.max_bytes = static_cast<size_t>(value);
+  }
+  auto prompt_it = args->find(flutter::EncodableValue("flushOnPrompt"));
+  if (prompt_it != args->end()) {
+    const auto* flush_on_prompt = std::get_if<bool>(&prompt_it->second);
+    if (!flush_on_prompt) return false;
+    options.flush_byte = *flush_on_prompt ? '>' : -1;
+  }
+  
+  // Receive threads pick the new options up with their next chunk or timer
+  coalescing_options_ = options;
+  coalescing_version_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+std::string FlutterBluetoothClassicPlugin::ReadData(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindReceiveChannel(arguments);
+  if (!channel) return "";
+  
+  ByteRing::Region regions[2];
+  int region_count = channel->ring.Peek(regions);
+  if (region_count == 0) return "";
+  
+  std::string data;
+  data.reserve(regions[0].size + (region_count > 1 ? regions[1].size : 0));
+  for (int i = 0; i < region_count; ++i) {
+    data.append(reinterpret_cast<const char*>(regions[i].data), regions[i].size);
+  }
+  channel->ring.Consume(data.length()); // Clear after reading
+  
+  trace_.Record<TraceLevel::kDebug>(TraceKind::kRead, static_cast<uint32_t>(channel->handle),
+                                    static_cast<int64_t>(data.size()), 0, data.data(),
+                                    data.size());
+  
+  // Return raw data exactly as received - no processing
+  return data;
+}
+
+int FlutterBluetoothClassicPlugin::GetAvailableBytes(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindReceiveChannel(arguments);
+  if (!channel) return 0;
   
-  std::lock_guard<std::mutex> lock(data_mutex_);
-  received_data_[*address_str].clear();
+  return static_cast<int>(channel->ring.Available());
+}
+
+flutter::EncodableMap FlutterBluetoothClassicPlugin::GetReceiveBufferStats(
+    const flutter::EncodableValue* arguments) {
+  flutter::EncodableMap stats;
+  ReceiveChannel* channel = FindReceiveChannel(arguments);
+  if (!channel) return stats;
+  
+  stats[flutter::EncodableValue("available")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->ring.Available()));
+  stats[flutter::EncodableValue("capacity")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->ring.capacity()));
+  stats[flutter::EncodableValue("droppedBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->ring.dropped_bytes()));
+  stats[flutter::EncodableValue("overflowCount")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->ring.overflow_count()));
+  return stats;
+}
+
+bool FlutterBluetoothClassicPlugin::FlushData(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindReceiveChannel(arguments);
+  if (!channel) return false;
+  
+  channel->ring.Clear();
   return true;
 }
 
+std::string FlutterBluetoothClassicPlugin::DumpTrace(const flutter::EncodableValue* arguments) {
+  int64_t max_events = static_cast<int64_t>(trace_.capacity());
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (args) GetIntArgument(*args, "maxEvents", &max_events);
+  if (max_events <= 0) return "";
+  return trace_.Dump(static_cast<size_t>(max_events));
+}
+
+bool FlutterBluetoothClassicPlugin::StartWireCapture(const flutter::EncodableValue* arguments) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) return false;
+  auto directory_it = args->find(flutter::EncodableValue("directory"));
+  if (directory_it == args->end()) return false;
+  const auto* directory = std::get_if<std::string>(&directory_it->second);
+  if (!directory || directory->empty()) return false;
+  
+  // Connections already listening start a new file too; later ones open
+  // theirs in StartDataListening
+  wire_capture_directory_ = *directory;
+  bool success = true;
+  for (const auto& pair : receive_handles_) {
+    success = OpenWireCapture(receive_channels_.Get(pair.second)) && success;
+  }
+  return success;
+}
+
+void FlutterBluetoothClassicPlugin::StopWireCapture() {
+  wire_capture_directory_.clear();
+  for (const auto& pair : receive_handles_) {
+    receive_channels_.Get(pair.second)->capture.Close();
+  }
+}
+
+bool FlutterBluetoothClassicPlugin::OpenWireCapture(ReceiveChannel* channel) {
+  // One file per connection: <directory>\<address without colons>_<unix ms>.ccwire
+  std::string name;
+  for (char c : channel->address) {
+    if (c != ':') name.push_back(c);
+  }
+  const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  std::string path = wire_capture_directory_;
+  if (path.back() != '\\' && path.back() != '/') path += '\\';
+  path += name + "_" + std::to_string(now_ms) + ".ccwire";
+  
+  if (channel->capture.Open(path, channel->address)) return true;
+  trace_.Record<TraceLevel::kError>(TraceKind::kError, static_cast<uint32_t>(channel->handle),
+                                    errno, 0, path.data(), path.size());
+  return false;
+}
+
 bool FlutterBluetoothClassicPlugin::WriteData(const flutter::EncodableValue* arguments) {
   if (!arguments) return false;
   
@@ -722,48 +1266,748 @@ bool FlutterBluetoothClassicPlugin::WriteData(const flutter::EncodableValue* arg
   auto address_it = args->find(flutter::EncodableValue("address"));
   auto data_it = args->find(flutter::EncodableValue("data"));
   
-  if (address_it == args->end() || data_it == args->end()) return false;
-  
-  const auto* address_str = std::get_if<std::string>(&address_it->second);
-  
-  if (!address_str) return false;
+  if (data_it == args->end()) return false;
   
-  auto sock_it = connected_sockets_.find(*address_str);
+  // Dart's sendData() carries no address; it targets the single connection
+  auto sock_it = connected_sockets_.end();
+  if (address_it != args->end()) {
+    const auto* address_str = std::get_if<std::string>(&address_it->second);
+    if (!address_str) return false;
+    sock_it = connected_sockets_.find(*address_str);
+  } else if (connected_sockets_.size() == 1) {
+    sock_it = connected_sockets_.begin();
+  }
   if (sock_it == connected_sockets_.end()) return false;
+  const std::string* address_str = &sock_it->first;
   
-  // Handle both string and binary data
-  const char* data_ptr = nullptr;
+  // Uint8List arrives as std::vector<uint8_t> and is sent from the decoded
+  // message without another copy; strings and boxed-int lists from older
+  // callers are still accepted.
+  const uint8_t* data_ptr = nullptr;
   size_t data_len = 0;
-  
-  if (const auto* data_str = std::get_if<std::string>(&data_it->second)) {
-    data_ptr = data_str->c_str();
-    data_len = data_str->length();
+  std::vector<uint8_t> list_bytes;
+  
+  if (const auto* data_bytes = std::get_if<std::vector<uint8_t>>(&data_it->second)) {
+    data_ptr = data_bytes->data();
+    data_len = data_bytes->size();
+  } else if (const auto* data_str = std::get_if<std::string>(&data_it->second)) {
+    data_ptr = reinterpret_cast<const uint8_t*>(data_str->data());
+    data_len = data_str->size();
   } else if (const auto* data_list = std::get_if<flutter::EncodableList>(&data_it->second)) {
-    // Handle binary data as list of bytes
-    static std::vector<char> byte_buffer;
-    byte_buffer.clear();
-    byte_buffer.reserve(data_list->size());
-    
+    list_bytes.reserve(data_list->size());
     for (const auto& byte_val : *data_list) {
       if (const auto* byte_int = std::get_if<int>(&byte_val)) {
-        byte_buffer.push_back(static_cast<char>(*byte_int));
+        list_bytes.push_back(static_cast<uint8_t>(*byte_int));
+      }
+    }
+    data_ptr = list_bytes.data();
+    data_len = list_bytes.size();
+  }
+  if (!data_ptr || data_len == 0) return false;
+  
+  // Recorded before sending so the I/O thread already knows the echo
+  // when the first response byte arrives
+  NoteCommandWritten(*address_str, reinterpret_cast<const char*>(data_ptr), data_len);
+  
+  // A listening connection goes through its write queue: sent now if the
+  // socket is idle, otherwise coalesced with the backlog and flushed by
+  // the I/O thread.
+  auto handle_it = receive_handles_.find(*address_str);
+  const uint32_t trace_id =
+      handle_it != receive_handles_.end() ? static_cast<uint32_t>(handle_it->second) : 0;
+  trace_.Record<TraceLevel::kDebug>(TraceKind::kWrite, trace_id, static_cast<int64_t>(data_len),
+                                    0, data_ptr, data_len);
+  if (handle_it != receive_handles_.end()) {
+    ReceiveChannel* channel = receive_channels_.Get(handle_it->second);
+    if (channel->loop && channel->loop->IsRunning()) {
+      channel->capture.Record(WireDirection::kSent, data_ptr, data_len);
+      bool queued = list_bytes.empty() ? channel->writes.Write(data_ptr, data_len)
+                                       : channel->writes.Write(std::move(list_bytes));
+      channel->stats.Add(queued ? LinkCounter::kBytesSent : LinkCounter::kWriteFailures,
+                         queued ? data_len : 1);
+      if (!queued) {
+        trace_.Record<TraceLevel::kError>(TraceKind::kWriteFailed, trace_id,
+                                          static_cast<int64_t>(data_len));
       }
+      return queued;
     }
+  }
+  
+  // Not listening, so the socket is still blocking
+  size_t sent = 0;
+  while (sent < data_len) {
+    int result = SendSome(sock_it->second, data_ptr + sent, data_len - sent);
+    if (result <= 0) {
+      trace_.Record<TraceLevel::kError>(TraceKind::kWriteFailed, trace_id,
+                                        static_cast<int64_t>(data_len), LastSocketError());
+      return false;
+    }
+    sent += static_cast<size_t>(result);
+  }
+  return true;
+}
+
+void FlutterBluetoothClassicPlugin::SendCommands(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) {
+    result->Error("INVALID_ARGUMENT", "Arguments must be a map");
+    return;
+  }
+  
+  auto commands_it = args->find(flutter::EncodableValue("commands"));
+  const auto* command_list = commands_it != args->end()
+                                 ? std::get_if<flutter::EncodableList>(&commands_it->second)
+                                 : nullptr;
+  if (!command_list || command_list->empty()) {
+    result->Error("INVALID_ARGUMENT", "commands must be a non-empty list of strings");
+    return;
+  }
+  std::vector<std::string> commands;
+  commands.reserve(command_list->size());
+  for (const auto& value : *command_list) {
+    const auto* command = std::get_if<std::string>(&value);
+    if (!command) {
+      result->Error("INVALID_ARGUMENT", "commands must be a non-empty list of strings");
+      return;
+    }
+    commands.push_back(*command);
+  }
+  
+  int64_t timeout_ms = kDefaultCommandTimeoutMs;
+  if (GetIntArgument(*args, "timeoutMs", &timeout_ms) && timeout_ms <= 0) {
+    result->Error("INVALID_ARGUMENT", "timeoutMs must be positive");
+    return;
+  }
+  
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->loop || !channel->loop->IsRunning()) {
+    result->Error("NOT_CONNECTED", "No active connection to send commands on");
+    return;
+  }
+  
+  // MethodResult is move-only; the batch handler is a std::function
+  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+  channel->pipeline.Submit(
+      std::move(commands), std::chrono::milliseconds(timeout_ms),
+      [this, shared_result, device_address = channel->address](
+          std::vector<CommandResult>&& results) {
+        auto encoded = std::make_shared<flutter::EncodableList>(EncodeCommandResults(results));
+        // A batch crosses to the platform thread once, when its last
+        // command completes; the hop is recorded against that command
+        const CommandResult& last = results.back();
+        dispatcher_->Post([this, shared_result, encoded, device_address, command = last.command,
+                           completed_at = last.completed_at]() {
+          RecordDelivery(device_address, command, completed_at);
+          shared_result->Success(flutter::EncodableValue(std::move(*encoded)));
+        });
+      });
+  // Also runs from the handler above on the I/O thread, so not through
+  // |loop|, which the platform thread may be resetting meanwhile
+  io_reactor_.Wake(channel->connection.load(std::memory_order_acquire));
+}
+
+bool FlutterBluetoothClassicPlugin::SetPollSchedule(const flutter::EncodableValue* arguments) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) return false;
+  
+  auto entries_it = args->find(flutter::EncodableValue("entries"));
+  if (entries_it == args->end()) return false;
+  const auto* entry_list = std::get_if<flutter::EncodableList>(&entries_it->second);
+  if (!entry_list) return false;
+  
+  std::vector<PollEntry> entries;
+  entries.reserve(entry_list->size());
+  for (const auto& value : *entry_list) {
+    const auto* entry_map = std::get_if<flutter::EncodableMap>(&value);
+    if (!entry_map) return false;
+    auto command_it = entry_map->find(flutter::EncodableValue("command"));
+    if (command_it == entry_map->end()) return false;
+    const auto* command = std::get_if<std::string>(&command_it->second);
+    int64_t period_ms = 0;
+    if (!command || command->empty() || !GetIntArgument(*entry_map, "periodMs", &period_ms) ||
+        period_ms <= 0) {
+      return false;
+    }
+    entries.push_back({*command, std::chrono::milliseconds(period_ms)});
+  }
+  
+  // Optional: pack single-PID Mode 01 entries of equal period into
+  // multi-PID requests
+  bool pack_mode01 = false;
+  auto pack_it = args->find(flutter::EncodableValue("packMode01"));
+  if (pack_it != args->end()) {
+    const auto* pack = std::get_if<bool>(&pack_it->second);
+    pack_mode01 = pack && *pack;
+  }
+  
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->loop || !channel->loop->IsRunning()) return false;
+  
+  channel->scheduler.SetSchedule(channel->packer.Pack(std::move(entries), pack_mode01));
+  channel->loop->Wake();
+  return true;
+}
+
+flutter::EncodableList FlutterBluetoothClassicPlugin::GetPollStats(
+    const flutter::EncodableValue* arguments) {
+  flutter::EncodableList list;
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return list;
+  
+  for (const auto& stats : channel->scheduler.Stats()) {
+    double achieved_hz = stats.achieved_period.count() > 0
+                             ? 1e6 / static_cast<double>(stats.achieved_period.count())
+                             : 0.0;
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(stats.command);
+    entry[flutter::EncodableValue("targetPeriodMs")] =
+        flutter::EncodableValue(static_cast<int64_t>(stats.target_period.count()));
+    entry[flutter::EncodableValue("targetHz")] =
+        flutter::EncodableValue(1000.0 / static_cast<double>(stats.target_period.count()));
+    entry[flutter::EncodableValue("achievedHz")] = flutter::EncodableValue(achieved_hz);
+    entry[flutter::EncodableValue("samples")] =
+        flutter::EncodableValue(static_cast<int64_t>(stats.samples));
+    entry[flutter::EncodableValue("timeouts")] =
+        flutter::EncodableValue(static_cast<int64_t>(stats.timeouts));
+    entry[flutter::EncodableValue("deadlineMisses")] =
+        flutter::EncodableValue(static_cast<int64_t>(stats.deadline_misses));
+    list.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (args) {
+    auto reset_it = args->find(flutter::EncodableValue("reset"));
+    if (reset_it != args->end()) {
+      const auto* reset = std::get_if<bool>(&reset_it->second);
+      if (reset && *reset) channel->scheduler.ResetStats();
+    }
+  }
+  return list;
+}
+
+flutter::EncodableMap FlutterBluetoothClassicPlugin::GetStats(
+    const flutter::EncodableValue* arguments) {
+  flutter::EncodableMap stats;
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return stats;
+  
+  flutter::EncodableMap counters;
+  for (size_t i = 0; i < kLinkCounterCount; ++i) {
+    auto counter = static_cast<LinkCounter>(i);
+    counters[flutter::EncodableValue(LinkCounterName(counter))] =
+        flutter::EncodableValue(static_cast<int64_t>(channel->stats.counter(counter)));
+  }
+  
+  flutter::EncodableList commands;
+  for (const auto& latency : channel->stats.Snapshot()) {
+    flutter::EncodableMap phases;
+    for (size_t i = 0; i < kLatencyPhaseCount; ++i) {
+      const LatencySummary& summary = latency.phases[i];
+      if (summary.count == 0) continue;
+      flutter::EncodableMap phase;
+      phase[flutter::EncodableValue("count")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.count));
+      phase[flutter::EncodableValue("meanUs")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.mean_us));
+      phase[flutter::EncodableValue("p50Us")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.p50_us));
+      phase[flutter::EncodableValue("p90Us")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.p90_us));
+      phase[flutter::EncodableValue("p99Us")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.p99_us));
+      phase[flutter::EncodableValue("maxUs")] =
+          flutter::EncodableValue(static_cast<int64_t>(summary.max_us));
+      phases[flutter::EncodableValue(LatencyPhaseName(static_cast<LatencyPhase>(i)))] =
+          flutter::EncodableValue(std::move(phase));
+    }
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(latency.command);
+    entry[flutter::EncodableValue("completed")] =
+        flutter::EncodableValue(static_cast<int64_t>(latency.completed));
+    entry[flutter::EncodableValue("timeouts")] =
+        flutter::EncodableValue(static_cast<int64_t>(latency.timeouts));
+    entry[flutter::EncodableValue("phases")] = flutter::EncodableValue(std::move(phases));
+    commands.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  flutter::EncodableList response_counts;
+  for (const auto& learned : channel->response_counts.Snapshot()) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(learned.command);
+    entry[flutter::EncodableValue("count")] = flutter::EncodableValue(learned.count);
+    entry[flutter::EncodableValue("openReplies")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.open_replies));
+    entry[flutter::EncodableValue("countedReplies")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.counted_replies));
+    entry[flutter::EncodableValue("openMeanUs")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.open_mean_us));
+    entry[flutter::EncodableValue("countedMeanUs")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.counted_mean_us));
+    entry[flutter::EncodableValue("savedUs")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.saved_us));
+    entry[flutter::EncodableValue("relearns")] = flutter::EncodableValue(learned.relearns);
+    response_counts.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  flutter::EncodableList timeouts;
+  for (const auto& learned : channel->timeouts.Snapshot()) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(learned.command);
+    entry[flutter::EncodableValue("counts")] = flutter::EncodableValue(learned.counts);
+    entry[flutter::EncodableValue("replies")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.replies));
+    entry[flutter::EncodableValue("noData")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.no_data));
+    entry[flutter::EncodableValue("quantileUs")] =
+        flutter::EncodableValue(static_cast<int64_t>(learned.quantile_us));
+    entry[flutter::EncodableValue("backoffs")] = flutter::EncodableValue(learned.backoffs);
+    timeouts.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  stats[flutter::EncodableValue("counters")] = flutter::EncodableValue(std::move(counters));
+  stats[flutter::EncodableValue("commands")] = flutter::EncodableValue(std::move(commands));
+  stats[flutter::EncodableValue("responseCounts")] =
+      flutter::EncodableValue(std::move(response_counts));
+  stats[flutter::EncodableValue("timeouts")] = flutter::EncodableValue(std::move(timeouts));
+  stats[flutter::EncodableValue("atstChanges")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->timeouts.changes()));
+  return stats;
+}
+
+bool FlutterBluetoothClassicPlugin::ResetStats(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return false;
+  channel->stats.Reset();
+  return true;
+}
+
+void FlutterBluetoothClassicPlugin::StartJ1939Monitor(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  std::vector<uint32_t> pgns;
+  bool stn = false;
+  if (args) {
+    auto pgns_it = args->find(flutter::EncodableValue("pgns"));
+    if (pgns_it != args->end()) {
+      const auto* pgn_list = std::get_if<flutter::EncodableList>(&pgns_it->second);
+      if (!pgn_list) {
+        result->Error("INVALID_ARGUMENT", "pgns must be a list of integers");
+        return;
+      }
+      for (const auto& value : *pgn_list) {
+        int64_t pgn = -1;
+        if (const auto* small = std::get_if<int32_t>(&value)) pgn = *small;
+        if (const auto* large = std::get_if<int64_t>(&value)) pgn = *large;
+        if (pgn < 0 || pgn > 0x3FFFF) {
+          result->Error("INVALID_ARGUMENT", "pgns must be a list of integers");
+          return;
+        }
+        pgns.push_back(static_cast<uint32_t>(pgn));
+      }
+    }
+    auto stn_it = args->find(flutter::EncodableValue("stn"));
+    if (stn_it != args->end()) {
+      const auto* value = std::get_if<bool>(&stn_it->second);
+      stn = value && *value;
+    }
+  }
+  
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->loop || !channel->loop->IsRunning()) {
+    result->Error("NOT_CONNECTED", "No active connection to monitor");
+    return;
+  }
+  // Any command written while monitoring would end it
+  if (channel->monitoring.load(std::memory_order_acquire) || channel->pipeline.busy()) {
+    result->Error("BUSY", "Commands or a poll schedule are running on this connection");
+    return;
+  }
+  
+  J1939MonitorCommands commands = MakeJ1939MonitorCommands(pgns, stn);
+  channel->monitor.Reset();
+  channel->monitor.SetPgns(pgns);
+  channel->monitor_restore = std::move(commands.restore);
+  
+  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+  channel->pipeline.Submit(
+      std::move(commands.setup), std::chrono::milliseconds(kDefaultCommandTimeoutMs),
+      [this, shared_result, channel, start = std::move(commands.start)](
+          std::vector<CommandResult>&& results) {
+        bool ok = true;
+        for (const auto& result : results) {
+          ok = ok && result.status == CommandResult::Status::kOk && !result.lines.empty() &&
+               result.lines.back() == "OK";
+        }
+        // Runs on the I/O thread, so the first monitor byte cannot arrive
+        // before the flag is set
+        if (ok) {
+          channel->monitoring.store(true, std::memory_order_release);
+          ok = channel->WriteCommand(start + "\r");
+          if (!ok) channel->monitoring.store(false, std::memory_order_release);
+        }
+        dispatcher_->Post([shared_result, ok]() {
+          if (ok) {
+            shared_result->Success(flutter::EncodableValue(true));
+          } else {
+            shared_result->Error("ADAPTER_ERROR", "The adapter rejected the monitor setup");
+          }
+        });
+      });
+  channel->loop->Wake();
+}
+
+bool FlutterBluetoothClassicPlugin::StopJ1939Monitor(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->monitoring.load(std::memory_order_acquire)) return false;
+  // Any byte stops ATMA/STMA; the prompt that follows restores the adapter.
+  // Written through the queue, not WriteCommand: the framer is the I/O
+  // thread's.
+  static const uint8_t kStop[] = {'\r'};
+  channel->capture.Record(WireDirection::kSent, kStop, sizeof(kStop));
+  bool queued = channel->writes.Write(kStop, sizeof(kStop));
+  channel->stats.Add(queued ? LinkCounter::kBytesSent : LinkCounter::kWriteFailures, 1);
+  return queued;
+}
+
+flutter::EncodableMap FlutterBluetoothClassicPlugin::GetJ1939Values(
+    const flutter::EncodableValue* arguments) {
+  flutter::EncodableMap values;
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return values;
+  
+  const auto now = std::chrono::steady_clock::now();
+  flutter::EncodableList spns;
+  for (const auto& latest : channel->monitor.Snapshot()) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("spn")] =
+        flutter::EncodableValue(static_cast<int64_t>(latest.spn->spn));
+    entry[flutter::EncodableValue("pgn")] =
+        flutter::EncodableValue(static_cast<int64_t>(latest.spn->pgn));
+    entry[flutter::EncodableValue("id")] = flutter::EncodableValue(std::string(latest.spn->id));
+    entry[flutter::EncodableValue("unit")] =
+        flutter::EncodableValue(std::string(latest.spn->unit));
+    entry[flutter::EncodableValue("value")] = flutter::EncodableValue(latest.value);
+    entry[flutter::EncodableValue("source")] =
+        flutter::EncodableValue(static_cast<int64_t>(latest.source));
+    entry[flutter::EncodableValue("ageUs")] = flutter::EncodableValue(static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - latest.at).count()));
+    entry[flutter::EncodableValue("updates")] =
+        flutter::EncodableValue(static_cast<int64_t>(latest.updates));
+    spns.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  const J1939MonitorCounters counters = channel->monitor.counters();
+  flutter::EncodableMap counter_map;
+  counter_map[flutter::EncodableValue("frames")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.frames));
+  counter_map[flutter::EncodableValue("decoded")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.decoded));
+  counter_map[flutter::EncodableValue("ignored")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.ignored));
+  counter_map[flutter::EncodableValue("malformed")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.malformed));
+  counter_map[flutter::EncodableValue("overflows")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.overflows));
+  counter_map[flutter::EncodableValue("transportMessages")] =
+      flutter::EncodableValue(static_cast<int64_t>(counters.transport.messages));
+  counter_map[flutter::EncodableValue("transportErrors")] = flutter::EncodableValue(
+      static_cast<int64_t>(counters.transport.sequence_errors + counters.transport.timeouts +
+                           counters.transport.aborts + counters.transport.pool_full +
+                           counters.transport.malformed));
+  
+  flutter::EncodableList dm1s;
+  for (const auto& dm1 : channel->monitor.Dm1Snapshot()) {
+    flutter::EncodableList dtcs;
+    for (const auto& dtc : dm1.dtcs) {
+      flutter::EncodableMap entry;
+      entry[flutter::EncodableValue("spn")] =
+          flutter::EncodableValue(static_cast<int64_t>(dtc.spn));
+      entry[flutter::EncodableValue("fmi")] =
+          flutter::EncodableValue(static_cast<int64_t>(dtc.fmi));
+      entry[flutter::EncodableValue("occurrences")] =
+          flutter::EncodableValue(static_cast<int64_t>(dtc.occurrences));
+      dtcs.push_back(flutter::EncodableValue(std::move(entry)));
+    }
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("source")] =
+        flutter::EncodableValue(static_cast<int64_t>(dm1.source));
+    entry[flutter::EncodableValue("malfunctionLamp")] =
+        flutter::EncodableValue(dm1.lamps.malfunction);
+    entry[flutter::EncodableValue("redStopLamp")] = flutter::EncodableValue(dm1.lamps.red_stop);
+    entry[flutter::EncodableValue("amberWarningLamp")] =
+        flutter::EncodableValue(dm1.lamps.amber_warning);
+    entry[flutter::EncodableValue("protectLamp")] = flutter::EncodableValue(dm1.lamps.protect);
+    entry[flutter::EncodableValue("dtcs")] = flutter::EncodableValue(std::move(dtcs));
+    entry[flutter::EncodableValue("ageUs")] = flutter::EncodableValue(static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - dm1.at).count()));
+    entry[flutter::EncodableValue("updates")] =
+        flutter::EncodableValue(static_cast<int64_t>(dm1.updates));
+    dm1s.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  values[flutter::EncodableValue("monitoring")] =
+      flutter::EncodableValue(channel->monitoring.load(std::memory_order_acquire));
+  values[flutter::EncodableValue("values")] = flutter::EncodableValue(std::move(spns));
+  values[flutter::EncodableValue("dm1")] = flutter::EncodableValue(std::move(dm1s));
+  values[flutter::EncodableValue("counters")] = flutter::EncodableValue(std::move(counter_map));
+  return values;
+}
+
+bool FlutterBluetoothClassicPlugin::SetEcuPolicies(const flutter::EncodableValue* arguments) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) return false;
+  
+  auto policies_it = args->find(flutter::EncodableValue("policies"));
+  if (policies_it == args->end()) return false;
+  const auto* policy_list = std::get_if<flutter::EncodableList>(&policies_it->second);
+  if (!policy_list) return false;
+  
+  struct Entry {
+    std::string command;
+    EcuPolicy policy;
+    std::string preferred;
+  };
+  std::vector<Entry> entries;
+  for (const auto& value : *policy_list) {
+    const auto* entry_map = std::get_if<flutter::EncodableMap>(&value);
+    if (!entry_map) return false;
+    auto command_it = entry_map->find(flutter::EncodableValue("command"));
+    auto policy_it = entry_map->find(flutter::EncodableValue("policy"));
+    if (command_it == entry_map->end() || policy_it == entry_map->end()) return false;
+    const auto* command = std::get_if<std::string>(&command_it->second);
+    const auto* policy = std::get_if<std::string>(&policy_it->second);
+    if (!command || command->empty() || !policy) return false;
     
-    data_ptr = byte_buffer.data();
-    data_len = byte_buffer.size();
+    Entry entry{*command, EcuPolicy::kPreferred, std::string()};
+    if (*policy == "max") {
+      entry.policy = EcuPolicy::kMax;
+    } else if (*policy == "consensus") {
+      entry.policy = EcuPolicy::kConsensus;
+    } else if (*policy != "preferred") {
+      return false;
+    }
+    auto preferred_it = entry_map->find(flutter::EncodableValue("preferred"));
+    if (preferred_it != entry_map->end()) {
+      const auto* preferred = std::get_if<std::string>(&preferred_it->second);
+      if (preferred) entry.preferred = *preferred;
+    }
+    entries.push_back(std::move(entry));
   }
   
-  if (data_ptr && data_len > 0) {
-    int bytes_sent = send(sock_it->second, data_ptr, (int)data_len, 0);
-    if (bytes_sent > 0) {
-      std::string debug_msg = "WriteData: Sent " + std::to_string(bytes_sent) + " bytes to " + *address_str + "\n";
-      OutputDebugStringA(debug_msg.c_str());
-      return true;
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return false;
+  for (const auto& entry : entries) {
+    channel->ecu_values.SetPolicy(entry.command, entry.policy, entry.preferred);
+  }
+  return true;
+}
+
+bool FlutterBluetoothClassicPlugin::SetEcuRouting(const flutter::EncodableValue* arguments) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) return false;
+  auto enabled_it = args->find(flutter::EncodableValue("enabled"));
+  if (enabled_it == args->end()) return false;
+  const auto* enabled = std::get_if<bool>(&enabled_it->second);
+  if (!enabled) return false;
+  
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return false;
+  // Takes effect with the next request the pipeline sends
+  channel->ecu_values.SetRouting(*enabled);
+  return true;
+}
+
+flutter::EncodableMap FlutterBluetoothClassicPlugin::GetEcuValues(
+    const flutter::EncodableValue* arguments) {
+  flutter::EncodableMap values;
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return values;
+  
+  static const char* const kPolicyNames[] = {"preferred", "max", "consensus"};
+  const auto now = std::chrono::steady_clock::now();
+  flutter::EncodableList commands;
+  for (const auto& stats : channel->ecu_values.Snapshot(now)) {
+    flutter::EncodableList ecus;
+    for (const auto& reading : stats.ecus) {
+      flutter::EncodableMap entry;
+      entry[flutter::EncodableValue("ecu")] = flutter::EncodableValue(reading.ecu);
+      if (reading.has_value) {
+        entry[flutter::EncodableValue("value")] = flutter::EncodableValue(reading.value);
+        entry[flutter::EncodableValue("ageUs")] = flutter::EncodableValue(static_cast<int64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - reading.at).count()));
+      }
+      entry[flutter::EncodableValue("failures")] = flutter::EncodableValue(reading.failures);
+      entry[flutter::EncodableValue("nrc")] =
+          flutter::EncodableValue(static_cast<int32_t>(reading.nrc));
+      entry[flutter::EncodableValue("answers")] =
+          flutter::EncodableValue(static_cast<int64_t>(reading.answers));
+      ecus.push_back(flutter::EncodableValue(std::move(entry)));
+    }
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("command")] = flutter::EncodableValue(stats.command);
+    entry[flutter::EncodableValue("policy")] =
+        flutter::EncodableValue(std::string(kPolicyNames[static_cast<int>(stats.policy)]));
+    entry[flutter::EncodableValue("preferred")] = flutter::EncodableValue(stats.preferred);
+    entry[flutter::EncodableValue("owner")] = flutter::EncodableValue(stats.owner);
+    if (stats.selected) {
+      entry[flutter::EncodableValue("value")] = flutter::EncodableValue(stats.value);
+      entry[flutter::EncodableValue("selectedEcu")] = flutter::EncodableValue(stats.selected_ecu);
     }
+    entry[flutter::EncodableValue("ecus")] = flutter::EncodableValue(std::move(ecus));
+    commands.push_back(flutter::EncodableValue(std::move(entry)));
   }
   
-  return false;
+  values[flutter::EncodableValue("routing")] =
+      flutter::EncodableValue(channel->ecu_values.routing());
+  values[flutter::EncodableValue("headerChanges")] =
+      flutter::EncodableValue(static_cast<int64_t>(channel->ecu_values.header_changes()));
+  values[flutter::EncodableValue("values")] = flutter::EncodableValue(std::move(commands));
+  return values;
+}
+
+void FlutterBluetoothClassicPlugin::StartDidScan(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!args) {
+    result->Error("INVALID_ARGUMENT", "Arguments must be a map");
+    return;
+  }
+  std::vector<DidScan::Range> ranges;
+  auto ranges_it = args->find(flutter::EncodableValue("ranges"));
+  const auto* range_list = ranges_it == args->end()
+                               ? nullptr
+                               : std::get_if<flutter::EncodableList>(&ranges_it->second);
+  if (range_list) {
+    for (const auto& value : *range_list) {
+      const auto* pair = std::get_if<flutter::EncodableList>(&value);
+      const auto* first = pair && pair->size() == 2 ? std::get_if<int32_t>(&(*pair)[0]) : nullptr;
+      const auto* last = pair && pair->size() == 2 ? std::get_if<int32_t>(&(*pair)[1]) : nullptr;
+      if (!first || !last || *first < 0 || *last > 0xFFFF || *first > *last) {
+        range_list = nullptr;
+        break;
+      }
+      ranges.emplace_back(static_cast<uint16_t>(*first), static_cast<uint16_t>(*last));
+    }
+  }
+  if (!range_list) {
+    result->Error("INVALID_ARGUMENT", "ranges must be a list of [first, last] DIDs");
+    return;
+  }
+  const std::vector<uint8_t>* bitmap = nullptr;
+  auto bitmap_it = args->find(flutter::EncodableValue("bitmap"));
+  if (bitmap_it != args->end()) bitmap = std::get_if<std::vector<uint8_t>>(&bitmap_it->second);
+  
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->loop || !channel->loop->IsRunning()) {
+    result->Error("NOT_CONNECTED", "No active connection to scan");
+    return;
+  }
+  if (channel->monitoring.load(std::memory_order_acquire) || channel->did_scan.running()) {
+    result->Error("BUSY", "A J1939 monitor or DID scan is running on this connection");
+    return;
+  }
+  
+  // A bitmap of another size (or none) starts over with every DID unknown
+  channel->did_scan.Load(bitmap ? *bitmap : std::vector<uint8_t>());
+  const size_t count = channel->did_scan.Start(std::move(ranges), std::chrono::steady_clock::now());
+  // Two chunks under way, so the adapter has the next request while the
+  // handler of the last one runs
+  SubmitDidScanChunk(channel);
+  SubmitDidScanChunk(channel);
+  result->Success(flutter::EncodableValue(static_cast<int64_t>(count)));
+}
+
+void FlutterBluetoothClassicPlugin::SubmitDidScanChunk(ReceiveChannel* channel) {
+  std::vector<std::string> chunk = channel->did_scan.NextChunk();
+  if (chunk.empty()) return;
+  channel->pipeline.SubmitRaw(
+      std::move(chunk), std::chrono::milliseconds(kDefaultCommandTimeoutMs),
+      [this, channel](std::vector<CommandResult>&& results) {
+        // On the I/O thread: the next chunk goes out before the event hops
+        std::vector<DidAnswer> answers;
+        const auto now = std::chrono::steady_clock::now();
+        const bool done = channel->did_scan.Observe(results, now, &answers);
+        if (!done) SubmitDidScanChunk(channel);
+        std::vector<uint8_t> bitmap;
+        if (done) bitmap = channel->did_scan.Bitmap();
+        dispatcher_->Post([this, device_address = channel->address, answers = std::move(answers),
+                           progress = channel->did_scan.Progress(now),
+                           bitmap = std::move(bitmap)]() mutable {
+          DeliverDidScanEvent(device_address, std::move(answers), progress, std::move(bitmap));
+        });
+      });
+  channel->loop->Wake();
+}
+
+void FlutterBluetoothClassicPlugin::DeliverDidScanEvent(const std::string& device_address,
+                                                        std::vector<DidAnswer>&& answers,
+                                                        const DidScanProgress& progress,
+                                                        std::vector<uint8_t>&& bitmap) {
+  if (!did_scan_sink_) return;
+  
+  flutter::EncodableList answer_list;
+  answer_list.reserve(answers.size());
+  for (auto& answer : answers) {
+    flutter::EncodableMap entry;
+    entry[flutter::EncodableValue("did")] =
+        flutter::EncodableValue(static_cast<int32_t>(answer.did));
+    entry[flutter::EncodableValue("ecu")] = flutter::EncodableValue(std::move(answer.ecu));
+    entry[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(answer.bytes));
+    entry[flutter::EncodableValue("nrc")] =
+        flutter::EncodableValue(static_cast<int32_t>(answer.nrc));
+    answer_list.push_back(flutter::EncodableValue(std::move(entry)));
+  }
+  
+  flutter::EncodableMap event;
+  event[flutter::EncodableValue("deviceAddress")] = flutter::EncodableValue(device_address);
+  event[flutter::EncodableValue("answers")] = flutter::EncodableValue(std::move(answer_list));
+  event[flutter::EncodableValue("running")] = flutter::EncodableValue(progress.running);
+  event[flutter::EncodableValue("stopped")] = flutter::EncodableValue(progress.stopped);
+  event[flutter::EncodableValue("total")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.total));
+  event[flutter::EncodableValue("probed")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.probed));
+  event[flutter::EncodableValue("supported")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.supported));
+  event[flutter::EncodableValue("refused")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.refused));
+  event[flutter::EncodableValue("absent")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.absent));
+  event[flutter::EncodableValue("requests")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.requests));
+  event[flutter::EncodableValue("lastDid")] =
+      flutter::EncodableValue(static_cast<int32_t>(progress.last_did));
+  event[flutter::EncodableValue("count")] = flutter::EncodableValue(progress.count);
+  event[flutter::EncodableValue("elapsedUs")] =
+      flutter::EncodableValue(static_cast<int64_t>(progress.elapsed.count()));
+  event[flutter::EncodableValue("didsPerSecond")] =
+      flutter::EncodableValue(progress.dids_per_second);
+  event[flutter::EncodableValue("hitsPerSecond")] =
+      flutter::EncodableValue(progress.hits_per_second);
+  // Only with the event that ends the run; getDidScanBitmap has it before
+  if (!bitmap.empty()) {
+    event[flutter::EncodableValue("bitmap")] = flutter::EncodableValue(std::move(bitmap));
+  }
+  did_scan_sink_->Success(flutter::EncodableValue(event));
+}
+
+bool FlutterBluetoothClassicPlugin::StopDidScan(const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel || !channel->did_scan.running()) return false;
+  // The run ends once the chunks under way are answered
+  channel->did_scan.Stop();
+  return true;
+}
+
+flutter::EncodableValue FlutterBluetoothClassicPlugin::GetDidScanBitmap(
+    const flutter::EncodableValue* arguments) {
+  ReceiveChannel* channel = FindCommandChannel(arguments);
+  if (!channel) return flutter::EncodableValue();
+  return flutter::EncodableValue(channel->did_scan.Bitmap());
 }
 
 void FlutterBluetoothClassicPlugin::CleanupDataChannels(const flutter::EncodableValue* arguments) {
@@ -774,12 +2018,8 @@ void FlutterBluetoothClassicPlugin::CleanupDataChannels(const flutter::Encodable
       if (address_it != args->end()) {
         const auto* address_str = std::get_if<std::string>(&address_it->second);
         if (address_str) {
-          // Stop data listening for this device
-          listening_devices_.erase(*address_str);
-          
-          // Clear buffered data
-          std::lock_guard<std::mutex> lock(data_mutex_);
-          received_data_.erase(*address_str);
+          // Stop data listening for this device and drop its buffered data
+          RemoveReceiveChannel(*address_str);
           
           OutputDebugStringA("CleanupDataChannels: Cleaned up data channels\n");
         }
@@ -787,9 +2027,7 @@ void FlutterBluetoothClassicPlugin::CleanupDataChannels(const flutter::Encodable
     }
   } else {
     // Clean up all data channels if no specific device
-    listening_devices_.clear();
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    received_data_.clear();
+    RemoveAllReceiveChannels();
     OutputDebugStringA("CleanupDataChannels: Cleaned up all data channels\n");
   }
 }
@@ -803,7 +2041,7 @@ void FlutterBluetoothClassicPlugin::CancelDataChannel(const flutter::EncodableVa
         const auto* address_str = std::get_if<std::string>(&address_it->second);
         if (address_str) {
           // Stop listening for this device
-          listening_devices_.erase(*address_str);
+          StopDataListening(*address_str);
           OutputDebugStringA("CancelDataChannel: Cancelled data channel\n");
         }
       }
@@ -820,10 +2058,7 @@ void FlutterBluetoothClassicPlugin::CloseDataChannel(const flutter::EncodableVal
         const auto* address_str = std::get_if<std::string>(&address_it->second);
         if (address_str) {
           // Stop listening and clear data
-          listening_devices_.erase(*address_str);
-          
-          std::lock_guard<std::mutex> lock(data_mutex_);
-          received_data_.erase(*address_str);
+          RemoveReceiveChannel(*address_str);
           
           OutputDebugStringA("CloseDataChannel: Closed data channel\n");
         }
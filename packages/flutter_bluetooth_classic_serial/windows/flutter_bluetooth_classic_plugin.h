@@ -1,17 +1,43 @@
 #ifndef FLUTTER_PLUGIN_FLUTTER_BLUETOOTH_CLASSIC_PLUGIN_H_
 #define FLUTTER_PLUGIN_FLUTTER_BLUETOOTH_CLASSIC_PLUGIN_H_
 
+#include <flutter/event_channel.h>
+#include <flutter/event_sink.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 #include <flutter_plugin_registrar.h>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <map>
 #include <string>
 #include <set>
 #include <mutex>
 #include <thread>
+#include <vector>
+
+#include "adaptive_timeouts.h"
+#include "byte_ring.h"
+#include "chunk_coalescer.h"
+#include "command_pipeline.h"
+#include "connection_reactor.h"
+#include "device_discovery.h"
+#include "did_scan.h"
+#include "ecu_values.h"
+#include "elm327_framer.h"
+#include "elm327_reply.h"
+#include "handle_table.h"
+#include "j1939_monitor.h"
+#include "latency_stats.h"
+#include "mode01_packer.h"
+#include "poll_scheduler.h"
+#include "receive_loop.h"
+#include "response_counts.h"
+#include "trace_ring.h"
+#include "wire_capture.h"
+#include "write_queue.h"
 
 #ifdef FLUTTER_PLUGIN_IMPL
 #define FLUTTER_PLUGIN_EXPORT __declspec(dllexport)
@@ -21,11 +47,13 @@
 
 namespace flutter_bluetooth_classic {
 
+class PlatformThreadDispatcher;
+
 class FlutterBluetoothClassicPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
 
-  FlutterBluetoothClassicPlugin();
+  explicit FlutterBluetoothClassicPlugin(flutter::PluginRegistrarWindows* registrar);
 
   virtual ~FlutterBluetoothClassicPlugin();
 
@@ -44,19 +72,143 @@ class FlutterBluetoothClassicPlugin : public flutter::Plugin {
   bool IsBluetoothEnabled();
   void OpenBluetoothSettings();
   flutter::EncodableList GetPairedDevices();
-  flutter::EncodableList StartDiscovery();
+  bool StartDiscovery();
+  flutter::EncodableList GetDiscoveredDevices();
   bool ConnectToDevice(const flutter::EncodableValue* arguments);
   bool DisconnectDevice(const flutter::EncodableValue* arguments);
   bool IsDeviceConnected(const flutter::EncodableValue* arguments);
+  flutter::EncodableValue GetConnectedChannel(const flutter::EncodableValue* arguments);
   bool WriteData(const flutter::EncodableValue* arguments);
+  void SendCommands(const flutter::EncodableValue* arguments,
+                    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  bool SetPollSchedule(const flutter::EncodableValue* arguments);
+  flutter::EncodableList GetPollStats(const flutter::EncodableValue* arguments);
+  flutter::EncodableMap GetStats(const flutter::EncodableValue* arguments);
+  bool ResetStats(const flutter::EncodableValue* arguments);
+  void StartJ1939Monitor(const flutter::EncodableValue* arguments,
+                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  bool StopJ1939Monitor(const flutter::EncodableValue* arguments);
+  flutter::EncodableMap GetJ1939Values(const flutter::EncodableValue* arguments);
+  bool SetEcuPolicies(const flutter::EncodableValue* arguments);
+  bool SetEcuRouting(const flutter::EncodableValue* arguments);
+  flutter::EncodableMap GetEcuValues(const flutter::EncodableValue* arguments);
+  void StartDidScan(const flutter::EncodableValue* arguments,
+                    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  bool StopDidScan(const flutter::EncodableValue* arguments);
+  flutter::EncodableValue GetDidScanBitmap(const flutter::EncodableValue* arguments);
   std::string ReadData(const flutter::EncodableValue* arguments);
   flutter::EncodableList GetConnectedDevices();
   
+  // Receive state of one listening device.
+  struct ReceiveChannel {
+    ReceiveChannel(const std::string& device_address, const CoalescingOptions& options);
+
+    // Pipeline write path; runs on the I/O thread.
+    bool WriteCommand(const std::string& data);
+
+    // The plugin's trace ring.
+    TraceRing* trace = nullptr;
+
+    std::string address;
+    HandleTable<ReceiveChannel>::Handle handle = HandleTable<ReceiveChannel>::kInvalidHandle;
+    // Set before the loop starts.
+    SOCKET socket = INVALID_SOCKET;
+    // Every byte sent and received while wire capture is on.
+    WireCaptureWriter capture;
+    // The plugin's I/O reactor and the socket's registration with it, set
+    // once the loop started. The backlog handler turns write interest on
+    // through them rather than through |loop|, which the platform thread
+    // may be resetting meanwhile.
+    ConnectionReactor* reactor = nullptr;
+    std::atomic<ConnectionReactor::ConnectionId> connection{
+        ConnectionReactor::kInvalidConnection};
+    // Outgoing bytes from writeData and the pipeline. Backlogged writes are
+    // flushed by the I/O thread when the socket turns writable.
+    WriteQueue writes;
+    // Written by the I/O thread, read on the platform thread.
+    ByteRing ring;
+    // I/O thread only.
+    CoalescingWindow window;
+    uint32_t options_version = 0;
+    Elm327Framer framer;
+    std::vector<ElmResponse> completed_responses;
+    uint32_t command_version = 0;
+    std::chrono::steady_clock::time_point command_sent_at;
+    // The writeData command the framed responses belong to, for stats.
+    std::string framed_command;
+    // Last command written on the platform thread, picked up by the
+    // I/O thread (for echo removal and timing) when the version changes.
+    std::mutex command_mutex;
+    std::string last_command;
+    std::chrono::steady_clock::time_point last_command_at;
+    std::atomic<uint32_t> last_command_version{0};
+    // Latency histograms and link counters served by getStats. Recorded on
+    // the I/O thread, plus the platform hop on the platform thread.
+    LinkStats stats;
+    // Responder counts the pipeline appends to OBD requests, learned per
+    // command; reported by getStats.
+    ResponseCounts response_counts;
+    // Picks the adapter's ATST per OBD request from its response times;
+    // the pipeline writes the changes. Reported by getStats.
+    AdaptiveTimeouts timeouts;
+    // Per-ECU values of the OBD replies and the ECU owning each request,
+    // set by setEcuPolicies and setEcuRouting, served by getEcuValues.
+    EcuValues ecu_values;
+    // Packs the Mode 01 PIDs of setPollSchedule into multi-PID requests and
+    // splits their samples back per PID.
+    Mode01Packer packer;
+    // Periodic commands set by setPollSchedule, run by the pipeline between
+    // batches.
+    PollScheduler scheduler;
+    // Set by startJ1939Monitor once the adapter is in monitor mode; received
+    // bytes then go to the monitor instead of the framer or the ring until
+    // the prompt that ends it.
+    std::atomic<bool> monitoring{false};
+    J1939Monitor monitor;
+    std::vector<std::string> monitor_restore;
+    // Mode 22 DID scan of startDidScan. Its chunks go through the pipeline
+    // as raw batches, the next submitted from the handler of the last.
+    DidScan did_scan;
+    // sendCommands batches. Submitted on the platform thread, driven by the
+    // I/O thread's framer and timer.
+    CommandPipeline pipeline;
+    // Declared last so the socket is unregistered before the members its
+    // handlers use go away.
+    std::unique_ptr<ReceiveLoop> loop;
+  };
+
   // Data streaming methods
   void StartDataListening(const std::string& device_address);
-  void DataListeningThread(const std::string& device_address, SOCKET sock);
+  void StopDataListening(const std::string& device_address);
+  ReceiveChannel* FindReceiveChannel(const flutter::EncodableValue* arguments);
+  ReceiveChannel* FindCommandChannel(const flutter::EncodableValue* arguments);
+  void RemoveReceiveChannel(const std::string& device_address);
+  void RemoveAllReceiveChannels();
+  void OnDataReceived(ReceiveChannel* channel, const uint8_t* data, size_t length);
+  int OnDataTimer(ReceiveChannel* channel);
+  void SyncCoalescingOptions(ReceiveChannel* channel);
+  void RequestDrain(ReceiveChannel* channel);
+  void DrainReceiveChannel(HandleTable<ReceiveChannel>::Handle handle);
+  void FrameResponses(ReceiveChannel* channel, const uint8_t* data, size_t length);
+  void DeliverResponse(const std::string& device_address, const ElmResponse& response,
+                       int64_t elapsed_us);
+  void DeliverPollSample(const std::string& device_address, const CommandResult& sample);
+  void RepackPollSchedule(const std::string& device_address);
+  void SubmitDidScanChunk(ReceiveChannel* channel);
+  void DeliverDidScanEvent(const std::string& device_address, std::vector<DidAnswer>&& answers,
+                           const DidScanProgress& progress, std::vector<uint8_t>&& bitmap);
+  void RecordDelivery(const std::string& device_address, const std::string& command,
+                      std::chrono::steady_clock::time_point completed_at);
+  void NoteCommandWritten(const std::string& device_address, const char* data, size_t length);
+  bool SetResponseFraming(const flutter::EncodableValue* arguments);
+  bool SetDataCoalescing(const flutter::EncodableValue* arguments);
   int GetAvailableBytes(const flutter::EncodableValue* arguments);
+  flutter::EncodableMap GetReceiveBufferStats(const flutter::EncodableValue* arguments);
   bool FlushData(const flutter::EncodableValue* arguments);
+  std::string DumpTrace(const flutter::EncodableValue* arguments);
+  bool StartWireCapture(const flutter::EncodableValue* arguments);
+  void StopWireCapture();
+  bool OpenWireCapture(ReceiveChannel* channel);
   
   // Connection state management
   void NotifyConnectionStateChange(const flutter::EncodableValue* arguments, bool connected);
@@ -66,11 +218,48 @@ class FlutterBluetoothClassicPlugin : public flutter::Plugin {
   void CancelDataChannel(const flutter::EncodableValue* arguments);
   void CloseDataChannel(const flutter::EncodableValue* arguments);
   
+  // Event sinks, set while Dart listens. Only touched on the platform thread.
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> state_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> data_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> connection_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> response_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> poll_sink_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> did_scan_sink_;
+  std::unique_ptr<PlatformThreadDispatcher> dispatcher_;
+
+  // Radio state and paired devices are served from the cache; discovery
+  // runs its inquiries on a worker and streams devices as they are found.
+  std::unique_ptr<DiscoveryBackend> radio_;
+  DeviceCache device_cache_;
+  DeviceDiscovery discovery_;
+
+  // Binary trace of I/O, connects and errors, formatted only by dumpTrace.
+  // Declared before every thread that records into it.
+  TraceRing trace_;
+
   // Store connected sockets and data
   std::map<std::string, SOCKET> connected_sockets_;
-  std::set<std::string> listening_devices_;
-  std::map<std::string, std::string> received_data_;
-  std::mutex data_mutex_;
+  // RFCOMM channel each connection came up on, so the app can cache it.
+  std::map<std::string, int> connected_channels_;
+  // The one thread that receives on every connection. Declared before the
+  // channels so it outlives their receive loops.
+  ConnectionReactor io_reactor_;
+  // Receive channels by handle, plus the address index used by method
+  // calls. Only touched on the platform thread; the I/O thread's handlers
+  // hold a pointer to their own channel and never look anything up.
+  HandleTable<ReceiveChannel> receive_channels_;
+  std::map<std::string, HandleTable<ReceiveChannel>::Handle> receive_handles_;
+  // Current coalescing options. Receive threads copy them when the version
+  // changes instead of locking on every chunk.
+  CoalescingOptions coalescing_options_;
+  std::atomic<uint32_t> coalescing_version_{0};
+  std::mutex coalescing_mutex_;
+  // When set, received bytes are framed into ELM327 responses on the
+  // I/O thread and delivered as records instead of raw data.
+  std::atomic<bool> response_framing_{false};
+  // Directory that listening connections capture their wire traffic to;
+  // empty when capture is off. Platform thread only.
+  std::string wire_capture_directory_;
 };
 
 }  // namespace flutter_bluetooth_classic
@@ -0,0 +1,55 @@
+#include "platform_thread_dispatcher.h"
+
+#include <utility>
+
+namespace flutter_bluetooth_classic {
+
+PlatformThreadDispatcher::PlatformThreadDispatcher(flutter::PluginRegistrarWindows* registrar)
+    : registrar_(registrar) {
+  message_id_ = RegisterWindowMessageW(L"FlutterBluetoothClassicDispatch");
+  if (registrar_->GetView()) {
+    window_ = GetAncestor(registrar_->GetView()->GetNativeWindow(), GA_ROOT);
+  }
+  delegate_id_ = registrar_->RegisterTopLevelWindowProcDelegate(
+      [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+        return HandleWindowProc(hwnd, message, wparam, lparam);
+      });
+}
+
+PlatformThreadDispatcher::~PlatformThreadDispatcher() {
+  registrar_->UnregisterTopLevelWindowProcDelegate(delegate_id_);
+}
+
+void PlatformThreadDispatcher::Post(std::function<void()> task) {
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    // One message drains the whole queue, so only the first task since the
+    // last drain needs to post. Without a window nothing is posted, so
+    // nothing is pending either.
+    wake = window_ && !wake_pending_;
+    if (wake) wake_pending_ = true;
+  }
+  if (wake && !PostMessage(window_, message_id_, 0, 0)) {
+    // The message queue is full: let the next Post try again
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_pending_ = false;
+  }
+}
+
+std::optional<LRESULT> PlatformThreadDispatcher::HandleWindowProc(HWND hwnd, UINT message,
+                                                                  WPARAM wparam, LPARAM lparam) {
+  if (message != message_id_) return std::nullopt;
+
+  std::vector<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+    wake_pending_ = false;
+  }
+  for (auto& task : tasks) task();
+  return 0;
+}
+
+}  // namespace flutter_bluetooth_classic
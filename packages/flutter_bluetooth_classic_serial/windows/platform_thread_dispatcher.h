@@ -0,0 +1,47 @@
+#ifndef FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
+#define FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
+
+#include <flutter/plugin_registrar_windows.h>
+#include <windows.h>
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace flutter_bluetooth_classic {
+
+// Runs tasks on the Flutter platform thread.
+//
+// Event sinks may only be used on the platform thread, but received data
+// arrives on receive-loop threads. Post() queues a task and posts a private
+// window message to the top-level window; the registrar's window proc
+// delegate drains the queue when that message is dispatched.
+class PlatformThreadDispatcher {
+ public:
+  explicit PlatformThreadDispatcher(flutter::PluginRegistrarWindows* registrar);
+  // Unregisters the delegate. Tasks still queued are dropped without running.
+  ~PlatformThreadDispatcher();
+
+  PlatformThreadDispatcher(const PlatformThreadDispatcher&) = delete;
+  PlatformThreadDispatcher& operator=(const PlatformThreadDispatcher&) = delete;
+
+  // Thread-safe.
+  void Post(std::function<void()> task);
+
+ private:
+  std::optional<LRESULT> HandleWindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+
+  flutter::PluginRegistrarWindows* registrar_;
+  int delegate_id_ = 0;
+  UINT message_id_ = 0;
+  HWND window_ = nullptr;
+
+  std::mutex mutex_;
+  std::vector<std::function<void()>> tasks_;
+  bool wake_pending_ = false;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_PLUGIN_PLATFORM_THREAD_DISPATCHER_H_
@@ -0,0 +1,83 @@
+#include "rfcomm_transport.h"
+
+#include <cwchar>
+
+namespace flutter_bluetooth_classic {
+
+namespace {
+
+// Serial Port Profile service class, 00001101-0000-1000-8000-00805F9B34FB.
+constexpr GUID kSerialPortServiceClass = {
+    0x00001101, 0x0000, 0x1000, {0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB}};
+
+}  // namespace
+
+int RfcommTransport::LookupServiceChannel() {
+  const int channel = QueryServiceChannel(0);
+  if (channel > 0) return channel;
+  return QueryServiceChannel(LUP_FLUSHCACHE);
+}
+
+int RfcommTransport::QueryServiceChannel(DWORD flags) {
+  wchar_t context[32];
+  swprintf_s(context, L"(%02X:%02X:%02X:%02X:%02X:%02X)",
+             static_cast<unsigned>((address_ >> 40) & 0xFF),
+             static_cast<unsigned>((address_ >> 32) & 0xFF),
+             static_cast<unsigned>((address_ >> 24) & 0xFF),
+             static_cast<unsigned>((address_ >> 16) & 0xFF),
+             static_cast<unsigned>((address_ >> 8) & 0xFF),
+             static_cast<unsigned>(address_ & 0xFF));
+
+  GUID service_class = kSerialPortServiceClass;
+  WSAQUERYSETW query = {};
+  query.dwSize = sizeof(query);
+  query.lpServiceClassId = &service_class;
+  query.dwNameSpace = NS_BTH;
+  query.lpszContext = context;
+
+  HANDLE lookup = nullptr;
+  if (WSALookupServiceBeginW(&query, flags | LUP_RETURN_ADDR, &lookup) != 0) return -1;
+
+  // Large enough for the address part of one service record.
+  alignas(WSAQUERYSETW) char buffer[2048];
+  auto* found = reinterpret_cast<WSAQUERYSETW*>(buffer);
+  DWORD size = sizeof(buffer);
+  int channel = -1;
+  if (WSALookupServiceNextW(lookup, LUP_RETURN_ADDR, &size, found) == 0 &&
+      found->dwNumberOfCsAddrs > 0 && found->lpcsaBuffer != nullptr) {
+    const auto* remote =
+        reinterpret_cast<const SOCKADDR_BTH*>(found->lpcsaBuffer->RemoteAddr.lpSockaddr);
+    if (remote != nullptr) channel = static_cast<int>(remote->port);
+  }
+  WSALookupServiceEnd(lookup);
+  return channel;
+}
+
+NativeSocket RfcommTransport::StartConnect(int channel, int* error) {
+  SOCKET sock = socket(AF_BTH, SOCK_STREAM, BTHPROTO_RFCOMM);
+  if (sock == INVALID_SOCKET) {
+    *error = WSAGetLastError();
+    return kInvalidSocket;
+  }
+  if (!SetNonBlocking(sock, true)) {
+    *error = WSAGetLastError();
+    closesocket(sock);
+    return kInvalidSocket;
+  }
+
+  SOCKADDR_BTH address = {};
+  address.addressFamily = AF_BTH;
+  address.btAddr = address_;
+  address.port = static_cast<ULONG>(channel);
+  if (connect(sock, reinterpret_cast<SOCKADDR*>(&address), sizeof(address)) != 0) {
+    const int result = WSAGetLastError();
+    if (result != WSAEWOULDBLOCK) {
+      *error = result;
+      closesocket(sock);
+      return kInvalidSocket;
+    }
+  }
+  return sock;
+}
+
+}  // namespace flutter_bluetooth_classic
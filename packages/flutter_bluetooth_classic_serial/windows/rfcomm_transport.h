@@ -0,0 +1,30 @@
+#ifndef FLUTTER_PLUGIN_RFCOMM_TRANSPORT_H_
+#define FLUTTER_PLUGIN_RFCOMM_TRANSPORT_H_
+
+#include <winsock2.h>
+#include <ws2bth.h>
+
+#include "rfcomm_connector.h"
+
+namespace flutter_bluetooth_classic {
+
+// ConnectTransport over Winsock AF_BTH sockets to one remote device.
+class RfcommTransport : public ConnectTransport {
+ public:
+  explicit RfcommTransport(BTH_ADDR address) : address_(address) {}
+
+  // SDP lookup of the Serial Port Profile record: the record cached at
+  // pairing first, then a fresh query of the device.
+  int LookupServiceChannel() override;
+
+  NativeSocket StartConnect(int channel, int* error) override;
+
+ private:
+  int QueryServiceChannel(DWORD flags);
+
+  BTH_ADDR address_;
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_PLUGIN_RFCOMM_TRANSPORT_H_
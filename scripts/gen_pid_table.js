@@ -0,0 +1,200 @@
+#!/usr/bin/env node
+/**
+ * Generates the native PID descriptor table from lib/config/pid_config.dart.
+ *
+ *   node scripts/gen_pid_table.js           rewrite pid_table.h
+ *   node scripts/gen_pid_table.js --check   exit 1 if pid_table.h is stale
+ *
+ * Each Dart parser expression is matched against the formula kernels in
+ * packages/flutter_bluetooth_classic_serial/src/pid_kernels.h. A parser that
+ * fits none of them stops the generator; add a kernel for it rather than
+ * approximating. Uses only Node.js built-ins.
+ */
+
+'use strict';
+const fs   = require('fs');
+const path = require('path');
+
+const ROOT   = path.resolve(__dirname, '..');
+const CONFIG = path.join(ROOT, 'lib/config/pid_config.dart');
+const OUTPUT = path.join(ROOT, 'packages/flutter_bluetooth_classic_serial/src/pid_table.h');
+
+function fail(message) {
+  console.error(`gen_pid_table: ${message}`);
+  process.exit(1);
+}
+
+// ── Dart parsers ─────────────────────────────────────────────────────────────
+
+// `double _parseX(List<int> b) => <expr>;` with the expression on any number
+// of lines. Comments are dropped first so they cannot end an expression.
+function readParsers(source) {
+  const code = source.replace(/\/\/.*$/gm, '');
+  const parsers = {};
+  const re = /double\s+(_\w+)\s*\(\s*List<int>\s+b\s*\)\s*=>\s*([^;]+);/g;
+  for (let m; (m = re.exec(code)); ) {
+    parsers[m[1]] = m[2].replace(/\s+/g, ' ').trim();
+  }
+  return parsers;
+}
+
+const NUMBER = '(\\d+(?:\\.\\d+)?)';
+
+// Returns { raw, rawEnd, conversion, scale, divisor, offset, zeroWhenShort }.
+function classify(name, expr) {
+  let zeroWhenShort = false;
+  let guard = null;
+  const guarded = expr.match(/^b\.length >= (\d+) \? (.+) : 0$/);
+  if (guarded) {
+    zeroWhenShort = true;
+    guard = Number(guarded[1]);
+    expr = guarded[2];
+  }
+
+  // Reduce the raw value to R, remembering how it is read.
+  let raw = null;
+  let rawEnd = 0;
+  const wide = [
+    /\(\(b\[(\d+)\] \* 256\) \+ b\[(\d+)\]\)/,
+    /\(b\[(\d+)\] \* 256 \+ b\[(\d+)\]\)/,
+  ];
+  for (const re of wide) {
+    const m = expr.match(re);
+    if (!m) continue;
+    const hi = Number(m[1]);
+    if (Number(m[2]) !== hi + 1) fail(`${name}: 16-bit value is not two adjacent bytes`);
+    raw = `Uint16BigEndianAt<${hi}>`;
+    rawEnd = hi + 2;
+    expr = expr.replace(re, 'R');
+    break;
+  }
+  if (!raw) {
+    const m = expr.match(/b\[(\d+)\]/);
+    if (!m) fail(`${name}: no raw byte in "${expr}"`);
+    raw = `Uint8At<${m[1]}>`;
+    rawEnd = Number(m[1]) + 1;
+    expr = expr.replace(/b\[(\d+)\]/, 'R');
+  }
+  if (/b\[/.test(expr)) fail(`${name}: reads more than one raw value: "${expr}"`);
+  if (guard !== null && guard !== rawEnd) {
+    fail(`${name}: length guard ${guard} does not match the bytes read (${rawEnd})`);
+  }
+  expr = expr.replace(/^R\.toDouble\(\)$/, 'R');
+
+  const result = (conversion, scale, divisor, offset) =>
+    ({ raw, rawEnd, conversion, scale, divisor, offset, zeroWhenShort });
+
+  const shapes = [
+    [/^R$/, () => result('Linear', 1, 1, 0)],
+    [new RegExp(`^R / ${NUMBER}$`), (m) => result('Linear', 1, Number(m[1]), 0)],
+    [new RegExp(`^R((?: \\* ${NUMBER})+)$`), (m) => {
+      // Folding a chain of multiplications into one scale is only exact
+      // when one side of each step is a power of two; check, don't assume.
+      const factors = m[1].trim().split(/\s*\*\s*/).filter(Boolean).map(Number);
+      let scale = factors[0];
+      for (const f of factors.slice(1)) {
+        if (!Number.isInteger(Math.log2(f)) && !Number.isInteger(Math.log2(scale))) {
+          fail(`${name}: cannot fold ${factors.join(' * ')} without rounding`);
+        }
+        scale *= f;
+      }
+      return result('Linear', scale, 1, 0);
+    }],
+    [new RegExp(`^R \\* ${NUMBER} / ${NUMBER}$`),
+      (m) => result('Linear', Number(m[1]), Number(m[2]), 0)],
+    [new RegExp(`^R - ${NUMBER}$`), (m) => result('SignedOffset', 1, 1, -Number(m[1]))],
+    [new RegExp(`^\\(R - ${NUMBER}\\) \\* 9 / 5 \\+ 32$`),
+      (m) => result('CelsiusToFahrenheit', 1, 1, -Number(m[1]))],
+    [new RegExp(`^\\(R / ${NUMBER} - ${NUMBER}\\) \\* 9 / 5 \\+ 32$`),
+      (m) => result('CelsiusToFahrenheit', 1, Number(m[1]), -Number(m[2]))],
+  ];
+  for (const [re, build] of shapes) {
+    const m = expr.match(re);
+    if (m) return build(m);
+  }
+  fail(`${name}: no formula kernel matches "${expr}"`);
+}
+
+// ── Registry entries ─────────────────────────────────────────────────────────
+
+function readEntries(source) {
+  const start = source.indexOf('_pids = {');
+  if (start < 0) fail('PidRegistry._pids not found');
+  const body = source.slice(start).replace(/\/\/.*$/gm, '');
+  const entries = [];
+  for (const block of body.split('PidDefinition(').slice(1)) {
+    const field = (re, what) => {
+      const m = block.match(re);
+      if (!m) fail(`entry ${entries.length}: missing ${what}`);
+      return m[1];
+    };
+    const id = field(/id:\s*'([^']+)'/, 'id');
+    const mode = block.match(/mode:\s*(0x[0-9A-Fa-f]+|\d+)/);
+    const protocol = field(/protocol:\s*PidProtocol\.(\w+)/, 'protocol');
+    entries.push({
+      id,
+      protocol,
+      code: Number(field(/code:\s*(0x[0-9A-Fa-f]+|\d+)/, 'code')),
+      mode: mode ? Number(mode[1]) : (protocol === 'mode22' ? 0x22 : 0x01),
+      responseBytes: Number(field(/responseBytes:\s*(\d+)/, 'responseBytes')),
+      tier: field(/tier:\s*PollTier\.(\w+)/, 'tier'),
+      parser: field(/parser:\s*(_\w+)/, 'parser'),
+    });
+  }
+  return entries;
+}
+
+// ── Output ───────────────────────────────────────────────────────────────────
+
+const hex = (n, width) => '0x' + n.toString(16).toUpperCase().padStart(width, '0');
+const cap = (s) => s[0].toUpperCase() + s.slice(1);
+// JavaScript prints the shortest text that reads back as the same double.
+const num = (n) => String(n);
+
+function render(entries, parsers) {
+  const rows = entries.map((e) => {
+    const expr = parsers[e.parser];
+    if (!expr) fail(`${e.id}: parser ${e.parser} not found`);
+    const k = classify(e.parser, expr);
+    if (k.rawEnd > e.responseBytes) {
+      fail(`${e.id}: ${e.parser} reads ${k.rawEnd} bytes but responseBytes is ${e.responseBytes}`);
+    }
+    return [
+      `    {"${e.id}", "${e.parser}", PidProtocol::k${cap(e.protocol)},`,
+      `     ${hex(e.code, e.protocol === 'mode22' ? 4 : 2)}, ${hex(e.mode, 2)}, ${e.responseBytes}, PollTier::k${cap(e.tier)},`,
+      `     {${num(k.scale)}, ${num(k.divisor)}, ${num(k.offset)}, ${k.zeroWhenShort}},`,
+      `     &DecodeKernel<${k.raw}, ${k.conversion}>},`,
+    ].join('\n');
+  });
+
+  return `// Generated by scripts/gen_pid_table.js from lib/config/pid_config.dart.
+// Do not edit; change the Dart config and rerun the generator.
+
+#ifndef FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
+#define FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
+
+#include "pid_kernels.h"
+
+namespace flutter_bluetooth_classic {
+
+inline constexpr PidDescriptor kPidTable[] = {
+${rows.join('\n')}
+};
+
+}  // namespace flutter_bluetooth_classic
+
+#endif  // FLUTTER_BLUETOOTH_CLASSIC_PID_TABLE_H_
+`;
+}
+
+const source = fs.readFileSync(CONFIG, 'utf8');
+const output = render(readEntries(source), readParsers(source));
+
+if (process.argv.includes('--check')) {
+  const current = fs.existsSync(OUTPUT) ? fs.readFileSync(OUTPUT, 'utf8') : '';
+  if (current !== output) fail(`${path.relative(ROOT, OUTPUT)} is stale; run node scripts/gen_pid_table.js`);
+  console.log('pid_table.h is up to date');
+} else {
+  fs.writeFileSync(OUTPUT, output);
+  console.log(`Wrote ${path.relative(ROOT, OUTPUT)}`);
+}